@@ -0,0 +1,319 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "procly/command.hpp"
+#include "procly/internal/fd.hpp"
+#include "procly/internal/io_drain.hpp"
+#include "procly/output_sink.hpp"
+#include "procly/pipe.hpp"
+#include "procly/pipeline.hpp"
+#include "procly/platform.hpp"
+#include "tests/helpers/runfiles_support.hpp"
+
+#if PROCLY_PLATFORM_POSIX
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+namespace procly {
+namespace {
+
+constexpr std::int64_t kKiB = 1024;
+constexpr std::int64_t kMiB = 1024 * kKiB;
+
+const char* g_argv0 = nullptr;
+
+const std::string& helper() {
+  static const std::string path = support::helper_path(g_argv0);
+  return path;
+}
+
+bool require_helper(benchmark::State& state) {
+  if (helper().empty()) {
+    state.SkipWithError("procly_child helper not found");
+    return false;
+  }
+  return true;
+}
+
+const char* strategy_label() {
+#if defined(PROCLY_FORCE_FORK)
+  return "fork_exec";
+#elif defined(PROCLY_FORCE_VFORK)
+  return "vfork_exec";
+#else
+  return "posix_spawn";
+#endif
+}
+
+void report_error(benchmark::State& state, const Error& error) {
+  std::string message = error.context + ": " + error.code.message();
+  state.SkipWithError(message.c_str());
+}
+
+// Spawn and reap the helper, optionally with a working directory (arg 0/1).
+void BM_SpawnWait(benchmark::State& state) {
+  if (!require_helper(state)) {
+    return;
+  }
+  bool with_cwd = state.range(0) != 0;
+  std::filesystem::path cwd = std::filesystem::temp_directory_path();
+  for (auto _ : state) {
+    Command cmd(helper());
+    if (with_cwd) {
+      cmd.current_dir(cwd);
+    }
+    auto status = cmd.status();
+    if (!status) {
+      report_error(state, status.error());
+      return;
+    }
+  }
+  state.SetLabel(std::string(strategy_label()) + (with_cwd ? "/cwd" : ""));
+}
+BENCHMARK(BM_SpawnWait)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond)->UseRealTime();
+
+// Capture N bytes of child stdout through Command::output().
+void BM_OutputThroughput(benchmark::State& state) {
+  if (!require_helper(state)) {
+    return;
+  }
+  std::string bytes = std::to_string(state.range(0));
+  for (auto _ : state) {
+    Command cmd(helper());
+    cmd.arg("--stdout-bytes").arg(bytes);
+    auto out = cmd.output();
+    if (!out) {
+      report_error(state, out.error());
+      return;
+    }
+    benchmark::DoNotOptimize(out->stdout_data.data());
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_OutputThroughput)
+    ->RangeMultiplier(16)
+    ->Range(kKiB, 16 * kMiB)
+    ->Unit(benchmark::kMicrosecond)
+    ->UseRealTime();
+
+// Drain a pipe pair fed by an in-process writer thread; no process is spawned.
+void BM_DrainPipes(benchmark::State& state) {
+  std::string payload(static_cast<std::size_t>(state.range(0)), 'x');
+  for (auto _ : state) {
+    auto out_pipe = internal::create_pipe();
+    auto err_pipe = internal::create_pipe();
+    if (!out_pipe || !err_pipe) {
+      state.SkipWithError("create_pipe failed");
+      return;
+    }
+    PipeReader out_reader(out_pipe->first.release());
+    PipeWriter out_writer(out_pipe->second.release());
+    PipeReader err_reader(err_pipe->first.release());
+    PipeWriter err_writer(err_pipe->second.release());
+    err_writer.close();
+    std::thread writer([&] {
+      (void)out_writer.write_all(payload);
+      out_writer.close();
+    });
+    auto drained = internal::drain_pipes(&out_reader, &err_reader);
+    writer.join();
+    if (!drained) {
+      report_error(state, drained.error());
+      return;
+    }
+    benchmark::DoNotOptimize(drained->stdout_data.data());
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_DrainPipes)
+    ->RangeMultiplier(16)
+    ->Range(kKiB, 16 * kMiB)
+    ->Unit(benchmark::kMicrosecond)
+    ->UseRealTime();
+
+// Push 1 MiB through a pipeline of N stages (one producer, N-1 echo stages).
+void BM_PipelineThroughput(benchmark::State& state) {
+  if (!require_helper(state)) {
+    return;
+  }
+  constexpr std::int64_t kPayload = kMiB;
+  auto stages = state.range(0);
+  for (auto _ : state) {
+    Command first(helper());
+    first.arg("--stdout-bytes").arg(std::to_string(kPayload));
+    if (stages == 1) {
+      auto out = first.output();
+      if (!out) {
+        report_error(state, out.error());
+        return;
+      }
+      continue;
+    }
+    Command echo(helper());
+    echo.arg("--echo-stdin");
+    Pipeline pipeline = first | echo;
+    for (std::int64_t i = 2; i < stages; ++i) {
+      pipeline = std::move(pipeline) | echo;
+    }
+    auto out = pipeline.output();
+    if (!out) {
+      report_error(state, out.error());
+      return;
+    }
+    benchmark::DoNotOptimize(out->stdout_data.data());
+  }
+  state.SetBytesProcessed(state.iterations() * kPayload);
+}
+BENCHMARK(BM_PipelineThroughput)
+    ->DenseRange(1, 4)
+    ->Arg(8)
+    ->Unit(benchmark::kMicrosecond)
+    ->UseRealTime();
+
+// Spawn and wait with no timeout (arg 0) or through the timeout/escalation policy (arg 1).
+void BM_WaitTimeoutOverhead(benchmark::State& state) {
+  if (!require_helper(state)) {
+    return;
+  }
+  bool with_timeout = state.range(0) != 0;
+  WaitOptions opts;
+  if (with_timeout) {
+    opts.timeout = std::chrono::seconds(10);
+  }
+  for (auto _ : state) {
+    Command cmd(helper());
+    auto child = cmd.spawn();
+    if (!child) {
+      report_error(state, child.error());
+      return;
+    }
+    auto waited = child->wait(opts);
+    if (!waited) {
+      report_error(state, waited.error());
+      return;
+    }
+  }
+  state.SetLabel(with_timeout ? "timeout" : "blocking");
+}
+BENCHMARK(BM_WaitTimeoutOverhead)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond)->UseRealTime();
+
+#if PROCLY_PLATFORM_POSIX
+// Spawn with N extra close-on-exec descriptors open in the parent.
+void BM_SpawnWithOpenFds(benchmark::State& state) {
+  if (!require_helper(state)) {
+    return;
+  }
+  auto count = static_cast<rlim_t>(state.range(0));
+  rlimit limit{};
+  if (::getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < count + kKiB) {
+    limit.rlim_cur = std::min<rlim_t>(limit.rlim_max, count + kKiB);
+    (void)::setrlimit(RLIMIT_NOFILE, &limit);
+  }
+  std::vector<internal::unique_fd> fds;
+  fds.reserve(static_cast<std::size_t>(count));
+  int base = ::open("/dev/null", O_RDONLY | O_CLOEXEC);
+  if (base < 0) {
+    state.SkipWithError("open(/dev/null) failed");
+    return;
+  }
+  internal::unique_fd base_fd(base);
+  for (rlim_t i = 0; i < count; ++i) {
+    int fd = ::fcntl(base_fd.get(), F_DUPFD_CLOEXEC, 0);
+    if (fd < 0) {
+      state.SkipWithError("fcntl(F_DUPFD_CLOEXEC) failed");
+      return;
+    }
+    fds.emplace_back(fd);
+  }
+  for (auto _ : state) {
+    Command cmd(helper());
+    auto status = cmd.status();
+    if (!status) {
+      report_error(state, status.error());
+      return;
+    }
+  }
+  state.SetLabel(strategy_label());
+}
+BENCHMARK(BM_SpawnWithOpenFds)
+    ->Arg(0)
+    ->Arg(256)
+    ->Arg(4096)
+    ->Arg(16384)
+    ->Unit(benchmark::kMicrosecond)
+    ->UseRealTime();
+#endif
+
+// Spawn with N extra environment variables layered over the inherited environment.
+void BM_SpawnWithEnvSize(benchmark::State& state) {
+  if (!require_helper(state)) {
+    return;
+  }
+  auto count = state.range(0);
+  std::string value(64, 'v');
+  for (auto _ : state) {
+    Command cmd(helper());
+    for (std::int64_t i = 0; i < count; ++i) {
+      cmd.env("PROCLY_BENCH_" + std::to_string(i), value);
+    }
+    auto status = cmd.status();
+    if (!status) {
+      report_error(state, status.error());
+      return;
+    }
+  }
+}
+BENCHMARK(BM_SpawnWithEnvSize)
+    ->Arg(0)
+    ->Arg(64)
+    ->Arg(1024)
+    ->Arg(4096)
+    ->Unit(benchmark::kMicrosecond)
+    ->UseRealTime();
+
+// Feed 64 KiB chunks of Arg-byte lines through a sink; 0 selects a chunk sink for comparison.
+void BM_OutputSinkLines(benchmark::State& state) {
+  constexpr std::size_t kChunk = 64 * kKiB;
+  std::string chunk;
+  auto line_length = static_cast<std::size_t>(state.range(0));
+  while (chunk.size() < kChunk) {
+    chunk.append(std::string(std::max<std::size_t>(line_length, 1) - 1, 'x')).push_back('\n');
+  }
+  std::size_t seen = 0;
+  OutputSink sink = line_length == 0
+                        ? OutputSink::chunks(OutputSink::ChunkCallback(
+                              [&](const std::byte* /*data*/, std::size_t size) { seen += size; }))
+                        : OutputSink::lines([&](std::string_view line) { seen += line.size(); });
+  for (auto _ : state) {
+    sink.write(chunk.data(), chunk.size());
+  }
+  sink.finish();
+  benchmark::DoNotOptimize(seen);
+  state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * chunk.size()));
+}
+BENCHMARK(BM_OutputSinkLines)->Arg(0)->Arg(16)->Arg(80)->Arg(1000)->Arg(64 * kKiB);
+
+}  // namespace
+}  // namespace procly
+
+int main(int argc, char** argv) {
+  procly::g_argv0 = argv[0];
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
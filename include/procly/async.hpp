@@ -0,0 +1,117 @@
+#pragma once
+
+/// @file async.hpp
+/// @brief Deferred results for reactor-driven operations.
+
+#include <atomic>
+#include <functional>
+#include <future>
+#include <memory>
+#include <optional>
+#include <utility>
+
+#include "procly/platform.hpp"
+#include "procly/result.hpp"
+
+#if PROCLY_HAS_CXX20 && defined(__cpp_impl_coroutine)
+#include <coroutine>
+/// @brief True when Async<T> can be co_awaited.
+#define PROCLY_HAS_COROUTINES 1
+#else
+/// @brief True when Async<T> can be co_awaited.
+#define PROCLY_HAS_COROUTINES 0
+#endif
+
+namespace procly {
+
+/// @brief Runs a continuation, for example by posting it to a thread pool.
+using Executor = std::function<void(std::function<void()>)>;
+
+/// @brief Result of an operation driven by a Reactor.
+///
+/// Nothing happens until the Async is started with then(), to_future(), or
+/// (C++20) co_await. The continuation runs on the thread driving the
+/// Reactor unless an executor is given with via(). Must be started from the
+/// reactor's thread or while the reactor is not running.
+template <typename T>
+class [[nodiscard]] Async {
+ public:
+  /// @brief Callback receiving the final result.
+  using Callback = std::function<void(Result<T>)>;
+  /// @brief Starts the operation; invokes the callback exactly once.
+  using Start = std::function<void(Callback)>;
+
+  /// @brief Wrap a start function.
+  explicit Async(Start start) : start_(std::move(start)) {}
+  /// @brief Move-construct an unstarted operation.
+  Async(Async&& other) noexcept
+      : start_(std::move(other.start_)), executor_(std::move(other.executor_)) {}
+  Async& operator=(Async&&) = delete;
+  Async(const Async&) = delete;
+  Async& operator=(const Async&) = delete;
+  /// @brief Destroy the operation handle.
+  ~Async() = default;
+
+  /// @brief Create an already-completed operation.
+  static Async ready(Result<T> result) {
+    return Async([result = std::move(result)](Callback callback) { callback(result); });
+  }
+
+  /// @brief Deliver the result through executor instead of inline.
+  Async via(Executor executor) && {
+    executor_ = std::move(executor);
+    return std::move(*this);
+  }
+
+  /// @brief Start the operation; callback runs once with the result.
+  void then(Callback callback) && {
+    Start start = std::move(start_);
+    if (!executor_) {
+      start(std::move(callback));
+      return;
+    }
+    start([executor = std::move(executor_), callback = std::move(callback)](Result<T> result) {
+      executor([callback, result = std::move(result)]() { callback(result); });
+    });
+  }
+
+  /// @brief Start the operation and deliver the result through a future.
+  std::future<Result<T>> to_future() && {
+    auto promise = std::make_shared<std::promise<Result<T>>>();
+    auto future = promise->get_future();
+    std::move(*this).then([promise](Result<T> result) { promise->set_value(std::move(result)); });
+    return future;
+  }
+
+#if PROCLY_HAS_COROUTINES
+  /// @brief Awaitable: always starts the operation.
+  bool await_ready() const noexcept { return false; }
+  /// @brief Awaitable: suspend unless the result arrived synchronously.
+  bool await_suspend(std::coroutine_handle<> handle) {
+    std::move(*this).then([this, handle](Result<T> result) {
+      result_.emplace(std::move(result));
+      // Whichever of the callback and await_suspend gets here second resumes.
+      if (settled_.exchange(true, std::memory_order_acq_rel)) {
+        handle.resume();
+      }
+    });
+    return !settled_.exchange(true, std::memory_order_acq_rel);
+  }
+  /// @brief Awaitable: the delivered result.
+  Result<T> await_resume() { return std::move(*result_); }
+#endif
+
+ private:
+  /// @brief Operation start function, consumed when started.
+  Start start_;
+  /// @brief Optional executor for the continuation.
+  Executor executor_;
+#if PROCLY_HAS_COROUTINES
+  /// @brief Result storage while awaited.
+  std::optional<Result<T>> result_;
+  /// @brief Suspend/complete handshake while awaited.
+  std::atomic<bool> settled_{false};
+#endif
+};
+
+}  // namespace procly
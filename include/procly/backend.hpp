@@ -0,0 +1,183 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "procly/child.hpp"
+#include "procly/command.hpp"
+#include "procly/internal/env_block.hpp"
+#include "procly/result.hpp"
+#include "procly/status.hpp"
+#include "procly/stdio.hpp"
+
+namespace procly {
+
+/// @brief Lowered stdio configuration for one stream of a SpawnSpec.
+struct StdioSpec {
+  /// @brief How the stream is connected.
+  enum class Kind : std::uint8_t {
+    /// @brief Inherit the parent's descriptor.
+    inherit,
+    /// @brief Attach to the null device.
+    null,
+    /// @brief Create a pipe; the parent end is returned in Spawned.
+    piped,
+    /// @brief Duplicate the borrowed descriptor fd.
+    fd,
+    /// @brief Open path with mode (and perms).
+    file,
+    /// @brief Duplicate the child's stdout (stderr only).
+    dup_stdout,
+  };
+
+  /// @brief Connection kind.
+  Kind kind = Kind::inherit;
+  /// @brief Borrowed descriptor for Kind::fd.
+  int fd = -1;
+  /// @brief Keeps fd open for Kind::fd while the spec is alive (Stdio::bytes, SharedFile).
+  std::shared_ptr<const void> fd_owner;
+  /// @brief Stdio::bytes payload behind fd; each spawn hands its child a fresh read-only
+  /// description of it so concurrent children never share a file offset.
+  std::shared_ptr<const std::string> bytes;
+  /// @brief Requested capacity for piped streams; 0 keeps the system default.
+  std::size_t pipe_capacity = 0;
+  /// @brief File path for Kind::file.
+  std::filesystem::path path;
+  /// @brief Open mode for Kind::file.
+  OpenMode mode = OpenMode::read;
+#if PROCLY_PLATFORM_POSIX
+  /// @brief Creation permissions for Kind::file.
+  std::optional<FilePerms> perms;
+#endif
+};
+
+/// @brief Fully lowered spawn request handed to a Backend.
+struct SpawnSpec {
+  /// @brief Argument vector; argv[0] is the program.
+  std::vector<std::string> argv;
+  /// @brief Executable resolved ahead of time (PreparedCommand); backends then skip the PATH
+  /// search.
+  std::optional<std::string> exec_path;
+  /// @brief Borrowed descriptor of the executable (PreparedCommand::pin_executable()); run with
+  /// execveat(AT_EMPTY_PATH) so nothing is looked up by path. Linux only.
+  std::optional<int> exec_fd;
+  /// @brief Working directory for the child.
+  std::optional<std::filesystem::path> cwd;
+  /// @brief Borrowed directory descriptor; takes precedence over cwd.
+  std::optional<int> cwd_fd;
+  /// @brief Complete child environment.
+  internal::EnvBlock envp;
+
+  /// @brief Lowered stdin.
+  StdioSpec stdin_spec;
+  /// @brief Lowered stdout.
+  StdioSpec stdout_spec;
+  /// @brief Lowered stderr.
+  StdioSpec stderr_spec;
+
+  /// @brief Spawn options from the Command.
+  SpawnOptions opts;
+  /// @brief Existing process group to join (later pipeline stages).
+  std::optional<int> process_group;
+};
+
+class Backend;
+
+/// @brief Record of a process started by a Backend.
+struct Spawned {
+  /// @brief Process id; -1 once reaped.
+  int pid = -1;
+  /// @brief Process group when the child leads or joined one.
+  std::optional<int> pgid;
+  /// @brief Parent end of piped stdin, owned by the receiver.
+  std::optional<int> stdin_fd;
+  /// @brief Parent end of piped stdout, owned by the receiver.
+  std::optional<int> stdout_fd;
+  /// @brief Parent end of piped stderr, owned by the receiver.
+  std::optional<int> stderr_fd;
+  /// @brief True when signals target the process group.
+  bool new_process_group = false;
+  /// @brief Backend that owns the process; set by procly after spawn().
+  Backend* backend = nullptr;
+  /// @brief When the process was started; backends that set it get ResourceUsage::wall_time.
+  std::optional<std::chrono::steady_clock::time_point> started;
+  /// @brief Final result once reaped (see mark_reaped()).
+  std::optional<WaitResult> terminal_result;
+#if PROCLY_PLATFORM_LINUX
+  /// @brief cgroup the process was started in (SpawnOptions::cgroup); set by procly after spawn().
+  std::optional<std::filesystem::path> cgroup;
+#endif
+};
+
+/// @brief Process creation and supervision strategy.
+///
+/// procly calls one backend from many threads at once, so implementations
+/// must be safe for concurrent use. Every process is later waited on and
+/// signalled through the backend that spawned it.
+class Backend {
+ public:
+  virtual ~Backend() = default;
+  /// @brief Start a process described by spec.
+  virtual Result<Spawned> spawn(const SpawnSpec& spec) = 0;
+  /// @brief Wait with optional timeout and terminate/kill escalation.
+  virtual Result<WaitResult> wait(Spawned& spawned,
+                                  std::optional<std::chrono::milliseconds> timeout,
+                                  std::chrono::milliseconds kill_grace) = 0;
+  /// @brief Reap the process if it has exited.
+  virtual Result<std::optional<ExitStatus>> try_wait(Spawned& spawned) = 0;
+  /// @brief Send SIGTERM (or equivalent).
+  virtual Result<void> terminate(Spawned& spawned) = 0;
+  /// @brief Send SIGKILL (or equivalent).
+  virtual Result<void> kill(Spawned& spawned) = 0;
+  /// @brief Send a POSIX signal.
+  virtual Result<void> signal(Spawned& spawned, int signo) = 0;
+  /// @brief The last handle to an unreaped process is being destroyed.
+  ///
+  /// The default does nothing, leaving the process to whoever reaps it.
+  virtual void abandon(Spawned& spawned) { (void)spawned; }
+  /// @brief New descriptor, owned by the caller, that polls readable once the process exits.
+  virtual Result<int> open_exit_handle(const Spawned& spawned) {
+    (void)spawned;
+    return Error{std::make_error_code(std::errc::not_supported), "open_exit_handle"};
+  }
+};
+
+/// @brief Record a reaped process so later waits return result and signals are no-ops.
+inline void mark_reaped(Spawned& spawned, WaitResult result) {
+  spawned.terminal_result = result;
+  spawned.pid = -1;
+  spawned.pgid.reset();
+  spawned.new_process_group = false;
+}
+
+/// @brief Make backend the default for spawns on the calling thread while alive.
+///
+/// Scopes nest and are strictly per-thread. Command::backend() and
+/// Pipeline::backend() take precedence over the thread default.
+class ScopedBackend {
+ public:
+  /// @brief Install backend as this thread's default.
+  explicit ScopedBackend(Backend& backend);
+  /// @brief Restore the previous default.
+  ~ScopedBackend();
+  ScopedBackend(const ScopedBackend&) = delete;
+  ScopedBackend& operator=(const ScopedBackend&) = delete;
+
+ private:
+  /// @brief Default in effect before this scope.
+  Backend* previous_ = nullptr;
+};
+
+/// @brief Backend used by spawns on the calling thread that do not pick one.
+Backend& default_backend();
+/// @brief The platform backend (posix_spawn with fork/exec fallback), ignoring overrides.
+Backend& native_backend();
+
+}  // namespace procly
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <vector>
+
+#include "procly/child.hpp"
+#include "procly/command.hpp"
+#include "procly/platform.hpp"
+#include "procly/result.hpp"
+#include "procly/status.hpp"
+
+#if PROCLY_HAS_STD_SPAN
+#include <span>
+#endif
+
+namespace procly {
+
+/// @brief Upper bound on commands running at once in run_all().
+struct Concurrency {
+  /// @brief Maximum number of live children; 0 is treated as 1.
+  std::size_t limit = 1;
+};
+
+/// @brief Policy for run_all().
+struct RunAllOptions {
+  /// @brief Stop launching commands once one fails to spawn or exits unsuccessfully.
+  ///
+  /// Commands already running are left to finish; those never started report
+  /// errc::cancelled.
+  bool fail_fast = false;
+  /// @brief Optional per-command timeout before the child is terminated.
+  std::optional<std::chrono::milliseconds> timeout;
+  /// @brief Grace period after terminate before kill.
+  std::chrono::milliseconds kill_grace{WaitOptions::kDefaultKillGrace};
+  /// @brief Called in completion order with the command's index and result.
+  ///
+  /// Runs on the calling thread; not called for cancelled commands.
+  std::function<void(std::size_t index, const Result<Output>& result)> on_complete;
+};
+
+/// @brief Run commands with at most concurrency.limit alive at a time and capture each output.
+///
+/// Each command behaves like Command::output() (stdout/stderr piped unless set
+/// otherwise). All children are supervised by one Reactor on the calling
+/// thread, so the cost per command is its pipes, not a thread. Returns one
+/// result per command in input order; the outer error covers reactor failure.
+[[nodiscard]] Result<std::vector<Result<Output>>> run_all(const Command* commands,
+                                                         std::size_t count,
+                                                         Concurrency concurrency,
+                                                         const RunAllOptions& options = {});
+#if PROCLY_HAS_STD_SPAN
+/// @brief Span overload of run_all().
+[[nodiscard]] Result<std::vector<Result<Output>>> run_all(std::span<const Command> commands,
+                                                         Concurrency concurrency,
+                                                         const RunAllOptions& options = {});
+#endif
+
+}  // namespace procly
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <memory>
+
+#include "procly/result.hpp"
+
+namespace procly {
+
+/// @brief Thread-safe flag that cuts blocking procly calls short.
+///
+/// Copies share one state, so a token handed to a call can be cancelled from
+/// any thread through another copy. Calls watching the token poll its
+/// wait_handle() next to their pipes and exit handles, so cancel() wakes them
+/// at once; they then terminate their processes, kill them after the usual
+/// grace period, and reap them before returning.
+class CancellationToken {
+ public:
+  /// @brief Construct a token that is not cancelled.
+  CancellationToken();
+
+  /// @brief Cancel every call watching this token; later calls see it at once.
+  void cancel() noexcept;
+  /// @brief True once cancel() has been called on any copy.
+  [[nodiscard]] bool cancelled() const noexcept;
+  /// @brief Descriptor that polls readable once the token is cancelled.
+  ///
+  /// Created on first use and owned by the token; stays valid while any copy
+  /// is alive.
+  [[nodiscard]] Result<int> wait_handle() const;
+
+ private:
+  /// @brief Shared state type.
+  struct State;
+  /// @brief State shared by every copy.
+  std::shared_ptr<State> state_;
+};
+
+}  // namespace procly
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "procly/platform.hpp"
+
+#if PROCLY_PLATFORM_LINUX
+
+#include <chrono>
+#include <filesystem>
+#include <optional>
+
+#include "procly/result.hpp"
+
+namespace procly {
+
+/// @brief cgroup v2 directory created for one Command or Pipeline and removed with the handle.
+///
+/// Place children in it with Command::cgroup(path()) or Pipeline::cgroup(path());
+/// kill() then ends every process inside, daemonized or regrouped descendants
+/// included, with a single write to cgroup.kill (Linux 5.14+). Child::kill_tree()
+/// and PipelineChild::kill_tree() do the same for the cgroup a child was started in.
+class Cgroup {
+ public:
+  /// @brief Create a new, uniquely named cgroup under parent (a delegated cgroup v2 directory).
+  [[nodiscard]] static Result<Cgroup> create(const std::filesystem::path& parent);
+
+  /// @brief Move-construct a cgroup handle.
+  Cgroup(Cgroup&& other) noexcept;
+  /// @brief Move-assign a cgroup handle, destroying the current cgroup first.
+  Cgroup& operator=(Cgroup&& other) noexcept;
+  Cgroup(const Cgroup&) = delete;
+  Cgroup& operator=(const Cgroup&) = delete;
+  /// @brief Kill what is left, wait briefly for the cgroup to empty, and remove it.
+  ~Cgroup();
+
+  /// @brief Directory of the cgroup.
+  [[nodiscard]] const std::filesystem::path& path() const noexcept { return path_; }
+
+  /// @brief SIGKILL every process in the cgroup through cgroup.kill; does not wait.
+  Result<void> kill() const;
+  /// @brief Whether any process is still in the cgroup (cgroup.events "populated").
+  [[nodiscard]] Result<bool> populated() const;
+  /// @brief Block until the cgroup is empty, woken by cgroup.events notifications.
+  ///
+  /// Fails with errc::timeout when timeout passes first.
+  Result<void> wait_empty(std::optional<std::chrono::milliseconds> timeout = std::nullopt) const;
+  /// @brief kill() followed by wait_empty(timeout).
+  Result<void> kill_and_wait(
+      std::optional<std::chrono::milliseconds> timeout = std::nullopt) const;
+
+ private:
+  explicit Cgroup(std::filesystem::path path) noexcept;
+  void destroy() noexcept;
+
+  /// @brief Owned cgroup directory; empty once moved from.
+  std::filesystem::path path_;
+};
+
+}  // namespace procly
+
+#endif
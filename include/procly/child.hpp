@@ -4,12 +4,16 @@
 #include <memory>
 #include <optional>
 
+#include "procly/async.hpp"
+#include "procly/cancellation.hpp"
 #include "procly/pipe.hpp"
 #include "procly/result.hpp"
 #include "procly/status.hpp"
 
 namespace procly {
 
+class Reactor;
+
 namespace internal {
 /// @brief Internal access helper for Child.
 struct ChildAccess;
@@ -23,6 +27,10 @@ struct WaitOptions {
   std::optional<std::chrono::milliseconds> timeout;
   /// @brief Grace period after terminate before kill.
   std::chrono::milliseconds kill_grace{kDefaultKillGrace};
+  /// @brief Optional token that cuts the wait short like an expired timeout.
+  ///
+  /// Honored by Child::wait(WaitOptions) and Pipeline::output(WaitOptions).
+  std::optional<CancellationToken> cancel;
 };
 
 /// @brief Result of waiting with timeout and escalation policy.
@@ -31,10 +39,14 @@ struct WaitResult {
   ExitStatus status;
   /// @brief True when the timeout budget elapsed before completion.
   bool timed_out = false;
+  /// @brief True when the cancellation token fired before completion.
+  bool cancelled = false;
   /// @brief True when SIGTERM (or equivalent) was sent.
   bool sent_terminate = false;
   /// @brief True when SIGKILL (or equivalent) was sent.
   bool sent_kill = false;
+  /// @brief Resources used by the child; empty when the backend does not report them.
+  std::optional<ResourceUsage> usage;
 
   /// @brief True if the child exited successfully.
   [[nodiscard]] bool success() const noexcept { return status.success(); }
@@ -69,16 +81,45 @@ class Child {
   /// @brief Wait for child completion.
   Result<ExitStatus> wait();
   /// @brief Non-blocking wait.
+  ///
+  /// Reaps the child if it has exited; pairs with exit_handle() readiness.
   Result<std::optional<ExitStatus>> try_wait();
+  /// @brief Pollable descriptor that becomes readable once the child exits.
+  ///
+  /// A pidfd on Linux, a kqueue watching the pid on macOS; register it with
+  /// epoll/kqueue/poll and call try_wait() when it fires. Readiness does not
+  /// reap the child. The descriptor is owned by the Child, opened on first
+  /// use, and stays valid until the handle is destroyed.
+  Result<int> exit_handle();
   /// @brief Wait with timeout and termination policy.
   ///
   /// Returns the final exit status together with timeout/escalation details.
   Result<WaitResult> wait(WaitOptions options);
+  /// @brief Wait on reactor without blocking, applying the same timeout policy.
+  ///
+  /// The Child must outlive the operation. Backends without exit handles fall
+  /// back to a blocking wait(options) when the operation starts.
+  [[nodiscard]] Async<WaitResult> wait_async(Reactor& reactor, WaitOptions options = {});
+
+  /// @brief Current CPU time, resident set size and thread count of the running child.
+  ///
+  /// Linux only (std::errc::not_supported elsewhere). /proc/<pid>/stat is
+  /// opened on first use and re-read on every call, so sampling once a second
+  /// costs one read. Fails with ESRCH once the child has been reaped.
+  Result<ResourceSample> sample();
 
   /// @brief Send SIGTERM (or platform equivalent).
   Result<void> terminate();
   /// @brief Send SIGKILL (or platform equivalent).
   Result<void> kill();
+  /// @brief Kill the child together with every descendant, then wait for them to go.
+  ///
+  /// For a child started in a cgroup (Command::cgroup(), Linux) this is one
+  /// write to cgroup.kill followed by a wait on cgroup.events until the
+  /// cgroup is empty, failing with errc::timeout once timeout passes. Every
+  /// process in that cgroup is killed, so give the child its own (see
+  /// Cgroup). Otherwise the same as kill(). Does not reap the child.
+  Result<void> kill_tree(std::optional<std::chrono::milliseconds> timeout = std::nullopt);
 
   /// @brief Send a POSIX signal (POSIX only).
   Result<void> signal(int signo);
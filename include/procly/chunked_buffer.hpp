@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "procly/status.hpp"
+
+namespace procly {
+
+namespace internal {
+struct ChunkedBufferAccess;
+}  // namespace internal
+
+/// @brief Captured bytes held as a list of fixed-size chunks (a rope).
+///
+/// Appending never moves bytes already stored, so capture is O(n) with no
+/// regrowth copies and no single large allocation. Chunks come from and
+/// return to a small process-wide pool, so repeated captures reuse memory.
+/// Move-only.
+class ChunkedBuffer {
+ public:
+  /// @brief Bytes per chunk; every chunk but the last is full.
+  static constexpr std::size_t kChunkBytes = 64 * 1024;
+
+  /// @brief Forward iterator over the chunks as string views.
+  class const_iterator {
+   public:
+    /// @brief Iterator category.
+    using iterator_category = std::forward_iterator_tag;
+    /// @brief Chunk view type.
+    using value_type = std::string_view;
+    /// @brief Index difference type.
+    using difference_type = std::ptrdiff_t;
+    /// @brief Views are returned by value.
+    using pointer = void;
+    /// @brief Views are returned by value.
+    using reference = std::string_view;
+
+    /// @brief Construct a singular iterator.
+    const_iterator() = default;
+    /// @brief View of the current chunk.
+    std::string_view operator*() const { return buffer_->chunk(index_); }
+    /// @brief Advance to the next chunk.
+    const_iterator& operator++() {
+      ++index_;
+      return *this;
+    }
+    /// @brief Advance to the next chunk.
+    const_iterator operator++(int) {
+      const_iterator previous = *this;
+      ++index_;
+      return previous;
+    }
+    /// @brief Compare positions.
+    bool operator==(const const_iterator& other) const { return index_ == other.index_; }
+    /// @brief Compare positions.
+    bool operator!=(const const_iterator& other) const { return index_ != other.index_; }
+
+   private:
+    friend class ChunkedBuffer;
+    const_iterator(const ChunkedBuffer* buffer, std::size_t index)
+        : buffer_(buffer), index_(index) {}
+
+    /// @brief Iterated buffer.
+    const ChunkedBuffer* buffer_ = nullptr;
+    /// @brief Current chunk index.
+    std::size_t index_ = 0;
+  };
+
+  /// @brief Construct an empty buffer.
+  ChunkedBuffer() = default;
+  /// @brief Move-construct, taking over the chunks.
+  ChunkedBuffer(ChunkedBuffer&& other) noexcept;
+  /// @brief Move-assign, returning this buffer's chunks to the pool first.
+  ChunkedBuffer& operator=(ChunkedBuffer&& other) noexcept;
+  ChunkedBuffer(const ChunkedBuffer&) = delete;
+  ChunkedBuffer& operator=(const ChunkedBuffer&) = delete;
+  /// @brief Return the chunks to the pool.
+  ~ChunkedBuffer();
+
+  /// @brief Append bytes, filling the last chunk before taking a new one.
+  void append(const char* data, std::size_t size);
+  /// @brief Append bytes, filling the last chunk before taking a new one.
+  void append(std::string_view data) { append(data.data(), data.size()); }
+  /// @brief Drop the contents and return the chunks to the pool.
+  void clear() noexcept;
+
+  /// @brief Total number of bytes.
+  [[nodiscard]] std::size_t size() const noexcept { return size_; }
+  /// @brief True when no bytes are stored.
+  [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+  /// @brief Number of chunks holding data.
+  [[nodiscard]] std::size_t chunk_count() const noexcept {
+    return (size_ + kChunkBytes - 1) / kChunkBytes;
+  }
+  /// @brief View of chunk index (< chunk_count()).
+  [[nodiscard]] std::string_view chunk(std::size_t index) const noexcept {
+    std::size_t offset = index * kChunkBytes;
+    std::size_t length = size_ - offset < kChunkBytes ? size_ - offset : kChunkBytes;
+    return {chunks_[index].get(), length};
+  }
+  /// @brief First chunk.
+  [[nodiscard]] const_iterator begin() const noexcept { return {this, 0}; }
+  /// @brief Past the last chunk.
+  [[nodiscard]] const_iterator end() const noexcept { return {this, chunk_count()}; }
+
+  /// @brief Copy every chunk into one contiguous string.
+  [[nodiscard]] std::string flatten() const;
+
+ private:
+  friend struct internal::ChunkedBufferAccess;
+
+  /// @brief Writable space after the last byte, taking a new chunk when the last one is full.
+  char* writable_tail(std::size_t* room);
+  /// @brief Record count bytes written into writable_tail().
+  void commit(std::size_t count) noexcept { size_ += count; }
+
+  /// @brief Owned chunks, each kChunkBytes long; trailing chunks may be spare.
+  std::vector<std::unique_ptr<char[]>> chunks_;
+  /// @brief Bytes stored.
+  std::size_t size_ = 0;
+};
+
+/// @brief Output captured into chunked buffers.
+struct ChunkedOutput {
+  /// @brief Exit status for the process.
+  ExitStatus status;
+  /// @brief Captured stdout.
+  ChunkedBuffer stdout_data;
+  /// @brief Captured stderr.
+  ChunkedBuffer stderr_data;
+};
+
+}  // namespace procly
@@ -1,19 +1,31 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 #include <filesystem>
-#include <map>
 #include <optional>
 #include <string>
 #include <string_view>
 #include <vector>
 
+#include "procly/cancellation.hpp"
 #include "procly/child.hpp"
+#include "procly/chunked_buffer.hpp"
+#include "procly/compressed_buffer.hpp"
+#include "procly/environment.hpp"
+#include "procly/exec_path_cache.hpp"
+#include "procly/internal/command_storage.hpp"
 #include "procly/internal/concurrent_use_guard.hpp"
+#include "procly/internal/env_block.hpp"
+#include "procly/mapped_buffer.hpp"
+#include "procly/output_sink.hpp"
 #include "procly/platform.hpp"
 #include "procly/result.hpp"
+#include "procly/spill_buffer.hpp"
 #include "procly/status.hpp"
+#include "procly/stdin_source.hpp"
 #include "procly/stdio.hpp"
+#include "procly/timeline.hpp"
 
 #if PROCLY_HAS_STD_SPAN
 #include <span>
@@ -21,23 +33,139 @@
 
 namespace procly {
 
+class Backend;
+
 namespace internal {
 /// @brief Internal access helper for Command.
 struct CommandAccess;
 }  // namespace internal
 
+/// @brief How the fork/exec fallback creates the child when posix_spawn cannot be used.
+enum class ForkStrategy : std::uint8_t {
+  /// @brief Plain fork(); copies the parent's page tables.
+  fork,
+  /// @brief clone(CLONE_VM | CLONE_VFORK) on a private stack (Linux; fork() elsewhere).
+  ///
+  /// Avoids the page-table copy, which matters for parents with a large RSS. The
+  /// calling thread is suspended until the child execs.
+  vfork,
+};
+
+#if PROCLY_PLATFORM_POSIX
+/// @brief Resource limit applied with setrlimit() in the child before exec.
+struct ResourceLimit {
+  /// @brief Resource id (RLIMIT_CPU, RLIMIT_AS, RLIMIT_NOFILE, ...).
+  int resource = 0;
+  /// @brief Soft limit; RLIM_INFINITY for none.
+  std::uint64_t soft = 0;
+  /// @brief Hard limit; RLIM_INFINITY for none.
+  std::uint64_t hard = 0;
+};
+#endif
+
+#if PROCLY_PLATFORM_LINUX
+/// @brief CPU scheduling policy set in the child.
+enum class SchedulingPolicy : std::uint8_t {
+  /// @brief Keep the parent's policy.
+  inherit,
+  /// @brief SCHED_OTHER.
+  normal,
+  /// @brief SCHED_BATCH: CPU-bound work that should not preempt interactive tasks.
+  batch,
+  /// @brief SCHED_IDLE: run only when the CPU would otherwise be idle.
+  idle,
+};
+
+/// @brief I/O scheduling class for ioprio_set().
+enum class IoPriorityClass : std::uint8_t {
+  /// @brief IOPRIO_CLASS_RT (requires CAP_SYS_ADMIN).
+  realtime = 1,
+  /// @brief IOPRIO_CLASS_BE.
+  best_effort = 2,
+  /// @brief IOPRIO_CLASS_IDLE.
+  idle = 3,
+};
+
+/// @brief I/O priority applied with ioprio_set() in the child.
+struct IoPriority {
+  /// @brief Scheduling class.
+  IoPriorityClass io_class = IoPriorityClass::best_effort;
+  /// @brief Level within the class, 0 (highest) to 7; ignored for idle.
+  int level = 4;
+};
+
+/// @brief NUMA memory policy set with set_mempolicy() in the child.
+enum class NumaPolicy : std::uint8_t {
+  /// @brief MPOL_BIND: allocate only from the listed nodes.
+  bind,
+  /// @brief MPOL_PREFERRED: prefer the first listed node, fall back to any other.
+  preferred,
+  /// @brief MPOL_INTERLEAVE: spread pages round-robin over the listed nodes.
+  interleave,
+};
+#endif
+
 /// @brief Options that affect process creation.
 struct SpawnOptions {
   /// @brief Create a new process group.
   bool new_process_group = false;
   /// @brief Merge stderr into stdout.
   bool merge_stderr_into_stdout = false;
+  /// @brief Skip closing inherited descriptors in the child.
+  ///
+  /// Only safe when every non-stdio descriptor in the parent is opened with
+  /// O_CLOEXEC (or marked FD_CLOEXEC); anything else leaks into the child.
+  bool trust_cloexec = false;
+  /// @brief Whether a bare program name is resolved through the PATH lookup cache.
+  PathLookup path_lookup = PathLookup::automatic;
+  /// @brief Child creation strategy for the fork/exec fallback.
+  ForkStrategy fork_strategy = ForkStrategy::fork;
+#if PROCLY_PLATFORM_POSIX
+  /// @brief Limits set in the child before exec; forces the fork/exec path.
+  std::vector<ResourceLimit> limits;
+#endif
+#if PROCLY_PLATFORM_POSIX
+  /// @brief Absolute nice value set with setpriority(); forces the fork/exec path.
+  std::optional<int> nice;
+#endif
+#if PROCLY_PLATFORM_LINUX
+  /// @brief CPUs the child may run on; empty inherits the parent's mask.
+  ///
+  /// Set with sched_setaffinity() in the child, which forces the fork/exec
+  /// path so the spawning thread's own mask is never touched. Pair it with
+  /// ForkStrategy::vfork to keep spawns cheap.
+  std::vector<int> cpu_affinity;
+  /// @brief Scheduling policy set in the child.
+  ///
+  /// normal stays on posix_spawn (POSIX_SPAWN_SETSCHEDULER); batch and idle
+  /// force the fork/exec path since posix_spawnattr_setschedpolicy only takes
+  /// the POSIX policies. Pair them with ForkStrategy::vfork to keep spawns cheap.
+  SchedulingPolicy scheduling_policy = SchedulingPolicy::inherit;
+  /// @brief I/O priority; forces the fork/exec path.
+  std::optional<IoPriority> io_priority;
+  /// @brief cgroup v2 directory the child is created in; forces the fork/exec path.
+  ///
+  /// Uses clone3(CLONE_INTO_CGROUP) so the child never runs outside the
+  /// cgroup; kernels without clone3 move it via cgroup.procs before exec.
+  std::optional<std::filesystem::path> cgroup;
+  /// @brief NUMA nodes the child allocates memory from; empty inherits the parent's policy.
+  ///
+  /// Applies numa_policy with set_mempolicy() before exec, which forces the
+  /// fork/exec path. Unless cpu_affinity is set, the child is also pinned to
+  /// the CPUs of those nodes so it runs next to its memory.
+  std::vector<int> numa_nodes;
+  /// @brief Memory policy used with numa_nodes.
+  NumaPolicy numa_policy = NumaPolicy::bind;
+#endif
 };
 
 /// @brief Builder for launching a child process.
 ///
-/// Command builders are not safe for concurrent shared use from multiple
-/// threads.
+/// Builder methods are not safe for concurrent shared use from multiple
+/// threads. Once configured, a Command may be shared as a read-only
+/// template: the const launch methods (spawn(), status(), output() and
+/// their variants) may run concurrently from any number of threads as long
+/// as no builder method runs at the same time.
 class Command {
  public:
   /// @brief Construct a command with argv[0]=program.
@@ -60,6 +188,13 @@ class Command {
 
   /// @brief Set current working directory for the child.
   Command& current_dir(std::filesystem::path path);
+#if PROCLY_PLATFORM_POSIX
+  /// @brief Set the child's working directory from an open directory descriptor.
+  ///
+  /// The descriptor is borrowed and must stay open until spawning returns.
+  /// Repeated spawns then skip resolving the directory path.
+  Command& current_dir(int dir_fd);
+#endif
 
   /// @brief Set or override an environment variable.
   Command& env(std::string key, std::string value);
@@ -67,6 +202,11 @@ class Command {
   Command& env_remove(std::string_view key);
   /// @brief Clear inherited environment.
   Command& env_clear();
+  /// @brief Inherit from an environment snapshot instead of the live process environment.
+  ///
+  /// The lowered environment block is then cached and reused across spawns until
+  /// env(), env_remove(), env_clear() or environment() change it.
+  Command& environment(Environment base);
 
   /// @brief Configure stdin.
   Command& stdin(Stdio value);
@@ -77,13 +217,110 @@ class Command {
 
   /// @brief Set spawn options.
   Command& options(SpawnOptions value);
+#if PROCLY_PLATFORM_POSIX
+  /// @brief Apply setrlimit(resource, {soft, hard}) in the child before exec.
+  ///
+  /// A later call for the same resource replaces the earlier one.
+  Command& limit(int resource, std::uint64_t soft, std::uint64_t hard);
+#endif
+#if PROCLY_PLATFORM_LINUX
+  /// @brief Start the child inside the cgroup v2 directory path.
+  Command& cgroup(std::filesystem::path path);
+  /// @brief Bind the child's memory (and, without cpu_affinity, its CPUs) to NUMA nodes.
+  Command& numa_nodes(std::vector<int> nodes, NumaPolicy policy = NumaPolicy::bind);
+#endif
+  /// @brief Spawn through backend instead of the calling thread's default_backend().
+  ///
+  /// The backend is borrowed and must outlive the command and every child it spawns.
+  Command& backend(Backend& backend);
 
   /// @brief Spawn without waiting.
   [[nodiscard]] Result<Child> spawn() const;
   /// @brief Spawn and wait for exit status.
   [[nodiscard]] Result<ExitStatus> status() const;
+  /// @brief Spawn and wait for exit status until cancel fires.
+  ///
+  /// Cancellation wakes the wait at once, terminates the child, kills it
+  /// after WaitOptions::kDefaultKillGrace, reaps it, and returns
+  /// errc::cancelled.
+  [[nodiscard]] Result<ExitStatus> status(const CancellationToken& cancel) const;
   /// @brief Spawn, capture output, and wait.
   [[nodiscard]] Result<Output> output() const;
+  /// @brief Spawn, capture output with per-stream limits and size hints, and wait.
+  [[nodiscard]] Result<Output> output(const CaptureOptions& options) const;
+  /// @brief Like output(options), cut short by cancel as in status(cancel).
+  [[nodiscard]] Result<Output> output(const CaptureOptions& options,
+                                      const CancellationToken& cancel) const;
+  /// @brief Spawn with piped stdin, feed input while capturing output, and wait.
+  ///
+  /// Input is written from the same poll loop that drains stdout/stderr, so
+  /// large filters cannot deadlock on a full pipe. Overrides any stdin setting.
+  [[nodiscard]] Result<Output> output_with_input(std::string_view input,
+                                                 const CaptureOptions& options = {}) const;
+  /// @brief Spawn with piped stdin, pull input from source while capturing output, and wait.
+  ///
+  /// The drain loop asks source for the next chunk only when stdin can take
+  /// more, so input is produced at the pace the child consumes it, with one
+  /// chunk in memory and no writer thread. Overrides any stdin setting.
+  [[nodiscard]] Result<Output> output_from(StdinSource input,
+                                           const CaptureOptions& options = {}) const;
+#if PROCLY_HAS_STD_SPAN
+  /// @brief Byte-span overload of output_with_input().
+  [[nodiscard]] Result<Output> output_with_input(std::span<const std::byte> input,
+                                                 const CaptureOptions& options = {}) const;
+#endif
+  /// @brief Spawn, capture output into caller-owned strings, and wait.
+  ///
+  /// The strings are cleared first but keep their capacity, so reusing them
+  /// across calls keeps heap allocation off the capture path.
+  [[nodiscard]] Result<ExitStatus> output_into(std::string& stdout_data,
+                                               std::string& stderr_data) const;
+  /// @brief Spawn, capture output into pooled fixed-size chunks, and wait.
+  ///
+  /// Reads land straight in the chunks, which are never moved or regrown, so
+  /// large captures need no contiguous allocation; flatten() when one is needed.
+  [[nodiscard]] Result<ChunkedOutput> output_chunked() const;
+#if PROCLY_PLATFORM_POSIX
+  /// @brief Spawn with stdout/stderr redirected to anonymous files and map them after exit.
+  ///
+  /// The child writes straight into the page cache, so there is no pipe and
+  /// no copy, whatever the output size. Explicit stdout/stderr settings are
+  /// overridden.
+  [[nodiscard]] Result<MappedOutput> output_mapped() const;
+  /// @brief Spawn, capture output in memory up to memory_limit bytes per stream, and wait.
+  ///
+  /// A stream that outgrows memory_limit moves to an unlinked file in the
+  /// temporary directory and is mapped once the child exits, so a rare huge
+  /// output costs disk rather than RAM while small outputs never touch it.
+  [[nodiscard]] Result<SpillOutput> output_spill(std::size_t memory_limit) const;
+#endif
+  /// @brief Spawn, capture stdout and stderr into one buffer in read order, and wait.
+  ///
+  /// Every read from either pipe appends its bytes to TimelineOutput::data
+  /// and a (time, stream, byte range) record, so the true interleaving of the
+  /// two streams can be rebuilt after the fact. Explicit stdout/stderr
+  /// settings other than piped are kept, and those streams stay uncaptured.
+  [[nodiscard]] Result<TimelineOutput> output_timeline() const;
+  /// @brief Spawn, compress output with codec as it is read, and wait.
+  ///
+  /// Each stream is fed to a streaming compressor chunk by chunk, so a large,
+  /// repetitive capture costs about its compressed size in memory. level 0 is
+  /// the codec's default. The codec is set up before spawning, so a build
+  /// without codec (errc::invalid_argument) or a codec that fails to start
+  /// returns the error without running the command.
+  [[nodiscard]] Result<CompressedOutput> output_compressed(Compression codec,
+                                                           int level = 0) const;
+  /// @brief Spawn, stream output into sinks as it is read, and wait.
+  ///
+  /// Memory stays bounded by the sinks no matter how much the child writes.
+  [[nodiscard]] Result<ExitStatus> output(OutputSink stdout_sink, OutputSink stderr_sink) const;
+
+  /// @brief Spawn now and wait for exit status on reactor.
+  ///
+  /// Piped output is drained and discarded, as with status().
+  [[nodiscard]] Async<ExitStatus> status_async(Reactor& reactor) const;
+  /// @brief Spawn now and capture output on reactor.
+  [[nodiscard]] Async<Output> output_async(Reactor& reactor) const;
 
   /// @brief Spawn and throw on error.
   [[nodiscard]] Child spawn_or_throw() const;
@@ -93,15 +330,19 @@ class Command {
   [[nodiscard]] Output output_or_throw() const;
 
  private:
-  /// @brief Argument vector (argv[0] is the program).
-  std::vector<std::string> argv_;
+  /// @brief Argument vector (argv[0] is the program) and environment delta, in one arena.
+  internal::CommandStorage strings_;
   /// @brief Optional working directory for the child.
   std::optional<std::filesystem::path> cwd_;
+  /// @brief Optional borrowed working directory descriptor (POSIX).
+  std::optional<int> cwd_fd_;
 
   /// @brief Whether to inherit the parent environment.
   bool inherit_env_ = true;
-  /// @brief Environment updates (set/unset) to apply to the child.
-  std::map<std::string, std::optional<std::string>, std::less<>> env_delta_;
+  /// @brief Snapshot to inherit from instead of the live process environment.
+  std::optional<Environment> env_base_;
+  /// @brief Lowered environment block, kept while the inputs are stable.
+  mutable internal::EnvBlockCache env_cache_;
 
   /// @brief Optional stdin configuration override.
   std::optional<Stdio> stdin_;
@@ -111,6 +352,8 @@ class Command {
   std::optional<Stdio> stderr_;
   /// @brief Spawn options for the command.
   SpawnOptions opts_{};
+  /// @brief Borrowed backend selected with backend(); null uses default_backend().
+  Backend* backend_ = nullptr;
   /// @brief Detect unsupported concurrent shared use of the builder.
   mutable internal::ConcurrentUseGuard concurrent_use_;
 
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "procly/result.hpp"
+#include "procly/status.hpp"
+
+namespace procly {
+
+namespace internal {
+class Compressor;
+}  // namespace internal
+
+/// @brief Codec used to compress a captured stream.
+enum class Compression : std::uint8_t {
+  /// @brief Zstandard frame (builds with PROCLY_ENABLE_ZSTD).
+  zstd,
+  /// @brief LZ4 frame (builds with PROCLY_ENABLE_LZ4).
+  lz4,
+};
+
+/// @brief True when procly was built with support for codec.
+[[nodiscard]] bool compression_supported(Compression codec) noexcept;
+
+/// @brief Captured output held as one compressed frame.
+///
+/// Chunks are compressed as the drain loop reads them, so capture holds the
+/// frame plus the codec's working buffers rather than the raw bytes. The
+/// frame is a standard zstd or LZ4 frame that the codec's own tools can
+/// decompress. Move-only.
+class CompressedBuffer {
+ public:
+  /// @brief Construct an empty buffer.
+  CompressedBuffer() = default;
+  /// @brief Move-construct a buffer.
+  CompressedBuffer(CompressedBuffer&& other) noexcept = default;
+  /// @brief Move-assign a buffer.
+  CompressedBuffer& operator=(CompressedBuffer&& other) noexcept = default;
+  CompressedBuffer(const CompressedBuffer&) = delete;
+  CompressedBuffer& operator=(const CompressedBuffer&) = delete;
+  /// @brief Destroy the buffer.
+  ~CompressedBuffer() = default;
+
+  /// @brief Codec of the frame.
+  [[nodiscard]] Compression codec() const noexcept { return codec_; }
+  /// @brief The compressed frame; empty until capture finishes.
+  [[nodiscard]] std::string_view frame() const noexcept { return frame_; }
+  /// @brief Bytes in the frame.
+  [[nodiscard]] std::size_t compressed_size() const noexcept { return frame_.size(); }
+  /// @brief Bytes captured before compression.
+  [[nodiscard]] std::size_t size() const noexcept { return size_; }
+  /// @brief True when nothing was captured.
+  [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+  /// @brief Decompress the frame into a string of size() bytes.
+  [[nodiscard]] Result<std::string> decompress() const;
+
+ private:
+  friend class internal::Compressor;
+
+  /// @brief Codec of the frame.
+  Compression codec_ = Compression::zstd;
+  /// @brief Compressed frame.
+  std::string frame_;
+  /// @brief Uncompressed byte count.
+  std::size_t size_ = 0;
+};
+
+/// @brief Output captured into compressed buffers.
+struct CompressedOutput {
+  /// @brief Exit status for the process.
+  ExitStatus status;
+  /// @brief Captured stdout.
+  CompressedBuffer stdout_data;
+  /// @brief Captured stderr.
+  CompressedBuffer stderr_data;
+};
+
+}  // namespace procly
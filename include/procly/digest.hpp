@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace procly {
+
+/// @brief Checksum or hash computed over a captured stream.
+enum class DigestAlgorithm : std::uint8_t {
+  /// @brief CRC-32C (Castagnoli); uses the SSE4.2 or ARMv8 CRC instructions when available.
+  crc32c,
+  /// @brief 64-bit xxHash (seed 0).
+  xxh64,
+  /// @brief SHA-256.
+  sha256,
+};
+
+/// @brief Incremental digest over a byte stream.
+///
+/// Feed chunks as they arrive with update(); hex() can be read at any point
+/// and leaves the digest open for more input.
+class Digest {
+ public:
+  /// @brief Start an empty digest.
+  explicit Digest(DigestAlgorithm algorithm);
+  /// @brief Copy the running state.
+  Digest(const Digest& other);
+  /// @brief Copy the running state.
+  Digest& operator=(const Digest& other);
+  /// @brief Move the running state.
+  Digest(Digest&& other) noexcept;
+  /// @brief Move the running state.
+  Digest& operator=(Digest&& other) noexcept;
+  /// @brief Destroy the digest.
+  ~Digest();
+
+  /// @brief Algorithm in use.
+  [[nodiscard]] DigestAlgorithm algorithm() const noexcept { return algorithm_; }
+  /// @brief Add bytes to the digest.
+  void update(const char* data, std::size_t size);
+  /// @brief Add bytes to the digest.
+  void update(std::string_view data) { update(data.data(), data.size()); }
+  /// @brief Lowercase hex of the digest of every byte so far (big-endian for CRC-32C/xxh64).
+  [[nodiscard]] std::string hex() const;
+
+ private:
+  /// @brief Opaque per-algorithm state.
+  struct State;
+
+  /// @brief Algorithm in use.
+  DigestAlgorithm algorithm_;
+  /// @brief Running state.
+  std::unique_ptr<State> state_;
+};
+
+}  // namespace procly
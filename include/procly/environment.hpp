@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <string_view>
+#include <utility>
+
+#include "procly/internal/env_block.hpp"
+
+namespace procly {
+
+namespace internal {
+/// @brief Internal access helper for Environment.
+struct EnvironmentAccess;
+}  // namespace internal
+
+/// @brief Immutable snapshot of a process environment.
+///
+/// Snapshots are cheap to copy (copies share storage) and safe to share across
+/// Commands and threads. Use Command::environment() to make a Command inherit
+/// from a snapshot instead of re-reading the live process environment on every
+/// spawn.
+class Environment {
+ public:
+  /// @brief Construct an empty environment.
+  Environment() = default;
+
+  /// @brief Capture the current process environment.
+  [[nodiscard]] static Environment capture();
+
+  /// @brief Look up a variable by name.
+  [[nodiscard]] std::optional<std::string_view> get(std::string_view key) const noexcept {
+    return block_.find(key);
+  }
+  /// @brief Number of variables in the snapshot.
+  [[nodiscard]] std::size_t size() const noexcept { return block_.size(); }
+  /// @brief True when the snapshot has no variables.
+  [[nodiscard]] bool empty() const noexcept { return block_.empty(); }
+
+ private:
+  explicit Environment(internal::EnvBlock block) : block_(std::move(block)) {}
+
+  /// @brief Entries sorted by key, one per variable.
+  internal::EnvBlock block_;
+
+  friend struct internal::EnvironmentAccess;
+};
+
+}  // namespace procly
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+namespace procly {
+
+/// @brief How a command resolves a bare program name against PATH.
+enum class PathLookup : std::uint8_t {
+  /// @brief Use the process-wide cache when it is enabled, otherwise search PATH.
+  automatic,
+  /// @brief Always use the process-wide cache, even when it is disabled globally.
+  cached,
+  /// @brief Always search PATH, bypassing the cache.
+  uncached,
+};
+
+/// @brief Process-wide executable lookup cache settings.
+struct ExecPathCacheOptions {
+  /// @brief Use the cache for commands with PathLookup::automatic.
+  bool enabled = false;
+  /// @brief Re-check a cached executable's mtime before each use.
+  ///
+  /// A cached entry is dropped and PATH searched again when the file is gone or
+  /// its modification time changed. Programs newly installed earlier in PATH are
+  /// only picked up after clear_exec_path_cache().
+  bool revalidate_mtime = false;
+};
+
+/// @brief Replace the process-wide cache settings.
+void configure_exec_path_cache(ExecPathCacheOptions options) noexcept;
+/// @brief Current process-wide cache settings.
+[[nodiscard]] ExecPathCacheOptions exec_path_cache_options() noexcept;
+/// @brief Drop every cached lookup.
+void clear_exec_path_cache();
+/// @brief Drop cached lookups for one program name (any PATH or cwd).
+void invalidate_exec_path(std::string_view program);
+
+}  // namespace procly
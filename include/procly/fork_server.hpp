@@ -0,0 +1,71 @@
+#pragma once
+
+#include <memory>
+
+#include "procly/result.hpp"
+
+namespace procly {
+
+class Backend;
+class ScopedBackend;
+
+/// @brief Helper process that performs spawns on behalf of its creator.
+///
+/// The server is forked once from the calling process and then receives
+/// serialized spawn requests over a unix socket, with stdio descriptors passed
+/// as SCM_RIGHTS. It spawns the children itself, returns their pipe ends, and
+/// streams exit statuses back, so later spawns never fork the (possibly large,
+/// heavily threaded) caller. Start it early: before other threads exist and
+/// before the heap grows. Relative program and working-directory paths resolve
+/// against the server's working directory at start().
+///
+/// Select it per thread with Scope, or per Command/Pipeline with backend().
+/// Children spawned through a server belong to it: wait, signal and exit
+/// handles are routed over the socket. The ForkServer must outlive every
+/// Child and PipelineChild spawned through it. Destroying it shuts the server
+/// down; children still running are left running.
+class ForkServer {
+ public:
+  /// @brief Opaque implementation (the client-side backend).
+  struct Impl;
+
+  /// @brief Routes spawns on the calling thread through a server while alive.
+  class Scope {
+   public:
+    /// @brief Install the server as the backend for this thread.
+    explicit Scope(ForkServer& server);
+    /// @brief Restore the previous backend.
+    ~Scope();
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+   private:
+    /// @brief Backend override restored on destruction.
+    std::unique_ptr<ScopedBackend> override_;
+  };
+
+  /// @brief Fork the server process and connect to it.
+  static Result<ForkServer> start();
+
+  /// @brief Move-construct a server handle.
+  ForkServer(ForkServer&& other) noexcept;
+  /// @brief Move-assign a server handle.
+  ForkServer& operator=(ForkServer&& other) noexcept;
+  ForkServer(const ForkServer&) = delete;
+  ForkServer& operator=(const ForkServer&) = delete;
+  /// @brief Shut the server down and reap it.
+  ~ForkServer();
+
+  /// @brief Process identifier of the server.
+  [[nodiscard]] int id() const noexcept;
+  /// @brief The server as a Backend, for Command::backend() or Pipeline::backend().
+  [[nodiscard]] Backend& backend() noexcept;
+
+ private:
+  explicit ForkServer(std::unique_ptr<Impl> impl) noexcept;
+
+  /// @brief Owned implementation state.
+  std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace procly
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "procly/pipe.hpp"
+#include "procly/result.hpp"
+
+namespace procly {
+
+/// @brief In-process pipeline stage: C++ code in place of a filter process.
+///
+/// The body runs on its own thread once the pipeline is spawned, reading the
+/// previous stage's output from in and writing the next stage's input to out.
+/// Both ends are closed when it returns, so returning early stops upstream
+/// writers just as an exiting process would. A function stage cannot be the
+/// first stage of a pipeline. The body must not throw.
+class FunctionStage {
+ public:
+  /// @brief Stage body; an error is reported in PipelineStatus::function_stages.
+  using Body = std::function<Result<void>(PipeReader& in, PipeWriter& out)>;
+
+  /// @brief Wrap body as a stage.
+  explicit FunctionStage(Body body) : body_(std::move(body)) {}
+
+  /// @brief Stage body.
+  [[nodiscard]] const Body& body() const noexcept { return body_; }
+
+ private:
+  /// @brief Stage body.
+  Body body_;
+};
+
+/// @brief Per-line callback for transform_lines().
+///
+/// Receives one line without its delimiter and appends whatever should be
+/// written downstream (delimiter included) to out. Returning false stops the
+/// stage, like `head`.
+using LineTransform = std::function<bool(std::string_view line, std::string& out)>;
+
+/// @brief Stage running body on its own thread.
+FunctionStage transform(FunctionStage::Body body);
+/// @brief Stage splitting its input on delimiter and passing each line through fn.
+///
+/// Output is batched into large writes; a trailing line without a delimiter is
+/// delivered at end of input.
+FunctionStage transform_lines(LineTransform fn, std::string delimiter = "\n");
+
+/// @brief Outcome of one function stage.
+struct FunctionStageStatus {
+  /// @brief Position of the stage in the pipeline, counting every stage.
+  std::size_t position = 0;
+  /// @brief Error returned by the stage body, if any.
+  std::optional<Error> error;
+
+  /// @brief True when the body returned success.
+  [[nodiscard]] bool success() const noexcept { return !error.has_value(); }
+};
+
+}  // namespace procly
@@ -1,13 +1,23 @@
 #pragma once
 
+#include <cstddef>
+#include <filesystem>
 #include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
 
 #include "procly/child.hpp"
+#include "procly/chunked_buffer.hpp"
 #include "procly/pipeline.hpp"
 
+namespace procly {
+struct Spawned;
+}  // namespace procly
+
 namespace procly::internal {
 
-struct Spawned;
+using procly::Spawned;
 
 struct ChildAccess {
   static std::unique_ptr<procly::Child::Impl>& impl(procly::Child& child) { return child.impl_; }
@@ -21,8 +31,21 @@ struct PipelineAccess {
   static const std::vector<procly::Command>& stages(const procly::Pipeline& pipeline) {
     return pipeline.stages_;
   }
+  static const std::vector<std::pair<std::size_t, procly::FunctionStage>>& functions(
+      const procly::Pipeline& pipeline) {
+    return pipeline.functions_;
+  }
   static bool pipefail(const procly::Pipeline& pipeline) { return pipeline.pipefail_; }
   static bool new_process_group(const procly::Pipeline& pipeline) { return pipeline.new_pgrp_; }
+  static std::size_t pipe_capacity(const procly::Pipeline& pipeline) {
+    return pipeline.pipe_capacity_;
+  }
+  static procly::Backend* backend(const procly::Pipeline& pipeline) { return pipeline.backend_; }
+#if PROCLY_PLATFORM_LINUX
+  static const std::optional<std::filesystem::path>& cgroup(const procly::Pipeline& pipeline) {
+    return pipeline.cgroup_;
+  }
+#endif
   static const std::optional<procly::Stdio>& stdin_opt(const procly::Pipeline& pipeline) {
     return pipeline.stdin_;
   }
@@ -34,4 +57,11 @@ struct PipelineAccess {
   }
 };
 
+struct ChunkedBufferAccess {
+  static char* writable_tail(procly::ChunkedBuffer& buffer, std::size_t* room) {
+    return buffer.writable_tail(room);
+  }
+  static void commit(procly::ChunkedBuffer& buffer, std::size_t count) { buffer.commit(count); }
+};
+
 }  // namespace procly::internal
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define PROCLY_BYTE_SCAN_SSE2 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define PROCLY_BYTE_SCAN_NEON 1
+#endif
+
+namespace procly::internal {
+
+// Match mask of one 16-byte block: bit i is set when block[i] == byte (NEON: bit 4i + 3).
+#if PROCLY_BYTE_SCAN_SSE2
+inline std::uint64_t block_matches(const char* block, char byte) {
+  __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block));
+  return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(byte))));
+}
+constexpr int kMatchBitsPerByte = 1;
+#elif PROCLY_BYTE_SCAN_NEON
+inline std::uint64_t block_matches(const char* block, char byte) {
+  uint8x16_t bytes = vld1q_u8(reinterpret_cast<const std::uint8_t*>(block));
+  uint8x16_t needle = vdupq_n_u8(static_cast<std::uint8_t>(byte));
+  uint16x8_t equal = vreinterpretq_u16_u8(vceqq_u8(bytes, needle));
+  // Narrowing shift packs each byte's compare result into a nibble; keep one bit per nibble.
+  return vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(equal, 4)), 0) & 0x8888888888888888ULL;
+}
+constexpr int kMatchBitsPerByte = 4;
+#endif
+
+// Call fn(offset) for every occurrence of byte in [data, data + size), in order. memchr skips
+// runs without a match; after each hit the following 16-byte blocks are compared at once with
+// SSE2 or NEON and their matches walked as a bit mask, so dense delimiters (short lines) cost
+// one compare per block instead of one memchr call per match. The first block without a match
+// hands back to memchr.
+template <typename Fn>
+void for_each_byte(const char* data, std::size_t size, char byte, Fn&& fn) {
+  std::size_t offset = 0;
+  while (offset < size) {
+    const void* found = std::memchr(data + offset, byte, size - offset);
+    if (found == nullptr) {
+      return;
+    }
+    std::size_t pos = static_cast<const char*>(found) - data;
+    fn(pos);
+    offset = pos + 1;
+#if PROCLY_BYTE_SCAN_SSE2 || PROCLY_BYTE_SCAN_NEON
+    while (offset + 16 <= size) {
+      std::uint64_t mask = block_matches(data + offset, byte);
+      if (mask == 0) {
+        offset += 16;
+        break;
+      }
+      for (; mask != 0; mask &= mask - 1) {
+        fn(offset + static_cast<std::size_t>(__builtin_ctzll(mask)) / kMatchBitsPerByte);
+      }
+      offset += 16;
+    }
+#endif
+  }
+}
+
+// Call fn(offset) for every non-overlapping occurrence of needle (non-empty) in haystack.
+template <typename Fn>
+void for_each_match(std::string_view haystack, std::string_view needle, Fn&& fn) {
+  if (needle.size() == 1) {
+    for_each_byte(haystack.data(), haystack.size(), needle.front(), fn);
+    return;
+  }
+  std::size_t next = 0;
+  for_each_byte(haystack.data(), haystack.size(), needle.front(), [&](std::size_t pos) {
+    if (pos < next || haystack.compare(pos, needle.size(), needle) != 0) {
+      return;
+    }
+    fn(pos);
+    next = pos + needle.size();
+  });
+}
+
+}  // namespace procly::internal
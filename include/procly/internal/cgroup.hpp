@@ -0,0 +1,28 @@
+#pragma once
+
+#include "procly/platform.hpp"
+
+#if PROCLY_PLATFORM_LINUX
+
+#include <chrono>
+#include <filesystem>
+#include <optional>
+
+#include "procly/result.hpp"
+
+namespace procly::internal {
+
+// Write "1" to <cgroup>/cgroup.kill: SIGKILL every process in the cgroup and its descendants.
+Result<void> cgroup_kill(const std::filesystem::path& cgroup);
+
+// Whether <cgroup>/cgroup.events reports live processes.
+Result<bool> cgroup_populated(const std::filesystem::path& cgroup);
+
+// Block until cgroup.events reports "populated 0", polling it for POLLPRI change notifications.
+// Fails with errc::timeout once timeout passes; nullopt waits indefinitely.
+Result<void> cgroup_wait_empty(const std::filesystem::path& cgroup,
+                               std::optional<std::chrono::milliseconds> timeout);
+
+}  // namespace procly::internal
+
+#endif
@@ -0,0 +1,10 @@
+#pragma once
+
+namespace procly::internal {
+
+// Ensure no descriptor >= first_fd other than keep_fd and extra_keep_fd survives exec.
+// Descriptors are either closed or marked FD_CLOEXEC. Async-signal-safe: intended for the child
+// side of fork().
+void close_inherited_fds(int first_fd, int keep_fd, int extra_keep_fd = -1) noexcept;
+
+}  // namespace procly::internal
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+#include "procly/cancellation.hpp"
+#include "procly/child.hpp"
+#include "procly/chunked_buffer.hpp"
+#include "procly/compressed_buffer.hpp"
+#include "procly/internal/backend.hpp"
+#include "procly/internal/compressor.hpp"
+#include "procly/internal/fd.hpp"
+#include "procly/output_sink.hpp"
+#include "procly/result.hpp"
+#include "procly/spill_buffer.hpp"
+#include "procly/status.hpp"
+#include "procly/stdin_source.hpp"
+#include "procly/timeline.hpp"
+
+namespace procly::internal {
+
+// Spawn a lowered spec on backend (default_backend() when null) and record which backend owns
+// the child.
+Result<Spawned> spawn_lowered(const SpawnSpec& spec, Backend* backend = nullptr);
+
+// Close stdin, drain and discard any piped output, then wait. A fired cancel token terminates
+// and kills the child, reaps it, and returns errc::cancelled.
+Result<ExitStatus> finish_status(Child& child, const CancellationToken* cancel = nullptr);
+
+// Close stdin, capture stdout/stderr under options, then wait; cancel as in finish_status().
+Result<Output> finish_output(Child& child, const CaptureOptions& options = {},
+                             const CancellationToken* cancel = nullptr);
+
+// Feed input to stdin while capturing stdout/stderr under options, then wait.
+Result<Output> finish_output_with_input(Child& child, std::string_view input,
+                                        const CaptureOptions& options);
+
+// As above, pulling input from source whenever stdin has room.
+Result<Output> finish_output_with_input(Child& child, StdinSource& input,
+                                        const CaptureOptions& options);
+
+// Close stdin, capture stdout/stderr into caller-owned strings, then wait.
+Result<ExitStatus> finish_output_into(Child& child, std::string& stdout_data,
+                                      std::string& stderr_data);
+
+// Close stdin, capture stdout/stderr into pooled chunks, then wait.
+Result<ChunkedOutput> finish_output_chunked(Child& child);
+
+// Close stdin, capture stdout/stderr in memory up to memory_limit each and on disk beyond it,
+// then wait.
+Result<SpillOutput> finish_output_spill(Child& child, std::size_t memory_limit);
+
+// Close stdin, capture stdout/stderr into one buffer with a record per read, then wait.
+Result<TimelineOutput> finish_output_timeline(Child& child);
+
+// Close stdin, compress stdout/stderr as they drain, then wait. The compressors are created by
+// the caller before spawning, so an unusable codec never runs the command.
+Result<CompressedOutput> finish_output_compressed(Child& child, Compressor stdout_compressor,
+                                                  Compressor stderr_compressor);
+
+// Close stdin, stream stdout/stderr into sinks, then wait.
+Result<ExitStatus> finish_stream(Child& child, OutputSink& stdout_sink, OutputSink& stderr_sink);
+
+// Anonymous read/write file for capture: memfd on Linux, an unlinked temporary file elsewhere.
+Result<unique_fd> create_capture_file(const char* name);
+
+// Read-only descriptor positioned at offset 0 over a file holding data: a memfd sealed against
+// writes and resizing on Linux, an unlinked temporary file elsewhere.
+Result<unique_fd> create_sealed_file(const char* name, std::string_view data);
+
+// Unlinked read/write file in the temporary directory ($TMPDIR), backed by disk rather than
+// memory.
+Result<unique_fd> create_temp_file(const char* name);
+
+}  // namespace procly::internal
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "procly/internal/env_block.hpp"
+#include "procly/internal/small_vector.hpp"
+
+namespace procly::internal {
+
+// Argument vector and environment delta of a Command. Every string lives in one arena and is
+// referenced by offset, so growing the arena keeps references valid; the reference lists hold a
+// typical command inline. Building a command of a few short arguments and env overrides costs a
+// single arena allocation, and moving it costs none.
+class CommandStorage {
+ public:
+  [[nodiscard]] std::size_t arg_count() const noexcept { return args_.size(); }
+  [[nodiscard]] std::string_view arg(std::size_t index) const noexcept {
+    return view(args_[index]);
+  }
+  void push_arg(std::string_view value);
+  void clear_args() noexcept;
+  // Owned copy of the arguments, for SpawnSpec::argv.
+  [[nodiscard]] std::vector<std::string> argv() const;
+
+  // Environment delta entries, sorted by key.
+  [[nodiscard]] std::size_t env_count() const noexcept { return env_.size(); }
+  [[nodiscard]] EnvDeltaEntry env_entry(std::size_t index) const noexcept;
+  [[nodiscard]] std::optional<EnvDeltaEntry> find_env(std::string_view key) const noexcept;
+  // Set key to value, or record it as unset when value is nullopt.
+  void set_env(std::string_view key, std::optional<std::string_view> value);
+  void clear_env() noexcept;
+
+ private:
+  struct Ref {
+    std::uint32_t offset = 0;
+    std::uint32_t size = 0;
+  };
+  struct EnvRef {
+    Ref key;
+    Ref value;
+    bool set = false;
+  };
+
+  // Sized so that the usual handful of arguments and overrides needs no second allocation.
+  static constexpr std::size_t kInitialArena = 256;
+  static constexpr std::size_t kInlineArgs = 8;
+  static constexpr std::size_t kInlineEnv = 4;
+
+  [[nodiscard]] std::string_view view(Ref ref) const noexcept {
+    return std::string_view(arena_).substr(ref.offset, ref.size);
+  }
+  [[nodiscard]] std::size_t lower_bound(std::string_view key) const noexcept;
+  Ref append(std::string_view value);
+  void compact();
+
+  std::string arena_;
+  // Bytes of the arena no longer referenced (overwritten values, cleared entries).
+  std::size_t dead_ = 0;
+  SmallVector<Ref, kInlineArgs> args_;
+  SmallVector<EnvRef, kInlineEnv> env_;
+};
+
+}  // namespace procly::internal
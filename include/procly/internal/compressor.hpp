@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+
+#include "procly/compressed_buffer.hpp"
+#include "procly/result.hpp"
+
+namespace procly::internal {
+
+// Builds a CompressedBuffer from one drained stream by feeding each chunk to a streaming
+// compressor as it arrives. A codec failure is remembered, later bytes are dropped so the pipe
+// keeps draining, and finish() reports the error.
+class Compressor {
+ public:
+  // Fails with errc::invalid_argument when procly was built without codec.
+  static Result<Compressor> create(Compression codec, int level);
+
+  Compressor(Compressor&& other) noexcept;
+  Compressor& operator=(Compressor&& other) noexcept;
+  Compressor(const Compressor&) = delete;
+  Compressor& operator=(const Compressor&) = delete;
+  ~Compressor();
+
+  void write(const char* data, std::size_t size);
+  Result<CompressedBuffer> finish();
+
+ private:
+  // Per-codec stream context.
+  struct State;
+
+  explicit Compressor(std::unique_ptr<State> state);
+
+  std::unique_ptr<State> state_;
+  CompressedBuffer buffer_;
+  std::optional<Error> error_;
+};
+
+}  // namespace procly::internal
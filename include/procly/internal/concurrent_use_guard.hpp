@@ -6,6 +6,8 @@
 
 namespace procly::internal {
 
+// Debug-build detector for unsupported sharing. enter() claims exclusive use; enter_shared()
+// admits any number of concurrent readers but still aborts if they overlap an exclusive user.
 class ConcurrentUseGuard {
  public:
   ConcurrentUseGuard() = default;
@@ -17,7 +19,7 @@ class ConcurrentUseGuard {
   ConcurrentUseGuard& operator=(const ConcurrentUseGuard& other) noexcept {
 #ifndef NDEBUG
     (void)other;
-    in_use_.clear(std::memory_order_release);
+    state_.store(0, std::memory_order_release);
 #endif
     return *this;
   }
@@ -29,36 +31,56 @@ class ConcurrentUseGuard {
   ConcurrentUseGuard& operator=(ConcurrentUseGuard&& other) noexcept {
 #ifndef NDEBUG
     (void)other;
-    in_use_.clear(std::memory_order_release);
+    state_.store(0, std::memory_order_release);
 #endif
     return *this;
   }
 
   class Scope {
    public:
-    Scope(const ConcurrentUseGuard& guard, const char* context) : guard_(guard) {
-      guard_.acquire(context);
+    Scope(const ConcurrentUseGuard& guard, const char* context, bool shared)
+        : guard_(guard), shared_(shared) {
+      if (shared_) {
+        guard_.acquire_shared(context);
+      } else {
+        guard_.acquire(context);
+      }
     }
 
-    ~Scope() { guard_.release(); }
+    ~Scope() {
+      if (shared_) {
+        guard_.release_shared();
+      } else {
+        guard_.release();
+      }
+    }
 
     Scope(const Scope&) = delete;
     Scope& operator=(const Scope&) = delete;
 
    private:
     const ConcurrentUseGuard& guard_;
+    bool shared_;
   };
 
-  [[nodiscard]] Scope enter(const char* context) const { return {*this, context}; }
+  [[nodiscard]] Scope enter(const char* context) const { return {*this, context, false}; }
+  [[nodiscard]] Scope enter_shared(const char* context) const { return {*this, context, true}; }
 
  private:
+  static constexpr int kExclusive = -1;
+
+  [[noreturn]] static void fail(const char* context) {
+    std::fputs("procly: concurrent use of non-thread-safe object: ", stderr);
+    std::fputs(context, stderr);
+    std::fputc('\n', stderr);
+    std::abort();
+  }
+
   void acquire(const char* context) const {
 #ifndef NDEBUG
-    if (in_use_.test_and_set(std::memory_order_acq_rel)) {
-      std::fputs("procly: concurrent use of non-thread-safe object: ", stderr);
-      std::fputs(context, stderr);
-      std::fputc('\n', stderr);
-      std::abort();
+    int expected = 0;
+    if (!state_.compare_exchange_strong(expected, kExclusive, std::memory_order_acq_rel)) {
+      fail(context);
     }
 #else
     (void)context;
@@ -67,12 +89,32 @@ class ConcurrentUseGuard {
 
   void release() const {
 #ifndef NDEBUG
-    in_use_.clear(std::memory_order_release);
+    state_.store(0, std::memory_order_release);
+#endif
+  }
+
+  void acquire_shared(const char* context) const {
+#ifndef NDEBUG
+    int current = state_.load(std::memory_order_acquire);
+    do {
+      if (current == kExclusive) {
+        fail(context);
+      }
+    } while (!state_.compare_exchange_weak(current, current + 1, std::memory_order_acq_rel));
+#else
+    (void)context;
+#endif
+  }
+
+  void release_shared() const {
+#ifndef NDEBUG
+    state_.fetch_sub(1, std::memory_order_release);
 #endif
   }
 
 #ifndef NDEBUG
-  mutable std::atomic_flag in_use_ = ATOMIC_FLAG_INIT;
+  // 0 when idle, kExclusive while enter() is held, otherwise the number of shared users.
+  mutable std::atomic<int> state_{0};
 #endif
 };
 
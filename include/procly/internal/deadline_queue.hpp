@@ -0,0 +1,50 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <map>
+#include <optional>
+#include <utility>
+
+namespace procly::internal {
+
+// Ordered set of pending deadlines for an event loop: arming, cancelling and popping a timer are
+// O(log n), and the next wakeup is O(1), however many timers are pending. Owners keep the handle
+// returned by schedule() to cancel or re-arm their timer; a handle is invalidated once its timer
+// is cancelled or popped.
+template <typename T>
+class DeadlineQueue {
+ public:
+  using TimePoint = std::chrono::steady_clock::time_point;
+  using Handle = typename std::multimap<TimePoint, T>::iterator;
+
+  Handle schedule(TimePoint when, T value) { return timers_.emplace(when, std::move(value)); }
+
+  void cancel(Handle handle) { timers_.erase(handle); }
+
+  // Earliest pending deadline, if any.
+  [[nodiscard]] std::optional<TimePoint> next() const {
+    if (timers_.empty()) {
+      return std::nullopt;
+    }
+    return timers_.begin()->first;
+  }
+
+  // Remove and return the earliest timer when it is due at now. Timers due at the same instant
+  // pop in the order they were scheduled.
+  std::optional<T> pop_due(TimePoint now) {
+    if (timers_.empty() || timers_.begin()->first > now) {
+      return std::nullopt;
+    }
+    auto node = timers_.extract(timers_.begin());
+    return std::move(node.mapped());
+  }
+
+  [[nodiscard]] bool empty() const noexcept { return timers_.empty(); }
+  [[nodiscard]] std::size_t size() const noexcept { return timers_.size(); }
+
+ private:
+  std::multimap<TimePoint, T> timers_;
+};
+
+}  // namespace procly::internal
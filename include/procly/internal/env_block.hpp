@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace procly::internal {
+
+// Immutable, shareable envp block: one contiguous buffer of NUL-terminated "KEY=VALUE" entries
+// plus the null-terminated pointer array execve/posix_spawn expect. Copies share storage.
+class EnvBlock {
+ public:
+  using const_iterator = std::vector<std::string_view>::const_iterator;
+
+  EnvBlock();
+  static EnvBlock from_entries(const std::vector<std::string_view>& entries);
+
+  [[nodiscard]] char* const* data() const noexcept;
+  [[nodiscard]] std::size_t size() const noexcept;
+  [[nodiscard]] bool empty() const noexcept { return size() == 0; }
+  [[nodiscard]] const std::vector<std::string_view>& entries() const noexcept;
+  [[nodiscard]] const_iterator begin() const noexcept { return entries().begin(); }
+  [[nodiscard]] const_iterator end() const noexcept { return entries().end(); }
+
+  [[nodiscard]] std::optional<std::string_view> find(std::string_view key) const noexcept;
+
+ private:
+  struct Storage {
+    std::unique_ptr<char[]> buffer;
+    std::vector<char*> pointers;
+    std::vector<std::string_view> entries;
+  };
+
+  explicit EnvBlock(std::shared_ptr<const Storage> storage) : storage_(std::move(storage)) {}
+
+  std::shared_ptr<const Storage> storage_;
+};
+
+// Lowered envp block memoized on a Command. Spawns on a shared const Command may fill it from
+// several threads at once, so loads and stores are serialized; copies take a snapshot.
+class EnvBlockCache {
+ public:
+  EnvBlockCache() = default;
+  EnvBlockCache(const EnvBlockCache& other) : block_(other.load()) {}
+  EnvBlockCache& operator=(const EnvBlockCache& other) {
+    if (this != &other) {
+      auto block = other.load();
+      std::lock_guard lock(mutex_);
+      block_ = std::move(block);
+    }
+    return *this;
+  }
+  ~EnvBlockCache() = default;
+
+  [[nodiscard]] std::optional<EnvBlock> load() const {
+    std::lock_guard lock(mutex_);
+    return block_;
+  }
+  void store(EnvBlock block) {
+    std::lock_guard lock(mutex_);
+    block_ = std::move(block);
+  }
+  void reset() {
+    std::lock_guard lock(mutex_);
+    block_.reset();
+  }
+
+ private:
+  mutable std::mutex mutex_;
+  std::optional<EnvBlock> block_;
+};
+
+// One change of an environment delta: set key to value, or unset it when value is nullopt.
+struct EnvDeltaEntry {
+  std::string_view key;
+  std::optional<std::string_view> value;
+};
+
+inline std::string_view env_entry_key(std::string_view entry) {
+  return entry.substr(0, entry.find('='));
+}
+
+// Entries of the live process environment, sorted by key; the last duplicate of a key wins.
+// Views point into environ and are invalidated by setenv/putenv.
+std::vector<std::string_view> process_environment_entries();
+
+// Merge sorted base entries with count delta entries, sorted by unique key, into a new sorted
+// block.
+EnvBlock apply_env_delta(const std::vector<std::string_view>& base, const EnvDeltaEntry* delta,
+                         std::size_t count);
+
+}  // namespace procly::internal
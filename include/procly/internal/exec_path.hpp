@@ -0,0 +1,27 @@
+#pragma once
+
+#include <filesystem>
+#include <optional>
+#include <string>
+
+#include "procly/exec_path_cache.hpp"
+#include "procly/internal/env_block.hpp"
+
+namespace procly::internal {
+
+// Resolve argv[0] against the PATH in envp (or the default search path), resolving relative PATH
+// entries against cwd_fd or cwd. Returns argv0 unchanged when it contains a '/' or nothing
+// matches. Matches under cwd_fd come back relative, for the child to resolve after fchdir.
+std::string resolve_exec_path(const std::string& argv0, const EnvBlock& envp,
+                              const std::optional<std::filesystem::path>& cwd,
+                              std::optional<int> cwd_fd = std::nullopt);
+
+// Resolve argv0 through the process-wide lookup cache. Returns nullopt when `lookup` does not
+// select the cache, argv0 is not a bare name, or PATH has no match (misses are not cached).
+// Lookups relative to a cwd_fd are never cached: the descriptor says nothing about identity.
+std::optional<std::string> cached_exec_path(const std::string& argv0, const EnvBlock& envp,
+                                            const std::optional<std::filesystem::path>& cwd,
+                                            PathLookup lookup,
+                                            std::optional<int> cwd_fd = std::nullopt);
+
+}  // namespace procly::internal
@@ -3,13 +3,16 @@
 #include <fcntl.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <array>
 #include <cerrno>
+#include <cstddef>
 #include <optional>
 #include <utility>
 
 #include "procly/platform.hpp"
 #include "procly/result.hpp"
+#include "procly/stdio.hpp"
 
 namespace procly::internal {
 
@@ -48,6 +51,21 @@ class unique_fd {
   int fd_{-1};
 };
 
+// open(2) flags for a Stdio::file mode; O_CLOEXEC is left to the caller.
+inline int open_flags_for(OpenMode mode) {
+  switch (mode) {
+    case OpenMode::read:
+      return O_RDONLY;
+    case OpenMode::write_truncate:
+      return O_WRONLY | O_CREAT | O_TRUNC;
+    case OpenMode::write_append:
+      return O_WRONLY | O_CREAT | O_APPEND;
+    case OpenMode::read_write:
+      return O_RDWR | O_CREAT;
+  }
+  return O_RDONLY;
+}
+
 inline Result<void> set_cloexec(int fd) {
   int flags = ::fcntl(fd, F_GETFD);
   if (flags == -1) {
@@ -98,4 +116,50 @@ inline Result<std::pair<unique_fd, unique_fd>> create_pipe() {
 #endif
 }
 
+#if PROCLY_PLATFORM_LINUX
+// Largest capacity an unprivileged process may request, from /proc/sys/fs/pipe-max-size.
+inline std::size_t pipe_max_size() {
+  static const std::size_t cached = [] {
+    constexpr std::size_t kFallback = 1024 * 1024;
+    unique_fd file(::open("/proc/sys/fs/pipe-max-size", O_RDONLY | O_CLOEXEC));
+    if (!file) {
+      return kFallback;
+    }
+    std::array<char, 32> buffer{};
+    ssize_t count = ::read(file.get(), buffer.data(), buffer.size() - 1);
+    if (count <= 0) {
+      return kFallback;
+    }
+    std::size_t value = 0;
+    for (ssize_t i = 0; i < count && buffer[i] >= '0' && buffer[i] <= '9'; ++i) {
+      value = value * 10 + static_cast<std::size_t>(buffer[i] - '0');
+    }
+    return value == 0 ? kFallback : value;
+  }();
+  return cached;
+}
+#endif
+
+// Best-effort resize of a pipe; capacity is a tuning hint, so failures are ignored.
+inline void set_pipe_capacity(int fd, std::size_t capacity) {
+#if PROCLY_PLATFORM_LINUX && defined(F_SETPIPE_SZ)
+  if (capacity == 0) {
+    return;
+  }
+  std::size_t clamped = std::min(capacity, pipe_max_size());
+  (void)::fcntl(fd, F_SETPIPE_SZ, static_cast<int>(clamped));
+#else
+  (void)fd;
+  (void)capacity;
+#endif
+}
+
+inline Result<std::pair<unique_fd, unique_fd>> create_pipe(std::size_t capacity) {
+  auto pipe = create_pipe();
+  if (pipe && capacity != 0) {
+    set_pipe_capacity(pipe->first.get(), capacity);
+  }
+  return pipe;
+}
+
 }  // namespace procly::internal
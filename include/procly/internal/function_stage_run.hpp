@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <thread>
+
+#include "procly/function_stage.hpp"
+#include "procly/internal/fd.hpp"
+#include "procly/result.hpp"
+
+namespace procly::internal {
+
+// A function stage running on its own thread. The thread owns both pipe ends and closes them
+// when the body returns; done_handle() turns readable at that point so the stage can be polled
+// next to process exit handles. Destroying a running stage detaches the thread.
+class FunctionStageRun {
+ public:
+  static Result<FunctionStageRun> start(const FunctionStage::Body& body, unique_fd in,
+                                        unique_fd out, std::size_t position);
+
+  FunctionStageRun(FunctionStageRun&& other) noexcept = default;
+  FunctionStageRun& operator=(FunctionStageRun&& other) noexcept;
+  FunctionStageRun(const FunctionStageRun&) = delete;
+  FunctionStageRun& operator=(const FunctionStageRun&) = delete;
+  ~FunctionStageRun();
+
+  [[nodiscard]] int done_handle() const noexcept { return done_.get(); }
+  // Non-blocking check whether the body has returned.
+  [[nodiscard]] bool done() const;
+  // Block until the body returns and report its outcome.
+  FunctionStageStatus join();
+
+ private:
+  struct State;
+
+  FunctionStageRun() = default;
+
+  std::thread thread_;
+  std::shared_ptr<State> state_;
+  unique_fd done_;
+  std::size_t position_ = 0;
+};
+
+}  // namespace procly::internal
@@ -1,18 +1,116 @@
 #pragma once
 
+#include <sys/types.h>
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
 #include <optional>
 #include <string>
+#include <string_view>
+#include <vector>
 
+#include "procly/child.hpp"
+#include "procly/chunked_buffer.hpp"
+#include "procly/output_sink.hpp"
 #include "procly/pipe.hpp"
 #include "procly/result.hpp"
+#include "procly/status.hpp"
+#include "procly/stdin_source.hpp"
+#include "procly/timeline.hpp"
 
 namespace procly::internal {
 
+// Capture buffers start here and double, so large outputs regrow O(log n) times.
+inline constexpr std::size_t kInitialCaptureBytes = 64 * 1024;
+// Spare capacity below this triggers growth before the next read.
+inline constexpr std::size_t kMinReadBytes = 4096;
+// Largest single read: one default-sized pipe buffer.
+inline constexpr std::size_t kMaxReadBytes = 64 * 1024;
+
+// Read once from fd into out's spare capacity, growing it geometrically as needed.
+// Returns the byte count (0 at EOF), or -1 with errno set.
+ssize_t read_into(int fd, std::string& out);
+
 struct DrainResult {
   std::string stdout_data;
   std::string stderr_data;
+  std::size_t stdout_dropped = 0;
+  std::size_t stderr_dropped = 0;
+  std::optional<std::string> stdout_digest;
+  std::optional<std::string> stderr_digest;
+};
+
+// Input written to a child's stdin from the drain loop; the pipe is closed once it is done.
+// With a source, data is refilled from it (into chunk) each time the pipe has taken all of data.
+struct StdinFeed {
+  PipeWriter* pipe = nullptr;
+  std::string_view data;
+  StdinSource* source = nullptr;
+  std::string chunk;
+  // Bytes of earlier chunks already written.
+  std::size_t written_before = 0;
 };
 
 Result<DrainResult> drain_pipes(PipeReader* stdout_pipe, PipeReader* stderr_pipe);
 
+// Capture both pipes under options; on_kill runs once when a kill-policy limit overflows.
+Result<DrainResult> drain_pipes(PipeReader* stdout_pipe, PipeReader* stderr_pipe,
+                                const CaptureOptions& options, const std::function<void()>& on_kill);
+
+// Feed stdin and capture both pipes from one poll loop, so neither side can deadlock.
+Result<DrainResult> drain_pipes(StdinFeed stdin_feed, PipeReader* stdout_pipe,
+                                PipeReader* stderr_pipe, const CaptureOptions& options,
+                                const std::function<void()>& on_kill);
+
+// A further stream captured whole by the same poll loop, such as one pipeline stage's stderr.
+struct ExtraCapture {
+  PipeReader* pipe = nullptr;
+  std::string* out = nullptr;
+};
+
+// Deadline and cancellation for a drain. Once `at` passes or cancel_fd polls readable,
+// terminate runs, then kill after kill_grace; the loop keeps draining meanwhile so no writer
+// blocks on a full pipe. Streams still open kill_grace after the kill (held by an escaped
+// grandchild) are abandoned.
+struct DrainDeadline {
+  std::optional<std::chrono::steady_clock::time_point> at;
+  std::chrono::milliseconds kill_grace{0};
+  // CancellationToken::wait_handle(), or -1.
+  int cancel_fd = -1;
+  std::function<void()> terminate;
+  std::function<void()> kill;
+  bool cancelled = false;
+  bool sent_terminate = false;
+  bool sent_kill = false;
+};
+
+// How to reap once a drain under `deadline` (built from `wait`) has returned: within the rest
+// of the budget or of the escalation the drain started, still watching the token if it has
+// not fired yet.
+WaitOptions reap_options(const DrainDeadline& deadline, const WaitOptions& wait);
+
+// As above, also draining every extra stream in the same pass, under an optional deadline.
+Result<DrainResult> drain_pipes(StdinFeed stdin_feed, PipeReader* stdout_pipe,
+                                PipeReader* stderr_pipe, const CaptureOptions& options,
+                                const std::function<void()>& on_kill,
+                                const std::vector<ExtraCapture>& extra,
+                                DrainDeadline* deadline = nullptr);
+
+// Capture both pipes into caller-owned strings, appending to their current contents.
+Result<void> drain_pipes_into(PipeReader* stdout_pipe, PipeReader* stderr_pipe,
+                              std::string& stdout_data, std::string& stderr_data);
+
+// Capture both pipes into chunked buffers, appending to their current contents.
+Result<void> drain_pipes_into(PipeReader* stdout_pipe, PipeReader* stderr_pipe,
+                              ChunkedBuffer& stdout_data, ChunkedBuffer& stderr_data);
+
+// Capture both pipes into data in read order, appending a record per read to records.
+Result<void> drain_pipes_timeline(PipeReader* stdout_pipe, PipeReader* stderr_pipe,
+                                  std::string& data, std::vector<TimelineRecord>& records);
+
+// Stream both pipes into sinks until EOF; each sink is finished when its pipe closes.
+Result<void> drain_pipes(PipeReader* stdout_pipe, PipeReader* stderr_pipe, OutputSink& stdout_sink,
+                         OutputSink& stderr_sink);
+
 }  // namespace procly::internal
@@ -1,10 +1,14 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
+#include <filesystem>
 #include <optional>
 
 #include "procly/command.hpp"
+#include "procly/environment.hpp"
 #include "procly/internal/backend.hpp"
+#include "procly/internal/env_block.hpp"
 #include "procly/pipeline.hpp"
 #include "procly/result.hpp"
 
@@ -12,6 +16,8 @@ namespace procly::internal {
 
 enum class SpawnMode : std::uint8_t { spawn, output };
 
+enum class StdioTarget : std::uint8_t { stdin, stdout, stderr };
+
 struct StdioOverride {
   std::optional<Stdio> stdin_override;
   std::optional<Stdio> stdout_override;
@@ -30,27 +36,46 @@ struct PipelineSpec {
   std::vector<PipelineStageSpec> stages;
   bool pipefail = false;
   bool new_process_group = false;
+  // Capacity for inter-stage pipes and the default for piped ends; 0 keeps the system default.
+  std::size_t pipe_capacity = 0;
+#if PROCLY_PLATFORM_LINUX
+  // cgroup for stages that do not set their own.
+  std::optional<std::filesystem::path> cgroup;
+#endif
 };
 
 struct CommandAccess {
-  static const std::vector<std::string>& argv(const Command& cmd) { return cmd.argv_; }
+  static const CommandStorage& storage(const Command& cmd) { return cmd.strings_; }
   static const std::optional<std::filesystem::path>& cwd(const Command& cmd) { return cmd.cwd_; }
+  static std::optional<int> cwd_fd(const Command& cmd) { return cmd.cwd_fd_; }
   static bool inherit_env(const Command& cmd) { return cmd.inherit_env_; }
-  static const std::map<std::string, std::optional<std::string>, std::less<>>& env_delta(
-      const Command& cmd) {
-    return cmd.env_delta_;
-  }
+  static const std::optional<Environment>& env_base(const Command& cmd) { return cmd.env_base_; }
+  static EnvBlockCache& env_cache(const Command& cmd) { return cmd.env_cache_; }
   static const std::optional<Stdio>& stdin_opt(const Command& cmd) { return cmd.stdin_; }
   static const std::optional<Stdio>& stdout_opt(const Command& cmd) { return cmd.stdout_; }
   static const std::optional<Stdio>& stderr_opt(const Command& cmd) { return cmd.stderr_; }
   static const SpawnOptions& options(const Command& cmd) { return cmd.opts_; }
+  static Backend* backend(const Command& cmd) { return cmd.backend_; }
+};
+
+struct EnvironmentAccess {
+  static const EnvBlock& block(const Environment& env) { return env.block_; }
 };
 
 struct ChildAccess;
 struct PipelineAccess;
 
+// live_env, when given, memoizes the unmodified live environment across several lowerings
+// (pipeline stages), so stages that inherit it share one block and one environ scan.
+EnvBlock lower_environment(const Command& cmd, std::optional<EnvBlock>* live_env = nullptr);
+
+// Lower one stream's setting, validated for target; an unset value is piped or inherited.
+Result<StdioSpec> resolve_stdio(const std::optional<Stdio>& value, bool piped_default,
+                                StdioTarget target);
+
 Result<SpawnSpec> lower_command(const Command& cmd, SpawnMode mode,
-                                const StdioOverride* override_stdio);
+                                const StdioOverride* override_stdio,
+                                std::optional<EnvBlock>* live_env = nullptr);
 Result<PipelineSpec> lower_pipeline(const Pipeline& pipeline, SpawnMode mode);
 
 }  // namespace procly::internal
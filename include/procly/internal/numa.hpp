@@ -0,0 +1,25 @@
+#pragma once
+
+#include "procly/platform.hpp"
+
+#if PROCLY_PLATFORM_LINUX
+
+#include <string_view>
+#include <vector>
+
+#include "procly/result.hpp"
+
+namespace procly::internal {
+
+// Parse a kernel id list such as "0-3,8\n" (sysfs cpulist, node/online) into ascending ids.
+Result<std::vector<int>> parse_id_list(std::string_view list);
+
+// Online NUMA node ids from /sys/devices/system/node/online; {0} when the kernel has no NUMA.
+Result<std::vector<int>> online_numa_nodes();
+
+// CPUs of one node from /sys/devices/system/node/node<N>/cpulist.
+Result<std::vector<int>> numa_node_cpus(int node);
+
+}  // namespace procly::internal
+
+#endif
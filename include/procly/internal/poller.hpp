@@ -0,0 +1,41 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "procly/internal/fd.hpp"
+#include "procly/platform.hpp"
+#include "procly/result.hpp"
+
+#if !PROCLY_PLATFORM_LINUX && !PROCLY_PLATFORM_MACOS
+#include <poll.h>
+#endif
+
+namespace procly::internal {
+
+// Level-triggered readiness multiplexer: epoll on Linux, kqueue on macOS, poll() elsewhere.
+// Hang-up and error conditions are reported as ready; callers attempt the I/O to find out.
+class Poller {
+ public:
+  enum class Interest : std::uint8_t { readable, writable };
+
+  static Result<Poller> create();
+
+  Result<void> add(int fd, Interest interest);
+  Result<void> remove(int fd, Interest interest);
+  // Wait up to `timeout` (forever when empty) and append ready descriptors to `ready`.
+  Result<void> wait(std::optional<std::chrono::milliseconds> timeout, std::vector<int>* ready);
+
+ private:
+  Poller() = default;
+
+#if PROCLY_PLATFORM_LINUX || PROCLY_PLATFORM_MACOS
+  unique_fd fd_;
+#else
+  std::vector<pollfd> fds_;
+#endif
+};
+
+}  // namespace procly::internal
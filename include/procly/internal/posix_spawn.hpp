@@ -1,14 +1,30 @@
 #pragma once
 
-#include <cstdint>
+#include <spawn.h>
 
 #include "procly/internal/backend.hpp"
+#include "procly/observer.hpp"
+#include "procly/platform.hpp"
+
+// posix_spawn_file_actions_addchdir_np / addfchdir_np: macOS 10.15+, glibc 2.29+.
+#if PROCLY_PLATFORM_MACOS || \
+    (defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 29)))
+#define PROCLY_HAS_SPAWN_CHDIR 1
+#else
+#define PROCLY_HAS_SPAWN_CHDIR 0
+#endif
 
 namespace procly::internal {
 
-enum class SpawnStrategy : std::uint8_t { fork_exec, posix_spawn };
+using procly::SpawnFallbackReason;
+using procly::SpawnStrategy;
 
+// First spec feature posix_spawn cannot express, or none.
+SpawnFallbackReason posix_spawn_blocker(const SpawnSpec& spec);
 bool can_use_posix_spawn(const SpawnSpec& spec);
-SpawnStrategy select_spawn_strategy(const SpawnSpec& spec);
+bool can_use_vfork();
+SpawnStrategy fork_fallback_strategy(const SpawnSpec& spec);
+// reason, when given, receives why posix_spawn was not chosen.
+SpawnStrategy select_spawn_strategy(const SpawnSpec& spec, SpawnFallbackReason* reason = nullptr);
 
 }  // namespace procly::internal
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <sys/resource.h>
+#include <sys/types.h>
+
+#include <chrono>
+#include <optional>
+
+#include "procly/internal/fd.hpp"
+#include "procly/result.hpp"
+#include "procly/status.hpp"
+
+namespace procly::internal {
+
+// Reaping primitives shared by the native backend and the Reaper.
+
+ExitStatus to_exit_status(int status);
+
+ResourceUsage to_resource_usage(const struct rusage& usage,
+                                std::optional<std::chrono::steady_clock::time_point> started);
+
+// wait4 reaps like waitpid and reports the child's rusage in the same call.
+Result<ExitStatus> wait_pid_blocking(pid_t pid, struct rusage* usage);
+Result<std::optional<ExitStatus>> try_wait_pid(pid_t pid, struct rusage* usage);
+
+// Descriptor that polls readable once `pid` exits, without reaping it: a pidfd on Linux 5.3+, a
+// kqueue holding an EVFILT_PROC/NOTE_EXIT registration on macOS.
+Result<unique_fd> open_exit_fd(pid_t pid);
+
+bool is_esrch(const Error& error);
+
+}  // namespace procly::internal
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "procly/internal/fd.hpp"
+#include "procly/result.hpp"
+#include "procly/status.hpp"
+
+namespace procly::internal {
+
+// Open /proc/<pid>/stat once; read_proc_stat() re-reads it with pread, so each sample costs one
+// syscall. Reads fail with ESRCH once the process has been reaped, even if the pid is reused.
+// Linux only; elsewhere fails with std::errc::not_supported.
+Result<unique_fd> open_proc_stat(int pid);
+
+// Decode CPU times, resident set size and thread count from an open /proc/<pid>/stat.
+Result<ResourceSample> read_proc_stat(int fd);
+
+}  // namespace procly::internal
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <sys/types.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "procly/child.hpp"
+#include "procly/internal/fd.hpp"
+#include "procly/internal/poller.hpp"
+#include "procly/result.hpp"
+
+namespace procly::internal {
+
+// Exit collection for native-backend children while a procly::Reaper runs. Every reap of an
+// adopted pid happens under the core's lock, whether the background thread or a waiting handle
+// performs it, so reaps never race and signals never reach a recycled pid.
+class ReaperCore {
+ public:
+  ReaperCore(Poller poller, unique_fd wake_read, unique_fd wake_write);
+  ~ReaperCore();
+  ReaperCore(const ReaperCore&) = delete;
+  ReaperCore& operator=(const ReaperCore&) = delete;
+
+  // Start and stop the background thread. After stop() adopted pids can still be reaped
+  // synchronously through try_wait(), but nothing waits for them in the background.
+  void start();
+  void stop();
+  [[nodiscard]] bool stopped() const;
+
+  // Take over exit collection for a freshly spawned pid.
+  void adopt(pid_t pid, std::optional<std::chrono::steady_clock::time_point> started);
+  [[nodiscard]] bool owns(pid_t pid) const;
+  // Reap pid if it has exited. A returned result is handed over: the pid is forgotten.
+  Result<std::optional<WaitResult>> try_wait(pid_t pid);
+  // Block until pid has been reaped (not collected) or the deadline passes.
+  void wait_exit(pid_t pid, std::optional<std::chrono::steady_clock::time_point> deadline);
+  // Send signo to target on behalf of pid; false when pid was already reaped.
+  Result<bool> signal(pid_t pid, int target, int signo);
+  // The handle for pid is gone: reap it in the background and discard the result.
+  void abandon(pid_t pid);
+  // Adopted pids not yet reaped and collected.
+  [[nodiscard]] std::size_t tracked() const;
+
+ private:
+  struct Entry {
+    std::optional<std::chrono::steady_clock::time_point> started;
+    std::optional<WaitResult> result;
+    std::optional<Error> error;
+    bool abandoned = false;
+    std::condition_variable exited;
+  };
+
+  void run();
+  void wake();
+  // Reap pid if it exited; caller holds mutex_. Returns true once the entry is settled.
+  bool reap_locked(pid_t pid, Entry& entry);
+  // Settle pid after its exit descriptor fired or a sweep came by; true when it is done.
+  bool collect(pid_t pid);
+
+  mutable std::mutex mutex_;
+  std::unordered_map<pid_t, std::unique_ptr<Entry>> entries_;
+  // Adopted pids with their exit descriptor (invalid when the kernel has none) awaiting
+  // registration by the background thread.
+  std::vector<std::pair<pid_t, unique_fd>> pending_;
+  bool stopping_ = false;
+
+  // Owned by the background thread.
+  Poller poller_;
+  unique_fd wake_read_;
+  unique_fd wake_write_;
+  std::unordered_map<int, std::pair<pid_t, unique_fd>> watched_;
+  std::vector<pid_t> swept_;
+  std::thread thread_;
+};
+
+// Core of the running Reaper, or null.
+std::shared_ptr<ReaperCore> active_reaper();
+
+}  // namespace procly::internal
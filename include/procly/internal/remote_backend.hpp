@@ -0,0 +1,218 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "procly/backend.hpp"
+#include "procly/internal/backend.hpp"
+#include "procly/internal/clock.hpp"
+#include "procly/internal/fd.hpp"
+#include "procly/internal/wait_policy.hpp"
+#include "procly/result.hpp"
+
+namespace procly::internal {
+
+// Client bookkeeping for a backend whose children are forked by a helper process at the other
+// end of a socket (ForkServer, Zygote). Requests are matched to Reply frames by id, and exit
+// notices are held until wait()/try_wait() collects them. The subclass encodes requests and
+// runs the reader thread, which feeds deliver_reply(), deliver_exit() and disconnect().
+//
+// Exits are keyed by pid. The exit notice of an abandoned child is dropped on arrival, and a
+// spawn reply that hands out a pid clears whatever an earlier child with that pid left behind,
+// so a reused pid never reports a stale status.
+template <typename Reply>
+class RemoteBackend : public Backend {
+ public:
+  RemoteBackend(const RemoteBackend&) = delete;
+  RemoteBackend& operator=(const RemoteBackend&) = delete;
+
+  Result<WaitResult> wait(Spawned& spawned, std::optional<std::chrono::milliseconds> timeout,
+                          std::chrono::milliseconds kill_grace) override {
+    if (spawned.terminal_result) {
+      return *spawned.terminal_result;
+    }
+    if (spawned.pid <= 0) {
+      return Error{.code = make_error_code(errc::wait_failed), .context = "waitpid"};
+    }
+    const int pid = spawned.pid;
+    WaitOps ops;
+    ops.try_wait = [&]() { return try_wait(spawned); };
+    ops.wait_blocking = [this, pid]() { return wait_exit_status(pid); };
+    ops.terminate = [&]() { return terminate(spawned); };
+    ops.kill = [&]() { return kill(spawned); };
+    ops.wait_exit = [this, pid](std::chrono::milliseconds budget) -> Result<void> {
+      std::unique_lock lock(mutex_);
+      cv_.wait_for(lock, budget, [&] { return exited_.count(pid) != 0 || disconnected_; });
+      return {};
+    };
+    auto result = wait_with_timeout(ops, default_clock(), timeout, kill_grace);
+    if (!result) {
+      return result.error();
+    }
+    cache_terminal_result(spawned, result.value());
+    return result.value();
+  }
+
+  Result<std::optional<ExitStatus>> try_wait(Spawned& spawned) override {
+    if (spawned.terminal_result) {
+      return std::optional<ExitStatus>(spawned.terminal_result->status);
+    }
+    if (spawned.pid <= 0) {
+      return Error{.code = make_error_code(errc::wait_failed), .context = "waitpid"};
+    }
+    std::optional<ExitStatus> status;
+    {
+      std::lock_guard lock(mutex_);
+      auto it = exited_.find(spawned.pid);
+      if (it != exited_.end()) {
+        status = it->second;
+        exited_.erase(it);
+      } else if (disconnected_) {
+        return disconnected_error(errc::wait_failed);
+      }
+    }
+    if (status) {
+      cache_terminal_result(spawned, WaitResult{.status = *status});
+    }
+    return status;
+  }
+
+  Result<void> terminate(Spawned& spawned) override { return signal(spawned, SIGTERM); }
+
+  Result<void> kill(Spawned& spawned) override { return signal(spawned, SIGKILL); }
+
+  // Nobody will collect the exit: drop it now if it already arrived, otherwise on arrival.
+  void abandon(Spawned& spawned) override {
+    if (spawned.pid <= 0) {
+      return;
+    }
+    std::lock_guard lock(mutex_);
+    if (exited_.erase(spawned.pid) == 0 && !disconnected_) {
+      abandoned_.insert(spawned.pid);
+    }
+  }
+
+  // A pipe whose write end is closed when the exit notice arrives.
+  Result<int> open_exit_handle(const Spawned& spawned) override {
+    if (spawned.pid <= 0 && !spawned.terminal_result) {
+      return Error{.code = make_error_code(errc::wait_failed), .context = "open_exit_handle"};
+    }
+    auto pipe = create_pipe();
+    if (!pipe) {
+      return pipe.error();
+    }
+    std::lock_guard lock(mutex_);
+    bool exited = spawned.terminal_result || disconnected_ || exited_.count(spawned.pid) != 0;
+    if (!exited) {
+      exit_notifiers_[spawned.pid].push_back(std::move(pipe->second));
+    }
+    return pipe->first.release();
+  }
+
+ protected:
+  // disconnected_context names the peer in errors once the socket is gone.
+  explicit RemoteBackend(const char* disconnected_context)
+      : disconnected_context_(disconnected_context) {}
+  ~RemoteBackend() override = default;
+
+  Error disconnected_error(errc code) const {
+    return Error{.code = make_error_code(code), .context = disconnected_context_};
+  }
+
+  // Send a request through send(id), under the write lock, and block for its reply.
+  Result<Reply> request(const std::function<Result<void>(std::uint64_t id)>& send) {
+    std::uint64_t id = 0;
+    {
+      std::lock_guard lock(mutex_);
+      if (disconnected_) {
+        return disconnected_error(errc::spawn_failed);
+      }
+      id = next_id_++;
+    }
+    {
+      std::lock_guard lock(write_mutex_);
+      auto sent = send(id);
+      if (!sent) {
+        return sent.error();
+      }
+    }
+    std::unique_lock lock(mutex_);
+    cv_.wait(lock, [&] { return replies_.count(id) != 0 || disconnected_; });
+    auto it = replies_.find(id);
+    if (it == replies_.end()) {
+      return disconnected_error(errc::spawn_failed);
+    }
+    Reply reply = std::move(it->second);
+    replies_.erase(it);
+    return reply;
+  }
+
+  // Reader thread: reply to request id; spawned_pid is the pid a spawn reply hands out.
+  void deliver_reply(std::uint64_t id, Reply reply, std::optional<int> spawned_pid) {
+    std::lock_guard lock(mutex_);
+    if (spawned_pid) {
+      exited_.erase(*spawned_pid);
+      abandoned_.erase(*spawned_pid);
+    }
+    replies_.insert_or_assign(id, std::move(reply));
+    cv_.notify_all();
+  }
+
+  // Reader thread: child pid exited.
+  void deliver_exit(int pid, ExitStatus status) {
+    std::lock_guard lock(mutex_);
+    exit_notifiers_.erase(pid);
+    if (abandoned_.erase(pid) == 0) {
+      exited_.insert_or_assign(pid, status);
+    }
+    cv_.notify_all();
+  }
+
+  // Reader thread: the socket closed; pending and future requests fail.
+  void disconnect() {
+    std::lock_guard lock(mutex_);
+    disconnected_ = true;
+    exit_notifiers_.clear();
+    abandoned_.clear();
+    cv_.notify_all();
+  }
+
+ private:
+  Result<ExitStatus> wait_exit_status(int pid) {
+    std::unique_lock lock(mutex_);
+    cv_.wait(lock, [&] { return exited_.count(pid) != 0 || disconnected_; });
+    auto it = exited_.find(pid);
+    if (it == exited_.end()) {
+      return disconnected_error(errc::wait_failed);
+    }
+    ExitStatus status = it->second;
+    exited_.erase(it);
+    return status;
+  }
+
+  const char* disconnected_context_;
+  // Serializes frames on the socket; replies are matched by request id.
+  std::mutex write_mutex_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::uint64_t next_id_ = 1;
+  bool disconnected_ = false;
+  std::map<std::uint64_t, Reply> replies_;
+  // Exit statuses received but not yet collected by wait/try_wait.
+  std::unordered_map<int, ExitStatus> exited_;
+  // Children whose handles were dropped before their exit notice arrived.
+  std::unordered_set<int> abandoned_;
+  std::unordered_map<int, std::vector<unique_fd>> exit_notifiers_;
+};
+
+}  // namespace procly::internal
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+namespace procly::internal {
+
+// Vector of trivially copyable elements holding the first N inline; past N every element moves
+// to a heap vector. Copies and moves of an inline vector touch no heap memory.
+template <typename T, std::size_t N>
+class SmallVector {
+  static_assert(std::is_trivially_copyable_v<T>, "SmallVector copies elements bytewise");
+
+ public:
+  [[nodiscard]] std::size_t size() const noexcept { return size_; }
+  [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+  [[nodiscard]] T* data() noexcept { return on_heap_ ? heap_.data() : inline_.data(); }
+  [[nodiscard]] const T* data() const noexcept {
+    return on_heap_ ? heap_.data() : inline_.data();
+  }
+  [[nodiscard]] T& operator[](std::size_t index) noexcept { return data()[index]; }
+  [[nodiscard]] const T& operator[](std::size_t index) const noexcept { return data()[index]; }
+  [[nodiscard]] T* begin() noexcept { return data(); }
+  [[nodiscard]] T* end() noexcept { return data() + size_; }
+  [[nodiscard]] const T* begin() const noexcept { return data(); }
+  [[nodiscard]] const T* end() const noexcept { return data() + size_; }
+
+  void push_back(const T& value) { insert(size_, value); }
+
+  void insert(std::size_t index, const T& value) {
+    if (!on_heap_ && size_ == N) {
+      heap_.assign(inline_.begin(), inline_.end());
+      on_heap_ = true;
+    }
+    if (on_heap_) {
+      heap_.insert(heap_.begin() + static_cast<std::ptrdiff_t>(index), value);
+    } else {
+      std::copy_backward(inline_.begin() + index, inline_.begin() + size_,
+                         inline_.begin() + size_ + 1);
+      inline_[index] = value;
+    }
+    ++size_;
+  }
+
+  void clear() noexcept {
+    heap_.clear();
+    on_heap_ = false;
+    size_ = 0;
+  }
+
+ private:
+  std::array<T, N> inline_{};
+  std::vector<T> heap_;
+  std::size_t size_ = 0;
+  bool on_heap_ = false;
+};
+
+}  // namespace procly::internal
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <string>
+
+#include "procly/internal/fd.hpp"
+#include "procly/result.hpp"
+#include "procly/spill_buffer.hpp"
+
+namespace procly::internal {
+
+// Once spilled, bytes are batched into writes of about this size.
+inline constexpr std::size_t kSpillWriteBytes = 256 * 1024;
+
+// Builds a SpillBuffer from one drained stream: appends stay in memory up to memory_limit, then
+// everything moves to a temporary file. A failed spill is remembered, later bytes are dropped
+// so the pipe keeps draining, and finish() reports the error.
+class SpillWriter {
+ public:
+  SpillWriter(std::size_t memory_limit, const char* name);
+
+  void write(const char* data, std::size_t size);
+  Result<SpillBuffer> finish();
+
+ private:
+  void spill();
+  void flush();
+
+  std::size_t memory_limit_;
+  const char* name_;
+  // In memory before the spill, pending writes after it.
+  std::string buffer_;
+  unique_fd file_;
+  bool spilled_ = false;
+  std::optional<Error> error_;
+};
+
+}  // namespace procly::internal
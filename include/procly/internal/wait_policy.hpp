@@ -1,8 +1,10 @@
 #pragma once
 
 #include <chrono>
+#include <cstddef>
 #include <functional>
 #include <optional>
+#include <vector>
 
 #include "procly/child.hpp"
 #include "procly/internal/clock.hpp"
@@ -16,10 +18,47 @@ struct WaitOps {
   std::function<Result<ExitStatus>()> wait_blocking;
   std::function<Result<void>()> terminate;
   std::function<Result<void>()> kill;
+  // Block until the child may have exited or `budget` elapses, without reaping it. Spurious
+  // wakeups are fine; try_wait decides. When empty, waits poll try_wait every millisecond.
+  std::function<Result<void>(std::chrono::milliseconds budget)> wait_exit;
+  // True once the wait was cancelled; checked after every wakeup and escalated like a
+  // timeout. wait_exit must then also wake on cancellation. When empty, nothing cancels.
+  std::function<bool()> cancelled;
 };
 
 Result<WaitResult> wait_with_timeout(WaitOps& ops, Clock& clock,
                                      std::optional<std::chrono::milliseconds> timeout,
                                      std::chrono::milliseconds kill_grace);
 
+// Operations for waiting on several processes (pipeline stages) at once.
+struct StageWaitOps {
+  std::size_t stage_count = 0;
+  // Reap `stage` if it has exited. Never called again for a stage once it reports a status.
+  std::function<Result<std::optional<ExitStatus>>(std::size_t stage)> try_wait;
+  // Signal every stage still running.
+  std::function<Result<void>()> terminate;
+  std::function<Result<void>()> kill;
+  // Block until some stage may have exited or `budget` elapses (forever when empty), without
+  // reaping. When empty, waits poll try_wait every millisecond.
+  std::function<Result<void>(std::optional<std::chrono::milliseconds> budget)> wait_any_exit;
+  // As in WaitOps; wait_any_exit must also wake on cancellation.
+  std::function<bool()> cancelled;
+};
+
+struct StageWaitResult {
+  std::vector<ExitStatus> stages;
+  bool timed_out = false;
+  bool cancelled = false;
+  bool sent_terminate = false;
+  bool sent_kill = false;
+  // First stage seen to fail when fail_fast is set.
+  std::optional<std::size_t> failed_stage;
+};
+
+// Reap stages in exit order. A timeout, or with fail_fast the first unsuccessful stage,
+// terminates the remaining stages and kills them after kill_grace.
+Result<StageWaitResult> wait_stages(StageWaitOps& ops, Clock& clock,
+                                    std::optional<std::chrono::milliseconds> timeout,
+                                    std::chrono::milliseconds kill_grace, bool fail_fast);
+
 }  // namespace procly::internal
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+namespace procly::internal {
+
+// Flat binary encoding shared by the fork server protocol and replay recordings. Fields are
+// written in native byte order: both ends of a fork server run the same binary, and
+// recordings are replayed on the machine that made them.
+class Encoder {
+ public:
+  void put_u8(std::uint8_t value) { bytes_.push_back(static_cast<char>(value)); }
+  void put_bool(bool value) { put_u8(value ? 1 : 0); }
+  void put_i32(std::int32_t value) { append(&value, sizeof(value)); }
+  void put_u32(std::uint32_t value) { append(&value, sizeof(value)); }
+  void put_u64(std::uint64_t value) { append(&value, sizeof(value)); }
+  void put_string(std::string_view value) {
+    put_u64(value.size());
+    bytes_.append(value.data(), value.size());
+  }
+
+  [[nodiscard]] const std::string& bytes() const noexcept { return bytes_; }
+
+ private:
+  void append(const void* data, std::size_t size) {
+    bytes_.append(static_cast<const char*>(data), size);
+  }
+
+  std::string bytes_;
+};
+
+// Reads fields back; a short payload sets failed() and yields zero values.
+class Decoder {
+ public:
+  explicit Decoder(std::string_view bytes) : bytes_(bytes) {}
+
+  std::uint8_t u8() {
+    std::uint8_t value = 0;
+    take(&value, sizeof(value));
+    return value;
+  }
+  bool boolean() { return u8() != 0; }
+  std::int32_t i32() {
+    std::int32_t value = 0;
+    take(&value, sizeof(value));
+    return value;
+  }
+  std::uint32_t u32() {
+    std::uint32_t value = 0;
+    take(&value, sizeof(value));
+    return value;
+  }
+  std::uint64_t u64() {
+    std::uint64_t value = 0;
+    take(&value, sizeof(value));
+    return value;
+  }
+  std::string string() {
+    auto size = u64();
+    if (failed_ || size > bytes_.size()) {
+      failed_ = true;
+      return {};
+    }
+    std::string value(bytes_.substr(0, size));
+    bytes_.remove_prefix(size);
+    return value;
+  }
+
+  [[nodiscard]] bool failed() const noexcept { return failed_; }
+
+ private:
+  void take(void* out, std::size_t size) {
+    if (failed_ || size > bytes_.size()) {
+      failed_ = true;
+      return;
+    }
+    std::memcpy(out, bytes_.data(), size);
+    bytes_.remove_prefix(size);
+  }
+
+  std::string_view bytes_;
+  bool failed_ = false;
+};
+
+}  // namespace procly::internal
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+#include "procly/result.hpp"
+#include "procly/status.hpp"
+
+namespace procly {
+
+/// @brief Read-only memory mapping of captured output.
+///
+/// Pages are backed by the page cache (a memfd on Linux, an unlinked
+/// temporary file elsewhere), so the kernel can evict them under memory
+/// pressure. Move-only; unmapped on destruction.
+class MappedBuffer {
+ public:
+  /// @brief Construct an empty buffer.
+  MappedBuffer() = default;
+  /// @brief Map an open file read-only in its entirety.
+  ///
+  /// The descriptor is borrowed; the mapping stays valid after it is closed.
+  static Result<MappedBuffer> map(int fd);
+
+  /// @brief Move-construct a mapping.
+  MappedBuffer(MappedBuffer&& other) noexcept;
+  /// @brief Move-assign a mapping.
+  MappedBuffer& operator=(MappedBuffer&& other) noexcept;
+  MappedBuffer(const MappedBuffer&) = delete;
+  MappedBuffer& operator=(const MappedBuffer&) = delete;
+  /// @brief Unmap the buffer.
+  ~MappedBuffer();
+
+  /// @brief Start of the mapped bytes (null when empty).
+  [[nodiscard]] const char* data() const noexcept { return data_; }
+  /// @brief Number of mapped bytes.
+  [[nodiscard]] std::size_t size() const noexcept { return size_; }
+  /// @brief True when nothing is mapped.
+  [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+  /// @brief View of the mapped bytes.
+  [[nodiscard]] std::string_view view() const noexcept { return {data_, size_}; }
+
+ private:
+  MappedBuffer(const char* data, std::size_t size) noexcept : data_(data), size_(size) {}
+
+  /// @brief Mapped address.
+  const char* data_ = nullptr;
+  /// @brief Mapped length.
+  std::size_t size_ = 0;
+};
+
+/// @brief Output captured into memory-mapped files.
+struct MappedOutput {
+  /// @brief Exit status for the process.
+  ExitStatus status;
+  /// @brief Captured stdout.
+  MappedBuffer stdout_data;
+  /// @brief Captured stderr.
+  MappedBuffer stderr_data;
+};
+
+}  // namespace procly
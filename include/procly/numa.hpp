@@ -0,0 +1,38 @@
+#pragma once
+
+#include "procly/platform.hpp"
+
+#if PROCLY_PLATFORM_LINUX
+
+#include <cstddef>
+#include <vector>
+
+#include "procly/command.hpp"
+#include "procly/result.hpp"
+
+#if PROCLY_HAS_STD_SPAN
+#include <span>
+#endif
+
+namespace procly {
+
+/// @brief Online NUMA node ids in ascending order; {0} on kernels without NUMA support.
+[[nodiscard]] Result<std::vector<int>> numa_nodes();
+
+/// @brief Assign each command one online NUMA node, round-robin in order, with policy.
+///
+/// Command i gets node i % N through Command::numa_nodes(), so a batch handed
+/// to run_all() runs evenly spread over the machine with each child's memory
+/// and CPUs local to one node. Commands that already name nodes are
+/// overwritten.
+[[nodiscard]] Result<void> spread_across_numa_nodes(Command* commands, std::size_t count,
+                                                    NumaPolicy policy = NumaPolicy::bind);
+#if PROCLY_HAS_STD_SPAN
+/// @brief Span overload of spread_across_numa_nodes().
+[[nodiscard]] Result<void> spread_across_numa_nodes(std::span<Command> commands,
+                                                    NumaPolicy policy = NumaPolicy::bind);
+#endif
+
+}  // namespace procly
+
+#endif
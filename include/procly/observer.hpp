@@ -0,0 +1,145 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <system_error>
+
+namespace procly {
+
+/// @brief How the native backend created a process.
+enum class SpawnStrategy : std::uint8_t {
+  /// @brief fork() (or clone3 for cgroup placement) followed by exec.
+  fork_exec,
+  /// @brief posix_spawn()/posix_spawnp().
+  posix_spawn,
+  /// @brief clone(CLONE_VM | CLONE_VFORK) followed by exec.
+  vfork_exec,
+};
+
+/// @brief Why the native backend did not use posix_spawn.
+enum class SpawnFallbackReason : std::uint8_t {
+  /// @brief posix_spawn was used.
+  none,
+  /// @brief A PROCLY_FORCE_* build flag selected the strategy.
+  forced,
+  /// @brief The platform has no posix_spawn chdir file action.
+  working_directory,
+  /// @brief The platform has no POSIX_SPAWN_SETPGROUP.
+  process_group,
+  /// @brief SpawnOptions::limits is set.
+  resource_limits,
+  /// @brief SpawnOptions::nice is set.
+  nice,
+  /// @brief SpawnOptions::scheduling_policy is batch or idle.
+  scheduling_policy,
+  /// @brief SpawnOptions::io_priority is set.
+  io_priority,
+  /// @brief SpawnOptions::cgroup is set.
+  cgroup,
+  /// @brief SpawnOptions::numa_nodes is set.
+  numa,
+  /// @brief The executable is pinned by descriptor (PreparedCommand::pin_executable()).
+  executable_fd,
+  /// @brief SpawnOptions::cpu_affinity is set.
+  cpu_affinity,
+};
+
+/// @brief A Command or pipeline stage was lowered into a spawn request.
+struct LoweringEvent {
+  /// @brief argv[0]; valid only during the callback.
+  std::string_view program;
+  /// @brief When lowering started.
+  std::chrono::steady_clock::time_point start;
+  /// @brief When lowering finished.
+  std::chrono::steady_clock::time_point end;
+};
+
+/// @brief The native backend finished a spawn attempt.
+struct SpawnEvent {
+  /// @brief argv[0]; valid only during the callback.
+  std::string_view program;
+  /// @brief Strategy used.
+  SpawnStrategy strategy = SpawnStrategy::posix_spawn;
+  /// @brief Why posix_spawn was not used.
+  SpawnFallbackReason fallback_reason = SpawnFallbackReason::none;
+  /// @brief When the backend started (PATH lookup and descriptor setup included).
+  std::chrono::steady_clock::time_point start;
+  /// @brief When the child was running, or the failure was known (exec errors included).
+  std::chrono::steady_clock::time_point end;
+  /// @brief Process id, or -1 on failure.
+  int pid = -1;
+  /// @brief Failure, if any.
+  std::error_code error;
+};
+
+/// @brief A capture or streaming drain loop finished.
+struct DrainEvent {
+  /// @brief Bytes read from stdout.
+  std::size_t stdout_bytes = 0;
+  /// @brief Bytes read from stderr.
+  std::size_t stderr_bytes = 0;
+  /// @brief Bytes written to stdin from the same loop.
+  std::size_t stdin_bytes = 0;
+  /// @brief When draining started.
+  std::chrono::steady_clock::time_point start;
+  /// @brief When every stream reached EOF.
+  std::chrono::steady_clock::time_point end;
+};
+
+/// @brief The native backend finished waiting for a process.
+struct WaitEvent {
+  /// @brief Process id.
+  int pid = -1;
+  /// @brief When waiting started.
+  std::chrono::steady_clock::time_point start;
+  /// @brief When the process was reaped or waiting failed.
+  std::chrono::steady_clock::time_point end;
+  /// @brief True when the timeout elapsed.
+  bool timed_out = false;
+  /// @brief True when SIGTERM was sent.
+  bool sent_terminate = false;
+  /// @brief True when SIGKILL was sent.
+  bool sent_kill = false;
+};
+
+/// @brief The native backend sent a signal (terminate, kill or timeout escalation).
+struct SignalEvent {
+  /// @brief Process id, or the negated process group id when the group was signalled.
+  int target = 0;
+  /// @brief Signal number.
+  int signo = 0;
+  /// @brief When the signal was sent.
+  std::chrono::steady_clock::time_point time;
+};
+
+/// @brief Receives instrumentation events from procly.
+///
+/// Callbacks run synchronously on whichever thread did the work, possibly
+/// several at once, so implementations must be thread-safe and cheap. Every
+/// method defaults to doing nothing.
+class Observer {
+ public:
+  virtual ~Observer() = default;
+  /// @brief Called after lowering a Command.
+  virtual void on_lowered(const LoweringEvent& event) { (void)event; }
+  /// @brief Called after each native spawn attempt.
+  virtual void on_spawn(const SpawnEvent& event) { (void)event; }
+  /// @brief Called when a drain loop finishes.
+  virtual void on_drain(const DrainEvent& event) { (void)event; }
+  /// @brief Called when a native wait finishes.
+  virtual void on_wait(const WaitEvent& event) { (void)event; }
+  /// @brief Called after the native backend signals a process.
+  virtual void on_signal(const SignalEvent& event) { (void)event; }
+};
+
+/// @brief Install observer process-wide; null disables instrumentation.
+///
+/// The observer is borrowed and must outlive every operation started while it
+/// is installed. With no observer, each hook costs one atomic load.
+void set_observer(Observer* observer) noexcept;
+/// @brief Currently installed observer, or null.
+[[nodiscard]] Observer* observer() noexcept;
+
+}  // namespace procly
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "procly/compressed_buffer.hpp"
+#include "procly/digest.hpp"
+#include "procly/platform.hpp"
+#include "procly/result.hpp"
+
+#if PROCLY_HAS_STD_SPAN
+#include <span>
+#endif
+
+namespace procly {
+
+/// @brief Destination for streamed child output.
+///
+/// Sinks run on the drain loop as data arrives, so nothing is buffered
+/// beyond the current chunk (or the current partial line). A
+/// default-constructed sink discards its input.
+class OutputSink {
+ public:
+  /// @brief Callback receiving a chunk as pointer and size.
+  using ChunkCallback = std::function<void(const std::byte* data, std::size_t size)>;
+#if PROCLY_HAS_STD_SPAN
+  /// @brief Callback receiving a chunk as a span.
+  using SpanCallback = std::function<void(std::span<const std::byte>)>;
+#endif
+  /// @brief Callback receiving one line without its delimiter.
+  using LineCallback = std::function<void(std::string_view line)>;
+
+  /// @brief Construct a sink that discards its input.
+  OutputSink() = default;
+
+  /// @brief Deliver each chunk as read from the pipe.
+  static OutputSink chunks(ChunkCallback on_chunk);
+#if PROCLY_HAS_STD_SPAN
+  /// @brief Deliver each chunk as read from the pipe.
+  static OutputSink chunks(SpanCallback on_chunk);
+#endif
+  /// @brief Split output on delimiter and deliver one line at a time.
+  ///
+  /// A trailing line without a delimiter is delivered at end of stream.
+  static OutputSink lines(LineCallback on_line, std::string delimiter = "\n");
+  /// @brief Append every chunk to a caller-owned string, which must outlive the sink.
+  static OutputSink capture(std::string& out);
+#if PROCLY_PLATFORM_POSIX
+  /// @brief Write every chunk to the file at path, appending or truncating it first.
+  ///
+  /// The file is created (mode 0644) if needed and closed when the last copy
+  /// of the sink is destroyed. Writing stops at the first failed write.
+  static Result<OutputSink> file(const std::filesystem::path& path, bool append = true);
+#endif
+  /// @brief Feed every chunk to each of sinks in order, and finish them together.
+  ///
+  /// All sinks see the drain loop's read buffer directly; only sinks that keep
+  /// data (capture, partial lines) copy it. Copies of a tee share its sinks.
+  static OutputSink tee(std::vector<OutputSink> sinks);
+  /// @brief Hash every chunk as it is read and store the hex digest in out at end of stream.
+  ///
+  /// Keeps no data, so tee it with file() or a discarding sink to checksum
+  /// output that is never held in memory. out must outlive the sink.
+  static OutputSink digest(DigestAlgorithm algorithm, std::string& out);
+  /// @brief Compress every chunk as it is read and store the frame in out at end of stream.
+  ///
+  /// level 0 is the codec's default. Fails with errc::invalid_argument when
+  /// procly was built without codec. If the codec fails mid-stream the rest is
+  /// dropped, finish() returns the codec's error and out is left untouched.
+  /// out must outlive the sink.
+  static Result<OutputSink> compress(Compression codec, CompressedBuffer& out, int level = 0);
+
+  /// @brief Feed bytes to the sink.
+  void write(const char* data, std::size_t size);
+  /// @brief Signal end of stream, flushing any partial line.
+  ///
+  /// Fails when a sink could not complete its output (a compress() codec
+  /// error); a tee finishes every sink and returns the first error.
+  Result<void> finish();
+
+ private:
+  /// @brief Chunk consumer (empty for discard and line sinks).
+  ChunkCallback on_chunk_;
+  /// @brief Line consumer (empty unless created with lines()).
+  LineCallback on_line_;
+  /// @brief Runs at end of stream (tee: finishes the fanned-out sinks).
+  std::function<Result<void>()> on_finish_;
+  /// @brief Line delimiter.
+  std::string delimiter_;
+  /// @brief Bytes of the current line not yet delimited.
+  std::string partial_;
+};
+
+}  // namespace procly
@@ -1,9 +1,11 @@
 #pragma once
 
 #include <cstddef>
+#include <optional>
 #include <string>
 #include <string_view>
 
+#include "procly/async.hpp"
 #include "procly/internal/concurrent_use_guard.hpp"
 #include "procly/platform.hpp"
 #include "procly/result.hpp"
@@ -14,6 +16,9 @@
 
 namespace procly {
 
+class Reactor;
+class PipeWriter;
+
 /// @brief Read end of a pipe owned by procly.
 ///
 /// PipeReader handles are not safe for concurrent shared use from multiple
@@ -47,10 +52,48 @@ class PipeReader {
 #if PROCLY_HAS_STD_SPAN
   /// @brief Read up to buffer.size() bytes.
   [[nodiscard]] Result<std::size_t> read_some(std::span<std::byte> buffer) const;
+  /// @brief Scatter one readv() across buffers in order; returns the total byte count.
+  [[nodiscard]] Result<std::size_t> read_some(
+      std::span<const std::span<std::byte>> buffers) const;
 #endif
   /// @brief Read up to n bytes into data.
   [[nodiscard]] Result<std::size_t> read_some(void* data, std::size_t n) const;
 
+  /// @brief Switch the descriptor to O_NONBLOCK for use from an external event loop.
+  ///
+  /// Use try_read_some() afterwards; the blocking calls then fail with EAGAIN
+  /// instead of waiting.
+  [[nodiscard]] Result<void> set_nonblocking() const;
+#if PROCLY_HAS_STD_SPAN
+  /// @brief Non-blocking read_some(); empty when the pipe has no data yet, 0 at EOF.
+  [[nodiscard]] Result<std::optional<std::size_t>> try_read_some(
+      std::span<std::byte> buffer) const;
+#endif
+  /// @brief Non-blocking read_some(); empty when the pipe has no data yet, 0 at EOF.
+  [[nodiscard]] Result<std::optional<std::size_t>> try_read_some(void* data,
+                                                                 std::size_t n) const;
+
+  /// @brief Move everything up to EOF into fd and return the byte count.
+  ///
+  /// Uses splice() on Linux so the bytes never enter user space, and falls
+  /// back to a read/write loop elsewhere or when fd cannot be spliced to.
+  /// The descriptor is borrowed.
+  [[nodiscard]] Result<std::size_t> transfer_to(int fd) const;
+  /// @brief Like transfer_to(fd), also duplicating every byte into tee first.
+  ///
+  /// On Linux tee() copies into the tee pipe without passing through user space.
+  [[nodiscard]] Result<std::size_t> transfer_to(int fd, const PipeWriter& tee) const;
+#if PROCLY_HAS_STD_SPAN
+  /// @brief Read up to buffer.size() bytes once the pipe polls readable on reactor.
+  [[nodiscard]] Async<std::size_t> read_some_async(Reactor& reactor,
+                                                   std::span<std::byte> buffer) const;
+#endif
+  /// @brief Read up to n bytes into data once the pipe polls readable on reactor.
+  ///
+  /// The reader and buffer must outlive the operation.
+  [[nodiscard]] Async<std::size_t> read_some_async(Reactor& reactor, void* data,
+                                                   std::size_t n) const;
+
  private:
   /// @brief Native file descriptor, or -1 if empty.
   int fd_{-1};
@@ -89,12 +132,36 @@ class PipeWriter {
   /// @brief Write all data to the pipe.
   [[nodiscard]] Result<void> write_all(std::string_view data) const;
 #if PROCLY_HAS_STD_SPAN
+  /// @brief Gather every buffer in order with writev(), resuming after partial writes.
+  ///
+  /// Writes a header and payload in one syscall without concatenating them.
+  [[nodiscard]] Result<void> write_all(std::span<const std::span<const std::byte>> buffers) const;
   /// @brief Write up to buffer.size() bytes.
   [[nodiscard]] Result<std::size_t> write_some(std::span<const std::byte> buffer) const;
 #endif
   /// @brief Write up to n bytes from data.
   [[nodiscard]] Result<std::size_t> write_some(const void* data, std::size_t n) const;
 
+  /// @brief Switch the descriptor to O_NONBLOCK for use from an external event loop.
+  ///
+  /// Use try_write_some() afterwards; the blocking calls then fail with EAGAIN
+  /// instead of waiting.
+  [[nodiscard]] Result<void> set_nonblocking() const;
+#if PROCLY_HAS_STD_SPAN
+  /// @brief Non-blocking write_some(); empty when the pipe is full.
+  [[nodiscard]] Result<std::optional<std::size_t>> try_write_some(
+      std::span<const std::byte> buffer) const;
+#endif
+  /// @brief Non-blocking write_some(); empty when the pipe is full.
+  [[nodiscard]] Result<std::optional<std::size_t>> try_write_some(const void* data,
+                                                                  std::size_t n) const;
+
+  /// @brief Move everything up to EOF from fd (for example a file) into the pipe.
+  ///
+  /// Uses splice() on Linux and a read/write loop elsewhere. The descriptor is
+  /// borrowed. Returns the byte count.
+  [[nodiscard]] Result<std::size_t> transfer_from(int fd) const;
+
  private:
   /// @brief Native file descriptor, or -1 if empty.
   int fd_{-1};
@@ -1,9 +1,18 @@
 #pragma once
 
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
 #include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 
+#include "procly/cancellation.hpp"
+#include "procly/child.hpp"
 #include "procly/command.hpp"
+#include "procly/function_stage.hpp"
 #include "procly/internal/concurrent_use_guard.hpp"
 #include "procly/pipe.hpp"
 #include "procly/result.hpp"
@@ -18,15 +27,72 @@ struct PipelineAccess;
 
 /// @brief Aggregate pipeline status.
 struct PipelineStatus {
-  /// @brief Exit status for each stage, in order.
+  /// @brief Exit status for each process stage, in order.
   std::vector<ExitStatus> stages;
+  /// @brief Resources used by each stage, parallel to stages; empty entries
+  /// mean the stage's backend does not report them.
+  std::vector<std::optional<ResourceUsage>> stage_usage;
+  /// @brief Outcome of each function stage, in order.
+  std::vector<FunctionStageStatus> function_stages;
+  /// @brief Captured stderr of each process stage, parallel to stages.
+  ///
+  /// Filled only by Pipeline::output_stages(); a stage with its own stderr
+  /// setting keeps it and has an empty entry here.
+  std::vector<std::string> stage_stderr;
   /// @brief Aggregate status using pipeline pipefail policy.
   ///
   /// When pipefail is enabled, this is the last non-success stage, matching
-  /// shell pipefail semantics.
+  /// shell pipefail semantics. A failed function stage counts as exit code 1.
   ExitStatus aggregate;
 };
 
+/// @brief Captured output together with per-stage status.
+///
+/// Returned by Pipeline::output_stages() and the deadline overload of
+/// Pipeline::output().
+struct PipelineOutput {
+  /// @brief Last-stage output, as returned by Pipeline::output().
+  Output output;
+  /// @brief Per-stage status; stage_stderr is filled only by output_stages().
+  PipelineStatus status;
+  /// @brief True when the deadline elapsed before every stage finished.
+  bool timed_out = false;
+  /// @brief True when the cancellation token fired before every stage finished.
+  bool cancelled = false;
+  /// @brief True when SIGTERM (or equivalent) was sent.
+  bool sent_terminate = false;
+  /// @brief True when SIGKILL (or equivalent) was sent.
+  bool sent_kill = false;
+};
+
+/// @brief Timeout and failure policy for PipelineChild::wait.
+struct PipelineWaitOptions {
+  /// @brief Optional timeout for the whole pipeline.
+  std::optional<std::chrono::milliseconds> timeout;
+  /// @brief Grace period after terminate before kill.
+  std::chrono::milliseconds kill_grace{WaitOptions::kDefaultKillGrace};
+  /// @brief Terminate the remaining stages as soon as any stage fails.
+  bool fail_fast = false;
+  /// @brief Optional token that cuts the wait short like an expired timeout.
+  std::optional<CancellationToken> cancel;
+};
+
+/// @brief Result of waiting on a pipeline with timeout and failure policy.
+struct PipelineWaitResult {
+  /// @brief Per-stage and aggregate status.
+  PipelineStatus status;
+  /// @brief True when the timeout budget elapsed before completion.
+  bool timed_out = false;
+  /// @brief True when the cancellation token fired before completion.
+  bool cancelled = false;
+  /// @brief True when SIGTERM (or equivalent) was sent.
+  bool sent_terminate = false;
+  /// @brief True when SIGKILL (or equivalent) was sent.
+  bool sent_kill = false;
+  /// @brief Stage whose failure triggered fail-fast termination, if any.
+  std::optional<std::size_t> failed_stage;
+};
+
 /// @brief Running pipeline handle (forward declaration).
 class PipelineChild;
 
@@ -45,6 +111,19 @@ class Pipeline {
   Pipeline& pipefail(bool enabled = true);
   /// @brief Spawn pipeline in a new process group.
   Pipeline& new_process_group(bool enabled = true);
+  /// @brief Capacity for the pipes between stages, in bytes.
+  ///
+  /// Also the default for piped stdin/stdout/stderr ends that do not request
+  /// their own capacity. Applied with F_SETPIPE_SZ on Linux (clamped to
+  /// /proc/sys/fs/pipe-max-size); ignored elsewhere. 0 keeps the system default.
+  Pipeline& pipe_capacity(std::size_t bytes);
+#if PROCLY_PLATFORM_LINUX
+  /// @brief Start every stage without its own Command::cgroup() in the cgroup v2 directory path.
+  ///
+  /// Lets PipelineChild::kill_tree() end the whole pipeline, descendants
+  /// included, with one cgroup.kill write; see Cgroup for creating one.
+  Pipeline& cgroup(std::filesystem::path path);
+#endif
 
   /// @brief Configure stdin for the first stage.
   Pipeline& stdin(Stdio value);
@@ -52,12 +131,19 @@ class Pipeline {
   Pipeline& stdout(Stdio value);
   /// @brief Configure stderr for the last stage.
   Pipeline& stderr(Stdio value);
+  /// @brief Spawn every stage through backend.
+  ///
+  /// Without it each stage uses its own Command::backend(), falling back to the
+  /// calling thread's default_backend(). Stages sharing a new process group
+  /// should share a backend. The backend is borrowed and must outlive the
+  /// pipeline and every PipelineChild it spawns.
+  Pipeline& backend(Backend& backend);
 
-  /// @brief Number of stages.
+  /// @brief Number of stages, function stages included.
   [[nodiscard]] std::size_t size() const noexcept {
     auto use = concurrent_use_.enter("Pipeline");
     (void)use;
-    return stages_.size();
+    return stages_.size() + functions_.size();
   }
 
   /// @brief Spawn the pipeline without waiting.
@@ -66,25 +152,67 @@ class Pipeline {
   [[nodiscard]] Result<ExitStatus> status() const;
   /// @brief Spawn, capture output from last stage, and wait.
   [[nodiscard]] Result<Output> output() const;
+  /// @brief Spawn, capture last-stage output with per-stream limits and size hints, and wait.
+  ///
+  /// OverflowPolicy::kill kills every stage.
+  [[nodiscard]] Result<Output> output(const CaptureOptions& options) const;
+  /// @brief Spawn, capture last-stage output, and wait, all under one deadline.
+  ///
+  /// wait.timeout covers the whole pipeline, capture included. On expiry, or
+  /// once wait.cancel fires, every stage is terminated, then killed after
+  /// wait.kill_grace: the whole process group with new_process_group(true),
+  /// each stage otherwise. The capture keeps draining meanwhile, so no stage
+  /// blocks on a full pipe.
+  [[nodiscard]] Result<PipelineOutput> output(const WaitOptions& wait,
+                                              const CaptureOptions& options = {}) const;
+  /// @brief Like output(), also capturing the stderr of every stage.
+  ///
+  /// Every stage's stderr is drained by the same poll loop as the final
+  /// stdout, so a chatty early stage cannot stall the pipeline. Stages with
+  /// an explicit stderr setting keep it. CaptureOptions stderr limits apply
+  /// to the last stage only.
+  [[nodiscard]] Result<PipelineOutput> output_stages(const CaptureOptions& options = {}) const;
+  /// @brief Spawn with piped first-stage stdin, feed input while capturing, and wait.
+  ///
+  /// Overrides any stdin setting on the pipeline.
+  [[nodiscard]] Result<Output> output_with_input(std::string_view input,
+                                                 const CaptureOptions& options = {}) const;
+#if PROCLY_HAS_STD_SPAN
+  /// @brief Byte-span overload of output_with_input().
+  [[nodiscard]] Result<Output> output_with_input(std::span<const std::byte> input,
+                                                 const CaptureOptions& options = {}) const;
+#endif
 
  private:
   /// @brief Commands making up the pipeline in order.
   std::vector<Command> stages_;
+  /// @brief Function stages in order, each paired with the number of commands before it.
+  std::vector<std::pair<std::size_t, FunctionStage>> functions_;
   /// @brief Whether to apply pipefail semantics to aggregate status.
   bool pipefail_ = false;
   /// @brief Whether to spawn the pipeline in a new process group.
   bool new_pgrp_ = false;
+  /// @brief Requested pipe capacity (0 keeps the system default).
+  std::size_t pipe_capacity_ = 0;
+#if PROCLY_PLATFORM_LINUX
+  /// @brief cgroup for stages that do not set their own.
+  std::optional<std::filesystem::path> cgroup_;
+#endif
   /// @brief Optional stdin configuration for the first stage.
   std::optional<Stdio> stdin_;
   /// @brief Optional stdout configuration for the last stage.
   std::optional<Stdio> stdout_;
   /// @brief Optional stderr configuration for the last stage.
   std::optional<Stdio> stderr_;
+  /// @brief Borrowed backend for all stages; null defers to each stage.
+  Backend* backend_ = nullptr;
   /// @brief Detect unsupported concurrent shared use of the builder.
   mutable internal::ConcurrentUseGuard concurrent_use_;
 
   friend Pipeline operator|(Command left, Command right);
   friend Pipeline operator|(Pipeline left, Command right);
+  friend Pipeline operator|(Command left, FunctionStage right);
+  friend Pipeline operator|(Pipeline left, FunctionStage right);
   friend struct internal::PipelineAccess;
 };
 
@@ -92,6 +220,10 @@ class Pipeline {
 Pipeline operator|(Command left, Command right);
 /// @brief Append a command to an existing pipeline.
 Pipeline operator|(Pipeline left, Command right);
+/// @brief Create a pipeline from a command followed by a function stage.
+Pipeline operator|(Command left, FunctionStage right);
+/// @brief Append a function stage to an existing pipeline.
+Pipeline operator|(Pipeline left, FunctionStage right);
 
 /// @brief Running pipeline handle.
 ///
@@ -119,10 +251,37 @@ class PipelineChild {
 
   /// @brief Wait for pipeline completion.
   Result<PipelineStatus> wait();
+  /// @brief Wait with timeout, kill escalation, and optional fail-fast.
+  ///
+  /// Stages are reaped in the order they exit (waitid on the process group
+  /// when the pipeline has one, exit handles otherwise), so a failure in any
+  /// stage is seen right away.
+  Result<PipelineWaitResult> wait(const PipelineWaitOptions& options);
+  /// @brief Non-blocking wait.
+  ///
+  /// Reaps every stage that has exited and returns the status once all have.
+  Result<std::optional<PipelineStatus>> try_wait();
+  /// @brief Pollable exit descriptors for every process stage, in stage order,
+  /// followed by one per function stage that becomes readable once it returns.
+  ///
+  /// Same contract as Child::exit_handle(): owned by the PipelineChild and
+  /// paired with try_wait().
+  Result<std::vector<int>> exit_handles();
+  /// @brief Child::sample() of every process stage not yet reaped, in stage order.
+  Result<std::vector<ProcessSample>> sample();
   /// @brief Send terminate to all stages (or process group).
+  ///
+  /// Function stages are not signalled; they finish once their pipes close.
   Result<void> terminate();
   /// @brief Send kill to all stages (or process group).
   Result<void> kill();
+  /// @brief Kill every stage and all of their descendants, then wait for them to go.
+  ///
+  /// Stages started in a cgroup (Pipeline::cgroup(), Command::cgroup()) are
+  /// torn down through cgroup.kill, once per distinct cgroup, and waited on
+  /// through cgroup.events until empty or timeout (errc::timeout); other
+  /// stages get kill(). Does not reap the stages.
+  Result<void> kill_tree(std::optional<std::chrono::milliseconds> timeout = std::nullopt);
 
  private:
   /// @brief Owned implementation state.
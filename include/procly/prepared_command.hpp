@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "procly/child.hpp"
+#include "procly/chunked_buffer.hpp"
+#include "procly/command.hpp"
+#include "procly/internal/backend.hpp"
+#include "procly/internal/concurrent_use_guard.hpp"
+#include "procly/internal/fd.hpp"
+#include "procly/output_sink.hpp"
+#include "procly/result.hpp"
+#include "procly/status.hpp"
+
+namespace procly {
+
+/// @brief Command lowered once for repeated spawns.
+///
+/// Preparing captures argv, cwd, stdio, options and the environment block, and
+/// resolves the executable against PATH. Later spawns reuse all of it; only
+/// argument slots changed with set_arg() are rewritten. The environment is the
+/// one in effect at prepare time, even for commands that inherit the live
+/// process environment. A backend chosen with Command::backend() is kept; otherwise
+/// each spawn uses the calling thread's default_backend().
+///
+/// PreparedCommand objects are not safe for concurrent shared use from multiple
+/// threads.
+class PreparedCommand {
+ public:
+  /// @brief Lower a command for repeated spawns.
+  [[nodiscard]] static Result<PreparedCommand> prepare(const Command& command);
+
+  /// @brief Number of argv entries, including argv[0].
+  [[nodiscard]] std::size_t arg_count() const noexcept { return spawn_spec_.argv.size(); }
+  /// @brief Current argv entries.
+  [[nodiscard]] const std::vector<std::string>& argv() const noexcept { return spawn_spec_.argv; }
+  /// @brief Resolved executable path (argv[0] when PATH had no match).
+  [[nodiscard]] std::string_view executable() const noexcept;
+
+  /// @brief Replace argument slot `index` (1 <= index < arg_count()).
+  ///
+  /// The program (index 0) stays fixed because the executable is resolved at
+  /// prepare time.
+  Result<void> set_arg(std::size_t index, std::string_view value);
+
+  /// @brief Open the resolved executable once and exec it by descriptor from now on.
+  ///
+  /// Later spawns call execveat(AT_EMPTY_PATH) on an O_PATH descriptor, so no
+  /// path is walked and every child runs the same inode even if the file is
+  /// renamed or replaced. The descriptor is close-on-exec, so the program must
+  /// be a binary rather than a `#!` script. Copies of this object share the
+  /// descriptor. Linux only; elsewhere this returns std::errc::not_supported.
+  Result<void> pin_executable();
+
+  /// @brief Spawn without waiting.
+  [[nodiscard]] Result<Child> spawn() const;
+  /// @brief Spawn and wait for exit status.
+  [[nodiscard]] Result<ExitStatus> status() const;
+  /// @brief Spawn, capture output, and wait.
+  [[nodiscard]] Result<Output> output() const;
+  /// @brief Spawn, capture output with per-stream limits and size hints, and wait.
+  [[nodiscard]] Result<Output> output(const CaptureOptions& options) const;
+  /// @brief Spawn, capture output into caller-owned strings, and wait.
+  ///
+  /// The strings are cleared first but keep their capacity, so reusing them
+  /// across calls keeps heap allocation off the capture path.
+  [[nodiscard]] Result<ExitStatus> output_into(std::string& stdout_data,
+                                               std::string& stderr_data) const;
+  /// @brief Spawn, capture output into pooled fixed-size chunks, and wait.
+  ///
+  /// Reads land straight in the chunks, which are never moved or regrown, so
+  /// large captures need no contiguous allocation; flatten() when one is needed.
+  [[nodiscard]] Result<ChunkedOutput> output_chunked() const;
+  /// @brief Spawn, stream output into sinks as it is read, and wait.
+  [[nodiscard]] Result<ExitStatus> output(OutputSink stdout_sink, OutputSink stderr_sink) const;
+
+  /// @brief Spawn and throw on error.
+  [[nodiscard]] Child spawn_or_throw() const;
+  /// @brief Wait and throw on error.
+  [[nodiscard]] ExitStatus status_or_throw() const;
+  /// @brief Capture output and throw on error.
+  [[nodiscard]] Output output_or_throw() const;
+
+ private:
+  PreparedCommand() = default;
+
+  /// @brief Spec used by spawn() and status().
+  internal::SpawnSpec spawn_spec_;
+  /// @brief Spec used by output() (stdout/stderr piped by default).
+  internal::SpawnSpec output_spec_;
+  /// @brief Backend captured from the command; null uses default_backend().
+  Backend* backend_ = nullptr;
+  /// @brief Executable opened by pin_executable(); both specs borrow it as exec_fd.
+  std::shared_ptr<const internal::unique_fd> executable_fd_;
+  /// @brief Detect unsupported concurrent shared use.
+  mutable internal::ConcurrentUseGuard concurrent_use_;
+};
+
+}  // namespace procly
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "procly/command.hpp"
+#include "procly/internal/concurrent_use_guard.hpp"
+#include "procly/pipe.hpp"
+#include "procly/result.hpp"
+#include "procly/status.hpp"
+
+namespace procly {
+
+/// @brief Status of every node in a process graph.
+struct GraphStatus {
+  /// @brief Exit status for each node, in add() order.
+  std::vector<ExitStatus> nodes;
+  /// @brief Resources used by each node, parallel to nodes; empty entries
+  /// mean the node's backend does not report them.
+  std::vector<std::optional<ResourceUsage>> node_usage;
+  /// @brief First error hit while copying a fanned-out stream, if any
+  /// (for example EPIPE when a consumer exits before reading everything).
+  std::optional<Error> fan_out_error;
+
+  /// @brief True when every node exited with code 0 and every copy completed.
+  [[nodiscard]] bool success() const noexcept;
+};
+
+/// @brief Running process graph handle (forward declaration).
+class ProcessGraphChild;
+
+/// @brief Processes connected by pipes as a directed acyclic graph.
+///
+/// connect(a, b) sends a's stdout to b's stdin. A node with several outgoing
+/// edges fans out: every consumer sees the whole stream, duplicated with
+/// tee()/splice() on Linux so the bytes stay in the kernel (one copier
+/// thread per extra consumer, read/write elsewhere). A node with several
+/// incoming edges fans in: its producers share one pipe, so their writes
+/// interleave (writes up to PIPE_BUF bytes stay whole). Unconnected stdio
+/// follows each Command's own settings.
+///
+/// ProcessGraph builders are not safe for concurrent shared use from
+/// multiple threads.
+class ProcessGraph {
+ public:
+  /// @brief Node handle returned by add().
+  using NodeId = std::size_t;
+
+  /// @brief Construct an empty graph.
+  ProcessGraph() = default;
+
+  /// @brief Add a node; ids count up from 0.
+  NodeId add(Command command);
+  /// @brief Send from's stdout to to's stdin.
+  ///
+  /// Invalid ids, self-loops, duplicate edges and cycles are reported by spawn().
+  ProcessGraph& connect(NodeId from, NodeId to);
+  /// @brief Capacity for the pipes between nodes, in bytes (0 keeps the system default).
+  ProcessGraph& pipe_capacity(std::size_t bytes);
+
+  /// @brief Number of nodes.
+  [[nodiscard]] std::size_t size() const noexcept {
+    auto use = concurrent_use_.enter("ProcessGraph");
+    (void)use;
+    return nodes_.size();
+  }
+
+  /// @brief Spawn every node without waiting.
+  [[nodiscard]] Result<ProcessGraphChild> spawn() const;
+  /// @brief Spawn and wait for every node.
+  ///
+  /// Piped stdio left on a node is closed before waiting.
+  [[nodiscard]] Result<GraphStatus> status() const;
+
+ private:
+  /// @brief Commands, indexed by NodeId.
+  std::vector<Command> nodes_;
+  /// @brief Edges as (from, to) pairs in connect() order.
+  std::vector<std::pair<NodeId, NodeId>> edges_;
+  /// @brief Requested pipe capacity (0 keeps the system default).
+  std::size_t pipe_capacity_ = 0;
+  /// @brief Detect unsupported concurrent shared use of the builder.
+  mutable internal::ConcurrentUseGuard concurrent_use_;
+};
+
+/// @brief Running process graph.
+///
+/// ProcessGraphChild handles are not safe for concurrent use from multiple
+/// threads.
+class ProcessGraphChild {
+ public:
+  /// @brief Opaque implementation type.
+  struct Impl;
+
+  /// @brief Construct an empty handle.
+  ProcessGraphChild();
+  /// @brief Move-construct a handle.
+  ProcessGraphChild(ProcessGraphChild&& other) noexcept;
+  /// @brief Move-assign a handle.
+  ProcessGraphChild& operator=(ProcessGraphChild&& other) noexcept;
+  /// @brief Destroy the handle; running nodes are left to the backend's reaper.
+  ~ProcessGraphChild();
+
+  /// @brief Take ownership of a node's piped stdin, if present.
+  std::optional<PipeWriter> take_stdin(ProcessGraph::NodeId node) noexcept;
+  /// @brief Take ownership of a node's piped stdout, if present.
+  std::optional<PipeReader> take_stdout(ProcessGraph::NodeId node) noexcept;
+  /// @brief Take ownership of a node's piped stderr, if present.
+  std::optional<PipeReader> take_stderr(ProcessGraph::NodeId node) noexcept;
+
+  /// @brief Wait for every node and fan-out copy to finish.
+  Result<GraphStatus> wait();
+  /// @brief Send terminate to every running node.
+  Result<void> terminate();
+  /// @brief Send kill to every running node.
+  Result<void> kill();
+
+ private:
+  friend class ProcessGraph;
+
+  /// @brief Adopt spawned state.
+  explicit ProcessGraphChild(std::unique_ptr<Impl> impl);
+
+  /// @brief Owned implementation state.
+  std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace procly
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "procly/child.hpp"
+#include "procly/internal/concurrent_use_guard.hpp"
+#include "procly/pipeline.hpp"
+#include "procly/result.hpp"
+#include "procly/status.hpp"
+
+namespace procly {
+
+/// @brief Per-child configuration for Reactor::watch.
+struct WatchOptions {
+  /// @brief Bytes fed to piped stdin before it is closed.
+  ///
+  /// Piped stdin is closed right away when empty.
+  std::string stdin_data;
+  /// @brief Optional timeout before the child is terminated.
+  std::optional<std::chrono::milliseconds> timeout;
+  /// @brief Grace period after terminate before kill.
+  std::chrono::milliseconds kill_grace{WaitOptions::kDefaultKillGrace};
+};
+
+/// @brief Completion of a Child watched by a Reactor.
+struct ChildCompletion {
+  /// @brief Final status with timeout/escalation details.
+  WaitResult wait;
+  /// @brief Captured stdout (empty unless stdout was piped).
+  std::string stdout_data;
+  /// @brief Captured stderr (empty unless stderr was piped).
+  std::string stderr_data;
+};
+
+/// @brief Completion of a PipelineChild watched by a Reactor.
+struct PipelineCompletion {
+  /// @brief Per-stage and aggregate status.
+  PipelineStatus status;
+  /// @brief True when the timeout budget elapsed before completion.
+  bool timed_out = false;
+  /// @brief True when SIGTERM (or equivalent) was sent.
+  bool sent_terminate = false;
+  /// @brief True when SIGKILL (or equivalent) was sent.
+  bool sent_kill = false;
+  /// @brief Captured stdout of the last stage (empty unless piped).
+  std::string stdout_data;
+  /// @brief Captured stderr of the last stage (empty unless piped).
+  std::string stderr_data;
+};
+
+/// @brief Single-threaded event loop supervising many children.
+///
+/// A Reactor drains piped stdout/stderr, feeds stdin, detects exits through
+/// exit handles, and applies timeouts for every watched child, all from the
+/// thread that calls run() or run_once(). It is backed by epoll on Linux and
+/// kqueue on macOS. Reactors are not safe for concurrent use; use one per
+/// thread to spread work over a small pool. Callbacks run on the reactor
+/// thread and may watch further children.
+class Reactor {
+ public:
+  /// @brief Callback receiving a child completion or error.
+  using ChildCallback = std::function<void(Result<ChildCompletion>)>;
+  /// @brief Callback receiving a pipeline completion or error.
+  using PipelineCallback = std::function<void(Result<PipelineCompletion>)>;
+
+  /// @brief Create a reactor with its own epoll/kqueue instance.
+  static Result<Reactor> create();
+
+  /// @brief Move-construct a reactor.
+  Reactor(Reactor&& other) noexcept;
+  /// @brief Move-assign a reactor.
+  Reactor& operator=(Reactor&& other) noexcept;
+  Reactor(const Reactor&) = delete;
+  Reactor& operator=(const Reactor&) = delete;
+  /// @brief Destroy the reactor, killing and reaping children still watched.
+  ~Reactor();
+
+  /// @brief Supervise a child; on_complete runs once it has exited and its pipes are drained.
+  ///
+  /// Pipes already taken from the child are left alone. On error the child
+  /// is killed and reaped and on_complete is not called.
+  Result<void> watch(Child child, WatchOptions options, ChildCallback on_complete);
+  /// @brief Supervise a pipeline; on_complete runs once every stage has exited.
+  Result<void> watch(PipelineChild child, WatchOptions options, PipelineCallback on_complete);
+  /// @brief Supervise a child and deliver its completion through a future.
+  std::future<Result<ChildCompletion>> watch(Child child, WatchOptions options = {});
+  /// @brief Supervise a pipeline and deliver its completion through a future.
+  std::future<Result<PipelineCompletion>> watch(PipelineChild child, WatchOptions options = {});
+
+  /// @brief Call on_ready once fd polls readable, or with false when timeout elapses first.
+  ///
+  /// One-shot; the descriptor is borrowed and must stay open until the
+  /// callback runs. Pending callbacks are dropped if the reactor is destroyed.
+  Result<void> when_readable(int fd, std::optional<std::chrono::milliseconds> timeout,
+                             std::function<void(bool ready)> on_ready);
+
+  /// @brief Resource use of every watched child and pipeline stage still running, in one pass.
+  ///
+  /// Each process's /proc/<pid>/stat is opened once and re-read on later
+  /// calls (see Child::sample()). Processes whose sample fails, typically
+  /// because they exited meanwhile, are left out. Linux only.
+  Result<std::vector<ProcessSample>> sample_all();
+
+  /// @brief Number of children and readiness callbacks still pending.
+  [[nodiscard]] std::size_t pending() const noexcept;
+
+  /// @brief Wait up to timeout (forever when empty) for events and process them.
+  ///
+  /// Returns the number of completions and readiness callbacks delivered.
+  Result<std::size_t> run_once(std::optional<std::chrono::milliseconds> timeout = std::nullopt);
+  /// @brief Process events until nothing is pending.
+  Result<void> run();
+
+ private:
+  /// @brief Opaque platform-specific implementation.
+  struct Impl;
+
+  Reactor();
+
+  /// @brief Owned implementation state.
+  std::unique_ptr<Impl> impl_;
+  /// @brief Detect unsupported concurrent shared use of the reactor.
+  mutable internal::ConcurrentUseGuard concurrent_use_;
+};
+
+}  // namespace procly
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+#include "procly/result.hpp"
+
+namespace procly {
+
+/// @brief Background exit collection for children of the native backend.
+///
+/// While a Reaper runs, every child the native backend spawns is adopted:
+/// one background thread watches all of their exits (pidfds on Linux, kqueue
+/// on macOS, a periodic wait4(WNOHANG) sweep where neither exists), reaps
+/// them, and publishes each result to the Child or PipelineChild that waits
+/// for it. Waits then sleep on that hand-off instead of each needing a thread
+/// of their own, and a handle dropped while its process still runs no longer
+/// leaves a zombie: the process is reaped in the background and its status
+/// discarded.
+///
+/// At most one Reaper runs at a time. It must outlive every handle spawned
+/// while it ran. Children spawned before start(), or through another
+/// Backend, are unaffected.
+class Reaper {
+ public:
+  /// @brief Opaque implementation.
+  struct Impl;
+
+  /// @brief Start the background thread and adopt native-backend spawns from now on.
+  ///
+  /// Fails with std::errc::device_or_resource_busy when a Reaper is already running.
+  static Result<Reaper> start();
+
+  /// @brief Move-construct a reaper handle.
+  Reaper(Reaper&& other) noexcept;
+  /// @brief Move-assign a reaper handle.
+  Reaper& operator=(Reaper&& other) noexcept;
+  Reaper(const Reaper&) = delete;
+  Reaper& operator=(const Reaper&) = delete;
+  /// @brief Stop adopting and join the background thread.
+  ~Reaper();
+
+  /// @brief Adopted children whose status has not yet been collected or discarded.
+  [[nodiscard]] std::size_t tracked() const;
+
+ private:
+  explicit Reaper(std::unique_ptr<Impl> impl) noexcept;
+
+  /// @brief Owned implementation state.
+  std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace procly
@@ -0,0 +1,141 @@
+#pragma once
+
+#include "procly/platform.hpp"
+
+#if PROCLY_PLATFORM_POSIX
+
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+
+#include "procly/result.hpp"
+
+namespace procly {
+
+class Backend;
+class ScopedBackend;
+
+/// @brief Backend that runs children through another backend and records each run.
+///
+/// For every child reaped through backend() the recorder keeps its argv,
+/// the bytes of its piped stdout and stderr with the time each chunk
+/// arrived, and its exit status and exit time. save() writes the completed
+/// runs, in spawn order, to the file a Replayer serves them from. Streams
+/// that are not piped are not recorded, and children dropped unreaped are
+/// left out.
+///
+/// Output is relayed through a thread per child, so recording costs more
+/// than a plain spawn; it is meant for producing fixtures. The Recorder must
+/// outlive every child spawned through it.
+class Recorder {
+ public:
+  /// @brief Opaque implementation state.
+  struct Impl;
+
+  /// @brief Routes spawns on the calling thread through a recorder while alive.
+  class Scope {
+   public:
+    /// @brief Install the recorder as the backend for this thread.
+    explicit Scope(Recorder& recorder);
+    /// @brief Restore the previous backend.
+    ~Scope();
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+   private:
+    /// @brief Backend override restored on destruction.
+    std::unique_ptr<ScopedBackend> override_;
+  };
+
+  /// @brief Record into path, spawning through inner (the thread's default backend when null).
+  explicit Recorder(std::filesystem::path path, Backend* inner = nullptr);
+
+  /// @brief Move-construct a recorder handle.
+  Recorder(Recorder&& other) noexcept;
+  /// @brief Move-assign a recorder handle.
+  Recorder& operator=(Recorder&& other) noexcept;
+  Recorder(const Recorder&) = delete;
+  Recorder& operator=(const Recorder&) = delete;
+  /// @brief Wait for the relay threads and save(), ignoring errors.
+  ~Recorder();
+
+  /// @brief The recorder as a Backend, for Command::backend().
+  [[nodiscard]] Backend& backend() noexcept;
+  /// @brief Runs completed so far, after the output of reaped children has ended.
+  [[nodiscard]] std::size_t recorded() const;
+  /// @brief Write every completed run to the file, replacing it atomically.
+  ///
+  /// Like recorded(), waits until the output of every reaped child has ended.
+  [[nodiscard]] Result<void> save() const;
+
+ private:
+  /// @brief Owned implementation state.
+  std::unique_ptr<Impl> impl_;
+};
+
+/// @brief Pacing of a Replayer.
+struct ReplayOptions {
+  /// @brief Factor applied to recorded delays; 0 serves output and exits without waiting.
+  double time_scale = 1.0;
+};
+
+/// @brief Backend that serves recorded runs instead of starting processes.
+///
+/// Each spawn is matched by argv against the runs of a Recorder file, first
+/// unused run first, and fails with errc::spawn_failed when none is left.
+/// The child's piped stdout and stderr are fed the recorded bytes through
+/// real pipes at the recorded offsets (scaled by time_scale), and the child
+/// exits with the recorded status at the recorded time; piped stdin is read
+/// and discarded. Signals end a running replay at once with that signal, as
+/// if the process had died of it. Replayed children have synthetic pids
+/// above any real pid, and must not be reached by means other than the
+/// backend. The Replayer must outlive every child spawned through it.
+class Replayer {
+ public:
+  /// @brief Opaque implementation state.
+  struct Impl;
+
+  /// @brief Routes spawns on the calling thread through a replayer while alive.
+  class Scope {
+   public:
+    /// @brief Install the replayer as the backend for this thread.
+    explicit Scope(Replayer& replayer);
+    /// @brief Restore the previous backend.
+    ~Scope();
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+   private:
+    /// @brief Backend override restored on destruction.
+    std::unique_ptr<ScopedBackend> override_;
+  };
+
+  /// @brief Load the runs recorded in path.
+  [[nodiscard]] static Result<Replayer> open(const std::filesystem::path& path,
+                                             ReplayOptions options = {});
+
+  /// @brief Move-construct a replayer handle.
+  Replayer(Replayer&& other) noexcept;
+  /// @brief Move-assign a replayer handle.
+  Replayer& operator=(Replayer&& other) noexcept;
+  Replayer(const Replayer&) = delete;
+  Replayer& operator=(const Replayer&) = delete;
+  /// @brief Stop replays still running (as if killed) and wait for their threads.
+  ~Replayer();
+
+  /// @brief The replayer as a Backend, for Command::backend().
+  [[nodiscard]] Backend& backend() noexcept;
+  /// @brief Recorded runs not yet served.
+  [[nodiscard]] std::size_t remaining() const;
+
+ private:
+  /// @brief Wrap loaded state.
+  explicit Replayer(std::unique_ptr<Impl> impl) noexcept;
+
+  /// @brief Owned implementation state.
+  std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace procly
+
+#endif
@@ -32,6 +32,8 @@ enum class errc : std::uint8_t {
   invalid_stdio,
   /// @brief Invalid pipeline configuration.
   invalid_pipeline,
+  /// @brief Argument out of range or otherwise invalid.
+  invalid_argument,
 
   // OS/syscall or API failures
   /// @brief Pipe creation failed.
@@ -58,6 +60,8 @@ enum class errc : std::uint8_t {
   // High-level
   /// @brief Operation timed out.
   timeout,
+  /// @brief Operation was cancelled, before it started or by a CancellationToken.
+  cancelled,
 };
 
 /// @brief Error payload returned by procly APIs.
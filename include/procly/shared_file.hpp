@@ -0,0 +1,61 @@
+#pragma once
+
+#include <filesystem>
+#include <memory>
+#include <optional>
+
+#include "procly/platform.hpp"
+#include "procly/result.hpp"
+#include "procly/stdio.hpp"
+
+#if PROCLY_PLATFORM_POSIX
+
+namespace procly {
+
+/// @brief File opened once and handed to any number of spawns (POSIX).
+///
+/// Stdio::file() opens its path again in every child; a SharedFile opens it
+/// once with O_CLOEXEC and lends the descriptor through stdio(), which saves
+/// the path lookup and permission check per spawn when many children append
+/// to one log. Copies share the descriptor, and every Stdio made from it keeps
+/// it open, so the handle may be dropped while commands still use it.
+///
+/// Every child gets the same open file description, so they all share one file
+/// offset:
+/// - OpenMode::write_append: each write lands at the current end of the file,
+///   so children running at once interleave whole writes and never overwrite.
+/// - OpenMode::write_truncate and OpenMode::read_write: the offset is not
+///   reset per spawn, so each child continues where the previous writes
+///   stopped; concurrent writers advance it together.
+/// - OpenMode::read: children read through the shared offset, so together they
+///   consume the file once, split between them, and a later spawn starts where
+///   the last one stopped. Use Stdio::file() when every child must read the
+///   whole file.
+class SharedFile {
+ public:
+  /// @brief Open path with mode, creating it with perms (default 0666 before umask).
+  ///
+  /// The file offset is shared by every child; see the class notes for what
+  /// that means per mode.
+  static Result<SharedFile> open(const std::filesystem::path& path,
+                                 OpenMode mode = OpenMode::write_append,
+                                 std::optional<FilePerms> perms = std::nullopt);
+
+  /// @brief Underlying descriptor; valid while any copy or Stdio from stdio() is alive.
+  [[nodiscard]] int native_handle() const noexcept;
+  /// @brief Stdio that redirects a stream to this file.
+  [[nodiscard]] Stdio stdio() const;
+
+ private:
+  /// @brief Shared state type.
+  struct State;
+
+  explicit SharedFile(std::shared_ptr<const State> state);
+
+  /// @brief Descriptor shared by every copy.
+  std::shared_ptr<const State> state_;
+};
+
+}  // namespace procly
+
+#endif
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string>
+
+#include "procly/platform.hpp"
+#include "procly/result.hpp"
+#include "procly/stdio.hpp"
+
+#if PROCLY_PLATFORM_LINUX
+
+namespace procly {
+
+/// @brief Shared-memory ring a cooperating child streams into (Linux).
+///
+/// An alternative to Stdio::piped() for helper tools that move a lot of data:
+/// the ring is a memfd, sealed against resizing, mapped by both processes and
+/// handed to the child through stdio() (usually as its stdout). The child attaches with
+/// procly::shm::RingWriter from the header-only procly/shm_ring.hpp and writes
+/// straight into the mapping; futex wakeups happen only when a side is asleep.
+/// Copies share the ring. Not safe for concurrent reads from several threads.
+class ShmChannel {
+ public:
+  /// @brief Ring size used by create() without an argument.
+  static constexpr std::size_t kDefaultCapacity = std::size_t{4} << 20;
+
+  /// @brief Create a ring holding capacity bytes, rounded up to a power of two (min 4 KiB).
+  static Result<ShmChannel> create(std::size_t capacity = kDefaultCapacity);
+
+  /// @brief The ring's memfd.
+  [[nodiscard]] int native_handle() const noexcept;
+  /// @brief Stdio that hands the ring to a child; keeps the memfd open while alive.
+  [[nodiscard]] Stdio stdio() const;
+
+  /// @brief Read up to n bytes, sleeping until data arrives; 0 once the writer closed.
+  ///
+  /// Fails with errc::timeout if nothing arrives within timeout.
+  [[nodiscard]] Result<std::size_t> read_some(
+      void* data, std::size_t n,
+      std::optional<std::chrono::milliseconds> timeout = std::nullopt) const;
+  /// @brief Read until the writer closes the ring.
+  [[nodiscard]] Result<std::string> read_all() const;
+  /// @brief Mark the ring closed from the parent, e.g. after the child exited without
+  /// closing it; bytes already written stay readable.
+  void close() const noexcept;
+
+ private:
+  /// @brief Shared state type.
+  struct State;
+
+  explicit ShmChannel(std::shared_ptr<State> state);
+
+  /// @brief Ring shared by every copy.
+  std::shared_ptr<State> state_;
+};
+
+}  // namespace procly
+
+#endif
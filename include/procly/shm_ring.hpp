@@ -0,0 +1,372 @@
+#pragma once
+
+#include "procly/platform.hpp"
+
+#if PROCLY_PLATFORM_LINUX
+
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <utility>
+
+/// @file
+/// @brief Header-only single-producer/single-consumer ring buffer in shared memory.
+///
+/// The parent creates the ring with ShmChannel and hands the memfd to a child
+/// as one of its standard streams; the child attaches with RingWriter (or
+/// RingReader) using only this header, so it needs no procly library. Both
+/// sides copy straight into the mapping and only make a futex syscall when the
+/// other side is asleep.
+
+namespace procly::shm {
+
+/// @brief Identifies a procly ring mapping.
+inline constexpr std::uint32_t kRingMagic = 0x70726e67;
+/// @brief Layout version of RingHeader.
+inline constexpr std::uint32_t kRingVersion = 1;
+
+/// @brief Control block at the start of the mapping; the data area follows it.
+///
+/// head and tail count bytes ever written and read, so head - tail is the fill
+/// level and position & (capacity - 1) is the offset into the data area.
+struct RingHeader {
+  /// @brief kRingMagic once initialized.
+  std::uint32_t magic;
+  /// @brief kRingVersion.
+  std::uint32_t version;
+  /// @brief Data area size in bytes; a power of two.
+  std::uint64_t capacity;
+  /// @brief Bytes written so far (writer-owned).
+  alignas(64) std::atomic<std::uint64_t> head;
+  /// @brief Bytes read so far (reader-owned).
+  alignas(64) std::atomic<std::uint64_t> tail;
+  /// @brief Futex word bumped after every write.
+  alignas(64) std::atomic<std::uint32_t> data_seq;
+  /// @brief Set while the reader sleeps on data_seq.
+  std::atomic<std::uint32_t> reader_waiting;
+  /// @brief Futex word bumped after every read.
+  alignas(64) std::atomic<std::uint32_t> space_seq;
+  /// @brief Set while the writer sleeps on space_seq.
+  std::atomic<std::uint32_t> writer_waiting;
+  /// @brief Nonzero once the writer is done; the reader drains and then sees EOF.
+  alignas(64) std::atomic<std::uint32_t> closed;
+};
+
+/// @brief Offset of the data area from the start of the mapping.
+inline constexpr std::size_t kRingDataOffset = (sizeof(RingHeader) + 63) & ~std::size_t{63};
+
+namespace detail {
+
+inline long futex(std::atomic<std::uint32_t>* word, int op, std::uint32_t value,
+                  const timespec* timeout) {
+  // Shared (not FUTEX_PRIVATE) futexes, since the word lives in memory mapped by two processes.
+  return ::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(word), op, value, timeout, nullptr,
+                   0);
+}
+
+inline void wake(std::atomic<std::uint32_t>* seq, std::atomic<std::uint32_t>* waiting) {
+  seq->fetch_add(1, std::memory_order_seq_cst);
+  if (waiting->load(std::memory_order_seq_cst) != 0) {
+    futex(seq, FUTEX_WAKE, 1, nullptr);
+  }
+}
+
+// Sleep on seq unless ready() turns true after announcing the wait. False on timeout.
+template <typename Ready>
+bool sleep_until(std::atomic<std::uint32_t>* seq, std::atomic<std::uint32_t>* waiting,
+                 Ready ready, std::optional<std::chrono::steady_clock::time_point> deadline) {
+  std::uint32_t observed = seq->load(std::memory_order_seq_cst);
+  waiting->store(1, std::memory_order_seq_cst);
+  if (ready()) {
+    waiting->store(0, std::memory_order_relaxed);
+    return true;
+  }
+  timespec relative{};
+  const timespec* timeout = nullptr;
+  if (deadline) {
+    auto left = *deadline - std::chrono::steady_clock::now();
+    if (left <= std::chrono::steady_clock::duration::zero()) {
+      waiting->store(0, std::memory_order_relaxed);
+      return false;
+    }
+    auto secs = std::chrono::duration_cast<std::chrono::seconds>(left);
+    relative.tv_sec = static_cast<time_t>(secs.count());
+    relative.tv_nsec = static_cast<long>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(left - secs).count());
+    timeout = &relative;
+  }
+  futex(seq, FUTEX_WAIT, observed, timeout);
+  waiting->store(0, std::memory_order_relaxed);
+  return true;
+}
+
+}  // namespace detail
+
+/// @brief Mapping of a ring memfd shared by RingWriter and RingReader.
+class RingMapping {
+ public:
+  RingMapping() = default;
+  RingMapping(RingMapping&& other) noexcept
+      : base_(std::exchange(other.base_, nullptr)),
+        size_(std::exchange(other.size_, 0)),
+        capacity_(std::exchange(other.capacity_, 0)) {}
+  RingMapping& operator=(RingMapping&& other) noexcept {
+    if (this != &other) {
+      unmap();
+      base_ = std::exchange(other.base_, nullptr);
+      size_ = std::exchange(other.size_, 0);
+      capacity_ = std::exchange(other.capacity_, 0);
+    }
+    return *this;
+  }
+  RingMapping(const RingMapping&) = delete;
+  RingMapping& operator=(const RingMapping&) = delete;
+  ~RingMapping() { unmap(); }
+
+  /// @brief Map an initialized ring from fd; empty with errno set on failure.
+  static std::optional<RingMapping> attach(int fd) {
+    struct stat info {};
+    if (::fstat(fd, &info) != 0) {
+      return std::nullopt;
+    }
+    auto size = static_cast<std::size_t>(info.st_size);
+    if (size <= kRingDataOffset) {
+      errno = EINVAL;
+      return std::nullopt;
+    }
+    void* base = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+      return std::nullopt;
+    }
+    RingMapping mapping;
+    mapping.base_ = static_cast<std::byte*>(base);
+    mapping.size_ = size;
+    const RingHeader& header = mapping.header();
+    const std::uint64_t capacity = header.capacity;
+    if (header.magic != kRingMagic || header.version != kRingVersion ||
+        capacity != size - kRingDataOffset || (capacity & (capacity - 1)) != 0) {
+      errno = EINVAL;
+      return std::nullopt;
+    }
+    mapping.capacity_ = capacity;
+    return mapping;
+  }
+
+  /// @brief Control block.
+  [[nodiscard]] RingHeader& header() const noexcept {
+    return *reinterpret_cast<RingHeader*>(base_);
+  }
+  /// @brief Start of the data area.
+  [[nodiscard]] std::byte* data() const noexcept { return base_ + kRingDataOffset; }
+  /// @brief Data area size validated at attach.
+  ///
+  /// The other process can rewrite the header at any time, so offsets are
+  /// only ever computed from this copy, never from RingHeader::capacity.
+  [[nodiscard]] std::uint64_t capacity() const noexcept { return capacity_; }
+  /// @brief True when mapped.
+  explicit operator bool() const noexcept { return base_ != nullptr; }
+
+ private:
+  void unmap() noexcept {
+    if (base_ != nullptr) {
+      ::munmap(base_, size_);
+      base_ = nullptr;
+    }
+  }
+
+  std::byte* base_ = nullptr;
+  std::size_t size_ = 0;
+  std::uint64_t capacity_ = 0;
+};
+
+/// @brief Producer end of a ring; closes the ring when destroyed.
+class RingWriter {
+ public:
+  RingWriter() = default;
+  RingWriter(RingWriter&& other) noexcept
+      : mapping_(std::move(other.mapping_)), corrupt_(std::exchange(other.corrupt_, false)) {}
+  RingWriter& operator=(RingWriter&& other) noexcept {
+    if (this != &other) {
+      close();
+      mapping_ = std::move(other.mapping_);
+      corrupt_ = std::exchange(other.corrupt_, false);
+    }
+    return *this;
+  }
+  RingWriter(const RingWriter&) = delete;
+  RingWriter& operator=(const RingWriter&) = delete;
+  ~RingWriter() { close(); }
+
+  /// @brief Attach to the ring behind fd (for example STDOUT_FILENO in the child).
+  static std::optional<RingWriter> attach(int fd) {
+    auto mapping = RingMapping::attach(fd);
+    if (!mapping) {
+      return std::nullopt;
+    }
+    RingWriter writer;
+    writer.mapping_ = std::move(*mapping);
+    return writer;
+  }
+
+  /// @brief Copy as much of data as fits without blocking; returns the byte count.
+  ///
+  /// Returns 0 for good once corrupt() is set.
+  std::size_t write_some(const void* data, std::size_t n) noexcept {
+    RingHeader& header = mapping_.header();
+    const std::uint64_t capacity = mapping_.capacity();
+    const std::uint64_t head = header.head.load(std::memory_order_relaxed);
+    const std::uint64_t tail = header.tail.load(std::memory_order_acquire);
+    if (corrupt_ || head - tail > capacity) {
+      corrupt_ = true;
+      return 0;
+    }
+    const std::uint64_t space = capacity - (head - tail);
+    const auto count = static_cast<std::size_t>(std::min<std::uint64_t>(n, space));
+    if (count == 0) {
+      return 0;
+    }
+    const auto offset = static_cast<std::size_t>(head & (capacity - 1));
+    const std::size_t first = std::min<std::size_t>(count, capacity - offset);
+    std::memcpy(mapping_.data() + offset, data, first);
+    std::memcpy(mapping_.data(), static_cast<const std::byte*>(data) + first, count - first);
+    header.head.store(head + count, std::memory_order_seq_cst);
+    detail::wake(&header.data_seq, &header.reader_waiting);
+    return count;
+  }
+
+  /// @brief Copy all of data, sleeping while the ring is full.
+  ///
+  /// Gives up with bytes unwritten once corrupt() is set.
+  void write_all(const void* data, std::size_t n) noexcept {
+    const auto* bytes = static_cast<const std::byte*>(data);
+    RingHeader& header = mapping_.header();
+    const std::uint64_t capacity = mapping_.capacity();
+    while (n > 0) {
+      std::size_t written = write_some(bytes, n);
+      bytes += written;
+      n -= written;
+      if (corrupt_) {
+        return;
+      }
+      if (n > 0 && written == 0) {
+        detail::sleep_until(
+            &header.space_seq, &header.writer_waiting,
+            [&header, capacity] {
+              return header.head.load(std::memory_order_relaxed) -
+                         header.tail.load(std::memory_order_seq_cst) !=
+                     capacity;
+            },
+            std::nullopt);
+      }
+    }
+  }
+
+  /// @brief True once the reader published a tail that leaves more than capacity bytes unread.
+  [[nodiscard]] bool corrupt() const noexcept { return corrupt_; }
+
+  /// @brief Mark the ring finished; the reader sees EOF once it drains.
+  void close() noexcept {
+    if (!mapping_) {
+      return;
+    }
+    RingHeader& header = mapping_.header();
+    header.closed.store(1, std::memory_order_seq_cst);
+    detail::wake(&header.data_seq, &header.reader_waiting);
+    mapping_ = RingMapping();
+  }
+
+ private:
+  RingMapping mapping_;
+  bool corrupt_ = false;
+};
+
+/// @brief Consumer end of a ring.
+class RingReader {
+ public:
+  RingReader() = default;
+  /// @brief Read through an existing mapping.
+  explicit RingReader(RingMapping mapping) : mapping_(std::move(mapping)) {}
+
+  /// @brief Attach to the ring behind fd.
+  static std::optional<RingReader> attach(int fd) {
+    auto mapping = RingMapping::attach(fd);
+    if (!mapping) {
+      return std::nullopt;
+    }
+    return RingReader(std::move(*mapping));
+  }
+
+  /// @brief Copy up to n buffered bytes without blocking; 0 when the ring is empty.
+  ///
+  /// Returns 0 for good once corrupt() is set.
+  std::size_t read_some(void* data, std::size_t n) noexcept {
+    RingHeader& header = mapping_.header();
+    const std::uint64_t capacity = mapping_.capacity();
+    const std::uint64_t tail = header.tail.load(std::memory_order_relaxed);
+    const std::uint64_t head = header.head.load(std::memory_order_acquire);
+    if (corrupt_ || head - tail > capacity) {
+      corrupt_ = true;
+      return 0;
+    }
+    const auto count = static_cast<std::size_t>(std::min<std::uint64_t>(n, head - tail));
+    if (count == 0) {
+      return 0;
+    }
+    const auto offset = static_cast<std::size_t>(tail & (capacity - 1));
+    const std::size_t first = std::min<std::size_t>(count, capacity - offset);
+    std::memcpy(data, mapping_.data() + offset, first);
+    std::memcpy(static_cast<std::byte*>(data) + first, mapping_.data(), count - first);
+    header.tail.store(tail + count, std::memory_order_seq_cst);
+    detail::wake(&header.space_seq, &header.writer_waiting);
+    return count;
+  }
+
+  /// @brief True once the writer closed and every byte has been read.
+  [[nodiscard]] bool finished() const noexcept {
+    const RingHeader& header = mapping_.header();
+    return header.closed.load(std::memory_order_acquire) != 0 &&
+           header.head.load(std::memory_order_acquire) ==
+               header.tail.load(std::memory_order_relaxed);
+  }
+
+  /// @brief Sleep until data arrives, the writer closes, or deadline passes.
+  ///
+  /// Returns false only on timeout; may also return early on a spurious wakeup.
+  bool wait(std::optional<std::chrono::steady_clock::time_point> deadline =
+                std::nullopt) noexcept {
+    RingHeader& header = mapping_.header();
+    return detail::sleep_until(
+        &header.data_seq, &header.reader_waiting,
+        [&header] {
+          return header.head.load(std::memory_order_seq_cst) !=
+                     header.tail.load(std::memory_order_relaxed) ||
+                 header.closed.load(std::memory_order_seq_cst) != 0;
+        },
+        deadline);
+  }
+
+  /// @brief True once the writer published a head more than capacity bytes past the tail.
+  [[nodiscard]] bool corrupt() const noexcept { return corrupt_; }
+
+  /// @brief Mapping the reader works on.
+  [[nodiscard]] const RingMapping& mapping() const noexcept { return mapping_; }
+
+ private:
+  RingMapping mapping_;
+  bool corrupt_ = false;
+};
+
+}  // namespace procly::shm
+
+#endif
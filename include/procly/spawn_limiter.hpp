@@ -0,0 +1,119 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+
+namespace procly {
+
+class Backend;
+class ScopedBackend;
+
+/// @brief What a spawn does when the limiter cannot admit it right away.
+enum class Admission : std::uint8_t {
+  /// @brief Queue until admitted (or until SpawnLimiterOptions::max_wait passes).
+  block,
+  /// @brief Fail at once with std::errc::resource_unavailable_try_again.
+  fail_fast,
+};
+
+/// @brief Queue order of spawns waiting for admission; higher goes first.
+enum class SpawnPriority : std::uint8_t {
+  /// @brief Admitted only when no normal or high spawn is waiting.
+  low,
+  /// @brief Default priority.
+  normal,
+  /// @brief Admitted before any waiting normal or low spawn.
+  high,
+};
+
+/// @brief Limits enforced by a SpawnLimiter.
+struct SpawnLimiterOptions {
+  /// @brief Maximum children spawned through the limiter and not yet reaped; 0 = no limit.
+  std::size_t max_live = 0;
+  /// @brief Sustained spawn rate; 0 = no limit.
+  std::size_t spawns_per_second = 0;
+  /// @brief Spawns allowed back to back before the rate applies; 0 = spawns_per_second.
+  std::size_t burst = 0;
+  /// @brief Behavior when a spawn cannot be admitted immediately.
+  Admission admission = Admission::block;
+  /// @brief Longest a blocked spawn waits before failing with errc::timeout.
+  std::optional<std::chrono::milliseconds> max_wait;
+  /// @brief Blocked spawns allowed at once; later ones fail fast. 0 = no limit.
+  std::size_t max_queued = 0;
+};
+
+/// @brief Counters describing a SpawnLimiter; a consistent snapshot.
+struct SpawnLimiterStats {
+  /// @brief Children admitted and not yet reaped.
+  std::size_t live = 0;
+  /// @brief Spawns currently waiting for admission.
+  std::size_t queued = 0;
+  /// @brief Largest queue depth seen.
+  std::size_t peak_queued = 0;
+  /// @brief Spawns admitted in total.
+  std::uint64_t admitted = 0;
+  /// @brief Spawns refused (fail-fast, full queue or max_wait).
+  std::uint64_t rejected = 0;
+};
+
+/// @brief Admission control in front of another Backend, to avoid fork storms.
+///
+/// Every spawn through the limiter first waits for a live slot (max_live)
+/// and a rate token (spawns_per_second with burst), in priority order and
+/// FIFO within a priority. A slot is returned when the child is reaped by
+/// wait()/try_wait(), when a child whose last handle was dropped unreaped
+/// exits (watched on a background thread through the inner backend's exit
+/// handle, or released at once when it has none), or when the spawn itself
+/// fails; a token is spent on every admitted attempt.
+///
+/// Select it per thread with Scope, or per Command/Pipeline with backend();
+/// run_all() and Reactor use whatever backend their commands resolve to. A
+/// blocking limiter must not be shared with a run_all() whose concurrency
+/// exceeds max_live: the reaping that frees slots runs on the blocked thread.
+/// The SpawnLimiter must outlive every child spawned through it.
+class SpawnLimiter {
+ public:
+  /// @brief Opaque implementation state.
+  struct Impl;
+
+  /// @brief Routes spawns on the calling thread through a limiter while alive.
+  class Scope {
+   public:
+    /// @brief Install the limiter, at priority, as the backend for this thread.
+    explicit Scope(SpawnLimiter& limiter, SpawnPriority priority = SpawnPriority::normal);
+    /// @brief Restore the previous backend.
+    ~Scope();
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+   private:
+    /// @brief Backend override restored on destruction.
+    std::unique_ptr<ScopedBackend> override_;
+  };
+
+  /// @brief Limit spawns made through inner (the thread's default backend when null).
+  explicit SpawnLimiter(SpawnLimiterOptions options = {}, Backend* inner = nullptr);
+
+  /// @brief Move-construct a limiter handle.
+  SpawnLimiter(SpawnLimiter&& other) noexcept;
+  /// @brief Move-assign a limiter handle.
+  SpawnLimiter& operator=(SpawnLimiter&& other) noexcept;
+  SpawnLimiter(const SpawnLimiter&) = delete;
+  SpawnLimiter& operator=(const SpawnLimiter&) = delete;
+  /// @brief Destroy the limiter; spawns must no longer be waiting in it.
+  ~SpawnLimiter();
+
+  /// @brief The limiter as a Backend admitting at priority, for Command::backend().
+  [[nodiscard]] Backend& backend(SpawnPriority priority = SpawnPriority::normal) noexcept;
+  /// @brief Current queue depth, live count and totals.
+  [[nodiscard]] SpawnLimiterStats stats() const;
+
+ private:
+  /// @brief Owned implementation state.
+  std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace procly
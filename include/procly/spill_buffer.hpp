@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+#include "procly/mapped_buffer.hpp"
+#include "procly/status.hpp"
+
+namespace procly {
+
+namespace internal {
+class SpillWriter;
+}  // namespace internal
+
+/// @brief Captured output kept in memory up to a threshold, in a temporary file beyond it.
+///
+/// Small captures are a plain string. Once a stream outgrows the threshold
+/// everything captured so far moves to an unlinked file in the temporary
+/// directory ($TMPDIR) and the rest is appended there; the file is mapped
+/// read-only when capture ends. The accessors are the same either way.
+/// Move-only.
+class SpillBuffer {
+ public:
+  /// @brief Construct an empty buffer.
+  SpillBuffer() = default;
+
+  /// @brief Number of captured bytes.
+  [[nodiscard]] std::size_t size() const noexcept { return view().size(); }
+  /// @brief True when nothing was captured.
+  [[nodiscard]] bool empty() const noexcept { return size() == 0; }
+  /// @brief True when the capture outgrew memory and lives in a mapped file.
+  [[nodiscard]] bool spilled() const noexcept { return spilled_; }
+  /// @brief Contiguous view of every captured byte (the mapping when spilled).
+  [[nodiscard]] std::string_view view() const noexcept {
+    return spilled_ ? mapped_.view() : std::string_view(memory_);
+  }
+  /// @brief Copy up to count bytes starting at offset into out; returns the number copied.
+  std::size_t read(std::size_t offset, char* out, std::size_t count) const noexcept;
+  /// @brief Copy the capture into a string.
+  [[nodiscard]] std::string to_string() const { return std::string(view()); }
+
+ private:
+  friend class internal::SpillWriter;
+
+  /// @brief Bytes captured in memory (unused once spilled).
+  std::string memory_;
+  /// @brief Read-only mapping of the spill file.
+  MappedBuffer mapped_;
+  /// @brief Whether mapped_ holds the capture.
+  bool spilled_ = false;
+};
+
+/// @brief Output captured into spill buffers.
+struct SpillOutput {
+  /// @brief Exit status for the process.
+  ExitStatus status;
+  /// @brief Captured stdout.
+  SpillBuffer stdout_data;
+  /// @brief Captured stderr.
+  SpillBuffer stderr_data;
+};
+
+}  // namespace procly
@@ -1,9 +1,13 @@
 #pragma once
 
+#include <chrono>
+#include <cstddef>
 #include <cstdint>
 #include <optional>
 #include <string>
 
+#include "procly/digest.hpp"
+
 namespace procly {
 
 /// @brief Portable process exit status.
@@ -37,6 +41,49 @@ class ExitStatus {
   std::uint32_t native_{0};
 };
 
+/// @brief Resources consumed by a reaped process.
+///
+/// Collected by wait4() when the process is reaped, so CPU time, faults and
+/// context switches include descendants the process itself waited for.
+struct ResourceUsage {
+  /// @brief CPU time spent in user mode.
+  std::chrono::microseconds user_time{0};
+  /// @brief CPU time spent in the kernel.
+  std::chrono::microseconds system_time{0};
+  /// @brief Time from spawn until the process was reaped.
+  std::chrono::nanoseconds wall_time{0};
+  /// @brief Peak resident set size in bytes.
+  std::uint64_t max_rss_bytes = 0;
+  /// @brief Page faults served without I/O.
+  std::uint64_t minor_faults = 0;
+  /// @brief Page faults that required I/O.
+  std::uint64_t major_faults = 0;
+  /// @brief Context switches from blocking on a resource.
+  std::uint64_t voluntary_context_switches = 0;
+  /// @brief Context switches from preemption.
+  std::uint64_t involuntary_context_switches = 0;
+};
+
+/// @brief Point-in-time resource use of a running process (Child::sample()).
+struct ResourceSample {
+  /// @brief CPU time spent in user mode so far.
+  std::chrono::microseconds user_time{0};
+  /// @brief CPU time spent in the kernel so far.
+  std::chrono::microseconds system_time{0};
+  /// @brief Current resident set size in bytes.
+  std::uint64_t rss_bytes = 0;
+  /// @brief Current number of threads.
+  std::uint32_t threads = 0;
+};
+
+/// @brief ResourceSample of one process, as returned for pipelines and Reactor::sample_all().
+struct ProcessSample {
+  /// @brief Process identifier.
+  int pid = -1;
+  /// @brief Resource use at the time of sampling.
+  ResourceSample sample;
+};
+
 /// @brief Captured output from a process.
 struct Output {
   /// @brief Exit status for the process.
@@ -45,6 +92,48 @@ struct Output {
   std::string stdout_data;
   /// @brief Captured stderr data.
   std::string stderr_data;
+  /// @brief Bytes of stdout discarded by a capture limit.
+  std::size_t stdout_dropped = 0;
+  /// @brief Bytes of stderr discarded by a capture limit.
+  std::size_t stderr_dropped = 0;
+  /// @brief Hex digest of every byte written to stdout, when requested.
+  std::optional<std::string> stdout_digest;
+  /// @brief Hex digest of every byte written to stderr, when requested.
+  std::optional<std::string> stderr_digest;
+};
+
+/// @brief What capture does once a stream reaches its byte limit.
+enum class OverflowPolicy : std::uint8_t {
+  /// @brief Keep the first max_bytes and discard the rest.
+  keep_head,
+  /// @brief Keep the last max_bytes (ring buffer).
+  keep_tail,
+  /// @brief Keep the first max_bytes and kill the child.
+  kill,
+};
+
+/// @brief Byte cap for one captured stream.
+struct CaptureLimit {
+  /// @brief Maximum bytes retained.
+  std::size_t max_bytes = 0;
+  /// @brief Behavior once max_bytes is reached.
+  OverflowPolicy policy = OverflowPolicy::keep_head;
+};
+
+/// @brief Per-stream capture configuration for output().
+struct CaptureOptions {
+  /// @brief Limit for stdout; empty means unbounded.
+  std::optional<CaptureLimit> stdout_limit;
+  /// @brief Limit for stderr; empty means unbounded.
+  std::optional<CaptureLimit> stderr_limit;
+  /// @brief Expected stdout size, reserved up front to avoid regrowth.
+  std::size_t stdout_size_hint = 0;
+  /// @brief Expected stderr size, reserved up front to avoid regrowth.
+  std::size_t stderr_size_hint = 0;
+  /// @brief Digest computed over all of stdout while it drains, including dropped bytes.
+  std::optional<DigestAlgorithm> stdout_digest;
+  /// @brief Digest computed over all of stderr while it drains, including dropped bytes.
+  std::optional<DigestAlgorithm> stderr_digest;
 };
 
 }  // namespace procly
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <string>
+
+namespace procly {
+
+/// @brief Producer of child input, pulled by the drain loop as stdin has room.
+///
+/// The drain loop asks for the next chunk only once the previous one is fully
+/// written and the pipe is still writable, so a slow child throttles the
+/// producer and at most one chunk is held at a time. The callbacks run on the
+/// thread that drains, between reads of stdout and stderr; a callback that
+/// blocks stalls capture too. A default-constructed source is empty input.
+class StdinSource {
+ public:
+  /// @brief Callback writing up to capacity bytes into data; returns the count, 0 at end of input.
+  using FillCallback = std::function<std::size_t(char* data, std::size_t capacity)>;
+  /// @brief Callback returning the next chunk, or nullopt at end of input.
+  using ChunkCallback = std::function<std::optional<std::string>()>;
+
+  /// @brief Bytes offered to a FillCallback per call.
+  static constexpr std::size_t kFillBytes = 64 * 1024;
+
+  /// @brief Construct a source with no input.
+  StdinSource() = default;
+
+  /// @brief Pull input by letting on_fill write into the drain loop's buffer.
+  static StdinSource fill(FillCallback on_fill);
+  /// @brief Pull input as whole chunks; empty chunks are skipped.
+  static StdinSource chunks(ChunkCallback next_chunk);
+
+  /// @brief Replace chunk with the next non-empty piece of input; false at end of input.
+  bool next(std::string& chunk);
+
+ private:
+  /// @brief Fill producer (empty unless created with fill()).
+  FillCallback on_fill_;
+  /// @brief Chunk producer (empty unless created with chunks()).
+  ChunkCallback next_chunk_;
+};
+
+}  // namespace procly
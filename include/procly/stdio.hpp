@@ -1,8 +1,13 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <filesystem>
+#include <memory>
 #include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
 #include <variant>
 
 #include "procly/platform.hpp"
@@ -49,17 +54,27 @@ struct Stdio {
   /// @brief Attach to null device.
   struct Null {};
   /// @brief Create a pipe and expose the parent end.
-  struct Piped {};
+  struct Piped {
+    /// @brief Requested pipe capacity in bytes (0 keeps the system default).
+    std::size_t capacity = 0;
+  };
   /// @brief Duplicate an existing file descriptor (POSIX).
   struct Fd {
     /// @brief Native file descriptor to duplicate.
     int fd;
+    /// @brief Keeps fd open while this Stdio is alive (SharedFile); empty for borrowed fds.
+    std::shared_ptr<const void> owner;
   };
   /// @brief Open a file path for redirection.
   using File = FileSpec;
+  /// @brief Feed stdin from an in-memory buffer through a sealed file (stdin only).
+  struct Bytes {
+    /// @brief Shared, immutable payload.
+    std::shared_ptr<const std::string> data;
+  };
 
   /// @brief Variant holding the stdio selection.
-  std::variant<Inherit, Null, Piped, Fd, File> value;
+  std::variant<Inherit, Null, Piped, Fd, File, Bytes> value;
 
   /// @brief Inherit the parent's stream.
   static Stdio inherit() { return Stdio{Inherit{}}; }
@@ -67,8 +82,13 @@ struct Stdio {
   static Stdio null() { return Stdio{Null{}}; }
   /// @brief Create a pipe.
   static Stdio piped() { return Stdio{Piped{}}; }
+  /// @brief Create a pipe with the given capacity.
+  ///
+  /// Applied with F_SETPIPE_SZ on Linux, clamped to /proc/sys/fs/pipe-max-size;
+  /// ignored on other platforms.
+  static Stdio piped(std::size_t capacity) { return Stdio{Piped{capacity}}; }
   /// @brief Duplicate a file descriptor (POSIX).
-  static Stdio fd(int fd) { return Stdio{Fd{fd}}; }
+  static Stdio fd(int fd) { return Stdio{Fd{.fd = fd}}; }
   /// @brief Redirect to a file path.
   static Stdio file(std::filesystem::path path) { return Stdio{FileSpec{.path = std::move(path)}}; }
   /// @brief Redirect to a file path with an explicit open mode.
@@ -77,6 +97,17 @@ struct Stdio {
   }
   /// @brief Redirect to a file path with full specification.
   static Stdio file(FileSpec spec) { return Stdio{std::move(spec)}; }
+  /// @brief Feed stdin from a copy of data.
+  ///
+  /// Each spawn writes the bytes once into a sealed memfd (an unlinked temporary file off
+  /// Linux) and hands the child a seekable descriptor, so no writer thread is needed.
+  static Stdio bytes(std::string_view data) {
+    return Stdio{Bytes{std::make_shared<const std::string>(data)}};
+  }
+  /// @brief Feed stdin from a shared buffer without copying it.
+  static Stdio bytes(std::shared_ptr<const std::string> data) {
+    return Stdio{Bytes{std::move(data)}};
+  }
 #if PROCLY_PLATFORM_POSIX
   /// @brief Redirect to a file path with explicit mode and permissions (POSIX only).
   static Stdio file(std::filesystem::path path, OpenMode mode, FilePerms perms) {
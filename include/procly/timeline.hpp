@@ -0,0 +1,56 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "procly/status.hpp"
+
+namespace procly {
+
+/// @brief Which captured stream a chunk came from.
+enum class OutputStream : std::uint8_t {
+  /// @brief The child's stdout.
+  out,
+  /// @brief The child's stderr.
+  err,
+};
+
+/// @brief One chunk read from stdout or stderr.
+struct TimelineRecord {
+  /// @brief When the drain loop read the chunk.
+  std::chrono::steady_clock::time_point at;
+  /// @brief Offset of the chunk in TimelineOutput::data.
+  std::uint64_t offset = 0;
+  /// @brief Chunk length in bytes.
+  std::uint32_t size = 0;
+  /// @brief Stream the chunk was read from.
+  OutputStream stream = OutputStream::out;
+};
+
+/// @brief stdout and stderr captured into one buffer, with the order and time of every read.
+///
+/// data holds every byte of both streams in the order the drain loop read
+/// them; records describe each chunk, so the true interleaving costs one
+/// record per read on top of the bytes. Writes that land in both pipes
+/// between two polls are read stdout first, so ordering is as fine as the
+/// reads, not the writes.
+struct TimelineOutput {
+  /// @brief Exit status for the process.
+  ExitStatus status;
+  /// @brief Bytes of both streams in read order.
+  std::string data;
+  /// @brief One record per chunk, in read order.
+  std::vector<TimelineRecord> records;
+
+  /// @brief Bytes of one record.
+  [[nodiscard]] std::string_view bytes(const TimelineRecord& record) const noexcept {
+    return std::string_view(data).substr(record.offset, record.size);
+  }
+  /// @brief Every byte of one stream, in order.
+  [[nodiscard]] std::string stream_data(OutputStream stream) const;
+};
+
+}  // namespace procly
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <optional>
+#include <vector>
+
+#include "procly/child.hpp"
+#include "procly/pipeline.hpp"
+#include "procly/platform.hpp"
+#include "procly/result.hpp"
+
+#if PROCLY_HAS_STD_SPAN
+#include <span>
+#endif
+
+namespace procly {
+
+/// @brief The child wait_any() saw finish.
+struct WaitAnyResult {
+  /// @brief Position of the child in the set passed to wait_any().
+  std::size_t index = 0;
+  /// @brief Its final status; the child is reaped.
+  WaitResult result;
+};
+
+/// @brief The pipeline wait_any() saw finish.
+struct PipelineWaitAnyResult {
+  /// @brief Position of the pipeline in the set passed to wait_any().
+  std::size_t index = 0;
+  /// @brief Its final status; every stage is reaped.
+  PipelineStatus status;
+};
+
+/// @brief Block until one of children exits, or timeout elapses (empty result).
+///
+/// Blocks on every child's exit_handle() at once (one epoll/kqueue set);
+/// backends without exit handles are polled with try_wait(). Children that
+/// have already finished, including ones waited on before, are reported
+/// first, lowest index first, so drop each reported child from the set
+/// before the next call. Null entries are skipped. Nothing is signalled on
+/// timeout.
+[[nodiscard]] Result<std::optional<WaitAnyResult>> wait_any(
+    Child* const* children, std::size_t count,
+    std::optional<std::chrono::milliseconds> timeout = std::nullopt);
+/// @brief Wait for every child, applying options.timeout to the whole set.
+///
+/// Children still running when the timeout elapses are terminated, then
+/// killed after options.kill_grace, and their results are flagged like
+/// Child::wait(WaitOptions). Results are in input order; null entries yield a
+/// default WaitResult.
+[[nodiscard]] Result<std::vector<WaitResult>> wait_all(Child* const* children, std::size_t count,
+                                                       WaitOptions options = {});
+/// @brief Pipeline overload of wait_any(); a pipeline finishes when all its stages have.
+[[nodiscard]] Result<std::optional<PipelineWaitAnyResult>> wait_any(
+    PipelineChild* const* pipelines, std::size_t count,
+    std::optional<std::chrono::milliseconds> timeout = std::nullopt);
+/// @brief Pipeline overload of wait_all(); escalation signals every stage of a late pipeline.
+[[nodiscard]] Result<std::vector<PipelineWaitResult>> wait_all(PipelineChild* const* pipelines,
+                                                               std::size_t count,
+                                                               WaitOptions options = {});
+
+#if PROCLY_HAS_STD_SPAN
+/// @brief Span overload of wait_any().
+[[nodiscard]] Result<std::optional<WaitAnyResult>> wait_any(
+    std::span<Child* const> children,
+    std::optional<std::chrono::milliseconds> timeout = std::nullopt);
+/// @brief Span overload of wait_all().
+[[nodiscard]] Result<std::vector<WaitResult>> wait_all(std::span<Child* const> children,
+                                                       WaitOptions options = {});
+/// @brief Span overload of the pipeline wait_any().
+[[nodiscard]] Result<std::optional<PipelineWaitAnyResult>> wait_any(
+    std::span<PipelineChild* const> pipelines,
+    std::optional<std::chrono::milliseconds> timeout = std::nullopt);
+/// @brief Span overload of the pipeline wait_all().
+[[nodiscard]] Result<std::vector<PipelineWaitResult>> wait_all(
+    std::span<PipelineChild* const> pipelines, WaitOptions options = {});
+#endif
+
+}  // namespace procly
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "procly/child.hpp"
+#include "procly/command.hpp"
+#include "procly/result.hpp"
+
+namespace procly {
+
+/// @brief How requests and responses are delimited on a worker's stdin/stdout.
+enum class WorkerFraming : std::uint8_t {
+  /// @brief One request per line; the response is the next line of output.
+  ///
+  /// Requests must not contain '\n'; the delimiter is stripped from responses.
+  newline,
+  /// @brief A 4-byte big-endian payload length, then the payload, in both directions.
+  length_prefixed,
+};
+
+/// @brief Configuration for WorkerPool::start.
+struct WorkerPoolOptions {
+  /// @brief Number of warm workers kept alive.
+  std::size_t workers = 1;
+  /// @brief Request/response framing.
+  WorkerFraming framing = WorkerFraming::newline;
+  /// @brief Optional per-request timeout, covering both writing and the response.
+  std::optional<std::chrono::milliseconds> request_timeout;
+  /// @brief Grace period after terminate before kill when a worker is retired.
+  std::chrono::milliseconds kill_grace{WaitOptions::kDefaultKillGrace};
+  /// @brief Largest accepted response payload; empty means unbounded.
+  std::optional<std::size_t> max_response_bytes;
+};
+
+/// @brief Pool of pre-spawned workers that answer framed requests over pipes.
+///
+/// Each worker is the pool's Command spawned with piped stdin and stdout
+/// (stderr keeps the command's setting) and serves one request at a time.
+/// A worker that times out, breaks the framing or exits is retired with the
+/// usual terminate/kill escalation and replaced, and that call fails; crashed
+/// idle workers are replaced before they get a request.
+///
+/// call() is safe to use from many threads at once; each call blocks until a
+/// worker is free. The pool must not be destroyed while calls are in flight.
+class WorkerPool {
+ public:
+  /// @brief Opaque shared state.
+  struct Impl;
+
+  /// @brief Spawn options.workers copies of command and keep them warm.
+  static Result<WorkerPool> start(Command command, WorkerPoolOptions options = {});
+
+  /// @brief Move-construct a pool.
+  WorkerPool(WorkerPool&& other) noexcept;
+  /// @brief Move-assign a pool.
+  WorkerPool& operator=(WorkerPool&& other) noexcept;
+  WorkerPool(const WorkerPool&) = delete;
+  WorkerPool& operator=(const WorkerPool&) = delete;
+  /// @brief Close every worker's stdin, then reap it, escalating after kill_grace.
+  ~WorkerPool();
+
+  /// @brief Send request to a free worker and return its response.
+  [[nodiscard]] Result<std::string> call(std::string_view request);
+
+  /// @brief Number of worker slots.
+  [[nodiscard]] std::size_t size() const noexcept;
+  /// @brief Workers replaced so far because they failed or exited.
+  [[nodiscard]] std::uint64_t restarts() const noexcept;
+
+ private:
+  explicit WorkerPool(std::unique_ptr<Impl> impl) noexcept;
+
+  /// @brief Owned implementation state.
+  std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace procly
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "procly/platform.hpp"
+
+#if PROCLY_PLATFORM_POSIX
+
+#include <chrono>
+#include <memory>
+
+#include "procly/child.hpp"
+#include "procly/command.hpp"
+#include "procly/result.hpp"
+#include "procly/status.hpp"
+#include "procly/stdio.hpp"
+
+namespace procly {
+
+/// @brief Pre-initialized template process that forks ready-to-work copies of itself.
+///
+/// start() spawns the template Command with its stdin replaced by a control
+/// socket and waits until the program calls procly::zygote::serve() (see
+/// zygote_serve.hpp), which marks the end of its expensive initialization.
+/// Each fork() then asks the template to fork a copy that continues from
+/// serve() with fresh standard streams passed over the socket, skipping the
+/// initialization. Copies come back as ordinary Child handles: wait, kill and
+/// exit handles are routed through the template, which reaps them.
+///
+/// The Zygote must outlive every Child it forked. Destroying it closes the
+/// socket, the template exits, and copies still running are left running.
+class Zygote {
+ public:
+  /// @brief Opaque implementation (the backend forked copies belong to).
+  struct Impl;
+
+  /// @brief Spawn command as the template and wait until it is ready.
+  ///
+  /// Fails with errc::timeout, killing the template, when it does not call
+  /// serve() within ready_timeout, and with errc::spawn_failed when it exits first.
+  [[nodiscard]] static Result<Zygote> start(Command command,
+                                            std::chrono::milliseconds ready_timeout =
+                                                std::chrono::seconds(30));
+
+  /// @brief Move-construct a zygote handle.
+  Zygote(Zygote&& other) noexcept;
+  /// @brief Move-assign a zygote handle.
+  Zygote& operator=(Zygote&& other) noexcept;
+  Zygote(const Zygote&) = delete;
+  Zygote& operator=(const Zygote&) = delete;
+  /// @brief Shut the template down and reap it.
+  ~Zygote();
+
+  /// @brief Fork a copy with the given standard streams.
+  ///
+  /// Stdio::inherit() keeps the template's stream (the template's stdin is
+  /// /dev/null once serve() runs). Piped streams come back on the Child.
+  [[nodiscard]] Result<Child> fork(const Stdio& stdin_cfg = Stdio::null(),
+                                   const Stdio& stdout_cfg = Stdio::inherit(),
+                                   const Stdio& stderr_cfg = Stdio::inherit());
+  /// @brief Fork a copy with piped stdout and stderr, capture both, and wait.
+  [[nodiscard]] Result<Output> output(const Stdio& stdin_cfg = Stdio::null());
+
+  /// @brief Process identifier of the template.
+  [[nodiscard]] int id() const noexcept;
+
+ private:
+  explicit Zygote(std::unique_ptr<Impl> impl) noexcept;
+
+  /// @brief Owned implementation state.
+  std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace procly
+
+#endif
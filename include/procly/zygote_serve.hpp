@@ -0,0 +1,357 @@
+#pragma once
+
+#include "procly/platform.hpp"
+
+#if PROCLY_PLATFORM_POSIX
+
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <array>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <unordered_set>
+
+/// @file
+/// @brief Template side of procly::Zygote; header-only so the template needs no procly library.
+///
+/// A program started by Zygote::start() runs its expensive initialization and
+/// then calls procly::zygote::serve(). serve() reports readiness to the parent
+/// and forks a copy of the warmed process for every request; it returns true in
+/// each copy, whose standard streams are then the descriptors the parent sent.
+/// Started any other way, serve() returns false at once and the program can do
+/// the work itself.
+
+namespace procly::zygote {
+
+/// @brief Environment variable naming the template's control socket descriptor.
+inline constexpr const char* kControlFdEnv = "PROCLY_ZYGOTE_FD";
+
+/// @brief Frame kinds on the control socket.
+enum class FrameType : std::uint32_t {
+  /// @brief Template -> parent: initialization finished.
+  ready = 1,
+  /// @brief Parent -> template: fork a copy; stdio descriptors ride along.
+  fork,
+  /// @brief Template -> parent: pid of the copy, or errno.
+  fork_reply,
+  /// @brief Parent -> template: send signal `value` to copy `pid`.
+  signal,
+  /// @brief Template -> parent: errno of the signal request, 0 on success.
+  signal_reply,
+  /// @brief Template -> parent: copy `pid` exited with wait status `value`.
+  exited,
+};
+
+/// @brief Fork flag: the copy's stdin arrives as a descriptor.
+inline constexpr std::uint32_t kForkStdin = 1U << 0;
+/// @brief Fork flag: the copy's stdout arrives as a descriptor.
+inline constexpr std::uint32_t kForkStdout = 1U << 1;
+/// @brief Fork flag: the copy's stderr arrives as a descriptor.
+inline constexpr std::uint32_t kForkStderr = 1U << 2;
+/// @brief Fork flag: the copy's stderr duplicates its stdout.
+inline constexpr std::uint32_t kForkStderrToStdout = 1U << 3;
+
+/// @brief Most descriptors carried by one frame.
+inline constexpr std::size_t kMaxFrameFds = 3;
+
+/// @brief Fixed-size control frame; both ends run on one host, so fields use native byte order.
+struct Frame {
+  /// @brief FrameType value.
+  std::uint32_t type;
+  /// @brief kFork* flags (fork), in the order the descriptors are attached.
+  std::uint32_t flags;
+  /// @brief Request id, echoed in the reply.
+  std::uint64_t id;
+  /// @brief Process id of a copy.
+  std::int32_t pid;
+  /// @brief Signal number, errno, or wait status, depending on type.
+  std::int32_t value;
+};
+
+namespace detail {
+
+#if defined(MSG_NOSIGNAL)
+inline constexpr int kSendFlags = MSG_NOSIGNAL;
+#else
+inline constexpr int kSendFlags = 0;
+#endif
+
+inline int& sigchld_write_fd() {
+  static int fd = -1;
+  return fd;
+}
+
+inline void on_sigchld(int /*signo*/) {
+  int saved_errno = errno;
+  char byte = 0;
+  (void)::write(sigchld_write_fd(), &byte, 1);
+  errno = saved_errno;
+}
+
+inline Frame make_frame(FrameType type, std::uint64_t id, std::int32_t pid, std::int32_t value) {
+  Frame frame{};
+  frame.type = static_cast<std::uint32_t>(type);
+  frame.id = id;
+  frame.pid = pid;
+  frame.value = value;
+  return frame;
+}
+
+/// Send frame with up to kMaxFrameFds descriptors; false with errno set on failure.
+inline bool send_frame(int socket, const Frame& frame, const int* fds, std::size_t count) {
+  if (count > kMaxFrameFds) {
+    errno = EINVAL;
+    return false;
+  }
+  const auto* bytes = reinterpret_cast<const char*>(&frame);
+  iovec iov{};
+  iov.iov_base = const_cast<char*>(bytes);
+  iov.iov_len = sizeof(frame);
+  alignas(cmsghdr) std::array<char, CMSG_SPACE(sizeof(int) * kMaxFrameFds)> control{};
+  msghdr msg{};
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  if (count > 0) {
+    msg.msg_control = control.data();
+    msg.msg_controllen = CMSG_SPACE(sizeof(int) * count);
+    cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int) * count);
+    std::memcpy(CMSG_DATA(cmsg), fds, sizeof(int) * count);
+  }
+  std::size_t done = 0;
+  while (done < sizeof(frame)) {
+    ssize_t sent = ::sendmsg(socket, &msg, kSendFlags);
+    if (sent == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    // The descriptors went with the first chunk.
+    done += static_cast<std::size_t>(sent);
+    iov.iov_base = const_cast<char*>(bytes + done);
+    iov.iov_len = sizeof(frame) - done;
+    msg.msg_control = nullptr;
+    msg.msg_controllen = 0;
+  }
+  return true;
+}
+
+/// Receive one frame and its descriptors; false on EOF or error, with nothing left open.
+inline bool recv_frame(int socket, Frame* frame, std::array<int, kMaxFrameFds>* fds,
+                       std::size_t* count) {
+  *count = 0;
+  auto* bytes = reinterpret_cast<char*>(frame);
+  std::size_t done = 0;
+  while (done < sizeof(Frame)) {
+    iovec iov{};
+    iov.iov_base = bytes + done;
+    iov.iov_len = sizeof(Frame) - done;
+    alignas(cmsghdr) std::array<char, CMSG_SPACE(sizeof(int) * kMaxFrameFds)> control{};
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.data();
+    msg.msg_controllen = control.size();
+    ssize_t got = ::recvmsg(socket, &msg, 0);
+    if (got == -1 && errno == EINTR) {
+      continue;
+    }
+    for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); got > 0 && cmsg != nullptr;
+         cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+      if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) {
+        continue;
+      }
+      std::size_t received = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+      for (std::size_t index = 0; index < received; ++index) {
+        int fd = -1;
+        std::memcpy(&fd, CMSG_DATA(cmsg) + index * sizeof(int), sizeof(int));
+        ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+        if (*count < kMaxFrameFds) {
+          (*fds)[(*count)++] = fd;
+        } else {
+          ::close(fd);
+        }
+      }
+    }
+    if (got <= 0) {
+      for (std::size_t index = 0; index < *count; ++index) {
+        ::close((*fds)[index]);
+      }
+      *count = 0;
+      return false;
+    }
+    done += static_cast<std::size_t>(got);
+  }
+  return true;
+}
+
+// In a fresh copy: install the passed descriptors as stdio. Returns false if dup2 fails.
+inline bool install_stdio(std::uint32_t flags, const std::array<int, kMaxFrameFds>& fds,
+                          std::size_t count) {
+  std::size_t next = 0;
+  bool ok = true;
+  for (int target = STDIN_FILENO; target <= STDERR_FILENO; ++target) {
+    if ((flags & (1U << target)) != 0 && next < count) {
+      ok = ok && ::dup2(fds[next++], target) != -1;
+    }
+  }
+  if ((flags & kForkStderrToStdout) != 0) {
+    ok = ok && ::dup2(STDOUT_FILENO, STDERR_FILENO) != -1;
+  }
+  for (std::size_t index = 0; index < count; ++index) {
+    if (fds[index] > STDERR_FILENO) {
+      ::close(fds[index]);
+    }
+  }
+  return ok;
+}
+
+}  // namespace detail
+
+/// @brief Serve fork requests from procly::Zygote until it goes away.
+///
+/// Returns false immediately when the process was not started by Zygote.
+/// Otherwise it never returns in the template, which exits once the Zygote is
+/// destroyed, and returns true in each forked copy with SIGCHLD handling and
+/// the signal mask restored. Only the calling thread is copied, so call it
+/// before starting threads. The template's stdin is the control socket until
+/// serve() runs; do not read stdin during initialization.
+inline bool serve() {
+  const char* control = std::getenv(kControlFdEnv);
+  if (control == nullptr) {
+    return false;
+  }
+  int inherited = std::atoi(control);
+  ::unsetenv(kControlFdEnv);
+  int socket = ::fcntl(inherited, F_DUPFD_CLOEXEC, STDERR_FILENO + 1);
+  if (socket == -1) {
+    std::_Exit(EXIT_FAILURE);
+  }
+  // Copies whose stdin is not replaced read /dev/null, never the control socket.
+  int null_fd = ::open("/dev/null", O_RDWR);
+  if (null_fd == -1 || ::dup2(null_fd, inherited) == -1) {
+    std::_Exit(EXIT_FAILURE);
+  }
+  if (null_fd != inherited) {
+    ::close(null_fd);
+  }
+
+  std::array<int, 2> wake{-1, -1};
+  if (::pipe(wake.data()) == -1) {
+    std::_Exit(EXIT_FAILURE);
+  }
+  for (int fd : wake) {
+    ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+    ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+  }
+  detail::sigchld_write_fd() = wake[1];
+  struct sigaction action {};
+  struct sigaction previous_action {};
+  action.sa_handler = detail::on_sigchld;
+  sigemptyset(&action.sa_mask);
+  action.sa_flags = SA_RESTART | SA_NOCLDSTOP;
+  ::sigaction(SIGCHLD, &action, &previous_action);
+  sigset_t unblock;
+  sigset_t previous_mask;
+  sigemptyset(&unblock);
+  sigaddset(&unblock, SIGCHLD);
+  ::sigprocmask(SIG_UNBLOCK, &unblock, &previous_mask);
+
+  if (!detail::send_frame(socket, detail::make_frame(FrameType::ready, 0, 0, 0), nullptr, 0)) {
+    std::_Exit(EXIT_FAILURE);
+  }
+
+  std::unordered_set<pid_t> copies;
+  while (true) {
+    std::array<pollfd, 2> watched{};
+    watched[0].fd = socket;
+    watched[0].events = POLLIN;
+    watched[1].fd = wake[0];
+    watched[1].events = POLLIN;
+    if (::poll(watched.data(), watched.size(), -1) == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      std::_Exit(EXIT_FAILURE);
+    }
+    if (watched[1].revents != 0) {
+      std::array<char, 64> drain{};
+      while (::read(wake[0], drain.data(), drain.size()) > 0) {
+      }
+    }
+    // Reap only copies, so children the template started itself stay its own business.
+    for (auto it = copies.begin(); it != copies.end();) {
+      int status = 0;
+      if (::waitpid(*it, &status, WNOHANG) != *it) {
+        ++it;
+        continue;
+      }
+      if (!detail::send_frame(socket, detail::make_frame(FrameType::exited, 0, *it, status),
+                              nullptr, 0)) {
+        std::_Exit(EXIT_SUCCESS);
+      }
+      it = copies.erase(it);
+    }
+    if (watched[0].revents == 0) {
+      continue;
+    }
+
+    Frame request{};
+    std::array<int, kMaxFrameFds> fds{};
+    std::size_t count = 0;
+    if (!detail::recv_frame(socket, &request, &fds, &count)) {
+      // The Zygote is gone; leftover copies are reparented as usual.
+      std::_Exit(EXIT_SUCCESS);
+    }
+    Frame reply{};
+    if (request.type == static_cast<std::uint32_t>(FrameType::fork)) {
+      pid_t pid = ::fork();
+      if (pid == 0) {
+        ::sigaction(SIGCHLD, &previous_action, nullptr);
+        ::sigprocmask(SIG_SETMASK, &previous_mask, nullptr);
+        ::close(socket);
+        ::close(wake[0]);
+        ::close(wake[1]);
+        if (!detail::install_stdio(request.flags, fds, count)) {
+          std::_Exit(EXIT_FAILURE);
+        }
+        return true;
+      }
+      int error = pid == -1 ? errno : 0;
+      if (pid > 0) {
+        copies.insert(pid);
+      }
+      reply = detail::make_frame(FrameType::fork_reply, request.id, pid, error);
+    } else if (request.type == static_cast<std::uint32_t>(FrameType::signal)) {
+      // Reaped copies are not signalled: their pid may already be reused.
+      int error = 0;
+      if (copies.count(request.pid) != 0 && ::kill(request.pid, request.value) == -1) {
+        error = errno;
+      }
+      reply = detail::make_frame(FrameType::signal_reply, request.id, request.pid, error);
+    } else {
+      std::_Exit(EXIT_FAILURE);
+    }
+    for (std::size_t index = 0; index < count; ++index) {
+      ::close(fds[index]);
+    }
+    if (!detail::send_frame(socket, reply, nullptr, 0)) {
+      std::_Exit(EXIT_SUCCESS);
+    }
+  }
+}
+
+}  // namespace procly::zygote
+
+#endif
@@ -0,0 +1,127 @@
+#include "procly/batch.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "procly/internal/access.hpp"
+#include "procly/internal/command_run.hpp"
+#include "procly/internal/lowering.hpp"
+#include "procly/reactor.hpp"
+
+namespace procly {
+
+namespace {
+
+Output to_output(ChildCompletion completion) {
+  Output output;
+  output.status = completion.wait.status;
+  output.stdout_data = std::move(completion.stdout_data);
+  output.stderr_data = std::move(completion.stderr_data);
+  return output;
+}
+
+}  // namespace
+
+Result<std::vector<Result<Output>>> run_all(const Command* commands, std::size_t count,
+                                            Concurrency concurrency,
+                                            const RunAllOptions& options) {
+  auto reactor = Reactor::create();
+  if (!reactor) {
+    return reactor.error();
+  }
+
+  const std::size_t limit = std::max<std::size_t>(concurrency.limit, 1);
+  std::vector<std::optional<Result<Output>>> results(count);
+  std::size_t next = 0;
+  std::size_t running = 0;
+  bool stopped = false;
+  bool launching = false;
+  // One snapshot of the live environment serves every command that inherits it.
+  std::optional<internal::EnvBlock> live_env;
+
+  WatchOptions watch_options;
+  watch_options.timeout = options.timeout;
+  watch_options.kill_grace = options.kill_grace;
+
+  auto complete = [&](std::size_t index, Result<Output> result) {
+    if (options.fail_fast && (!result || !result->status.success())) {
+      stopped = true;
+    }
+    if (options.on_complete) {
+      options.on_complete(index, result);
+    }
+    results[index].emplace(std::move(result));
+  };
+
+  // Completions re-enter through the reactor callbacks; the outer call keeps launching, so
+  // a run of synchronous spawn failures does not recurse.
+  std::function<void()> launch_more = [&] {
+    if (launching) {
+      return;
+    }
+    launching = true;
+    while (!stopped && running < limit && next < count) {
+      std::size_t index = next++;
+      const Command& command = commands[index];
+      auto lowered =
+          internal::lower_command(command, internal::SpawnMode::output, nullptr, &live_env);
+      if (!lowered) {
+        complete(index, lowered.error());
+        continue;
+      }
+      auto spawned =
+          internal::spawn_lowered(lowered.value(), internal::CommandAccess::backend(command));
+      if (!spawned) {
+        complete(index, spawned.error());
+        continue;
+      }
+      ++running;
+      auto watched =
+          reactor->watch(internal::ChildAccess::from_spawned(std::move(spawned.value())),
+                         watch_options, [&, index](Result<ChildCompletion> completion) {
+                           --running;
+                           if (completion) {
+                             complete(index, to_output(std::move(completion.value())));
+                           } else {
+                             complete(index, completion.error());
+                           }
+                           launch_more();
+                         });
+      if (!watched) {
+        --running;
+        complete(index, watched.error());
+      }
+    }
+    launching = false;
+  };
+
+  launch_more();
+  auto ran = reactor->run();
+  if (!ran) {
+    return ran.error();
+  }
+
+  std::vector<Result<Output>> outputs;
+  outputs.reserve(count);
+  for (auto& result : results) {
+    if (result) {
+      outputs.push_back(std::move(*result));
+    } else {
+      outputs.emplace_back(Error{.code = make_error_code(errc::cancelled), .context = "run_all"});
+    }
+  }
+  return outputs;
+}
+
+#if PROCLY_HAS_STD_SPAN
+Result<std::vector<Result<Output>>> run_all(std::span<const Command> commands,
+                                            Concurrency concurrency,
+                                            const RunAllOptions& options) {
+  return run_all(commands.data(), commands.size(), concurrency, options);
+}
+#endif
+
+}  // namespace procly
@@ -0,0 +1,45 @@
+#include "procly/cancellation.hpp"
+
+#include <atomic>
+#include <mutex>
+
+#include "procly/internal/fd.hpp"
+
+namespace procly {
+
+struct CancellationToken::State {
+  std::atomic<bool> cancelled{false};
+  std::mutex mutex;
+  // cancel() closes the write end, which makes the read end poll readable (EOF) for good.
+  internal::unique_fd read_end;
+  internal::unique_fd write_end;
+};
+
+CancellationToken::CancellationToken() : state_(std::make_shared<State>()) {}
+
+void CancellationToken::cancel() noexcept {
+  state_->cancelled.store(true, std::memory_order_release);
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  state_->write_end.reset(-1);
+}
+
+bool CancellationToken::cancelled() const noexcept {
+  return state_->cancelled.load(std::memory_order_acquire);
+}
+
+Result<int> CancellationToken::wait_handle() const {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  if (!state_->read_end) {
+    auto pipe = internal::create_pipe();
+    if (!pipe) {
+      return pipe.error();
+    }
+    state_->read_end = std::move(pipe->first);
+    if (!cancelled()) {
+      state_->write_end = std::move(pipe->second);
+    }
+  }
+  return state_->read_end.get();
+}
+
+}  // namespace procly
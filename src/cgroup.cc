@@ -0,0 +1,86 @@
+#include "procly/cgroup.hpp"
+
+#if PROCLY_PLATFORM_LINUX
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#include "procly/internal/cgroup.hpp"
+
+namespace procly {
+
+namespace {
+
+// Bound on the destructor's wait for killed processes to leave before rmdir.
+constexpr std::chrono::milliseconds kDestroyWait{1000};
+
+std::atomic<unsigned> next_cgroup_index{0};
+
+}  // namespace
+
+Cgroup::Cgroup(std::filesystem::path path) noexcept : path_(std::move(path)) {}
+
+Result<Cgroup> Cgroup::create(const std::filesystem::path& parent) {
+  constexpr ::mode_t kDirMode = 0755;
+  while (true) {
+    std::filesystem::path path =
+        parent / ("procly-" + std::to_string(::getpid()) + "-" +
+                  std::to_string(next_cgroup_index.fetch_add(1, std::memory_order_relaxed)));
+    if (::mkdir(path.c_str(), kDirMode) == 0) {
+      return Cgroup(std::move(path));
+    }
+    if (errno != EEXIST) {
+      return Error{.code = std::error_code(errno, std::system_category()),
+                   .context = "mkdir(cgroup)"};
+    }
+  }
+}
+
+Cgroup::Cgroup(Cgroup&& other) noexcept : path_(std::exchange(other.path_, {})) {}
+
+Cgroup& Cgroup::operator=(Cgroup&& other) noexcept {
+  if (this != &other) {
+    destroy();
+    path_ = std::exchange(other.path_, {});
+  }
+  return *this;
+}
+
+Cgroup::~Cgroup() { destroy(); }
+
+void Cgroup::destroy() noexcept {
+  if (path_.empty()) {
+    return;
+  }
+  if (kill()) {
+    (void)wait_empty(kDestroyWait);
+  }
+  ::rmdir(path_.c_str());
+  path_.clear();
+}
+
+Result<void> Cgroup::kill() const { return internal::cgroup_kill(path_); }
+
+Result<bool> Cgroup::populated() const { return internal::cgroup_populated(path_); }
+
+Result<void> Cgroup::wait_empty(std::optional<std::chrono::milliseconds> timeout) const {
+  return internal::cgroup_wait_empty(path_, timeout);
+}
+
+Result<void> Cgroup::kill_and_wait(std::optional<std::chrono::milliseconds> timeout) const {
+  auto killed = kill();
+  if (!killed) {
+    return killed;
+  }
+  return wait_empty(timeout);
+}
+
+}  // namespace procly
+
+#endif
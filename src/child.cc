@@ -1,9 +1,25 @@
 #include "procly/child.hpp"
 
+#include <poll.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <memory>
+#include <optional>
+
 #include "procly/internal/access.hpp"
 #include "procly/internal/backend.hpp"
+#include "procly/internal/cgroup.hpp"
 #include "procly/internal/concurrent_use_guard.hpp"
+#include "procly/internal/fd.hpp"
 #include "procly/internal/lowering.hpp"
+#include "procly/internal/proc_sample.hpp"
+#include "procly/internal/wait_policy.hpp"
+#include "procly/reactor.hpp"
 
 namespace procly {
 
@@ -24,6 +40,9 @@ struct Child::Impl {
   std::optional<PipeWriter> stdin_pipe;
   std::optional<PipeReader> stdout_pipe;
   std::optional<PipeReader> stderr_pipe;
+  internal::unique_fd exit_handle;
+  // /proc/<pid>/stat, opened by the first sample().
+  internal::unique_fd stat_fd;
   internal::ConcurrentUseGuard concurrent_use;
 };
 
@@ -50,7 +69,11 @@ Child& Child::operator=(Child&& other) noexcept {
   return *this;
 }
 
-Child::~Child() = default;
+Child::~Child() {
+  if (impl_ && impl_->spawned_.pid > 0 && !impl_->spawned_.terminal_result) {
+    internal::backend_for(impl_->spawned_).abandon(impl_->spawned_);
+  }
+}
 
 namespace internal {
 
@@ -62,6 +85,115 @@ Child ChildAccess::from_spawned(Spawned spawned) {
 
 }  // namespace internal
 
+namespace {
+
+bool is_esrch_error(const Error& error) {
+  return error.code.category() == std::system_category() && error.code.value() == ESRCH;
+}
+
+// Drives Child::wait_async: the wait_with_timeout policy, with every wait parked on the reactor
+// instead of blocking a thread.
+class AsyncWait : public std::enable_shared_from_this<AsyncWait> {
+ public:
+  AsyncWait(Child& child, Reactor& reactor, int exit_handle, WaitOptions options,
+            Async<WaitResult>::Callback done)
+      : child_(child),
+        reactor_(reactor),
+        exit_handle_(exit_handle),
+        options_(options),
+        done_(std::move(done)) {}
+
+  void start() {
+    stage_ = options_.timeout ? Stage::timeout : Stage::final;
+    arm(options_.timeout);
+  }
+
+ private:
+  enum class Stage : std::uint8_t { timeout, grace, final };
+
+  void arm(std::optional<std::chrono::milliseconds> budget) {
+    deadline_.reset();
+    if (budget) {
+      deadline_ = std::chrono::steady_clock::now() + *budget;
+    }
+    auto self = shared_from_this();
+    auto armed = reactor_.when_readable(exit_handle_, budget,
+                                        [self](bool ready) { self->on_event(ready); });
+    if (!armed) {
+      done_(armed.error());
+    }
+  }
+
+  void on_event(bool ready) {
+    auto status = child_.try_wait();
+    if (!status) {
+      done_(status.error());
+      return;
+    }
+    if (status.value().has_value()) {
+      result_.status = *status.value();
+      done_(result_);
+      return;
+    }
+    if (ready || stage_ == Stage::final) {
+      // Spurious wakeup: keep waiting for whatever budget is left.
+      std::optional<std::chrono::milliseconds> budget;
+      if (deadline_) {
+        budget = std::max(std::chrono::ceil<std::chrono::milliseconds>(
+                              *deadline_ - std::chrono::steady_clock::now()),
+                          std::chrono::milliseconds(0));
+      }
+      arm(budget);
+      return;
+    }
+    escalate();
+  }
+
+  void escalate() {
+    if (stage_ == Stage::timeout) {
+      result_.timed_out = true;
+      auto terminated = child_.terminate();
+      if (!terminated) {
+        finish_after_signal_error(terminated.error());
+        return;
+      }
+      result_.sent_terminate = true;
+      stage_ = Stage::grace;
+      arm(options_.kill_grace);
+      return;
+    }
+    auto killed = child_.kill();
+    if (!killed) {
+      finish_after_signal_error(killed.error());
+      return;
+    }
+    result_.sent_kill = true;
+    stage_ = Stage::final;
+    arm(std::nullopt);
+  }
+
+  // ESRCH means the child already exited; wait for the reap instead of failing.
+  void finish_after_signal_error(const Error& error) {
+    if (!is_esrch_error(error)) {
+      done_(error);
+      return;
+    }
+    stage_ = Stage::final;
+    arm(std::nullopt);
+  }
+
+  Child& child_;
+  Reactor& reactor_;
+  int exit_handle_;
+  WaitOptions options_;
+  Async<WaitResult>::Callback done_;
+  Stage stage_ = Stage::final;
+  std::optional<std::chrono::steady_clock::time_point> deadline_;
+  WaitResult result_;
+};
+
+}  // namespace
+
 int Child::id() const noexcept {
   if (!impl_) {
     return -1;
@@ -127,14 +259,124 @@ Result<std::optional<ExitStatus>> Child::try_wait() {
   return internal::backend_for(impl_->spawned_).try_wait(impl_->spawned_);
 }
 
+Result<int> Child::exit_handle() {
+  if (!impl_) {
+    return Error{.code = make_error_code(errc::wait_failed), .context = "exit_handle"};
+  }
+  auto use = impl_->concurrent_use.enter("Child");
+  (void)use;
+  if (!impl_->exit_handle) {
+    auto handle = internal::backend_for(impl_->spawned_).open_exit_handle(impl_->spawned_);
+    if (!handle) {
+      return handle.error();
+    }
+    impl_->exit_handle.reset(handle.value());
+  }
+  return impl_->exit_handle.get();
+}
+
+Result<ResourceSample> Child::sample() {
+  if (!impl_) {
+    return Error{.code = make_error_code(errc::invalid_argument), .context = "sample"};
+  }
+  auto use = impl_->concurrent_use.enter("Child");
+  (void)use;
+  if (impl_->spawned_.terminal_result) {
+    return Error{.code = std::make_error_code(std::errc::no_such_process), .context = "sample"};
+  }
+  if (!impl_->stat_fd) {
+    auto opened = internal::open_proc_stat(impl_->spawned_.pid);
+    if (!opened) {
+      return opened.error();
+    }
+    impl_->stat_fd = std::move(opened.value());
+  }
+  return internal::read_proc_stat(impl_->stat_fd.get());
+}
+
 Result<WaitResult> Child::wait(WaitOptions options) {
   if (!impl_) {
     return Error{.code = make_error_code(errc::wait_failed), .context = "wait"};
   }
   auto use = impl_->concurrent_use.enter("Child");
   (void)use;
-  return internal::backend_for(impl_->spawned_)
-      .wait(impl_->spawned_, options.timeout, options.kill_grace);
+  auto& spawned = impl_->spawned_;
+  auto& backend = internal::backend_for(spawned);
+  if (!options.cancel) {
+    return backend.wait(spawned, options.timeout, options.kill_grace);
+  }
+
+  // The wait_with_timeout policy, sleeping in poll() on the token and the exit handle together.
+  auto cancel_fd = options.cancel->wait_handle();
+  if (!cancel_fd) {
+    return cancel_fd.error();
+  }
+  if (!impl_->exit_handle && !spawned.terminal_result) {
+    auto handle = backend.open_exit_handle(spawned);
+    if (handle) {
+      impl_->exit_handle.reset(handle.value());
+    }
+  }
+  internal::WaitOps ops;
+  ops.try_wait = [&] { return backend.try_wait(spawned); };
+  ops.wait_blocking = [&]() -> Result<ExitStatus> {
+    auto waited = backend.wait(spawned, std::nullopt, std::chrono::milliseconds(0));
+    if (!waited) {
+      return waited.error();
+    }
+    return waited->status;
+  };
+  ops.terminate = [&] { return backend.terminate(spawned); };
+  ops.kill = [&] { return backend.kill(spawned); };
+  ops.cancelled = [&] { return options.cancel->cancelled(); };
+  ops.wait_exit = [&](std::chrono::milliseconds budget) -> Result<void> {
+    std::array<pollfd, 2> fds = {
+        pollfd{.fd = cancel_fd.value(), .events = POLLIN, .revents = 0},
+        pollfd{.fd = impl_->exit_handle.get(), .events = POLLIN, .revents = 0},
+    };
+    pollfd* first = fds.data();
+    nfds_t count = 2;
+    if (options.cancel->cancelled()) {
+      // A fired token stays readable; once the escalation is underway only exits matter.
+      first = &fds[1];
+      count = 1;
+    }
+    if (!impl_->exit_handle) {
+      // Without an exit handle, wake every millisecond for try_wait.
+      --count;
+      budget = std::min(budget, std::chrono::milliseconds(1));
+    }
+    auto timeout_ms = static_cast<int>(
+        std::clamp<std::chrono::milliseconds::rep>(budget.count(), 0, INT_MAX));
+    if (::poll(first, count, timeout_ms) == -1 && errno != EINTR) {
+      return Error{.code = std::error_code(errno, std::system_category()), .context = "poll"};
+    }
+    return {};
+  };
+  auto waited = internal::wait_with_timeout(ops, internal::default_clock(), options.timeout,
+                                            options.kill_grace);
+  if (!waited) {
+    return waited.error();
+  }
+  // Every path above reaped through the backend, which cached the result with its usage.
+  auto terminal = backend.wait(spawned, std::nullopt, std::chrono::milliseconds(0));
+  if (!terminal) {
+    return terminal.error();
+  }
+  WaitResult result = waited.value();
+  result.usage = terminal->usage;
+  return result;
+}
+
+Async<WaitResult> Child::wait_async(Reactor& reactor, WaitOptions options) {
+  return Async<WaitResult>([this, &reactor, options](Async<WaitResult>::Callback done) {
+    auto handle = exit_handle();
+    if (!handle) {
+      done(wait(options));
+      return;
+    }
+    std::make_shared<AsyncWait>(*this, reactor, handle.value(), options, std::move(done))->start();
+  });
 }
 
 Result<void> Child::terminate() {
@@ -155,6 +397,25 @@ Result<void> Child::kill() {
   return internal::backend_for(impl_->spawned_).kill(impl_->spawned_);
 }
 
+Result<void> Child::kill_tree(std::optional<std::chrono::milliseconds> timeout) {
+  if (!impl_) {
+    return Error{.code = make_error_code(errc::kill_failed), .context = "kill_tree"};
+  }
+  auto use = impl_->concurrent_use.enter("Child");
+  (void)use;
+#if PROCLY_PLATFORM_LINUX
+  if (const auto& cgroup = impl_->spawned_.cgroup) {
+    auto killed = internal::cgroup_kill(*cgroup);
+    if (!killed) {
+      return killed;
+    }
+    return internal::cgroup_wait_empty(*cgroup, timeout);
+  }
+#endif
+  (void)timeout;
+  return internal::backend_for(impl_->spawned_).kill(impl_->spawned_);
+}
+
 Result<void> Child::signal(int signo) {
   if (!impl_) {
     return Error{.code = make_error_code(errc::kill_failed), .context = "signal"};
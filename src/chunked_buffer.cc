@@ -0,0 +1,113 @@
+#include "procly/chunked_buffer.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <utility>
+
+namespace procly {
+
+namespace {
+
+// Free chunks kept for reuse; beyond this (4 MiB) released chunks go back to the heap.
+constexpr std::size_t kMaxPooledChunks = 64;
+
+struct ChunkPool {
+  // Reserved up front so releasing a chunk never allocates.
+  ChunkPool() { free.reserve(kMaxPooledChunks); }
+
+  std::mutex mutex;
+  std::vector<std::unique_ptr<char[]>> free;
+};
+
+ChunkPool& chunk_pool() {
+  // Leaked so buffers destroyed during static destruction can still release into it.
+  static auto* pool = new ChunkPool();
+  return *pool;
+}
+
+std::unique_ptr<char[]> acquire_chunk() {
+  {
+    auto& pool = chunk_pool();
+    std::lock_guard lock(pool.mutex);
+    if (!pool.free.empty()) {
+      auto chunk = std::move(pool.free.back());
+      pool.free.pop_back();
+      return chunk;
+    }
+  }
+  // Uninitialized on purpose: every byte is written before it becomes visible.
+  return std::unique_ptr<char[]>(new char[ChunkedBuffer::kChunkBytes]);
+}
+
+void release_chunks(std::vector<std::unique_ptr<char[]>>& chunks) {
+  if (chunks.empty()) {
+    return;
+  }
+  auto& pool = chunk_pool();
+  std::lock_guard lock(pool.mutex);
+  for (auto& chunk : chunks) {
+    if (pool.free.size() >= kMaxPooledChunks) {
+      break;
+    }
+    pool.free.push_back(std::move(chunk));
+  }
+  chunks.clear();
+}
+
+}  // namespace
+
+ChunkedBuffer::ChunkedBuffer(ChunkedBuffer&& other) noexcept
+    : chunks_(std::move(other.chunks_)), size_(std::exchange(other.size_, 0)) {
+  other.chunks_.clear();
+}
+
+ChunkedBuffer& ChunkedBuffer::operator=(ChunkedBuffer&& other) noexcept {
+  if (this != &other) {
+    clear();
+    chunks_ = std::move(other.chunks_);
+    size_ = std::exchange(other.size_, 0);
+    other.chunks_.clear();
+  }
+  return *this;
+}
+
+ChunkedBuffer::~ChunkedBuffer() { clear(); }
+
+void ChunkedBuffer::clear() noexcept {
+  release_chunks(chunks_);
+  size_ = 0;
+}
+
+char* ChunkedBuffer::writable_tail(std::size_t* room) {
+  std::size_t index = size_ / kChunkBytes;
+  if (index == chunks_.size()) {
+    chunks_.push_back(acquire_chunk());
+  }
+  std::size_t used = size_ % kChunkBytes;
+  *room = kChunkBytes - used;
+  return chunks_[index].get() + used;
+}
+
+void ChunkedBuffer::append(const char* data, std::size_t size) {
+  while (size > 0) {
+    std::size_t room = 0;
+    char* tail = writable_tail(&room);
+    std::size_t take = std::min(room, size);
+    std::memcpy(tail, data, take);
+    commit(take);
+    data += take;
+    size -= take;
+  }
+}
+
+std::string ChunkedBuffer::flatten() const {
+  std::string flat;
+  flat.reserve(size_);
+  for (std::string_view chunk : *this) {
+    flat.append(chunk);
+  }
+  return flat;
+}
+
+}  // namespace procly
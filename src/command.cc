@@ -5,8 +5,9 @@
 #include "procly/child.hpp"
 #include "procly/internal/access.hpp"
 #include "procly/internal/backend.hpp"
-#include "procly/internal/io_drain.hpp"
+#include "procly/internal/command_run.hpp"
 #include "procly/internal/lowering.hpp"
+#include "procly/reactor.hpp"
 
 namespace procly {
 
@@ -18,37 +19,31 @@ Result<internal::Spawned> spawn_command(const Command& command, internal::SpawnM
     return lowered.error();
   }
 
-  auto& backend = internal::default_backend();
-  auto spawned = backend.spawn(lowered.value());
-  if (!spawned) {
-    return spawned.error();
-  }
-  spawned->backend = &backend;
-  return spawned.value();
+  return internal::spawn_lowered(lowered.value(), internal::CommandAccess::backend(command));
 }
 
 }  // namespace
 
-Command::Command(std::string program) { argv_.emplace_back(std::move(program)); }
+Command::Command(std::string program) { strings_.push_arg(program); }
 
 Command& Command::arg(std::string value) {
   auto use = concurrent_use_.enter("Command");
   (void)use;
-  argv_.emplace_back(std::move(value));
+  strings_.push_arg(value);
   return *this;
 }
 
 Command& Command::arg(const char* value) {
   auto use = concurrent_use_.enter("Command");
   (void)use;
-  argv_.emplace_back(value);
+  strings_.push_arg(value);
   return *this;
 }
 
 Command& Command::arg(std::string_view value) {
   auto use = concurrent_use_.enter("Command");
   (void)use;
-  argv_.emplace_back(value);
+  strings_.push_arg(value);
   return *this;
 }
 
@@ -56,7 +51,7 @@ Command& Command::args(std::initializer_list<std::string_view> values) {
   auto use = concurrent_use_.enter("Command");
   (void)use;
   for (auto value : values) {
-    argv_.emplace_back(value);
+    strings_.push_arg(value);
   }
   return *this;
 }
@@ -65,7 +60,7 @@ Command& Command::args(const std::string* values, std::size_t count) {
   auto use = concurrent_use_.enter("Command");
   (void)use;
   for (std::size_t i = 0; i < count; ++i) {
-    argv_.emplace_back(values[i]);
+    strings_.push_arg(values[i]);
   }
   return *this;
 }
@@ -75,7 +70,7 @@ Command& Command::args(std::span<const std::string> values) {
   auto use = concurrent_use_.enter("Command");
   (void)use;
   for (const auto& value : values) {
-    argv_.emplace_back(value);
+    strings_.push_arg(value);
   }
   return *this;
 }
@@ -85,28 +80,64 @@ Command& Command::current_dir(std::filesystem::path path) {
   auto use = concurrent_use_.enter("Command");
   (void)use;
   cwd_ = std::move(path);
+  cwd_fd_.reset();
+  return *this;
+}
+
+#if PROCLY_PLATFORM_POSIX
+Command& Command::current_dir(int dir_fd) {
+  auto use = concurrent_use_.enter("Command");
+  (void)use;
+  cwd_fd_ = dir_fd;
+  cwd_.reset();
   return *this;
 }
+#endif
 
 Command& Command::env(std::string key, std::string value) {
   auto use = concurrent_use_.enter("Command");
   (void)use;
-  env_delta_[std::move(key)] = std::move(value);
+  auto current = strings_.find_env(key);
+  if (current && current->value == value) {
+    return *this;
+  }
+  strings_.set_env(key, value);
+  env_cache_.reset();
   return *this;
 }
 
 Command& Command::env_remove(std::string_view key) {
   auto use = concurrent_use_.enter("Command");
   (void)use;
-  env_delta_[std::string(key)] = std::nullopt;
+  auto current = strings_.find_env(key);
+  // Without an inherited environment there is nothing to remove a missing key from.
+  if (current ? !current->value.has_value() : !inherit_env_) {
+    return *this;
+  }
+  strings_.set_env(key, std::nullopt);
+  env_cache_.reset();
   return *this;
 }
 
 Command& Command::env_clear() {
   auto use = concurrent_use_.enter("Command");
   (void)use;
+  if (!inherit_env_ && strings_.env_count() == 0) {
+    return *this;
+  }
   inherit_env_ = false;
-  env_delta_.clear();
+  env_base_.reset();
+  strings_.clear_env();
+  env_cache_.reset();
+  return *this;
+}
+
+Command& Command::environment(Environment base) {
+  auto use = concurrent_use_.enter("Command");
+  (void)use;
+  inherit_env_ = true;
+  env_base_ = std::move(base);
+  env_cache_.reset();
   return *this;
 }
 
@@ -134,13 +165,53 @@ Command& Command::stderr(Stdio value) {
 Command& Command::options(SpawnOptions value) {
   auto use = concurrent_use_.enter("Command");
   (void)use;
-  opts_ = value;
+  opts_ = std::move(value);
   return *this;
 }
 
-Result<Child> Command::spawn() const {
+#if PROCLY_PLATFORM_POSIX
+Command& Command::limit(int resource, std::uint64_t soft, std::uint64_t hard) {
+  auto use = concurrent_use_.enter("Command");
+  (void)use;
+  for (auto& existing : opts_.limits) {
+    if (existing.resource == resource) {
+      existing.soft = soft;
+      existing.hard = hard;
+      return *this;
+    }
+  }
+  opts_.limits.push_back(ResourceLimit{.resource = resource, .soft = soft, .hard = hard});
+  return *this;
+}
+#endif
+
+#if PROCLY_PLATFORM_LINUX
+Command& Command::cgroup(std::filesystem::path path) {
+  auto use = concurrent_use_.enter("Command");
+  (void)use;
+  opts_.cgroup = std::move(path);
+  return *this;
+}
+
+Command& Command::numa_nodes(std::vector<int> nodes, NumaPolicy policy) {
+  auto use = concurrent_use_.enter("Command");
+  (void)use;
+  opts_.numa_nodes = std::move(nodes);
+  opts_.numa_policy = policy;
+  return *this;
+}
+#endif
+
+Command& Command::backend(Backend& backend) {
   auto use = concurrent_use_.enter("Command");
   (void)use;
+  backend_ = &backend;
+  return *this;
+}
+
+Result<Child> Command::spawn() const {
+  auto use = concurrent_use_.enter_shared("Command");
+  (void)use;
   auto spawned = spawn_command(*this, internal::SpawnMode::spawn);
   if (!spawned) {
     return spawned.error();
@@ -149,67 +220,266 @@ Result<Child> Command::spawn() const {
 }
 
 Result<ExitStatus> Command::status() const {
-  auto use = concurrent_use_.enter("Command");
+  auto use = concurrent_use_.enter_shared("Command");
   (void)use;
   auto spawned = spawn_command(*this, internal::SpawnMode::spawn);
   if (!spawned) {
     return spawned.error();
   }
   Child child = internal::ChildAccess::from_spawned(spawned.value());
+  return internal::finish_status(child);
+}
 
-  auto stdin_pipe = child.take_stdin();
-  if (stdin_pipe) {
-    stdin_pipe->close();
+Result<ExitStatus> Command::status(const CancellationToken& cancel) const {
+  auto use = concurrent_use_.enter_shared("Command");
+  (void)use;
+  auto spawned = spawn_command(*this, internal::SpawnMode::spawn);
+  if (!spawned) {
+    return spawned.error();
   }
+  Child child = internal::ChildAccess::from_spawned(spawned.value());
+  return internal::finish_status(child, &cancel);
+}
 
-  auto stdout_pipe = child.take_stdout();
-  auto stderr_pipe = child.take_stderr();
-  if (stdout_pipe || stderr_pipe) {
-    auto drained = internal::drain_pipes(stdout_pipe ? &*stdout_pipe : nullptr,
-                                         stderr_pipe ? &*stderr_pipe : nullptr);
-    if (!drained) {
-      return drained.error();
-    }
-  }
+Result<Output> Command::output() const { return output(CaptureOptions{}); }
 
-  return child.wait();
+Result<Output> Command::output(const CaptureOptions& options) const {
+  auto use = concurrent_use_.enter_shared("Command");
+  (void)use;
+  auto spawned = spawn_command(*this, internal::SpawnMode::output);
+  if (!spawned) {
+    return spawned.error();
+  }
+  Child child = internal::ChildAccess::from_spawned(spawned.value());
+  return internal::finish_output(child, options);
 }
 
-Result<Output> Command::output() const {
-  auto use = concurrent_use_.enter("Command");
+Result<Output> Command::output(const CaptureOptions& options,
+                               const CancellationToken& cancel) const {
+  auto use = concurrent_use_.enter_shared("Command");
   (void)use;
   auto spawned = spawn_command(*this, internal::SpawnMode::output);
   if (!spawned) {
     return spawned.error();
   }
   Child child = internal::ChildAccess::from_spawned(spawned.value());
+  return internal::finish_output(child, options, &cancel);
+}
 
-  auto stdin_pipe = child.take_stdin();
-  if (stdin_pipe) {
-    stdin_pipe->close();
+Result<Output> Command::output_with_input(std::string_view input,
+                                          const CaptureOptions& options) const {
+  auto use = concurrent_use_.enter_shared("Command");
+  (void)use;
+  internal::StdioOverride overrides;
+  overrides.stdin_override = Stdio::piped();
+  auto lowered = internal::lower_command(*this, internal::SpawnMode::output, &overrides);
+  if (!lowered) {
+    return lowered.error();
+  }
+  auto spawned = internal::spawn_lowered(lowered.value(), backend_);
+  if (!spawned) {
+    return spawned.error();
   }
+  Child child = internal::ChildAccess::from_spawned(spawned.value());
+  return internal::finish_output_with_input(child, input, options);
+}
 
-  auto stdout_pipe = child.take_stdout();
-  auto stderr_pipe = child.take_stderr();
+Result<Output> Command::output_from(StdinSource input, const CaptureOptions& options) const {
+  auto use = concurrent_use_.enter_shared("Command");
+  (void)use;
+  internal::StdioOverride overrides;
+  overrides.stdin_override = Stdio::piped();
+  auto lowered = internal::lower_command(*this, internal::SpawnMode::output, &overrides);
+  if (!lowered) {
+    return lowered.error();
+  }
+  auto spawned = internal::spawn_lowered(lowered.value(), backend_);
+  if (!spawned) {
+    return spawned.error();
+  }
+  Child child = internal::ChildAccess::from_spawned(spawned.value());
+  return internal::finish_output_with_input(child, input, options);
+}
 
-  auto drained = internal::drain_pipes(stdout_pipe ? &*stdout_pipe : nullptr,
-                                       stderr_pipe ? &*stderr_pipe : nullptr);
-  if (!drained) {
-    return drained.error();
+#if PROCLY_HAS_STD_SPAN
+Result<Output> Command::output_with_input(std::span<const std::byte> input,
+                                          const CaptureOptions& options) const {
+  return output_with_input(
+      std::string_view(reinterpret_cast<const char*>(input.data()), input.size()), options);
+}
+#endif
+
+Result<ExitStatus> Command::output_into(std::string& stdout_data,
+                                      std::string& stderr_data) const {
+  auto use = concurrent_use_.enter_shared("Command");
+  (void)use;
+  auto spawned = spawn_command(*this, internal::SpawnMode::output);
+  if (!spawned) {
+    return spawned.error();
+  }
+  Child child = internal::ChildAccess::from_spawned(spawned.value());
+  return internal::finish_output_into(child, stdout_data, stderr_data);
+}
+
+Result<ChunkedOutput> Command::output_chunked() const {
+  auto use = concurrent_use_.enter_shared("Command");
+  (void)use;
+  auto spawned = spawn_command(*this, internal::SpawnMode::output);
+  if (!spawned) {
+    return spawned.error();
   }
+  Child child = internal::ChildAccess::from_spawned(spawned.value());
+  return internal::finish_output_chunked(child);
+}
 
-  auto status = child.wait();
+#if PROCLY_PLATFORM_POSIX
+Result<MappedOutput> Command::output_mapped() const {
+  auto use = concurrent_use_.enter_shared("Command");
+  (void)use;
+  auto stdout_file = internal::create_capture_file("procly-stdout");
+  if (!stdout_file) {
+    return stdout_file.error();
+  }
+  auto stderr_file = internal::create_capture_file("procly-stderr");
+  if (!stderr_file) {
+    return stderr_file.error();
+  }
+  internal::StdioOverride overrides;
+  overrides.stdout_override = Stdio::fd(stdout_file->get());
+  overrides.stderr_override = Stdio::fd(stderr_file->get());
+  auto lowered = internal::lower_command(*this, internal::SpawnMode::output, &overrides);
+  if (!lowered) {
+    return lowered.error();
+  }
+  auto spawned = internal::spawn_lowered(lowered.value(), backend_);
+  if (!spawned) {
+    return spawned.error();
+  }
+  Child child = internal::ChildAccess::from_spawned(spawned.value());
+  auto status = internal::finish_status(child);
   if (!status) {
     return status.error();
   }
-
-  Output output;
+  auto stdout_map = MappedBuffer::map(stdout_file->get());
+  if (!stdout_map) {
+    return stdout_map.error();
+  }
+  auto stderr_map = MappedBuffer::map(stderr_file->get());
+  if (!stderr_map) {
+    return stderr_map.error();
+  }
+  MappedOutput output;
   output.status = status.value();
-  output.stdout_data = std::move(drained->stdout_data);
-  output.stderr_data = std::move(drained->stderr_data);
+  output.stdout_data = std::move(stdout_map.value());
+  output.stderr_data = std::move(stderr_map.value());
   return output;
 }
 
+Result<SpillOutput> Command::output_spill(std::size_t memory_limit) const {
+  auto use = concurrent_use_.enter_shared("Command");
+  (void)use;
+  auto spawned = spawn_command(*this, internal::SpawnMode::output);
+  if (!spawned) {
+    return spawned.error();
+  }
+  Child child = internal::ChildAccess::from_spawned(spawned.value());
+  return internal::finish_output_spill(child, memory_limit);
+}
+#endif
+
+Result<TimelineOutput> Command::output_timeline() const {
+  auto use = concurrent_use_.enter_shared("Command");
+  (void)use;
+  auto spawned = spawn_command(*this, internal::SpawnMode::output);
+  if (!spawned) {
+    return spawned.error();
+  }
+  Child child = internal::ChildAccess::from_spawned(spawned.value());
+  return internal::finish_output_timeline(child);
+}
+
+Result<CompressedOutput> Command::output_compressed(Compression codec, int level) const {
+  auto use = concurrent_use_.enter_shared("Command");
+  (void)use;
+  // Set the codec up before spawning so an unsupported codec or level never runs the command.
+  auto stdout_compressor = internal::Compressor::create(codec, level);
+  if (!stdout_compressor) {
+    return stdout_compressor.error();
+  }
+  auto stderr_compressor = internal::Compressor::create(codec, level);
+  if (!stderr_compressor) {
+    return stderr_compressor.error();
+  }
+  auto spawned = spawn_command(*this, internal::SpawnMode::output);
+  if (!spawned) {
+    return spawned.error();
+  }
+  Child child = internal::ChildAccess::from_spawned(spawned.value());
+  return internal::finish_output_compressed(child, std::move(stdout_compressor.value()),
+                                            std::move(stderr_compressor.value()));
+}
+
+Result<ExitStatus> Command::output(OutputSink stdout_sink, OutputSink stderr_sink) const {
+  auto use = concurrent_use_.enter_shared("Command");
+  (void)use;
+  auto spawned = spawn_command(*this, internal::SpawnMode::output);
+  if (!spawned) {
+    return spawned.error();
+  }
+  Child child = internal::ChildAccess::from_spawned(spawned.value());
+  return internal::finish_stream(child, stdout_sink, stderr_sink);
+}
+
+Async<ExitStatus> Command::status_async(Reactor& reactor) const {
+  auto use = concurrent_use_.enter_shared("Command");
+  (void)use;
+  auto spawned = spawn_command(*this, internal::SpawnMode::spawn);
+  if (!spawned) {
+    return Async<ExitStatus>::ready(spawned.error());
+  }
+  auto child = std::make_shared<Child>(internal::ChildAccess::from_spawned(spawned.value()));
+  return Async<ExitStatus>([&reactor, child](const Async<ExitStatus>::Callback& done) {
+    auto watched =
+        reactor.watch(std::move(*child), {}, [done](Result<ChildCompletion> completion) {
+          if (!completion) {
+            done(completion.error());
+            return;
+          }
+          done(completion->wait.status);
+        });
+    if (!watched) {
+      done(watched.error());
+    }
+  });
+}
+
+Async<Output> Command::output_async(Reactor& reactor) const {
+  auto use = concurrent_use_.enter_shared("Command");
+  (void)use;
+  auto spawned = spawn_command(*this, internal::SpawnMode::output);
+  if (!spawned) {
+    return Async<Output>::ready(spawned.error());
+  }
+  auto child = std::make_shared<Child>(internal::ChildAccess::from_spawned(spawned.value()));
+  return Async<Output>([&reactor, child](const Async<Output>::Callback& done) {
+    auto watched =
+        reactor.watch(std::move(*child), {}, [done](Result<ChildCompletion> completion) {
+          if (!completion) {
+            done(completion.error());
+            return;
+          }
+          Output output;
+          output.status = completion->wait.status;
+          output.stdout_data = std::move(completion->stdout_data);
+          output.stderr_data = std::move(completion->stderr_data);
+          done(std::move(output));
+        });
+    if (!watched) {
+      done(watched.error());
+    }
+  });
+}
+
 Child Command::spawn_or_throw() const {
   auto result = spawn();
   if (!result) {
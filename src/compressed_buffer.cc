@@ -0,0 +1,111 @@
+#include "procly/compressed_buffer.hpp"
+
+#include <memory>
+#include <string>
+
+#if defined(PROCLY_ENABLE_ZSTD)
+#include <zstd.h>
+#endif
+#if defined(PROCLY_ENABLE_LZ4)
+#include <lz4frame.h>
+#endif
+
+namespace procly {
+
+namespace {
+
+Error corrupt_frame(const char* call, const char* detail) {
+  return Error{.code = make_error_code(errc::invalid_argument),
+               .context = std::string(call) + ": " + detail};
+}
+
+}  // namespace
+
+bool compression_supported(Compression codec) noexcept {
+  switch (codec) {
+    case Compression::zstd:
+#if defined(PROCLY_ENABLE_ZSTD)
+      return true;
+#else
+      return false;
+#endif
+    case Compression::lz4:
+#if defined(PROCLY_ENABLE_LZ4)
+      return true;
+#else
+      return false;
+#endif
+  }
+  return false;
+}
+
+Result<std::string> CompressedBuffer::decompress() const {
+  if (!compression_supported(codec_)) {
+    return Error{.code = make_error_code(errc::invalid_argument),
+                 .context = codec_ == Compression::zstd ? "zstd" : "lz4"};
+  }
+  // The uncompressed size is known, so the output is sized once and filled in place.
+  std::string out(size_, '\0');
+  std::size_t produced = 0;
+  switch (codec_) {
+    case Compression::zstd: {
+#if defined(PROCLY_ENABLE_ZSTD)
+      std::unique_ptr<ZSTD_DCtx, std::size_t (*)(ZSTD_DCtx*)> context(ZSTD_createDCtx(),
+                                                                      ZSTD_freeDCtx);
+      if (!context) {
+        return corrupt_frame("ZSTD_createDCtx", "out of memory");
+      }
+      ZSTD_inBuffer in{.src = frame_.data(), .size = frame_.size(), .pos = 0};
+      ZSTD_outBuffer target{.dst = out.data(), .size = out.size(), .pos = 0};
+      std::size_t remaining = 1;
+      while (remaining != 0) {
+        std::size_t consumed = in.pos;
+        std::size_t written = target.pos;
+        remaining = ZSTD_decompressStream(context.get(), &target, &in);
+        if (ZSTD_isError(remaining)) {
+          return corrupt_frame("ZSTD_decompressStream", ZSTD_getErrorName(remaining));
+        }
+        if (remaining != 0 && in.pos == consumed && target.pos == written) {
+          return corrupt_frame("ZSTD_decompressStream", "truncated frame");
+        }
+      }
+      produced = target.pos;
+#endif
+      break;
+    }
+    case Compression::lz4: {
+#if defined(PROCLY_ENABLE_LZ4)
+      LZ4F_dctx* raw = nullptr;
+      LZ4F_errorCode_t created = LZ4F_createDecompressionContext(&raw, LZ4F_VERSION);
+      std::unique_ptr<LZ4F_dctx, LZ4F_errorCode_t (*)(LZ4F_dctx*)> context(
+          raw, LZ4F_freeDecompressionContext);
+      if (LZ4F_isError(created)) {
+        return corrupt_frame("LZ4F_createDecompressionContext", LZ4F_getErrorName(created));
+      }
+      std::size_t consumed = 0;
+      std::size_t remaining = 1;
+      while (remaining != 0) {
+        std::size_t dst_size = out.size() - produced;
+        std::size_t src_size = frame_.size() - consumed;
+        remaining = LZ4F_decompress(context.get(), out.data() + produced, &dst_size,
+                                    frame_.data() + consumed, &src_size, nullptr);
+        if (LZ4F_isError(remaining)) {
+          return corrupt_frame("LZ4F_decompress", LZ4F_getErrorName(remaining));
+        }
+        if (remaining != 0 && dst_size == 0 && src_size == 0) {
+          return corrupt_frame("LZ4F_decompress", "truncated frame");
+        }
+        produced += dst_size;
+        consumed += src_size;
+      }
+#endif
+      break;
+    }
+  }
+  if (produced != size_) {
+    return corrupt_frame("decompress", "size mismatch");
+  }
+  return out;
+}
+
+}  // namespace procly
@@ -0,0 +1,379 @@
+#include "procly/digest.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <variant>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <nmmintrin.h>
+#define PROCLY_CRC32C_SSE42 1
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#define PROCLY_CRC32C_ARM 1
+#endif
+
+namespace procly {
+
+namespace {
+
+std::uint32_t load32(const unsigned char* p) {
+  return static_cast<std::uint32_t>(p[0]) | static_cast<std::uint32_t>(p[1]) << 8 |
+         static_cast<std::uint32_t>(p[2]) << 16 | static_cast<std::uint32_t>(p[3]) << 24;
+}
+
+std::uint64_t load64(const unsigned char* p) {
+  return static_cast<std::uint64_t>(load32(p)) | static_cast<std::uint64_t>(load32(p + 4)) << 32;
+}
+
+std::uint32_t load32_be(const unsigned char* p) {
+  return static_cast<std::uint32_t>(p[0]) << 24 | static_cast<std::uint32_t>(p[1]) << 16 |
+         static_cast<std::uint32_t>(p[2]) << 8 | static_cast<std::uint32_t>(p[3]);
+}
+
+std::uint64_t rotl64(std::uint64_t value, int bits) {
+  return (value << bits) | (value >> (64 - bits));
+}
+
+std::uint32_t rotr32(std::uint32_t value, int bits) {
+  return (value >> bits) | (value << (32 - bits));
+}
+
+void append_hex(std::string& out, std::uint64_t value, int bytes) {
+  static constexpr char kDigits[] = "0123456789abcdef";
+  for (int shift = bytes * 8 - 4; shift >= 0; shift -= 4) {
+    out.push_back(kDigits[(value >> shift) & 0xf]);
+  }
+}
+
+// --- CRC-32C --------------------------------------------------------------------------------
+
+using Crc32cTables = std::array<std::array<std::uint32_t, 256>, 8>;
+
+Crc32cTables make_crc32c_tables() {
+  Crc32cTables tables{};
+  for (std::uint32_t i = 0; i < 256; ++i) {
+    std::uint32_t crc = i;
+    for (int bit = 0; bit < 8; ++bit) {
+      crc = (crc >> 1) ^ ((crc & 1) != 0 ? 0x82f63b78U : 0);
+    }
+    tables[0][i] = crc;
+  }
+  for (std::size_t k = 1; k < tables.size(); ++k) {
+    for (std::size_t i = 0; i < 256; ++i) {
+      std::uint32_t previous = tables[k - 1][i];
+      tables[k][i] = (previous >> 8) ^ tables[0][previous & 0xff];
+    }
+  }
+  return tables;
+}
+
+// Slicing-by-8: eight table lookups per 8 input bytes.
+std::uint32_t crc32c_portable(std::uint32_t crc, const unsigned char* data, std::size_t size) {
+  static const Crc32cTables tables = make_crc32c_tables();
+  while (size >= 8) {
+    std::uint32_t low = load32(data) ^ crc;
+    std::uint32_t high = load32(data + 4);
+    crc = tables[7][low & 0xff] ^ tables[6][(low >> 8) & 0xff] ^ tables[5][(low >> 16) & 0xff] ^
+          tables[4][low >> 24] ^ tables[3][high & 0xff] ^ tables[2][(high >> 8) & 0xff] ^
+          tables[1][(high >> 16) & 0xff] ^ tables[0][high >> 24];
+    data += 8;
+    size -= 8;
+  }
+  while (size-- > 0) {
+    crc = (crc >> 8) ^ tables[0][(crc ^ *data++) & 0xff];
+  }
+  return crc;
+}
+
+#if PROCLY_CRC32C_SSE42
+__attribute__((target("sse4.2"))) std::uint32_t crc32c_hardware(std::uint32_t crc,
+                                                                const unsigned char* data,
+                                                                std::size_t size) {
+  std::uint64_t wide = crc;
+  while (size >= 8) {
+    wide = _mm_crc32_u64(wide, load64(data));
+    data += 8;
+    size -= 8;
+  }
+  crc = static_cast<std::uint32_t>(wide);
+  while (size-- > 0) {
+    crc = _mm_crc32_u8(crc, *data++);
+  }
+  return crc;
+}
+
+bool crc32c_hardware_available() {
+  static const bool available = __builtin_cpu_supports("sse4.2");
+  return available;
+}
+#elif PROCLY_CRC32C_ARM
+std::uint32_t crc32c_hardware(std::uint32_t crc, const unsigned char* data, std::size_t size) {
+  while (size >= 8) {
+    crc = __crc32cd(crc, load64(data));
+    data += 8;
+    size -= 8;
+  }
+  while (size-- > 0) {
+    crc = __crc32cb(crc, *data++);
+  }
+  return crc;
+}
+
+bool crc32c_hardware_available() { return true; }
+#endif
+
+struct Crc32c {
+  std::uint32_t crc = 0xffffffffU;
+
+  void update(const unsigned char* data, std::size_t size) {
+#if PROCLY_CRC32C_SSE42 || PROCLY_CRC32C_ARM
+    if (crc32c_hardware_available()) {
+      crc = crc32c_hardware(crc, data, size);
+      return;
+    }
+#endif
+    crc = crc32c_portable(crc, data, size);
+  }
+
+  void hex(std::string& out) const { append_hex(out, crc ^ 0xffffffffU, 4); }
+};
+
+// --- xxHash64 -------------------------------------------------------------------------------
+
+constexpr std::uint64_t kXxPrime1 = 11400714785074694791ULL;
+constexpr std::uint64_t kXxPrime2 = 14029467366897019727ULL;
+constexpr std::uint64_t kXxPrime3 = 1609587929392839161ULL;
+constexpr std::uint64_t kXxPrime4 = 9650029242287828579ULL;
+constexpr std::uint64_t kXxPrime5 = 2870177450012600261ULL;
+
+std::uint64_t xx_round(std::uint64_t acc, std::uint64_t input) {
+  acc += input * kXxPrime2;
+  return rotl64(acc, 31) * kXxPrime1;
+}
+
+std::uint64_t xx_merge(std::uint64_t acc, std::uint64_t lane) {
+  acc ^= xx_round(0, lane);
+  return acc * kXxPrime1 + kXxPrime4;
+}
+
+struct Xxh64 {
+  std::array<std::uint64_t, 4> lanes{kXxPrime1 + kXxPrime2, kXxPrime2, 0, 0 - kXxPrime1};
+  std::uint64_t total = 0;
+  std::array<unsigned char, 32> pending{};
+  std::size_t pending_size = 0;
+
+  void consume(const unsigned char* stripe) {
+    for (std::size_t i = 0; i < lanes.size(); ++i) {
+      lanes[i] = xx_round(lanes[i], load64(stripe + i * 8));
+    }
+  }
+
+  void update(const unsigned char* data, std::size_t size) {
+    total += size;
+    if (pending_size > 0) {
+      std::size_t take = std::min(size, pending.size() - pending_size);
+      std::memcpy(pending.data() + pending_size, data, take);
+      pending_size += take;
+      data += take;
+      size -= take;
+      if (pending_size < pending.size()) {
+        return;
+      }
+      consume(pending.data());
+      pending_size = 0;
+    }
+    while (size >= pending.size()) {
+      consume(data);
+      data += pending.size();
+      size -= pending.size();
+    }
+    std::memcpy(pending.data(), data, size);
+    pending_size = size;
+  }
+
+  void hex(std::string& out) const {
+    std::uint64_t hash = 0;
+    if (total >= pending.size()) {
+      hash = rotl64(lanes[0], 1) + rotl64(lanes[1], 7) + rotl64(lanes[2], 12) +
+             rotl64(lanes[3], 18);
+      for (std::uint64_t lane : lanes) {
+        hash = xx_merge(hash, lane);
+      }
+    } else {
+      hash = kXxPrime5;
+    }
+    hash += total;
+    const unsigned char* tail = pending.data();
+    std::size_t size = pending_size;
+    for (; size >= 8; tail += 8, size -= 8) {
+      hash ^= xx_round(0, load64(tail));
+      hash = rotl64(hash, 27) * kXxPrime1 + kXxPrime4;
+    }
+    if (size >= 4) {
+      hash ^= static_cast<std::uint64_t>(load32(tail)) * kXxPrime1;
+      hash = rotl64(hash, 23) * kXxPrime2 + kXxPrime3;
+      tail += 4;
+      size -= 4;
+    }
+    for (; size > 0; ++tail, --size) {
+      hash ^= *tail * kXxPrime5;
+      hash = rotl64(hash, 11) * kXxPrime1;
+    }
+    hash ^= hash >> 33;
+    hash *= kXxPrime2;
+    hash ^= hash >> 29;
+    hash *= kXxPrime3;
+    hash ^= hash >> 32;
+    append_hex(out, hash, 8);
+  }
+};
+
+// --- SHA-256 --------------------------------------------------------------------------------
+
+constexpr std::array<std::uint32_t, 64> kShaRounds = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4,
+    0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe,
+    0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f,
+    0x4a7484aa, 0x5cb0a9dc, 0x76f988da, 0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+    0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc,
+    0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+    0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070, 0x19a4c116,
+    0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7,
+    0xc67178f2};
+
+struct Sha256 {
+  std::array<std::uint32_t, 8> state{0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                                     0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+  std::uint64_t total = 0;
+  std::array<unsigned char, 64> pending{};
+  std::size_t pending_size = 0;
+
+  void compress(const unsigned char* block) {
+    std::array<std::uint32_t, 64> w{};
+    for (std::size_t i = 0; i < 16; ++i) {
+      w[i] = load32_be(block + i * 4);
+    }
+    for (std::size_t i = 16; i < 64; ++i) {
+      std::uint32_t s0 = rotr32(w[i - 15], 7) ^ rotr32(w[i - 15], 18) ^ (w[i - 15] >> 3);
+      std::uint32_t s1 = rotr32(w[i - 2], 17) ^ rotr32(w[i - 2], 19) ^ (w[i - 2] >> 10);
+      w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+    auto [a, b, c, d, e, f, g, h] = state;
+    for (std::size_t i = 0; i < 64; ++i) {
+      std::uint32_t t1 = h + (rotr32(e, 6) ^ rotr32(e, 11) ^ rotr32(e, 25)) +
+                         ((e & f) ^ (~e & g)) + kShaRounds[i] + w[i];
+      std::uint32_t t2 = (rotr32(a, 2) ^ rotr32(a, 13) ^ rotr32(a, 22)) +
+                         ((a & b) ^ (a & c) ^ (b & c));
+      h = g;
+      g = f;
+      f = e;
+      e = d + t1;
+      d = c;
+      c = b;
+      b = a;
+      a = t1 + t2;
+    }
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+  }
+
+  void update(const unsigned char* data, std::size_t size) {
+    total += size;
+    if (pending_size > 0) {
+      std::size_t take = std::min(size, pending.size() - pending_size);
+      std::memcpy(pending.data() + pending_size, data, take);
+      pending_size += take;
+      data += take;
+      size -= take;
+      if (pending_size < pending.size()) {
+        return;
+      }
+      compress(pending.data());
+      pending_size = 0;
+    }
+    while (size >= pending.size()) {
+      compress(data);
+      data += pending.size();
+      size -= pending.size();
+    }
+    std::memcpy(pending.data(), data, size);
+    pending_size = size;
+  }
+
+  // Pads a copy, so the running state stays open for more input.
+  void hex(std::string& out) const {
+    Sha256 copy = *this;
+    std::uint64_t bits = total * 8;
+    static constexpr unsigned char kPad[64] = {0x80};
+    std::size_t pad = pending_size < 56 ? 56 - pending_size : 120 - pending_size;
+    copy.update(kPad, pad);
+    unsigned char length[8];
+    for (int i = 0; i < 8; ++i) {
+      length[i] = static_cast<unsigned char>(bits >> (56 - 8 * i));
+    }
+    copy.update(length, sizeof(length));
+    for (std::uint32_t word : copy.state) {
+      append_hex(out, word, 4);
+    }
+  }
+};
+
+}  // namespace
+
+struct Digest::State {
+  std::variant<Crc32c, Xxh64, Sha256> impl;
+};
+
+Digest::Digest(DigestAlgorithm algorithm)
+    : algorithm_(algorithm), state_(std::make_unique<State>()) {
+  switch (algorithm) {
+    case DigestAlgorithm::crc32c:
+      state_->impl.emplace<Crc32c>();
+      break;
+    case DigestAlgorithm::xxh64:
+      state_->impl.emplace<Xxh64>();
+      break;
+    case DigestAlgorithm::sha256:
+      state_->impl.emplace<Sha256>();
+      break;
+  }
+}
+
+Digest::Digest(const Digest& other)
+    : algorithm_(other.algorithm_), state_(std::make_unique<State>(*other.state_)) {}
+
+Digest& Digest::operator=(const Digest& other) {
+  if (this != &other) {
+    algorithm_ = other.algorithm_;
+    state_ = std::make_unique<State>(*other.state_);
+  }
+  return *this;
+}
+
+Digest::Digest(Digest&& other) noexcept = default;
+Digest& Digest::operator=(Digest&& other) noexcept = default;
+Digest::~Digest() = default;
+
+void Digest::update(const char* data, std::size_t size) {
+  if (size == 0) {
+    return;
+  }
+  const auto* bytes = reinterpret_cast<const unsigned char*>(data);
+  std::visit([&](auto& impl) { impl.update(bytes, size); }, state_->impl);
+}
+
+std::string Digest::hex() const {
+  std::string out;
+  std::visit([&](const auto& impl) { impl.hex(out); }, state_->impl);
+  return out;
+}
+
+}  // namespace procly
@@ -0,0 +1,9 @@
+#include "procly/environment.hpp"
+
+namespace procly {
+
+Environment Environment::capture() {
+  return Environment(internal::EnvBlock::from_entries(internal::process_environment_entries()));
+}
+
+}  // namespace procly
@@ -0,0 +1,156 @@
+#include "procly/exec_path_cache.hpp"
+
+#include <atomic>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
+
+#include "procly/internal/exec_path.hpp"
+
+namespace procly {
+
+namespace {
+
+struct CacheEntry {
+  std::string program;
+  std::string path;
+  std::filesystem::file_time_type mtime;
+  bool has_mtime = false;
+};
+
+struct ExecPathCacheState {
+  std::atomic<bool> enabled{false};
+  std::atomic<bool> revalidate_mtime{false};
+  std::mutex mutex;
+  std::unordered_map<std::string, CacheEntry> entries;
+};
+
+ExecPathCacheState& cache_state() {
+  static ExecPathCacheState state;
+  return state;
+}
+
+bool has_relative_entry(std::string_view path_value) {
+  std::size_t start = 0;
+  while (true) {
+    std::size_t end = path_value.find(':', start);
+    // end - start wraps to a huge count for the last entry; substr clamps it.
+    std::string_view dir = path_value.substr(start, end - start);
+    if (dir.empty() || dir.front() != '/') {
+      return true;
+    }
+    if (end == std::string_view::npos) {
+      return false;
+    }
+    start = end + 1;
+  }
+}
+
+// (argv0, PATH, cwd) with cwd only when a relative PATH entry makes the result depend on it.
+std::string cache_key(const std::string& argv0, const internal::EnvBlock& envp,
+                      const std::optional<std::filesystem::path>& cwd) {
+  auto path_value = envp.find("PATH");
+  std::string key = argv0;
+  key.push_back('\0');
+  if (path_value) {
+    key.push_back('=');
+    key.append(*path_value);
+  }
+  key.push_back('\0');
+  if (cwd && (!path_value || has_relative_entry(*path_value))) {
+    key.append(cwd->native());
+  }
+  return key;
+}
+
+bool entry_is_current(const CacheEntry& entry) {
+  if (!entry.has_mtime) {
+    return false;
+  }
+  std::error_code ec;
+  auto mtime = std::filesystem::last_write_time(entry.path, ec);
+  return !ec && mtime == entry.mtime;
+}
+
+}  // namespace
+
+void configure_exec_path_cache(ExecPathCacheOptions options) noexcept {
+  auto& state = cache_state();
+  state.enabled.store(options.enabled, std::memory_order_relaxed);
+  state.revalidate_mtime.store(options.revalidate_mtime, std::memory_order_relaxed);
+}
+
+ExecPathCacheOptions exec_path_cache_options() noexcept {
+  auto& state = cache_state();
+  return ExecPathCacheOptions{
+      .enabled = state.enabled.load(std::memory_order_relaxed),
+      .revalidate_mtime = state.revalidate_mtime.load(std::memory_order_relaxed),
+  };
+}
+
+void clear_exec_path_cache() {
+  auto& state = cache_state();
+  std::lock_guard<std::mutex> lock(state.mutex);
+  state.entries.clear();
+}
+
+void invalidate_exec_path(std::string_view program) {
+  auto& state = cache_state();
+  std::lock_guard<std::mutex> lock(state.mutex);
+  std::erase_if(state.entries, [&](const auto& item) { return item.second.program == program; });
+}
+
+namespace internal {
+
+std::optional<std::string> cached_exec_path(const std::string& argv0, const EnvBlock& envp,
+                                            const std::optional<std::filesystem::path>& cwd,
+                                            PathLookup lookup, std::optional<int> cwd_fd) {
+  auto& state = cache_state();
+  if (lookup == PathLookup::uncached ||
+      (lookup == PathLookup::automatic && !state.enabled.load(std::memory_order_relaxed))) {
+    return std::nullopt;
+  }
+  if (argv0.empty() || argv0.find('/') != std::string::npos) {
+    return std::nullopt;
+  }
+  if (cwd_fd) {
+    auto path_value = envp.find("PATH");
+    if (!path_value || has_relative_entry(*path_value)) {
+      return std::nullopt;
+    }
+  }
+
+  std::string key = cache_key(argv0, envp, cwd);
+  const bool revalidate = state.revalidate_mtime.load(std::memory_order_relaxed);
+  {
+    std::lock_guard<std::mutex> lock(state.mutex);
+    auto it = state.entries.find(key);
+    if (it != state.entries.end()) {
+      if (!revalidate || entry_is_current(it->second)) {
+        return it->second.path;
+      }
+      state.entries.erase(it);
+    }
+  }
+
+  // Search outside the lock; concurrent misses for the same key just race to insert.
+  std::string resolved = resolve_exec_path(argv0, envp, cwd);
+  if (resolved.find('/') == std::string::npos) {
+    return std::nullopt;
+  }
+  CacheEntry entry{.program = argv0, .path = resolved};
+  std::error_code ec;
+  entry.mtime = std::filesystem::last_write_time(resolved, ec);
+  entry.has_mtime = !ec;
+
+  std::lock_guard<std::mutex> lock(state.mutex);
+  state.entries.insert_or_assign(std::move(key), std::move(entry));
+  return resolved;
+}
+
+}  // namespace internal
+
+}  // namespace procly
@@ -0,0 +1,800 @@
+#include "procly/fork_server.hpp"
+
+#include <dirent.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <array>
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "procly/backend.hpp"
+#include "procly/internal/backend.hpp"
+#include "procly/internal/fd.hpp"
+#include "procly/internal/remote_backend.hpp"
+#include "procly/internal/wire.hpp"
+#include "procly/platform.hpp"
+
+namespace procly {
+
+namespace {
+
+using internal::Decoder;
+using internal::Encoder;
+using internal::unique_fd;
+
+Error make_errno_error(const char* context) {
+  return Error{.code = std::error_code(errno, std::system_category()), .context = context};
+}
+
+Error protocol_error() {
+  return Error{.code = make_error_code(errc::spawn_failed), .context = "fork_server protocol"};
+}
+
+#if PROCLY_PLATFORM_LINUX
+constexpr int kSendFlags = MSG_NOSIGNAL;
+constexpr int kRecvFlags = MSG_CMSG_CLOEXEC;
+#else
+constexpr int kSendFlags = 0;
+constexpr int kRecvFlags = 0;
+#endif
+
+// Spawn requests carry cwd_fd and exec_fd plus one descriptor per stdio stream at most.
+constexpr std::size_t kMaxMessageFds = 5;
+constexpr std::uint64_t kMaxPayloadBytes = 64ULL * 1024 * 1024;
+
+enum class MessageType : std::uint32_t { spawn = 1, signal, spawn_reply, signal_reply, exited };
+
+struct MessageHeader {
+  std::uint32_t type = 0;
+  std::uint32_t fd_count = 0;
+  std::uint64_t id = 0;
+  std::uint64_t size = 0;
+};
+
+struct Message {
+  MessageType type = MessageType::spawn;
+  std::uint64_t id = 0;
+  std::string payload;
+  std::vector<unique_fd> fds;
+};
+
+using ControlBuffer = std::array<char, CMSG_SPACE(sizeof(int) * kMaxMessageFds)>;
+
+Result<void> send_message(int socket, MessageType type, std::uint64_t id,
+                          std::string_view payload, const std::vector<int>& fds) {
+  if (fds.size() > kMaxMessageFds) {
+    return protocol_error();
+  }
+  MessageHeader header{.type = static_cast<std::uint32_t>(type),
+                       .fd_count = static_cast<std::uint32_t>(fds.size()),
+                       .id = id,
+                       .size = payload.size()};
+  std::array<iovec, 2> iov{iovec{.iov_base = &header, .iov_len = sizeof(header)},
+                           iovec{.iov_base = const_cast<char*>(payload.data()),
+                                 .iov_len = payload.size()}};
+  alignas(cmsghdr) ControlBuffer control{};
+  msghdr msg{};
+  msg.msg_iov = iov.data();
+  msg.msg_iovlen = payload.empty() ? 1 : 2;
+  if (!fds.empty()) {
+    msg.msg_control = control.data();
+    msg.msg_controllen = CMSG_SPACE(sizeof(int) * fds.size());
+    cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int) * fds.size());
+    std::memcpy(CMSG_DATA(cmsg), fds.data(), sizeof(int) * fds.size());
+  }
+
+  const std::size_t total = sizeof(header) + payload.size();
+  ssize_t sent = 0;
+  do {
+    sent = ::sendmsg(socket, &msg, kSendFlags);
+  } while (sent == -1 && errno == EINTR);
+  if (sent == -1) {
+    return make_errno_error("sendmsg");
+  }
+
+  // A stream socket may take only a prefix; the descriptors went with it.
+  auto done = static_cast<std::size_t>(sent);
+  while (done < total) {
+    const char* data = nullptr;
+    std::size_t size = 0;
+    if (done < sizeof(header)) {
+      data = reinterpret_cast<const char*>(&header) + done;
+      size = sizeof(header) - done;
+    } else {
+      data = payload.data() + (done - sizeof(header));
+      size = total - done;
+    }
+    ssize_t written = ::send(socket, data, size, kSendFlags);
+    if (written == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return make_errno_error("send");
+    }
+    done += static_cast<std::size_t>(written);
+  }
+  return {};
+}
+
+void collect_fds(msghdr& msg, std::vector<unique_fd>* fds) {
+  for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+    if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) {
+      continue;
+    }
+    std::size_t count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+    for (std::size_t index = 0; index < count; ++index) {
+      int fd = -1;
+      std::memcpy(&fd, CMSG_DATA(cmsg) + index * sizeof(int), sizeof(int));
+#if !PROCLY_PLATFORM_LINUX
+      (void)internal::set_cloexec(fd);
+#endif
+      fds->emplace_back(fd);
+    }
+  }
+}
+
+// Returns nullopt when the peer closed the connection between messages.
+Result<std::optional<Message>> recv_message(int socket) {
+  MessageHeader header{};
+  std::vector<unique_fd> fds;
+  auto* header_bytes = reinterpret_cast<char*>(&header);
+  std::size_t received = 0;
+  while (received < sizeof(header)) {
+    iovec iov{.iov_base = header_bytes + received, .iov_len = sizeof(header) - received};
+    alignas(cmsghdr) ControlBuffer control{};
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.data();
+    msg.msg_controllen = control.size();
+    ssize_t count = ::recvmsg(socket, &msg, kRecvFlags);
+    if (count == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return make_errno_error("recvmsg");
+    }
+    collect_fds(msg, &fds);
+    if (count == 0) {
+      if (received == 0 && fds.empty()) {
+        return std::optional<Message>();
+      }
+      return protocol_error();
+    }
+    if ((msg.msg_flags & MSG_CTRUNC) != 0) {
+      return protocol_error();
+    }
+    received += static_cast<std::size_t>(count);
+  }
+  if (header.size > kMaxPayloadBytes || header.fd_count != fds.size()) {
+    return protocol_error();
+  }
+
+  Message message;
+  message.type = static_cast<MessageType>(header.type);
+  message.id = header.id;
+  message.payload.resize(header.size);
+  std::size_t done = 0;
+  while (done < message.payload.size()) {
+    ssize_t count =
+        ::recv(socket, message.payload.data() + done, message.payload.size() - done, 0);
+    if (count == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return make_errno_error("recv");
+    }
+    if (count == 0) {
+      return protocol_error();
+    }
+    done += static_cast<std::size_t>(count);
+  }
+  message.fds = std::move(fds);
+  return std::optional<Message>(std::move(message));
+}
+
+void encode_error(Encoder& out, const Error& error) {
+  std::uint8_t category = 2;
+  if (error.code.category() == std::system_category()) {
+    category = 0;
+  } else if (error.code.category() == error_category()) {
+    category = 1;
+  }
+  out.put_u8(category);
+  out.put_i32(error.code.value());
+  out.put_string(error.context);
+}
+
+Error decode_error(Decoder& in) {
+  auto category = in.u8();
+  auto value = in.i32();
+  auto context = in.string();
+  if (in.failed()) {
+    return protocol_error();
+  }
+  std::error_code code(value, std::generic_category());
+  if (category == 0) {
+    code = std::error_code(value, std::system_category());
+  } else if (category == 1) {
+    code = std::error_code(value, error_category());
+  }
+  return Error{.code = code, .context = std::move(context)};
+}
+
+void encode_status(Encoder& out, const ExitStatus& status) {
+  out.put_bool(status.kind() == ExitStatus::Kind::exited);
+  out.put_i32(status.code().value_or(0));
+  out.put_u32(status.native());
+}
+
+ExitStatus decode_status(Decoder& in) {
+  bool exited = in.boolean();
+  auto code = in.i32();
+  auto native = in.u32();
+  return exited ? ExitStatus::exited(code, native) : ExitStatus::other(native);
+}
+
+void encode_stdio(Encoder& out, const StdioSpec& spec, std::vector<int>* fds) {
+  out.put_u8(static_cast<std::uint8_t>(spec.kind));
+  if (spec.kind == StdioSpec::Kind::fd) {
+    fds->push_back(spec.fd);
+  }
+  out.put_u64(spec.pipe_capacity);
+  out.put_string(spec.path.native());
+  out.put_u8(static_cast<std::uint8_t>(spec.mode));
+  out.put_bool(spec.perms.has_value());
+  out.put_u32(static_cast<std::uint32_t>(spec.perms.value_or(0)));
+}
+
+StdioSpec decode_stdio(Decoder& in, const std::vector<unique_fd>& fds, std::size_t* next_fd,
+                       bool* ok) {
+  StdioSpec spec;
+  spec.kind = static_cast<StdioSpec::Kind>(in.u8());
+  if (spec.kind == StdioSpec::Kind::fd) {
+    if (*next_fd >= fds.size()) {
+      *ok = false;
+    } else {
+      spec.fd = fds[(*next_fd)++].get();
+    }
+  }
+  spec.pipe_capacity = in.u64();
+  spec.path = in.string();
+  spec.mode = static_cast<OpenMode>(in.u8());
+  bool has_perms = in.boolean();
+  auto perms = in.u32();
+  if (has_perms) {
+    spec.perms = static_cast<FilePerms>(perms);
+  }
+  return spec;
+}
+
+void encode_spec(Encoder& out, const SpawnSpec& spec, std::vector<int>* fds) {
+  out.put_u32(static_cast<std::uint32_t>(spec.argv.size()));
+  for (const auto& arg : spec.argv) {
+    out.put_string(arg);
+  }
+  out.put_bool(spec.exec_path.has_value());
+  out.put_string(spec.exec_path.value_or(std::string()));
+  out.put_bool(spec.cwd.has_value());
+  out.put_string(spec.cwd ? spec.cwd->native() : std::string());
+  out.put_bool(spec.cwd_fd.has_value());
+  if (spec.cwd_fd) {
+    fds->push_back(*spec.cwd_fd);
+  }
+  out.put_bool(spec.exec_fd.has_value());
+  if (spec.exec_fd) {
+    fds->push_back(*spec.exec_fd);
+  }
+  out.put_u32(static_cast<std::uint32_t>(spec.envp.size()));
+  for (auto entry : spec.envp) {
+    out.put_string(entry);
+  }
+  encode_stdio(out, spec.stdin_spec, fds);
+  encode_stdio(out, spec.stdout_spec, fds);
+  encode_stdio(out, spec.stderr_spec, fds);
+  out.put_bool(spec.opts.new_process_group);
+  out.put_bool(spec.opts.merge_stderr_into_stdout);
+  out.put_bool(spec.opts.trust_cloexec);
+  out.put_u8(static_cast<std::uint8_t>(spec.opts.path_lookup));
+  out.put_u8(static_cast<std::uint8_t>(spec.opts.fork_strategy));
+  out.put_u32(static_cast<std::uint32_t>(spec.opts.limits.size()));
+  for (const auto& limit : spec.opts.limits) {
+    out.put_i32(limit.resource);
+    out.put_u64(limit.soft);
+    out.put_u64(limit.hard);
+  }
+  out.put_bool(spec.opts.nice.has_value());
+  out.put_i32(spec.opts.nice.value_or(0));
+#if PROCLY_PLATFORM_LINUX
+  out.put_u32(static_cast<std::uint32_t>(spec.opts.cpu_affinity.size()));
+  for (int cpu : spec.opts.cpu_affinity) {
+    out.put_i32(cpu);
+  }
+  out.put_u8(static_cast<std::uint8_t>(spec.opts.scheduling_policy));
+  out.put_bool(spec.opts.io_priority.has_value());
+  out.put_u8(static_cast<std::uint8_t>(spec.opts.io_priority.value_or(IoPriority{}).io_class));
+  out.put_i32(spec.opts.io_priority.value_or(IoPriority{}).level);
+  out.put_bool(spec.opts.cgroup.has_value());
+  out.put_string(spec.opts.cgroup ? spec.opts.cgroup->native() : std::string());
+  out.put_u32(static_cast<std::uint32_t>(spec.opts.numa_nodes.size()));
+  for (int node : spec.opts.numa_nodes) {
+    out.put_i32(node);
+  }
+  out.put_u8(static_cast<std::uint8_t>(spec.opts.numa_policy));
+#endif
+  out.put_bool(spec.process_group.has_value());
+  out.put_i32(spec.process_group.value_or(0));
+}
+
+// Descriptors in the spec are borrowed from `fds`, which must outlive the spawn.
+std::optional<SpawnSpec> decode_spec(Decoder& in, const std::vector<unique_fd>& fds) {
+  SpawnSpec spec;
+  bool ok = true;
+  std::size_t next_fd = 0;
+  auto argc = in.u32();
+  for (std::uint32_t index = 0; index < argc && !in.failed(); ++index) {
+    spec.argv.push_back(in.string());
+  }
+  bool has_exec_path = in.boolean();
+  auto exec_path = in.string();
+  if (has_exec_path) {
+    spec.exec_path = std::move(exec_path);
+  }
+  bool has_cwd = in.boolean();
+  auto cwd = in.string();
+  if (has_cwd) {
+    spec.cwd = std::move(cwd);
+  }
+  if (in.boolean()) {
+    if (next_fd >= fds.size()) {
+      return std::nullopt;
+    }
+    spec.cwd_fd = fds[next_fd++].get();
+  }
+  if (in.boolean()) {
+    if (next_fd >= fds.size()) {
+      return std::nullopt;
+    }
+    spec.exec_fd = fds[next_fd++].get();
+  }
+  auto env_count = in.u32();
+  std::vector<std::string> env;
+  for (std::uint32_t index = 0; index < env_count && !in.failed(); ++index) {
+    env.push_back(in.string());
+  }
+  std::vector<std::string_view> entries(env.begin(), env.end());
+  spec.envp = internal::EnvBlock::from_entries(entries);
+  spec.stdin_spec = decode_stdio(in, fds, &next_fd, &ok);
+  spec.stdout_spec = decode_stdio(in, fds, &next_fd, &ok);
+  spec.stderr_spec = decode_stdio(in, fds, &next_fd, &ok);
+  spec.opts.new_process_group = in.boolean();
+  spec.opts.merge_stderr_into_stdout = in.boolean();
+  spec.opts.trust_cloexec = in.boolean();
+  spec.opts.path_lookup = static_cast<PathLookup>(in.u8());
+  spec.opts.fork_strategy = static_cast<ForkStrategy>(in.u8());
+  auto limit_count = in.u32();
+  for (std::uint32_t index = 0; index < limit_count && !in.failed(); ++index) {
+    ResourceLimit limit;
+    limit.resource = in.i32();
+    limit.soft = in.u64();
+    limit.hard = in.u64();
+    spec.opts.limits.push_back(limit);
+  }
+  bool has_nice = in.boolean();
+  auto nice = in.i32();
+  if (has_nice) {
+    spec.opts.nice = nice;
+  }
+#if PROCLY_PLATFORM_LINUX
+  auto cpu_count = in.u32();
+  for (std::uint32_t index = 0; index < cpu_count && !in.failed(); ++index) {
+    spec.opts.cpu_affinity.push_back(in.i32());
+  }
+  spec.opts.scheduling_policy = static_cast<SchedulingPolicy>(in.u8());
+  bool has_io_priority = in.boolean();
+  IoPriority io_priority;
+  io_priority.io_class = static_cast<IoPriorityClass>(in.u8());
+  io_priority.level = in.i32();
+  if (has_io_priority) {
+    spec.opts.io_priority = io_priority;
+  }
+  bool has_cgroup = in.boolean();
+  auto cgroup = in.string();
+  if (has_cgroup) {
+    spec.opts.cgroup = std::move(cgroup);
+  }
+  auto node_count = in.u32();
+  for (std::uint32_t index = 0; index < node_count && !in.failed(); ++index) {
+    spec.opts.numa_nodes.push_back(in.i32());
+  }
+  spec.opts.numa_policy = static_cast<NumaPolicy>(in.u8());
+#endif
+  bool has_group = in.boolean();
+  auto group = in.i32();
+  if (has_group) {
+    spec.process_group = group;
+  }
+  if (!ok || in.failed()) {
+    return std::nullopt;
+  }
+  return spec;
+}
+
+// Server side ---------------------------------------------------------------------------------
+
+int g_sigchld_fd = -1;
+
+void on_sigchld(int) {
+  int saved_errno = errno;
+  char byte = 0;
+  (void)::write(g_sigchld_fd, &byte, 1);
+  errno = saved_errno;
+}
+
+// Drop every descriptor inherited from the client except stdio and the socket, so pipes the
+// client opened before start() still see EOF once the client closes them.
+void close_inherited(int keep_fd) {
+  std::vector<int> open_fds;
+  if (DIR* dir = ::opendir("/dev/fd")) {
+    while (dirent* entry = ::readdir(dir)) {
+      char* end = nullptr;
+      long fd = std::strtol(entry->d_name, &end, 10);
+      if (end != entry->d_name && *end == '\0') {
+        open_fds.push_back(static_cast<int>(fd));
+      }
+    }
+    ::closedir(dir);
+  }
+  for (int fd : open_fds) {
+    if (fd > STDERR_FILENO && fd != keep_fd) {
+      ::close(fd);
+    }
+  }
+}
+
+class Server {
+ public:
+  explicit Server(int socket) : socket_(socket) {}
+
+  void run(int wake_fd) {
+    while (true) {
+      std::array<pollfd, 2> fds{pollfd{.fd = socket_, .events = POLLIN, .revents = 0},
+                                pollfd{.fd = wake_fd, .events = POLLIN, .revents = 0}};
+      if (::poll(fds.data(), fds.size(), -1) == -1) {
+        if (errno == EINTR) {
+          continue;
+        }
+        return;
+      }
+      if (fds[1].revents != 0) {
+        std::array<char, 64> drain{};
+        while (::read(wake_fd, drain.data(), drain.size()) > 0) {
+        }
+      }
+      // Reap on every wakeup: a SIGCHLD may land while a request is being handled.
+      if (!reap()) {
+        return;
+      }
+      if (fds[0].revents != 0) {
+        auto message = recv_message(socket_);
+        if (!message || !message.value().has_value()) {
+          return;
+        }
+        if (!handle(*message.value())) {
+          return;
+        }
+      }
+    }
+  }
+
+ private:
+  bool reap() {
+    while (true) {
+      int status = 0;
+      pid_t pid = ::waitpid(-1, &status, WNOHANG);
+      if (pid <= 0) {
+        return true;
+      }
+      children_.erase(pid);
+      ExitStatus exit_status = WIFEXITED(status)
+                                   ? ExitStatus::exited(WEXITSTATUS(status),
+                                                        static_cast<std::uint32_t>(status))
+                                   : ExitStatus::other(static_cast<std::uint32_t>(status));
+      Encoder out;
+      out.put_i32(pid);
+      encode_status(out, exit_status);
+      if (!send_message(socket_, MessageType::exited, 0, out.bytes(), {})) {
+        return false;
+      }
+    }
+  }
+
+  bool handle(Message& message) {
+    switch (message.type) {
+      case MessageType::spawn:
+        return handle_spawn(message);
+      case MessageType::signal:
+        return handle_signal(message);
+      default:
+        return false;
+    }
+  }
+
+  bool handle_spawn(Message& message) {
+    Decoder in(message.payload);
+    auto spec = decode_spec(in, message.fds);
+    Encoder out;
+    if (!spec) {
+      out.put_bool(false);
+      encode_error(out, protocol_error());
+      return static_cast<bool>(
+          send_message(socket_, MessageType::spawn_reply, message.id, out.bytes(), {}));
+    }
+    auto spawned = native_backend().spawn(*spec);
+    if (!spawned) {
+      out.put_bool(false);
+      encode_error(out, spawned.error());
+      return static_cast<bool>(
+          send_message(socket_, MessageType::spawn_reply, message.id, out.bytes(), {}));
+    }
+
+    Spawned& child = spawned.value();
+    std::vector<unique_fd> owned;
+    std::vector<int> fds;
+    std::uint8_t mask = 0;
+    std::uint8_t bit = 1;
+    for (auto* fd : {&child.stdin_fd, &child.stdout_fd, &child.stderr_fd}) {
+      if (*fd) {
+        mask |= bit;
+        fds.push_back(**fd);
+        owned.emplace_back(**fd);
+        fd->reset();
+      }
+      bit <<= 1;
+    }
+    out.put_bool(true);
+    out.put_i32(child.pid);
+    out.put_bool(child.pgid.has_value());
+    out.put_i32(child.pgid.value_or(0));
+    out.put_bool(child.new_process_group);
+    out.put_u8(mask);
+    children_.emplace(child.pid, child);
+    return static_cast<bool>(
+        send_message(socket_, MessageType::spawn_reply, message.id, out.bytes(), fds));
+  }
+
+  bool handle_signal(const Message& message) {
+    Decoder in(message.payload);
+    auto pid = in.i32();
+    auto signo = in.i32();
+    auto result = [&]() -> Result<void> {
+      if (in.failed()) {
+        return protocol_error();
+      }
+      // Children already reaped are not signalled: their exit message is on its way.
+      auto it = children_.find(pid);
+      if (it == children_.end()) {
+        return {};
+      }
+      return native_backend().signal(it->second, signo);
+    }();
+    Encoder out;
+    out.put_bool(result.has_value());
+    if (!result) {
+      encode_error(out, result.error());
+    }
+    return static_cast<bool>(
+        send_message(socket_, MessageType::signal_reply, message.id, out.bytes(), {}));
+  }
+
+  int socket_;
+  std::unordered_map<int, Spawned> children_;
+};
+
+[[noreturn]] void run_server(int socket) {
+  close_inherited(socket);
+  auto wake = internal::create_pipe();
+  if (!wake || !internal::set_nonblocking(wake->first.get()) ||
+      !internal::set_nonblocking(wake->second.get())) {
+    ::_exit(EXIT_FAILURE);
+  }
+  g_sigchld_fd = wake->second.get();
+
+  struct sigaction action{};
+  action.sa_handler = on_sigchld;
+  sigemptyset(&action.sa_mask);
+  action.sa_flags = SA_RESTART | SA_NOCLDSTOP;
+  ::sigaction(SIGCHLD, &action, nullptr);
+  sigset_t unblock;
+  sigemptyset(&unblock);
+  sigaddset(&unblock, SIGCHLD);
+  ::sigprocmask(SIG_UNBLOCK, &unblock, nullptr);
+
+  Server server(socket);
+  server.run(wake->first.get());
+  ::_exit(EXIT_SUCCESS);
+}
+
+}  // namespace
+
+// Client side ---------------------------------------------------------------------------------
+
+struct ForkServer::Impl final : internal::RemoteBackend<Message> {
+  Impl(unique_fd socket, pid_t server_pid)
+      : RemoteBackend("fork_server disconnected"),
+        socket_(std::move(socket)),
+        server_pid_(server_pid) {
+    reader_ = std::thread([this] { read_loop(); });
+  }
+
+  Impl(const Impl&) = delete;
+  Impl& operator=(const Impl&) = delete;
+
+  ~Impl() override {
+    ::shutdown(socket_.get(), SHUT_RDWR);
+    reader_.join();
+    int status = 0;
+    while (::waitpid(server_pid_, &status, 0) == -1 && errno == EINTR) {
+    }
+  }
+
+  Result<Spawned> spawn(const SpawnSpec& spec) override {
+    Encoder out;
+    std::vector<int> fds;
+    encode_spec(out, spec, &fds);
+    auto reply = request(MessageType::spawn, out.bytes(), fds);
+    if (!reply) {
+      return reply.error();
+    }
+    Decoder in(reply->payload);
+    if (!in.boolean()) {
+      return decode_error(in);
+    }
+    Spawned spawned;
+    spawned.pid = in.i32();
+    bool has_pgid = in.boolean();
+    auto pgid = in.i32();
+    if (has_pgid) {
+      spawned.pgid = pgid;
+    }
+    spawned.new_process_group = in.boolean();
+    auto mask = in.u8();
+    if (in.failed()) {
+      return protocol_error();
+    }
+    std::size_t next_fd = 0;
+    std::uint8_t bit = 1;
+    for (auto* fd : {&spawned.stdin_fd, &spawned.stdout_fd, &spawned.stderr_fd}) {
+      if ((mask & bit) != 0) {
+        if (next_fd >= reply->fds.size()) {
+          return protocol_error();
+        }
+        *fd = reply->fds[next_fd++].release();
+      }
+      bit <<= 1;
+    }
+    return spawned;
+  }
+
+  Result<void> signal(Spawned& spawned, int signo) override {
+    if (spawned.terminal_result) {
+      return {};
+    }
+    if (spawned.pid <= 0) {
+      return Error{.code = make_error_code(errc::kill_failed), .context = "kill"};
+    }
+    Encoder out;
+    out.put_i32(spawned.pid);
+    out.put_i32(signo);
+    auto reply = request(MessageType::signal, out.bytes(), {});
+    if (!reply) {
+      return reply.error();
+    }
+    Decoder in(reply->payload);
+    if (in.boolean()) {
+      return {};
+    }
+    return decode_error(in);
+  }
+
+  [[nodiscard]] int id() const noexcept { return server_pid_; }
+
+ private:
+  Result<Message> request(MessageType type, std::string_view payload,
+                          const std::vector<int>& fds) {
+    return RemoteBackend::request([&](std::uint64_t id) {
+      return send_message(socket_.get(), type, id, payload, fds);
+    });
+  }
+
+  void read_loop() {
+    while (true) {
+      auto message = recv_message(socket_.get());
+      if (!message || !message.value().has_value()) {
+        break;
+      }
+      Message& received = *message.value();
+      Decoder in(received.payload);
+      if (received.type == MessageType::exited) {
+        auto pid = in.i32();
+        deliver_exit(pid, decode_status(in));
+        continue;
+      }
+      std::optional<int> spawned_pid;
+      if (received.type == MessageType::spawn_reply && in.boolean()) {
+        spawned_pid = in.i32();
+      }
+      auto id = received.id;
+      deliver_reply(id, std::move(received), spawned_pid);
+    }
+    disconnect();
+  }
+
+  unique_fd socket_;
+  pid_t server_pid_;
+  std::thread reader_;
+};
+
+ForkServer::Scope::Scope(ForkServer& server)
+    : override_(std::make_unique<ScopedBackend>(*server.impl_)) {}
+
+ForkServer::Scope::~Scope() = default;
+
+Result<ForkServer> ForkServer::start() {
+  std::array<int, 2> sockets{-1, -1};
+  if (::socketpair(AF_UNIX, SOCK_STREAM, 0, sockets.data()) == -1) {
+    return make_errno_error("socketpair");
+  }
+  unique_fd client(sockets[0]);
+  unique_fd server(sockets[1]);
+  for (const auto& fd : {client.get(), server.get()}) {
+    auto cloexec = internal::set_cloexec(fd);
+    if (!cloexec) {
+      return cloexec.error();
+    }
+#if defined(SO_NOSIGPIPE)
+    int enabled = 1;
+    ::setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &enabled, sizeof(enabled));
+#endif
+  }
+
+  pid_t pid = ::fork();
+  if (pid == -1) {
+    return make_errno_error("fork");
+  }
+  if (pid == 0) {
+    run_server(server.get());
+  }
+  server.reset(-1);
+  return ForkServer(std::make_unique<Impl>(std::move(client), pid));
+}
+
+ForkServer::ForkServer(std::unique_ptr<Impl> impl) noexcept : impl_(std::move(impl)) {}
+
+ForkServer::ForkServer(ForkServer&& other) noexcept = default;
+
+ForkServer& ForkServer::operator=(ForkServer&& other) noexcept = default;
+
+ForkServer::~ForkServer() = default;
+
+int ForkServer::id() const noexcept { return impl_ ? impl_->id() : -1; }
+
+Backend& ForkServer::backend() noexcept { return *impl_; }
+
+}  // namespace procly
@@ -0,0 +1,57 @@
+#include "procly/function_stage.hpp"
+
+#include <vector>
+
+#include "procly/output_sink.hpp"
+
+namespace procly {
+
+namespace {
+
+// Read size for transform_lines, and the output batched before each write.
+constexpr std::size_t kLineStageBytes = 64 * 1024;
+
+}  // namespace
+
+FunctionStage transform(FunctionStage::Body body) { return FunctionStage(std::move(body)); }
+
+FunctionStage transform_lines(LineTransform fn, std::string delimiter) {
+  return FunctionStage([fn = std::move(fn), delimiter = std::move(delimiter)](
+                           PipeReader& in, PipeWriter& out) -> Result<void> {
+    std::string pending;
+    bool running = true;
+    // The line sink splits in place and only copies lines that straddle reads.
+    auto lines = OutputSink::lines(
+        [&](std::string_view line) {
+          if (running) {
+            running = fn(line, pending);
+          }
+        },
+        delimiter);
+    std::vector<char> buffer(kLineStageBytes);
+    while (running) {
+      auto count = in.read_some(buffer.data(), buffer.size());
+      if (!count) {
+        return count.error();
+      }
+      if (count.value() == 0) {
+        lines.finish();
+        break;
+      }
+      lines.write(buffer.data(), count.value());
+      if (pending.size() >= kLineStageBytes) {
+        auto written = out.write_all(pending);
+        if (!written) {
+          return written.error();
+        }
+        pending.clear();
+      }
+    }
+    if (pending.empty()) {
+      return {};
+    }
+    return out.write_all(pending);
+  });
+}
+
+}  // namespace procly
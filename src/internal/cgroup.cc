@@ -0,0 +1,117 @@
+#include "procly/internal/cgroup.hpp"
+
+#if PROCLY_PLATFORM_LINUX
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <string_view>
+#include <system_error>
+
+#include "procly/internal/fd.hpp"
+
+namespace procly::internal {
+
+namespace {
+
+Error make_errno_error(const char* context) {
+  return Error{.code = std::error_code(errno, std::system_category()), .context = context};
+}
+
+Result<unique_fd> open_control(const std::filesystem::path& cgroup, const char* name, int flags,
+                               const char* context) {
+  unique_fd fd(::open((cgroup / name).c_str(), flags | O_CLOEXEC));
+  if (!fd) {
+    return make_errno_error(context);
+  }
+  return fd;
+}
+
+// Reads the "populated" key from an open cgroup.events, from the start of the file.
+Result<bool> read_populated(int fd) {
+  constexpr std::size_t kEventsSize = 256;
+  std::array<char, kEventsSize> buffer{};
+  ssize_t count = -1;
+  do {
+    count = ::pread(fd, buffer.data(), buffer.size(), 0);
+  } while (count == -1 && errno == EINTR);
+  if (count == -1) {
+    return make_errno_error("read(cgroup.events)");
+  }
+  std::string_view events(buffer.data(), static_cast<std::size_t>(count));
+  constexpr std::string_view kKey = "populated ";
+  auto at = events.find(kKey);
+  if (at == std::string_view::npos || at + kKey.size() >= events.size()) {
+    return Error{.code = std::make_error_code(std::errc::protocol_error),
+                 .context = "read(cgroup.events)"};
+  }
+  return events[at + kKey.size()] != '0';
+}
+
+}  // namespace
+
+Result<void> cgroup_kill(const std::filesystem::path& cgroup) {
+  auto fd = open_control(cgroup, "cgroup.kill", O_WRONLY, "open(cgroup.kill)");
+  if (!fd) {
+    return fd.error();
+  }
+  ssize_t written = -1;
+  do {
+    written = ::write(fd->get(), "1", 1);
+  } while (written == -1 && errno == EINTR);
+  if (written != 1) {
+    return make_errno_error("write(cgroup.kill)");
+  }
+  return {};
+}
+
+Result<bool> cgroup_populated(const std::filesystem::path& cgroup) {
+  auto fd = open_control(cgroup, "cgroup.events", O_RDONLY, "open(cgroup.events)");
+  if (!fd) {
+    return fd.error();
+  }
+  return read_populated(fd->get());
+}
+
+Result<void> cgroup_wait_empty(const std::filesystem::path& cgroup,
+                               std::optional<std::chrono::milliseconds> timeout) {
+  auto fd = open_control(cgroup, "cgroup.events", O_RDONLY, "open(cgroup.events)");
+  if (!fd) {
+    return fd.error();
+  }
+  std::optional<std::chrono::steady_clock::time_point> deadline;
+  if (timeout) {
+    deadline = std::chrono::steady_clock::now() + *timeout;
+  }
+  while (true) {
+    // Re-read after arming: the kernel flags the file on every change after the last read.
+    auto populated = read_populated(fd->get());
+    if (!populated) {
+      return populated.error();
+    }
+    if (!populated.value()) {
+      return {};
+    }
+    int wait_ms = -1;
+    if (deadline) {
+      auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+          *deadline - std::chrono::steady_clock::now());
+      if (left.count() <= 0) {
+        return Error{.code = make_error_code(errc::timeout), .context = "cgroup.events"};
+      }
+      wait_ms = static_cast<int>(left.count());
+    }
+    pollfd watched{.fd = fd->get(), .events = POLLPRI, .revents = 0};
+    if (::poll(&watched, 1, wait_ms) == -1 && errno != EINTR) {
+      return make_errno_error("poll(cgroup.events)");
+    }
+  }
+}
+
+}  // namespace procly::internal
+
+#endif
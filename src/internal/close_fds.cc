@@ -0,0 +1,209 @@
+#include "procly/internal/close_fds.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+
+#include "procly/platform.hpp"
+
+#if PROCLY_PLATFORM_LINUX
+#include <sys/syscall.h>
+#endif
+#if PROCLY_PLATFORM_MACOS
+#include <libproc.h>
+#endif
+
+namespace procly::internal {
+
+namespace {
+
+constexpr long kFallbackMaxFd = 256;
+
+// Descriptors that survive, in ascending order; -1 marks an unused slot.
+struct KeptFds {
+  int low = -1;
+  int high = -1;
+
+  [[nodiscard]] bool contains(int fd) const noexcept { return fd == low || fd == high; }
+};
+
+#if PROCLY_PLATFORM_LINUX
+// CLOSE_RANGE_CLOEXEC (Linux 5.11+); spelled out so older kernel headers still build.
+constexpr unsigned int kCloseRangeCloexec = 1U << 2;
+constexpr unsigned int kMaxFd = ~0U;
+
+// linux_dirent64 layout: u64 d_ino, s64 d_off, u16 d_reclen, u8 d_type, char d_name[].
+constexpr std::size_t kDirentReclenOffset = 16;
+constexpr std::size_t kDirentNameOffset = 19;
+constexpr std::size_t kDirentBufferSize = 4096;
+
+// Returns false when close_range is unavailable so the caller can fall back.
+bool close_range_compat(unsigned int first, unsigned int last) {
+#ifdef SYS_close_range
+  if (first > last) {
+    return true;
+  }
+  if (::syscall(SYS_close_range, first, last, kCloseRangeCloexec) == 0) {
+    return true;
+  }
+  // Linux 5.9/5.10 know close_range but reject CLOSE_RANGE_CLOEXEC.
+  if (errno == EINVAL) {
+    return ::syscall(SYS_close_range, first, last, 0U) == 0;
+  }
+  return false;
+#else
+  (void)first;
+  (void)last;
+  return false;
+#endif
+}
+
+bool close_fd_ranges(int first_fd, const KeptFds& keep) {
+  auto next = static_cast<unsigned int>(first_fd);
+  for (int keep_fd : {keep.low, keep.high}) {
+    if (keep_fd < 0 || static_cast<unsigned int>(keep_fd) < next) {
+      continue;
+    }
+    auto kept = static_cast<unsigned int>(keep_fd);
+    if (kept > next && !close_range_compat(next, kept - 1)) {
+      return false;
+    }
+    if (kept == kMaxFd) {
+      return true;
+    }
+    next = kept + 1;
+  }
+  return close_range_compat(next, kMaxFd);
+}
+
+bool parse_fd_name(const char* name, int* out) {
+  if (name[0] < '0' || name[0] > '9') {
+    return false;
+  }
+  int value = 0;
+  constexpr int kBase = 10;
+  for (const char* cursor = name; *cursor != '\0'; ++cursor) {
+    if (*cursor < '0' || *cursor > '9') {
+      return false;
+    }
+    value = value * kBase + (*cursor - '0');
+  }
+  *out = value;
+  return true;
+}
+
+// Walk /proc/self/fd with raw getdents64 so no allocation happens in the child.
+bool close_listed_fds(int first_fd, const KeptFds& keep) {
+  int dir_fd = ::open("/proc/self/fd", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (dir_fd == -1) {
+    return false;
+  }
+  std::array<char, kDirentBufferSize> buffer{};
+  while (true) {
+    long count = ::syscall(SYS_getdents64, dir_fd, buffer.data(), buffer.size());
+    if (count == -1 && errno == EINTR) {
+      continue;
+    }
+    if (count <= 0) {
+      ::close(dir_fd);
+      return count == 0;
+    }
+    std::size_t offset = 0;
+    while (offset < static_cast<std::size_t>(count)) {
+      std::uint16_t reclen = 0;
+      std::memcpy(&reclen, buffer.data() + offset + kDirentReclenOffset, sizeof(reclen));
+      int fd = -1;
+      if (parse_fd_name(buffer.data() + offset + kDirentNameOffset, &fd) && fd >= first_fd &&
+          !keep.contains(fd) && fd != dir_fd) {
+        ::close(fd);
+      }
+      offset += reclen;
+    }
+  }
+}
+#elif PROCLY_PLATFORM_MACOS
+constexpr std::size_t kFdInfoBatch = 512;
+
+// proc_pidinfo is a thin syscall wrapper; re-query until no closable descriptors remain.
+bool close_listed_fds(int first_fd, const KeptFds& keep) {
+  std::array<proc_fdinfo, kFdInfoBatch> infos{};
+  const int buffer_bytes = static_cast<int>(sizeof(proc_fdinfo) * infos.size());
+  while (true) {
+    int filled = ::proc_pidinfo(::getpid(), PROC_PIDLISTFDS, 0, infos.data(), buffer_bytes);
+    if (filled <= 0) {
+      return false;
+    }
+    std::size_t count = static_cast<std::size_t>(filled) / sizeof(proc_fdinfo);
+    bool closed_any = false;
+    for (std::size_t i = 0; i < count; ++i) {
+      int fd = infos[i].proc_fd;
+      if (fd >= first_fd && !keep.contains(fd)) {
+        ::close(fd);
+        closed_any = true;
+      }
+    }
+    if (!closed_any) {
+      return count < infos.size();
+    }
+  }
+}
+#else
+bool close_listed_fds(int first_fd, const KeptFds& keep) {
+#if defined(__FreeBSD__) || defined(__OpenBSD__) || defined(__NetBSD__) || defined(__DragonFly__)
+  int next = first_fd;
+  for (int keep_fd : {keep.low, keep.high}) {
+    if (keep_fd < next) {
+      continue;
+    }
+    for (int fd = next; fd < keep_fd; ++fd) {
+      ::close(fd);
+    }
+    next = keep_fd + 1;
+  }
+  ::closefrom(next);
+  return true;
+#else
+  (void)first_fd;
+  (void)keep;
+  return false;
+#endif
+}
+#endif
+
+void close_fds_up_to_limit(int first_fd, const KeptFds& keep) {
+  long max_fd = ::sysconf(_SC_OPEN_MAX);
+  if (max_fd < 0) {
+    max_fd = kFallbackMaxFd;
+  }
+  for (int fd = first_fd; fd < max_fd; ++fd) {
+    if (keep.contains(fd)) {
+      continue;
+    }
+    ::close(fd);
+  }
+}
+
+}  // namespace
+
+void close_inherited_fds(int first_fd, int keep_fd, int extra_keep_fd) noexcept {
+  int saved_errno = errno;
+  KeptFds keep;
+  keep.low = keep_fd < extra_keep_fd ? keep_fd : extra_keep_fd;
+  keep.high = keep_fd < extra_keep_fd ? extra_keep_fd : keep_fd;
+#if PROCLY_PLATFORM_LINUX
+  if (close_fd_ranges(first_fd, keep)) {
+    errno = saved_errno;
+    return;
+  }
+#endif
+  if (!close_listed_fds(first_fd, keep)) {
+    close_fds_up_to_limit(first_fd, keep);
+  }
+  errno = saved_errno;
+}
+
+}  // namespace procly::internal
@@ -0,0 +1,428 @@
+#include "procly/internal/command_run.hpp"
+
+#include <stdlib.h>
+#if PROCLY_PLATFORM_LINUX
+#include <sys/mman.h>
+#endif
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <utility>
+
+#include "procly/internal/compressor.hpp"
+#include "procly/internal/io_drain.hpp"
+#include "procly/internal/spill_writer.hpp"
+
+namespace procly::internal {
+
+namespace {
+
+// Fresh read-only description of a Stdio::bytes file at offset 0: reopened through /proc on
+// Linux, rebuilt from the payload where that is unavailable.
+Result<unique_fd> reopen_bytes(const StdioSpec& spec) {
+#if PROCLY_PLATFORM_LINUX
+  std::string path = "/proc/self/fd/" + std::to_string(spec.fd);
+  unique_fd reopened(::open(path.c_str(), O_RDONLY | O_CLOEXEC));
+  if (reopened) {
+    return reopened;
+  }
+#endif
+  return create_sealed_file("procly-stdin", *spec.bytes);
+}
+
+}  // namespace
+
+Result<Spawned> spawn_lowered(const SpawnSpec& spec, Backend* backend) {
+  if (backend == nullptr) {
+    backend = &default_backend();
+  }
+  // A reused spec (PreparedCommand) may spawn children concurrently, so each one reads
+  // Stdio::bytes through its own file offset.
+  std::optional<SpawnSpec> own_stdin;
+  if (spec.stdin_spec.bytes) {
+    auto file = reopen_bytes(spec.stdin_spec);
+    if (!file) {
+      return file.error();
+    }
+    own_stdin.emplace(spec);
+    auto owned = std::make_shared<const unique_fd>(std::move(file.value()));
+    own_stdin->stdin_spec.fd = owned->get();
+    own_stdin->stdin_spec.fd_owner = std::move(owned);
+  }
+  auto spawned = backend->spawn(own_stdin ? *own_stdin : spec);
+  if (!spawned) {
+    return spawned.error();
+  }
+  spawned->backend = backend;
+#if PROCLY_PLATFORM_LINUX
+  spawned->cgroup = spec.opts.cgroup;
+#endif
+  return spawned.value();
+}
+
+namespace {
+
+// Drain deadline that escalates against child once cancel fires; empty without a token.
+Result<std::optional<DrainDeadline>> cancel_deadline(Child& child,
+                                                     const CancellationToken* cancel) {
+  if (cancel == nullptr) {
+    return std::optional<DrainDeadline>();
+  }
+  auto cancel_fd = cancel->wait_handle();
+  if (!cancel_fd) {
+    (void)child.kill();
+    (void)child.wait();
+    return cancel_fd.error();
+  }
+  DrainDeadline deadline;
+  deadline.cancel_fd = cancel_fd.value();
+  deadline.kill_grace = WaitOptions::kDefaultKillGrace;
+  deadline.terminate = [&child] { (void)child.terminate(); };
+  deadline.kill = [&child] { (void)child.kill(); };
+  return std::optional<DrainDeadline>(std::move(deadline));
+}
+
+// Reap child, finishing any escalation the drain started and still watching the token.
+Result<ExitStatus> reap(Child& child, const CancellationToken* cancel,
+                        const std::optional<DrainDeadline>& deadline) {
+  if (cancel == nullptr) {
+    return child.wait();
+  }
+  WaitOptions wait;
+  wait.cancel = *cancel;
+  auto waited = child.wait(deadline ? reap_options(*deadline, wait) : wait);
+  if (!waited) {
+    return waited.error();
+  }
+  if ((deadline && deadline->cancelled) || waited->cancelled) {
+    return Error{.code = make_error_code(errc::cancelled), .context = "wait"};
+  }
+  return waited->status;
+}
+
+// Feed stdin from feed (its pipe is filled in here) while capturing output, then wait.
+Result<Output> finish_fed_output(Child& child, StdinFeed feed, const CaptureOptions& options) {
+  auto stdin_pipe = child.take_stdin();
+  auto stdout_pipe = child.take_stdout();
+  auto stderr_pipe = child.take_stderr();
+  feed.pipe = stdin_pipe ? &*stdin_pipe : nullptr;
+  auto drained = drain_pipes(std::move(feed), stdout_pipe ? &*stdout_pipe : nullptr,
+                             stderr_pipe ? &*stderr_pipe : nullptr, options,
+                             [&child] { (void)child.kill(); });
+  if (!drained) {
+    return drained.error();
+  }
+  auto status = child.wait();
+  if (!status) {
+    return status.error();
+  }
+  Output output;
+  output.status = status.value();
+  output.stdout_data = std::move(drained->stdout_data);
+  output.stderr_data = std::move(drained->stderr_data);
+  output.stdout_dropped = drained->stdout_dropped;
+  output.stderr_dropped = drained->stderr_dropped;
+  output.stdout_digest = std::move(drained->stdout_digest);
+  output.stderr_digest = std::move(drained->stderr_digest);
+  return output;
+}
+
+}  // namespace
+
+Result<ExitStatus> finish_status(Child& child, const CancellationToken* cancel) {
+  auto stdin_pipe = child.take_stdin();
+  if (stdin_pipe) {
+    stdin_pipe->close();
+  }
+  auto cancelling = cancel_deadline(child, cancel);
+  if (!cancelling) {
+    return cancelling.error();
+  }
+  auto& deadline = cancelling.value();
+  auto stdout_pipe = child.take_stdout();
+  auto stderr_pipe = child.take_stderr();
+  if (stdout_pipe || stderr_pipe) {
+    auto drained = drain_pipes(
+        StdinFeed{}, stdout_pipe ? &*stdout_pipe : nullptr, stderr_pipe ? &*stderr_pipe : nullptr,
+        CaptureOptions{}, {}, {}, deadline ? &*deadline : nullptr);
+    if (!drained) {
+      return drained.error();
+    }
+  }
+  return reap(child, cancel, deadline);
+}
+
+Result<Output> finish_output(Child& child, const CaptureOptions& options,
+                             const CancellationToken* cancel) {
+  auto stdin_pipe = child.take_stdin();
+  if (stdin_pipe) {
+    stdin_pipe->close();
+  }
+  auto cancelling = cancel_deadline(child, cancel);
+  if (!cancelling) {
+    return cancelling.error();
+  }
+  auto& deadline = cancelling.value();
+  auto stdout_pipe = child.take_stdout();
+  auto stderr_pipe = child.take_stderr();
+  auto drained = drain_pipes(
+      StdinFeed{}, stdout_pipe ? &*stdout_pipe : nullptr, stderr_pipe ? &*stderr_pipe : nullptr,
+      options, [&child] { (void)child.kill(); }, {},
+      deadline ? &*deadline : nullptr);
+  if (!drained) {
+    return drained.error();
+  }
+  auto status = reap(child, cancel, deadline);
+  if (!status) {
+    return status.error();
+  }
+  Output output;
+  output.status = status.value();
+  output.stdout_data = std::move(drained->stdout_data);
+  output.stderr_data = std::move(drained->stderr_data);
+  output.stdout_dropped = drained->stdout_dropped;
+  output.stderr_dropped = drained->stderr_dropped;
+  output.stdout_digest = std::move(drained->stdout_digest);
+  output.stderr_digest = std::move(drained->stderr_digest);
+  return output;
+}
+
+Result<Output> finish_output_with_input(Child& child, std::string_view input,
+                                        const CaptureOptions& options) {
+  return finish_fed_output(child, StdinFeed{.data = input}, options);
+}
+
+Result<Output> finish_output_with_input(Child& child, StdinSource& input,
+                                        const CaptureOptions& options) {
+  return finish_fed_output(child, StdinFeed{.source = &input}, options);
+}
+
+Result<ExitStatus> finish_output_into(Child& child, std::string& stdout_data,
+                                      std::string& stderr_data) {
+  auto stdin_pipe = child.take_stdin();
+  if (stdin_pipe) {
+    stdin_pipe->close();
+  }
+  // clear() keeps the capacity, so pooled buffers are refilled without allocating.
+  stdout_data.clear();
+  stderr_data.clear();
+  auto stdout_pipe = child.take_stdout();
+  auto stderr_pipe = child.take_stderr();
+  auto drained = drain_pipes_into(stdout_pipe ? &*stdout_pipe : nullptr,
+                                  stderr_pipe ? &*stderr_pipe : nullptr, stdout_data, stderr_data);
+  if (!drained) {
+    return drained.error();
+  }
+  return child.wait();
+}
+
+Result<ChunkedOutput> finish_output_chunked(Child& child) {
+  auto stdin_pipe = child.take_stdin();
+  if (stdin_pipe) {
+    stdin_pipe->close();
+  }
+  ChunkedOutput output;
+  auto stdout_pipe = child.take_stdout();
+  auto stderr_pipe = child.take_stderr();
+  auto drained = drain_pipes_into(stdout_pipe ? &*stdout_pipe : nullptr,
+                                  stderr_pipe ? &*stderr_pipe : nullptr, output.stdout_data,
+                                  output.stderr_data);
+  if (!drained) {
+    return drained.error();
+  }
+  auto status = child.wait();
+  if (!status) {
+    return status.error();
+  }
+  output.status = status.value();
+  return output;
+}
+
+Result<SpillOutput> finish_output_spill(Child& child, std::size_t memory_limit) {
+  auto stdin_pipe = child.take_stdin();
+  if (stdin_pipe) {
+    stdin_pipe->close();
+  }
+  SpillWriter stdout_writer(memory_limit, "procly-stdout");
+  SpillWriter stderr_writer(memory_limit, "procly-stderr");
+  auto stdout_sink = OutputSink::chunks(
+      OutputSink::ChunkCallback([&stdout_writer](const std::byte* data, std::size_t size) {
+        stdout_writer.write(reinterpret_cast<const char*>(data), size);
+      }));
+  auto stderr_sink = OutputSink::chunks(
+      OutputSink::ChunkCallback([&stderr_writer](const std::byte* data, std::size_t size) {
+        stderr_writer.write(reinterpret_cast<const char*>(data), size);
+      }));
+  auto stdout_pipe = child.take_stdout();
+  auto stderr_pipe = child.take_stderr();
+  auto drained = drain_pipes(stdout_pipe ? &*stdout_pipe : nullptr,
+                             stderr_pipe ? &*stderr_pipe : nullptr, stdout_sink, stderr_sink);
+  if (!drained) {
+    return drained.error();
+  }
+  auto status = child.wait();
+  if (!status) {
+    return status.error();
+  }
+  auto stdout_data = stdout_writer.finish();
+  if (!stdout_data) {
+    return stdout_data.error();
+  }
+  auto stderr_data = stderr_writer.finish();
+  if (!stderr_data) {
+    return stderr_data.error();
+  }
+  SpillOutput output;
+  output.status = status.value();
+  output.stdout_data = std::move(stdout_data.value());
+  output.stderr_data = std::move(stderr_data.value());
+  return output;
+}
+
+Result<TimelineOutput> finish_output_timeline(Child& child) {
+  auto stdin_pipe = child.take_stdin();
+  if (stdin_pipe) {
+    stdin_pipe->close();
+  }
+  TimelineOutput output;
+  auto stdout_pipe = child.take_stdout();
+  auto stderr_pipe = child.take_stderr();
+  auto drained = drain_pipes_timeline(stdout_pipe ? &*stdout_pipe : nullptr,
+                                      stderr_pipe ? &*stderr_pipe : nullptr, output.data,
+                                      output.records);
+  if (!drained) {
+    return drained.error();
+  }
+  auto status = child.wait();
+  if (!status) {
+    return status.error();
+  }
+  output.status = status.value();
+  return output;
+}
+
+Result<CompressedOutput> finish_output_compressed(Child& child, Compressor stdout_compressor,
+                                                  Compressor stderr_compressor) {
+  auto stdout_sink = OutputSink::chunks(OutputSink::ChunkCallback(
+      [&compressor = stdout_compressor](const std::byte* data, std::size_t size) {
+        compressor.write(reinterpret_cast<const char*>(data), size);
+      }));
+  auto stderr_sink = OutputSink::chunks(OutputSink::ChunkCallback(
+      [&compressor = stderr_compressor](const std::byte* data, std::size_t size) {
+        compressor.write(reinterpret_cast<const char*>(data), size);
+      }));
+  auto status = finish_stream(child, stdout_sink, stderr_sink);
+  if (!status) {
+    return status.error();
+  }
+  auto stdout_data = stdout_compressor.finish();
+  if (!stdout_data) {
+    return stdout_data.error();
+  }
+  auto stderr_data = stderr_compressor.finish();
+  if (!stderr_data) {
+    return stderr_data.error();
+  }
+  CompressedOutput output;
+  output.status = status.value();
+  output.stdout_data = std::move(stdout_data.value());
+  output.stderr_data = std::move(stderr_data.value());
+  return output;
+}
+
+Result<ExitStatus> finish_stream(Child& child, OutputSink& stdout_sink, OutputSink& stderr_sink) {
+  auto stdin_pipe = child.take_stdin();
+  if (stdin_pipe) {
+    stdin_pipe->close();
+  }
+  auto stdout_pipe = child.take_stdout();
+  auto stderr_pipe = child.take_stderr();
+  auto drained = drain_pipes(stdout_pipe ? &*stdout_pipe : nullptr,
+                             stderr_pipe ? &*stderr_pipe : nullptr, stdout_sink, stderr_sink);
+  if (!drained) {
+    return drained.error();
+  }
+  return child.wait();
+}
+
+Result<unique_fd> create_capture_file(const char* name) {
+#if PROCLY_PLATFORM_LINUX && defined(MFD_CLOEXEC)
+  int fd = ::memfd_create(name, MFD_CLOEXEC);
+  if (fd >= 0) {
+    return unique_fd(fd);
+  }
+  if (errno != ENOSYS) {
+    return Error{.code = std::error_code(errno, std::system_category()),
+                 .context = "memfd_create"};
+  }
+#endif
+  return create_temp_file(name);
+}
+
+Result<unique_fd> create_sealed_file(const char* name, std::string_view data) {
+  unique_fd file;
+  bool sealable = false;
+#if PROCLY_PLATFORM_LINUX && defined(MFD_ALLOW_SEALING)
+  file.reset(::memfd_create(name, MFD_CLOEXEC | MFD_ALLOW_SEALING));
+  if (!file && errno != ENOSYS) {
+    return Error{.code = std::error_code(errno, std::system_category()),
+                 .context = "memfd_create"};
+  }
+  sealable = static_cast<bool>(file);
+#endif
+  if (!file) {
+    auto temp = create_temp_file(name);
+    if (!temp) {
+      return temp.error();
+    }
+    file = std::move(temp.value());
+  }
+  std::size_t offset = 0;
+  while (offset < data.size()) {
+    ssize_t written = ::write(file.get(), data.data() + offset, data.size() - offset);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return Error{.code = std::error_code(errno, std::system_category()), .context = "write"};
+    }
+    offset += static_cast<std::size_t>(written);
+  }
+#if PROCLY_PLATFORM_LINUX && defined(F_ADD_SEALS)
+  if (sealable &&
+      ::fcntl(file.get(), F_ADD_SEALS, F_SEAL_WRITE | F_SEAL_GROW | F_SEAL_SHRINK | F_SEAL_SEAL) <
+          0) {
+    return Error{.code = std::error_code(errno, std::system_category()), .context = "F_ADD_SEALS"};
+  }
+#endif
+  (void)sealable;
+  if (::lseek(file.get(), 0, SEEK_SET) < 0) {
+    return Error{.code = std::error_code(errno, std::system_category()), .context = "lseek"};
+  }
+  return file;
+}
+
+Result<unique_fd> create_temp_file(const char* name) {
+  std::error_code ec;
+  auto dir = std::filesystem::temp_directory_path(ec);
+  if (ec) {
+    return Error{.code = ec, .context = "temp_directory_path"};
+  }
+  std::string path = (dir / name).string() + ".XXXXXX";
+  unique_fd file(::mkstemp(path.data()));
+  if (!file) {
+    return Error{.code = std::error_code(errno, std::system_category()), .context = "mkstemp"};
+  }
+  ::unlink(path.c_str());
+  auto cloexec = set_cloexec(file.get());
+  if (!cloexec) {
+    return cloexec.error();
+  }
+  return file;
+}
+
+}  // namespace procly::internal
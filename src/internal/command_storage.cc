@@ -0,0 +1,127 @@
+#include "procly/internal/command_storage.hpp"
+
+#include <algorithm>
+
+namespace procly::internal {
+
+void CommandStorage::push_arg(std::string_view value) { args_.push_back(append(value)); }
+
+void CommandStorage::clear_args() noexcept {
+  for (const Ref& ref : args_) {
+    dead_ += ref.size;
+  }
+  args_.clear();
+}
+
+std::vector<std::string> CommandStorage::argv() const {
+  std::vector<std::string> argv;
+  argv.reserve(args_.size());
+  for (const Ref& ref : args_) {
+    argv.emplace_back(view(ref));
+  }
+  return argv;
+}
+
+EnvDeltaEntry CommandStorage::env_entry(std::size_t index) const noexcept {
+  const EnvRef& ref = env_[index];
+  EnvDeltaEntry entry{.key = view(ref.key), .value = std::nullopt};
+  if (ref.set) {
+    entry.value = view(ref.value);
+  }
+  return entry;
+}
+
+std::optional<EnvDeltaEntry> CommandStorage::find_env(std::string_view key) const noexcept {
+  std::size_t index = lower_bound(key);
+  if (index == env_.size() || view(env_[index].key) != key) {
+    return std::nullopt;
+  }
+  return env_entry(index);
+}
+
+void CommandStorage::set_env(std::string_view key, std::optional<std::string_view> value) {
+  std::size_t index = lower_bound(key);
+  if (index == env_.size() || view(env_[index].key) != key) {
+    // Insert the key first: appending the value may compact the arena, which only relocates
+    // entries already in env_.
+    env_.insert(index, EnvRef{.key = append(key), .value = Ref{}, .set = false});
+    if (value) {
+      Ref appended = append(*value);
+      env_[index].value = appended;
+      env_[index].set = true;
+    }
+    return;
+  }
+  EnvRef& ref = env_[index];
+  if (!value) {
+    dead_ += ref.value.size;
+    ref.value = Ref{};
+    ref.set = false;
+    return;
+  }
+  // A value no longer than the old one is overwritten in place.
+  if (value->size() <= ref.value.size) {
+    arena_.replace(ref.value.offset, value->size(), *value);
+    dead_ += ref.value.size - value->size();
+    ref.value.size = static_cast<std::uint32_t>(value->size());
+  } else {
+    dead_ += ref.value.size;
+    Ref appended = append(*value);
+    // append() may have compacted the arena and moved every entry.
+    env_[index].value = appended;
+  }
+  env_[index].set = true;
+}
+
+void CommandStorage::clear_env() noexcept {
+  for (const EnvRef& ref : env_) {
+    dead_ += ref.key.size + ref.value.size;
+  }
+  env_.clear();
+}
+
+std::size_t CommandStorage::lower_bound(std::string_view key) const noexcept {
+  const EnvRef* found = std::lower_bound(
+      env_.begin(), env_.end(), key,
+      [this](const EnvRef& ref, std::string_view wanted) { return view(ref.key) < wanted; });
+  return static_cast<std::size_t>(found - env_.begin());
+}
+
+CommandStorage::Ref CommandStorage::append(std::string_view value) {
+  // value never points into the arena, so compacting or growing it cannot invalidate value.
+  if (arena_.size() + value.size() > arena_.capacity()) {
+    // Reclaim dead bytes before growing when they make up most of the arena.
+    if (dead_ > arena_.size() / 2) {
+      compact();
+    }
+    if (arena_.size() + value.size() > arena_.capacity()) {
+      arena_.reserve(
+          std::max({kInitialArena, arena_.size() + value.size(), 2 * arena_.capacity()}));
+    }
+  }
+  Ref ref{.offset = static_cast<std::uint32_t>(arena_.size()),
+          .size = static_cast<std::uint32_t>(value.size())};
+  arena_.append(value);
+  return ref;
+}
+
+void CommandStorage::compact() {
+  std::string packed;
+  packed.reserve(std::max(kInitialArena, arena_.size() - dead_));
+  auto move = [&](Ref& ref) {
+    std::string_view bytes = view(ref);
+    ref.offset = static_cast<std::uint32_t>(packed.size());
+    packed.append(bytes);
+  };
+  for (Ref& ref : args_) {
+    move(ref);
+  }
+  for (EnvRef& ref : env_) {
+    move(ref.key);
+    move(ref.value);
+  }
+  arena_ = std::move(packed);
+  dead_ = 0;
+}
+
+}  // namespace procly::internal
@@ -0,0 +1,195 @@
+#include "procly/internal/compressor.hpp"
+
+#include <algorithm>
+#include <string>
+#include <utility>
+
+#if defined(PROCLY_ENABLE_ZSTD)
+#include <zstd.h>
+#endif
+#if defined(PROCLY_ENABLE_LZ4)
+#include <lz4frame.h>
+#endif
+
+namespace procly::internal {
+
+namespace {
+
+#if defined(PROCLY_ENABLE_LZ4)
+// LZ4F_compressUpdate is fed at most this much at a time so the scratch buffer has a fixed bound.
+constexpr std::size_t kLz4FeedBytes = 64 * 1024;
+#endif
+
+#if defined(PROCLY_ENABLE_ZSTD) || defined(PROCLY_ENABLE_LZ4)
+Error codec_error(const char* call, const char* detail) {
+  return Error{.code = make_error_code(errc::write_failed),
+               .context = std::string(call) + ": " + detail};
+}
+#endif
+
+}  // namespace
+
+struct Compressor::State {
+  State() = default;
+  State(const State&) = delete;
+  State& operator=(const State&) = delete;
+  ~State() {
+#if defined(PROCLY_ENABLE_ZSTD)
+    ZSTD_freeCCtx(zstd);
+#endif
+#if defined(PROCLY_ENABLE_LZ4)
+    LZ4F_freeCompressionContext(lz4);
+#endif
+  }
+
+  Compression codec = Compression::zstd;
+#if defined(PROCLY_ENABLE_ZSTD)
+  ZSTD_CCtx* zstd = nullptr;
+#endif
+#if defined(PROCLY_ENABLE_LZ4)
+  LZ4F_cctx* lz4 = nullptr;
+  LZ4F_preferences_t lz4_preferences{};
+#endif
+  // Codec output lands here before it is appended to the frame, so the frame grows only by what
+  // was actually produced.
+  std::string scratch;
+};
+
+Result<Compressor> Compressor::create(Compression codec, int level) {
+  auto state = std::make_unique<State>();
+  state->codec = codec;
+  switch (codec) {
+    case Compression::zstd: {
+#if defined(PROCLY_ENABLE_ZSTD)
+      state->zstd = ZSTD_createCCtx();
+      if (state->zstd == nullptr) {
+        return codec_error("ZSTD_createCCtx", "out of memory");
+      }
+      std::size_t rc = ZSTD_CCtx_setParameter(state->zstd, ZSTD_c_compressionLevel, level);
+      if (ZSTD_isError(rc)) {
+        return codec_error("ZSTD_CCtx_setParameter", ZSTD_getErrorName(rc));
+      }
+      state->scratch.resize(ZSTD_CStreamOutSize());
+      return Compressor(std::move(state));
+#else
+      (void)level;
+      return Error{.code = make_error_code(errc::invalid_argument), .context = "zstd"};
+#endif
+    }
+    case Compression::lz4: {
+#if defined(PROCLY_ENABLE_LZ4)
+      LZ4F_errorCode_t created = LZ4F_createCompressionContext(&state->lz4, LZ4F_VERSION);
+      if (LZ4F_isError(created)) {
+        return codec_error("LZ4F_createCompressionContext", LZ4F_getErrorName(created));
+      }
+      state->lz4_preferences.compressionLevel = level;
+      state->scratch.resize(
+          std::max<std::size_t>(LZ4F_HEADER_SIZE_MAX,
+                                LZ4F_compressBound(kLz4FeedBytes, &state->lz4_preferences)));
+      std::size_t header = LZ4F_compressBegin(state->lz4, state->scratch.data(),
+                                              state->scratch.size(), &state->lz4_preferences);
+      if (LZ4F_isError(header)) {
+        return codec_error("LZ4F_compressBegin", LZ4F_getErrorName(header));
+      }
+      Compressor compressor(std::move(state));
+      compressor.buffer_.frame_.append(compressor.state_->scratch.data(), header);
+      return compressor;
+#else
+      (void)level;
+      return Error{.code = make_error_code(errc::invalid_argument), .context = "lz4"};
+#endif
+    }
+  }
+  return Error{.code = make_error_code(errc::invalid_argument), .context = "compression"};
+}
+
+Compressor::Compressor(std::unique_ptr<State> state) : state_(std::move(state)) {
+  buffer_.codec_ = state_->codec;
+}
+
+Compressor::Compressor(Compressor&& other) noexcept = default;
+Compressor& Compressor::operator=(Compressor&& other) noexcept = default;
+Compressor::~Compressor() = default;
+
+void Compressor::write([[maybe_unused]] const char* data, std::size_t size) {
+  if (error_ || size == 0) {
+    return;
+  }
+  buffer_.size_ += size;
+  switch (state_->codec) {
+    case Compression::zstd: {
+#if defined(PROCLY_ENABLE_ZSTD)
+      std::string& scratch = state_->scratch;
+      ZSTD_inBuffer in{.src = data, .size = size, .pos = 0};
+      while (in.pos < in.size) {
+        ZSTD_outBuffer out{.dst = scratch.data(), .size = scratch.size(), .pos = 0};
+        std::size_t rc = ZSTD_compressStream2(state_->zstd, &out, &in, ZSTD_e_continue);
+        if (ZSTD_isError(rc)) {
+          error_ = codec_error("ZSTD_compressStream2", ZSTD_getErrorName(rc));
+          return;
+        }
+        buffer_.frame_.append(scratch.data(), out.pos);
+      }
+#endif
+      break;
+    }
+    case Compression::lz4: {
+#if defined(PROCLY_ENABLE_LZ4)
+      std::string& scratch = state_->scratch;
+      while (size > 0) {
+        std::size_t feed = std::min(size, kLz4FeedBytes);
+        std::size_t produced = LZ4F_compressUpdate(state_->lz4, scratch.data(), scratch.size(),
+                                                   data, feed, nullptr);
+        if (LZ4F_isError(produced)) {
+          error_ = codec_error("LZ4F_compressUpdate", LZ4F_getErrorName(produced));
+          return;
+        }
+        buffer_.frame_.append(scratch.data(), produced);
+        data += feed;
+        size -= feed;
+      }
+#endif
+      break;
+    }
+  }
+}
+
+Result<CompressedBuffer> Compressor::finish() {
+  if (error_) {
+    return *error_;
+  }
+  switch (state_->codec) {
+    case Compression::zstd: {
+#if defined(PROCLY_ENABLE_ZSTD)
+      std::string& scratch = state_->scratch;
+      ZSTD_inBuffer in{.src = nullptr, .size = 0, .pos = 0};
+      std::size_t remaining = 0;
+      do {
+        ZSTD_outBuffer out{.dst = scratch.data(), .size = scratch.size(), .pos = 0};
+        remaining = ZSTD_compressStream2(state_->zstd, &out, &in, ZSTD_e_end);
+        if (ZSTD_isError(remaining)) {
+          return codec_error("ZSTD_compressStream2", ZSTD_getErrorName(remaining));
+        }
+        buffer_.frame_.append(scratch.data(), out.pos);
+      } while (remaining != 0);
+#endif
+      break;
+    }
+    case Compression::lz4: {
+#if defined(PROCLY_ENABLE_LZ4)
+      std::string& scratch = state_->scratch;
+      std::size_t produced =
+          LZ4F_compressEnd(state_->lz4, scratch.data(), scratch.size(), nullptr);
+      if (LZ4F_isError(produced)) {
+        return codec_error("LZ4F_compressEnd", LZ4F_getErrorName(produced));
+      }
+      buffer_.frame_.append(scratch.data(), produced);
+#endif
+      break;
+    }
+  }
+  buffer_.frame_.shrink_to_fit();
+  return std::move(buffer_);
+}
+
+}  // namespace procly::internal
@@ -0,0 +1,158 @@
+#include "procly/internal/env_block.hpp"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+#include "procly/platform.hpp"
+
+#if PROCLY_PLATFORM_MACOS
+#include <crt_externs.h>
+#endif
+
+namespace procly::internal {
+
+namespace {
+
+constexpr std::array<char*, 1> kEmptyEnvp = {nullptr};
+
+const std::vector<std::string_view>& empty_entries() {
+  static const std::vector<std::string_view> entries;
+  return entries;
+}
+
+char** process_environ() {
+#if PROCLY_PLATFORM_MACOS
+  char*** envp = _NSGetEnviron();
+  return (envp != nullptr) ? *envp : nullptr;
+#else
+  return ::environ;
+#endif
+}
+
+bool key_less(std::string_view left, std::string_view right) {
+  return env_entry_key(left) < env_entry_key(right);
+}
+
+}  // namespace
+
+EnvBlock::EnvBlock() = default;
+
+EnvBlock EnvBlock::from_entries(const std::vector<std::string_view>& entries) {
+  std::size_t total = 0;
+  for (auto entry : entries) {
+    total += entry.size() + 1;
+  }
+
+  auto storage = std::make_shared<Storage>();
+  storage->buffer = std::make_unique<char[]>(total == 0 ? 1 : total);
+  storage->pointers.reserve(entries.size() + 1);
+  storage->entries.reserve(entries.size());
+
+  char* cursor = storage->buffer.get();
+  for (auto entry : entries) {
+    std::memcpy(cursor, entry.data(), entry.size());
+    cursor[entry.size()] = '\0';
+    storage->pointers.push_back(cursor);
+    storage->entries.emplace_back(cursor, entry.size());
+    cursor += entry.size() + 1;
+  }
+  storage->pointers.push_back(nullptr);
+  return EnvBlock(std::move(storage));
+}
+
+char* const* EnvBlock::data() const noexcept {
+  return storage_ ? storage_->pointers.data() : kEmptyEnvp.data();
+}
+
+std::size_t EnvBlock::size() const noexcept { return storage_ ? storage_->entries.size() : 0; }
+
+const std::vector<std::string_view>& EnvBlock::entries() const noexcept {
+  return storage_ ? storage_->entries : empty_entries();
+}
+
+std::optional<std::string_view> EnvBlock::find(std::string_view key) const noexcept {
+  for (auto entry : *this) {
+    if (entry.size() > key.size() && entry[key.size()] == '=' &&
+        entry.compare(0, key.size(), key) == 0) {
+      return entry.substr(key.size() + 1);
+    }
+  }
+  return std::nullopt;
+}
+
+std::vector<std::string_view> process_environment_entries() {
+  std::vector<std::string_view> entries;
+  for (char** env = process_environ(); env && *env != nullptr; ++env) {
+    std::string_view entry(*env);
+    if (entry.find('=') == std::string_view::npos) {
+      continue;
+    }
+    entries.push_back(entry);
+  }
+  std::ranges::stable_sort(entries, key_less);
+
+  // Keep the last entry of each run of duplicate keys, matching later-assignment-wins.
+  std::size_t out = 0;
+  for (std::size_t i = 0; i < entries.size(); ++i) {
+    if (i + 1 < entries.size() && env_entry_key(entries[i]) == env_entry_key(entries[i + 1])) {
+      continue;
+    }
+    entries[out++] = entries[i];
+  }
+  entries.resize(out);
+  return entries;
+}
+
+EnvBlock apply_env_delta(const std::vector<std::string_view>& base, const EnvDeltaEntry* delta,
+                         std::size_t count) {
+  if (count == 0) {
+    return EnvBlock::from_entries(base);
+  }
+
+  // Reserve up front so the views taken below stay valid while more entries are formatted.
+  std::vector<std::string> formatted;
+  formatted.reserve(count);
+  std::vector<std::string_view> merged;
+  merged.reserve(base.size() + count);
+
+  auto push_delta = [&](std::string_view key, std::string_view value) {
+    std::string entry;
+    entry.reserve(key.size() + 1 + value.size());
+    entry.append(key);
+    entry.push_back('=');
+    entry.append(value);
+    formatted.push_back(std::move(entry));
+    merged.emplace_back(formatted.back());
+  };
+
+  auto base_it = base.begin();
+  const EnvDeltaEntry* delta_it = delta;
+  const EnvDeltaEntry* delta_end = delta + count;
+  while (base_it != base.end() || delta_it != delta_end) {
+    if (delta_it == delta_end) {
+      merged.push_back(*base_it++);
+      continue;
+    }
+    std::string_view delta_key = delta_it->key;
+    if (base_it != base.end()) {
+      std::string_view base_key = env_entry_key(*base_it);
+      if (base_key < delta_key) {
+        merged.push_back(*base_it++);
+        continue;
+      }
+      if (base_key == delta_key) {
+        ++base_it;
+      }
+    }
+    if (delta_it->value.has_value()) {
+      push_delta(delta_it->key, *delta_it->value);
+    }
+    ++delta_it;
+  }
+  return EnvBlock::from_entries(merged);
+}
+
+}  // namespace procly::internal
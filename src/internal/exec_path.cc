@@ -0,0 +1,60 @@
+#include "procly/internal/exec_path.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <string_view>
+
+namespace procly::internal {
+
+namespace {
+
+constexpr std::string_view kDefaultSearchPath = "/usr/bin:/bin";
+
+std::filesystem::path resolve_search_dir(std::string_view raw_dir,
+                                         const std::optional<std::filesystem::path>& cwd) {
+  std::filesystem::path dir =
+      raw_dir.empty() ? std::filesystem::path(".") : std::filesystem::path(raw_dir);
+  if (cwd && dir.is_relative()) {
+    return *cwd / dir;
+  }
+  return dir;
+}
+
+}  // namespace
+
+std::string resolve_exec_path(const std::string& argv0, const EnvBlock& envp,
+                              const std::optional<std::filesystem::path>& cwd,
+                              std::optional<int> cwd_fd) {
+  if (argv0.find('/') != std::string::npos) {
+    return argv0;
+  }
+  std::string_view path_value = envp.find("PATH").value_or(kDefaultSearchPath);
+  if (path_value.empty()) {
+    return argv0;
+  }
+  std::size_t start = 0;
+  while (true) {
+    std::size_t end = path_value.find(':', start);
+    std::size_t len = (end == std::string_view::npos) ? path_value.size() - start : end - start;
+    std::string_view dir = (len == 0) ? std::string_view(".") : path_value.substr(start, len);
+    if (cwd_fd && dir.front() != '/') {
+      std::filesystem::path candidate = std::filesystem::path(dir) / argv0;
+      if (::faccessat(*cwd_fd, candidate.c_str(), X_OK, 0) == 0) {
+        return candidate.string();
+      }
+    } else {
+      std::filesystem::path candidate = resolve_search_dir(dir, cwd) / argv0;
+      if (::access(candidate.c_str(), X_OK) == 0) {
+        return candidate.string();
+      }
+    }
+    if (end == std::string_view::npos) {
+      break;
+    }
+    start = end + 1;
+  }
+  return argv0;
+}
+
+}  // namespace procly::internal
@@ -0,0 +1,82 @@
+#include "procly/internal/function_stage_run.hpp"
+
+#include <poll.h>
+
+#include <system_error>
+#include <utility>
+
+#include "procly/pipe.hpp"
+
+namespace procly::internal {
+
+struct FunctionStageRun::State {
+  std::optional<Error> error;
+  // Closed by the thread after error is set; the read end then polls readable.
+  unique_fd done_writer;
+};
+
+Result<FunctionStageRun> FunctionStageRun::start(const FunctionStage::Body& body, unique_fd in,
+                                                 unique_fd out, std::size_t position) {
+  auto done = create_pipe();
+  if (!done) {
+    return done.error();
+  }
+  FunctionStageRun run;
+  run.state_ = std::make_shared<State>();
+  run.state_->done_writer = std::move(done->second);
+  run.done_ = std::move(done->first);
+  run.position_ = position;
+  try {
+    run.thread_ = std::thread([state = run.state_, body, in = std::move(in),
+                               out = std::move(out)]() mutable {
+      PipeReader reader(in.release());
+      PipeWriter writer(out.release());
+      auto result = body(reader, writer);
+      reader.close();
+      writer.close();
+      if (!result) {
+        state->error = result.error();
+      }
+      state->done_writer.reset(-1);
+    });
+  } catch (const std::system_error& error) {
+    return Error{.code = error.code(), .context = "function_stage"};
+  }
+  return run;
+}
+
+FunctionStageRun& FunctionStageRun::operator=(FunctionStageRun&& other) noexcept {
+  if (this != &other) {
+    if (thread_.joinable()) {
+      thread_.detach();
+    }
+    thread_ = std::move(other.thread_);
+    state_ = std::move(other.state_);
+    done_ = std::move(other.done_);
+    position_ = other.position_;
+  }
+  return *this;
+}
+
+FunctionStageRun::~FunctionStageRun() {
+  if (thread_.joinable()) {
+    thread_.detach();
+  }
+}
+
+bool FunctionStageRun::done() const {
+  if (!thread_.joinable()) {
+    return true;
+  }
+  pollfd pfd{.fd = done_.get(), .events = POLLIN, .revents = 0};
+  return ::poll(&pfd, 1, 0) == 1;
+}
+
+FunctionStageStatus FunctionStageRun::join() {
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+  return FunctionStageStatus{.position = position_, .error = state_->error};
+}
+
+}  // namespace procly::internal
@@ -1,12 +1,22 @@
 #include "procly/internal/io_drain.hpp"
 
 #include <poll.h>
+#include <sys/ioctl.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <array>
 #include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <vector>
 
+#include "procly/internal/access.hpp"
+#include "procly/internal/clock.hpp"
 #include "procly/internal/fd.hpp"
+#include "procly/internal/observe.hpp"
 
 namespace procly::internal {
 
@@ -16,52 +26,252 @@ Error make_errno_error(const char* context) {
   return Error{.code = std::error_code(errno, std::system_category()), .context = context};
 }
 
-}  // namespace
+// Appends one captured stream into a string, honoring an optional CaptureLimit.
+class BoundedCapture {
+ public:
+  BoundedCapture(std::string* out, std::size_t* dropped, std::optional<CaptureLimit> limit,
+                 const std::function<void()>* on_kill)
+      : out_(out), dropped_(dropped), limit_(limit), on_kill_(on_kill) {}
 
-Result<DrainResult> drain_pipes(PipeReader* stdout_pipe, PipeReader* stderr_pipe) {
-  DrainResult result;
+  void append(const char* data, std::size_t size) {
+    if (!limit_) {
+      out_->append(data, size);
+      return;
+    }
+    if (limit_->policy == OverflowPolicy::keep_tail) {
+      append_tail(data, size);
+      return;
+    }
+    std::size_t room = limit_->max_bytes - out_->size();
+    std::size_t take = std::min(room, size);
+    out_->append(data, take);
+    if (take == size) {
+      return;
+    }
+    *dropped_ += size - take;
+    if (limit_->policy == OverflowPolicy::kill && !killed_) {
+      killed_ = true;
+      if (on_kill_ != nullptr && *on_kill_) {
+        (*on_kill_)();
+      }
+    }
+  }
+
+  // Put the ring buffer back into stream order.
+  void finish() {
+    if (head_ != 0) {
+      std::rotate(out_->begin(), out_->begin() + static_cast<std::ptrdiff_t>(head_), out_->end());
+      head_ = 0;
+    }
+  }
+
+ private:
+  void append_tail(const char* data, std::size_t size) {
+    std::size_t max = limit_->max_bytes;
+    if (size >= max) {
+      *dropped_ += out_->size() + size - max;
+      out_->assign(data + (size - max), max);
+      head_ = 0;
+      return;
+    }
+    std::size_t room = max - out_->size();
+    std::size_t take = std::min(room, size);
+    out_->append(data, take);
+    data += take;
+    size -= take;
+    // Full: overwrite the oldest bytes, which start at head_.
+    *dropped_ += size;
+    while (size > 0) {
+      std::size_t chunk = std::min(size, max - head_);
+      std::memcpy(out_->data() + head_, data, chunk);
+      head_ = (head_ + chunk) % max;
+      data += chunk;
+      size -= chunk;
+    }
+  }
+
+  std::string* out_;
+  std::size_t* dropped_;
+  std::optional<CaptureLimit> limit_;
+  const std::function<void()>* on_kill_;
+  std::size_t head_ = 0;
+  bool killed_ = false;
+};
+
+struct DrainTarget {
+  PipeReader* pipe;
+  // Chunks go to sink unless direct or chunked is set, in which case reads land in that buffer.
+  OutputSink* sink;
+  std::string* direct;
+  bool done = false;
+  std::size_t bytes = 0;
+  ChunkedBuffer* chunked = nullptr;
+  // Fed every byte read, whichever buffer it lands in.
+  Digest* digest = nullptr;
+  // Gets a record per read into direct, which the other stream may share.
+  std::vector<TimelineRecord>* timeline = nullptr;
+  OutputStream stream = OutputStream::out;
+};
+
+// Read once into the free tail of the buffer's last chunk; filled chunks are never moved.
+ssize_t read_into_chunks(int fd, ChunkedBuffer& out) {
+  std::size_t room = 0;
+  char* tail = ChunkedBufferAccess::writable_tail(out, &room);
+  ssize_t count = ::read(fd, tail, room);
+  if (count > 0) {
+    ChunkedBufferAccess::commit(out, static_cast<std::size_t>(count));
+  }
+  return count;
+}
+
+bool would_block(const Error& error) {
+  return error.code == std::errc::resource_unavailable_try_again ||
+         error.code == std::errc::operation_would_block;
+}
+
+// Write as much of the remaining input as the pipe takes without blocking, pulling the next
+// chunk from the source whenever the current one is gone. Returns false once feeding is over:
+// everything was written or the child closed its stdin.
+Result<bool> feed_stdin(StdinFeed& feed, std::size_t& offset) {
+  while (true) {
+    while (offset < feed.data.size()) {
+      auto written = feed.pipe->write_some(feed.data.data() + offset, feed.data.size() - offset);
+      if (!written) {
+        if (would_block(written.error())) {
+          return true;
+        }
+        if (written.error().code == std::errc::broken_pipe) {
+          feed.pipe->close();
+          return false;
+        }
+        return written.error();
+      }
+      offset += written.value();
+    }
+    // The pipe took the whole chunk without blocking, so it may have room for the next one.
+    if (feed.source == nullptr || !feed.source->next(feed.chunk)) {
+      break;
+    }
+    feed.written_before += offset;
+    feed.data = feed.chunk;
+    offset = 0;
+  }
+  feed.pipe->close();
+  return false;
+}
+
+// Poll timeout for the next deadline step, running any step already due. Returns false once
+// the kill grace has passed too and the remaining streams should be abandoned.
+bool advance_deadline(DrainDeadline& deadline, int* timeout_ms) {
+  if (!deadline.at) {
+    return true;
+  }
+  auto now = default_clock().now();
+  if (now >= *deadline.at) {
+    if (deadline.sent_kill) {
+      return false;
+    }
+    if (!deadline.sent_terminate) {
+      deadline.sent_terminate = true;
+      if (deadline.terminate) {
+        deadline.terminate();
+      }
+    } else {
+      deadline.sent_kill = true;
+      if (deadline.kill) {
+        deadline.kill();
+      }
+    }
+    deadline.at = now + deadline.kill_grace;
+  }
+  auto left = std::chrono::ceil<std::chrono::milliseconds>(*deadline.at - now);
+  *timeout_ms = static_cast<int>(
+      std::clamp<std::chrono::milliseconds::rep>(left.count(), 0, std::numeric_limits<int>::max()));
+  return true;
+}
+
+// Drain target_count targets (stdout and stderr first) and feed stdin from one poll loop.
+Result<void> drain_targets(DrainTarget* targets, std::size_t target_count, StdinFeed* feed,
+                           DrainDeadline* deadline = nullptr) {
   constexpr std::size_t kBufferSize = 8192;
 
-  struct Target {
-    PipeReader* pipe;
-    std::string* out;
-    bool done = false;
-  };
+  auto* observer = current_observer();
+  std::chrono::steady_clock::time_point start;
+  if (observer != nullptr) {
+    start = std::chrono::steady_clock::now();
+  }
 
-  std::array targets = {
-      Target{.pipe = stdout_pipe, .out = &result.stdout_data, .done = false},
-      Target{.pipe = stderr_pipe, .out = &result.stderr_data, .done = false},
-  };
+  bool feeding = false;
+  std::size_t fed = 0;
+  if (feed != nullptr && feed->pipe != nullptr && feed->pipe->native_handle() >= 0) {
+    if (feed->data.empty() && feed->source == nullptr) {
+      feed->pipe->close();
+    } else {
+      auto nonblocking_result = set_nonblocking(feed->pipe->native_handle());
+      if (!nonblocking_result) {
+        return nonblocking_result.error();
+      }
+      feeding = true;
+    }
+  }
 
   int active = 0;
-  for (auto& target : targets) {
-    if (target.pipe != nullptr && target.pipe->native_handle() >= 0) {
+  for (DrainTarget* target = targets; target != targets + target_count; ++target) {
+    if (target->pipe != nullptr && target->pipe->native_handle() >= 0) {
       ++active;
-      auto nonblocking_result = set_nonblocking(target.pipe->native_handle());
+      auto nonblocking_result = set_nonblocking(target->pipe->native_handle());
       if (!nonblocking_result) {
         return nonblocking_result.error();
       }
     } else {
-      target.done = true;
+      target->done = true;
     }
   }
 
-  std::array<pollfd, 2> pollfds{};
+  // Two streams, stdin and the cancel handle fit inline; extra streams (per-stage stderr)
+  // spill to the heap.
+  std::array<pollfd, 4> inline_pollfds{};
+  std::vector<pollfd> heap_pollfds;
+  pollfd* pollfds = inline_pollfds.data();
+  if (target_count + 2 > inline_pollfds.size()) {
+    heap_pollfds.resize(target_count + 2);
+    pollfds = heap_pollfds.data();
+  }
+  std::array<char, kBufferSize> buffer;  // NOLINT(cppcoreguidelines-pro-type-member-init)
+  // A sink that fails to finish does not stop the other stream from draining.
+  std::optional<Error> sink_error;
 
-  while (active > 0) {
-    // Poll until at least one pipe becomes readable or hits EOF.
+  while (active > 0 || feeding) {
+    // Poll until a pipe becomes readable or hits EOF, or stdin has room.
     int poll_count = 0;
-    for (const auto& target : targets) {
-      if (target.done) {
+    for (const DrainTarget* target = targets; target != targets + target_count; ++target) {
+      if (target->done) {
         continue;
       }
-      pollfds[poll_count].fd = target.pipe->native_handle();
+      pollfds[poll_count].fd = target->pipe->native_handle();
+      pollfds[poll_count].events = POLLIN;
+      pollfds[poll_count].revents = 0;
+      ++poll_count;
+    }
+    if (feeding) {
+      pollfds[poll_count].fd = feed->pipe->native_handle();
+      pollfds[poll_count].events = POLLOUT;
+      pollfds[poll_count].revents = 0;
+      ++poll_count;
+    }
+    bool watch_cancel = deadline != nullptr && deadline->cancel_fd >= 0 && !deadline->cancelled;
+    if (watch_cancel) {
+      pollfds[poll_count].fd = deadline->cancel_fd;
       pollfds[poll_count].events = POLLIN;
       pollfds[poll_count].revents = 0;
       ++poll_count;
     }
 
-    int poll_result = ::poll(pollfds.data(), poll_count, -1);
+    int timeout_ms = -1;
+    if (deadline != nullptr && !advance_deadline(*deadline, &timeout_ms)) {
+      break;
+    }
+    int poll_result = ::poll(pollfds, poll_count, timeout_ms);
     if (poll_result == -1) {
       if (errno == EINTR) {
         continue;
@@ -70,22 +280,51 @@ Result<DrainResult> drain_pipes(PipeReader* stdout_pipe, PipeReader* stderr_pipe
     }
 
     int poll_index = 0;
-    for (auto& target : targets) {
-      if (target.done) {
+    for (DrainTarget* target = targets; target != targets + target_count; ++target) {
+      if (target->done) {
         continue;
       }
       auto& pfd = pollfds[poll_index++];
       if ((pfd.revents & (POLLIN | POLLHUP)) != 0) {
-        std::array<char, kBufferSize> buffer{};
         while (true) {
-          ssize_t count = ::read(pfd.fd, buffer.data(), buffer.size());
+          ssize_t count = 0;
+          if (target->direct != nullptr) {
+            count = read_into(pfd.fd, *target->direct);
+          } else if (target->chunked != nullptr) {
+            count = read_into_chunks(pfd.fd, *target->chunked);
+          } else {
+            count = ::read(pfd.fd, buffer.data(), buffer.size());
+            if (count > 0) {
+              target->sink->write(buffer.data(), static_cast<std::size_t>(count));
+            }
+          }
           if (count > 0) {
-            target.out->append(buffer.data(), static_cast<std::size_t>(count));
+            auto size = static_cast<std::size_t>(count);
+            if (target->digest != nullptr) {
+              target->digest->update(target->direct != nullptr
+                                        ? target->direct->data() + target->direct->size() - size
+                                        : buffer.data(),
+                                    size);
+            }
+            if (target->timeline != nullptr) {
+              target->timeline->push_back(
+                  TimelineRecord{.at = std::chrono::steady_clock::now(),
+                                 .offset = target->direct->size() - size,
+                                 .size = static_cast<std::uint32_t>(size),
+                                 .stream = target->stream});
+            }
+            target->bytes += size;
             continue;
           }
           if (count == 0) {
-            target.pipe->close();
-            target.done = true;
+            target->pipe->close();
+            if (target->sink != nullptr) {
+              auto finished = target->sink->finish();
+              if (!finished && !sink_error) {
+                sink_error = finished.error();
+              }
+            }
+            target->done = true;
             --active;
             break;
           }
@@ -99,9 +338,221 @@ Result<DrainResult> drain_pipes(PipeReader* stdout_pipe, PipeReader* stderr_pipe
         }
       }
     }
+
+    if (feeding && pollfds[poll_index++].revents != 0) {
+      auto more = feed_stdin(*feed, fed);
+      if (!more) {
+        return more.error();
+      }
+      feeding = more.value();
+    }
+    if (watch_cancel && pollfds[poll_index].revents != 0) {
+      // Cancellation starts the escalation now, unless a deadline already did.
+      deadline->cancelled = true;
+      if (!deadline->sent_terminate) {
+        deadline->at = default_clock().now();
+      }
+    }
+  }
+
+  if (observer != nullptr) {
+    observer->on_drain(DrainEvent{.stdout_bytes = targets[0].bytes,
+                                  .stderr_bytes = target_count > 1 ? targets[1].bytes : 0,
+                                  .stdin_bytes = feed != nullptr ? feed->written_before + fed : 0,
+                                  .start = start,
+                                  .end = std::chrono::steady_clock::now()});
+  }
+  if (sink_error) {
+    return *sink_error;
+  }
+  return {};
+}
+
+Result<void> drain_targets(std::array<DrainTarget, 2>& targets, StdinFeed* feed) {
+  return drain_targets(targets.data(), targets.size(), feed);
+}
+
+}  // namespace
+
+ssize_t read_into(int fd, std::string& out) {
+  std::size_t size = out.size();
+  std::size_t spare = out.capacity() - size;
+  if (spare < kMinReadBytes) {
+    // Grow only when the queued bytes would not fit, sized by FIONREAD and then doubled. A
+    // read that will just see EOF or EAGAIN leaves a caller-sized buffer alone.
+    int queued = 0;
+    bool known = ::ioctl(fd, FIONREAD, &queued) == 0;
+    auto pending = static_cast<std::size_t>(std::max(queued, 0));
+    if (spare == 0 || !known || pending > spare) {
+      std::size_t want = std::max(kMinReadBytes, pending);
+      out.reserve(std::max({size + want, out.capacity() * 2, kInitialCaptureBytes}));
+      spare = out.capacity() - size;
+    }
   }
+  // Bound the chunk so growing the string never zero-fills more than one pipe's worth.
+  std::size_t chunk = std::min(spare, kMaxReadBytes);
+  ssize_t count = 0;
+#if defined(__cpp_lib_string_resize_and_overwrite)
+  out.resize_and_overwrite(size + chunk, [&](char* data, std::size_t) {
+    count = ::read(fd, data + size, chunk);
+    return count > 0 ? size + static_cast<std::size_t>(count) : size;
+  });
+#else
+  out.resize(size + chunk);
+  count = ::read(fd, out.data() + size, chunk);
+  int saved_errno = errno;
+  out.resize(count > 0 ? size + static_cast<std::size_t>(count) : size);
+  errno = saved_errno;
+#endif
+  return count;
+}
 
+WaitOptions reap_options(const DrainDeadline& deadline, const WaitOptions& wait) {
+  WaitOptions reap;
+  if (deadline.sent_kill) {
+    return reap;
+  }
+  if (deadline.at) {
+    reap.timeout = std::max(std::chrono::milliseconds(0),
+                            std::chrono::ceil<std::chrono::milliseconds>(
+                                *deadline.at - default_clock().now()));
+  }
+  if (deadline.sent_terminate) {
+    // The time left is the kill grace; kill as soon as it runs out.
+    reap.kill_grace = std::chrono::milliseconds(0);
+    return reap;
+  }
+  reap.kill_grace = wait.kill_grace;
+  reap.cancel = wait.cancel;
+  return reap;
+}
+
+Result<DrainResult> drain_pipes(PipeReader* stdout_pipe, PipeReader* stderr_pipe) {
+  return drain_pipes(stdout_pipe, stderr_pipe, CaptureOptions{}, {});
+}
+
+Result<DrainResult> drain_pipes(PipeReader* stdout_pipe, PipeReader* stderr_pipe,
+                                const CaptureOptions& options, const std::function<void()>& on_kill) {
+  return drain_pipes(StdinFeed{}, stdout_pipe, stderr_pipe, options, on_kill);
+}
+
+Result<DrainResult> drain_pipes(StdinFeed stdin_feed, PipeReader* stdout_pipe,
+                                PipeReader* stderr_pipe, const CaptureOptions& options,
+                                const std::function<void()>& on_kill) {
+  return drain_pipes(stdin_feed, stdout_pipe, stderr_pipe, options, on_kill, {});
+}
+
+Result<DrainResult> drain_pipes(StdinFeed stdin_feed, PipeReader* stdout_pipe,
+                                PipeReader* stderr_pipe, const CaptureOptions& options,
+                                const std::function<void()>& on_kill,
+                                const std::vector<ExtraCapture>& extra,
+                                DrainDeadline* deadline) {
+  DrainResult result;
+  result.stdout_data.reserve(options.stdout_size_hint);
+  result.stderr_data.reserve(options.stderr_size_hint);
+  BoundedCapture stdout_capture(&result.stdout_data, &result.stdout_dropped, options.stdout_limit,
+                                &on_kill);
+  BoundedCapture stderr_capture(&result.stderr_data, &result.stderr_dropped, options.stderr_limit,
+                                &on_kill);
+  auto stdout_sink = OutputSink::chunks(
+      OutputSink::ChunkCallback([&stdout_capture](const std::byte* data, std::size_t size) {
+        stdout_capture.append(reinterpret_cast<const char*>(data), size);
+      }));
+  auto stderr_sink = OutputSink::chunks(
+      OutputSink::ChunkCallback([&stderr_capture](const std::byte* data, std::size_t size) {
+        stderr_capture.append(reinterpret_cast<const char*>(data), size);
+      }));
+
+  std::optional<Digest> stdout_digest;
+  std::optional<Digest> stderr_digest;
+  if (options.stdout_digest) {
+    stdout_digest.emplace(*options.stdout_digest);
+  }
+  if (options.stderr_digest) {
+    stderr_digest.emplace(*options.stderr_digest);
+  }
+
+  // Unlimited streams skip the sink and read straight into the result string.
+  std::array targets = {
+      DrainTarget{.pipe = stdout_pipe,
+                  .sink = &stdout_sink,
+                  .direct = options.stdout_limit ? nullptr : &result.stdout_data,
+                  .done = false,
+                  .digest = stdout_digest ? &*stdout_digest : nullptr},
+      DrainTarget{.pipe = stderr_pipe,
+                  .sink = &stderr_sink,
+                  .direct = options.stderr_limit ? nullptr : &result.stderr_data,
+                  .done = false,
+                  .digest = stderr_digest ? &*stderr_digest : nullptr},
+  };
+  Result<void> drained;
+  if (extra.empty()) {
+    drained = drain_targets(targets.data(), targets.size(), &stdin_feed, deadline);
+  } else {
+    std::vector<DrainTarget> all(targets.begin(), targets.end());
+    all.reserve(targets.size() + extra.size());
+    for (const auto& capture : extra) {
+      all.push_back(DrainTarget{.pipe = capture.pipe, .sink = nullptr, .direct = capture.out});
+    }
+    drained = drain_targets(all.data(), all.size(), &stdin_feed, deadline);
+  }
+  if (!drained) {
+    return drained.error();
+  }
+  stdout_capture.finish();
+  stderr_capture.finish();
+  if (stdout_digest) {
+    result.stdout_digest = stdout_digest->hex();
+  }
+  if (stderr_digest) {
+    result.stderr_digest = stderr_digest->hex();
+  }
   return result;
 }
 
+Result<void> drain_pipes_into(PipeReader* stdout_pipe, PipeReader* stderr_pipe,
+                              std::string& stdout_data, std::string& stderr_data) {
+  std::array targets = {
+      DrainTarget{.pipe = stdout_pipe, .sink = nullptr, .direct = &stdout_data, .done = false},
+      DrainTarget{.pipe = stderr_pipe, .sink = nullptr, .direct = &stderr_data, .done = false},
+  };
+  return drain_targets(targets, nullptr);
+}
+
+Result<void> drain_pipes_into(PipeReader* stdout_pipe, PipeReader* stderr_pipe,
+                              ChunkedBuffer& stdout_data, ChunkedBuffer& stderr_data) {
+  std::array targets = {
+      DrainTarget{.pipe = stdout_pipe, .sink = nullptr, .direct = nullptr, .chunked = &stdout_data},
+      DrainTarget{.pipe = stderr_pipe, .sink = nullptr, .direct = nullptr, .chunked = &stderr_data},
+  };
+  return drain_targets(targets, nullptr);
+}
+
+Result<void> drain_pipes_timeline(PipeReader* stdout_pipe, PipeReader* stderr_pipe,
+                                  std::string& data, std::vector<TimelineRecord>& records) {
+  // Both streams read straight into the one buffer; the records say whose bytes are where.
+  std::array targets = {
+      DrainTarget{.pipe = stdout_pipe,
+                  .sink = nullptr,
+                  .direct = &data,
+                  .timeline = &records,
+                  .stream = OutputStream::out},
+      DrainTarget{.pipe = stderr_pipe,
+                  .sink = nullptr,
+                  .direct = &data,
+                  .timeline = &records,
+                  .stream = OutputStream::err},
+  };
+  return drain_targets(targets, nullptr);
+}
+
+Result<void> drain_pipes(PipeReader* stdout_pipe, PipeReader* stderr_pipe, OutputSink& stdout_sink,
+                         OutputSink& stderr_sink) {
+  std::array targets = {
+      DrainTarget{.pipe = stdout_pipe, .sink = &stdout_sink, .direct = nullptr, .done = false},
+      DrainTarget{.pipe = stderr_pipe, .sink = &stderr_sink, .direct = nullptr, .done = false},
+  };
+  return drain_targets(targets, nullptr);
+}
+
 }  // namespace procly::internal
@@ -2,30 +2,23 @@
 
 #include <unistd.h>
 
+#include <chrono>
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
+#include <memory>
 
 #include "procly/internal/access.hpp"
-
-#if PROCLY_PLATFORM_MACOS
-#include <crt_externs.h>
-#endif
+#include "procly/internal/command_run.hpp"
+#include "procly/internal/observe.hpp"
+#include "procly/internal/small_vector.hpp"
 
 namespace procly::internal {
 
 namespace {
 
-char** process_environ() {
-#if PROCLY_PLATFORM_MACOS
-  char*** envp = _NSGetEnviron();
-  return (envp != nullptr) ? *envp : nullptr;
-#else
-  return ::environ;
-#endif
-}
-
-enum class StdioTarget : std::uint8_t { stdin, stdout, stderr };
+// Environment overrides lowered without a heap allocation.
+constexpr std::size_t kInlineEnvDelta = 8;
 
 OpenMode default_open_mode(StdioTarget target) {
   return target == StdioTarget::stdin ? OpenMode::read : OpenMode::write_truncate;
@@ -40,6 +33,8 @@ bool mode_is_writable(OpenMode mode) {
          mode == OpenMode::read_write;
 }
 
+}  // namespace
+
 Result<StdioSpec> resolve_stdio(const std::optional<Stdio>& value, bool piped_default,
                                 StdioTarget target) {
   StdioSpec spec;
@@ -54,6 +49,7 @@ Result<StdioSpec> resolve_stdio(const std::optional<Stdio>& value, bool piped_de
     spec.kind = StdioSpec::Kind::null;
   } else if (std::holds_alternative<Stdio::Piped>(value->value)) {
     spec.kind = StdioSpec::Kind::piped;
+    spec.pipe_capacity = std::get<Stdio::Piped>(value->value).capacity;
   } else if (std::holds_alternative<Stdio::Fd>(value->value)) {
     int fd = std::get<Stdio::Fd>(value->value).fd;
     if (fd < 0) {
@@ -61,6 +57,7 @@ Result<StdioSpec> resolve_stdio(const std::optional<Stdio>& value, bool piped_de
     }
     spec.kind = StdioSpec::Kind::fd;
     spec.fd = fd;
+    spec.fd_owner = std::get<Stdio::Fd>(value->value).owner;
   } else if (std::holds_alternative<Stdio::File>(value->value)) {
     const auto& file = std::get<Stdio::File>(value->value);
     OpenMode mode = file.mode.value_or(default_open_mode(target));
@@ -79,53 +76,76 @@ Result<StdioSpec> resolve_stdio(const std::optional<Stdio>& value, bool piped_de
 #if PROCLY_PLATFORM_POSIX
     spec.perms = file.perms;
 #endif
+  } else if (std::holds_alternative<Stdio::Bytes>(value->value)) {
+    const auto& bytes = std::get<Stdio::Bytes>(value->value);
+    if (target != StdioTarget::stdin) {
+      return Error{.code = make_error_code(errc::invalid_stdio), .context = "bytes"};
+    }
+    auto file = create_sealed_file("procly-stdin", bytes.data ? *bytes.data : std::string_view());
+    if (!file) {
+      return file.error();
+    }
+    auto owned = std::make_shared<const unique_fd>(std::move(file.value()));
+    spec.kind = StdioSpec::Kind::fd;
+    spec.fd = owned->get();
+    spec.fd_owner = std::move(owned);
+    spec.bytes = bytes.data ? bytes.data : std::make_shared<const std::string>();
   }
   return spec;
 }
 
-}  // namespace
+EnvBlock lower_environment(const Command& cmd, std::optional<EnvBlock>* live_env) {
+  auto& cache = CommandAccess::env_cache(cmd);
+  if (auto cached = cache.load()) {
+    return *std::move(cached);
+  }
 
-Result<SpawnSpec> lower_command(const Command& cmd, SpawnMode mode,
-                                const StdioOverride* override_stdio) {
-  if (CommandAccess::argv(cmd).empty()) {
+  const auto& storage = CommandAccess::storage(cmd);
+  SmallVector<EnvDeltaEntry, kInlineEnvDelta> delta;
+  for (std::size_t index = 0; index < storage.env_count(); ++index) {
+    delta.push_back(storage.env_entry(index));
+  }
+  const auto& base = CommandAccess::env_base(cmd);
+  if (!CommandAccess::inherit_env(cmd)) {
+    auto block = apply_env_delta({}, delta.data(), delta.size());
+    cache.store(block);
+    return block;
+  }
+  if (base) {
+    auto block = apply_env_delta(EnvironmentAccess::block(*base).entries(), delta.data(),
+                                 delta.size());
+    cache.store(block);
+    return block;
+  }
+  // The live environment can change between spawns, so it is never cached on the command.
+  if (live_env == nullptr) {
+    return apply_env_delta(process_environment_entries(), delta.data(), delta.size());
+  }
+  if (!*live_env) {
+    *live_env = EnvBlock::from_entries(process_environment_entries());
+  }
+  if (delta.empty()) {
+    return **live_env;
+  }
+  return apply_env_delta((*live_env)->entries(), delta.data(), delta.size());
+}
+
+namespace {
+
+Result<SpawnSpec> lower_command_spec(const Command& cmd, SpawnMode mode,
+                                     const StdioOverride* override_stdio,
+                                     std::optional<EnvBlock>* live_env) {
+  if (CommandAccess::storage(cmd).arg_count() == 0) {
     return Error{.code = make_error_code(errc::empty_argv), .context = "argv"};
   }
 
   SpawnSpec spec;
-  spec.argv = CommandAccess::argv(cmd);
+  spec.argv = CommandAccess::storage(cmd).argv();
   spec.cwd = CommandAccess::cwd(cmd);
+  spec.cwd_fd = CommandAccess::cwd_fd(cmd);
   spec.opts = CommandAccess::options(cmd);
 
-  std::map<std::string, std::string, std::less<>> env_map;
-  if (CommandAccess::inherit_env(cmd)) {
-    for (char** env = process_environ(); env && *env != nullptr; ++env) {
-      std::string entry(*env);
-      auto pos = entry.find('=');
-      if (pos == std::string::npos) {
-        continue;
-      }
-      env_map[entry.substr(0, pos)] = entry.substr(pos + 1);
-    }
-  }
-
-  for (const auto& entry : CommandAccess::env_delta(cmd)) {
-    const auto& key = entry.first;
-    const auto& value = entry.second;
-    if (value.has_value()) {
-      env_map[key] = value.value();
-    } else {
-      env_map.erase(key);
-    }
-  }
-
-  for (const auto& [key, value] : env_map) {
-    std::string entry;
-    entry.reserve(key.size() + 1 + value.size());
-    entry.append(key);
-    entry.push_back('=');
-    entry.append(value);
-    spec.envp.push_back(std::move(entry));
-  }
+  spec.envp = lower_environment(cmd, live_env);
 
   const bool output_mode = (mode == SpawnMode::output);
 
@@ -169,6 +189,24 @@ Result<SpawnSpec> lower_command(const Command& cmd, SpawnMode mode,
   return spec;
 }
 
+}  // namespace
+
+Result<SpawnSpec> lower_command(const Command& cmd, SpawnMode mode,
+                                const StdioOverride* override_stdio,
+                                std::optional<EnvBlock>* live_env) {
+  auto* observer = current_observer();
+  if (observer == nullptr) {
+    return lower_command_spec(cmd, mode, override_stdio, live_env);
+  }
+  const auto start = std::chrono::steady_clock::now();
+  auto spec = lower_command_spec(cmd, mode, override_stdio, live_env);
+  if (spec) {
+    observer->on_lowered(LoweringEvent{
+        .program = spec->argv.front(), .start = start, .end = std::chrono::steady_clock::now()});
+  }
+  return spec;
+}
+
 Result<PipelineSpec> lower_pipeline(const Pipeline& pipeline, SpawnMode mode) {
   const auto& stages = PipelineAccess::stages(pipeline);
   if (stages.empty()) {
@@ -178,20 +216,30 @@ Result<PipelineSpec> lower_pipeline(const Pipeline& pipeline, SpawnMode mode) {
   PipelineSpec spec;
   spec.pipefail = PipelineAccess::pipefail(pipeline);
   spec.new_process_group = PipelineAccess::new_process_group(pipeline);
+  spec.pipe_capacity = PipelineAccess::pipe_capacity(pipeline);
+#if PROCLY_PLATFORM_LINUX
+  spec.cgroup = PipelineAccess::cgroup(pipeline);
+#endif
   spec.stages.reserve(stages.size());
 
   const std::size_t stage_count = stages.size();
+  // Function stages after the last command take over the pipeline's stdout.
+  const auto& functions = PipelineAccess::functions(pipeline);
+  if (!functions.empty() && functions.front().first == 0) {
+    return Error{.code = make_error_code(errc::invalid_pipeline), .context = "function_stage"};
+  }
+  bool trailing_functions = !functions.empty() && functions.back().first == stage_count;
   for (std::size_t index = 0; index < stage_count; ++index) {
     PipelineStageSpec stage;
     stage.command = &stages[index];
     stage.mode = (index + 1 == stage_count) ? mode : SpawnMode::spawn;
     stage.stdin_from_prev = index > 0;
-    stage.stdout_to_next = index + 1 < stage_count;
+    stage.stdout_to_next = index + 1 < stage_count || trailing_functions;
 
     if (index == 0 && PipelineAccess::stdin_opt(pipeline)) {
       stage.overrides.stdin_override = PipelineAccess::stdin_opt(pipeline);
     }
-    if (index + 1 == stage_count && PipelineAccess::stdout_opt(pipeline)) {
+    if (index + 1 == stage_count && !trailing_functions && PipelineAccess::stdout_opt(pipeline)) {
       stage.overrides.stdout_override = PipelineAccess::stdout_opt(pipeline);
     }
     if (index + 1 == stage_count && PipelineAccess::stderr_opt(pipeline)) {
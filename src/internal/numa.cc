@@ -0,0 +1,104 @@
+#include "procly/internal/numa.hpp"
+
+#if PROCLY_PLATFORM_LINUX
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <array>
+#include <cerrno>
+#include <charconv>
+#include <string>
+#include <system_error>
+
+#include "procly/internal/fd.hpp"
+
+namespace procly::internal {
+
+namespace {
+
+constexpr const char* kNodeRoot = "/sys/devices/system/node/";
+
+Error list_error(const char* context) {
+  return Error{.code = std::make_error_code(std::errc::protocol_error), .context = context};
+}
+
+// Reads a small sysfs file in one go; these lists fit in a page.
+Result<std::string> read_sysfs(const std::string& path, const char* context) {
+  unique_fd fd(::open(path.c_str(), O_RDONLY | O_CLOEXEC));
+  if (!fd) {
+    return Error{.code = std::error_code(errno, std::system_category()), .context = context};
+  }
+  constexpr std::size_t kListSize = 4096;
+  std::array<char, kListSize> buffer{};
+  ssize_t count = -1;
+  do {
+    count = ::read(fd.get(), buffer.data(), buffer.size());
+  } while (count == -1 && errno == EINTR);
+  if (count == -1) {
+    return Error{.code = std::error_code(errno, std::system_category()), .context = context};
+  }
+  return std::string(buffer.data(), static_cast<std::size_t>(count));
+}
+
+}  // namespace
+
+Result<std::vector<int>> parse_id_list(std::string_view list) {
+  while (!list.empty() && (list.back() == '\n' || list.back() == ' ')) {
+    list.remove_suffix(1);
+  }
+  std::vector<int> ids;
+  const char* at = list.data();
+  const char* end = list.data() + list.size();
+  while (at < end) {
+    int first = 0;
+    auto parsed = std::from_chars(at, end, first);
+    if (parsed.ec != std::errc()) {
+      return list_error("id list");
+    }
+    int last = first;
+    at = parsed.ptr;
+    if (at < end && *at == '-') {
+      parsed = std::from_chars(at + 1, end, last);
+      if (parsed.ec != std::errc() || last < first) {
+        return list_error("id list");
+      }
+      at = parsed.ptr;
+    }
+    for (int id = first; id <= last; ++id) {
+      ids.push_back(id);
+    }
+    if (at < end) {
+      if (*at != ',') {
+        return list_error("id list");
+      }
+      ++at;
+    }
+  }
+  return ids;
+}
+
+Result<std::vector<int>> online_numa_nodes() {
+  auto online = read_sysfs(std::string(kNodeRoot) + "online", "read(node/online)");
+  if (!online) {
+    // Kernels built without CONFIG_NUMA have no node directory: everything is node 0.
+    if (online.error().code == std::errc::no_such_file_or_directory) {
+      return std::vector<int>{0};
+    }
+    return online.error();
+  }
+  return parse_id_list(online.value());
+}
+
+Result<std::vector<int>> numa_node_cpus(int node) {
+  auto cpus = read_sysfs(std::string(kNodeRoot) + "node" + std::to_string(node) + "/cpulist",
+                         "read(node/cpulist)");
+  if (!cpus) {
+    return cpus.error();
+  }
+  return parse_id_list(cpus.value());
+}
+
+}  // namespace procly::internal
+
+#endif
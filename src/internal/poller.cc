@@ -0,0 +1,176 @@
+#include "procly/internal/poller.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <climits>
+
+#if PROCLY_PLATFORM_LINUX
+#include <sys/epoll.h>
+#elif PROCLY_PLATFORM_MACOS
+#include <sys/event.h>
+#endif
+
+namespace procly::internal {
+
+namespace {
+
+constexpr int kMaxEvents = 64;
+
+Error make_errno_error(const char* context) {
+  return Error{.code = std::error_code(errno, std::system_category()), .context = context};
+}
+
+int timeout_ms(std::optional<std::chrono::milliseconds> timeout) {
+  if (!timeout) {
+    return -1;
+  }
+  return static_cast<int>(
+      std::clamp<std::chrono::milliseconds::rep>(timeout->count(), 0, INT_MAX));
+}
+
+}  // namespace
+
+#if PROCLY_PLATFORM_LINUX
+
+Result<Poller> Poller::create() {
+  Poller poller;
+  poller.fd_.reset(::epoll_create1(EPOLL_CLOEXEC));
+  if (!poller.fd_) {
+    return make_errno_error("epoll_create1");
+  }
+  return poller;
+}
+
+Result<void> Poller::add(int fd, Interest interest) {
+  epoll_event event{};
+  event.events = interest == Interest::readable ? EPOLLIN : EPOLLOUT;
+  event.data.fd = fd;
+  if (::epoll_ctl(fd_.get(), EPOLL_CTL_ADD, fd, &event) == -1) {
+    return make_errno_error("epoll_ctl(ADD)");
+  }
+  return {};
+}
+
+Result<void> Poller::remove(int fd, Interest interest) {
+  (void)interest;
+  if (::epoll_ctl(fd_.get(), EPOLL_CTL_DEL, fd, nullptr) == -1) {
+    return make_errno_error("epoll_ctl(DEL)");
+  }
+  return {};
+}
+
+Result<void> Poller::wait(std::optional<std::chrono::milliseconds> timeout,
+                          std::vector<int>* ready) {
+  std::array<epoll_event, kMaxEvents> events{};
+  int count = ::epoll_wait(fd_.get(), events.data(), kMaxEvents, timeout_ms(timeout));
+  if (count == -1) {
+    if (errno == EINTR) {
+      return {};
+    }
+    return make_errno_error("epoll_wait");
+  }
+  for (int i = 0; i < count; ++i) {
+    ready->push_back(events[static_cast<std::size_t>(i)].data.fd);
+  }
+  return {};
+}
+
+#elif PROCLY_PLATFORM_MACOS
+
+Result<Poller> Poller::create() {
+  Poller poller;
+  poller.fd_.reset(::kqueue());
+  if (!poller.fd_) {
+    return make_errno_error("kqueue");
+  }
+  auto cloexec = set_cloexec(poller.fd_.get());
+  if (!cloexec) {
+    return cloexec.error();
+  }
+  return poller;
+}
+
+Result<void> Poller::add(int fd, Interest interest) {
+  struct kevent change {};
+  EV_SET(&change, fd, interest == Interest::readable ? EVFILT_READ : EVFILT_WRITE, EV_ADD, 0, 0,
+         nullptr);
+  if (::kevent(fd_.get(), &change, 1, nullptr, 0, nullptr) == -1) {
+    return make_errno_error("kevent(EV_ADD)");
+  }
+  return {};
+}
+
+Result<void> Poller::remove(int fd, Interest interest) {
+  struct kevent change {};
+  EV_SET(&change, fd, interest == Interest::readable ? EVFILT_READ : EVFILT_WRITE, EV_DELETE, 0,
+         0, nullptr);
+  if (::kevent(fd_.get(), &change, 1, nullptr, 0, nullptr) == -1) {
+    return make_errno_error("kevent(EV_DELETE)");
+  }
+  return {};
+}
+
+Result<void> Poller::wait(std::optional<std::chrono::milliseconds> timeout,
+                          std::vector<int>* ready) {
+  std::array<struct kevent, kMaxEvents> events{};
+  timespec ts{};
+  timespec* ts_ptr = nullptr;
+  if (timeout) {
+    auto ms = std::max<std::chrono::milliseconds::rep>(timeout->count(), 0);
+    ts.tv_sec = static_cast<time_t>(ms / 1000);
+    ts.tv_nsec = static_cast<long>((ms % 1000) * 1000000);
+    ts_ptr = &ts;
+  }
+  int count = ::kevent(fd_.get(), nullptr, 0, events.data(), kMaxEvents, ts_ptr);
+  if (count == -1) {
+    if (errno == EINTR) {
+      return {};
+    }
+    return make_errno_error("kevent");
+  }
+  for (int i = 0; i < count; ++i) {
+    ready->push_back(static_cast<int>(events[static_cast<std::size_t>(i)].ident));
+  }
+  return {};
+}
+
+#else
+
+Result<Poller> Poller::create() { return Poller(); }
+
+Result<void> Poller::add(int fd, Interest interest) {
+  fds_.push_back(pollfd{
+      .fd = fd, .events = interest == Interest::readable ? POLLIN : POLLOUT, .revents = 0});
+  return {};
+}
+
+Result<void> Poller::remove(int fd, Interest interest) {
+  (void)interest;
+  fds_.erase(std::remove_if(fds_.begin(), fds_.end(),
+                            [fd](const pollfd& pfd) { return pfd.fd == fd; }),
+             fds_.end());
+  return {};
+}
+
+Result<void> Poller::wait(std::optional<std::chrono::milliseconds> timeout,
+                          std::vector<int>* ready) {
+  int count = ::poll(fds_.data(), fds_.size(), timeout_ms(timeout));
+  if (count == -1) {
+    if (errno == EINTR) {
+      return {};
+    }
+    return make_errno_error("poll");
+  }
+  for (auto& pfd : fds_) {
+    if (pfd.revents != 0) {
+      ready->push_back(pfd.fd);
+      pfd.revents = 0;
+    }
+  }
+  return {};
+}
+
+#endif
+
+}  // namespace procly::internal
@@ -1,21 +1,45 @@
 #include <dirent.h>
 #include <fcntl.h>
 #include <spawn.h>
+#include <sys/resource.h>
 #include <sys/wait.h>
 #include <unistd.h>
 
+#include "procly/platform.hpp"
+
+#include <poll.h>
+
+#if PROCLY_PLATFORM_LINUX
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+#if PROCLY_PLATFORM_MACOS
+#include <sys/event.h>
+#endif
+
 #include <algorithm>
 #include <cerrno>
+#include <climits>
 #include <csignal>
 #include <cstdlib>
 #include <cstring>
+#include <array>
 #include <filesystem>
-#include <string_view>
+#include <memory>
+#include <thread>
 #include <unordered_set>
 
 #include "procly/internal/backend.hpp"
+#include "procly/internal/close_fds.hpp"
+#include "procly/internal/exec_path.hpp"
 #include "procly/internal/fd.hpp"
+#include "procly/internal/numa.hpp"
+#include "procly/internal/observe.hpp"
 #include "procly/internal/posix_spawn.hpp"
+#include "procly/internal/posix_wait.hpp"
+#include "procly/internal/reaper.hpp"
 #include "procly/internal/wait_policy.hpp"
 
 namespace procly::internal {
@@ -30,9 +54,20 @@ Error make_spawn_error(int error, const char* context) {
   return Error{.code = std::error_code(error, std::system_category()), .context = context};
 }
 
-constexpr long kFallbackMaxFd = 256;
 constexpr int kExecFailureExitCode = 127;
+// Wait cadence for children of a Reaper that stopped before they were collected.
+constexpr std::chrono::milliseconds kReaperPollInterval{1};
 constexpr int kDefaultFileMode = 0666;
+
+#if !defined(POSIX_SPAWN_CLOEXEC_DEFAULT) && defined(__GLIBC__) && \
+    (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 34))
+#define PROCLY_HAS_SPAWN_ADDCLOSEFROM 1
+#else
+#define PROCLY_HAS_SPAWN_ADDCLOSEFROM 0
+#endif
+
+#if !defined(POSIX_SPAWN_CLOEXEC_DEFAULT) && !PROCLY_HAS_SPAWN_ADDCLOSEFROM
+constexpr long kFallbackMaxFd = 256;
 constexpr int kParseBase = 10;
 
 std::vector<int> list_open_fds() {
@@ -73,9 +108,25 @@ std::vector<int> list_open_fds() {
   std::ranges::sort(fds);
   return fds;
 }
+#endif
 
+// Keep inherited descriptors out of the posix_spawn child. POSIX_SPAWN_CLOEXEC_DEFAULT (set with
+// the other attr flags) and addclosefrom_np cost the same regardless of how many fds are open;
+// the per-fd close list is only the last resort.
 Result<void> add_close_actions_for_inherited_fds(posix_spawn_file_actions_t* actions,
                                                  std::unordered_set<int>* closed_fds) {
+#if defined(POSIX_SPAWN_CLOEXEC_DEFAULT)
+  (void)actions;
+  (void)closed_fds;
+  return {};
+#elif PROCLY_HAS_SPAWN_ADDCLOSEFROM
+  (void)closed_fds;
+  int rc = posix_spawn_file_actions_addclosefrom_np(actions, STDERR_FILENO + 1);
+  if (rc != 0) {
+    return make_spawn_error(rc, "posix_spawn_file_actions_addclosefrom_np");
+  }
+  return {};
+#else
   auto fds = list_open_fds();
   for (int fd : fds) {
     if (fd <= STDERR_FILENO) {
@@ -91,84 +142,37 @@ Result<void> add_close_actions_for_inherited_fds(posix_spawn_file_actions_t* act
     closed_fds->insert(fd);
   }
   return {};
+#endif
 }
 
-std::optional<std::string> find_env_value(const std::vector<std::string>& envp, const char* key) {
-  std::size_t key_len = std::strlen(key);
-  for (const auto& entry : envp) {
-    if (entry.size() <= key_len) {
-      continue;
+// argv as the pointer array exec expects, without copying the strings; exec never writes
+// through it. Short argument lists stay on the stack.
+class ArgvPointers {
+ public:
+  explicit ArgvPointers(const std::vector<std::string>& argv) {
+    char** out = inline_.data();
+    if (argv.size() + 1 > inline_.size()) {
+      heap_.resize(argv.size() + 1);
+      out = heap_.data();
     }
-    if (entry.compare(0, key_len, key) != 0 || entry[key_len] != '=') {
-      continue;
+    for (std::size_t i = 0; i < argv.size(); ++i) {
+      out[i] = const_cast<char*>(argv[i].c_str());  // NOLINT(cppcoreguidelines-pro-type-const-cast)
     }
-    return entry.substr(key_len + 1);
-  }
-  return std::nullopt;
-}
-
-std::filesystem::path resolve_search_dir(std::string_view raw_dir,
-                                         const std::optional<std::filesystem::path>& cwd) {
-  std::filesystem::path dir =
-      raw_dir.empty() ? std::filesystem::path(".") : std::filesystem::path(raw_dir);
-  if (cwd && dir.is_relative()) {
-    return *cwd / dir;
+    out[argv.size()] = nullptr;
+    data_ = out;
   }
-  return dir;
-}
+  ArgvPointers(const ArgvPointers&) = delete;
+  ArgvPointers& operator=(const ArgvPointers&) = delete;
 
-// Resolve argv[0] before fork so the child only needs async-signal-safe syscalls.
-std::string resolve_exec_path(const std::string& argv0, const std::vector<std::string>& envp,
-                              const std::optional<std::filesystem::path>& cwd) {
-  if (argv0.find('/') != std::string::npos) {
-    return argv0;
-  }
-  std::string path_value;
-  if (auto env_path = find_env_value(envp, "PATH")) {
-    path_value = std::move(*env_path);
-  } else {
-    path_value = "/usr/bin:/bin";
-  }
-  if (path_value.empty()) {
-    return argv0;
-  }
-  std::size_t start = 0;
-  while (true) {
-    std::size_t end = path_value.find(':', start);
-    std::size_t len = (end == std::string::npos) ? path_value.size() - start : end - start;
-    std::string_view dir =
-        (len == 0) ? std::string_view(".") : std::string_view(path_value).substr(start, len);
-    std::filesystem::path candidate = resolve_search_dir(dir, cwd) / argv0;
-    if (::access(candidate.c_str(), X_OK) == 0) {
-      return candidate.string();
-    }
-    if (end == std::string::npos) {
-      break;
-    }
-    start = end + 1;
-  }
-  return argv0;
-}
+  [[nodiscard]] char* const* data() const noexcept { return data_; }
 
-long max_open_fd_limit() {
-  long max_fd = ::sysconf(_SC_OPEN_MAX);
-  if (max_fd < 0) {
-    return kFallbackMaxFd;
-  }
-  return max_fd;
-}
+ private:
+  static constexpr std::size_t kInlineCount = 16;
 
-// Close all inherited descriptors after dup2 so descriptors opened by other threads between
-// pre-fork bookkeeping and fork() do not leak into the exec'ed process.
-void close_inherited_fds_after_fork(int keep_fd) {
-  long max_fd = max_open_fd_limit();
-  for (int fd = STDERR_FILENO + 1; fd < max_fd; ++fd) {
-    if (fd == keep_fd) {
-      continue;
-    }
-    ::close(fd);
-  }
-}
+  std::array<char*, kInlineCount> inline_{};
+  std::vector<char*> heap_;
+  char** data_ = nullptr;
+};
 
 void reap_child_after_exec_failure(pid_t pid) {
   if (pid <= 0) {
@@ -194,20 +198,6 @@ Result<int> open_null(bool read_only) {
   return fd;
 }
 
-int open_flags_for(OpenMode mode) {
-  switch (mode) {
-    case OpenMode::read:
-      return O_RDONLY;
-    case OpenMode::write_truncate:
-      return O_WRONLY | O_CREAT | O_TRUNC;
-    case OpenMode::write_append:
-      return O_WRONLY | O_CREAT | O_APPEND;
-    case OpenMode::read_write:
-      return O_RDWR | O_CREAT;
-  }
-  return O_RDONLY;
-}
-
 Result<int> open_file(const std::filesystem::path& path, OpenMode mode,
                       std::optional<FilePerms> perms) {
   int flags = open_flags_for(mode);
@@ -223,42 +213,59 @@ Result<int> open_file(const std::filesystem::path& path, OpenMode mode,
   return fd;
 }
 
-ExitStatus to_exit_status(int status) {
-  if (WIFEXITED(status)) {
-    return ExitStatus::exited(WEXITSTATUS(status), static_cast<std::uint32_t>(status));
-  }
-  return ExitStatus::other(static_cast<std::uint32_t>(status));
-}
-
-Result<ExitStatus> wait_pid_blocking(pid_t pid) {
-  int status = 0;
-  while (true) {
-    pid_t rv = ::waitpid(pid, &status, 0);
-    if (rv == pid) {
-      return to_exit_status(status);
-    }
-    if (errno == EINTR) {
-      continue;
+// Blocks until an unreaped child exits, using open_exit_fd(). Inactive when the kernel has no
+// exit notification; wait_with_timeout then polls try_wait.
+class ExitWatcher {
+ public:
+  explicit ExitWatcher(pid_t pid) {
+    auto fd = open_exit_fd(pid);
+    if (fd) {
+      fd_ = std::move(fd.value());
+    } else {
+      // ESRCH: the child already exited, so there is nothing left to wait for.
+      exited_ = is_esrch(fd.error());
     }
-    return make_errno_error("waitpid");
   }
-}
 
-Result<std::optional<ExitStatus>> try_wait_pid(pid_t pid) {
-  int status = 0;
-  while (true) {
-    pid_t rv = ::waitpid(pid, &status, WNOHANG);
-    if (rv == pid) {
-      return std::optional<ExitStatus>(to_exit_status(status));
+  [[nodiscard]] bool active() const noexcept { return static_cast<bool>(fd_) || exited_; }
+
+  Result<void> wait_for(std::chrono::milliseconds budget) {
+    if (exited_) {
+      return {};
     }
-    if (rv == 0) {
-      return std::optional<ExitStatus>();
+#if PROCLY_PLATFORM_MACOS
+    auto secs = std::chrono::duration_cast<std::chrono::seconds>(budget);
+    timespec ts{.tv_sec = static_cast<time_t>(secs.count()),
+                .tv_nsec = static_cast<long>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(budget - secs).count())};
+    struct kevent event {};
+    int rc = ::kevent(fd_.get(), nullptr, 0, &event, 1, &ts);
+    if (rc == -1 && errno != EINTR) {
+      return make_errno_error("kevent");
     }
-    if (errno == EINTR) {
-      continue;
+    exited_ = rc > 0;
+#else
+    pollfd pfd{.fd = fd_.get(), .events = POLLIN, .revents = 0};
+    auto timeout_ms = std::min<std::chrono::milliseconds::rep>(budget.count(), INT_MAX);
+    if (::poll(&pfd, 1, static_cast<int>(timeout_ms)) == -1 && errno != EINTR) {
+      return make_errno_error("poll(pidfd)");
     }
-    return make_errno_error("waitpid");
+#endif
+    return {};
   }
+
+ private:
+  unique_fd fd_;
+  bool exited_ = false;
+};
+
+// The running Reaper when it adopted this process, else null.
+std::shared_ptr<ReaperCore> reaper_for(const Spawned& spawned) {
+  if (spawned.pid <= 0 || spawned.terminal_result) {
+    return nullptr;
+  }
+  auto reaper = active_reaper();
+  return reaper && reaper->owns(spawned.pid) ? reaper : nullptr;
 }
 
 Result<void> send_signal(const Spawned& spawned, int signo) {
@@ -272,12 +279,108 @@ Result<void> send_signal(const Spawned& spawned, int signo) {
   if (spawned.new_process_group && spawned.pgid) {
     target = -(*spawned.pgid);
   }
-  if (::kill(target, signo) == -1) {
+  if (auto reaper = reaper_for(spawned)) {
+    // The reaper may have collected the pid already; it signals only while the pid is ours.
+    auto sent = reaper->signal(spawned.pid, target, signo);
+    if (!sent || !sent.value()) {
+      return sent ? Result<void>() : Result<void>(sent.error());
+    }
+  } else if (::kill(target, signo) == -1) {
     return make_errno_error("kill");
   }
+  if (auto* observer = current_observer()) {
+    observer->on_signal(SignalEvent{
+        .target = target, .signo = signo, .time = std::chrono::steady_clock::now()});
+  }
+  return {};
+}
+
+#if PROCLY_PLATFORM_LINUX
+int native_policy(SchedulingPolicy policy) {
+  switch (policy) {
+    case SchedulingPolicy::batch:
+      return SCHED_BATCH;
+    case SchedulingPolicy::idle:
+      return SCHED_IDLE;
+    case SchedulingPolicy::inherit:
+    case SchedulingPolicy::normal:
+      break;
+  }
+  return SCHED_OTHER;
+}
+
+Result<void> fill_cpu_set(const std::vector<int>& cpus, cpu_set_t* set) {
+  CPU_ZERO(set);
+  for (int cpu : cpus) {
+    if (cpu < 0 || cpu >= CPU_SETSIZE) {
+      return Error{.code = std::make_error_code(std::errc::invalid_argument),
+                   .context = "cpu_affinity"};
+    }
+    CPU_SET(cpu, set);
+  }
+  return {};
+}
+
+// Node mask for set_mempolicy(); sized for the kernel's largest MAX_NUMNODES.
+constexpr int kMaxNumaNodes = 1024;
+constexpr int kMaskWordBits = static_cast<int>(sizeof(unsigned long) * CHAR_BIT);
+using NumaMask = std::array<unsigned long, kMaxNumaNodes / kMaskWordBits>;
+
+// MPOL_* from <linux/mempolicy.h>; libnuma's <numaif.h> is not required.
+int mempolicy_mode(NumaPolicy policy) {
+  constexpr int kMpolPreferred = 1;
+  constexpr int kMpolBind = 2;
+  constexpr int kMpolInterleave = 3;
+  switch (policy) {
+    case NumaPolicy::preferred:
+      return kMpolPreferred;
+    case NumaPolicy::interleave:
+      return kMpolInterleave;
+    case NumaPolicy::bind:
+      break;
+  }
+  return kMpolBind;
+}
+
+// Fills the node mask and, when cpus is non-null, the CPUs of those nodes. preferred takes a
+// single node, so only the first one is set for it.
+Result<void> fill_numa_mask(const SpawnOptions& opts, NumaMask* mask, cpu_set_t* cpus) {
+  mask->fill(0);
+  if (cpus != nullptr) {
+    CPU_ZERO(cpus);
+  }
+  for (int node : opts.numa_nodes) {
+    if (node < 0 || node >= kMaxNumaNodes) {
+      return Error{.code = std::make_error_code(std::errc::invalid_argument),
+                   .context = "numa_nodes"};
+    }
+    (*mask)[static_cast<std::size_t>(node / kMaskWordBits)] |= 1UL << (node % kMaskWordBits);
+    if (cpus != nullptr) {
+      auto node_cpus = numa_node_cpus(node);
+      if (!node_cpus) {
+        return node_cpus.error();
+      }
+      for (int cpu : node_cpus.value()) {
+        if (cpu < CPU_SETSIZE) {
+          CPU_SET(cpu, cpus);
+        }
+      }
+    }
+    if (opts.numa_policy == NumaPolicy::preferred) {
+      break;
+    }
+  }
   return {};
 }
 
+constexpr int kIoprioWhoProcess = 1;
+constexpr int kIoprioClassShift = 13;
+
+int ioprio_value(const IoPriority& priority) {
+  return (static_cast<int>(priority.io_class) << kIoprioClassShift) | priority.level;
+}
+#endif
+
 struct SpawnActionState {
   posix_spawn_file_actions_t actions;
   posix_spawnattr_t attr;
@@ -352,8 +455,20 @@ Result<Spawned> spawn_posix_spawnp(const SpawnSpec& spec) {
         "posix_spawn_file_actions_addopen");
   };
 
-  if (spec.cwd) {
-#if PROCLY_PLATFORM_MACOS
+  if (spec.cwd_fd) {
+#if PROCLY_HAS_SPAWN_CHDIR
+    auto chdir_action =
+        add_spawn_action(posix_spawn_file_actions_addfchdir_np(&state.actions, *spec.cwd_fd),
+                         "posix_spawn_file_actions_addfchdir_np");
+    if (!chdir_action) {
+      return cleanup_and_return(chdir_action.error());
+    }
+#else
+    return cleanup_and_return(
+        Error{.code = make_error_code(errc::chdir_failed), .context = "posix_spawn_fchdir"});
+#endif
+  } else if (spec.cwd) {
+#if PROCLY_HAS_SPAWN_CHDIR
     auto chdir_action =
         add_spawn_action(posix_spawn_file_actions_addchdir_np(&state.actions, spec.cwd->c_str()),
                          "posix_spawn_file_actions_addchdir_np");
@@ -382,7 +497,27 @@ Result<Spawned> spawn_posix_spawnp(const SpawnSpec& spec) {
 #endif
   }
 #ifdef POSIX_SPAWN_CLOEXEC_DEFAULT
-  flags = static_cast<short>(flags | POSIX_SPAWN_CLOEXEC_DEFAULT);
+  if (!spec.opts.trust_cloexec) {
+    flags = static_cast<short>(flags | POSIX_SPAWN_CLOEXEC_DEFAULT);
+  }
+#endif
+#if PROCLY_PLATFORM_LINUX
+  // Only normal gets here; can_use_posix_spawn() sends batch and idle to the fork path.
+  if (spec.opts.scheduling_policy != SchedulingPolicy::inherit) {
+    flags = static_cast<short>(flags | POSIX_SPAWN_SETSCHEDULER);
+    auto set_policy = add_spawn_action(
+        posix_spawnattr_setschedpolicy(&state.attr, native_policy(spec.opts.scheduling_policy)),
+        "posix_spawnattr_setschedpolicy");
+    if (!set_policy) {
+      return cleanup_and_return(set_policy.error());
+    }
+    sched_param param{};
+    auto set_param = add_spawn_action(posix_spawnattr_setschedparam(&state.attr, &param),
+                                      "posix_spawnattr_setschedparam");
+    if (!set_param) {
+      return cleanup_and_return(set_param.error());
+    }
+  }
 #endif
   if (flags != 0) {
     auto set_flags =
@@ -414,7 +549,7 @@ Result<Spawned> spawn_posix_spawnp(const SpawnSpec& spec) {
         return add_dup(stdio.fd, target_fd);
       }
       case StdioSpec::Kind::piped: {
-        auto pipe_result = create_pipe();
+        auto pipe_result = create_pipe(stdio.pipe_capacity);
         if (!pipe_result) {
           return pipe_result.error();
         }
@@ -473,34 +608,42 @@ Result<Spawned> spawn_posix_spawnp(const SpawnSpec& spec) {
     }
   }
 
-#if !defined(POSIX_SPAWN_CLOEXEC_DEFAULT)
-  auto close_result = add_close_actions_for_inherited_fds(&state.actions, &closed_fds);
-  if (!close_result) {
-    return cleanup_and_return(close_result.error());
+  if (!spec.opts.trust_cloexec) {
+    auto close_result = add_close_actions_for_inherited_fds(&state.actions, &closed_fds);
+    if (!close_result) {
+      return cleanup_and_return(close_result.error());
+    }
   }
-#endif
 
-  std::vector<std::string> argv_copy = spec.argv;
-  std::vector<char*> argv_c;
-  argv_c.reserve(argv_copy.size() + 1);
-  for (auto& arg : argv_copy) {
-    argv_c.push_back(arg.data());
+  ArgvPointers argv_c(spec.argv);
+  std::optional<std::string> exec_path = spec.exec_path;
+  if (!exec_path) {
+    exec_path = cached_exec_path(spec.argv.front(), spec.envp, spec.cwd, spec.opts.path_lookup,
+                                 spec.cwd_fd);
   }
-  argv_c.push_back(nullptr);
-
-  std::vector<std::string> envp_copy = spec.envp;
-  std::vector<char*> envp_c;
-  envp_c.reserve(envp_copy.size() + 1);
-  for (auto& entry : envp_copy) {
-    envp_c.push_back(entry.data());
+  if (!exec_path && (spec.cwd || spec.cwd_fd) && spec.argv.front().find('/') == std::string::npos) {
+    // posix_spawnp searches the parent's PATH; a child with its own cwd gets the same lookup as
+    // the fork path (the child's PATH, relative entries under the new cwd).
+    std::string resolved =
+        resolve_exec_path(spec.argv.front(), spec.envp, spec.cwd, spec.cwd_fd);
+    if (resolved.find('/') != std::string::npos) {
+      exec_path = std::move(resolved);
+    }
   }
-  envp_c.push_back(nullptr);
 
   pid_t pid = -1;
-  int spawn_rc =
-      ::posix_spawnp(&pid, argv_c[0], &state.actions, &state.attr, argv_c.data(), envp_c.data());
-  if (spawn_rc != 0) {
-    return cleanup_and_return(make_spawn_error(spawn_rc, "posix_spawnp"));
+  if (exec_path) {
+    int spawn_rc = ::posix_spawn(&pid, exec_path->c_str(), &state.actions, &state.attr,
+                                 argv_c.data(), spec.envp.data());
+    if (spawn_rc != 0) {
+      return cleanup_and_return(make_spawn_error(spawn_rc, "posix_spawn"));
+    }
+  } else {
+    int spawn_rc = ::posix_spawnp(&pid, spec.argv.front().c_str(), &state.actions, &state.attr,
+                                  argv_c.data(), spec.envp.data());
+    if (spawn_rc != 0) {
+      return cleanup_and_return(make_spawn_error(spawn_rc, "posix_spawnp"));
+    }
   }
 
   Spawned spawned;
@@ -526,197 +669,445 @@ Result<Spawned> spawn_posix_spawnp(const SpawnSpec& spec) {
   return spawned;
 }
 
-class PosixBackend final : public Backend {
- public:
-  Result<Spawned> spawn(const SpawnSpec& spec) override {
-    if (spec.argv.empty()) {
-      return Error{.code = make_error_code(errc::empty_argv), .context = "argv"};
-    }
-
-    if (select_spawn_strategy(spec) == SpawnStrategy::posix_spawn) {
-      return spawn_posix_spawnp(spec);
-    }
+// Everything the child runs between fork/clone and exec, prepared by the parent so the child
+// only makes async-signal-safe syscalls.
+struct ChildExecPlan {
+  const SpawnSpec* spec = nullptr;
+  const char* exec_path = nullptr;
+  char* const* argv = nullptr;
+  int stdin_fd = STDIN_FILENO;
+  int stdout_fd = STDOUT_FILENO;
+  int stderr_fd = STDERR_FILENO;
+  int error_read_fd = -1;
+  int error_write_fd = -1;
+  // Set instead of the error pipe when the child shares the parent's memory (vfork), which
+  // resumes only after exec or _exit and then reads the errno here.
+  int* shared_errno = nullptr;
+  // cgroup directory; the child joins it through cgroup.procs when join_cgroup is set (clone3
+  // unavailable), otherwise clone3 already created it there.
+  int cgroup_fd = -1;
+  bool join_cgroup = false;
+#if PROCLY_PLATFORM_LINUX
+  const cpu_set_t* affinity = nullptr;
+  const NumaMask* numa_mask = nullptr;
+#endif
+  const sigset_t* restore_mask = nullptr;
+};
 
-    std::vector<int> opened_fds;
-    std::optional<int> parent_stdin;
-    std::optional<int> parent_stdout;
-    std::optional<int> parent_stderr;
+#if defined(__GLIBC__)
+using rlimit_resource = __rlimit_resource_t;
+#else
+using rlimit_resource = int;
+#endif
 
-    int child_stdin = STDIN_FILENO;
-    int child_stdout = STDOUT_FILENO;
-    int child_stderr = STDERR_FILENO;
+[[noreturn]] void report_child_failure(const ChildExecPlan& plan) noexcept {
+  int err = errno;
+  if (plan.shared_errno != nullptr) {
+    *plan.shared_errno = err;
+  } else {
+    ::write(plan.error_write_fd, &err, sizeof(err));
+  }
+  _exit(kExecFailureExitCode);
+}
 
-    auto open_for_spec = [&](const StdioSpec& spec, bool read_only, bool is_stdout,
-                             std::optional<int>& parent_fd) -> Result<int> {
-      switch (spec.kind) {
-        case StdioSpec::Kind::inherit:
-          if (read_only) {
-            return STDIN_FILENO;
-          }
-          if (is_stdout) {
-            return STDOUT_FILENO;
-          }
-          return STDERR_FILENO;
-        case StdioSpec::Kind::null: {
-          auto fd = open_null(read_only);
-          if (!fd) {
-            return fd.error();
-          }
-          opened_fds.push_back(fd.value());
-          return fd.value();
-        }
-        case StdioSpec::Kind::file: {
-          auto fd = open_file(spec.path, spec.mode, spec.perms);
-          if (!fd) {
-            return fd.error();
-          }
-          opened_fds.push_back(fd.value());
-          return fd.value();
-        }
-        case StdioSpec::Kind::fd:
-          return spec.fd;
-        case StdioSpec::Kind::piped: {
-          auto pipe_result = create_pipe();
-          if (!pipe_result) {
-            return pipe_result.error();
-          }
-          auto [read_end, write_end] = std::move(pipe_result.value());
-          int read_fd = read_end.release();
-          int write_fd = write_end.release();
-          opened_fds.push_back(read_fd);
-          opened_fds.push_back(write_fd);
-          if (read_only) {
-            parent_fd = write_fd;
-            return read_fd;
-          }
-          parent_fd = read_fd;
-          return write_fd;
-        }
-        case StdioSpec::Kind::dup_stdout:
-          return STDOUT_FILENO;
-      }
-      return Error{.code = make_error_code(errc::invalid_stdio), .context = "stdio"};
-    };
+[[noreturn]] void exec_child(const ChildExecPlan& plan) noexcept {
+  const SpawnSpec& spec = *plan.spec;
+  if (plan.error_read_fd >= 0) {
+    ::close(plan.error_read_fd);
+  }
 
-    auto stdout_fd = open_for_spec(spec.stdout_spec, false, true, parent_stdout);
-    if (!stdout_fd) {
-      return stdout_fd.error();
+  if (plan.join_cgroup) {
+    int procs_fd = ::openat(plan.cgroup_fd, "cgroup.procs", O_WRONLY | O_CLOEXEC);
+    if (procs_fd == -1 || ::write(procs_fd, "0", 1) != 1) {
+      report_child_failure(plan);
     }
-    child_stdout = stdout_fd.value();
+    ::close(procs_fd);
+  }
 
-    auto stdin_fd = open_for_spec(spec.stdin_spec, true, false, parent_stdin);
-    if (!stdin_fd) {
-      return stdin_fd.error();
+  for (const auto& limit : spec.opts.limits) {
+    struct rlimit value {};
+    value.rlim_cur = static_cast<rlim_t>(limit.soft);
+    value.rlim_max = static_cast<rlim_t>(limit.hard);
+    if (::setrlimit(static_cast<rlimit_resource>(limit.resource), &value) == -1) {
+      report_child_failure(plan);
     }
-    child_stdin = stdin_fd.value();
+  }
 
-    if (spec.stderr_spec.kind == StdioSpec::Kind::dup_stdout) {
-      child_stderr = child_stdout;
-    } else {
-      auto stderr_fd = open_for_spec(spec.stderr_spec, false, false, parent_stderr);
-      if (!stderr_fd) {
-        return stderr_fd.error();
-      }
-      child_stderr = stderr_fd.value();
+#if PROCLY_PLATFORM_LINUX
+  // Before anything else allocates in the child, so exec'd memory lands on the chosen nodes.
+  if (plan.numa_mask != nullptr &&
+      ::syscall(SYS_set_mempolicy, mempolicy_mode(spec.opts.numa_policy), plan.numa_mask->data(),
+                static_cast<unsigned long>(kMaxNumaNodes) + 1) == -1) {
+    report_child_failure(plan);
+  }
+  if (plan.affinity != nullptr && ::sched_setaffinity(0, sizeof(cpu_set_t), plan.affinity) == -1) {
+    report_child_failure(plan);
+  }
+  if (spec.opts.scheduling_policy != SchedulingPolicy::inherit) {
+    sched_param param{};
+    if (::sched_setscheduler(0, native_policy(spec.opts.scheduling_policy), &param) == -1) {
+      report_child_failure(plan);
     }
+  }
+  if (spec.opts.io_priority &&
+      ::syscall(SYS_ioprio_set, kIoprioWhoProcess, 0, ioprio_value(*spec.opts.io_priority)) == -1) {
+    report_child_failure(plan);
+  }
+#endif
+  if (spec.opts.nice && ::setpriority(PRIO_PROCESS, 0, *spec.opts.nice) == -1) {
+    report_child_failure(plan);
+  }
 
-    // Error pipe communicates child setup/exec failures back to the parent.
-    auto error_pipe_result = create_pipe();
-    if (!error_pipe_result) {
-      return error_pipe_result.error();
+  if (spec.opts.new_process_group) {
+    if (::setpgid(0, 0) == -1) {
+      report_child_failure(plan);
     }
-    auto [error_read, error_write] = std::move(error_pipe_result.value());
-    int error_read_fd = error_read.release();
-    int error_write_fd = error_write.release();
-    opened_fds.push_back(error_read_fd);
-    opened_fds.push_back(error_write_fd);
+  } else if (spec.process_group) {
+    if (::setpgid(0, *spec.process_group) == -1) {
+      report_child_failure(plan);
+    }
+  }
 
-    std::vector<std::string> argv_copy = spec.argv;
-    std::vector<char*> argv_c;
-    argv_c.reserve(argv_copy.size() + 1);
-    for (auto& arg : argv_copy) {
-      argv_c.push_back(arg.data());
+  if (spec.cwd_fd) {
+    if (::fchdir(*spec.cwd_fd) == -1) {
+      report_child_failure(plan);
     }
-    argv_c.push_back(nullptr);
+  } else if (spec.cwd) {
+    if (::chdir(spec.cwd->c_str()) == -1) {
+      report_child_failure(plan);
+    }
+  }
 
-    std::vector<std::string> envp_copy = spec.envp;
-    std::vector<char*> envp_c;
-    envp_c.reserve(envp_copy.size() + 1);
-    for (auto& entry : envp_copy) {
-      envp_c.push_back(entry.data());
+  if (plan.stdin_fd != STDIN_FILENO) {
+    if (::dup2(plan.stdin_fd, STDIN_FILENO) == -1) {
+      report_child_failure(plan);
     }
-    envp_c.push_back(nullptr);
+  }
+  if (plan.stdout_fd != STDOUT_FILENO) {
+    if (::dup2(plan.stdout_fd, STDOUT_FILENO) == -1) {
+      report_child_failure(plan);
+    }
+  }
+  if (plan.stderr_fd != STDERR_FILENO) {
+    if (::dup2(plan.stderr_fd, STDERR_FILENO) == -1) {
+      report_child_failure(plan);
+    }
+  }
 
-    std::string exec_path = resolve_exec_path(argv_copy.front(), envp_copy, spec.cwd);
+  // Close all inherited descriptors after dup2 so descriptors opened by other threads between
+  // pre-fork bookkeeping and fork() do not leak into the exec'ed process.
+  if (!spec.opts.trust_cloexec) {
+    close_inherited_fds(STDERR_FILENO + 1, plan.error_write_fd, spec.exec_fd.value_or(-1));
+  }
 
-    pid_t pid = ::fork();
-    if (pid == -1) {
-      for (int fd : opened_fds) {
-        ::close(fd);
-      }
-      return make_errno_error("fork");
+#if PROCLY_PLATFORM_LINUX
+  if (spec.exec_fd) {
+    // The descriptor is O_CLOEXEC; the kernel opens the binary before closing it.
+    ::syscall(SYS_execveat, *spec.exec_fd, "", plan.argv, spec.envp.data(), AT_EMPTY_PATH);
+    report_child_failure(plan);
+  }
+#endif
+  ::execve(plan.exec_path, plan.argv, spec.envp.data());
+  report_child_failure(plan);
+}
+
+#if PROCLY_PLATFORM_LINUX
+// Untouched pages are never faulted in, so a generous size costs nothing.
+constexpr std::size_t kVforkStackSize = std::size_t{256} * 1024;
+
+int vfork_child_entry(void* arg) {
+  const auto& plan = *static_cast<const ChildExecPlan*>(arg);
+  // The child runs on the parent's memory: parent handlers must not run here, so reset them
+  // before unblocking the signals the parent blocked around clone().
+  for (int signo = 1; signo < NSIG; ++signo) {
+    struct sigaction action {};
+    if (::sigaction(signo, nullptr, &action) != 0) {
+      continue;
+    }
+    if (action.sa_handler == SIG_IGN || action.sa_handler == SIG_DFL) {
+      continue;
     }
+    action.sa_handler = SIG_DFL;
+    action.sa_flags = 0;
+    ::sigaction(signo, &action, nullptr);
+  }
+  ::pthread_sigmask(SIG_SETMASK, plan.restore_mask, nullptr);
+  exec_child(plan);
+}
 
-    if (pid == 0) {
-      if (error_read_fd >= 0) {
-        ::close(error_read_fd);
-      }
+// clone(CLONE_VM | CLONE_VFORK) on a private stack: no page-table copy, and the parent thread
+// is suspended until the child execs or exits. Returns -1 with errno set on failure.
+pid_t clone_vfork_child(ChildExecPlan& plan) {
+  void* stack = ::mmap(nullptr, kVforkStackSize, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+  if (stack == MAP_FAILED) {
+    return -1;
+  }
+  sigset_t all_signals;
+  sigset_t previous_mask;
+  ::sigfillset(&all_signals);
+  ::pthread_sigmask(SIG_BLOCK, &all_signals, &previous_mask);
+  plan.restore_mask = &previous_mask;
+
+  void* stack_top = static_cast<char*>(stack) + kVforkStackSize;
+  pid_t pid = ::clone(vfork_child_entry, stack_top, CLONE_VM | CLONE_VFORK | SIGCHLD, &plan);
+  int clone_errno = errno;
+
+  ::pthread_sigmask(SIG_SETMASK, &previous_mask, nullptr);
+  plan.restore_mask = nullptr;
+  ::munmap(stack, kVforkStackSize);
+  errno = clone_errno;
+  return pid;
+}
 
-      if (spec.opts.new_process_group) {
-        if (::setpgid(0, 0) == -1) {
-          int err = errno;
-          ::write(error_write_fd, &err, sizeof(err));
-          _exit(kExecFailureExitCode);
+// Leading fields of struct clone_args from <linux/sched.h>, up to cgroup (CLONE_ARGS_SIZE_VER2).
+struct CloneArgs {
+  std::uint64_t flags;
+  std::uint64_t pidfd;
+  std::uint64_t child_tid;
+  std::uint64_t parent_tid;
+  std::uint64_t exit_signal;
+  std::uint64_t stack;
+  std::uint64_t stack_size;
+  std::uint64_t tls;
+  std::uint64_t set_tid;
+  std::uint64_t set_tid_size;
+  std::uint64_t cgroup;
+};
+
+constexpr std::uint64_t kCloneIntoCgroup = 0x200000000ULL;
+
+// fork() whose child starts inside the cgroup behind plan.cgroup_fd, so it never runs outside
+// it. Kernels without clone3 or CLONE_INTO_CGROUP (before 5.7) fall back to fork() with the
+// child writing itself into cgroup.procs before exec.
+pid_t fork_into_cgroup(ChildExecPlan& plan) {
+#if defined(SYS_clone3)
+  CloneArgs args{};
+  args.flags = kCloneIntoCgroup;
+  args.exit_signal = SIGCHLD;
+  args.cgroup = static_cast<std::uint64_t>(plan.cgroup_fd);
+  auto pid = static_cast<pid_t>(::syscall(SYS_clone3, &args, sizeof(args)));
+  if (pid != -1 || (errno != ENOSYS && errno != E2BIG && errno != EINVAL)) {
+    return pid;
+  }
+#endif
+  plan.join_cgroup = true;
+  return ::fork();
+}
+#endif
+
+// Create the child with fork(), clone(CLONE_VM | CLONE_VFORK) or clone3, then exec.
+Result<Spawned> spawn_fork_exec(const SpawnSpec& spec, SpawnStrategy strategy) {
+  std::vector<int> opened_fds;
+  std::optional<int> parent_stdin;
+  std::optional<int> parent_stdout;
+  std::optional<int> parent_stderr;
+
+  int child_stdin = STDIN_FILENO;
+  int child_stdout = STDOUT_FILENO;
+  int child_stderr = STDERR_FILENO;
+
+  auto open_for_spec = [&](const StdioSpec& spec, bool read_only, bool is_stdout,
+                           std::optional<int>& parent_fd) -> Result<int> {
+    switch (spec.kind) {
+      case StdioSpec::Kind::inherit:
+        if (read_only) {
+          return STDIN_FILENO;
         }
-      } else if (spec.process_group) {
-        if (::setpgid(0, *spec.process_group) == -1) {
-          int err = errno;
-          ::write(error_write_fd, &err, sizeof(err));
-          _exit(kExecFailureExitCode);
+        if (is_stdout) {
+          return STDOUT_FILENO;
         }
-      }
-
-      if (spec.cwd) {
-        if (::chdir(spec.cwd->c_str()) == -1) {
-          int err = errno;
-          ::write(error_write_fd, &err, sizeof(err));
-          _exit(kExecFailureExitCode);
+        return STDERR_FILENO;
+      case StdioSpec::Kind::null: {
+        auto fd = open_null(read_only);
+        if (!fd) {
+          return fd.error();
         }
+        opened_fds.push_back(fd.value());
+        return fd.value();
       }
-
-      if (child_stdin != STDIN_FILENO) {
-        if (::dup2(child_stdin, STDIN_FILENO) == -1) {
-          int err = errno;
-          ::write(error_write_fd, &err, sizeof(err));
-          _exit(kExecFailureExitCode);
+      case StdioSpec::Kind::file: {
+        auto fd = open_file(spec.path, spec.mode, spec.perms);
+        if (!fd) {
+          return fd.error();
         }
+        opened_fds.push_back(fd.value());
+        return fd.value();
       }
-      if (child_stdout != STDOUT_FILENO) {
-        if (::dup2(child_stdout, STDOUT_FILENO) == -1) {
-          int err = errno;
-          ::write(error_write_fd, &err, sizeof(err));
-          _exit(kExecFailureExitCode);
+      case StdioSpec::Kind::fd:
+        return spec.fd;
+      case StdioSpec::Kind::piped: {
+        auto pipe_result = create_pipe(spec.pipe_capacity);
+        if (!pipe_result) {
+          return pipe_result.error();
         }
-      }
-      if (child_stderr != STDERR_FILENO) {
-        if (::dup2(child_stderr, STDERR_FILENO) == -1) {
-          int err = errno;
-          ::write(error_write_fd, &err, sizeof(err));
-          _exit(kExecFailureExitCode);
+        auto [read_end, write_end] = std::move(pipe_result.value());
+        int read_fd = read_end.release();
+        int write_fd = write_end.release();
+        opened_fds.push_back(read_fd);
+        opened_fds.push_back(write_fd);
+        if (read_only) {
+          parent_fd = write_fd;
+          return read_fd;
         }
+        parent_fd = read_fd;
+        return write_fd;
       }
+      case StdioSpec::Kind::dup_stdout:
+        return STDOUT_FILENO;
+    }
+    return Error{.code = make_error_code(errc::invalid_stdio), .context = "stdio"};
+  };
 
-      close_inherited_fds_after_fork(error_write_fd);
+  auto stdout_fd = open_for_spec(spec.stdout_spec, false, true, parent_stdout);
+  if (!stdout_fd) {
+    return stdout_fd.error();
+  }
+  child_stdout = stdout_fd.value();
 
-      ::execve(exec_path.c_str(), argv_c.data(), envp_c.data());
+  auto stdin_fd = open_for_spec(spec.stdin_spec, true, false, parent_stdin);
+  if (!stdin_fd) {
+    return stdin_fd.error();
+  }
+  child_stdin = stdin_fd.value();
 
-      int err = errno;
-      ::write(error_write_fd, &err, sizeof(err));
-      _exit(kExecFailureExitCode);
+  if (spec.stderr_spec.kind == StdioSpec::Kind::dup_stdout) {
+    child_stderr = child_stdout;
+  } else {
+    auto stderr_fd = open_for_spec(spec.stderr_spec, false, false, parent_stderr);
+    if (!stderr_fd) {
+      return stderr_fd.error();
     }
+    child_stderr = stderr_fd.value();
+  }
+
+  ArgvPointers argv_c(spec.argv);
+
+  // Resolve argv[0] before fork so the child only needs async-signal-safe syscalls.
+  std::string resolved_path;
+  if (!spec.exec_path) {
+    auto cached = cached_exec_path(spec.argv.front(), spec.envp, spec.cwd,
+                                   spec.opts.path_lookup, spec.cwd_fd);
+    resolved_path = cached ? std::move(*cached)
+                           : resolve_exec_path(spec.argv.front(), spec.envp, spec.cwd,
+                                               spec.cwd_fd);
+  }
+  const std::string& exec_path = spec.exec_path ? *spec.exec_path : resolved_path;
+
+#if PROCLY_PLATFORM_LINUX
+  cpu_set_t affinity;
+  if (!spec.opts.cpu_affinity.empty()) {
+    auto filled = fill_cpu_set(spec.opts.cpu_affinity, &affinity);
+    if (!filled) {
+      for (int fd : opened_fds) {
+        ::close(fd);
+      }
+      return filled.error();
+    }
+  }
+  // Without an explicit cpu_affinity, numa_nodes also pins the child to the nodes' CPUs.
+  NumaMask numa_mask{};
+  const bool numa_affinity = !spec.opts.numa_nodes.empty() && spec.opts.cpu_affinity.empty();
+  if (!spec.opts.numa_nodes.empty()) {
+    auto filled = fill_numa_mask(spec.opts, &numa_mask, numa_affinity ? &affinity : nullptr);
+    if (!filled) {
+      for (int fd : opened_fds) {
+        ::close(fd);
+      }
+      return filled.error();
+    }
+  }
 
+  unique_fd cgroup_dir;
+  if (spec.opts.cgroup) {
+    cgroup_dir.reset(::open(spec.opts.cgroup->c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC));
+    if (!cgroup_dir) {
+      Error error = make_errno_error("open(cgroup)");
+      for (int fd : opened_fds) {
+        ::close(fd);
+      }
+      return error;
+    }
+  }
+  // Placing the child in a cgroup takes clone3, which replaces the vfork strategy.
+  const bool use_cgroup = static_cast<bool>(cgroup_dir);
+  const bool use_vfork = !use_cgroup && strategy == SpawnStrategy::vfork_exec;
+#else
+  (void)strategy;
+  const bool use_cgroup = false;
+  const bool use_vfork = false;
+#endif
+
+  // A forked child reports setup/exec failures through a CLOEXEC pipe the parent reads until
+  // exec closes it. A vfork child writes the errno into the memory it shares with the parent,
+  // which saves the pipe, its closes and the blocking read on every spawn.
+  int error_read_fd = -1;
+  int error_write_fd = -1;
+  int child_errno = 0;
+  if (!use_vfork) {
+    auto error_pipe_result = create_pipe();
+    if (!error_pipe_result) {
+      for (int fd : opened_fds) {
+        ::close(fd);
+      }
+      return error_pipe_result.error();
+    }
+    auto [error_read, error_write] = std::move(error_pipe_result.value());
+    error_read_fd = error_read.release();
+    error_write_fd = error_write.release();
+  }
+
+  ChildExecPlan plan{
+      .spec = &spec,
+      .exec_path = exec_path.c_str(),
+      .argv = argv_c.data(),
+      .stdin_fd = child_stdin,
+      .stdout_fd = child_stdout,
+      .stderr_fd = child_stderr,
+      .error_read_fd = error_read_fd,
+      .error_write_fd = error_write_fd,
+      .shared_errno = use_vfork ? &child_errno : nullptr,
+  };
+
+#if PROCLY_PLATFORM_LINUX
+  plan.cgroup_fd = cgroup_dir.get();
+  if (!spec.opts.cpu_affinity.empty() || (numa_affinity && CPU_COUNT(&affinity) > 0)) {
+    plan.affinity = &affinity;
+  }
+  if (!spec.opts.numa_nodes.empty()) {
+    plan.numa_mask = &numa_mask;
+  }
+  pid_t pid = -1;
+  if (use_cgroup) {
+    pid = fork_into_cgroup(plan);
+  } else {
+    pid = use_vfork ? clone_vfork_child(plan) : ::fork();
+  }
+#else
+  pid_t pid = ::fork();
+#endif
+  if (pid == -1) {
+    const char* context = use_vfork ? "clone" : "fork";
+    if (use_cgroup) {
+      context = plan.join_cgroup ? "fork" : "clone3";
+    }
+    Error error = make_errno_error(context);
+    for (int fd : opened_fds) {
+      ::close(fd);
+    }
+    if (!use_vfork) {
+      ::close(error_read_fd);
+      ::close(error_write_fd);
+    }
+    return error;
+  }
+
+  if (pid == 0) {
+    exec_child(plan);
+  }
+
+  if (!use_vfork) {
     ::close(error_write_fd);
-    int child_errno = 0;
     ssize_t read_result = -1;
     while (read_result == -1) {
       read_result = ::read(error_read_fd, &child_errno, sizeof(child_errno));
@@ -727,50 +1118,77 @@ class PosixBackend final : public Backend {
     ::close(error_read_fd);
     if (read_result == -1) {
       for (int fd : opened_fds) {
-        if (fd == error_read_fd || fd == error_write_fd) {
-          continue;
-        }
         ::close(fd);
       }
       return make_errno_error("read");
     }
-    if (read_result > 0) {
-      reap_child_after_exec_failure(pid);
-      for (int fd : opened_fds) {
-        if (fd == error_read_fd || fd == error_write_fd) {
-          continue;
-        }
-        ::close(fd);
-      }
-      return Error{.code = std::error_code(child_errno, std::system_category()),
-                   .context = "spawn"};
+    if (read_result == 0) {
+      child_errno = 0;
     }
+  }
+  if (child_errno != 0) {
+    reap_child_after_exec_failure(pid);
+    for (int fd : opened_fds) {
+      ::close(fd);
+    }
+    return Error{.code = std::error_code(child_errno, std::system_category()),
+                 .context = "spawn"};
+  }
+
+  Spawned spawned;
+  spawned.pid = pid;
+  spawned.new_process_group = spec.opts.new_process_group || spec.process_group.has_value();
+  if (spec.opts.new_process_group) {
+    spawned.pgid = pid;
+  } else if (spec.process_group) {
+    spawned.pgid = spec.process_group;
+  }
+
+  spawned.stdin_fd = parent_stdin;
+  spawned.stdout_fd = parent_stdout;
+  spawned.stderr_fd = parent_stderr;
 
-    Spawned spawned;
-    spawned.pid = pid;
-    spawned.new_process_group = spec.opts.new_process_group || spec.process_group.has_value();
-    if (spec.opts.new_process_group) {
-      spawned.pgid = pid;
-    } else if (spec.process_group) {
-      spawned.pgid = spec.process_group;
+  for (int fd : opened_fds) {
+    bool keep = (parent_stdin && fd == *parent_stdin) ||
+                (parent_stdout && fd == *parent_stdout) ||
+                (parent_stderr && fd == *parent_stderr);
+    if (!keep) {
+      ::close(fd);
     }
+  }
 
-    spawned.stdin_fd = parent_stdin;
-    spawned.stdout_fd = parent_stdout;
-    spawned.stderr_fd = parent_stderr;
+  return spawned;
+}
 
-    for (int fd : opened_fds) {
-      if (fd == error_read_fd || fd == error_write_fd) {
-        continue;
-      }
-      bool keep = (parent_stdin && fd == *parent_stdin) ||
-                  (parent_stdout && fd == *parent_stdout) ||
-                  (parent_stderr && fd == *parent_stderr);
-      if (!keep) {
-        ::close(fd);
-      }
+class PosixBackend final : public Backend {
+ public:
+  Result<Spawned> spawn(const SpawnSpec& spec) override {
+    if (spec.argv.empty()) {
+      return Error{.code = make_error_code(errc::empty_argv), .context = "argv"};
     }
 
+    const auto started = std::chrono::steady_clock::now();
+    SpawnFallbackReason reason = SpawnFallbackReason::none;
+    const SpawnStrategy strategy = select_spawn_strategy(spec, &reason);
+    auto spawned = strategy == SpawnStrategy::posix_spawn ? spawn_posix_spawnp(spec)
+                                                          : spawn_fork_exec(spec, strategy);
+    if (spawned) {
+      spawned->started = started;
+      if (auto reaper = active_reaper()) {
+        reaper->adopt(spawned->pid, started);
+      }
+    }
+    if (auto* observer = current_observer()) {
+      observer->on_spawn(SpawnEvent{
+          .program = spec.argv.front(),
+          .strategy = strategy,
+          .fallback_reason = reason,
+          .start = started,
+          .end = std::chrono::steady_clock::now(),
+          .pid = spawned ? spawned->pid : -1,
+          .error = spawned ? std::error_code() : spawned.error().code,
+      });
+    }
     return spawned;
   }
 
@@ -780,16 +1198,69 @@ class PosixBackend final : public Backend {
       return *spawned.terminal_result;
     }
 
+    struct rusage usage {};
     WaitOps ops;
     ops.try_wait = [&]() { return try_wait(spawned); };
-    ops.wait_blocking = [&]() { return wait_pid_blocking(spawned.pid); };
+    ops.wait_blocking = [&]() { return wait_pid_blocking(spawned.pid, &usage); };
     ops.terminate = [&]() { return terminate(spawned); };
     ops.kill = [&]() { return kill(spawned); };
+    std::optional<ExitWatcher> watcher;
+    if (auto reaper = reaper_for(spawned)) {
+      // The reaper thread reaps; this wait only sleeps until it publishes the result.
+      ops.wait_blocking = [&, reaper]() -> Result<ExitStatus> {
+        while (true) {
+          auto status = try_wait(spawned);
+          if (!status) {
+            return status.error();
+          }
+          if (status.value()) {
+            return *status.value();
+          }
+          // A stopped reaper reaps nothing in the background any more; poll instead.
+          if (reaper->stopped()) {
+            std::this_thread::sleep_for(kReaperPollInterval);
+          } else {
+            reaper->wait_exit(spawned.pid, std::nullopt);
+          }
+        }
+      };
+      ops.wait_exit = [&, reaper](std::chrono::milliseconds budget) -> Result<void> {
+        if (reaper->stopped()) {
+          std::this_thread::sleep_for(std::min(budget, kReaperPollInterval));
+        } else {
+          reaper->wait_exit(spawned.pid, std::chrono::steady_clock::now() + budget);
+        }
+        return {};
+      };
+    } else if (timeout && spawned.pid > 0) {
+      watcher.emplace(spawned.pid);
+      if (watcher->active()) {
+        ops.wait_exit = [&](std::chrono::milliseconds budget) { return watcher->wait_for(budget); };
+      }
+    }
+    auto* observer = current_observer();
+    const int pid = spawned.pid;
+    std::chrono::steady_clock::time_point wait_start;
+    if (observer != nullptr) {
+      wait_start = std::chrono::steady_clock::now();
+    }
     auto wait_result = wait_with_timeout(ops, default_clock(), timeout, kill_grace);
+    if (observer != nullptr) {
+      WaitEvent event{.pid = pid, .start = wait_start, .end = std::chrono::steady_clock::now()};
+      if (wait_result) {
+        event.timed_out = wait_result->timed_out;
+        event.sent_terminate = wait_result->sent_terminate;
+        event.sent_kill = wait_result->sent_kill;
+      }
+      observer->on_wait(event);
+    }
     if (!wait_result) {
       return wait_result.error();
     }
-    const WaitResult terminal = wait_result.value();
+    WaitResult terminal = wait_result.value();
+    // A reap through try_wait() already cached the usage; otherwise wait4 filled `usage`.
+    terminal.usage = spawned.terminal_result ? spawned.terminal_result->usage
+                                             : to_resource_usage(usage, spawned.started);
     cache_terminal_result(spawned, terminal);
     return terminal;
   }
@@ -801,14 +1272,27 @@ class PosixBackend final : public Backend {
     if (spawned.pid <= 0) {
       return Error{.code = make_error_code(errc::wait_failed), .context = "waitpid"};
     }
-    auto status = try_wait_pid(spawned.pid);
+    if (auto reaper = reaper_for(spawned)) {
+      auto reaped = reaper->try_wait(spawned.pid);
+      if (!reaped) {
+        return reaped.error();
+      }
+      if (!reaped.value()) {
+        return std::optional<ExitStatus>();
+      }
+      cache_terminal_result(spawned, *reaped.value());
+      return std::optional<ExitStatus>(reaped.value()->status);
+    }
+    struct rusage usage {};
+    auto status = try_wait_pid(spawned.pid, &usage);
     if (!status) {
       return status.error();
     }
     const std::optional<ExitStatus>& maybe_status = status.value();
     if (maybe_status.has_value()) {
       const ExitStatus terminal = *maybe_status;
-      cache_terminal_result(spawned, WaitResult{.status = terminal});
+      cache_terminal_result(spawned, WaitResult{.status = terminal,
+                                                .usage = to_resource_usage(usage, spawned.started)});
       return std::optional<ExitStatus>(terminal);
     }
     return std::optional<ExitStatus>();
@@ -819,6 +1303,32 @@ class PosixBackend final : public Backend {
   Result<void> kill(Spawned& spawned) override { return send_signal(spawned, SIGKILL); }
 
   Result<void> signal(Spawned& spawned, int signo) override { return send_signal(spawned, signo); }
+
+  void abandon(Spawned& spawned) override {
+    if (auto reaper = reaper_for(spawned)) {
+      reaper->abandon(spawned.pid);
+    }
+  }
+
+  Result<int> open_exit_handle(const Spawned& spawned) override {
+    if (spawned.pid > 0) {
+      auto fd = open_exit_fd(spawned.pid);
+      if (fd) {
+        return fd.value().release();
+      }
+      if (!is_esrch(fd.error())) {
+        return fd.error();
+      }
+    } else if (!spawned.terminal_result) {
+      return Error{.code = make_error_code(errc::wait_failed), .context = "open_exit_handle"};
+    }
+    // Already exited: hand out a pipe read end at EOF, which always polls readable.
+    auto pipe = create_pipe();
+    if (!pipe) {
+      return pipe.error();
+    }
+    return pipe.value().first.release();
+  }
 };
 
 }  // namespace
@@ -829,18 +1339,26 @@ thread_local Backend* g_backend_override = nullptr;
 
 }  // namespace
 
-ScopedBackendOverride::ScopedBackendOverride(Backend& backend) : previous_(g_backend_override) {
-  g_backend_override = &backend;
+}  // namespace procly::internal
+
+namespace procly {
+
+ScopedBackend::ScopedBackend(Backend& backend) : previous_(internal::g_backend_override) {
+  internal::g_backend_override = &backend;
 }
 
-ScopedBackendOverride::~ScopedBackendOverride() { g_backend_override = previous_; }
+ScopedBackend::~ScopedBackend() { internal::g_backend_override = previous_; }
 
 Backend& default_backend() {
-  if (auto* override_backend = g_backend_override) {
+  if (auto* override_backend = internal::g_backend_override) {
     return *override_backend;
   }
-  static PosixBackend backend;
+  return native_backend();
+}
+
+Backend& native_backend() {
+  static internal::PosixBackend backend;
   return backend;
 }
 
-}  // namespace procly::internal
+}  // namespace procly
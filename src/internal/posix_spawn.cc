@@ -1,7 +1,5 @@
 #include "procly/internal/posix_spawn.hpp"
 
-#include <spawn.h>
-
 namespace procly::internal {
 
 namespace {
@@ -13,8 +11,10 @@ constexpr bool kHasSpawnPgroup =
     false;
 #endif
 
-constexpr bool kHasSpawnChdir =
-#if PROCLY_PLATFORM_MACOS
+constexpr bool kHasSpawnChdir = PROCLY_HAS_SPAWN_CHDIR != 0;
+
+constexpr bool kHasCloneVfork =
+#if PROCLY_PLATFORM_LINUX
     true;
 #else
     false;
@@ -22,32 +22,79 @@ constexpr bool kHasSpawnChdir =
 
 }  // namespace
 
-bool can_use_posix_spawn(const SpawnSpec& spec) {
+SpawnStrategy fork_fallback_strategy(const SpawnSpec& spec) {
+  if (spec.opts.fork_strategy == ForkStrategy::vfork && kHasCloneVfork) {
+    return SpawnStrategy::vfork_exec;
+  }
+  return SpawnStrategy::fork_exec;
+}
+
+SpawnFallbackReason posix_spawn_blocker(const SpawnSpec& spec) {
   // POSIX_SPAWN_CLOEXEC_DEFAULT is optional; when missing we close FDs manually.
-  if (spec.cwd && !kHasSpawnChdir) {
-    return false;
+  if ((spec.cwd || spec.cwd_fd) && !kHasSpawnChdir) {
+    return SpawnFallbackReason::working_directory;
   }
   if ((spec.opts.new_process_group || spec.process_group) && !kHasSpawnPgroup) {
-    return false;
+    return SpawnFallbackReason::process_group;
+  }
+  // posix_spawn has no hook for setrlimit, nice, ioprio, mempolicy, affinity or cgroup placement.
+  if (!spec.opts.limits.empty()) {
+    return SpawnFallbackReason::resource_limits;
+  }
+  if (spec.opts.nice) {
+    return SpawnFallbackReason::nice;
+  }
+#if PROCLY_PLATFORM_LINUX
+  if (spec.opts.cgroup) {
+    return SpawnFallbackReason::cgroup;
+  }
+  if (!spec.opts.numa_nodes.empty()) {
+    return SpawnFallbackReason::numa;
+  }
+  // posix_spawn only takes a path.
+  if (spec.exec_fd) {
+    return SpawnFallbackReason::executable_fd;
+  }
+  if (spec.opts.io_priority) {
+    return SpawnFallbackReason::io_priority;
+  }
+  // The only way to hand posix_spawn a mask is to narrow the calling thread's, which would move
+  // the caller onto the child's CPUs; set it in the child instead.
+  if (!spec.opts.cpu_affinity.empty()) {
+    return SpawnFallbackReason::cpu_affinity;
   }
-  return true;
+  // posix_spawnattr_setschedpolicy rejects SCHED_BATCH and SCHED_IDLE.
+  if (spec.opts.scheduling_policy == SchedulingPolicy::batch ||
+      spec.opts.scheduling_policy == SchedulingPolicy::idle) {
+    return SpawnFallbackReason::scheduling_policy;
+  }
+#endif
+  return SpawnFallbackReason::none;
 }
 
-SpawnStrategy select_spawn_strategy(const SpawnSpec& spec) {
+bool can_use_posix_spawn(const SpawnSpec& spec) {
+  return posix_spawn_blocker(spec) == SpawnFallbackReason::none;
+}
+
+bool can_use_vfork() { return kHasCloneVfork; }
+
+SpawnStrategy select_spawn_strategy(const SpawnSpec& spec, SpawnFallbackReason* reason) {
+  SpawnFallbackReason blocker = SpawnFallbackReason::forced;
 #if defined(PROCLY_FORCE_FORK)
   (void)spec;
-  return SpawnStrategy::fork_exec;
-#elif defined(PROCLY_FORCE_POSIX_SPAWN)
-  if (can_use_posix_spawn(spec)) {
-    return SpawnStrategy::posix_spawn;
-  }
-  return SpawnStrategy::fork_exec;
+  SpawnStrategy strategy = SpawnStrategy::fork_exec;
+#elif defined(PROCLY_FORCE_VFORK)
+  (void)spec;
+  SpawnStrategy strategy = kHasCloneVfork ? SpawnStrategy::vfork_exec : SpawnStrategy::fork_exec;
 #else
-  if (can_use_posix_spawn(spec)) {
-    return SpawnStrategy::posix_spawn;
-  }
-  return SpawnStrategy::fork_exec;
+  blocker = posix_spawn_blocker(spec);
+  SpawnStrategy strategy = blocker == SpawnFallbackReason::none ? SpawnStrategy::posix_spawn
+                                                                : fork_fallback_strategy(spec);
 #endif
+  if (reason != nullptr) {
+    *reason = blocker;
+  }
+  return strategy;
 }
 
 }  // namespace procly::internal
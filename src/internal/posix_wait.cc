@@ -0,0 +1,127 @@
+#include "procly/internal/posix_wait.hpp"
+
+#include <sys/wait.h>
+
+#include "procly/platform.hpp"
+
+#if PROCLY_PLATFORM_LINUX
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#if PROCLY_PLATFORM_MACOS
+#include <sys/event.h>
+#endif
+
+#include <cerrno>
+#include <cstdint>
+#include <system_error>
+
+namespace procly::internal {
+
+namespace {
+
+Error make_errno_error(const char* context) {
+  return Error{.code = std::error_code(errno, std::system_category()), .context = context};
+}
+
+std::chrono::microseconds to_microseconds(const timeval& value) {
+  return std::chrono::seconds(value.tv_sec) + std::chrono::microseconds(value.tv_usec);
+}
+
+}  // namespace
+
+ExitStatus to_exit_status(int status) {
+  if (WIFEXITED(status)) {
+    return ExitStatus::exited(WEXITSTATUS(status), static_cast<std::uint32_t>(status));
+  }
+  return ExitStatus::other(static_cast<std::uint32_t>(status));
+}
+
+ResourceUsage to_resource_usage(const struct rusage& usage,
+                                std::optional<std::chrono::steady_clock::time_point> started) {
+#if PROCLY_PLATFORM_MACOS
+  constexpr std::uint64_t kMaxRssUnit = 1;  // bytes
+#else
+  constexpr std::uint64_t kMaxRssUnit = 1024;  // kilobytes
+#endif
+  ResourceUsage result;
+  result.user_time = to_microseconds(usage.ru_utime);
+  result.system_time = to_microseconds(usage.ru_stime);
+  if (started) {
+    result.wall_time = std::chrono::steady_clock::now() - *started;
+  }
+  result.max_rss_bytes = static_cast<std::uint64_t>(usage.ru_maxrss) * kMaxRssUnit;
+  result.minor_faults = static_cast<std::uint64_t>(usage.ru_minflt);
+  result.major_faults = static_cast<std::uint64_t>(usage.ru_majflt);
+  result.voluntary_context_switches = static_cast<std::uint64_t>(usage.ru_nvcsw);
+  result.involuntary_context_switches = static_cast<std::uint64_t>(usage.ru_nivcsw);
+  return result;
+}
+
+Result<ExitStatus> wait_pid_blocking(pid_t pid, struct rusage* usage) {
+  int status = 0;
+  while (true) {
+    pid_t rv = ::wait4(pid, &status, 0, usage);
+    if (rv == pid) {
+      return to_exit_status(status);
+    }
+    if (errno == EINTR) {
+      continue;
+    }
+    return make_errno_error("wait4");
+  }
+}
+
+Result<std::optional<ExitStatus>> try_wait_pid(pid_t pid, struct rusage* usage) {
+  int status = 0;
+  while (true) {
+    pid_t rv = ::wait4(pid, &status, WNOHANG, usage);
+    if (rv == pid) {
+      return std::optional<ExitStatus>(to_exit_status(status));
+    }
+    if (rv == 0) {
+      return std::optional<ExitStatus>();
+    }
+    if (errno == EINTR) {
+      continue;
+    }
+    return make_errno_error("wait4");
+  }
+}
+
+Result<unique_fd> open_exit_fd(pid_t pid) {
+#if PROCLY_PLATFORM_LINUX && defined(SYS_pidfd_open)
+  // pidfd_open sets O_CLOEXEC on the descriptor it returns.
+  unique_fd fd(static_cast<int>(::syscall(SYS_pidfd_open, pid, 0)));
+  if (!fd) {
+    return make_errno_error("pidfd_open");
+  }
+  return fd;
+#elif PROCLY_PLATFORM_MACOS
+  unique_fd kq(::kqueue());
+  if (!kq) {
+    return make_errno_error("kqueue");
+  }
+  auto cloexec = set_cloexec(kq.get());
+  if (!cloexec) {
+    return cloexec.error();
+  }
+  struct kevent change {};
+  EV_SET(&change, pid, EVFILT_PROC, EV_ADD | EV_ONESHOT, NOTE_EXIT, 0, nullptr);
+  if (::kevent(kq.get(), &change, 1, nullptr, 0, nullptr) == -1) {
+    return make_errno_error("kevent");
+  }
+  return kq;
+#else
+  (void)pid;
+  return Error{.code = std::error_code(ENOSYS, std::system_category()),
+               .context = "open_exit_fd"};
+#endif
+}
+
+bool is_esrch(const Error& error) {
+  return error.code.category() == std::system_category() && error.code.value() == ESRCH;
+}
+
+}  // namespace procly::internal
@@ -0,0 +1,109 @@
+#include "procly/internal/proc_sample.hpp"
+
+#include "procly/platform.hpp"
+
+#if PROCLY_PLATFORM_LINUX
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <array>
+#include <cerrno>
+#include <charconv>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+namespace procly::internal {
+
+#if PROCLY_PLATFORM_LINUX
+
+namespace {
+
+// Positions after the ")" closing comm: field 3 (state) is index 0.
+constexpr std::size_t kUserTimeIndex = 11;
+constexpr std::size_t kSystemTimeIndex = 12;
+constexpr std::size_t kThreadsIndex = 17;
+constexpr std::size_t kRssIndex = 21;
+
+Error parse_error() {
+  return Error{.code = std::make_error_code(std::errc::protocol_error),
+               .context = "read(/proc/<pid>/stat)"};
+}
+
+std::chrono::microseconds ticks_to_duration(std::uint64_t ticks) {
+  static const auto kTicksPerSecond = static_cast<std::uint64_t>(::sysconf(_SC_CLK_TCK));
+  constexpr std::uint64_t kMicrosPerSecond = 1000000;
+  return std::chrono::microseconds(ticks * kMicrosPerSecond / kTicksPerSecond);
+}
+
+}  // namespace
+
+Result<unique_fd> open_proc_stat(int pid) {
+  std::string path = "/proc/" + std::to_string(pid) + "/stat";
+  unique_fd fd(::open(path.c_str(), O_RDONLY | O_CLOEXEC));
+  if (!fd) {
+    return Error{.code = std::error_code(errno, std::system_category()),
+                 .context = "open(/proc/<pid>/stat)"};
+  }
+  return fd;
+}
+
+Result<ResourceSample> read_proc_stat(int fd) {
+  // comm is at most 16 bytes; the whole line stays well below this.
+  constexpr std::size_t kStatSize = 1024;
+  std::array<char, kStatSize> buffer{};
+  ssize_t count = -1;
+  do {
+    count = ::pread(fd, buffer.data(), buffer.size(), 0);
+  } while (count == -1 && errno == EINTR);
+  if (count == -1) {
+    return Error{.code = std::error_code(errno, std::system_category()),
+                 .context = "read(/proc/<pid>/stat)"};
+  }
+  std::string_view line(buffer.data(), static_cast<std::size_t>(count));
+  auto comm_end = line.rfind(')');
+  if (comm_end == std::string_view::npos) {
+    return parse_error();
+  }
+  line.remove_prefix(comm_end + 1);
+
+  std::array<std::uint64_t, kRssIndex + 1> fields{};
+  std::size_t index = 0;
+  while (index < fields.size()) {
+    auto start = line.find_first_not_of(' ');
+    if (start == std::string_view::npos) {
+      return parse_error();
+    }
+    line.remove_prefix(start);
+    auto end = line.find(' ');
+    std::string_view token = line.substr(0, end);
+    // Non-numeric fields (the state letter) stay 0.
+    std::from_chars(token.data(), token.data() + token.size(), fields[index]);
+    ++index;
+    line.remove_prefix(token.size());
+  }
+
+  static const auto kPageSize = static_cast<std::uint64_t>(::sysconf(_SC_PAGESIZE));
+  return ResourceSample{.user_time = ticks_to_duration(fields[kUserTimeIndex]),
+                        .system_time = ticks_to_duration(fields[kSystemTimeIndex]),
+                        .rss_bytes = fields[kRssIndex] * kPageSize,
+                        .threads = static_cast<std::uint32_t>(fields[kThreadsIndex])};
+}
+
+#else
+
+Result<unique_fd> open_proc_stat(int pid) {
+  (void)pid;
+  return Error{.code = std::make_error_code(std::errc::not_supported), .context = "sample"};
+}
+
+Result<ResourceSample> read_proc_stat(int fd) {
+  (void)fd;
+  return Error{.code = std::make_error_code(std::errc::not_supported), .context = "sample"};
+}
+
+#endif
+
+}  // namespace procly::internal
@@ -0,0 +1,82 @@
+#include "procly/internal/spill_writer.hpp"
+
+#include <unistd.h>
+
+#include <cerrno>
+#include <utility>
+
+#include "procly/internal/command_run.hpp"
+
+namespace procly::internal {
+
+SpillWriter::SpillWriter(std::size_t memory_limit, const char* name)
+    : memory_limit_(memory_limit), name_(name) {}
+
+void SpillWriter::write(const char* data, std::size_t size) {
+  if (error_) {
+    return;
+  }
+  buffer_.append(data, size);
+  if (!spilled_ && buffer_.size() > memory_limit_) {
+    spill();
+  }
+  if (spilled_ && buffer_.size() >= kSpillWriteBytes) {
+    flush();
+  }
+}
+
+void SpillWriter::spill() {
+  auto file = create_temp_file(name_);
+  if (!file) {
+    error_ = file.error();
+    buffer_.clear();
+    return;
+  }
+  file_ = std::move(file.value());
+  spilled_ = true;
+  // The in-memory prefix goes out with the next flush, ahead of everything after it.
+  buffer_.reserve(kSpillWriteBytes + kSpillWriteBytes / 4);
+}
+
+void SpillWriter::flush() {
+  const char* data = buffer_.data();
+  std::size_t left = buffer_.size();
+  while (left > 0) {
+    ssize_t written = ::write(file_.get(), data, left);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      error_ = Error{.code = std::error_code(errno, std::system_category()),
+                     .context = "write spill file"};
+      break;
+    }
+    data += written;
+    left -= static_cast<std::size_t>(written);
+  }
+  buffer_.clear();
+}
+
+Result<SpillBuffer> SpillWriter::finish() {
+  SpillBuffer result;
+  if (!error_ && !spilled_) {
+    result.memory_ = std::move(buffer_);
+    return result;
+  }
+  if (!error_) {
+    flush();
+  }
+  if (error_) {
+    return *error_;
+  }
+  auto mapped = MappedBuffer::map(file_.get());
+  if (!mapped) {
+    return mapped.error();
+  }
+  result.mapped_ = std::move(mapped.value());
+  result.spilled_ = true;
+  file_.reset(-1);
+  return result;
+}
+
+}  // namespace procly::internal
@@ -1,6 +1,8 @@
 #include "procly/internal/wait_policy.hpp"
 
+#include <algorithm>
 #include <cerrno>
+#include <cstdint>
 
 namespace procly::internal {
 
@@ -26,13 +28,41 @@ Result<ExitStatus> reconcile_after_missed_signal(WaitOps& ops, const Error& erro
   return ops.wait_blocking();
 }
 
+bool is_cancelled(const std::function<bool()>& cancelled) { return cancelled && cancelled(); }
+
+// Wait for the child to exit until `deadline`. Returns nullopt when the deadline passes or the
+// wait is cancelled first.
+Result<std::optional<ExitStatus>> wait_until(WaitOps& ops, Clock& clock,
+                                             std::chrono::steady_clock::time_point deadline) {
+  constexpr auto kSleepStep = std::chrono::milliseconds(1);
+  while (true) {
+    auto wait_result = ops.try_wait();
+    if (!wait_result || wait_result.value().has_value()) {
+      return wait_result;
+    }
+    auto now = clock.now();
+    if (now >= deadline || is_cancelled(ops.cancelled)) {
+      return std::optional<ExitStatus>();
+    }
+    if (!ops.wait_exit) {
+      clock.sleep_for(kSleepStep);
+      continue;
+    }
+    auto budget = std::chrono::ceil<std::chrono::milliseconds>(deadline - now);
+    auto exit_result = ops.wait_exit(budget);
+    if (!exit_result) {
+      return exit_result.error();
+    }
+  }
+}
+
 }  // namespace
 
 Result<WaitResult> wait_with_timeout(WaitOps& ops, Clock& clock,
                                      std::optional<std::chrono::milliseconds> timeout,
                                      std::chrono::milliseconds kill_grace) {
   WaitResult result;
-  if (!timeout) {
+  if (!timeout && !ops.cancelled) {
     auto status = ops.wait_blocking();
     if (!status) {
       return status.error();
@@ -41,22 +71,21 @@ Result<WaitResult> wait_with_timeout(WaitOps& ops, Clock& clock,
     return result;
   }
 
-  constexpr auto kSleepStep = std::chrono::milliseconds(1);
-  auto deadline = clock.now() + *timeout;
-  while (clock.now() < deadline) {
-    auto wait_result = ops.try_wait();
-    if (!wait_result) {
-      return wait_result.error();
-    }
-    auto& status_opt = wait_result.value();
-    if (status_opt.has_value()) {
-      result.status = *status_opt;
-      return result;
-    }
-    clock.sleep_for(kSleepStep);
+  auto deadline = timeout ? clock.now() + *timeout : std::chrono::steady_clock::time_point::max();
+  auto timeout_status = wait_until(ops, clock, deadline);
+  if (!timeout_status) {
+    return timeout_status.error();
+  }
+  if (timeout_status.value().has_value()) {
+    result.status = *timeout_status.value();
+    return result;
   }
 
-  result.timed_out = true;
+  if (is_cancelled(ops.cancelled)) {
+    result.cancelled = true;
+  } else {
+    result.timed_out = true;
+  }
   auto term_result = ops.terminate();
   if (!term_result) {
     auto status = reconcile_after_missed_signal(ops, term_result.error());
@@ -68,18 +97,13 @@ Result<WaitResult> wait_with_timeout(WaitOps& ops, Clock& clock,
   }
   result.sent_terminate = true;
 
-  auto grace_deadline = clock.now() + kill_grace;
-  while (clock.now() < grace_deadline) {
-    auto wait_result = ops.try_wait();
-    if (!wait_result) {
-      return wait_result.error();
-    }
-    auto& status_opt = wait_result.value();
-    if (status_opt.has_value()) {
-      result.status = *status_opt;
-      return result;
-    }
-    clock.sleep_for(kSleepStep);
+  auto grace_status = wait_until(ops, clock, clock.now() + kill_grace);
+  if (!grace_status) {
+    return grace_status.error();
+  }
+  if (grace_status.value().has_value()) {
+    result.status = *grace_status.value();
+    return result;
   }
 
   auto kill_result = ops.kill();
@@ -101,4 +125,102 @@ Result<WaitResult> wait_with_timeout(WaitOps& ops, Clock& clock,
   return result;
 }
 
+Result<StageWaitResult> wait_stages(StageWaitOps& ops, Clock& clock,
+                                    std::optional<std::chrono::milliseconds> timeout,
+                                    std::chrono::milliseconds kill_grace, bool fail_fast) {
+  constexpr auto kSleepStep = std::chrono::milliseconds(1);
+  enum class Phase : std::uint8_t { running, grace, killed };
+
+  StageWaitResult result;
+  std::vector<std::optional<ExitStatus>> statuses(ops.stage_count);
+  std::size_t remaining = ops.stage_count;
+  Phase phase = Phase::running;
+  std::optional<std::chrono::steady_clock::time_point> deadline;
+  if (timeout) {
+    deadline = clock.now() + *timeout;
+  }
+
+  // Signals may race with stages exiting on their own; ESRCH just means nothing was left.
+  auto escalate = [&](const std::function<Result<void>()>& send) -> Result<void> {
+    auto sent = send();
+    if (!sent && !is_esrch_error(sent.error())) {
+      return sent.error();
+    }
+    return {};
+  };
+
+  while (true) {
+    for (std::size_t stage = 0; stage < statuses.size(); ++stage) {
+      if (statuses[stage]) {
+        continue;
+      }
+      auto status = ops.try_wait(stage);
+      if (!status) {
+        return status.error();
+      }
+      if (!status.value().has_value()) {
+        continue;
+      }
+      statuses[stage] = status.value();
+      --remaining;
+      if (fail_fast && !result.failed_stage && !statuses[stage]->success()) {
+        result.failed_stage = stage;
+      }
+    }
+    if (remaining == 0) {
+      break;
+    }
+
+    auto now = clock.now();
+    bool abort = result.failed_stage.has_value() && phase == Phase::running;
+    if (!abort && deadline && now >= deadline && phase == Phase::running) {
+      result.timed_out = true;
+      abort = true;
+    }
+    if (!abort && phase == Phase::running && is_cancelled(ops.cancelled)) {
+      result.cancelled = true;
+      abort = true;
+    }
+    if (abort) {
+      auto sent = escalate(ops.terminate);
+      if (!sent) {
+        return sent.error();
+      }
+      result.sent_terminate = true;
+      phase = Phase::grace;
+      deadline = now + kill_grace;
+      continue;
+    }
+    if (deadline && now >= deadline) {
+      auto sent = escalate(ops.kill);
+      if (!sent) {
+        return sent.error();
+      }
+      result.sent_kill = true;
+      phase = Phase::killed;
+      deadline.reset();
+      continue;
+    }
+
+    std::optional<std::chrono::milliseconds> budget;
+    if (deadline) {
+      budget = std::chrono::ceil<std::chrono::milliseconds>(*deadline - now);
+    }
+    if (!ops.wait_any_exit) {
+      clock.sleep_for(budget ? std::min(*budget, kSleepStep) : kSleepStep);
+      continue;
+    }
+    auto exit_result = ops.wait_any_exit(budget);
+    if (!exit_result) {
+      return exit_result.error();
+    }
+  }
+
+  result.stages.reserve(statuses.size());
+  for (auto& status : statuses) {
+    result.stages.push_back(*status);
+  }
+  return result;
+}
+
 }  // namespace procly::internal
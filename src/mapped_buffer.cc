@@ -0,0 +1,55 @@
+#include "procly/mapped_buffer.hpp"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <cerrno>
+#include <utility>
+
+namespace procly {
+
+namespace {
+
+Error make_errno_error(const char* context) {
+  return Error{.code = std::error_code(errno, std::system_category()), .context = context};
+}
+
+}  // namespace
+
+Result<MappedBuffer> MappedBuffer::map(int fd) {
+  struct stat info{};
+  if (::fstat(fd, &info) == -1) {
+    return make_errno_error("fstat");
+  }
+  if (info.st_size == 0) {
+    return MappedBuffer();
+  }
+  auto size = static_cast<std::size_t>(info.st_size);
+  void* data = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  if (data == MAP_FAILED) {
+    return make_errno_error("mmap");
+  }
+  return MappedBuffer(static_cast<const char*>(data), size);
+}
+
+MappedBuffer::MappedBuffer(MappedBuffer&& other) noexcept
+    : data_(std::exchange(other.data_, nullptr)), size_(std::exchange(other.size_, 0)) {}
+
+MappedBuffer& MappedBuffer::operator=(MappedBuffer&& other) noexcept {
+  if (this != &other) {
+    if (data_ != nullptr) {
+      ::munmap(const_cast<char*>(data_), size_);
+    }
+    data_ = std::exchange(other.data_, nullptr);
+    size_ = std::exchange(other.size_, 0);
+  }
+  return *this;
+}
+
+MappedBuffer::~MappedBuffer() {
+  if (data_ != nullptr) {
+    ::munmap(const_cast<char*>(data_), size_);
+  }
+}
+
+}  // namespace procly
@@ -0,0 +1,35 @@
+#include "procly/numa.hpp"
+
+#if PROCLY_PLATFORM_LINUX
+
+#include "procly/internal/numa.hpp"
+
+namespace procly {
+
+Result<std::vector<int>> numa_nodes() { return internal::online_numa_nodes(); }
+
+Result<void> spread_across_numa_nodes(Command* commands, std::size_t count, NumaPolicy policy) {
+  auto nodes = internal::online_numa_nodes();
+  if (!nodes) {
+    return nodes.error();
+  }
+  if (nodes->empty()) {
+    return Error{.code = std::make_error_code(std::errc::no_such_device),
+                 .context = "numa nodes"};
+  }
+  const std::vector<int>& online = nodes.value();
+  for (std::size_t index = 0; index < count; ++index) {
+    commands[index].numa_nodes({online[index % online.size()]}, policy);
+  }
+  return {};
+}
+
+#if PROCLY_HAS_STD_SPAN
+Result<void> spread_across_numa_nodes(std::span<Command> commands, NumaPolicy policy) {
+  return spread_across_numa_nodes(commands.data(), commands.size(), policy);
+}
+#endif
+
+}  // namespace procly
+
+#endif
@@ -0,0 +1,19 @@
+#include "procly/observer.hpp"
+
+#include "procly/internal/observe.hpp"
+
+namespace procly {
+
+namespace internal {
+
+std::atomic<Observer*> g_observer{nullptr};
+
+}  // namespace internal
+
+void set_observer(Observer* observer) noexcept {
+  internal::g_observer.store(observer, std::memory_order_release);
+}
+
+Observer* observer() noexcept { return internal::current_observer(); }
+
+}  // namespace procly
@@ -0,0 +1,183 @@
+#include "procly/output_sink.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <optional>
+#include <utility>
+
+#include "procly/internal/byte_scan.hpp"
+#include "procly/internal/compressor.hpp"
+
+#if PROCLY_PLATFORM_POSIX
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+
+#include "procly/internal/fd.hpp"
+#endif
+
+namespace procly {
+
+OutputSink OutputSink::chunks(ChunkCallback on_chunk) {
+  OutputSink sink;
+  sink.on_chunk_ = std::move(on_chunk);
+  return sink;
+}
+
+#if PROCLY_HAS_STD_SPAN
+OutputSink OutputSink::chunks(SpanCallback on_chunk) {
+  return chunks(ChunkCallback([on_chunk = std::move(on_chunk)](const std::byte* data,
+                                                               std::size_t size) {
+    on_chunk(std::span<const std::byte>(data, size));
+  }));
+}
+#endif
+
+OutputSink OutputSink::lines(LineCallback on_line, std::string delimiter) {
+  OutputSink sink;
+  sink.on_line_ = std::move(on_line);
+  sink.delimiter_ = delimiter.empty() ? std::string("\n") : std::move(delimiter);
+  return sink;
+}
+
+OutputSink OutputSink::capture(std::string& out) {
+  return chunks(ChunkCallback([&out](const std::byte* data, std::size_t size) {
+    out.append(reinterpret_cast<const char*>(data), size);
+  }));
+}
+
+#if PROCLY_PLATFORM_POSIX
+Result<OutputSink> OutputSink::file(const std::filesystem::path& path, bool append) {
+  int flags = O_WRONLY | O_CREAT | O_CLOEXEC | (append ? O_APPEND : O_TRUNC);
+  auto fd = std::make_shared<internal::unique_fd>(::open(path.c_str(), flags, 0644));
+  if (!*fd) {
+    return Error{.code = std::error_code(errno, std::system_category()), .context = "open"};
+  }
+  return chunks(ChunkCallback([fd](const std::byte* data, std::size_t size) {
+    while (size > 0 && *fd) {
+      ssize_t written = ::write(fd->get(), data, size);
+      if (written < 0) {
+        if (errno != EINTR) {
+          fd->reset(-1);
+        }
+        continue;
+      }
+      data += written;
+      size -= static_cast<std::size_t>(written);
+    }
+  }));
+}
+#endif
+
+OutputSink OutputSink::tee(std::vector<OutputSink> sinks) {
+  auto shared = std::make_shared<std::vector<OutputSink>>(std::move(sinks));
+  OutputSink sink = chunks(ChunkCallback([shared](const std::byte* data, std::size_t size) {
+    for (auto& target : *shared) {
+      target.write(reinterpret_cast<const char*>(data), size);
+    }
+  }));
+  sink.on_finish_ = [shared]() -> Result<void> {
+    std::optional<Error> first_error;
+    for (auto& target : *shared) {
+      auto finished = target.finish();
+      if (!finished && !first_error) {
+        first_error = finished.error();
+      }
+    }
+    if (first_error) {
+      return *first_error;
+    }
+    return {};
+  };
+  return sink;
+}
+
+OutputSink OutputSink::digest(DigestAlgorithm algorithm, std::string& out) {
+  auto state = std::make_shared<Digest>(algorithm);
+  OutputSink sink = chunks(ChunkCallback([state](const std::byte* data, std::size_t size) {
+    state->update(reinterpret_cast<const char*>(data), size);
+  }));
+  sink.on_finish_ = [state, &out]() -> Result<void> {
+    out = state->hex();
+    return {};
+  };
+  return sink;
+}
+
+Result<OutputSink> OutputSink::compress(Compression codec, CompressedBuffer& out, int level) {
+  auto compressor = internal::Compressor::create(codec, level);
+  if (!compressor) {
+    return compressor.error();
+  }
+  auto state = std::make_shared<internal::Compressor>(std::move(compressor.value()));
+  OutputSink sink = chunks(ChunkCallback([state](const std::byte* data, std::size_t size) {
+    state->write(reinterpret_cast<const char*>(data), size);
+  }));
+  sink.on_finish_ = [state, &out]() -> Result<void> {
+    auto finished = state->finish();
+    if (!finished) {
+      return finished.error();
+    }
+    out = std::move(finished.value());
+    return {};
+  };
+  return sink;
+}
+
+void OutputSink::write(const char* data, std::size_t size) {
+  if (size == 0) {
+    return;
+  }
+  if (on_chunk_) {
+    on_chunk_(reinterpret_cast<const std::byte*>(data), size);
+    return;
+  }
+  if (!on_line_) {
+    return;
+  }
+
+  std::string_view chunk(data, size);
+  if (!partial_.empty() && delimiter_.size() > 1) {
+    // A delimiter may start in the partial line and end in this chunk.
+    std::size_t keep = std::min(partial_.size(), delimiter_.size() - 1);
+    std::string window = partial_.substr(partial_.size() - keep);
+    window.append(chunk.substr(0, delimiter_.size() - 1));
+    std::size_t pos = window.find(delimiter_);
+    if (pos != std::string::npos && pos < keep) {
+      partial_.resize(partial_.size() - keep + pos);
+      on_line_(partial_);
+      partial_.clear();
+      chunk.remove_prefix(pos + delimiter_.size() - keep);
+    }
+  }
+
+  // Complete lines are delivered straight from the read buffer; only a line that started in an
+  // earlier chunk is stitched together in partial_.
+  std::size_t start = 0;
+  internal::for_each_match(chunk, delimiter_, [&](std::size_t pos) {
+    std::string_view line = chunk.substr(start, pos - start);
+    if (partial_.empty()) {
+      on_line_(line);
+    } else {
+      partial_.append(line);
+      on_line_(partial_);
+      partial_.clear();
+    }
+    start = pos + delimiter_.size();
+  });
+  partial_.append(chunk.substr(start));
+}
+
+Result<void> OutputSink::finish() {
+  if (on_line_ && !partial_.empty()) {
+    on_line_(partial_);
+    partial_.clear();
+  }
+  if (on_finish_) {
+    return on_finish_();
+  }
+  return {};
+}
+
+}  // namespace procly
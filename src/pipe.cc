@@ -1,13 +1,23 @@
 #include "procly/pipe.hpp"
 
+#include <fcntl.h>
+#include <poll.h>
 #include <pthread.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <array>
 #include <cerrno>
+#include <climits>
 #include <csignal>
 #include <cstring>
+#include <optional>
+#include <vector>
 
+#include "procly/internal/fd.hpp"
+#include "procly/internal/io_drain.hpp"
+#include "procly/reactor.hpp"
 #include "procly/result.hpp"
 
 namespace procly {
@@ -22,7 +32,9 @@ Error make_pthread_error(int error, const char* context) {
   return Error{.code = std::error_code(error, std::system_category()), .context = context};
 }
 
-Result<std::size_t> write_without_sigpipe(int fd, const void* data, std::size_t n) {
+// Run a write-like syscall with SIGPIPE blocked, consuming any SIGPIPE it raises.
+template <typename Op>
+Result<std::size_t> without_sigpipe(Op op, const char* context) {
   sigset_t sigpipe_set;
   sigemptyset(&sigpipe_set);
   sigaddset(&sigpipe_set, SIGPIPE);
@@ -45,7 +57,7 @@ Result<std::size_t> write_without_sigpipe(int fd, const void* data, std::size_t
   ssize_t rv = -1;
   int saved_errno = 0;
   while (true) {
-    rv = ::write(fd, data, n);
+    rv = op();
     if (rv >= 0) {
       break;
     }
@@ -92,7 +104,197 @@ Result<std::size_t> write_without_sigpipe(int fd, const void* data, std::size_t
     return make_pthread_error(restore_errno, "pthread_sigmask");
   }
   errno = saved_errno;
-  return make_errno_error("write");
+  return make_errno_error(context);
+}
+
+Result<std::size_t> write_without_sigpipe(int fd, const void* data, std::size_t n) {
+  return without_sigpipe([&] { return ::write(fd, data, n); }, "write");
+}
+
+constexpr std::size_t kTransferChunk = 64 * 1024;
+
+bool would_block(const Error& error) {
+  return error.code == std::errc::resource_unavailable_try_again ||
+         error.code == std::errc::operation_would_block;
+}
+
+// Block until a borrowed, possibly non-blocking descriptor is ready.
+Result<void> wait_for(int fd, short events) {
+  pollfd pfd{.fd = fd, .events = events, .revents = 0};
+  while (::poll(&pfd, 1, -1) == -1) {
+    if (errno != EINTR) {
+      return make_errno_error("poll");
+    }
+  }
+  return {};
+}
+
+Result<void> write_fully(int fd, const char* data, std::size_t n) {
+  while (n > 0) {
+    auto written = write_without_sigpipe(fd, data, n);
+    if (!written) {
+      if (!would_block(written.error())) {
+        return written.error();
+      }
+      auto ready = wait_for(fd, POLLOUT);
+      if (!ready) {
+        return ready.error();
+      }
+      continue;
+    }
+    data += written.value();
+    n -= written.value();
+  }
+  return {};
+}
+
+// Portable path: read up to limit bytes (all when empty) and write them to tee_fd and to.
+Result<std::size_t> copy_loop(int from, int to, int tee_fd, std::optional<std::size_t> limit) {
+  std::vector<char> buffer(kTransferChunk);
+  std::size_t total = 0;
+  while (!limit || total < *limit) {
+    std::size_t want = limit ? std::min(buffer.size(), *limit - total) : buffer.size();
+    ssize_t count = ::read(from, buffer.data(), want);
+    if (count == 0) {
+      break;
+    }
+    if (count < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        auto ready = wait_for(from, POLLIN);
+        if (!ready) {
+          return ready.error();
+        }
+        continue;
+      }
+      return make_errno_error("read");
+    }
+    auto n = static_cast<std::size_t>(count);
+    if (tee_fd >= 0) {
+      auto teed = write_fully(tee_fd, buffer.data(), n);
+      if (!teed) {
+        return teed.error();
+      }
+    }
+    auto written = write_fully(to, buffer.data(), n);
+    if (!written) {
+      return written.error();
+    }
+    total += n;
+  }
+  return total;
+}
+
+#if PROCLY_PLATFORM_LINUX
+// Splice up to n bytes once; 0 means EOF. Waits out EAGAIN on either end.
+Result<std::size_t> splice_some(int from, int to, std::size_t n) {
+  while (true) {
+    auto moved = without_sigpipe(
+        [&] { return ::splice(from, nullptr, to, nullptr, n, SPLICE_F_MOVE | SPLICE_F_MORE); },
+        "splice");
+    if (moved || !would_block(moved.error())) {
+      return moved;
+    }
+    auto readable = wait_for(from, POLLIN);
+    if (!readable) {
+      return readable.error();
+    }
+    auto writable = wait_for(to, POLLOUT);
+    if (!writable) {
+      return writable.error();
+    }
+  }
+}
+
+bool is_einval(const Error& error) { return error.code == std::errc::invalid_argument; }
+
+// splice()/tee() path. Sets *unsupported and returns the bytes moved so far when the
+// descriptors cannot be spliced, so the caller can finish with copy_loop.
+Result<std::size_t> splice_loop(int from, int to, int tee_fd, bool* unsupported) {
+  std::size_t total = 0;
+  while (true) {
+    std::size_t chunk = kTransferChunk;
+    if (tee_fd >= 0) {
+      ssize_t teed = ::tee(from, tee_fd, kTransferChunk, 0);
+      if (teed == 0) {
+        return total;
+      }
+      if (teed < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        if (errno == EAGAIN) {
+          auto readable = wait_for(from, POLLIN);
+          if (!readable) {
+            return readable.error();
+          }
+          auto writable = wait_for(tee_fd, POLLOUT);
+          if (!writable) {
+            return writable.error();
+          }
+          continue;
+        }
+        if (errno == EINVAL && total == 0) {
+          *unsupported = true;
+          return total;
+        }
+        return make_errno_error("tee");
+      }
+      chunk = static_cast<std::size_t>(teed);
+    }
+
+    // With tee, the same bytes are still at the head of the pipe; move exactly those.
+    std::size_t remaining = chunk;
+    do {
+      auto moved = splice_some(from, to, remaining);
+      if (!moved) {
+        if (is_einval(moved.error()) && total == 0) {
+          *unsupported = true;
+          if (tee_fd < 0) {
+            return total;
+          }
+          // The teed bytes are already observed; copy them on without teeing again.
+          auto copied = copy_loop(from, to, -1, remaining);
+          if (!copied) {
+            return copied.error();
+          }
+          return total + copied.value();
+        }
+        return moved.error();
+      }
+      if (moved.value() == 0) {
+        return total;
+      }
+      remaining -= std::min(remaining, moved.value());
+      total += moved.value();
+    } while (tee_fd >= 0 && remaining > 0);
+  }
+}
+#endif
+
+Result<std::size_t> transfer(int from, int to, int tee_fd) {
+  if (from < 0 || to < 0) {
+    return Error{.code = make_error_code(errc::invalid_stdio), .context = "transfer"};
+  }
+  std::size_t total = 0;
+#if PROCLY_PLATFORM_LINUX
+  bool unsupported = false;
+  auto spliced = splice_loop(from, to, tee_fd, &unsupported);
+  if (!spliced) {
+    return spliced.error();
+  }
+  if (!unsupported) {
+    return spliced.value();
+  }
+  total = spliced.value();
+#endif
+  auto copied = copy_loop(from, to, tee_fd, std::nullopt);
+  if (!copied) {
+    return copied.error();
+  }
+  return total + copied.value();
 }
 
 Result<std::size_t> read_some_impl(int fd, void* data, std::size_t n) {
@@ -118,6 +320,59 @@ Result<std::size_t> write_some_impl(int fd, const void* data, std::size_t n) {
   return write_without_sigpipe(fd, data, n);
 }
 
+// Map EAGAIN to an empty result for the try_* calls.
+Result<std::optional<std::size_t>> unless_would_block(Result<std::size_t> result) {
+  if (result) {
+    return std::optional<std::size_t>(result.value());
+  }
+  if (would_block(result.error())) {
+    return std::optional<std::size_t>();
+  }
+  return result.error();
+}
+
+Result<void> set_nonblocking_impl(int fd) {
+  if (fd < 0) {
+    return Error{.code = make_error_code(errc::invalid_stdio), .context = "set_nonblocking"};
+  }
+  return internal::set_nonblocking(fd);
+}
+
+#if PROCLY_HAS_STD_SPAN
+// iovec array for a scatter/gather call: inline for the usual handful of buffers.
+class IovecList {
+ public:
+  template <typename Buffers>
+  explicit IovecList(const Buffers& buffers) {
+    iovec* out = inline_.data();
+    if (buffers.size() > inline_.size()) {
+      spilled_.resize(buffers.size());
+      out = spilled_.data();
+    }
+    for (const auto& buffer : buffers) {
+      // readv/writev take non-const iov_base even for writes.
+      out[size_++] = iovec{.iov_base = const_cast<std::byte*>(buffer.data()),
+                           .iov_len = buffer.size()};
+    }
+    data_ = out;
+  }
+
+  [[nodiscard]] iovec* data() noexcept { return data_; }
+  [[nodiscard]] std::size_t size() const noexcept { return size_; }
+  // Count passed to one readv/writev call.
+  [[nodiscard]] int batch(std::size_t from) const noexcept {
+    return static_cast<int>(std::min<std::size_t>(size_ - from, IOV_MAX));
+  }
+
+ private:
+  static constexpr std::size_t kInlineIovecs = 8;
+  std::array<iovec, kInlineIovecs> inline_{};
+  std::vector<iovec> spilled_;
+  iovec* data_ = nullptr;
+  std::size_t size_ = 0;
+};
+#endif
+
 }  // namespace
 
 PipeReader::PipeReader(PipeReader&& other) noexcept {
@@ -157,6 +412,25 @@ void PipeReader::close() noexcept {
 Result<std::size_t> PipeReader::read_some(std::span<std::byte> buffer) const {
   return read_some(buffer.data(), buffer.size());
 }
+
+Result<std::size_t> PipeReader::read_some(std::span<const std::span<std::byte>> buffers) const {
+  auto use = concurrent_use_.enter("PipeReader");
+  (void)use;
+  if (fd_ < 0) {
+    return Error{.code = make_error_code(errc::invalid_stdio), .context = "readv"};
+  }
+  IovecList iov(buffers);
+  while (true) {
+    ssize_t rv = ::readv(fd_, iov.data(), iov.batch(0));
+    if (rv >= 0) {
+      return static_cast<std::size_t>(rv);
+    }
+    if (errno == EINTR) {
+      continue;
+    }
+    return make_errno_error("readv");
+  }
+}
 #endif
 
 Result<std::size_t> PipeReader::read_some(void* data, std::size_t n) const {
@@ -165,6 +439,63 @@ Result<std::size_t> PipeReader::read_some(void* data, std::size_t n) const {
   return read_some_impl(fd_, data, n);
 }
 
+Result<void> PipeReader::set_nonblocking() const {
+  auto use = concurrent_use_.enter("PipeReader");
+  (void)use;
+  return set_nonblocking_impl(fd_);
+}
+
+#if PROCLY_HAS_STD_SPAN
+Result<std::optional<std::size_t>> PipeReader::try_read_some(std::span<std::byte> buffer) const {
+  return try_read_some(buffer.data(), buffer.size());
+}
+#endif
+
+Result<std::optional<std::size_t>> PipeReader::try_read_some(void* data, std::size_t n) const {
+  auto use = concurrent_use_.enter("PipeReader");
+  (void)use;
+  return unless_would_block(read_some_impl(fd_, data, n));
+}
+
+Result<std::size_t> PipeReader::transfer_to(int fd) const {
+  auto use = concurrent_use_.enter("PipeReader");
+  (void)use;
+  return transfer(fd_, fd, -1);
+}
+
+Result<std::size_t> PipeReader::transfer_to(int fd, const PipeWriter& tee) const {
+  int tee_fd = tee.native_handle();
+  auto use = concurrent_use_.enter("PipeReader");
+  (void)use;
+  if (tee_fd < 0) {
+    return Error{.code = make_error_code(errc::invalid_stdio), .context = "tee"};
+  }
+  return transfer(fd_, fd, tee_fd);
+}
+
+#if PROCLY_HAS_STD_SPAN
+Async<std::size_t> PipeReader::read_some_async(Reactor& reactor,
+                                               std::span<std::byte> buffer) const {
+  return read_some_async(reactor, buffer.data(), buffer.size());
+}
+#endif
+
+Async<std::size_t> PipeReader::read_some_async(Reactor& reactor, void* data,
+                                               std::size_t n) const {
+  return Async<std::size_t>([this, &reactor, data, n](const Async<std::size_t>::Callback& done) {
+    int fd = native_handle();
+    if (fd < 0) {
+      done(Error{.code = make_error_code(errc::invalid_stdio), .context = "read"});
+      return;
+    }
+    auto armed = reactor.when_readable(fd, std::nullopt,
+                                       [this, data, n, done](bool) { done(read_some(data, n)); });
+    if (!armed) {
+      done(armed.error());
+    }
+  });
+}
+
 Result<std::string> PipeReader::read_all() const {
   auto use = concurrent_use_.enter("PipeReader");
   (void)use;
@@ -172,18 +503,18 @@ Result<std::string> PipeReader::read_all() const {
     return Error{.code = make_error_code(errc::invalid_stdio), .context = "read"};
   }
   std::string out;
-  constexpr std::size_t kPipeBufferSize = 8192;
-  std::array<char, kPipeBufferSize> buffer{};
   while (true) {
-    auto read_result = read_some_impl(fd_, buffer.data(), buffer.size());
-    if (!read_result) {
-      return read_result.error();
+    ssize_t count = internal::read_into(fd_, out);
+    if (count > 0) {
+      continue;
     }
-    std::size_t count = read_result.value();
     if (count == 0) {
       break;
     }
-    out.append(buffer.data(), count);
+    if (errno == EINTR) {
+      continue;
+    }
+    return make_errno_error("read");
   }
   return out;
 }
@@ -225,6 +556,43 @@ void PipeWriter::close() noexcept {
 Result<std::size_t> PipeWriter::write_some(std::span<const std::byte> buffer) const {
   return write_some(buffer.data(), buffer.size());
 }
+
+Result<void> PipeWriter::write_all(std::span<const std::span<const std::byte>> buffers) const {
+  auto use = concurrent_use_.enter("PipeWriter");
+  (void)use;
+  if (fd_ < 0) {
+    return Error{.code = make_error_code(errc::invalid_stdio), .context = "writev"};
+  }
+  IovecList iov(buffers);
+  std::size_t next = 0;
+  while (next < iov.size()) {
+    iovec* head = iov.data() + next;
+    if (head->iov_len == 0) {
+      ++next;
+      continue;
+    }
+    int batch = iov.batch(next);
+    auto written = without_sigpipe([&] { return ::writev(fd_, head, batch); }, "writev");
+    if (!written) {
+      return written.error();
+    }
+    if (written.value() == 0) {
+      return Error{.code = make_error_code(errc::write_failed), .context = "writev"};
+    }
+    // Skip the buffers written in full and trim the one the write stopped inside.
+    std::size_t remaining = written.value();
+    while (next < iov.size() && remaining >= iov.data()[next].iov_len) {
+      remaining -= iov.data()[next].iov_len;
+      ++next;
+    }
+    if (remaining > 0) {
+      iovec& partial = iov.data()[next];
+      partial.iov_base = static_cast<std::byte*>(partial.iov_base) + remaining;
+      partial.iov_len -= remaining;
+    }
+  }
+  return {};
+}
 #endif
 
 Result<std::size_t> PipeWriter::write_some(const void* data, std::size_t n) const {
@@ -233,6 +601,32 @@ Result<std::size_t> PipeWriter::write_some(const void* data, std::size_t n) cons
   return write_some_impl(fd_, data, n);
 }
 
+Result<void> PipeWriter::set_nonblocking() const {
+  auto use = concurrent_use_.enter("PipeWriter");
+  (void)use;
+  return set_nonblocking_impl(fd_);
+}
+
+#if PROCLY_HAS_STD_SPAN
+Result<std::optional<std::size_t>> PipeWriter::try_write_some(
+    std::span<const std::byte> buffer) const {
+  return try_write_some(buffer.data(), buffer.size());
+}
+#endif
+
+Result<std::optional<std::size_t>> PipeWriter::try_write_some(const void* data,
+                                                              std::size_t n) const {
+  auto use = concurrent_use_.enter("PipeWriter");
+  (void)use;
+  return unless_would_block(write_some_impl(fd_, data, n));
+}
+
+Result<std::size_t> PipeWriter::transfer_from(int fd) const {
+  auto use = concurrent_use_.enter("PipeWriter");
+  (void)use;
+  return transfer(fd, fd_, -1);
+}
+
 Result<void> PipeWriter::write_all(std::string_view data) const {
   auto use = concurrent_use_.enter("PipeWriter");
   (void)use;
@@ -1,13 +1,28 @@
 #include "procly/pipeline.hpp"
 
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <optional>
+#include <string_view>
 #include <utility>
+#include <variant>
 
 #include "procly/child.hpp"
 #include "procly/internal/access.hpp"
 #include "procly/internal/backend.hpp"
+#include "procly/internal/cgroup.hpp"
 #include "procly/internal/fd.hpp"
+#include "procly/internal/function_stage_run.hpp"
 #include "procly/internal/io_drain.hpp"
 #include "procly/internal/lowering.hpp"
+#include "procly/internal/proc_sample.hpp"
+#include "procly/internal/wait_policy.hpp"
 
 namespace procly {
 
@@ -25,6 +40,29 @@ Pipeline& Pipeline::new_process_group(bool enabled) {
   return *this;
 }
 
+Pipeline& Pipeline::pipe_capacity(std::size_t bytes) {
+  auto use = concurrent_use_.enter("Pipeline");
+  (void)use;
+  pipe_capacity_ = bytes;
+  return *this;
+}
+
+#if PROCLY_PLATFORM_LINUX
+Pipeline& Pipeline::cgroup(std::filesystem::path path) {
+  auto use = concurrent_use_.enter("Pipeline");
+  (void)use;
+  cgroup_ = std::move(path);
+  return *this;
+}
+#endif
+
+Pipeline& Pipeline::backend(Backend& backend) {
+  auto use = concurrent_use_.enter("Pipeline");
+  (void)use;
+  backend_ = &backend;
+  return *this;
+}
+
 Pipeline& Pipeline::stdin(Stdio value) {
   auto use = concurrent_use_.enter("Pipeline");
   (void)use;
@@ -58,6 +96,17 @@ Pipeline operator|(Pipeline left, Command right) {
   return left;
 }
 
+Pipeline operator|(Command left, FunctionStage right) {
+  Pipeline pipeline;
+  pipeline.stages_.push_back(std::move(left));
+  return std::move(pipeline) | std::move(right);
+}
+
+Pipeline operator|(Pipeline left, FunctionStage right) {
+  left.functions_.emplace_back(left.stages_.size(), std::move(right));
+  return left;
+}
+
 struct PipelineChild::Impl {
   std::vector<internal::Spawned> spawned;
   bool pipefail = false;
@@ -66,9 +115,31 @@ struct PipelineChild::Impl {
   std::optional<PipeWriter> stdin_pipe;
   std::optional<PipeReader> stdout_pipe;
   std::optional<PipeReader> stderr_pipe;
+  // Stderr pipes of the stages before the last, when output_stages() asked for them.
+  std::vector<std::optional<PipeReader>> stage_stderr;
+  std::vector<internal::unique_fd> exit_handles;
+  // /proc/<pid>/stat per process stage, opened by the first sample().
+  std::vector<internal::unique_fd> stat_fds;
+  std::vector<internal::FunctionStageRun> functions;
+  // Position of each process stage among all stages, function stages included.
+  std::vector<std::size_t> positions;
   internal::ConcurrentUseGuard concurrent_use;
 };
 
+// Kills the process group when the pipeline has one, otherwise every stage.
+Result<void> kill_stages(PipelineChild::Impl& impl) {
+  if (impl.new_process_group && !impl.spawned.empty()) {
+    return internal::backend_for(impl.spawned.front()).kill(impl.spawned.front());
+  }
+  for (auto& spawned : impl.spawned) {
+    auto result = internal::backend_for(spawned).kill(spawned);
+    if (!result) {
+      return result;
+    }
+  }
+  return {};
+}
+
 void cleanup_partially_spawned_pipeline(std::vector<internal::Spawned>* spawned,
                                         bool new_process_group) {
   if (spawned == nullptr || spawned->empty()) {
@@ -90,53 +161,172 @@ void cleanup_partially_spawned_pipeline(std::vector<internal::Spawned>* spawned,
   }
 }
 
-static Result<PipelineChild> spawn_pipeline(const Pipeline& pipeline, internal::SpawnMode mode) {
+namespace {
+
+struct FunctionLaunch {
+  const FunctionStage::Body* body = nullptr;
+  internal::unique_fd in;
+  internal::unique_fd out;
+  std::size_t position = 0;
+};
+
+// Where the last function stage writes when it ends the pipeline: the pipeline's stdout
+// setting, defaulting to a pipe for output() and the parent's stdout otherwise.
+Result<internal::unique_fd> open_function_stdout(const std::optional<Stdio>& value,
+                                                 internal::SpawnMode mode, std::size_t capacity,
+                                                 std::optional<PipeReader>* piped) {
+  bool want_pipe = value ? std::holds_alternative<Stdio::Piped>(value->value)
+                         : mode == internal::SpawnMode::output;
+  if (want_pipe) {
+    if (value && std::get<Stdio::Piped>(value->value).capacity != 0) {
+      capacity = std::get<Stdio::Piped>(value->value).capacity;
+    }
+    auto pipe = internal::create_pipe(capacity);
+    if (!pipe) {
+      return pipe.error();
+    }
+    piped->emplace(pipe->first.release());
+    return std::move(pipe->second);
+  }
+  int fd = STDOUT_FILENO;
+  if (value && std::holds_alternative<Stdio::Null>(value->value)) {
+    internal::unique_fd null_fd(::open("/dev/null", O_WRONLY | O_CLOEXEC));
+    if (!null_fd) {
+      return Error{.code = std::error_code(errno, std::system_category()), .context = "open"};
+    }
+    return null_fd;
+  }
+  if (value && std::holds_alternative<Stdio::Fd>(value->value)) {
+    fd = std::get<Stdio::Fd>(value->value).fd;
+  } else if (value && (std::holds_alternative<Stdio::File>(value->value) ||
+                        std::holds_alternative<Stdio::Bytes>(value->value))) {
+    return Error{.code = make_error_code(errc::invalid_stdio), .context = "function_stage_stdout"};
+  }
+  internal::unique_fd copy(::fcntl(fd, F_DUPFD_CLOEXEC, 0));
+  if (!copy) {
+    return Error{.code = std::error_code(errno, std::system_category()), .context = "dup"};
+  }
+  return copy;
+}
+
+}  // namespace
+
+static Result<PipelineChild> spawn_pipeline(const Pipeline& pipeline, internal::SpawnMode mode,
+                                            std::optional<Stdio> stdin_override = std::nullopt,
+                                            bool capture_stage_stderr = false) {
   auto pipeline_spec_result = internal::lower_pipeline(pipeline, mode);
   if (!pipeline_spec_result) {
     return pipeline_spec_result.error();
   }
-  const auto& pipeline_spec = pipeline_spec_result.value();
+  auto& pipeline_spec = pipeline_spec_result.value();
+  if (stdin_override && !pipeline_spec.stages.empty()) {
+    pipeline_spec.stages.front().overrides.stdin_override = std::move(stdin_override);
+  }
 
   const std::size_t stage_count = pipeline_spec.stages.size();
-  std::vector<std::pair<internal::unique_fd, internal::unique_fd>> pipes;
-  if (stage_count > 1) {
-    pipes.reserve(stage_count - 1);
-    for (std::size_t i = 0; i + 1 < stage_count; ++i) {
-      auto pipe_result = internal::create_pipe();
-      if (!pipe_result) {
-        return pipe_result.error();
+  const auto& functions = internal::PipelineAccess::functions(pipeline);
+
+  // Pipe ends handed to each command; the link after command i runs through any function
+  // stages placed there before reaching command i + 1 (or the pipeline's stdout).
+  std::vector<internal::unique_fd> stage_stdin(stage_count);
+  std::vector<internal::unique_fd> stage_stdout(stage_count);
+  std::vector<FunctionLaunch> launches;
+  launches.reserve(functions.size());
+  std::optional<PipeReader> function_stdout;
+  std::size_t next_function = 0;
+  for (std::size_t link = 1; link <= stage_count; ++link) {
+    std::size_t first_function = next_function;
+    while (next_function < functions.size() && functions[next_function].first == link) {
+      ++next_function;
+    }
+    bool trailing = link == stage_count;
+    if (trailing && first_function == next_function) {
+      break;
+    }
+    auto pipe_result = internal::create_pipe(pipeline_spec.pipe_capacity);
+    if (!pipe_result) {
+      return pipe_result.error();
+    }
+    stage_stdout[link - 1] = std::move(pipe_result->second);
+    internal::unique_fd upstream = std::move(pipe_result->first);
+    for (std::size_t index = first_function; index < next_function; ++index) {
+      FunctionLaunch launch{.body = &functions[index].second.body(),
+                            .in = std::move(upstream),
+                            .position = link + index};
+      if (trailing && index + 1 == next_function) {
+        auto out = open_function_stdout(internal::PipelineAccess::stdout_opt(pipeline), mode,
+                                        pipeline_spec.pipe_capacity, &function_stdout);
+        if (!out) {
+          return out.error();
+        }
+        launch.out = std::move(out.value());
+      } else {
+        auto next = internal::create_pipe(pipeline_spec.pipe_capacity);
+        if (!next) {
+          return next.error();
+        }
+        launch.out = std::move(next->second);
+        upstream = std::move(next->first);
       }
-      pipes.push_back(std::move(pipe_result.value()));
+      launches.push_back(std::move(launch));
+    }
+    if (!trailing) {
+      stage_stdin[link] = std::move(upstream);
     }
   }
 
   struct PreparedStage {
     internal::SpawnSpec spec;
+    internal::Backend* backend = nullptr;
     bool joins_pipeline_group = false;
   };
 
   std::vector<PreparedStage> prepared_stages;
   prepared_stages.reserve(stage_count);
 
+  // One snapshot of the live environment serves every stage that inherits it.
+  std::optional<internal::EnvBlock> live_env;
+
   for (std::size_t index = 0; index < stage_count; ++index) {
-    const auto& stage_spec = pipeline_spec.stages[index];
-    internal::StdioOverride override_stdio = stage_spec.overrides;
+    auto& stage_spec = pipeline_spec.stages[index];
+    internal::StdioOverride override_stdio = std::move(stage_spec.overrides);
 
     if (stage_spec.stdin_from_prev) {
-      override_stdio.stdin_override = Stdio::fd(pipes[index - 1].first.get());
+      override_stdio.stdin_override = Stdio::fd(stage_stdin[index].get());
     }
     if (stage_spec.stdout_to_next) {
-      override_stdio.stdout_override = Stdio::fd(pipes[index].second.get());
+      override_stdio.stdout_override = Stdio::fd(stage_stdout[index].get());
+    }
+    if (capture_stage_stderr && index + 1 < stage_count &&
+        !internal::CommandAccess::stderr_opt(*stage_spec.command)) {
+      override_stdio.stderr_override = Stdio::piped();
     }
 
     auto spec_result =
-        internal::lower_command(*stage_spec.command, stage_spec.mode, &override_stdio);
+        internal::lower_command(*stage_spec.command, stage_spec.mode, &override_stdio, &live_env);
     if (!spec_result) {
       return spec_result.error();
     }
 
+#if PROCLY_PLATFORM_LINUX
+    if (pipeline_spec.cgroup && !spec_result->opts.cgroup) {
+      spec_result->opts.cgroup = pipeline_spec.cgroup;
+    }
+#endif
+    for (auto* stdio : {&spec_result->stdin_spec, &spec_result->stdout_spec,
+                        &spec_result->stderr_spec}) {
+      if (stdio->kind == internal::StdioSpec::Kind::piped && stdio->pipe_capacity == 0) {
+        stdio->pipe_capacity = pipeline_spec.pipe_capacity;
+      }
+    }
+
+    auto* backend = internal::PipelineAccess::backend(pipeline);
+    if (backend == nullptr) {
+      backend = internal::CommandAccess::backend(*stage_spec.command);
+    }
     PreparedStage prepared{
         .spec = std::move(spec_result.value()),
+        .backend = backend != nullptr ? backend : &internal::default_backend(),
         .joins_pipeline_group = pipeline_spec.new_process_group && index > 0,
     };
     if (pipeline_spec.new_process_group && index == 0) {
@@ -149,28 +339,46 @@ static Result<PipelineChild> spawn_pipeline(const Pipeline& pipeline, internal::
   spawned.reserve(stage_count);
 
   std::optional<int> pipeline_pgid;
-  auto& backend = internal::default_backend();
 
   for (std::size_t index = 0; index < stage_count; ++index) {
-    auto spec = prepared_stages[index].spec;
+    auto& spec = prepared_stages[index].spec;
     if (prepared_stages[index].joins_pipeline_group) {
       spec.process_group = pipeline_pgid;
     } else {
       spec.process_group.reset();
     }
 
-    auto spawned_result = backend.spawn(spec);
+    auto* backend = prepared_stages[index].backend;
+    auto spawned_result = backend->spawn(spec);
     if (!spawned_result) {
       cleanup_partially_spawned_pipeline(&spawned, pipeline_spec.new_process_group);
       return spawned_result.error();
     }
-    spawned_result->backend = &backend;
+    spawned_result->backend = backend;
+#if PROCLY_PLATFORM_LINUX
+    spawned_result->cgroup = spec.opts.cgroup;
+#endif
 
     if (internal::PipelineAccess::new_process_group(pipeline) && !pipeline_pgid) {
       pipeline_pgid = spawned_result->pgid;
     }
 
-    spawned.push_back(spawned_result.value());
+    spawned.push_back(std::move(spawned_result.value()));
+  }
+  // Function stages must hold the only copies of their pipe ends to see EOF and EPIPE.
+  stage_stdin.clear();
+  stage_stdout.clear();
+
+  std::vector<internal::FunctionStageRun> runs;
+  runs.reserve(launches.size());
+  for (auto& launch : launches) {
+    auto run = internal::FunctionStageRun::start(*launch.body, std::move(launch.in),
+                                                 std::move(launch.out), launch.position);
+    if (!run) {
+      cleanup_partially_spawned_pipeline(&spawned, pipeline_spec.new_process_group);
+      return run.error();
+    }
+    runs.push_back(std::move(run.value()));
   }
 
   PipelineChild child;
@@ -179,6 +387,14 @@ static Result<PipelineChild> spawn_pipeline(const Pipeline& pipeline, internal::
   impl->pipefail = pipeline_spec.pipefail;
   impl->new_process_group = pipeline_spec.new_process_group;
   impl->pgid = pipeline_pgid;
+  impl->functions = std::move(runs);
+  impl->positions.reserve(stage_count);
+  for (std::size_t index = 0, before = 0; index < stage_count; ++index) {
+    while (before < functions.size() && functions[before].first <= index) {
+      ++before;
+    }
+    impl->positions.push_back(index + before);
+  }
 
   if (!impl->spawned.empty()) {
     auto& first = impl->spawned.front();
@@ -186,13 +402,23 @@ static Result<PipelineChild> spawn_pipeline(const Pipeline& pipeline, internal::
     if (first.stdin_fd) {
       impl->stdin_pipe.emplace(*first.stdin_fd);
     }
-    if (last.stdout_fd) {
+    if (function_stdout) {
+      impl->stdout_pipe = std::move(function_stdout);
+    } else if (last.stdout_fd) {
       impl->stdout_pipe.emplace(*last.stdout_fd);
     }
     if (last.stderr_fd) {
       impl->stderr_pipe.emplace(*last.stderr_fd);
     }
   }
+  if (capture_stage_stderr) {
+    impl->stage_stderr.resize(stage_count);
+    for (std::size_t index = 0; index + 1 < stage_count; ++index) {
+      if (impl->spawned[index].stderr_fd) {
+        impl->stage_stderr[index].emplace(*impl->spawned[index].stderr_fd);
+      }
+    }
+  }
 
   internal::PipelineAccess::impl(child) = std::move(impl);
   return child;
@@ -234,39 +460,158 @@ Result<ExitStatus> Pipeline::status() const {
   return status_result->aggregate;
 }
 
-Result<Output> Pipeline::output() const {
+// Feed input (closing stdin right away when absent), drain, and wait for every stage, all
+// before wait->timeout when given.
+static Result<PipelineOutput> finish_pipeline_output(PipelineChild& child,
+                                                     std::optional<std::string_view> input,
+                                                     const CaptureOptions& options,
+                                                     const WaitOptions* wait = nullptr) {
+  auto stdin_pipe = child.take_stdin();
+  if (stdin_pipe && !input) {
+    stdin_pipe->close();
+  }
+
+  auto stdout_pipe = child.take_stdout();
+  auto stderr_pipe = child.take_stderr();
+
+  internal::StdinFeed feed;
+  if (input && stdin_pipe) {
+    feed.pipe = &*stdin_pipe;
+    feed.data = *input;
+  }
+
+  auto& stage_pipes = internal::PipelineAccess::impl(child)->stage_stderr;
+  std::vector<std::string> stage_stderr(stage_pipes.size());
+  std::vector<internal::ExtraCapture> extra;
+  for (std::size_t index = 0; index < stage_pipes.size(); ++index) {
+    if (stage_pipes[index]) {
+      extra.push_back(
+          internal::ExtraCapture{.pipe = &*stage_pipes[index], .out = &stage_stderr[index]});
+    }
+  }
+  std::optional<internal::DrainDeadline> deadline;
+  if (wait != nullptr && (wait->timeout || wait->cancel)) {
+    deadline.emplace();
+    if (wait->timeout) {
+      deadline->at = internal::default_clock().now() + *wait->timeout;
+    }
+    if (wait->cancel) {
+      auto cancel_fd = wait->cancel->wait_handle();
+      if (!cancel_fd) {
+        (void)child.kill();
+        (void)child.wait();
+        return cancel_fd.error();
+      }
+      deadline->cancel_fd = cancel_fd.value();
+    }
+    deadline->kill_grace = wait->kill_grace;
+    deadline->terminate = [&child] { (void)child.terminate(); };
+    deadline->kill = [&child] { (void)child.kill(); };
+  }
+  auto drained = internal::drain_pipes(
+      feed, stdout_pipe ? &*stdout_pipe : nullptr, stderr_pipe ? &*stderr_pipe : nullptr,
+      options, [&child] { (void)child.kill(); }, extra, deadline ? &*deadline : nullptr);
+  stage_pipes.clear();
+  if (!drained) {
+    return drained.error();
+  }
+
+  PipelineOutput result;
+  if (!deadline) {
+    auto status_result = child.wait();
+    if (!status_result) {
+      return status_result.error();
+    }
+    result.status = std::move(status_result.value());
+  } else {
+    auto reap = internal::reap_options(*deadline, *wait);
+    PipelineWaitOptions remaining;
+    remaining.timeout = reap.timeout;
+    remaining.kill_grace = reap.kill_grace;
+    remaining.cancel = std::move(reap.cancel);
+    auto waited = child.wait(remaining);
+    if (!waited) {
+      return waited.error();
+    }
+    result.status = std::move(waited->status);
+    result.cancelled = deadline->cancelled || waited->cancelled;
+    result.timed_out = (deadline->sent_terminate && !deadline->cancelled) || waited->timed_out;
+    result.sent_terminate = deadline->sent_terminate || waited->sent_terminate;
+    result.sent_kill = deadline->sent_kill || waited->sent_kill;
+  }
+
+  result.output.status = result.status.aggregate;
+  result.output.stdout_data = std::move(drained->stdout_data);
+  result.output.stderr_data = std::move(drained->stderr_data);
+  result.output.stdout_dropped = drained->stdout_dropped;
+  result.output.stderr_dropped = drained->stderr_dropped;
+  if (!stage_stderr.empty()) {
+    stage_stderr.back() = result.output.stderr_data;
+    result.status.stage_stderr = std::move(stage_stderr);
+  }
+  return result;
+}
+
+Result<Output> Pipeline::output() const { return output(CaptureOptions{}); }
+
+Result<Output> Pipeline::output(const CaptureOptions& options) const {
   auto use = concurrent_use_.enter("Pipeline");
   (void)use;
   auto child_result = spawn_pipeline(*this, internal::SpawnMode::output);
   if (!child_result) {
     return child_result.error();
   }
-
-  auto stdin_pipe = child_result->take_stdin();
-  if (stdin_pipe) {
-    stdin_pipe->close();
+  auto result = finish_pipeline_output(child_result.value(), std::nullopt, options);
+  if (!result) {
+    return result.error();
   }
+  return std::move(result->output);
+}
 
-  auto stdout_pipe = child_result->take_stdout();
-  auto stderr_pipe = child_result->take_stderr();
+Result<PipelineOutput> Pipeline::output(const WaitOptions& wait,
+                                        const CaptureOptions& options) const {
+  auto use = concurrent_use_.enter("Pipeline");
+  (void)use;
+  auto child_result = spawn_pipeline(*this, internal::SpawnMode::output);
+  if (!child_result) {
+    return child_result.error();
+  }
+  return finish_pipeline_output(child_result.value(), std::nullopt, options, &wait);
+}
 
-  auto drained = internal::drain_pipes(stdout_pipe ? &*stdout_pipe : nullptr,
-                                       stderr_pipe ? &*stderr_pipe : nullptr);
-  if (!drained) {
-    return drained.error();
+Result<PipelineOutput> Pipeline::output_stages(const CaptureOptions& options) const {
+  auto use = concurrent_use_.enter("Pipeline");
+  (void)use;
+  auto child_result = spawn_pipeline(*this, internal::SpawnMode::output, std::nullopt,
+                                     /*capture_stage_stderr=*/true);
+  if (!child_result) {
+    return child_result.error();
   }
+  return finish_pipeline_output(child_result.value(), std::nullopt, options);
+}
 
-  auto status_result = child_result->wait();
-  if (!status_result) {
-    return status_result.error();
+Result<Output> Pipeline::output_with_input(std::string_view input,
+                                           const CaptureOptions& options) const {
+  auto use = concurrent_use_.enter("Pipeline");
+  (void)use;
+  auto child_result = spawn_pipeline(*this, internal::SpawnMode::output, Stdio::piped());
+  if (!child_result) {
+    return child_result.error();
   }
+  auto result = finish_pipeline_output(child_result.value(), input, options);
+  if (!result) {
+    return result.error();
+  }
+  return std::move(result->output);
+}
 
-  Output output;
-  output.status = status_result->aggregate;
-  output.stdout_data = std::move(drained->stdout_data);
-  output.stderr_data = std::move(drained->stderr_data);
-  return output;
+#if PROCLY_HAS_STD_SPAN
+Result<Output> Pipeline::output_with_input(std::span<const std::byte> input,
+                                           const CaptureOptions& options) const {
+  return output_with_input(
+      std::string_view(reinterpret_cast<const char*>(input.data()), input.size()), options);
 }
+#endif
 
 PipelineChild::PipelineChild() = default;
 
@@ -291,7 +636,16 @@ PipelineChild& PipelineChild::operator=(PipelineChild&& other) noexcept {
   return *this;
 }
 
-PipelineChild::~PipelineChild() = default;
+PipelineChild::~PipelineChild() {
+  if (!impl_) {
+    return;
+  }
+  for (auto& stage : impl_->spawned) {
+    if (stage.pid > 0 && !stage.terminal_result) {
+      internal::backend_for(stage).abandon(stage);
+    }
+  }
+}
 
 std::optional<PipeWriter> PipelineChild::take_stdin() noexcept {
   if (!impl_) {
@@ -326,6 +680,140 @@ std::optional<PipeReader> PipelineChild::take_stderr() noexcept {
   return pipe;
 }
 
+namespace {
+
+// Join every function stage and record its outcome; the processes have all been reaped, so
+// the stages are at or past end of input.
+void join_function_stages(PipelineChild::Impl& impl, PipelineStatus& status) {
+  status.function_stages.reserve(impl.functions.size());
+  for (auto& function : impl.functions) {
+    status.function_stages.push_back(function.join());
+  }
+}
+
+Result<PipelineStatus> aggregate_status(PipelineStatus status, const PipelineChild::Impl& impl) {
+  if (status.stages.empty()) {
+    return Error{.code = make_error_code(errc::invalid_pipeline), .context = "wait"};
+  }
+
+  // Every stage in pipeline order; a failed function stage counts as exit code 1.
+  std::vector<ExitStatus> ordered(status.stages.size() + status.function_stages.size());
+  for (std::size_t index = 0; index < status.stages.size(); ++index) {
+    ordered[impl.positions.empty() ? index : impl.positions[index]] = status.stages[index];
+  }
+  for (const auto& function : status.function_stages) {
+    ordered[function.position] = ExitStatus::exited(function.success() ? 0 : 1);
+  }
+
+  if (!impl.pipefail) {
+    status.aggregate = ordered.back();
+    return status;
+  }
+
+  for (auto it = ordered.rbegin(); it != ordered.rend(); ++it) {
+    if (!it->success()) {
+      status.aggregate = *it;
+      return status;
+    }
+  }
+  status.aggregate = ordered.back();
+  return status;
+}
+
+Error make_errno_error(const char* context) {
+  return Error{.code = std::error_code(errno, std::system_category()), .context = context};
+}
+
+Result<void> open_exit_handles(PipelineChild::Impl& impl) {
+  if (impl.exit_handles.size() == impl.spawned.size()) {
+    return {};
+  }
+  std::vector<internal::unique_fd> handles;
+  handles.reserve(impl.spawned.size());
+  for (auto& spawned : impl.spawned) {
+    auto handle = internal::backend_for(spawned).open_exit_handle(spawned);
+    if (!handle) {
+      return handle.error();
+    }
+    handles.emplace_back(handle.value());
+  }
+  impl.exit_handles = std::move(handles);
+  return {};
+}
+
+// Block until a member of the process group exits, leaving it for try_wait to reap. Returns
+// false when the group has no children left to wait for.
+Result<bool> wait_group_exit(int pgid) {
+  siginfo_t info{};
+  while (::waitid(P_PGID, static_cast<id_t>(pgid), &info, WEXITED | WNOWAIT) == -1) {
+    if (errno == EINTR) {
+      continue;
+    }
+    if (errno == ECHILD) {
+      return false;
+    }
+    return make_errno_error("waitid");
+  }
+  return true;
+}
+
+// Poll the exit handles of stages not yet reaped, and cancel_fd unless it is -1.
+Result<void> wait_exit_handles(PipelineChild::Impl& impl,
+                               std::optional<std::chrono::milliseconds> budget, int cancel_fd) {
+  std::vector<pollfd> fds;
+  fds.reserve(impl.spawned.size() + 1);
+  if (cancel_fd >= 0) {
+    fds.push_back(pollfd{.fd = cancel_fd, .events = POLLIN, .revents = 0});
+  }
+  for (std::size_t index = 0; index < impl.spawned.size(); ++index) {
+    if (!impl.spawned[index].terminal_result) {
+      fds.push_back(pollfd{.fd = impl.exit_handles[index].get(), .events = POLLIN, .revents = 0});
+    }
+  }
+  int timeout_ms = -1;
+  if (budget) {
+    timeout_ms = static_cast<int>(std::min<std::chrono::milliseconds::rep>(budget->count(), INT_MAX));
+  }
+  if (::poll(fds.data(), fds.size(), timeout_ms) == -1 && errno != EINTR) {
+    return make_errno_error("poll(exit_handles)");
+  }
+  return {};
+}
+
+// Usage recorded by each stage's backend when it was reaped.
+std::vector<std::optional<ResourceUsage>> reaped_stage_usage(const PipelineChild::Impl& impl) {
+  std::vector<std::optional<ResourceUsage>> usage;
+  usage.reserve(impl.spawned.size());
+  for (const auto& spawned : impl.spawned) {
+    usage.push_back(spawned.terminal_result ? spawned.terminal_result->usage : std::nullopt);
+  }
+  return usage;
+}
+
+// Signal every stage still running; a process group only needs one live member signalled.
+Result<void> signal_running_stages(PipelineChild::Impl& impl, bool force) {
+  std::optional<Error> first_error;
+  for (auto& spawned : impl.spawned) {
+    if (spawned.terminal_result) {
+      continue;
+    }
+    auto& backend = internal::backend_for(spawned);
+    auto result = force ? backend.kill(spawned) : backend.terminate(spawned);
+    if (!result && !first_error) {
+      first_error = result.error();
+    }
+    if (result && impl.new_process_group) {
+      return {};
+    }
+  }
+  if (first_error) {
+    return *first_error;
+  }
+  return {};
+}
+
+}  // namespace
+
 Result<PipelineStatus> PipelineChild::wait() {
   if (!impl_) {
     return Error{.code = make_error_code(errc::wait_failed), .context = "wait"};
@@ -335,6 +823,7 @@ Result<PipelineStatus> PipelineChild::wait() {
 
   PipelineStatus status;
   status.stages.reserve(impl_->spawned.size());
+  status.stage_usage.reserve(impl_->spawned.size());
 
   for (auto& spawned : impl_->spawned) {
     auto wait_result =
@@ -343,25 +832,188 @@ Result<PipelineStatus> PipelineChild::wait() {
       return wait_result.error();
     }
     status.stages.push_back(wait_result->status);
+    status.stage_usage.push_back(wait_result->usage);
   }
+  join_function_stages(*impl_, status);
 
-  if (status.stages.empty()) {
-    return Error{.code = make_error_code(errc::invalid_pipeline), .context = "wait"};
+  return aggregate_status(std::move(status), *impl_);
+}
+
+Result<PipelineWaitResult> PipelineChild::wait(const PipelineWaitOptions& options) {
+  if (!impl_) {
+    return Error{.code = make_error_code(errc::wait_failed), .context = "wait"};
   }
+  auto use = impl_->concurrent_use.enter("PipelineChild");
+  (void)use;
 
-  if (!impl_->pipefail) {
-    status.aggregate = status.stages.back();
-    return status;
+  auto& impl = *impl_;
+  // waitid() cannot also watch the cancellation token, so cancellable waits poll exit handles.
+  bool group_wait = impl.new_process_group && impl.pgid.has_value() && !options.cancel;
+  int cancel_fd = -1;
+  if (options.cancel) {
+    auto handle = options.cancel->wait_handle();
+    if (!handle) {
+      return handle.error();
+    }
+    cancel_fd = handle.value();
   }
+  bool handles_ready = false;
+  bool handles_failed = false;
 
-  for (auto it = status.stages.rbegin(); it != status.stages.rend(); ++it) {
-    if (!it->success()) {
-      status.aggregate = *it;
-      return status;
+  internal::StageWaitOps ops;
+  ops.stage_count = impl.spawned.size();
+  ops.try_wait = [&impl](std::size_t stage) {
+    auto& spawned = impl.spawned[stage];
+    return internal::backend_for(spawned).try_wait(spawned);
+  };
+  ops.terminate = [&impl] { return signal_running_stages(impl, false); };
+  ops.kill = [&impl] { return signal_running_stages(impl, true); };
+  ops.wait_any_exit = [&](std::optional<std::chrono::milliseconds> budget) -> Result<void> {
+    // waitid has no timeout, so it only serves unbounded waits.
+    if (group_wait && !budget) {
+      auto waited = wait_group_exit(*impl.pgid);
+      if (!waited) {
+        return waited.error();
+      }
+      if (waited.value()) {
+        return {};
+      }
+      group_wait = false;
+    }
+    if (!handles_ready && !handles_failed) {
+      handles_ready = static_cast<bool>(open_exit_handles(impl));
+      handles_failed = !handles_ready;
+    }
+    if (handles_failed) {
+      constexpr auto kSleepStep = std::chrono::milliseconds(1);
+      internal::default_clock().sleep_for(budget ? std::min(*budget, kSleepStep) : kSleepStep);
+      return {};
     }
+    // A fired token stays readable, so stop watching it once the escalation is underway.
+    bool watch_cancel = options.cancel && !options.cancel->cancelled();
+    return wait_exit_handles(impl, budget, watch_cancel ? cancel_fd : -1);
+  };
+  if (options.cancel) {
+    ops.cancelled = [&options] { return options.cancel->cancelled(); };
   }
-  status.aggregate = status.stages.back();
-  return status;
+
+  auto waited = internal::wait_stages(ops, internal::default_clock(), options.timeout,
+                                      options.kill_grace, options.fail_fast);
+  if (!waited) {
+    return waited.error();
+  }
+  PipelineStatus status;
+  status.stages = std::move(waited->stages);
+  status.stage_usage = reaped_stage_usage(impl);
+  join_function_stages(impl, status);
+  auto aggregate = aggregate_status(std::move(status), impl);
+  if (!aggregate) {
+    return aggregate.error();
+  }
+
+  PipelineWaitResult result;
+  result.status = std::move(aggregate.value());
+  result.timed_out = waited->timed_out;
+  result.cancelled = waited->cancelled;
+  result.sent_terminate = waited->sent_terminate;
+  result.sent_kill = waited->sent_kill;
+  result.failed_stage = waited->failed_stage;
+  return result;
+}
+
+Result<std::optional<PipelineStatus>> PipelineChild::try_wait() {
+  if (!impl_) {
+    return Error{.code = make_error_code(errc::wait_failed), .context = "try_wait"};
+  }
+  auto use = impl_->concurrent_use.enter("PipelineChild");
+  (void)use;
+
+  PipelineStatus status;
+  status.stages.reserve(impl_->spawned.size());
+  bool all_exited = true;
+
+  // Poll every stage, not just up to the first running one, so exited stages do not linger as
+  // zombies while a later stage keeps running.
+  for (auto& spawned : impl_->spawned) {
+    auto try_wait_result = internal::backend_for(spawned).try_wait(spawned);
+    if (!try_wait_result) {
+      return try_wait_result.error();
+    }
+    if (!try_wait_result.value().has_value()) {
+      all_exited = false;
+      continue;
+    }
+    status.stages.push_back(*try_wait_result.value());
+  }
+  for (const auto& function : impl_->functions) {
+    all_exited = all_exited && function.done();
+  }
+
+  if (!all_exited) {
+    return std::optional<PipelineStatus>();
+  }
+  status.stage_usage = reaped_stage_usage(*impl_);
+  join_function_stages(*impl_, status);
+  auto aggregate = aggregate_status(std::move(status), *impl_);
+  if (!aggregate) {
+    return aggregate.error();
+  }
+  return std::optional<PipelineStatus>(std::move(aggregate.value()));
+}
+
+Result<std::vector<int>> PipelineChild::exit_handles() {
+  if (!impl_) {
+    return Error{.code = make_error_code(errc::wait_failed), .context = "exit_handles"};
+  }
+  auto use = impl_->concurrent_use.enter("PipelineChild");
+  (void)use;
+
+  auto opened = open_exit_handles(*impl_);
+  if (!opened) {
+    return opened.error();
+  }
+
+  std::vector<int> fds;
+  fds.reserve(impl_->exit_handles.size() + impl_->functions.size());
+  for (const auto& handle : impl_->exit_handles) {
+    fds.push_back(handle.get());
+  }
+  for (const auto& function : impl_->functions) {
+    fds.push_back(function.done_handle());
+  }
+  return fds;
+}
+
+Result<std::vector<ProcessSample>> PipelineChild::sample() {
+  if (!impl_) {
+    return Error{.code = make_error_code(errc::invalid_argument), .context = "sample"};
+  }
+  auto use = impl_->concurrent_use.enter("PipelineChild");
+  (void)use;
+
+  impl_->stat_fds.resize(impl_->spawned.size());
+  std::vector<ProcessSample> samples;
+  samples.reserve(impl_->spawned.size());
+  for (std::size_t index = 0; index < impl_->spawned.size(); ++index) {
+    const auto& spawned = impl_->spawned[index];
+    if (spawned.terminal_result) {
+      continue;
+    }
+    auto& stat_fd = impl_->stat_fds[index];
+    if (!stat_fd) {
+      auto opened = internal::open_proc_stat(spawned.pid);
+      if (!opened) {
+        return opened.error();
+      }
+      stat_fd = std::move(opened.value());
+    }
+    auto sample = internal::read_proc_stat(stat_fd.get());
+    if (!sample) {
+      return sample.error();
+    }
+    samples.push_back(ProcessSample{.pid = spawned.pid, .sample = sample.value()});
+  }
+  return samples;
 }
 
 Result<void> PipelineChild::terminate() {
@@ -390,18 +1042,58 @@ Result<void> PipelineChild::kill() {
   }
   auto use = impl_->concurrent_use.enter("PipelineChild");
   (void)use;
+  return kill_stages(*impl_);
+}
 
-  if (impl_->new_process_group && !impl_->spawned.empty()) {
-    return internal::backend_for(impl_->spawned.front()).kill(impl_->spawned.front());
+Result<void> PipelineChild::kill_tree(std::optional<std::chrono::milliseconds> timeout) {
+  if (!impl_) {
+    return Error{.code = make_error_code(errc::kill_failed), .context = "kill_tree"};
   }
-
-  for (auto& spawned : impl_->spawned) {
-    auto result = internal::backend_for(spawned).kill(spawned);
-    if (!result) {
-      return result;
+  auto use = impl_->concurrent_use.enter("PipelineChild");
+  (void)use;
+#if PROCLY_PLATFORM_LINUX
+  std::vector<std::filesystem::path> cgroups;
+  bool every_stage_in_cgroup = true;
+  for (const auto& spawned : impl_->spawned) {
+    if (!spawned.cgroup) {
+      every_stage_in_cgroup = false;
+    } else if (std::find(cgroups.begin(), cgroups.end(), *spawned.cgroup) == cgroups.end()) {
+      cgroups.push_back(*spawned.cgroup);
+    }
+  }
+  for (const auto& cgroup : cgroups) {
+    auto killed = internal::cgroup_kill(cgroup);
+    if (!killed) {
+      return killed;
+    }
+  }
+  if (!every_stage_in_cgroup) {
+    auto killed = kill_stages(*impl_);
+    if (!killed) {
+      return killed;
+    }
+  }
+  std::optional<std::chrono::steady_clock::time_point> deadline;
+  if (timeout) {
+    deadline = std::chrono::steady_clock::now() + *timeout;
+  }
+  for (const auto& cgroup : cgroups) {
+    std::optional<std::chrono::milliseconds> left;
+    if (deadline) {
+      left = std::max(std::chrono::milliseconds(0),
+                      std::chrono::duration_cast<std::chrono::milliseconds>(
+                          *deadline - std::chrono::steady_clock::now()));
+    }
+    auto emptied = internal::cgroup_wait_empty(cgroup, left);
+    if (!emptied) {
+      return emptied;
     }
   }
   return {};
+#else
+  (void)timeout;
+  return kill_stages(*impl_);
+#endif
 }
 
 }  // namespace procly
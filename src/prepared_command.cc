@@ -0,0 +1,193 @@
+#include "procly/prepared_command.hpp"
+
+#include <fcntl.h>
+
+#include <cerrno>
+#include <filesystem>
+#include <utility>
+
+#include "procly/internal/access.hpp"
+#include "procly/internal/command_run.hpp"
+#include "procly/internal/exec_path.hpp"
+#include "procly/internal/lowering.hpp"
+
+namespace procly {
+
+Result<PreparedCommand> PreparedCommand::prepare(const Command& command) {
+  auto spawn_spec = internal::lower_command(command, internal::SpawnMode::spawn, nullptr);
+  if (!spawn_spec) {
+    return spawn_spec.error();
+  }
+  auto output_spec = internal::lower_command(command, internal::SpawnMode::output, nullptr);
+  if (!output_spec) {
+    return output_spec.error();
+  }
+
+  PreparedCommand prepared;
+  prepared.spawn_spec_ = std::move(spawn_spec.value());
+  prepared.output_spec_ = std::move(output_spec.value());
+  // Both specs share one environment block.
+  prepared.output_spec_.envp = prepared.spawn_spec_.envp;
+  prepared.backend_ = internal::CommandAccess::backend(command);
+
+  const auto& spec = prepared.spawn_spec_;
+  std::string resolved;
+  if (auto cached = internal::cached_exec_path(spec.argv.front(), spec.envp, spec.cwd,
+                                               spec.opts.path_lookup, spec.cwd_fd)) {
+    resolved = std::move(*cached);
+  } else {
+    resolved = internal::resolve_exec_path(spec.argv.front(), spec.envp, spec.cwd, spec.cwd_fd);
+  }
+  // An unresolved bare name keeps the per-spawn search, so it fails the same way Command does.
+  if (resolved.find('/') != std::string::npos) {
+    prepared.spawn_spec_.exec_path = resolved;
+    prepared.output_spec_.exec_path = std::move(resolved);
+  }
+  return prepared;
+}
+
+std::string_view PreparedCommand::executable() const noexcept {
+  if (spawn_spec_.exec_path) {
+    return *spawn_spec_.exec_path;
+  }
+  return spawn_spec_.argv.front();
+}
+
+Result<void> PreparedCommand::set_arg(std::size_t index, std::string_view value) {
+  auto use = concurrent_use_.enter("PreparedCommand");
+  (void)use;
+  if (index == 0 || index >= spawn_spec_.argv.size()) {
+    return Error{.code = make_error_code(errc::invalid_argument), .context = "set_arg"};
+  }
+  // assign() reuses the slot's capacity, so same-or-shorter values do not allocate.
+  spawn_spec_.argv[index].assign(value);
+  output_spec_.argv[index].assign(value);
+  return {};
+}
+
+Result<void> PreparedCommand::pin_executable() {
+  auto use = concurrent_use_.enter("PreparedCommand");
+  (void)use;
+#if PROCLY_PLATFORM_LINUX
+  if (!spawn_spec_.exec_path) {
+    return Error{.code = std::error_code(ENOENT, std::system_category()),
+                 .context = "pin_executable"};
+  }
+  // A relative exec_path is relative to the child's working directory.
+  std::filesystem::path path(*spawn_spec_.exec_path);
+  int dir_fd = AT_FDCWD;
+  if (path.is_relative()) {
+    if (spawn_spec_.cwd_fd) {
+      dir_fd = *spawn_spec_.cwd_fd;
+    } else if (spawn_spec_.cwd) {
+      path = *spawn_spec_.cwd / path;
+    }
+  }
+  internal::unique_fd file(::openat(dir_fd, path.c_str(), O_PATH | O_CLOEXEC));
+  if (!file) {
+    return Error{.code = std::error_code(errno, std::system_category()),
+                 .context = "open(executable)"};
+  }
+  executable_fd_ = std::make_shared<const internal::unique_fd>(std::move(file));
+  spawn_spec_.exec_fd = executable_fd_->get();
+  output_spec_.exec_fd = executable_fd_->get();
+  return {};
+#else
+  return Error{.code = std::make_error_code(std::errc::not_supported),
+               .context = "pin_executable"};
+#endif
+}
+
+Result<Child> PreparedCommand::spawn() const {
+  auto use = concurrent_use_.enter("PreparedCommand");
+  (void)use;
+  auto spawned = internal::spawn_lowered(spawn_spec_, backend_);
+  if (!spawned) {
+    return spawned.error();
+  }
+  return internal::ChildAccess::from_spawned(spawned.value());
+}
+
+Result<ExitStatus> PreparedCommand::status() const {
+  auto use = concurrent_use_.enter("PreparedCommand");
+  (void)use;
+  auto spawned = internal::spawn_lowered(spawn_spec_, backend_);
+  if (!spawned) {
+    return spawned.error();
+  }
+  Child child = internal::ChildAccess::from_spawned(spawned.value());
+  return internal::finish_status(child);
+}
+
+Result<Output> PreparedCommand::output() const { return output(CaptureOptions{}); }
+
+Result<Output> PreparedCommand::output(const CaptureOptions& options) const {
+  auto use = concurrent_use_.enter("PreparedCommand");
+  (void)use;
+  auto spawned = internal::spawn_lowered(output_spec_, backend_);
+  if (!spawned) {
+    return spawned.error();
+  }
+  Child child = internal::ChildAccess::from_spawned(spawned.value());
+  return internal::finish_output(child, options);
+}
+
+Result<ExitStatus> PreparedCommand::output_into(std::string& stdout_data,
+                                      std::string& stderr_data) const {
+  auto use = concurrent_use_.enter("PreparedCommand");
+  (void)use;
+  auto spawned = internal::spawn_lowered(output_spec_, backend_);
+  if (!spawned) {
+    return spawned.error();
+  }
+  Child child = internal::ChildAccess::from_spawned(spawned.value());
+  return internal::finish_output_into(child, stdout_data, stderr_data);
+}
+
+Result<ChunkedOutput> PreparedCommand::output_chunked() const {
+  auto use = concurrent_use_.enter("PreparedCommand");
+  (void)use;
+  auto spawned = internal::spawn_lowered(output_spec_, backend_);
+  if (!spawned) {
+    return spawned.error();
+  }
+  Child child = internal::ChildAccess::from_spawned(spawned.value());
+  return internal::finish_output_chunked(child);
+}
+
+Result<ExitStatus> PreparedCommand::output(OutputSink stdout_sink, OutputSink stderr_sink) const {
+  auto use = concurrent_use_.enter("PreparedCommand");
+  (void)use;
+  auto spawned = internal::spawn_lowered(output_spec_, backend_);
+  if (!spawned) {
+    return spawned.error();
+  }
+  Child child = internal::ChildAccess::from_spawned(spawned.value());
+  return internal::finish_stream(child, stdout_sink, stderr_sink);
+}
+
+Child PreparedCommand::spawn_or_throw() const {
+  auto result = spawn();
+  if (!result) {
+    internal::throw_error(result.error());
+  }
+  return std::move(result.value());
+}
+
+ExitStatus PreparedCommand::status_or_throw() const {
+  auto result = status();
+  if (!result) {
+    internal::throw_error(result.error());
+  }
+  return result.value();
+}
+
+Output PreparedCommand::output_or_throw() const {
+  auto result = output();
+  if (!result) {
+    internal::throw_error(result.error());
+  }
+  return std::move(result.value());
+}
+
+}  // namespace procly
@@ -0,0 +1,421 @@
+#include "procly/process_graph.hpp"
+
+#include <fcntl.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <utility>
+
+#include "procly/internal/access.hpp"
+#include "procly/internal/backend.hpp"
+#include "procly/internal/fd.hpp"
+#include "procly/internal/function_stage_run.hpp"
+#include "procly/internal/lowering.hpp"
+
+namespace procly {
+
+bool GraphStatus::success() const noexcept {
+  return !fan_out_error &&
+         std::all_of(nodes.begin(), nodes.end(), [](const ExitStatus& status) {
+           return status.success();
+         });
+}
+
+ProcessGraph::NodeId ProcessGraph::add(Command command) {
+  auto use = concurrent_use_.enter("ProcessGraph");
+  (void)use;
+  nodes_.push_back(std::move(command));
+  return nodes_.size() - 1;
+}
+
+ProcessGraph& ProcessGraph::connect(NodeId from, NodeId to) {
+  auto use = concurrent_use_.enter("ProcessGraph");
+  (void)use;
+  edges_.emplace_back(from, to);
+  return *this;
+}
+
+ProcessGraph& ProcessGraph::pipe_capacity(std::size_t bytes) {
+  auto use = concurrent_use_.enter("ProcessGraph");
+  (void)use;
+  pipe_capacity_ = bytes;
+  return *this;
+}
+
+struct ProcessGraphChild::Impl {
+  std::vector<internal::Spawned> spawned;
+  std::vector<std::optional<PipeWriter>> stdin_pipes;
+  std::vector<std::optional<PipeReader>> stdout_pipes;
+  std::vector<std::optional<PipeReader>> stderr_pipes;
+  // One tee/splice copier per extra consumer of a fanned-out stream.
+  std::vector<internal::FunctionStageRun> copiers;
+  internal::ConcurrentUseGuard concurrent_use;
+};
+
+namespace {
+
+Error graph_error(const char* context) {
+  return Error{.code = make_error_code(errc::invalid_pipeline), .context = context};
+}
+
+// Reject bad ids, self-loops, duplicate edges and cycles; returns each node's consumers.
+Result<std::vector<std::vector<std::size_t>>> graph_consumers(
+    std::size_t node_count, const std::vector<std::pair<std::size_t, std::size_t>>& edges) {
+  if (node_count == 0) {
+    return graph_error("graph");
+  }
+  std::vector<std::vector<std::size_t>> consumers(node_count);
+  std::vector<std::size_t> in_degree(node_count, 0);
+  for (auto [from, to] : edges) {
+    if (from >= node_count || to >= node_count || from == to ||
+        std::find(consumers[from].begin(), consumers[from].end(), to) != consumers[from].end()) {
+      return graph_error("graph_edge");
+    }
+    consumers[from].push_back(to);
+    ++in_degree[to];
+  }
+
+  std::vector<std::size_t> ready;
+  for (std::size_t node = 0; node < node_count; ++node) {
+    if (in_degree[node] == 0) {
+      ready.push_back(node);
+    }
+  }
+  std::size_t ordered = 0;
+  while (!ready.empty()) {
+    std::size_t node = ready.back();
+    ready.pop_back();
+    ++ordered;
+    for (std::size_t consumer : consumers[node]) {
+      if (--in_degree[consumer] == 0) {
+        ready.push_back(consumer);
+      }
+    }
+  }
+  if (ordered != node_count) {
+    return graph_error("graph_cycle");
+  }
+  return consumers;
+}
+
+Result<internal::unique_fd> duplicate_fd(int fd) {
+  internal::unique_fd copy(::fcntl(fd, F_DUPFD_CLOEXEC, 0));
+  if (!copy) {
+    return Error{.code = std::error_code(errno, std::system_category()), .context = "dup"};
+  }
+  return copy;
+}
+
+// Copier for one extra consumer: duplicates in onto tee and moves the same bytes to out.
+struct CopierLaunch {
+  internal::unique_fd in;
+  internal::unique_fd tee;
+  internal::unique_fd out;
+};
+
+void cleanup_spawned(std::vector<internal::Spawned>& spawned) {
+  for (auto& node : spawned) {
+    (void)internal::backend_for(node).kill(node);
+  }
+  for (auto& node : spawned) {
+    (void)internal::backend_for(node).wait(node, std::nullopt, std::chrono::milliseconds(0));
+  }
+}
+
+}  // namespace
+
+Result<ProcessGraphChild> ProcessGraph::spawn() const {
+  auto use = concurrent_use_.enter("ProcessGraph");
+  (void)use;
+
+  const std::size_t node_count = nodes_.size();
+  auto consumers = graph_consumers(node_count, edges_);
+  if (!consumers) {
+    return consumers.error();
+  }
+
+  // One input pipe per node with producers; fanned-in producers share its write end.
+  std::vector<std::pair<internal::unique_fd, internal::unique_fd>> inputs(node_count);
+  for (auto [from, to] : edges_) {
+    (void)from;
+    if (inputs[to].first) {
+      continue;
+    }
+    auto pipe = internal::create_pipe(pipe_capacity_);
+    if (!pipe) {
+      return pipe.error();
+    }
+    inputs[to] = std::move(pipe.value());
+  }
+
+  // A single consumer gets the producer's stdout directly. k consumers get a chain of k - 1
+  // copiers: each tees its input to one consumer and moves it on to the next copier.
+  std::vector<internal::unique_fd> outputs(node_count);
+  std::vector<CopierLaunch> copiers;
+  for (std::size_t node = 0; node < node_count; ++node) {
+    const auto& targets = consumers.value()[node];
+    if (targets.size() < 2) {
+      continue;
+    }
+    auto source = internal::create_pipe(pipe_capacity_);
+    if (!source) {
+      return source.error();
+    }
+    outputs[node] = std::move(source->second);
+    internal::unique_fd upstream = std::move(source->first);
+    for (std::size_t index = 0; index + 1 < targets.size(); ++index) {
+      CopierLaunch launch{.in = std::move(upstream)};
+      auto tee = duplicate_fd(inputs[targets[index]].second.get());
+      if (!tee) {
+        return tee.error();
+      }
+      launch.tee = std::move(tee.value());
+      if (index + 2 == targets.size()) {
+        auto out = duplicate_fd(inputs[targets.back()].second.get());
+        if (!out) {
+          return out.error();
+        }
+        launch.out = std::move(out.value());
+      } else {
+        auto next = internal::create_pipe(pipe_capacity_);
+        if (!next) {
+          return next.error();
+        }
+        launch.out = std::move(next->second);
+        upstream = std::move(next->first);
+      }
+      copiers.push_back(std::move(launch));
+    }
+  }
+
+  std::vector<internal::SpawnSpec> specs;
+  specs.reserve(node_count);
+  std::optional<internal::EnvBlock> live_env;
+  for (std::size_t node = 0; node < node_count; ++node) {
+    internal::StdioOverride overrides;
+    if (inputs[node].first) {
+      overrides.stdin_override = Stdio::fd(inputs[node].first.get());
+    }
+    const auto& targets = consumers.value()[node];
+    if (targets.size() == 1) {
+      overrides.stdout_override = Stdio::fd(inputs[targets.front()].second.get());
+    } else if (outputs[node]) {
+      overrides.stdout_override = Stdio::fd(outputs[node].get());
+    }
+    auto spec = internal::lower_command(nodes_[node], internal::SpawnMode::spawn, &overrides,
+                                        &live_env);
+    if (!spec) {
+      return spec.error();
+    }
+    specs.push_back(std::move(spec.value()));
+  }
+
+  std::vector<internal::Spawned> spawned;
+  spawned.reserve(node_count);
+  for (std::size_t node = 0; node < node_count; ++node) {
+    auto* backend = internal::CommandAccess::backend(nodes_[node]);
+    if (backend == nullptr) {
+      backend = &internal::default_backend();
+    }
+    auto result = backend->spawn(specs[node]);
+    if (!result) {
+      cleanup_spawned(spawned);
+      return result.error();
+    }
+    result->backend = backend;
+    spawned.push_back(std::move(result.value()));
+  }
+  // Copiers and children must hold the only write ends, or consumers never see EOF.
+  inputs.clear();
+  outputs.clear();
+
+  auto impl = std::make_unique<ProcessGraphChild::Impl>();
+  impl->copiers.reserve(copiers.size());
+  for (auto& launch : copiers) {
+    auto tee = std::make_shared<PipeWriter>(launch.tee.release());
+    auto run = internal::FunctionStageRun::start(
+        [tee](PipeReader& in, PipeWriter& out) -> Result<void> {
+          auto moved = in.transfer_to(out.native_handle(), *tee);
+          tee->close();
+          if (!moved) {
+            return moved.error();
+          }
+          return {};
+        },
+        std::move(launch.in), std::move(launch.out), impl->copiers.size());
+    if (!run) {
+      cleanup_spawned(spawned);
+      return run.error();
+    }
+    impl->copiers.push_back(std::move(run.value()));
+  }
+
+  impl->stdin_pipes.resize(node_count);
+  impl->stdout_pipes.resize(node_count);
+  impl->stderr_pipes.resize(node_count);
+  for (std::size_t node = 0; node < node_count; ++node) {
+    if (spawned[node].stdin_fd) {
+      impl->stdin_pipes[node].emplace(*spawned[node].stdin_fd);
+    }
+    if (spawned[node].stdout_fd) {
+      impl->stdout_pipes[node].emplace(*spawned[node].stdout_fd);
+    }
+    if (spawned[node].stderr_fd) {
+      impl->stderr_pipes[node].emplace(*spawned[node].stderr_fd);
+    }
+  }
+  impl->spawned = std::move(spawned);
+  return ProcessGraphChild(std::move(impl));
+}
+
+Result<GraphStatus> ProcessGraph::status() const {
+  auto child = spawn();
+  if (!child) {
+    return child.error();
+  }
+  for (std::size_t node = 0; node < nodes_.size(); ++node) {
+    (void)child->take_stdin(node);
+    (void)child->take_stdout(node);
+    (void)child->take_stderr(node);
+  }
+  return child->wait();
+}
+
+ProcessGraphChild::ProcessGraphChild() = default;
+
+ProcessGraphChild::ProcessGraphChild(std::unique_ptr<Impl> impl) : impl_(std::move(impl)) {}
+
+ProcessGraphChild::ProcessGraphChild(ProcessGraphChild&& other) noexcept {
+  if (other.impl_) {
+    auto use = other.impl_->concurrent_use.enter("ProcessGraphChild");
+    (void)use;
+    impl_ = std::move(other.impl_);
+  }
+}
+
+ProcessGraphChild& ProcessGraphChild::operator=(ProcessGraphChild&& other) noexcept {
+  if (this == &other) {
+    return *this;
+  }
+  if (other.impl_) {
+    auto other_use = other.impl_->concurrent_use.enter("ProcessGraphChild");
+    (void)other_use;
+  }
+  impl_ = std::move(other.impl_);
+  return *this;
+}
+
+ProcessGraphChild::~ProcessGraphChild() {
+  if (!impl_) {
+    return;
+  }
+  for (auto& node : impl_->spawned) {
+    if (node.pid > 0 && !node.terminal_result) {
+      internal::backend_for(node).abandon(node);
+    }
+  }
+}
+
+std::optional<PipeWriter> ProcessGraphChild::take_stdin(ProcessGraph::NodeId node) noexcept {
+  if (!impl_ || node >= impl_->stdin_pipes.size()) {
+    return std::nullopt;
+  }
+  auto use = impl_->concurrent_use.enter("ProcessGraphChild");
+  (void)use;
+  auto pipe = std::move(impl_->stdin_pipes[node]);
+  impl_->stdin_pipes[node].reset();
+  return pipe;
+}
+
+std::optional<PipeReader> ProcessGraphChild::take_stdout(ProcessGraph::NodeId node) noexcept {
+  if (!impl_ || node >= impl_->stdout_pipes.size()) {
+    return std::nullopt;
+  }
+  auto use = impl_->concurrent_use.enter("ProcessGraphChild");
+  (void)use;
+  auto pipe = std::move(impl_->stdout_pipes[node]);
+  impl_->stdout_pipes[node].reset();
+  return pipe;
+}
+
+std::optional<PipeReader> ProcessGraphChild::take_stderr(ProcessGraph::NodeId node) noexcept {
+  if (!impl_ || node >= impl_->stderr_pipes.size()) {
+    return std::nullopt;
+  }
+  auto use = impl_->concurrent_use.enter("ProcessGraphChild");
+  (void)use;
+  auto pipe = std::move(impl_->stderr_pipes[node]);
+  impl_->stderr_pipes[node].reset();
+  return pipe;
+}
+
+Result<GraphStatus> ProcessGraphChild::wait() {
+  if (!impl_) {
+    return Error{.code = make_error_code(errc::wait_failed), .context = "wait"};
+  }
+  auto use = impl_->concurrent_use.enter("ProcessGraphChild");
+  (void)use;
+
+  GraphStatus status;
+  status.nodes.reserve(impl_->spawned.size());
+  status.node_usage.reserve(impl_->spawned.size());
+  for (auto& node : impl_->spawned) {
+    auto waited =
+        internal::backend_for(node).wait(node, std::nullopt, std::chrono::milliseconds(0));
+    if (!waited) {
+      return waited.error();
+    }
+    status.nodes.push_back(waited->status);
+    status.node_usage.push_back(waited->usage);
+  }
+  for (auto& copier : impl_->copiers) {
+    auto copied = copier.join();
+    if (copied.error && !status.fan_out_error) {
+      status.fan_out_error = copied.error;
+    }
+  }
+  return status;
+}
+
+namespace {
+
+Result<void> signal_nodes(ProcessGraphChild::Impl& impl, bool force) {
+  std::optional<Error> first_error;
+  for (auto& node : impl.spawned) {
+    if (node.terminal_result) {
+      continue;
+    }
+    auto& backend = internal::backend_for(node);
+    auto result = force ? backend.kill(node) : backend.terminate(node);
+    if (!result && !first_error) {
+      first_error = result.error();
+    }
+  }
+  if (first_error) {
+    return *first_error;
+  }
+  return {};
+}
+
+}  // namespace
+
+Result<void> ProcessGraphChild::terminate() {
+  if (!impl_) {
+    return Error{.code = make_error_code(errc::kill_failed), .context = "terminate"};
+  }
+  auto use = impl_->concurrent_use.enter("ProcessGraphChild");
+  (void)use;
+  return signal_nodes(*impl_, false);
+}
+
+Result<void> ProcessGraphChild::kill() {
+  if (!impl_) {
+    return Error{.code = make_error_code(errc::kill_failed), .context = "kill"};
+  }
+  auto use = impl_->concurrent_use.enter("ProcessGraphChild");
+  (void)use;
+  return signal_nodes(*impl_, true);
+}
+
+}  // namespace procly
@@ -0,0 +1,783 @@
+#include "procly/reactor.hpp"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "procly/internal/clock.hpp"
+#include "procly/internal/deadline_queue.hpp"
+#include "procly/internal/fd.hpp"
+#include "procly/internal/poller.hpp"
+
+namespace procly {
+
+namespace {
+
+using Interest = internal::Poller::Interest;
+using TimePoint = std::chrono::steady_clock::time_point;
+
+constexpr std::size_t kBufferSize = 8192;
+// Children whose backend offers no exit handle are polled with try_wait at this interval.
+constexpr std::chrono::milliseconds kFallbackTick{10};
+
+enum class Role : std::uint8_t { stdin_pipe, stdout_pipe, stderr_pipe, exit, readiness };
+
+Interest interest_for(Role role) {
+  return role == Role::stdin_pipe ? Interest::writable : Interest::readable;
+}
+
+bool has_errno(const Error& error, int value) {
+  return error.code.category() == std::system_category() && error.code.value() == value;
+}
+
+class Watched;
+
+// A pending timeout: a watched child's next escalation step, or a readiness waiter (by fd).
+struct Timer {
+  Watched* watched = nullptr;
+  int fd = -1;
+};
+
+using TimerQueue = internal::DeadlineQueue<Timer>;
+
+// One supervised Child or PipelineChild plus its I/O and timeout state.
+class Watched {
+ public:
+  Watched() = default;
+  Watched(const Watched&) = delete;
+  Watched& operator=(const Watched&) = delete;
+  Watched(Watched&&) = delete;
+  Watched& operator=(Watched&&) = delete;
+  virtual ~Watched() = default;
+
+  // Reap without blocking; true once the child (every stage) has exited.
+  virtual Result<bool> try_reap() = 0;
+  virtual Result<std::vector<int>> exit_handles() = 0;
+  virtual Result<void> terminate() = 0;
+  virtual Result<void> kill() = 0;
+  // Kill and reap synchronously; used when supervision is abandoned.
+  virtual void abandon() = 0;
+  virtual void complete() = 0;
+  // Append samples of the processes still running; failures leave them out.
+  virtual void sample(std::vector<ProcessSample>* out) = 0;
+
+  std::optional<PipeWriter> stdin_pipe;
+  std::optional<PipeReader> stdout_pipe;
+  std::optional<PipeReader> stderr_pipe;
+  std::string stdin_data;
+  std::size_t stdin_offset = 0;
+  std::string stdout_data;
+  std::string stderr_data;
+
+  std::vector<int> exit_fds;
+  bool polls_exit = false;
+  bool reaped = false;
+  std::optional<Error> error;
+
+  // Position in watch() order, so completions due together are delivered in that order.
+  std::uint64_t order = 0;
+  // Set while the child has had activity this iteration and may have finished.
+  bool touched = false;
+
+  std::optional<TimerQueue::Handle> timer;
+  std::chrono::milliseconds kill_grace{WaitOptions::kDefaultKillGrace};
+  bool timed_out = false;
+  bool sent_terminate = false;
+  bool sent_kill = false;
+
+  [[nodiscard]] bool finished() const {
+    return reaped && !stdin_pipe && !stdout_pipe && !stderr_pipe;
+  }
+};
+
+class WatchedChild final : public Watched {
+ public:
+  WatchedChild(Child child, Reactor::ChildCallback on_complete)
+      : child_(std::move(child)), on_complete_(std::move(on_complete)) {
+    stdin_pipe = child_.take_stdin();
+    stdout_pipe = child_.take_stdout();
+    stderr_pipe = child_.take_stderr();
+  }
+
+  Result<bool> try_reap() override {
+    auto status = child_.try_wait();
+    if (!status) {
+      return status.error();
+    }
+    if (!status.value().has_value()) {
+      return false;
+    }
+    status_ = *status.value();
+    return true;
+  }
+
+  Result<std::vector<int>> exit_handles() override {
+    auto handle = child_.exit_handle();
+    if (!handle) {
+      return handle.error();
+    }
+    return std::vector<int>{handle.value()};
+  }
+
+  Result<void> terminate() override { return child_.terminate(); }
+  Result<void> kill() override { return child_.kill(); }
+
+  void abandon() override {
+    (void)child_.kill();
+    (void)child_.wait();
+  }
+
+  void sample(std::vector<ProcessSample>* out) override {
+    auto sample = child_.sample();
+    if (sample) {
+      out->push_back(ProcessSample{.pid = child_.id(), .sample = sample.value()});
+    }
+  }
+
+  void complete() override {
+    if (error) {
+      on_complete_(*error);
+      return;
+    }
+    ChildCompletion completion;
+    completion.wait.status = status_;
+    completion.wait.timed_out = timed_out;
+    completion.wait.sent_terminate = sent_terminate;
+    completion.wait.sent_kill = sent_kill;
+    completion.stdout_data = std::move(stdout_data);
+    completion.stderr_data = std::move(stderr_data);
+    on_complete_(std::move(completion));
+  }
+
+ private:
+  Child child_;
+  Reactor::ChildCallback on_complete_;
+  ExitStatus status_;
+};
+
+class WatchedPipeline final : public Watched {
+ public:
+  WatchedPipeline(PipelineChild child, Reactor::PipelineCallback on_complete)
+      : child_(std::move(child)), on_complete_(std::move(on_complete)) {
+    stdin_pipe = child_.take_stdin();
+    stdout_pipe = child_.take_stdout();
+    stderr_pipe = child_.take_stderr();
+  }
+
+  Result<bool> try_reap() override {
+    auto status = child_.try_wait();
+    if (!status) {
+      return status.error();
+    }
+    if (!status.value().has_value()) {
+      return false;
+    }
+    status_ = std::move(*status.value());
+    return true;
+  }
+
+  Result<std::vector<int>> exit_handles() override { return child_.exit_handles(); }
+  Result<void> terminate() override { return child_.terminate(); }
+  Result<void> kill() override { return child_.kill(); }
+
+  void abandon() override {
+    (void)child_.kill();
+    (void)child_.wait();
+  }
+
+  void sample(std::vector<ProcessSample>* out) override {
+    auto samples = child_.sample();
+    if (samples) {
+      out->insert(out->end(), samples->begin(), samples->end());
+    }
+  }
+
+  void complete() override {
+    if (error) {
+      on_complete_(*error);
+      return;
+    }
+    PipelineCompletion completion;
+    completion.status = std::move(status_);
+    completion.timed_out = timed_out;
+    completion.sent_terminate = sent_terminate;
+    completion.sent_kill = sent_kill;
+    completion.stdout_data = std::move(stdout_data);
+    completion.stderr_data = std::move(stderr_data);
+    on_complete_(std::move(completion));
+  }
+
+ private:
+  PipelineChild child_;
+  Reactor::PipelineCallback on_complete_;
+  PipelineStatus status_;
+};
+
+}  // namespace
+
+struct Reactor::Impl {
+  struct Registration {
+    Watched* watched;
+    Role role;
+  };
+
+  struct Waiter {
+    std::optional<TimerQueue::Handle> timer;
+    std::function<void(bool)> on_ready;
+  };
+
+  explicit Impl(internal::Poller poller) : poller(std::move(poller)) {}
+  Impl(const Impl&) = delete;
+  Impl& operator=(const Impl&) = delete;
+  Impl(Impl&&) = delete;
+  Impl& operator=(Impl&&) = delete;
+
+  ~Impl() {
+    for (const auto& [fd, waiter] : waiters) {
+      (void)waiter;
+      unregister(fd, Role::readiness);
+    }
+    for (auto& [key, watched] : entries) {
+      (void)key;
+      unregister_all(*watched);
+      watched->abandon();
+    }
+  }
+
+  Result<void> add(int fd, Watched* watched, Role role) {
+    auto added = poller.add(fd, interest_for(role));
+    if (!added) {
+      return added.error();
+    }
+    registrations.emplace(fd, Registration{.watched = watched, .role = role});
+    return {};
+  }
+
+  void unregister(int fd, Role role) {
+    if (registrations.erase(fd) > 0) {
+      (void)poller.remove(fd, interest_for(role));
+    }
+  }
+
+  void close_stdin(Watched& watched) {
+    if (watched.stdin_pipe) {
+      unregister(watched.stdin_pipe->native_handle(), Role::stdin_pipe);
+      watched.stdin_pipe.reset();
+    }
+  }
+
+  void close_output(Watched& watched, Role role) {
+    auto& pipe = role == Role::stdout_pipe ? watched.stdout_pipe : watched.stderr_pipe;
+    if (pipe) {
+      unregister(pipe->native_handle(), role);
+      pipe.reset();
+    }
+  }
+
+  void unregister_all(Watched& watched) {
+    close_stdin(watched);
+    close_output(watched, Role::stdout_pipe);
+    close_output(watched, Role::stderr_pipe);
+    for (int fd : watched.exit_fds) {
+      unregister(fd, Role::exit);
+    }
+    watched.exit_fds.clear();
+    disarm(watched);
+  }
+
+  void arm(Watched& watched, TimePoint when) {
+    disarm(watched);
+    watched.timer = timers.schedule(when, Timer{.watched = &watched});
+  }
+
+  void disarm(Watched& watched) {
+    if (watched.timer) {
+      timers.cancel(*watched.timer);
+      watched.timer.reset();
+    }
+  }
+
+  // Queue watched for the finished() check at the end of this iteration.
+  void touch(Watched& watched) {
+    if (!watched.touched) {
+      watched.touched = true;
+      touched.push_back(&watched);
+    }
+  }
+
+  // Record the first error, stop all I/O, and kill the child so the exit path completes it.
+  void fail(Watched& watched, Error error) {
+    if (!watched.error) {
+      watched.error = std::move(error);
+    }
+    close_stdin(watched);
+    close_output(watched, Role::stdout_pipe);
+    close_output(watched, Role::stderr_pipe);
+    if (!watched.reaped) {
+      (void)watched.kill();
+    }
+  }
+
+  void reap(Watched& watched) {
+    auto reaped = watched.try_reap();
+    if (!reaped) {
+      // The child can no longer be waited for; report instead of spinning on it.
+      watched.reaped = true;
+      disarm(watched);
+      touch(watched);
+      fail(watched, reaped.error());
+      return;
+    }
+    if (reaped.value()) {
+      watched.reaped = true;
+      disarm(watched);
+      touch(watched);
+      close_stdin(watched);
+    }
+  }
+
+  Result<void> start(std::unique_ptr<Watched> watched, WatchOptions options) {
+    Watched& entry = *watched;
+    entry.stdin_data = std::move(options.stdin_data);
+    entry.kill_grace = options.kill_grace;
+    entry.order = next_order++;
+
+    auto registered = register_fds(entry);
+    if (!registered) {
+      unregister_all(entry);
+      entry.abandon();
+      return registered.error();
+    }
+    if (options.timeout) {
+      arm(entry, internal::default_clock().now() + *options.timeout);
+    }
+    if (entry.polls_exit) {
+      polled.push_back(&entry);
+    }
+    entries.emplace(&entry, std::move(watched));
+    return {};
+  }
+
+  Result<void> register_fds(Watched& entry) {
+    if (entry.stdin_pipe && entry.stdin_data.empty()) {
+      entry.stdin_pipe.reset();
+    }
+    if (entry.stdin_pipe) {
+      int fd = entry.stdin_pipe->native_handle();
+      auto nonblocking = internal::set_nonblocking(fd);
+      if (!nonblocking) {
+        return nonblocking.error();
+      }
+      auto added = add(fd, &entry, Role::stdin_pipe);
+      if (!added) {
+        return added.error();
+      }
+    }
+    for (Role role : {Role::stdout_pipe, Role::stderr_pipe}) {
+      auto& pipe = role == Role::stdout_pipe ? entry.stdout_pipe : entry.stderr_pipe;
+      if (!pipe) {
+        continue;
+      }
+      int fd = pipe->native_handle();
+      auto nonblocking = internal::set_nonblocking(fd);
+      if (!nonblocking) {
+        return nonblocking.error();
+      }
+      auto added = add(fd, &entry, role);
+      if (!added) {
+        return added.error();
+      }
+    }
+
+    auto handles = entry.exit_handles();
+    if (!handles) {
+      if (handles.error().code != std::make_error_code(std::errc::not_supported)) {
+        return handles.error();
+      }
+      entry.polls_exit = true;
+      return {};
+    }
+    for (int fd : handles.value()) {
+      auto added = add(fd, &entry, Role::exit);
+      if (!added) {
+        return added.error();
+      }
+      entry.exit_fds.push_back(fd);
+    }
+    return {};
+  }
+
+  void feed_stdin(Watched& watched) {
+    while (watched.stdin_offset < watched.stdin_data.size()) {
+      auto written = watched.stdin_pipe->write_some(watched.stdin_data.data() + watched.stdin_offset,
+                                                    watched.stdin_data.size() - watched.stdin_offset);
+      if (!written) {
+        if (has_errno(written.error(), EAGAIN) || has_errno(written.error(), EWOULDBLOCK)) {
+          return;
+        }
+        if (!has_errno(written.error(), EPIPE)) {
+          fail(watched, written.error());
+          return;
+        }
+        // The child stopped reading; the rest of its input is dropped.
+        break;
+      }
+      watched.stdin_offset += written.value();
+    }
+    close_stdin(watched);
+  }
+
+  void drain_output(Watched& watched, Role role) {
+    auto& pipe = role == Role::stdout_pipe ? watched.stdout_pipe : watched.stderr_pipe;
+    auto& out = role == Role::stdout_pipe ? watched.stdout_data : watched.stderr_data;
+    std::array<char, kBufferSize> buffer{};
+    while (true) {
+      auto count = pipe->read_some(buffer.data(), buffer.size());
+      if (!count) {
+        if (has_errno(count.error(), EAGAIN) || has_errno(count.error(), EWOULDBLOCK)) {
+          return;
+        }
+        fail(watched, count.error());
+        return;
+      }
+      if (count.value() == 0) {
+        close_output(watched, role);
+        return;
+      }
+      out.append(buffer.data(), count.value());
+    }
+  }
+
+  Result<void> add_waiter(int fd, std::optional<TimePoint> deadline,
+                          std::function<void(bool)> on_ready) {
+    auto added = add(fd, nullptr, Role::readiness);
+    if (!added) {
+      return added.error();
+    }
+    Waiter waiter{.timer = std::nullopt, .on_ready = std::move(on_ready)};
+    if (deadline) {
+      waiter.timer = timers.schedule(*deadline, Timer{.fd = fd});
+    }
+    waiters.emplace(fd, std::move(waiter));
+    return {};
+  }
+
+  void fire_waiter(int fd, bool ready, std::vector<std::function<void()>>* fired) {
+    auto it = waiters.find(fd);
+    if (it == waiters.end()) {
+      return;
+    }
+    unregister(fd, Role::readiness);
+    if (it->second.timer) {
+      timers.cancel(*it->second.timer);
+    }
+    fired->push_back([on_ready = std::move(it->second.on_ready), ready]() { on_ready(ready); });
+    waiters.erase(it);
+  }
+
+  void on_ready(int fd, std::vector<std::function<void()>>* fired) {
+    auto it = registrations.find(fd);
+    if (it == registrations.end()) {
+      return;
+    }
+    Registration registration = it->second;
+    if (registration.role == Role::readiness) {
+      fire_waiter(fd, true, fired);
+      return;
+    }
+    Watched& watched = *registration.watched;
+    touch(watched);
+    switch (registration.role) {
+      case Role::readiness:
+        break;
+      case Role::stdin_pipe:
+        feed_stdin(watched);
+        break;
+      case Role::stdout_pipe:
+      case Role::stderr_pipe:
+        drain_output(watched, registration.role);
+        break;
+      case Role::exit:
+        // Exit handles stay readable; drop this one so it does not fire again.
+        unregister(fd, Role::exit);
+        watched.exit_fds.erase(std::remove(watched.exit_fds.begin(), watched.exit_fds.end(), fd),
+                               watched.exit_fds.end());
+        if (!watched.reaped) {
+          reap(watched);
+        }
+        break;
+    }
+  }
+
+  // The child's timer fired: terminate it, or kill it once the grace period is over too.
+  void expire(Watched& watched, TimePoint now) {
+    watched.timer.reset();
+    touch(watched);
+    if (watched.reaped) {
+      return;
+    }
+    watched.timed_out = true;
+    if (!watched.sent_terminate) {
+      auto terminated = watched.terminate();
+      if (terminated) {
+        watched.sent_terminate = true;
+        arm(watched, now + watched.kill_grace);
+        return;
+      }
+      if (!has_errno(terminated.error(), ESRCH)) {
+        fail(watched, terminated.error());
+      }
+      return;
+    }
+    auto killed = watched.kill();
+    if (killed) {
+      watched.sent_kill = true;
+    } else if (!has_errno(killed.error(), ESRCH)) {
+      fail(watched, killed.error());
+    }
+  }
+
+  void fire_timers(TimePoint now, std::vector<std::function<void()>>* fired) {
+    while (auto timer = timers.pop_due(now)) {
+      if (timer->watched != nullptr) {
+        expire(*timer->watched, now);
+        continue;
+      }
+      auto it = waiters.find(timer->fd);
+      if (it != waiters.end()) {
+        it->second.timer.reset();
+        fire_waiter(timer->fd, false, fired);
+      }
+    }
+  }
+
+  // Only the earliest deadline matters, whatever the number of pending timers.
+  std::optional<std::chrono::milliseconds> poll_budget(
+      std::optional<std::chrono::milliseconds> timeout, TimePoint now) const {
+    std::optional<std::chrono::milliseconds> budget = timeout;
+    auto shrink = [&](std::chrono::milliseconds value) {
+      budget = budget ? std::min(*budget, value) : value;
+    };
+    if (auto next = timers.next()) {
+      shrink(std::max(std::chrono::ceil<std::chrono::milliseconds>(*next - now),
+                      std::chrono::milliseconds(0)));
+    }
+    if (!polled.empty()) {
+      shrink(kFallbackTick);
+    }
+    return budget;
+  }
+
+  internal::Poller poller;
+  std::unordered_map<Watched*, std::unique_ptr<Watched>> entries;
+  std::uint64_t next_order = 0;
+  std::unordered_map<int, Registration> registrations;
+  std::unordered_map<int, Waiter> waiters;
+  TimerQueue timers;
+  // Children without exit handles, reaped with try_wait every kFallbackTick.
+  std::vector<Watched*> polled;
+  // Children with activity since the last finished() check.
+  std::vector<Watched*> touched;
+  std::vector<int> ready;
+};
+
+Reactor::Reactor() = default;
+
+Reactor::Reactor(Reactor&& other) noexcept {
+  auto use = other.concurrent_use_.enter("Reactor");
+  (void)use;
+  impl_ = std::move(other.impl_);
+}
+
+Reactor& Reactor::operator=(Reactor&& other) noexcept {
+  if (this != &other) {
+    auto use = concurrent_use_.enter("Reactor");
+    auto other_use = other.concurrent_use_.enter("Reactor");
+    (void)use;
+    (void)other_use;
+    impl_ = std::move(other.impl_);
+  }
+  return *this;
+}
+
+Reactor::~Reactor() = default;
+
+Result<Reactor> Reactor::create() {
+  auto poller = internal::Poller::create();
+  if (!poller) {
+    return poller.error();
+  }
+  Reactor reactor;
+  reactor.impl_ = std::make_unique<Impl>(std::move(poller.value()));
+  return reactor;
+}
+
+Result<void> Reactor::watch(Child child, WatchOptions options, ChildCallback on_complete) {
+  if (!impl_) {
+    return Error{.code = make_error_code(errc::invalid_argument), .context = "watch"};
+  }
+  auto use = concurrent_use_.enter("Reactor");
+  (void)use;
+  return impl_->start(std::make_unique<WatchedChild>(std::move(child), std::move(on_complete)),
+                      std::move(options));
+}
+
+Result<void> Reactor::watch(PipelineChild child, WatchOptions options,
+                            PipelineCallback on_complete) {
+  if (!impl_) {
+    return Error{.code = make_error_code(errc::invalid_argument), .context = "watch"};
+  }
+  auto use = concurrent_use_.enter("Reactor");
+  (void)use;
+  return impl_->start(std::make_unique<WatchedPipeline>(std::move(child), std::move(on_complete)),
+                      std::move(options));
+}
+
+std::future<Result<ChildCompletion>> Reactor::watch(Child child, WatchOptions options) {
+  auto promise = std::make_shared<std::promise<Result<ChildCompletion>>>();
+  auto future = promise->get_future();
+  auto watched =
+      watch(std::move(child), std::move(options),
+            [promise](Result<ChildCompletion> result) { promise->set_value(std::move(result)); });
+  if (!watched) {
+    promise->set_value(watched.error());
+  }
+  return future;
+}
+
+std::future<Result<PipelineCompletion>> Reactor::watch(PipelineChild child,
+                                                       WatchOptions options) {
+  auto promise = std::make_shared<std::promise<Result<PipelineCompletion>>>();
+  auto future = promise->get_future();
+  auto watched = watch(
+      std::move(child), std::move(options),
+      [promise](Result<PipelineCompletion> result) { promise->set_value(std::move(result)); });
+  if (!watched) {
+    promise->set_value(watched.error());
+  }
+  return future;
+}
+
+Result<void> Reactor::when_readable(int fd, std::optional<std::chrono::milliseconds> timeout,
+                                    std::function<void(bool ready)> on_ready) {
+  if (!impl_) {
+    return Error{.code = make_error_code(errc::invalid_argument), .context = "when_readable"};
+  }
+  auto use = concurrent_use_.enter("Reactor");
+  (void)use;
+  std::optional<TimePoint> deadline;
+  if (timeout) {
+    deadline = internal::default_clock().now() + *timeout;
+  }
+  return impl_->add_waiter(fd, deadline, std::move(on_ready));
+}
+
+Result<std::vector<ProcessSample>> Reactor::sample_all() {
+  if (!impl_) {
+    return Error{.code = make_error_code(errc::invalid_argument), .context = "sample_all"};
+  }
+  auto use = concurrent_use_.enter("Reactor");
+  (void)use;
+#if PROCLY_PLATFORM_LINUX
+  std::vector<Watched*> running;
+  running.reserve(impl_->entries.size());
+  for (const auto& [key, entry] : impl_->entries) {
+    if (!entry->reaped) {
+      running.push_back(key);
+    }
+  }
+  std::sort(running.begin(), running.end(),
+            [](const Watched* left, const Watched* right) { return left->order < right->order; });
+  std::vector<ProcessSample> samples;
+  samples.reserve(running.size());
+  for (Watched* watched : running) {
+    watched->sample(&samples);
+  }
+  return samples;
+#else
+  return Error{.code = std::make_error_code(std::errc::not_supported), .context = "sample_all"};
+#endif
+}
+
+std::size_t Reactor::pending() const noexcept {
+  if (!impl_) {
+    return 0;
+  }
+  auto use = concurrent_use_.enter("Reactor");
+  (void)use;
+  return impl_->entries.size() + impl_->waiters.size();
+}
+
+Result<std::size_t> Reactor::run_once(std::optional<std::chrono::milliseconds> timeout) {
+  if (!impl_) {
+    return Error{.code = make_error_code(errc::invalid_argument), .context = "run_once"};
+  }
+
+  std::vector<std::unique_ptr<Watched>> done;
+  std::vector<std::function<void()>> fired;
+  {
+    auto use = concurrent_use_.enter("Reactor");
+    (void)use;
+    Impl& impl = *impl_;
+    auto& clock = internal::default_clock();
+
+    impl.ready.clear();
+    auto waited = impl.poller.wait(impl.poll_budget(timeout, clock.now()), &impl.ready);
+    if (!waited) {
+      return waited.error();
+    }
+    for (int fd : impl.ready) {
+      impl.on_ready(fd, &fired);
+    }
+
+    for (Watched* watched : impl.polled) {
+      impl.reap(*watched);
+    }
+    impl.polled.erase(std::remove_if(impl.polled.begin(), impl.polled.end(),
+                                     [](const Watched* watched) { return watched->reaped; }),
+                      impl.polled.end());
+    impl.fire_timers(clock.now(), &fired);
+
+    // Only children with activity this iteration can have finished.
+    for (Watched* watched : impl.touched) {
+      watched->touched = false;
+      if (!watched->finished()) {
+        continue;
+      }
+      auto it = impl.entries.find(watched);
+      impl.unregister_all(*watched);
+      done.push_back(std::move(it->second));
+      impl.entries.erase(it);
+    }
+    impl.touched.clear();
+    std::sort(done.begin(), done.end(),
+              [](const auto& lhs, const auto& rhs) { return lhs->order < rhs->order; });
+  }
+
+  // Callbacks run outside the guard so they can watch more children.
+  for (auto& callback : fired) {
+    callback();
+  }
+  for (auto& watched : done) {
+    watched->complete();
+  }
+  return fired.size() + done.size();
+}
+
+Result<void> Reactor::run() {
+  while (pending() > 0) {
+    auto ran = run_once();
+    if (!ran) {
+      return ran.error();
+    }
+  }
+  return {};
+}
+
+}  // namespace procly
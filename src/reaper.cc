@@ -0,0 +1,317 @@
+#include "procly/reaper.hpp"
+
+#include <pthread.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <mutex>
+#include <system_error>
+#include <utility>
+
+#include "procly/internal/posix_wait.hpp"
+#include "procly/internal/reaper.hpp"
+
+namespace procly {
+
+namespace internal {
+
+namespace {
+
+// Wakeup cadence for pids whose exits cannot be watched with a descriptor.
+constexpr std::chrono::milliseconds kSweepInterval{10};
+
+std::mutex g_reaper_mutex;
+std::shared_ptr<ReaperCore> g_reaper;
+// Lets spawns and waits skip g_reaper_mutex while no Reaper runs.
+std::atomic<bool> g_reaper_active{false};
+
+// A forked child has no reaper thread; its own spawns must reap for themselves.
+void disable_reaper_after_fork() { g_reaper_active.store(false, std::memory_order_relaxed); }
+
+}  // namespace
+
+std::shared_ptr<ReaperCore> active_reaper() {
+  if (!g_reaper_active.load(std::memory_order_acquire)) {
+    return nullptr;
+  }
+  std::lock_guard lock(g_reaper_mutex);
+  return g_reaper;
+}
+
+ReaperCore::ReaperCore(Poller poller, unique_fd wake_read, unique_fd wake_write)
+    : poller_(std::move(poller)),
+      wake_read_(std::move(wake_read)),
+      wake_write_(std::move(wake_write)) {}
+
+ReaperCore::~ReaperCore() { stop(); }
+
+void ReaperCore::start() { thread_ = std::thread([this] { run(); }); }
+
+void ReaperCore::stop() {
+  {
+    std::lock_guard lock(mutex_);
+    if (stopping_) {
+      return;
+    }
+    stopping_ = true;
+    for (auto& [pid, entry] : entries_) {
+      entry->exited.notify_all();
+    }
+  }
+  wake();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+bool ReaperCore::stopped() const {
+  std::lock_guard lock(mutex_);
+  return stopping_;
+}
+
+void ReaperCore::wake() {
+  const char byte = 1;
+  // A full pipe already guarantees a wakeup.
+  (void)::write(wake_write_.get(), &byte, 1);
+}
+
+void ReaperCore::adopt(pid_t pid,
+                       std::optional<std::chrono::steady_clock::time_point> started) {
+  auto entry = std::make_unique<Entry>();
+  entry->started = started;
+  // Without an exit descriptor the background thread sweeps the pid instead.
+  auto exit_fd = open_exit_fd(pid);
+  {
+    std::lock_guard lock(mutex_);
+    entries_[pid] = std::move(entry);
+    pending_.emplace_back(pid, exit_fd ? std::move(exit_fd.value()) : unique_fd());
+  }
+  wake();
+}
+
+bool ReaperCore::owns(pid_t pid) const {
+  std::lock_guard lock(mutex_);
+  return entries_.find(pid) != entries_.end();
+}
+
+bool ReaperCore::reap_locked(pid_t pid, Entry& entry) {
+  if (entry.result || entry.error) {
+    return true;
+  }
+  struct rusage usage {};
+  auto status = try_wait_pid(pid, &usage);
+  if (!status) {
+    entry.error = status.error();
+  } else if (status.value()) {
+    entry.result = WaitResult{.status = *status.value(),
+                              .usage = to_resource_usage(usage, entry.started)};
+  } else {
+    return false;
+  }
+  entry.exited.notify_all();
+  return true;
+}
+
+Result<std::optional<WaitResult>> ReaperCore::try_wait(pid_t pid) {
+  std::lock_guard lock(mutex_);
+  auto it = entries_.find(pid);
+  if (it == entries_.end()) {
+    return Error{.code = make_error_code(errc::wait_failed), .context = "reaper"};
+  }
+  if (!reap_locked(pid, *it->second)) {
+    return std::optional<WaitResult>();
+  }
+  auto entry = std::move(it->second);
+  entries_.erase(it);
+  if (entry->error) {
+    return *entry->error;
+  }
+  return std::optional<WaitResult>(*entry->result);
+}
+
+void ReaperCore::wait_exit(pid_t pid,
+                           std::optional<std::chrono::steady_clock::time_point> deadline) {
+  std::unique_lock lock(mutex_);
+  auto it = entries_.find(pid);
+  if (it == entries_.end()) {
+    return;
+  }
+  // Entries are only erased by their own handle, which is the caller, so `entry` stays valid.
+  Entry& entry = *it->second;
+  auto settled = [&] { return stopping_ || entry.result || entry.error; };
+  if (deadline) {
+    entry.exited.wait_until(lock, *deadline, settled);
+  } else {
+    entry.exited.wait(lock, settled);
+  }
+}
+
+Result<bool> ReaperCore::signal(pid_t pid, int target, int signo) {
+  std::lock_guard lock(mutex_);
+  auto it = entries_.find(pid);
+  // An unreaped pid (even a zombie) cannot be recycled, so the kill is safe under the lock.
+  if (it == entries_.end() || it->second->result || it->second->error) {
+    return false;
+  }
+  if (::kill(target, signo) == -1) {
+    return Error{.code = std::error_code(errno, std::system_category()), .context = "kill"};
+  }
+  return true;
+}
+
+void ReaperCore::abandon(pid_t pid) {
+  std::lock_guard lock(mutex_);
+  auto it = entries_.find(pid);
+  if (it == entries_.end()) {
+    return;
+  }
+  if (reap_locked(pid, *it->second)) {
+    entries_.erase(it);
+    return;
+  }
+  it->second->abandoned = true;
+}
+
+std::size_t ReaperCore::tracked() const {
+  std::lock_guard lock(mutex_);
+  return entries_.size();
+}
+
+bool ReaperCore::collect(pid_t pid) {
+  std::lock_guard lock(mutex_);
+  auto it = entries_.find(pid);
+  if (it == entries_.end()) {
+    return true;
+  }
+  if (!reap_locked(pid, *it->second)) {
+    return false;
+  }
+  if (it->second->abandoned) {
+    entries_.erase(it);
+  }
+  return true;
+}
+
+void ReaperCore::run() {
+  std::vector<int> ready;
+  while (true) {
+    std::vector<std::pair<pid_t, unique_fd>> adopted;
+    {
+      std::lock_guard lock(mutex_);
+      if (stopping_) {
+        break;
+      }
+      adopted.swap(pending_);
+    }
+    for (auto& [pid, fd] : adopted) {
+      if (fd && poller_.add(fd.get(), Poller::Interest::readable)) {
+        int key = fd.get();
+        watched_.emplace(key, std::make_pair(pid, std::move(fd)));
+      } else {
+        swept_.push_back(pid);
+      }
+    }
+
+    ready.clear();
+    auto timeout = swept_.empty() ? std::nullopt
+                                  : std::optional<std::chrono::milliseconds>(kSweepInterval);
+    if (!poller_.wait(timeout, &ready)) {
+      // Nothing sensible to do about a broken poller but keep sweeping.
+      std::this_thread::sleep_for(kSweepInterval);
+    }
+    for (int fd : ready) {
+      if (fd == wake_read_.get()) {
+        std::array<char, 64> drain{};
+        while (::read(fd, drain.data(), drain.size()) > 0) {
+        }
+        continue;
+      }
+      auto it = watched_.find(fd);
+      if (it != watched_.end() && collect(it->second.first)) {
+        (void)poller_.remove(fd, Poller::Interest::readable);
+        watched_.erase(it);
+      }
+    }
+    swept_.erase(std::remove_if(swept_.begin(), swept_.end(),
+                                [this](pid_t pid) { return collect(pid); }),
+                 swept_.end());
+  }
+  for (auto& [fd, watched] : watched_) {
+    (void)poller_.remove(fd, Poller::Interest::readable);
+  }
+  watched_.clear();
+  swept_.clear();
+}
+
+}  // namespace internal
+
+struct Reaper::Impl {
+  std::shared_ptr<internal::ReaperCore> core;
+
+  ~Impl() {
+    {
+      std::lock_guard lock(internal::g_reaper_mutex);
+      if (internal::g_reaper == core) {
+        internal::g_reaper.reset();
+        internal::g_reaper_active.store(false, std::memory_order_release);
+      }
+    }
+    core->stop();
+  }
+};
+
+Result<Reaper> Reaper::start() {
+  static std::once_flag atfork_once;
+  std::call_once(atfork_once,
+                 [] { ::pthread_atfork(nullptr, nullptr, internal::disable_reaper_after_fork); });
+  std::lock_guard lock(internal::g_reaper_mutex);
+  if (internal::g_reaper) {
+    return Error{.code = std::make_error_code(std::errc::device_or_resource_busy),
+                 .context = "Reaper::start"};
+  }
+  auto poller = internal::Poller::create();
+  if (!poller) {
+    return poller.error();
+  }
+  auto wake = internal::create_pipe();
+  if (!wake) {
+    return wake.error();
+  }
+  auto& [wake_read, wake_write] = wake.value();
+  for (int fd : {wake_read.get(), wake_write.get()}) {
+    auto nonblocking = internal::set_nonblocking(fd);
+    if (!nonblocking) {
+      return nonblocking.error();
+    }
+  }
+  auto added = poller->add(wake_read.get(), internal::Poller::Interest::readable);
+  if (!added) {
+    return added.error();
+  }
+
+  auto impl = std::make_unique<Impl>();
+  impl->core = std::make_shared<internal::ReaperCore>(std::move(poller.value()),
+                                                      std::move(wake_read), std::move(wake_write));
+  impl->core->start();
+  internal::g_reaper = impl->core;
+  internal::g_reaper_active.store(true, std::memory_order_release);
+  return Reaper(std::move(impl));
+}
+
+Reaper::Reaper(std::unique_ptr<Impl> impl) noexcept : impl_(std::move(impl)) {}
+
+Reaper::Reaper(Reaper&& other) noexcept = default;
+
+Reaper& Reaper::operator=(Reaper&& other) noexcept = default;
+
+Reaper::~Reaper() = default;
+
+std::size_t Reaper::tracked() const { return impl_ ? impl_->core->tracked() : 0; }
+
+}  // namespace procly
@@ -0,0 +1,908 @@
+#include "procly/replay.hpp"
+
+#if PROCLY_PLATFORM_POSIX
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <condition_variable>
+#include <csignal>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "procly/backend.hpp"
+#include "procly/internal/backend.hpp"
+#include "procly/internal/clock.hpp"
+#include "procly/internal/fd.hpp"
+#include "procly/internal/wait_policy.hpp"
+#include "procly/internal/wire.hpp"
+
+namespace procly {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using internal::Decoder;
+using internal::Encoder;
+using internal::unique_fd;
+
+constexpr std::string_view kMagic = "procly-replay-1\n";
+constexpr std::size_t kRelayBufferSize = 64 * 1024;
+// Above PID_MAX_LIMIT, so a synthetic pid never names a real process.
+constexpr int kFirstReplayPid = (1 << 22) + 1;
+
+enum class Stream : std::uint8_t { stdout = 1, stderr = 2 };
+
+struct Chunk {
+  Stream stream = Stream::stdout;
+  std::uint64_t offset_us = 0;
+  std::string bytes;
+};
+
+struct Run {
+  std::vector<std::string> argv;
+  std::vector<Chunk> chunks;
+  ExitStatus status;
+  std::uint64_t exit_us = 0;
+};
+
+Error make_errno_error(const char* context) {
+  return Error{.code = std::error_code(errno, std::system_category()), .context = context};
+}
+
+Error format_error() {
+  return Error{.code = std::make_error_code(std::errc::protocol_error), .context = "replay file"};
+}
+
+std::uint64_t micros_since(Clock::time_point start, Clock::time_point now) {
+  return static_cast<std::uint64_t>(
+      std::chrono::duration_cast<std::chrono::microseconds>(now - start).count());
+}
+
+void encode_run(Encoder& out, const Run& run) {
+  out.put_u32(static_cast<std::uint32_t>(run.argv.size()));
+  for (const auto& arg : run.argv) {
+    out.put_string(arg);
+  }
+  out.put_u32(static_cast<std::uint32_t>(run.chunks.size()));
+  for (const auto& chunk : run.chunks) {
+    out.put_u8(static_cast<std::uint8_t>(chunk.stream));
+    out.put_u64(chunk.offset_us);
+    out.put_string(chunk.bytes);
+  }
+  out.put_bool(run.status.kind() == ExitStatus::Kind::exited);
+  out.put_i32(run.status.code().value_or(0));
+  out.put_u32(run.status.native());
+  out.put_u64(run.exit_us);
+}
+
+Result<Run> decode_run(Decoder& in) {
+  Run run;
+  auto arg_count = in.u32();
+  for (std::uint32_t index = 0; index < arg_count && !in.failed(); ++index) {
+    run.argv.push_back(in.string());
+  }
+  auto chunk_count = in.u32();
+  for (std::uint32_t index = 0; index < chunk_count && !in.failed(); ++index) {
+    Chunk chunk;
+    // The stream byte later indexes the child's pipe ends, so only stdout and stderr pass.
+    auto stream = in.u8();
+    if (stream != static_cast<std::uint8_t>(Stream::stdout) &&
+        stream != static_cast<std::uint8_t>(Stream::stderr)) {
+      return format_error();
+    }
+    chunk.stream = static_cast<Stream>(stream);
+    chunk.offset_us = in.u64();
+    chunk.bytes = in.string();
+    run.chunks.push_back(std::move(chunk));
+  }
+  bool exited = in.boolean();
+  auto code = in.i32();
+  auto native = in.u32();
+  run.status = exited ? ExitStatus::exited(code, native) : ExitStatus::other(native);
+  run.exit_us = in.u64();
+  return run;
+}
+
+// Relay and replay threads write to pipes the caller may have closed; take EPIPE instead.
+void block_sigpipe() {
+  sigset_t set;
+  sigemptyset(&set);
+  sigaddset(&set, SIGPIPE);
+  ::pthread_sigmask(SIG_BLOCK, &set, nullptr);
+}
+
+bool write_all(int fd, std::string_view bytes) {
+  while (!bytes.empty()) {
+    ssize_t written = ::write(fd, bytes.data(), bytes.size());
+    if (written == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    bytes.remove_prefix(static_cast<std::size_t>(written));
+  }
+  return true;
+}
+
+Result<void> write_file(const std::filesystem::path& path, std::string_view bytes) {
+  constexpr ::mode_t kFileMode = 0644;
+  std::filesystem::path temp = path;
+  temp += ".tmp";
+  unique_fd fd(::open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, kFileMode));
+  if (!fd) {
+    return make_errno_error("open(replay file)");
+  }
+  if (!write_all(fd.get(), bytes)) {
+    return make_errno_error("write(replay file)");
+  }
+  fd.reset(-1);
+  if (::rename(temp.c_str(), path.c_str()) == -1) {
+    return make_errno_error("rename(replay file)");
+  }
+  return {};
+}
+
+Result<std::string> read_file(const std::filesystem::path& path) {
+  unique_fd fd(::open(path.c_str(), O_RDONLY | O_CLOEXEC));
+  if (!fd) {
+    return make_errno_error("open(replay file)");
+  }
+  std::string bytes;
+  std::array<char, kRelayBufferSize> buffer{};
+  while (true) {
+    ssize_t count = ::read(fd.get(), buffer.data(), buffer.size());
+    if (count == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return make_errno_error("read(replay file)");
+    }
+    if (count == 0) {
+      return bytes;
+    }
+    bytes.append(buffer.data(), static_cast<std::size_t>(count));
+  }
+}
+
+void join_all(std::vector<std::thread> threads) {
+  for (auto& thread : threads) {
+    if (thread.joinable()) {
+      thread.join();
+    }
+  }
+}
+
+}  // namespace
+
+struct Recorder::Impl final : Backend {
+  // A child being recorded. The relay thread owns run.chunks until relay_done.
+  struct Live {
+    std::uint64_t sequence = 0;
+    Run run;
+    Clock::time_point started;
+    bool exit_seen = false;
+    bool relay_done = false;
+    bool reaped = false;
+    bool abandoned = false;
+    std::thread relay;
+  };
+
+  Impl(std::filesystem::path path, Backend& inner) : path_(std::move(path)), inner_(inner) {}
+
+  Impl(const Impl&) = delete;
+  Impl& operator=(const Impl&) = delete;
+
+  ~Impl() override { join_relays(); }
+
+  Result<Spawned> spawn(const SpawnSpec& spec) override {
+    join_finished();
+    auto spawned = inner_.spawn(spec);
+    if (!spawned) {
+      return spawned;
+    }
+    auto live = std::make_shared<Live>();
+    live->started = spawned->started.value_or(Clock::now());
+    live->run.argv = spec.argv;
+
+    // Interpose a pipe on each piped output so the relay sees the bytes first.
+    std::array<unique_fd, 2> sources;
+    std::array<unique_fd, 2> sinks;
+    std::array<std::optional<int>*, 2> outputs{&spawned->stdout_fd, &spawned->stderr_fd};
+    for (std::size_t index = 0; index < outputs.size(); ++index) {
+      if (!*outputs[index]) {
+        continue;
+      }
+      sources[index].reset(**outputs[index]);
+      auto pipe = internal::create_pipe();
+      if (!pipe) {
+        outputs[index]->reset();
+        discard(spawned.value());
+        return pipe.error();
+      }
+      *outputs[index] = pipe->first.release();
+      sinks[index] = std::move(pipe->second);
+    }
+    unique_fd exit_handle;
+    if (auto handle = inner_.open_exit_handle(spawned.value())) {
+      exit_handle.reset(handle.value());
+    }
+    spawned->started = live->started;
+
+    std::lock_guard lock(mutex_);
+    live->sequence = next_sequence_++;
+    live->relay = std::thread([this, live, sources = std::move(sources),
+                               sinks = std::move(sinks),
+                               exit_handle = std::move(exit_handle)]() mutable {
+      relay(*live, sources, sinks, exit_handle);
+    });
+    live_[spawned->pid] = std::move(live);
+    return spawned;
+  }
+
+  Result<WaitResult> wait(Spawned& spawned, std::optional<std::chrono::milliseconds> timeout,
+                          std::chrono::milliseconds kill_grace) override {
+    const int pid = spawned.pid;
+    auto result = inner_.wait(spawned, timeout, kill_grace);
+    if (spawned.terminal_result) {
+      reaped(pid, spawned.terminal_result->status);
+    }
+    return result;
+  }
+
+  Result<std::optional<ExitStatus>> try_wait(Spawned& spawned) override {
+    const int pid = spawned.pid;
+    auto result = inner_.try_wait(spawned);
+    if (spawned.terminal_result) {
+      reaped(pid, spawned.terminal_result->status);
+    }
+    return result;
+  }
+
+  Result<void> terminate(Spawned& spawned) override { return inner_.terminate(spawned); }
+
+  Result<void> kill(Spawned& spawned) override { return inner_.kill(spawned); }
+
+  Result<void> signal(Spawned& spawned, int signo) override {
+    return inner_.signal(spawned, signo);
+  }
+
+  void abandon(Spawned& spawned) override {
+    {
+      std::lock_guard lock(mutex_);
+      auto it = live_.find(spawned.pid);
+      if (it != live_.end()) {
+        it->second->abandoned = true;
+        if (it->second->relay_done) {
+          retire(it);
+        }
+      }
+    }
+    inner_.abandon(spawned);
+  }
+
+  Result<int> open_exit_handle(const Spawned& spawned) override {
+    return inner_.open_exit_handle(spawned);
+  }
+
+  // Wait until every relay has seen its child's output end.
+  void join_relays() {
+    std::vector<std::thread> threads;
+    {
+      std::lock_guard lock(mutex_);
+      threads = std::move(finished_);
+      finished_.clear();
+      for (auto& [pid, live] : live_) {
+        threads.push_back(std::move(live->relay));
+      }
+    }
+    join_all(std::move(threads));
+  }
+
+  std::size_t recorded() const {
+    std::unique_lock lock(mutex_);
+    await_reaped(lock);
+    return completed_.size();
+  }
+
+  Result<void> save() const {
+    Encoder out;
+    {
+      std::unique_lock lock(mutex_);
+      await_reaped(lock);
+      out.put_u64(completed_.size());
+      for (const auto& [sequence, run] : completed_) {
+        encode_run(out, run);
+      }
+    }
+    std::string bytes(kMagic);
+    bytes += out.bytes();
+    return write_file(path_, bytes);
+  }
+
+ private:
+  // Kill and reap a child whose interposed pipes could not be set up.
+  void discard(Spawned& spawned) {
+    (void)inner_.kill(spawned);
+    (void)inner_.wait(spawned, std::nullopt, std::chrono::milliseconds(0));
+    for (auto* fd : {&spawned.stdin_fd, &spawned.stdout_fd, &spawned.stderr_fd}) {
+      if (*fd) {
+        ::close(**fd);
+      }
+    }
+  }
+
+  // Caller holds mutex_. A reaped child's run is complete once its relay has seen the output end.
+  void await_reaped(std::unique_lock<std::mutex>& lock) const {
+    retired_.wait(lock, [this] {
+      return std::none_of(live_.begin(), live_.end(),
+                          [](const auto& entry) { return entry.second->reaped; });
+    });
+  }
+
+  void relay(Live& live, std::array<unique_fd, 2>& sources, std::array<unique_fd, 2>& sinks,
+             unique_fd& exit_handle) {
+    block_sigpipe();
+    std::array<char, kRelayBufferSize> buffer{};
+    while (sources[0] || sources[1] || exit_handle) {
+      std::array<pollfd, 3> polled{};
+      for (std::size_t index = 0; index < sources.size(); ++index) {
+        polled[index] = pollfd{.fd = sources[index].get(), .events = POLLIN, .revents = 0};
+      }
+      polled[2] = pollfd{.fd = exit_handle.get(), .events = POLLIN, .revents = 0};
+      if (::poll(polled.data(), polled.size(), -1) == -1) {
+        if (errno == EINTR) {
+          continue;
+        }
+        break;
+      }
+      for (std::size_t index = 0; index < sources.size(); ++index) {
+        if (polled[index].revents == 0) {
+          continue;
+        }
+        ssize_t count = ::read(sources[index].get(), buffer.data(), buffer.size());
+        if (count == -1 && errno == EINTR) {
+          continue;
+        }
+        if (count <= 0) {
+          sources[index].reset(-1);
+          sinks[index].reset(-1);
+          continue;
+        }
+        std::string_view bytes(buffer.data(), static_cast<std::size_t>(count));
+        live.run.chunks.push_back(Chunk{.stream = index == 0 ? Stream::stdout : Stream::stderr,
+                                        .offset_us = micros_since(live.started, Clock::now()),
+                                        .bytes = std::string(bytes)});
+        // A reader that went away stops the forwarding, not the recording.
+        if (sinks[index] && !write_all(sinks[index].get(), bytes)) {
+          sinks[index].reset(-1);
+        }
+      }
+      if (polled[2].revents != 0) {
+        std::lock_guard lock(mutex_);
+        live.run.exit_us = micros_since(live.started, Clock::now());
+        live.exit_seen = true;
+        exit_handle.reset(-1);
+      }
+    }
+    sources = {};
+    sinks = {};
+    std::lock_guard lock(mutex_);
+    live.relay_done = true;
+    for (auto it = live_.begin(); it != live_.end(); ++it) {
+      if (it->second.get() == &live) {
+        if (live.reaped || live.abandoned) {
+          retire(it);
+        }
+        break;
+      }
+    }
+  }
+
+  void reaped(int pid, const ExitStatus& status) {
+    std::lock_guard lock(mutex_);
+    auto it = live_.find(pid);
+    if (it == live_.end()) {
+      return;
+    }
+    Live& live = *it->second;
+    live.run.status = status;
+    if (!live.exit_seen) {
+      live.run.exit_us = micros_since(live.started, Clock::now());
+    }
+    live.reaped = true;
+    if (live.relay_done) {
+      retire(it);
+    }
+  }
+
+  // Caller holds mutex_. Keeps a reaped run, and hands the relay thread to join_finished().
+  void retire(std::unordered_map<int, std::shared_ptr<Live>>::iterator it) {
+    Live& live = *it->second;
+    if (live.reaped && !live.abandoned) {
+      completed_.emplace(live.sequence, std::move(live.run));
+    }
+    finished_.push_back(std::move(live.relay));
+    live_.erase(it);
+    retired_.notify_all();
+  }
+
+  void join_finished() {
+    std::vector<std::thread> threads;
+    {
+      std::lock_guard lock(mutex_);
+      threads = std::move(finished_);
+      finished_.clear();
+    }
+    join_all(std::move(threads));
+  }
+
+  std::filesystem::path path_;
+  Backend& inner_;
+  mutable std::mutex mutex_;
+  mutable std::condition_variable retired_;
+  std::uint64_t next_sequence_ = 0;
+  std::unordered_map<int, std::shared_ptr<Live>> live_;
+  // Completed runs by spawn order.
+  std::map<std::uint64_t, Run> completed_;
+  // Relay threads that have finished or are about to; joined on the next spawn.
+  std::vector<std::thread> finished_;
+};
+
+struct Replayer::Impl final : Backend {
+  // A replayed child. The feeder thread sets status last, when the child "exits".
+  struct Playback {
+    const Run* run = nullptr;
+    Clock::time_point started;
+    std::optional<int> kill_signal;
+    std::optional<ExitStatus> status;
+    bool abandoned = false;
+    unique_fd wake_read;
+    unique_fd wake_write;
+    std::vector<unique_fd> exit_notifiers;
+    std::thread feeder;
+  };
+
+  Impl(std::vector<Run> runs, ReplayOptions options)
+      : runs_(std::move(runs)), options_(options), remaining_(runs_.size()) {
+    for (std::size_t index = 0; index < runs_.size(); ++index) {
+      pending_[runs_[index].argv].push_back(index);
+    }
+  }
+
+  Impl(const Impl&) = delete;
+  Impl& operator=(const Impl&) = delete;
+
+  ~Impl() override {
+    std::vector<std::thread> threads;
+    {
+      std::lock_guard lock(mutex_);
+      threads = std::move(finished_);
+      for (auto& [pid, playback] : live_) {
+        stop(*playback, SIGKILL);
+        if (playback->feeder.joinable()) {
+          threads.push_back(std::move(playback->feeder));
+        }
+      }
+    }
+    join_all(std::move(threads));
+  }
+
+  Result<Spawned> spawn(const SpawnSpec& spec) override {
+    join_finished();
+    const Run* run = nullptr;
+    {
+      std::lock_guard lock(mutex_);
+      auto it = pending_.find(spec.argv);
+      if (it == pending_.end() || it->second.empty()) {
+        return Error{.code = make_error_code(errc::spawn_failed),
+                     .context = "replay: no recorded run for " +
+                                (spec.argv.empty() ? std::string() : spec.argv.front())};
+      }
+      run = &runs_[it->second.front()];
+      it->second.pop_front();
+      --remaining_;
+    }
+
+    auto playback = std::make_shared<Playback>();
+    playback->run = run;
+    std::array<unique_fd, 3> child_ends;
+    Spawned spawned;
+    std::array<std::pair<const StdioSpec*, std::optional<int>*>, 3> streams{
+        std::pair{&spec.stdin_spec, &spawned.stdin_fd},
+        std::pair{&spec.stdout_spec, &spawned.stdout_fd},
+        std::pair{&spec.stderr_spec, &spawned.stderr_fd}};
+    for (std::size_t index = 0; index < streams.size(); ++index) {
+      if (streams[index].first->kind != StdioSpec::Kind::piped) {
+        continue;
+      }
+      auto pipe = internal::create_pipe(streams[index].first->pipe_capacity);
+      if (!pipe) {
+        close_parent_ends(spawned);
+        return pipe.error();
+      }
+      // stdin: the caller writes, the replay drains. Outputs: the replay writes.
+      if (index == 0) {
+        *streams[index].second = pipe->second.release();
+        child_ends[index] = std::move(pipe->first);
+      } else {
+        *streams[index].second = pipe->first.release();
+        child_ends[index] = std::move(pipe->second);
+      }
+    }
+    auto wake = internal::create_pipe();
+    if (!wake) {
+      close_parent_ends(spawned);
+      return wake.error();
+    }
+    playback->wake_read = std::move(wake->first);
+    playback->wake_write = std::move(wake->second);
+    playback->started = Clock::now();
+    spawned.started = playback->started;
+    spawned.new_process_group = spec.opts.new_process_group;
+
+    std::lock_guard lock(mutex_);
+    spawned.pid = next_pid_++;
+    if (spec.opts.new_process_group) {
+      spawned.pgid = spawned.pid;
+    } else if (spec.process_group) {
+      spawned.pgid = *spec.process_group;
+    }
+    playback->feeder =
+        std::thread([this, playback, child_ends = std::move(child_ends)]() mutable {
+          feed(*playback, child_ends);
+        });
+    live_[spawned.pid] = std::move(playback);
+    return spawned;
+  }
+
+  Result<WaitResult> wait(Spawned& spawned, std::optional<std::chrono::milliseconds> timeout,
+                          std::chrono::milliseconds kill_grace) override {
+    if (spawned.terminal_result) {
+      return *spawned.terminal_result;
+    }
+    const int pid = spawned.pid;
+    internal::WaitOps ops;
+    ops.try_wait = [&]() { return try_wait(spawned); };
+    ops.wait_blocking = [this, pid]() -> Result<ExitStatus> {
+      std::unique_lock lock(mutex_);
+      auto it = live_.find(pid);
+      if (it == live_.end()) {
+        return Error{.code = make_error_code(errc::wait_failed), .context = "replay wait"};
+      }
+      auto playback = it->second;
+      cv_.wait(lock, [&] { return playback->status.has_value(); });
+      return *playback->status;
+    };
+    ops.terminate = [&]() { return terminate(spawned); };
+    ops.kill = [&]() { return kill(spawned); };
+    ops.wait_exit = [this, pid](std::chrono::milliseconds budget) -> Result<void> {
+      std::unique_lock lock(mutex_);
+      cv_.wait_for(lock, budget, [&] {
+        auto it = live_.find(pid);
+        return it == live_.end() || it->second->status.has_value();
+      });
+      return {};
+    };
+    auto result = internal::wait_with_timeout(ops, internal::default_clock(), timeout, kill_grace);
+    if (!result) {
+      return result.error();
+    }
+    if (!spawned.terminal_result) {
+      internal::cache_terminal_result(spawned, result.value());
+      forget(pid);
+    }
+    return *spawned.terminal_result;
+  }
+
+  Result<std::optional<ExitStatus>> try_wait(Spawned& spawned) override {
+    if (spawned.terminal_result) {
+      return std::optional<ExitStatus>(spawned.terminal_result->status);
+    }
+    std::optional<ExitStatus> status;
+    {
+      std::lock_guard lock(mutex_);
+      auto it = live_.find(spawned.pid);
+      if (it == live_.end()) {
+        return Error{.code = make_error_code(errc::wait_failed), .context = "replay wait"};
+      }
+      status = it->second->status;
+    }
+    if (status) {
+      const int pid = spawned.pid;
+      internal::cache_terminal_result(spawned, WaitResult{.status = *status});
+      forget(pid);
+    }
+    return status;
+  }
+
+  Result<void> terminate(Spawned& spawned) override { return signal(spawned, SIGTERM); }
+
+  Result<void> kill(Spawned& spawned) override { return signal(spawned, SIGKILL); }
+
+  Result<void> signal(Spawned& spawned, int signo) override {
+    if (spawned.terminal_result) {
+      return {};
+    }
+    std::lock_guard lock(mutex_);
+    auto it = live_.find(spawned.pid);
+    if (it == live_.end()) {
+      return Error{.code = make_error_code(errc::kill_failed), .context = "replay signal"};
+    }
+    if (signo != 0) {
+      stop(*it->second, signo);
+    }
+    return {};
+  }
+
+  void abandon(Spawned& spawned) override {
+    std::lock_guard lock(mutex_);
+    auto it = live_.find(spawned.pid);
+    if (it == live_.end()) {
+      return;
+    }
+    it->second->abandoned = true;
+    if (it->second->status) {
+      retire(it);
+    }
+  }
+
+  // A pipe whose write end is closed when the replayed child exits.
+  Result<int> open_exit_handle(const Spawned& spawned) override {
+    auto pipe = internal::create_pipe();
+    if (!pipe) {
+      return pipe.error();
+    }
+    std::lock_guard lock(mutex_);
+    if (!spawned.terminal_result) {
+      auto it = live_.find(spawned.pid);
+      if (it == live_.end()) {
+        return Error{.code = make_error_code(errc::wait_failed), .context = "open_exit_handle"};
+      }
+      if (!it->second->status) {
+        it->second->exit_notifiers.push_back(std::move(pipe->second));
+      }
+    }
+    return pipe->first.release();
+  }
+
+  std::size_t remaining() const {
+    std::lock_guard lock(mutex_);
+    return remaining_;
+  }
+
+ private:
+  static void close_parent_ends(Spawned& spawned) {
+    for (auto* fd : {&spawned.stdin_fd, &spawned.stdout_fd, &spawned.stderr_fd}) {
+      if (*fd) {
+        ::close(**fd);
+      }
+    }
+  }
+
+  // Caller holds mutex_.
+  static void stop(Playback& playback, int signo) {
+    if (playback.status || playback.kill_signal) {
+      return;
+    }
+    playback.kill_signal = signo;
+    char byte = 0;
+    (void)::write(playback.wake_write.get(), &byte, 1);
+  }
+
+  [[nodiscard]] Clock::time_point due(const Playback& playback, std::uint64_t offset_us) const {
+    return playback.started + std::chrono::duration_cast<Clock::duration>(
+                                  std::chrono::duration<double, std::micro>(
+                                      static_cast<double>(offset_us) * options_.time_scale));
+  }
+
+  // Writes the recorded chunks at their offsets while draining stdin, then exits the child.
+  void feed(Playback& playback, std::array<unique_fd, 3>& child_ends) {
+    block_sigpipe();
+    for (std::size_t index = 1; index < child_ends.size(); ++index) {
+      if (child_ends[index]) {
+        (void)internal::set_nonblocking(child_ends[index].get());
+      }
+    }
+    const Run& run = *playback.run;
+    std::size_t next = 0;
+    std::size_t written = 0;
+    std::array<char, kRelayBufferSize> buffer{};
+    while (true) {
+      const bool chunk_pending = next < run.chunks.size();
+      const auto deadline = due(playback, chunk_pending ? run.chunks[next].offset_us : run.exit_us);
+      const auto now = Clock::now();
+      int target = -1;
+      if (chunk_pending && now >= deadline) {
+        target = child_ends[static_cast<std::size_t>(run.chunks[next].stream)].get();
+        if (target < 0) {
+          // Nobody reads this stream; the recorded bytes go nowhere.
+          ++next;
+          written = 0;
+          continue;
+        }
+      } else if (!chunk_pending && now >= deadline) {
+        break;
+      }
+      std::array<pollfd, 3> polled{
+          pollfd{.fd = playback.wake_read.get(), .events = POLLIN, .revents = 0},
+          pollfd{.fd = child_ends[0].get(), .events = POLLIN, .revents = 0},
+          pollfd{.fd = target, .events = POLLOUT, .revents = 0}};
+      int wait_ms = -1;
+      if (target < 0) {
+        wait_ms = static_cast<int>(
+            std::chrono::ceil<std::chrono::milliseconds>(deadline - now).count());
+      }
+      if (::poll(polled.data(), polled.size(), wait_ms) == -1 && errno != EINTR) {
+        break;
+      }
+      // Woken by signal(): the child dies now.
+      if (polled[0].revents != 0) {
+        break;
+      }
+      if (polled[1].revents != 0) {
+        ssize_t count = ::read(child_ends[0].get(), buffer.data(), buffer.size());
+        if (count == 0 || (count == -1 && errno != EINTR && errno != EAGAIN)) {
+          child_ends[0].reset(-1);
+        }
+      }
+      if (target >= 0 && polled[2].revents != 0) {
+        const Chunk& chunk = run.chunks[next];
+        std::string_view bytes = std::string_view(chunk.bytes).substr(written);
+        ssize_t count = ::write(target, bytes.data(), bytes.size());
+        if (count == -1 && errno != EINTR && errno != EAGAIN) {
+          // The reader went away; the rest of this stream is dropped.
+          child_ends[static_cast<std::size_t>(chunk.stream)].reset(-1);
+        } else if (count > 0) {
+          written += static_cast<std::size_t>(count);
+        }
+        if (written == chunk.bytes.size()) {
+          ++next;
+          written = 0;
+        }
+      }
+    }
+    child_ends = {};
+
+    std::lock_guard lock(mutex_);
+    // A signal that arrived before the recorded exit decides the status.
+    if (playback.kill_signal) {
+      playback.status = ExitStatus::other(static_cast<std::uint32_t>(*playback.kill_signal));
+    } else {
+      playback.status = run.status;
+    }
+    playback.exit_notifiers.clear();
+    for (auto it = live_.begin(); it != live_.end(); ++it) {
+      if (it->second.get() == &playback) {
+        if (playback.abandoned) {
+          retire(it);
+        }
+        break;
+      }
+    }
+    cv_.notify_all();
+  }
+
+  void forget(int pid) {
+    std::lock_guard lock(mutex_);
+    auto it = live_.find(pid);
+    if (it != live_.end()) {
+      retire(it);
+    }
+  }
+
+  // Caller holds mutex_; the playback has exited.
+  void retire(std::unordered_map<int, std::shared_ptr<Playback>>::iterator it) {
+    finished_.push_back(std::move(it->second->feeder));
+    live_.erase(it);
+  }
+
+  void join_finished() {
+    std::vector<std::thread> threads;
+    {
+      std::lock_guard lock(mutex_);
+      threads = std::move(finished_);
+      finished_.clear();
+    }
+    join_all(std::move(threads));
+  }
+
+  std::vector<Run> runs_;
+  ReplayOptions options_;
+  mutable std::mutex mutex_;
+  std::condition_variable cv_;
+  // Unserved run indices per argv, in recorded order.
+  std::map<std::vector<std::string>, std::deque<std::size_t>> pending_;
+  std::size_t remaining_;
+  int next_pid_ = kFirstReplayPid;
+  std::unordered_map<int, std::shared_ptr<Playback>> live_;
+  // Feeder threads that have finished or are about to; joined on the next spawn.
+  std::vector<std::thread> finished_;
+};
+
+Recorder::Scope::Scope(Recorder& recorder)
+    : override_(std::make_unique<ScopedBackend>(recorder.backend())) {}
+
+Recorder::Scope::~Scope() = default;
+
+Recorder::Recorder(std::filesystem::path path, Backend* inner)
+    : impl_(std::make_unique<Impl>(std::move(path),
+                                   inner != nullptr ? *inner : default_backend())) {}
+
+Recorder::Recorder(Recorder&& other) noexcept = default;
+
+Recorder& Recorder::operator=(Recorder&& other) noexcept = default;
+
+Recorder::~Recorder() {
+  if (impl_) {
+    impl_->join_relays();
+    (void)impl_->save();
+  }
+}
+
+Backend& Recorder::backend() noexcept { return *impl_; }
+
+std::size_t Recorder::recorded() const { return impl_->recorded(); }
+
+Result<void> Recorder::save() const { return impl_->save(); }
+
+Replayer::Replayer(std::unique_ptr<Impl> impl) noexcept : impl_(std::move(impl)) {}
+
+Replayer::Scope::Scope(Replayer& replayer)
+    : override_(std::make_unique<ScopedBackend>(replayer.backend())) {}
+
+Replayer::Scope::~Scope() = default;
+
+Result<Replayer> Replayer::open(const std::filesystem::path& path, ReplayOptions options) {
+  auto bytes = read_file(path);
+  if (!bytes) {
+    return bytes.error();
+  }
+  std::string_view contents = bytes.value();
+  if (contents.substr(0, kMagic.size()) != kMagic) {
+    return format_error();
+  }
+  Decoder in(contents.substr(kMagic.size()));
+  auto count = in.u64();
+  std::vector<Run> runs;
+  for (std::uint64_t index = 0; index < count && !in.failed(); ++index) {
+    auto run = decode_run(in);
+    if (!run) {
+      return run.error();
+    }
+    runs.push_back(std::move(run.value()));
+  }
+  if (in.failed()) {
+    return format_error();
+  }
+  return Replayer(std::make_unique<Impl>(std::move(runs), options));
+}
+
+Replayer::Replayer(Replayer&& other) noexcept = default;
+
+Replayer& Replayer::operator=(Replayer&& other) noexcept = default;
+
+Replayer::~Replayer() = default;
+
+Backend& Replayer::backend() noexcept { return *impl_; }
+
+std::size_t Replayer::remaining() const { return impl_->remaining(); }
+
+}  // namespace procly
+
+#endif
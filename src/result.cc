@@ -20,6 +20,8 @@ class procly_error_category : public std::error_category {
         return "invalid stdio";
       case errc::invalid_pipeline:
         return "invalid pipeline";
+      case errc::invalid_argument:
+        return "invalid argument";
       case errc::pipe_failed:
         return "pipe failed";
       case errc::spawn_failed:
@@ -42,6 +44,8 @@ class procly_error_category : public std::error_category {
         return "kill failed";
       case errc::timeout:
         return "timeout";
+      case errc::cancelled:
+        return "cancelled";
     }
     return "unknown error";
   }
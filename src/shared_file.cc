@@ -0,0 +1,55 @@
+#include "procly/shared_file.hpp"
+
+#include <fcntl.h>
+
+#include <cerrno>
+#include <system_error>
+#include <utility>
+
+#include "procly/internal/fd.hpp"
+
+namespace procly {
+
+struct SharedFile::State {
+  internal::unique_fd fd;
+};
+
+namespace {
+
+int open_flags(OpenMode mode) {
+  switch (mode) {
+    case OpenMode::read:
+      return O_RDONLY;
+    case OpenMode::write_truncate:
+      return O_WRONLY | O_CREAT | O_TRUNC;
+    case OpenMode::write_append:
+      return O_WRONLY | O_CREAT | O_APPEND;
+    case OpenMode::read_write:
+      return O_RDWR | O_CREAT;
+  }
+  return O_RDONLY;
+}
+
+}  // namespace
+
+SharedFile::SharedFile(std::shared_ptr<const State> state) : state_(std::move(state)) {}
+
+Result<SharedFile> SharedFile::open(const std::filesystem::path& path, OpenMode mode,
+                                    std::optional<FilePerms> perms) {
+  constexpr FilePerms kFileMode = 0666;
+  internal::unique_fd fd(::open(path.c_str(), open_flags(mode) | O_CLOEXEC,
+                                static_cast<int>(perms.value_or(kFileMode))));
+  if (!fd) {
+    return Error{.code = std::error_code(errno, std::system_category()),
+                 .context = "open(shared_file)"};
+  }
+  return SharedFile(std::make_shared<const State>(State{.fd = std::move(fd)}));
+}
+
+int SharedFile::native_handle() const noexcept { return state_->fd.get(); }
+
+Stdio SharedFile::stdio() const {
+  return Stdio{Stdio::Fd{.fd = state_->fd.get(), .owner = state_}};
+}
+
+}  // namespace procly
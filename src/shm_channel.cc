@@ -0,0 +1,126 @@
+#include "procly/shm_channel.hpp"
+
+#if PROCLY_PLATFORM_LINUX
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <cstdint>
+#include <system_error>
+#include <utility>
+
+#include "procly/internal/fd.hpp"
+#include "procly/shm_ring.hpp"
+
+namespace procly {
+
+struct ShmChannel::State {
+  internal::unique_fd fd;
+  shm::RingReader reader;
+};
+
+namespace {
+
+constexpr std::size_t kMinCapacity = 4096;
+constexpr std::size_t kReadChunk = 64 * 1024;
+
+Error make_errno_error(const char* context) {
+  return Error{.code = std::error_code(errno, std::system_category()), .context = context};
+}
+
+// Leading fields of shm::RingHeader; ftruncate leaves the rest zeroed.
+struct RingPreamble {
+  std::uint32_t magic;
+  std::uint32_t version;
+  std::uint64_t capacity;
+};
+
+}  // namespace
+
+ShmChannel::ShmChannel(std::shared_ptr<State> state) : state_(std::move(state)) {}
+
+Result<ShmChannel> ShmChannel::create(std::size_t capacity) {
+  capacity = std::bit_ceil(std::max(capacity, kMinCapacity));
+  internal::unique_fd fd(::memfd_create("procly-ring", MFD_CLOEXEC | MFD_ALLOW_SEALING));
+  if (!fd) {
+    return make_errno_error("memfd_create");
+  }
+  if (::ftruncate(fd.get(), static_cast<off_t>(shm::kRingDataOffset + capacity)) != 0) {
+    return make_errno_error("ftruncate");
+  }
+  // A child holding the descriptor could otherwise truncate the file under the parent's
+  // mapping and fault it with SIGBUS.
+  if (::fcntl(fd.get(), F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) != 0) {
+    return make_errno_error("F_ADD_SEALS");
+  }
+  RingPreamble preamble{
+      .magic = shm::kRingMagic, .version = shm::kRingVersion, .capacity = capacity};
+  if (::pwrite(fd.get(), &preamble, sizeof(preamble), 0) != sizeof(preamble)) {
+    return make_errno_error("pwrite");
+  }
+  auto reader = shm::RingReader::attach(fd.get());
+  if (!reader) {
+    return make_errno_error("mmap");
+  }
+  auto state = std::make_shared<State>();
+  state->fd = std::move(fd);
+  state->reader = std::move(*reader);
+  return ShmChannel(std::move(state));
+}
+
+int ShmChannel::native_handle() const noexcept { return state_->fd.get(); }
+
+Stdio ShmChannel::stdio() const {
+  return Stdio{Stdio::Fd{.fd = state_->fd.get(), .owner = state_}};
+}
+
+Result<std::size_t> ShmChannel::read_some(void* data, std::size_t n,
+                                          std::optional<std::chrono::milliseconds> timeout) const {
+  std::optional<std::chrono::steady_clock::time_point> deadline;
+  if (timeout) {
+    deadline = std::chrono::steady_clock::now() + *timeout;
+  }
+  auto& reader = state_->reader;
+  while (true) {
+    std::size_t count = reader.read_some(data, n);
+    if (reader.corrupt()) {
+      return Error{.code = make_error_code(errc::read_failed), .context = "shm_ring"};
+    }
+    if (count > 0 || n == 0 || reader.finished()) {
+      return count;
+    }
+    if (!reader.wait(deadline)) {
+      return Error{.code = make_error_code(errc::timeout), .context = "shm_read"};
+    }
+  }
+}
+
+Result<std::string> ShmChannel::read_all() const {
+  std::string out;
+  while (true) {
+    std::size_t size = out.size();
+    out.resize(size + kReadChunk);
+    auto count = read_some(out.data() + size, kReadChunk);
+    if (!count) {
+      return count.error();
+    }
+    out.resize(size + count.value());
+    if (count.value() == 0) {
+      return out;
+    }
+  }
+}
+
+void ShmChannel::close() const noexcept {
+  auto& header = state_->reader.mapping().header();
+  header.closed.store(1, std::memory_order_seq_cst);
+  shm::detail::wake(&header.data_seq, &header.reader_waiting);
+}
+
+}  // namespace procly
+
+#endif
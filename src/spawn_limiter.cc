@@ -0,0 +1,449 @@
+#include "procly/spawn_limiter.hpp"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "procly/backend.hpp"
+#include "procly/internal/fd.hpp"
+#include "procly/internal/poller.hpp"
+#include "procly/result.hpp"
+
+namespace procly {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr std::size_t kPriorityCount = 3;
+
+Error rejected_error() {
+  return Error{.code = std::make_error_code(std::errc::resource_unavailable_try_again),
+               .context = "spawn limiter"};
+}
+
+// Background thread that reports each watched (pid, key) once its exit handle polls readable.
+class ExitWatcher {
+ public:
+  using OnExit = std::function<void(int pid, std::uint64_t key)>;
+
+  explicit ExitWatcher(OnExit on_exit) : on_exit_(std::move(on_exit)) {}
+
+  ~ExitWatcher() {
+    {
+      std::lock_guard lock(mutex_);
+      stopping_ = true;
+    }
+    if (thread_.joinable()) {
+      wake();
+      thread_.join();
+    }
+  }
+
+  ExitWatcher(const ExitWatcher&) = delete;
+  ExitWatcher& operator=(const ExitWatcher&) = delete;
+
+  // False when the thread cannot be started, leaving pid unwatched.
+  bool watch(int pid, std::uint64_t key, internal::unique_fd handle) {
+    std::lock_guard lock(mutex_);
+    if (!thread_.joinable() && !start()) {
+      return false;
+    }
+    pending_.push_back(Watch{.pid = pid, .key = key, .handle = std::move(handle)});
+    wake();
+    return true;
+  }
+
+ private:
+  bool start() {
+    auto poller = internal::Poller::create();
+    auto pipe = internal::create_pipe();
+    if (!poller || !pipe) {
+      return false;
+    }
+    auto& [wake_read, wake_write] = pipe.value();
+    if (!internal::set_nonblocking(wake_read.get()) ||
+        !internal::set_nonblocking(wake_write.get()) ||
+        !poller->add(wake_read.get(), internal::Poller::Interest::readable)) {
+      return false;
+    }
+    poller_.emplace(std::move(poller.value()));
+    wake_read_ = std::move(wake_read);
+    wake_write_ = std::move(wake_write);
+    thread_ = std::thread([this] { run(); });
+    return true;
+  }
+
+  void wake() {
+    const char byte = 1;
+    // A full pipe already guarantees a wakeup.
+    (void)::write(wake_write_.get(), &byte, 1);
+  }
+
+  void run() {
+    std::vector<int> ready;
+    while (true) {
+      std::vector<Watch> added;
+      {
+        std::lock_guard lock(mutex_);
+        if (stopping_) {
+          return;
+        }
+        added.swap(pending_);
+      }
+      for (auto& watch : added) {
+        if (!poller_->add(watch.handle.get(), internal::Poller::Interest::readable)) {
+          on_exit_(watch.pid, watch.key);
+          continue;
+        }
+        int fd = watch.handle.get();
+        watched_.emplace(fd, std::move(watch));
+      }
+
+      ready.clear();
+      (void)poller_->wait(std::nullopt, &ready);
+      for (int fd : ready) {
+        if (fd == wake_read_.get()) {
+          std::array<char, 64> drain{};
+          while (::read(fd, drain.data(), drain.size()) > 0) {
+          }
+          continue;
+        }
+        auto it = watched_.find(fd);
+        if (it != watched_.end()) {
+          (void)poller_->remove(fd, internal::Poller::Interest::readable);
+          on_exit_(it->second.pid, it->second.key);
+          watched_.erase(it);
+        }
+      }
+    }
+  }
+
+  struct Watch {
+    int pid;
+    std::uint64_t key;
+    internal::unique_fd handle;
+  };
+
+  OnExit on_exit_;
+  std::mutex mutex_;
+  std::vector<Watch> pending_;
+  bool stopping_ = false;
+  internal::unique_fd wake_write_;
+
+  // Owned by the background thread once started.
+  std::optional<internal::Poller> poller_;
+  internal::unique_fd wake_read_;
+  std::unordered_map<int, Watch> watched_;
+  std::thread thread_;
+};
+
+}  // namespace
+
+struct SpawnLimiter::Impl {
+  // One backend per priority, so the priority travels with Command::backend().
+  class Gate final : public Backend {
+   public:
+    Gate(Impl& impl, SpawnPriority priority) : impl_(impl), priority_(priority) {}
+
+    Result<Spawned> spawn(const SpawnSpec& spec) override {
+      auto admitted = impl_.admit(priority_);
+      if (!admitted) {
+        return admitted.error();
+      }
+      auto spawned = impl_.inner_.spawn(spec);
+      if (!spawned) {
+        impl_.release_slot();
+        return spawned.error();
+      }
+      impl_.track(spawned->pid);
+      return spawned;
+    }
+
+    Result<WaitResult> wait(Spawned& spawned, std::optional<std::chrono::milliseconds> timeout,
+                            std::chrono::milliseconds kill_grace) override {
+      const int pid = spawned.pid;
+      auto result = impl_.inner_.wait(spawned, timeout, kill_grace);
+      if (spawned.terminal_result) {
+        impl_.forget(pid);
+      }
+      return result;
+    }
+
+    Result<std::optional<ExitStatus>> try_wait(Spawned& spawned) override {
+      const int pid = spawned.pid;
+      auto result = impl_.inner_.try_wait(spawned);
+      if (spawned.terminal_result) {
+        impl_.forget(pid);
+      }
+      return result;
+    }
+
+    Result<void> terminate(Spawned& spawned) override { return impl_.inner_.terminate(spawned); }
+
+    Result<void> kill(Spawned& spawned) override { return impl_.inner_.kill(spawned); }
+
+    Result<void> signal(Spawned& spawned, int signo) override {
+      return impl_.inner_.signal(spawned, signo);
+    }
+
+    // The child may outlive its last handle, so its slot is held until it really exits.
+    void abandon(Spawned& spawned) override {
+      const int pid = spawned.pid;
+      auto handle = impl_.inner_.open_exit_handle(spawned);
+      internal::unique_fd exit_fd(handle ? handle.value() : -1);
+      impl_.inner_.abandon(spawned);
+      const std::uint64_t key = impl_.hold_abandoned(pid);
+      if (key != 0 && (!exit_fd || !impl_.exits_.watch(pid, key, std::move(exit_fd)))) {
+        // No way to observe the exit; release the slot now rather than never.
+        impl_.release_abandoned(pid, key);
+      }
+    }
+
+    Result<int> open_exit_handle(const Spawned& spawned) override {
+      return impl_.inner_.open_exit_handle(spawned);
+    }
+
+   private:
+    Impl& impl_;
+    SpawnPriority priority_;
+  };
+
+  Impl(SpawnLimiterOptions options, Backend& inner)
+      : options_(std::move(options)),
+        inner_(inner),
+        capacity_(static_cast<double>(options_.burst != 0 ? options_.burst
+                                                          : options_.spawns_per_second)),
+        tokens_(capacity_),
+        refilled_(Clock::now()),
+        gates_{Gate(*this, SpawnPriority::low), Gate(*this, SpawnPriority::normal),
+               Gate(*this, SpawnPriority::high)} {}
+
+  Impl(const Impl&) = delete;
+  Impl& operator=(const Impl&) = delete;
+
+  Result<void> admit(SpawnPriority priority) {
+    const auto level = static_cast<std::size_t>(priority);
+    std::unique_lock lock(mutex_);
+    auto now = Clock::now();
+    refill(now);
+    if (!waiting_at_or_above(level) && has_capacity()) {
+      take();
+      return {};
+    }
+    if (options_.admission == Admission::fail_fast ||
+        (options_.max_queued != 0 && queued_ >= options_.max_queued)) {
+      ++rejected_;
+      return rejected_error();
+    }
+
+    const std::uint64_t ticket = next_ticket_++;
+    waiting_[level].push_back(ticket);
+    ++queued_;
+    peak_queued_ = std::max(peak_queued_, queued_);
+    std::optional<Clock::time_point> deadline;
+    if (options_.max_wait) {
+      deadline = now + *options_.max_wait;
+    }
+    while (true) {
+      refill(now);
+      const bool first = is_first(level, ticket);
+      if (first && has_capacity()) {
+        dequeue(level, ticket);
+        take();
+        // The next waiter may be admissible too.
+        cv_.notify_all();
+        return {};
+      }
+      if (deadline && now >= *deadline) {
+        dequeue(level, ticket);
+        ++rejected_;
+        cv_.notify_all();
+        return Error{.code = make_error_code(errc::timeout), .context = "spawn limiter"};
+      }
+      // Only the first waiter can be held up by the rate alone; it wakes when a token is due.
+      std::optional<Clock::time_point> wake = deadline;
+      if (first && has_live_slot()) {
+        auto token_due = now + std::chrono::duration_cast<Clock::duration>(
+                                   std::chrono::duration<double>(
+                                       (1.0 - tokens_) /
+                                       static_cast<double>(options_.spawns_per_second)));
+        wake = wake ? std::min(*wake, token_due) : token_due;
+      }
+      if (wake) {
+        cv_.wait_until(lock, *wake);
+      } else {
+        cv_.wait(lock);
+      }
+      now = Clock::now();
+    }
+  }
+
+  void track(int pid) {
+    std::lock_guard lock(mutex_);
+    if (pid > 0) {
+      // A reused pid means the abandoned child that held it has exited.
+      if (abandoned_.erase(pid) != 0) {
+        --live_;
+      }
+      live_pids_.insert(pid);
+      return;
+    }
+    --live_;
+    cv_.notify_all();
+  }
+
+  void forget(int pid) {
+    std::lock_guard lock(mutex_);
+    if (pid > 0 && live_pids_.erase(pid) != 0) {
+      --live_;
+      cv_.notify_all();
+    }
+  }
+
+  // Keeps the slot of a child whose last handle is gone; 0 when pid holds no slot.
+  std::uint64_t hold_abandoned(int pid) {
+    std::lock_guard lock(mutex_);
+    if (pid <= 0 || live_pids_.erase(pid) == 0) {
+      return 0;
+    }
+    const std::uint64_t key = ++next_abandoned_key_;
+    abandoned_[pid] = key;
+    return key;
+  }
+
+  // The abandoned child held under key has exited; stale keys are ignored.
+  void release_abandoned(int pid, std::uint64_t key) {
+    std::lock_guard lock(mutex_);
+    auto it = abandoned_.find(pid);
+    if (it != abandoned_.end() && it->second == key) {
+      abandoned_.erase(it);
+      --live_;
+      cv_.notify_all();
+    }
+  }
+
+  void release_slot() {
+    std::lock_guard lock(mutex_);
+    --live_;
+    cv_.notify_all();
+  }
+
+  SpawnLimiterStats stats() const {
+    std::lock_guard lock(mutex_);
+    return SpawnLimiterStats{.live = live_,
+                             .queued = queued_,
+                             .peak_queued = peak_queued_,
+                             .admitted = admitted_,
+                             .rejected = rejected_};
+  }
+
+  Backend& gate(SpawnPriority priority) noexcept {
+    return gates_[static_cast<std::size_t>(priority)];
+  }
+
+ private:
+  void refill(Clock::time_point now) {
+    if (options_.spawns_per_second == 0) {
+      return;
+    }
+    std::chrono::duration<double> elapsed = now - refilled_;
+    tokens_ = std::min(capacity_, tokens_ + elapsed.count() *
+                                                static_cast<double>(options_.spawns_per_second));
+    refilled_ = now;
+  }
+
+  [[nodiscard]] bool has_live_slot() const {
+    return options_.max_live == 0 || live_ < options_.max_live;
+  }
+
+  [[nodiscard]] bool has_capacity() const {
+    return has_live_slot() && (options_.spawns_per_second == 0 || tokens_ >= 1.0);
+  }
+
+  [[nodiscard]] bool waiting_at_or_above(std::size_t level) const {
+    for (std::size_t index = level; index < kPriorityCount; ++index) {
+      if (!waiting_[index].empty()) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  [[nodiscard]] bool is_first(std::size_t level, std::uint64_t ticket) const {
+    return !waiting_at_or_above(level + 1) && waiting_[level].front() == ticket;
+  }
+
+  void dequeue(std::size_t level, std::uint64_t ticket) {
+    auto& queue = waiting_[level];
+    queue.erase(std::find(queue.begin(), queue.end(), ticket));
+    --queued_;
+  }
+
+  // Claims a live slot for the spawn about to run and spends a rate token.
+  void take() {
+    ++live_;
+    ++admitted_;
+    if (options_.spawns_per_second != 0) {
+      tokens_ -= 1.0;
+    }
+  }
+
+  SpawnLimiterOptions options_;
+  Backend& inner_;
+  const double capacity_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable cv_;
+  double tokens_;
+  Clock::time_point refilled_;
+  // Live slots include spawns in flight; live_pids_ holds those already started.
+  std::size_t live_ = 0;
+  std::unordered_set<int> live_pids_;
+  // Started children whose handles were dropped before they exited, by pid.
+  std::unordered_map<int, std::uint64_t> abandoned_;
+  std::uint64_t next_abandoned_key_ = 0;
+  // FIFO of waiting tickets per priority.
+  std::array<std::deque<std::uint64_t>, kPriorityCount> waiting_;
+  std::uint64_t next_ticket_ = 0;
+  std::size_t queued_ = 0;
+  std::size_t peak_queued_ = 0;
+  std::uint64_t admitted_ = 0;
+  std::uint64_t rejected_ = 0;
+  std::array<Gate, kPriorityCount> gates_;
+  // Last member, so its thread stops before the state it reports into is destroyed.
+  ExitWatcher exits_{[this](int pid, std::uint64_t key) { release_abandoned(pid, key); }};
+};
+
+SpawnLimiter::Scope::Scope(SpawnLimiter& limiter, SpawnPriority priority)
+    : override_(std::make_unique<ScopedBackend>(limiter.backend(priority))) {}
+
+SpawnLimiter::Scope::~Scope() = default;
+
+SpawnLimiter::SpawnLimiter(SpawnLimiterOptions options, Backend* inner)
+    : impl_(std::make_unique<Impl>(std::move(options),
+                                   inner != nullptr ? *inner : default_backend())) {}
+
+SpawnLimiter::SpawnLimiter(SpawnLimiter&& other) noexcept = default;
+
+SpawnLimiter& SpawnLimiter::operator=(SpawnLimiter&& other) noexcept = default;
+
+SpawnLimiter::~SpawnLimiter() = default;
+
+Backend& SpawnLimiter::backend(SpawnPriority priority) noexcept { return impl_->gate(priority); }
+
+SpawnLimiterStats SpawnLimiter::stats() const { return impl_->stats(); }
+
+}  // namespace procly
@@ -0,0 +1,18 @@
+#include "procly/spill_buffer.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace procly {
+
+std::size_t SpillBuffer::read(std::size_t offset, char* out, std::size_t count) const noexcept {
+  std::string_view bytes = view();
+  if (offset >= bytes.size()) {
+    return 0;
+  }
+  std::size_t copied = std::min(count, bytes.size() - offset);
+  std::memcpy(out, bytes.data() + offset, copied);
+  return copied;
+}
+
+}  // namespace procly
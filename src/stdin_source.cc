@@ -0,0 +1,42 @@
+#include "procly/stdin_source.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace procly {
+
+StdinSource StdinSource::fill(FillCallback on_fill) {
+  StdinSource source;
+  source.on_fill_ = std::move(on_fill);
+  return source;
+}
+
+StdinSource StdinSource::chunks(ChunkCallback next_chunk) {
+  StdinSource source;
+  source.next_chunk_ = std::move(next_chunk);
+  return source;
+}
+
+bool StdinSource::next(std::string& chunk) {
+  if (on_fill_) {
+    // resize() keeps the capacity, so the buffer is allocated once per source.
+    chunk.resize(kFillBytes);
+    std::size_t count = on_fill_(chunk.data(), chunk.size());
+    chunk.resize(std::min(count, kFillBytes));
+    return !chunk.empty();
+  }
+  while (next_chunk_) {
+    std::optional<std::string> next = next_chunk_();
+    if (!next) {
+      break;
+    }
+    if (!next->empty()) {
+      chunk = std::move(*next);
+      return true;
+    }
+  }
+  chunk.clear();
+  return false;
+}
+
+}  // namespace procly
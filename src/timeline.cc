@@ -0,0 +1,15 @@
+#include "procly/timeline.hpp"
+
+namespace procly {
+
+std::string TimelineOutput::stream_data(OutputStream stream) const {
+  std::string out;
+  for (const TimelineRecord& record : records) {
+    if (record.stream == stream) {
+      out.append(bytes(record));
+    }
+  }
+  return out;
+}
+
+}  // namespace procly
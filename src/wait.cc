@@ -0,0 +1,402 @@
+#include "procly/wait.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+#include "procly/internal/poller.hpp"
+
+namespace procly {
+
+namespace {
+
+using SteadyClock = std::chrono::steady_clock;
+
+// Poll cadence when some handle has no exit descriptor (matches wait_with_timeout).
+constexpr auto kPollInterval = std::chrono::milliseconds(1);
+
+struct ChildTraits {
+  using Handle = Child;
+  using Outcome = WaitResult;
+
+  static Result<std::vector<int>> exit_handles(Child& child) {
+    auto handle = child.exit_handle();
+    if (!handle) {
+      return handle.error();
+    }
+    return std::vector<int>{handle.value()};
+  }
+
+  static Result<std::optional<WaitResult>> collect(Child& child) {
+    auto status = child.try_wait();
+    if (!status) {
+      return status.error();
+    }
+    if (!status.value()) {
+      return std::optional<WaitResult>();
+    }
+    // Already reaped, so this returns the cached result with its resource usage.
+    auto result = child.wait(WaitOptions{});
+    if (!result) {
+      return result.error();
+    }
+    return std::optional<WaitResult>(result.value());
+  }
+
+  static Result<void> terminate(Child& child) { return child.terminate(); }
+  static Result<void> kill(Child& child) { return child.kill(); }
+};
+
+struct PipelineTraits {
+  using Handle = PipelineChild;
+  using Outcome = PipelineWaitResult;
+
+  static Result<std::vector<int>> exit_handles(PipelineChild& pipeline) {
+    return pipeline.exit_handles();
+  }
+
+  static Result<std::optional<PipelineWaitResult>> collect(PipelineChild& pipeline) {
+    auto status = pipeline.try_wait();
+    if (!status) {
+      return status.error();
+    }
+    if (!status.value()) {
+      return std::optional<PipelineWaitResult>();
+    }
+    PipelineWaitResult result;
+    result.status = std::move(*status.value());
+    return std::optional<PipelineWaitResult>(std::move(result));
+  }
+
+  static Result<void> terminate(PipelineChild& pipeline) { return pipeline.terminate(); }
+  static Result<void> kill(PipelineChild& pipeline) { return pipeline.kill(); }
+};
+
+bool is_esrch(const Error& error) {
+  return error.code.category() == std::system_category() && error.code.value() == ESRCH;
+}
+
+// A fixed set of handles waited on together: one poller over every exit descriptor, or a
+// try_wait poll when some handle has none.
+template <typename Traits>
+class WaitSet {
+ public:
+  using Handle = typename Traits::Handle;
+  using Outcome = typename Traits::Outcome;
+
+  WaitSet(Handle* const* handles, std::size_t count)
+      : handles_(handles, handles + count), outcomes_(count), flags_(count) {}
+
+  Result<void> open() {
+    auto poller = internal::Poller::create();
+    if (!poller) {
+      return poller.error();
+    }
+    poller_.emplace(std::move(poller.value()));
+    for (std::size_t index = 0; index < handles_.size(); ++index) {
+      if (handles_[index] == nullptr) {
+        continue;
+      }
+      ++pending_;
+      auto fds = Traits::exit_handles(*handles_[index]);
+      if (!fds) {
+        // No exit notification (e.g. a custom backend): fall back to polling.
+        poller_.reset();
+        continue;
+      }
+      if (!poller_) {
+        continue;
+      }
+      for (int fd : fds.value()) {
+        auto added = poller_->add(fd, internal::Poller::Interest::readable);
+        if (!added) {
+          return added.error();
+        }
+        owners_.emplace(fd, index);
+      }
+      fd_counts_.emplace(index, fds.value().size());
+    }
+    if (!poller_) {
+      owners_.clear();
+    }
+    return {};
+  }
+
+  [[nodiscard]] std::size_t pending() const noexcept { return pending_; }
+  [[nodiscard]] std::vector<std::optional<Outcome>>& outcomes() noexcept { return outcomes_; }
+
+  // Collect every pending handle that has finished, in index order. Returns the lowest index
+  // collected by this call, if any.
+  Result<std::optional<std::size_t>> collect_all() {
+    std::optional<std::size_t> first;
+    for (std::size_t index = 0; index < handles_.size(); ++index) {
+      auto collected = collect(index);
+      if (!collected) {
+        return collected.error();
+      }
+      if (collected.value() && !first) {
+        first = index;
+      }
+    }
+    return first;
+  }
+
+  // Block until some pending handle may have finished or deadline passes, then collect.
+  // Returns the lowest index collected, if any.
+  Result<std::optional<std::size_t>> wait_some(std::optional<SteadyClock::time_point> deadline) {
+    std::optional<std::chrono::milliseconds> budget;
+    if (deadline) {
+      budget = std::max(std::chrono::ceil<std::chrono::milliseconds>(*deadline - SteadyClock::now()),
+                        std::chrono::milliseconds(0));
+    }
+    if (!poller_) {
+      std::this_thread::sleep_for(budget ? std::min(*budget, kPollInterval) : kPollInterval);
+      return collect_all();
+    }
+    ready_.clear();
+    auto waited = poller_->wait(budget, &ready_);
+    if (!waited) {
+      return waited.error();
+    }
+    std::optional<std::size_t> first;
+    for (int fd : ready_) {
+      auto owner = owners_.find(fd);
+      if (owner == owners_.end()) {
+        continue;
+      }
+      std::size_t index = owner->second;
+      auto collected = collect(index);
+      if (!collected) {
+        return collected.error();
+      }
+      if (collected.value()) {
+        first = first ? std::min(*first, index) : index;
+      } else if (fd_counts_[index] > 1) {
+        // One stage of a pipeline exited; its descriptor stays readable, so stop watching it.
+        forget(fd);
+        --fd_counts_[index];
+      }
+    }
+    return first;
+  }
+
+  // Signal every pending handle and flag its eventual outcome.
+  Result<void> escalate(bool kill) {
+    for (std::size_t index = 0; index < handles_.size(); ++index) {
+      if (handles_[index] == nullptr || outcomes_[index]) {
+        continue;
+      }
+      auto sent = kill ? Traits::kill(*handles_[index]) : Traits::terminate(*handles_[index]);
+      if (!sent && !is_esrch(sent.error())) {
+        return sent.error();
+      }
+      auto& flags = flags_[index];
+      flags.timed_out = true;
+      (kill ? flags.sent_kill : flags.sent_terminate) = sent.has_value();
+    }
+    return {};
+  }
+
+ private:
+  struct Flags {
+    bool timed_out = false;
+    bool sent_terminate = false;
+    bool sent_kill = false;
+  };
+
+  Result<bool> collect(std::size_t index) {
+    if (handles_[index] == nullptr || outcomes_[index]) {
+      return false;
+    }
+    auto outcome = Traits::collect(*handles_[index]);
+    if (!outcome) {
+      return outcome.error();
+    }
+    if (!outcome.value()) {
+      return false;
+    }
+    Outcome& done = outcomes_[index].emplace(std::move(*outcome.value()));
+    done.timed_out = flags_[index].timed_out;
+    done.sent_terminate = flags_[index].sent_terminate;
+    done.sent_kill = flags_[index].sent_kill;
+    --pending_;
+    if (poller_) {
+      for (auto it = owners_.begin(); it != owners_.end();) {
+        if (it->second == index) {
+          (void)poller_->remove(it->first, internal::Poller::Interest::readable);
+          it = owners_.erase(it);
+        } else {
+          ++it;
+        }
+      }
+    }
+    return true;
+  }
+
+  void forget(int fd) {
+    (void)poller_->remove(fd, internal::Poller::Interest::readable);
+    owners_.erase(fd);
+  }
+
+  std::vector<Handle*> handles_;
+  std::vector<std::optional<Outcome>> outcomes_;
+  std::vector<Flags> flags_;
+  std::size_t pending_ = 0;
+  std::optional<internal::Poller> poller_;
+  std::unordered_map<int, std::size_t> owners_;
+  std::unordered_map<std::size_t, std::size_t> fd_counts_;
+  std::vector<int> ready_;
+};
+
+Error empty_set_error(const char* context) {
+  return Error{.code = std::make_error_code(std::errc::invalid_argument), .context = context};
+}
+
+template <typename Traits>
+Result<std::optional<std::pair<std::size_t, typename Traits::Outcome>>> wait_any_impl(
+    typename Traits::Handle* const* handles, std::size_t count,
+    std::optional<std::chrono::milliseconds> timeout) {
+  using Found = std::optional<std::pair<std::size_t, typename Traits::Outcome>>;
+  WaitSet<Traits> set(handles, count);
+  auto opened = set.open();
+  if (!opened) {
+    return opened.error();
+  }
+  if (set.pending() == 0) {
+    return empty_set_error("wait_any");
+  }
+  std::optional<SteadyClock::time_point> deadline;
+  if (timeout) {
+    deadline = SteadyClock::now() + *timeout;
+  }
+  auto found = set.collect_all();
+  while (found && !found.value()) {
+    if (deadline && SteadyClock::now() >= *deadline) {
+      return Found();
+    }
+    found = set.wait_some(deadline);
+  }
+  if (!found) {
+    return found.error();
+  }
+  std::size_t index = *found.value();
+  return Found(std::in_place, index, std::move(*set.outcomes()[index]));
+}
+
+template <typename Traits>
+Result<std::vector<typename Traits::Outcome>> wait_all_impl(typename Traits::Handle* const* handles,
+                                                            std::size_t count,
+                                                            WaitOptions options) {
+  WaitSet<Traits> set(handles, count);
+  auto opened = set.open();
+  if (!opened) {
+    return opened.error();
+  }
+  auto drain = [&](std::optional<SteadyClock::time_point> deadline) -> Result<void> {
+    auto collected = set.collect_all();
+    while (collected && set.pending() != 0) {
+      if (deadline && SteadyClock::now() >= *deadline) {
+        return {};
+      }
+      collected = set.wait_some(deadline);
+    }
+    if (!collected) {
+      return collected.error();
+    }
+    return {};
+  };
+
+  std::optional<SteadyClock::time_point> deadline;
+  if (options.timeout) {
+    deadline = SteadyClock::now() + *options.timeout;
+  }
+  auto phase = drain(deadline);
+  if (phase && set.pending() != 0) {
+    phase = set.escalate(false);
+    if (phase) {
+      phase = drain(SteadyClock::now() + options.kill_grace);
+    }
+  }
+  if (phase && set.pending() != 0) {
+    phase = set.escalate(true);
+    if (phase) {
+      phase = drain(std::nullopt);
+    }
+  }
+  if (!phase) {
+    return phase.error();
+  }
+
+  std::vector<typename Traits::Outcome> results;
+  results.reserve(count);
+  for (auto& outcome : set.outcomes()) {
+    results.push_back(outcome ? std::move(*outcome) : typename Traits::Outcome{});
+  }
+  return results;
+}
+
+}  // namespace
+
+Result<std::optional<WaitAnyResult>> wait_any(Child* const* children, std::size_t count,
+                                              std::optional<std::chrono::milliseconds> timeout) {
+  auto found = wait_any_impl<ChildTraits>(children, count, timeout);
+  if (!found) {
+    return found.error();
+  }
+  if (!found.value()) {
+    return std::optional<WaitAnyResult>();
+  }
+  return std::optional<WaitAnyResult>(
+      WaitAnyResult{.index = found.value()->first, .result = std::move(found.value()->second)});
+}
+
+Result<std::vector<WaitResult>> wait_all(Child* const* children, std::size_t count,
+                                         WaitOptions options) {
+  return wait_all_impl<ChildTraits>(children, count, options);
+}
+
+Result<std::optional<PipelineWaitAnyResult>> wait_any(
+    PipelineChild* const* pipelines, std::size_t count,
+    std::optional<std::chrono::milliseconds> timeout) {
+  auto found = wait_any_impl<PipelineTraits>(pipelines, count, timeout);
+  if (!found) {
+    return found.error();
+  }
+  if (!found.value()) {
+    return std::optional<PipelineWaitAnyResult>();
+  }
+  return std::optional<PipelineWaitAnyResult>(PipelineWaitAnyResult{
+      .index = found.value()->first, .status = std::move(found.value()->second.status)});
+}
+
+Result<std::vector<PipelineWaitResult>> wait_all(PipelineChild* const* pipelines,
+                                                 std::size_t count, WaitOptions options) {
+  return wait_all_impl<PipelineTraits>(pipelines, count, options);
+}
+
+#if PROCLY_HAS_STD_SPAN
+Result<std::optional<WaitAnyResult>> wait_any(std::span<Child* const> children,
+                                              std::optional<std::chrono::milliseconds> timeout) {
+  return wait_any(children.data(), children.size(), timeout);
+}
+
+Result<std::vector<WaitResult>> wait_all(std::span<Child* const> children, WaitOptions options) {
+  return wait_all(children.data(), children.size(), options);
+}
+
+Result<std::optional<PipelineWaitAnyResult>> wait_any(
+    std::span<PipelineChild* const> pipelines, std::optional<std::chrono::milliseconds> timeout) {
+  return wait_any(pipelines.data(), pipelines.size(), timeout);
+}
+
+Result<std::vector<PipelineWaitResult>> wait_all(std::span<PipelineChild* const> pipelines,
+                                                 WaitOptions options) {
+  return wait_all(pipelines.data(), pipelines.size(), options);
+}
+#endif
+
+}  // namespace procly
@@ -0,0 +1,348 @@
+#include "procly/worker_pool.hpp"
+
+#include <poll.h>
+
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "procly/internal/fd.hpp"
+#include "procly/pipe.hpp"
+#include "procly/stdio.hpp"
+
+namespace procly {
+
+namespace {
+
+constexpr std::size_t kLengthPrefixBytes = 4;
+constexpr std::size_t kReadChunkBytes = 8192;
+
+Error make_errno_error(const char* context) {
+  return Error{.code = std::error_code(errno, std::system_category()), .context = context};
+}
+
+bool would_block(const Error& error) {
+  return error.code == std::errc::resource_unavailable_try_again ||
+         error.code == std::errc::operation_would_block;
+}
+
+struct Worker {
+  std::optional<Child> child;
+  PipeWriter input;
+  PipeReader output;
+  // Bytes read past the previous response.
+  std::string pending;
+};
+
+Error response_too_large() {
+  return Error{.code = make_error_code(errc::read_failed),
+               .context = "worker response exceeds max_response_bytes"};
+}
+
+// Remove one complete response from the front of pending, if it holds one yet.
+Result<std::optional<std::string>> take_frame(const WorkerPoolOptions& options,
+                                              std::string& pending) {
+  const auto& limit = options.max_response_bytes;
+  if (options.framing == WorkerFraming::newline) {
+    auto end = pending.find('\n');
+    if (end == std::string::npos) {
+      if (limit && pending.size() > *limit) {
+        return response_too_large();
+      }
+      return std::optional<std::string>();
+    }
+    if (limit && end > *limit) {
+      return response_too_large();
+    }
+    std::string frame = pending.substr(0, end);
+    pending.erase(0, end + 1);
+    return std::optional<std::string>(std::move(frame));
+  }
+
+  if (pending.size() < kLengthPrefixBytes) {
+    return std::optional<std::string>();
+  }
+  std::size_t length = 0;
+  for (std::size_t index = 0; index < kLengthPrefixBytes; ++index) {
+    length = (length << 8U) | static_cast<unsigned char>(pending[index]);
+  }
+  if (limit && length > *limit) {
+    return response_too_large();
+  }
+  if (pending.size() < kLengthPrefixBytes + length) {
+    pending.reserve(kLengthPrefixBytes + length);
+    return std::optional<std::string>();
+  }
+  std::string frame = pending.substr(kLengthPrefixBytes, length);
+  pending.erase(0, kLengthPrefixBytes + length);
+  return std::optional<std::string>(std::move(frame));
+}
+
+// Write the framed request and read one response, both from a single poll loop so a
+// worker that answers while its stdin is still draining cannot deadlock us.
+Result<std::string> exchange(const WorkerPoolOptions& options, Worker& worker,
+                             std::string_view request) {
+  std::array<char, kLengthPrefixBytes> header{};
+  std::array<std::string_view, 2> parts;
+  if (options.framing == WorkerFraming::length_prefixed) {
+    auto length = static_cast<std::uint32_t>(request.size());
+    for (std::size_t index = 0; index < kLengthPrefixBytes; ++index) {
+      header[kLengthPrefixBytes - 1 - index] = static_cast<char>((length >> (8U * index)) & 0xFFU);
+    }
+    parts = {std::string_view(header.data(), header.size()), request};
+  } else {
+    parts = {request, std::string_view("\n", 1)};
+  }
+
+  std::optional<std::chrono::steady_clock::time_point> deadline;
+  if (options.request_timeout) {
+    deadline = std::chrono::steady_clock::now() + *options.request_timeout;
+  }
+
+  std::size_t part = 0;
+  std::size_t offset = 0;
+  std::optional<std::string> response;
+  std::array<char, kReadChunkBytes> chunk{};
+  while (true) {
+    while (part < parts.size() && offset == parts[part].size()) {
+      ++part;
+      offset = 0;
+    }
+    if (!response) {
+      auto frame = take_frame(options, worker.pending);
+      if (!frame) {
+        return frame.error();
+      }
+      response = std::move(frame.value());
+    }
+    const bool writing = part < parts.size();
+    if (!writing && response) {
+      return std::move(*response);
+    }
+
+    std::array<pollfd, 2> fds{};
+    nfds_t count = 0;
+    if (writing) {
+      fds[count++] = pollfd{.fd = worker.input.native_handle(), .events = POLLOUT, .revents = 0};
+    }
+    if (!response) {
+      fds[count++] = pollfd{.fd = worker.output.native_handle(), .events = POLLIN, .revents = 0};
+    }
+
+    int timeout_ms = -1;
+    if (deadline) {
+      auto now = std::chrono::steady_clock::now();
+      if (now >= *deadline) {
+        return Error{.code = make_error_code(errc::timeout), .context = "worker request"};
+      }
+      timeout_ms = static_cast<int>(
+          std::chrono::ceil<std::chrono::milliseconds>(*deadline - now).count());
+    }
+    if (::poll(fds.data(), count, timeout_ms) == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return make_errno_error("poll");
+    }
+
+    std::size_t slot = 0;
+    if (writing && fds[slot++].revents != 0) {
+      auto written = worker.input.write_some(parts[part].data() + offset,
+                                             parts[part].size() - offset);
+      if (!written) {
+        if (!would_block(written.error())) {
+          return written.error();
+        }
+      } else {
+        offset += written.value();
+      }
+    }
+    if (!response && fds[slot].revents != 0) {
+      auto read = worker.output.read_some(chunk.data(), chunk.size());
+      if (!read) {
+        if (!would_block(read.error())) {
+          return read.error();
+        }
+      } else if (read.value() == 0) {
+        return Error{.code = make_error_code(errc::read_failed), .context = "worker exited"};
+      } else {
+        worker.pending.append(chunk.data(), read.value());
+      }
+    }
+  }
+}
+
+}  // namespace
+
+struct WorkerPool::Impl {
+  Command command;
+  WorkerPoolOptions options;
+  std::vector<Worker> workers;
+  std::atomic<std::uint64_t> restarts{0};
+
+  std::mutex idle_mutex;
+  std::condition_variable idle_ready;
+  std::vector<std::size_t> idle;
+
+  Impl(Command cmd, WorkerPoolOptions opts)
+      : command(std::move(cmd)), options(opts), workers(opts.workers) {}
+  Impl(const Impl&) = delete;
+  Impl& operator=(const Impl&) = delete;
+
+  ~Impl() {
+    // Close every stdin first so the workers wind down in parallel.
+    for (auto& worker : workers) {
+      worker.input.close();
+    }
+    for (auto& worker : workers) {
+      if (worker.child) {
+        (void)worker.child->wait(
+            WaitOptions{.timeout = options.kill_grace, .kill_grace = options.kill_grace});
+      }
+    }
+  }
+
+  Result<void> spawn(Worker& worker) {
+    auto child = command.spawn();
+    if (!child) {
+      return child.error();
+    }
+    auto input = child->take_stdin();
+    auto output = child->take_stdout();
+    worker.child = std::move(child.value());
+    worker.pending.clear();
+    if (!input || !output) {
+      retire(worker);
+      return Error{.code = make_error_code(errc::invalid_stdio), .context = "worker stdio"};
+    }
+    worker.input = std::move(*input);
+    worker.output = std::move(*output);
+    for (int fd : {worker.input.native_handle(), worker.output.native_handle()}) {
+      auto nonblocking = internal::set_nonblocking(fd);
+      if (!nonblocking) {
+        retire(worker);
+        return nonblocking.error();
+      }
+    }
+    return {};
+  }
+
+  // Stop and reap a worker that is no longer trusted with requests.
+  void retire(Worker& worker) {
+    worker.input.close();
+    worker.output.close();
+    worker.pending.clear();
+    if (worker.child) {
+      (void)worker.child->wait(
+          WaitOptions{.timeout = std::chrono::milliseconds(0), .kill_grace = options.kill_grace});
+      worker.child.reset();
+    }
+  }
+
+  // A failed respawn leaves the slot empty; the next call on it spawns again.
+  void replace(Worker& worker) {
+    retire(worker);
+    restarts.fetch_add(1, std::memory_order_relaxed);
+    (void)spawn(worker);
+  }
+
+  Result<void> ensure_running(Worker& worker) {
+    if (worker.child) {
+      auto exited = worker.child->try_wait();
+      if (!exited) {
+        return exited.error();
+      }
+      if (!exited.value().has_value()) {
+        return {};
+      }
+      replace(worker);
+      if (worker.child) {
+        return {};
+      }
+    }
+    return spawn(worker);
+  }
+
+  std::size_t acquire() {
+    std::unique_lock<std::mutex> lock(idle_mutex);
+    idle_ready.wait(lock, [this] { return !idle.empty(); });
+    std::size_t slot = idle.back();
+    idle.pop_back();
+    return slot;
+  }
+
+  void release(std::size_t slot) {
+    {
+      std::lock_guard<std::mutex> lock(idle_mutex);
+      idle.push_back(slot);
+    }
+    idle_ready.notify_one();
+  }
+};
+
+Result<WorkerPool> WorkerPool::start(Command command, WorkerPoolOptions options) {
+  if (options.workers == 0) {
+    return Error{.code = make_error_code(errc::invalid_argument), .context = "workers"};
+  }
+  command.stdin(Stdio::piped()).stdout(Stdio::piped());
+  auto impl = std::make_unique<Impl>(std::move(command), options);
+  impl->idle.reserve(options.workers);
+  for (std::size_t slot = 0; slot < options.workers; ++slot) {
+    auto spawned = impl->spawn(impl->workers[slot]);
+    if (!spawned) {
+      return spawned.error();
+    }
+    impl->idle.push_back(options.workers - 1 - slot);
+  }
+  return WorkerPool(std::move(impl));
+}
+
+WorkerPool::WorkerPool(std::unique_ptr<Impl> impl) noexcept : impl_(std::move(impl)) {}
+
+WorkerPool::WorkerPool(WorkerPool&& other) noexcept = default;
+
+WorkerPool& WorkerPool::operator=(WorkerPool&& other) noexcept = default;
+
+WorkerPool::~WorkerPool() = default;
+
+Result<std::string> WorkerPool::call(std::string_view request) {
+  auto& impl = *impl_;
+  if (impl.options.framing == WorkerFraming::newline &&
+      request.find('\n') != std::string_view::npos) {
+    return Error{.code = make_error_code(errc::invalid_argument), .context = "worker request"};
+  }
+  if (impl.options.framing == WorkerFraming::length_prefixed &&
+      request.size() > std::numeric_limits<std::uint32_t>::max()) {
+    return Error{.code = make_error_code(errc::invalid_argument), .context = "worker request"};
+  }
+
+  std::size_t slot = impl.acquire();
+  Worker& worker = impl.workers[slot];
+  auto result = [&]() -> Result<std::string> {
+    auto running = impl.ensure_running(worker);
+    if (!running) {
+      return running.error();
+    }
+    return exchange(impl.options, worker, request);
+  }();
+  // Any failure with a live worker leaves its pipes in an unknown state.
+  if (!result && worker.child) {
+    impl.replace(worker);
+  }
+  impl.release(slot);
+  return result;
+}
+
+std::size_t WorkerPool::size() const noexcept { return impl_ ? impl_->workers.size() : 0; }
+
+std::uint64_t WorkerPool::restarts() const noexcept {
+  return impl_ ? impl_->restarts.load(std::memory_order_relaxed) : 0;
+}
+
+}  // namespace procly
@@ -0,0 +1,334 @@
+#include "procly/zygote.hpp"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <array>
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "procly/backend.hpp"
+#include "procly/internal/access.hpp"
+#include "procly/internal/command_run.hpp"
+#include "procly/internal/fd.hpp"
+#include "procly/internal/lowering.hpp"
+#include "procly/internal/posix_wait.hpp"
+#include "procly/internal/remote_backend.hpp"
+#include "procly/zygote_serve.hpp"
+
+namespace procly {
+
+namespace {
+
+using internal::unique_fd;
+using zygote::Frame;
+using zygote::FrameType;
+
+Error make_errno_error(const char* context) {
+  return Error{.code = std::error_code(errno, std::system_category()), .context = context};
+}
+
+Error protocol_error() {
+  return Error{.code = make_error_code(errc::spawn_failed), .context = "zygote protocol"};
+}
+
+// Descriptors of one fork request: what is sent, what this side opened, and the parent pipe ends.
+struct ForkStreams {
+  std::uint32_t flags = 0;
+  std::vector<int> sent;
+  std::vector<unique_fd> owned;
+  std::array<std::optional<unique_fd>, 3> parent_ends;
+};
+
+Result<void> add_stream(const StdioSpec& spec, int target, ForkStreams& streams) {
+  int fd = -1;
+  switch (spec.kind) {
+    case StdioSpec::Kind::inherit:
+      return {};
+    case StdioSpec::Kind::dup_stdout:
+      if (target != STDERR_FILENO) {
+        return Error{.code = make_error_code(errc::invalid_stdio), .context = "stdio"};
+      }
+      streams.flags |= zygote::kForkStderrToStdout;
+      return {};
+    case StdioSpec::Kind::null: {
+      unique_fd file(::open("/dev/null", O_RDWR | O_CLOEXEC));
+      if (!file) {
+        return make_errno_error("open(/dev/null)");
+      }
+      fd = file.get();
+      streams.owned.push_back(std::move(file));
+      break;
+    }
+    case StdioSpec::Kind::file: {
+      constexpr FilePerms kFileMode = 0666;
+      unique_fd file(::open(spec.path.c_str(), internal::open_flags_for(spec.mode) | O_CLOEXEC,
+                            static_cast<int>(spec.perms.value_or(kFileMode))));
+      if (!file) {
+        return make_errno_error("open(file)");
+      }
+      fd = file.get();
+      streams.owned.push_back(std::move(file));
+      break;
+    }
+    case StdioSpec::Kind::fd:
+      fd = spec.fd;
+      break;
+    case StdioSpec::Kind::piped: {
+      auto pipe = spec.pipe_capacity > 0 ? internal::create_pipe(spec.pipe_capacity)
+                                         : internal::create_pipe();
+      if (!pipe) {
+        return pipe.error();
+      }
+      const bool child_reads = target == STDIN_FILENO;
+      unique_fd& child_end = child_reads ? pipe->first : pipe->second;
+      unique_fd& parent_end = child_reads ? pipe->second : pipe->first;
+      fd = child_end.get();
+      streams.owned.push_back(std::move(child_end));
+      streams.parent_ends[static_cast<std::size_t>(target)] = std::move(parent_end);
+      break;
+    }
+  }
+  streams.flags |= 1U << static_cast<unsigned>(target);
+  streams.sent.push_back(fd);
+  return {};
+}
+
+}  // namespace
+
+struct Zygote::Impl final : internal::RemoteBackend<Frame> {
+  Impl(Child template_child, unique_fd socket)
+      : RemoteBackend("zygote disconnected"),
+        template_(std::move(template_child)),
+        socket_(std::move(socket)) {}
+
+  Impl(const Impl&) = delete;
+  Impl& operator=(const Impl&) = delete;
+
+  ~Impl() override {
+    ::shutdown(socket_.get(), SHUT_RDWR);
+    if (reader_.joinable()) {
+      reader_.join();
+    }
+    (void)template_.wait();
+  }
+
+  // Read the template's ready frame; the reader thread starts only afterwards.
+  Result<void> wait_ready(std::chrono::milliseconds timeout) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (true) {
+      auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+          deadline - std::chrono::steady_clock::now());
+      pollfd watched{.fd = socket_.get(), .events = POLLIN, .revents = 0};
+      int ready = ::poll(&watched, 1, static_cast<int>(std::max<std::int64_t>(left.count(), 0)));
+      if (ready == -1 && errno == EINTR) {
+        continue;
+      }
+      if (ready == -1) {
+        (void)template_.kill();
+        return make_errno_error("poll");
+      }
+      if (ready == 0) {
+        (void)template_.kill();
+        return Error{.code = make_error_code(errc::timeout), .context = "zygote ready"};
+      }
+      break;
+    }
+    Frame frame{};
+    std::array<int, zygote::kMaxFrameFds> fds{};
+    std::size_t count = 0;
+    if (!zygote::detail::recv_frame(socket_.get(), &frame, &fds, &count)) {
+      (void)template_.kill();
+      return Error{.code = make_error_code(errc::spawn_failed), .context = "zygote ready"};
+    }
+    for (std::size_t index = 0; index < count; ++index) {
+      ::close(fds[index]);
+    }
+    if (frame.type != static_cast<std::uint32_t>(FrameType::ready)) {
+      (void)template_.kill();
+      return protocol_error();
+    }
+    reader_ = std::thread([this] { read_loop(); });
+    return {};
+  }
+
+  Result<Spawned> spawn(const SpawnSpec& spec) override {
+    ForkStreams streams;
+    for (const auto& [stdio, target] : {std::pair{&spec.stdin_spec, STDIN_FILENO},
+                                        std::pair{&spec.stdout_spec, STDOUT_FILENO},
+                                        std::pair{&spec.stderr_spec, STDERR_FILENO}}) {
+      auto added = add_stream(*stdio, target, streams);
+      if (!added) {
+        return added.error();
+      }
+    }
+    Frame frame = zygote::detail::make_frame(FrameType::fork, 0, 0, 0);
+    frame.flags = streams.flags;
+    auto reply = request(frame, streams.sent);
+    if (!reply) {
+      return reply.error();
+    }
+    if (reply->pid <= 0) {
+      return Error{.code = std::error_code(reply->value, std::system_category()),
+                   .context = "zygote fork"};
+    }
+    Spawned spawned;
+    spawned.pid = reply->pid;
+    std::size_t index = 0;
+    for (auto* fd : {&spawned.stdin_fd, &spawned.stdout_fd, &spawned.stderr_fd}) {
+      if (auto& end = streams.parent_ends[index++]) {
+        *fd = end->release();
+      }
+    }
+    return spawned;
+  }
+
+  Result<void> signal(Spawned& spawned, int signo) override {
+    if (spawned.terminal_result) {
+      return {};
+    }
+    if (spawned.pid <= 0) {
+      return Error{.code = make_error_code(errc::kill_failed), .context = "kill"};
+    }
+    auto reply =
+        request(zygote::detail::make_frame(FrameType::signal, 0, spawned.pid, signo), {});
+    if (!reply) {
+      return reply.error();
+    }
+    if (reply->value != 0) {
+      return Error{.code = std::error_code(reply->value, std::system_category()),
+                   .context = "kill"};
+    }
+    return {};
+  }
+
+  [[nodiscard]] int id() const noexcept { return template_.id(); }
+
+ private:
+  Result<Frame> request(Frame frame, const std::vector<int>& fds) {
+    return RemoteBackend::request([&](std::uint64_t id) -> Result<void> {
+      frame.id = id;
+      if (!zygote::detail::send_frame(socket_.get(), frame, fds.data(), fds.size())) {
+        return make_errno_error("sendmsg");
+      }
+      return {};
+    });
+  }
+
+  void read_loop() {
+    while (true) {
+      Frame frame{};
+      std::array<int, zygote::kMaxFrameFds> fds{};
+      std::size_t count = 0;
+      if (!zygote::detail::recv_frame(socket_.get(), &frame, &fds, &count)) {
+        break;
+      }
+      for (std::size_t index = 0; index < count; ++index) {
+        ::close(fds[index]);
+      }
+      if (frame.type == static_cast<std::uint32_t>(FrameType::exited)) {
+        deliver_exit(frame.pid, internal::to_exit_status(frame.value));
+        continue;
+      }
+      std::optional<int> spawned_pid;
+      if (frame.type == static_cast<std::uint32_t>(FrameType::fork_reply) && frame.pid > 0) {
+        spawned_pid = frame.pid;
+      }
+      deliver_reply(frame.id, frame, spawned_pid);
+    }
+    disconnect();
+  }
+
+  Child template_;
+  unique_fd socket_;
+  std::thread reader_;
+};
+
+Result<Zygote> Zygote::start(Command command, std::chrono::milliseconds ready_timeout) {
+  std::array<int, 2> sockets{-1, -1};
+  if (::socketpair(AF_UNIX, SOCK_STREAM, 0, sockets.data()) == -1) {
+    return make_errno_error("socketpair");
+  }
+  unique_fd client(sockets[0]);
+  unique_fd server(sockets[1]);
+  for (const auto& fd : {client.get(), server.get()}) {
+    auto cloexec = internal::set_cloexec(fd);
+    if (!cloexec) {
+      return cloexec.error();
+    }
+#if defined(SO_NOSIGPIPE)
+    int enabled = 1;
+    ::setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &enabled, sizeof(enabled));
+#endif
+  }
+
+  // The template reaches the socket as its stdin until serve() moves it aside.
+  command.stdin(Stdio::fd(server.get()));
+  command.env(zygote::kControlFdEnv, "0");
+  auto child = command.spawn();
+  server.reset(-1);
+  if (!child) {
+    return child.error();
+  }
+  auto impl = std::make_unique<Impl>(std::move(child.value()), std::move(client));
+  auto ready = impl->wait_ready(ready_timeout);
+  if (!ready) {
+    return ready.error();
+  }
+  return Zygote(std::move(impl));
+}
+
+Zygote::Zygote(std::unique_ptr<Impl> impl) noexcept : impl_(std::move(impl)) {}
+
+Zygote::Zygote(Zygote&& other) noexcept = default;
+
+Zygote& Zygote::operator=(Zygote&& other) noexcept = default;
+
+Zygote::~Zygote() = default;
+
+Result<Child> Zygote::fork(const Stdio& stdin_cfg, const Stdio& stdout_cfg,
+                           const Stdio& stderr_cfg) {
+  if (!impl_) {
+    return Error{.code = make_error_code(errc::invalid_argument), .context = "zygote"};
+  }
+  internal::SpawnSpec spec;
+  auto stdin_spec = internal::resolve_stdio(stdin_cfg, false, internal::StdioTarget::stdin);
+  if (!stdin_spec) {
+    return stdin_spec.error();
+  }
+  auto stdout_spec = internal::resolve_stdio(stdout_cfg, false, internal::StdioTarget::stdout);
+  if (!stdout_spec) {
+    return stdout_spec.error();
+  }
+  auto stderr_spec = internal::resolve_stdio(stderr_cfg, false, internal::StdioTarget::stderr);
+  if (!stderr_spec) {
+    return stderr_spec.error();
+  }
+  spec.stdin_spec = std::move(stdin_spec.value());
+  spec.stdout_spec = std::move(stdout_spec.value());
+  spec.stderr_spec = std::move(stderr_spec.value());
+  auto spawned = internal::spawn_lowered(spec, impl_.get());
+  if (!spawned) {
+    return spawned.error();
+  }
+  return internal::ChildAccess::from_spawned(spawned.value());
+}
+
+Result<Output> Zygote::output(const Stdio& stdin_cfg) {
+  auto child = fork(stdin_cfg, Stdio::piped(), Stdio::piped());
+  if (!child) {
+    return child.error();
+  }
+  return internal::finish_output(child.value(), CaptureOptions{});
+}
+
+int Zygote::id() const noexcept { return impl_ ? impl_->id() : -1; }
+
+}  // namespace procly
@@ -0,0 +1,303 @@
+#include <gtest/gtest.h>
+
+#include <linux/filter.h>
+#include <linux/seccomp.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "procly/command.hpp"
+#include "procly/pipeline.hpp"
+#include "procly/platform.hpp"
+#include "tests/helpers/runfiles_support.hpp"
+
+// Allocations are counted by replacing the global operator new for this binary. Only the thread
+// under measurement counts, and only inside its measurement window.
+#if defined(__GNUC__) && !defined(__clang__)
+// GCC pairs the malloc in the replaced operator new with the free in the replaced operator delete
+// once both are inlined, and reports them as mismatched.
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+namespace {
+
+thread_local bool t_count_allocations = false;
+thread_local std::size_t t_allocations = 0;
+
+void* counted_alloc(std::size_t size) {
+  if (t_count_allocations) {
+    ++t_allocations;
+  }
+  return std::malloc(size == 0 ? 1 : size);
+}
+
+void* counted_aligned_alloc(std::size_t size, std::align_val_t align) {
+  if (t_count_allocations) {
+    ++t_allocations;
+  }
+  void* ptr = nullptr;
+  std::size_t alignment = std::max(static_cast<std::size_t>(align), sizeof(void*));
+  if (::posix_memalign(&ptr, alignment, size == 0 ? 1 : size) != 0) {
+    return nullptr;
+  }
+  return ptr;
+}
+
+}  // namespace
+
+void* operator new(std::size_t size) {
+  if (void* ptr = counted_alloc(size)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+void* operator new[](std::size_t size) { return ::operator new(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+  return counted_alloc(size);
+}
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+  return counted_alloc(size);
+}
+void* operator new(std::size_t size, std::align_val_t align) {
+  if (void* ptr = counted_aligned_alloc(size, align)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+void* operator new[](std::size_t size, std::align_val_t align) {
+  return ::operator new(size, align);
+}
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { ::operator delete(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { ::operator delete(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { ::operator delete(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { ::operator delete(ptr); }
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept { ::operator delete(ptr); }
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept {
+  ::operator delete(ptr);
+}
+
+namespace procly {
+namespace {
+
+std::string helper_path() {
+  const auto& argv = ::testing::internal::GetArgvs();
+  if (argv.empty()) {
+    ADD_FAILURE() << "argv0 missing";
+    return "";
+  }
+  auto path = procly::support::helper_path(argv[0].c_str());
+  if (path.empty()) {
+    ADD_FAILURE() << "helper path not found";
+  }
+  return path;
+}
+
+struct Cost {
+  std::size_t allocations = 0;
+  std::size_t syscalls = 0;
+  // Syscall number -> count, for diagnosing a blown budget.
+  std::map<long, std::size_t> by_syscall;
+  bool measured = false;
+  // Why nothing was measured, when measured is false.
+  std::string unavailable;
+};
+
+std::string describe(const Cost& cost) {
+  std::ostringstream out;
+  out << cost.allocations << " allocations, " << cost.syscalls << " syscalls (";
+  const char* separator = "";
+  for (const auto& [nr, count] : cost.by_syscall) {
+    out << separator << "nr " << nr << " x" << count;
+    separator = ", ";
+  }
+  out << ")";
+  return out.str();
+}
+
+// Runs work on a fresh thread that routes its syscalls to this thread through a seccomp
+// user-notification filter, which answers each with "continue" and counts the ones the measured
+// thread makes inside its window. Children inherit the filter, but their syscalls are not counted.
+// work runs once to warm caches, then once measured.
+Cost measure(const std::function<void()>& work) {
+  Cost cost;
+  std::atomic<int> listener{-1};
+  std::atomic<pid_t> measured_tid{0};
+  std::atomic<bool> window{false};
+
+  std::thread measured([&] {
+    measured_tid.store(static_cast<pid_t>(::syscall(SYS_gettid)));
+    sock_filter filter[] = {BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_USER_NOTIF)};
+    sock_fprog program{.len = 1, .filter = filter};
+    int fd = -1;
+    if (::prctl(PR_SET_NO_NEW_PRIVS, 1, 0, 0, 0) == 0) {
+      fd = static_cast<int>(::syscall(SYS_seccomp, SECCOMP_SET_MODE_FILTER,
+                                      SECCOMP_FILTER_FLAG_NEW_LISTENER, &program));
+    }
+    // Publishing the listener takes no syscall, so nothing blocks before it is being served.
+    listener.store(fd == -1 ? -errno : fd);
+    if (fd == -1) {
+      return;
+    }
+    work();
+    t_allocations = 0;
+    t_count_allocations = true;
+    window.store(true);
+    work();
+    window.store(false);
+    t_count_allocations = false;
+    cost.allocations = t_allocations;
+    cost.measured = true;
+  });
+
+  int fd = -1;
+  while ((fd = listener.load()) == -1) {
+    std::this_thread::yield();
+  }
+  if (fd < -1) {
+    measured.join();
+    cost.unavailable = std::string("seccomp user notification: ") + std::strerror(-fd);
+    return cost;
+  }
+  // The listener hangs up once the measured thread and every child holding the filter are gone.
+  for (;;) {
+    pollfd polled{.fd = fd, .events = POLLIN, .revents = 0};
+    if (::poll(&polled, 1, -1) == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      ADD_FAILURE() << "poll on seccomp listener failed: " << std::strerror(errno);
+      break;
+    }
+    if ((polled.revents & POLLIN) == 0) {
+      break;
+    }
+    seccomp_notif notif{};
+    if (::ioctl(fd, SECCOMP_IOCTL_NOTIF_RECV, &notif) == -1) {
+      continue;
+    }
+    if (window.load() && static_cast<pid_t>(notif.pid) == measured_tid.load()) {
+      ++cost.syscalls;
+      ++cost.by_syscall[notif.data.nr];
+    }
+    seccomp_notif_resp response{};
+    response.id = notif.id;
+    response.flags = SECCOMP_USER_NOTIF_FLAG_CONTINUE;
+    // ENOENT means the task died while notifying; nothing is left to continue.
+    (void)::ioctl(fd, SECCOMP_IOCTL_NOTIF_SEND, &response);
+  }
+  measured.join();
+  ::close(fd);
+  return cost;
+}
+
+// Budgets sit about a quarter above the counts measured when they were set. Lower them when a
+// change makes spawning cheaper; a change that needs more must say why.
+struct Budget {
+  std::size_t allocations;
+  std::size_t syscalls;
+};
+
+#if defined(PROCLY_FORCE_FORK)
+constexpr Budget kOutputBudget{.allocations = 32, .syscalls = 32};
+constexpr Budget kStatusBudget{.allocations = 28, .syscalls = 8};
+constexpr Budget kPipelineBudget{.allocations = 58, .syscalls = 43};
+#else
+constexpr Budget kOutputBudget{.allocations = 35, .syscalls = 43};
+constexpr Budget kStatusBudget{.allocations = 24, .syscalls = 9};
+constexpr Budget kPipelineBudget{.allocations = 58, .syscalls = 60};
+#endif
+
+void expect_within(const Cost& cost, const Budget& budget) {
+  if (!cost.unavailable.empty()) {
+    GTEST_SKIP() << cost.unavailable;
+  }
+  ASSERT_TRUE(cost.measured);
+  ::testing::Test::RecordProperty("allocations", static_cast<int>(cost.allocations));
+  ::testing::Test::RecordProperty("syscalls", static_cast<int>(cost.syscalls));
+  EXPECT_LE(cost.allocations, budget.allocations) << describe(cost);
+  EXPECT_LE(cost.syscalls, budget.syscalls) << describe(cost);
+}
+
+class SpawnBudgetTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    // Sanitizer runtimes add their own allocations and syscalls.
+    if (PROCLY_HAS_ADDRESS_SANITIZER || PROCLY_HAS_THREAD_SANITIZER ||
+        PROCLY_HAS_UNDEFINED_BEHAVIOR_SANITIZER) {
+      GTEST_SKIP() << "budgets do not apply under sanitizers";
+    }
+  }
+
+  // Every spawn inherits an environment of at least 100 variables.
+  static void SetUpTestSuite() {
+    for (int index = 0; index < 100; ++index) {
+      std::string name = "PROCLY_BUDGET_VAR_" + std::to_string(index);
+      ::setenv(name.c_str(), "value", 0);
+    }
+  }
+};
+
+}  // namespace
+
+TEST_F(SpawnBudgetTest, OutputOfThreeArgCommand) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+  bool ok = true;
+  Cost cost = measure([&] {
+    Command cmd(helper);
+    cmd.args({"--stdout-bytes", "64", "--close-stdin"});
+    auto out = cmd.output();
+    ok = ok && out.has_value() && out->stdout_data.size() == 64;
+  });
+  EXPECT_TRUE(ok);
+  expect_within(cost, kOutputBudget);
+}
+
+TEST_F(SpawnBudgetTest, StatusWithInheritedStdio) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+  bool ok = true;
+  Cost cost = measure([&] {
+    Command cmd(helper);
+    cmd.args({"--exit-code", "0", "--close-stdin"});
+    auto status = cmd.status();
+    ok = ok && status.has_value() && status->success();
+  });
+  EXPECT_TRUE(ok);
+  expect_within(cost, kStatusBudget);
+}
+
+TEST_F(SpawnBudgetTest, OutputOfTwoStagePipeline) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+  bool ok = true;
+  Cost cost = measure([&] {
+    Command first(helper);
+    first.args({"--stdout-bytes", "64"});
+    Command second(helper);
+    second.arg("--echo-stdin");
+    auto out = (first | second).output();
+    ok = ok && out.has_value() && out->stdout_data.size() == 64;
+  });
+  EXPECT_TRUE(ok);
+  expect_within(cost, kPipelineBudget);
+}
+
+}  // namespace procly
@@ -18,6 +18,8 @@
 #include <vector>
 
 #include "procly/platform.hpp"
+#include "procly/shm_ring.hpp"
+#include "procly/zygote_serve.hpp"
 
 namespace {
 
@@ -31,6 +33,7 @@ constexpr long kFallbackMaxFd = 256;
 struct Options {
   std::size_t stdout_bytes = 0;
   std::size_t stderr_bytes = 0;
+  std::size_t ring_stdout_bytes = 0;
   std::optional<int> exit_code;
   std::optional<int> sleep_ms;
   std::optional<int> grandchild_sleep_ms;
@@ -43,8 +46,10 @@ struct Options {
   bool consume_stdin = false;
   bool spawn_grandchild = false;
   bool close_stdin = false;
+  bool ring_shrink = false;
   std::optional<std::string> print_env;
   bool print_cwd = false;
+  bool zygote = false;
 };
 
 bool parse_size(const std::string& value, std::size_t* out) {
@@ -84,6 +89,12 @@ bool parse_args(int argc, char* argv[], Options* options) {  // NOLINT(modernize
       }
       continue;
     }
+    if (arg == "--ring-stdout-bytes" && i + 1 < argc) {
+      if (!parse_size(argv[++i], &options->ring_stdout_bytes)) {
+        return false;
+      }
+      continue;
+    }
     if (arg == "--exit-code" && i + 1 < argc) {
       int value = 0;
       if (!parse_int(argv[++i], &value)) {
@@ -144,6 +155,10 @@ bool parse_args(int argc, char* argv[], Options* options) {  // NOLINT(modernize
       options->close_stdin = true;
       continue;
     }
+    if (arg == "--ring-shrink") {
+      options->ring_shrink = true;
+      continue;
+    }
     if (arg == "--print-env" && i + 1 < argc) {
       options->print_env = argv[++i];
       continue;
@@ -152,6 +167,10 @@ bool parse_args(int argc, char* argv[], Options* options) {  // NOLINT(modernize
       options->print_cwd = true;
       continue;
     }
+    if (arg == "--zygote") {
+      options->zygote = true;
+      continue;
+    }
     return false;
   }
   return true;
@@ -316,6 +335,12 @@ int main(int argc, char* argv[]) {
     std::this_thread::sleep_for(std::chrono::milliseconds(*options.sleep_ms));
   }
 
+  // The template stays in serve(); forked copies return and run the rest.
+  if (options.zygote && !procly::zygote::serve()) {
+    std::cerr << "not started by procly::Zygote" << '\n';
+    return 2;
+  }
+
   if (options.spawn_grandchild) {
     pid_t pid = ::fork();
     if (pid == 0) {
@@ -364,6 +389,34 @@ int main(int argc, char* argv[]) {
     write_bytes(std::cout, WriteSpec{.count = options.stdout_bytes, .fill = 'a'});
   }
 
+#if PROCLY_PLATFORM_LINUX
+  if (options.ring_shrink) {
+    // stdout is a procly::ShmChannel ring; shrinking it must be refused by its seals.
+    if (::ftruncate(STDOUT_FILENO, 0) == 0 || errno != EPERM) {
+      std::cerr << "ring shrink allowed" << '\n';
+      return 1;
+    }
+  }
+  if (options.ring_stdout_bytes > 0) {
+    // stdout is a procly::ShmChannel ring; the byte at offset i is 'a' + i % 26.
+    auto ring = procly::shm::RingWriter::attach(STDOUT_FILENO);
+    if (!ring) {
+      std::cerr << "ring attach failed" << '\n';
+      return 1;
+    }
+    std::string buffer(kIoBufferSize * 16, '\0');
+    std::size_t written = 0;
+    while (written < options.ring_stdout_bytes) {
+      std::size_t amount = std::min(buffer.size(), options.ring_stdout_bytes - written);
+      for (std::size_t i = 0; i < amount; ++i) {
+        buffer[i] = static_cast<char>('a' + (written + i) % 26);
+      }
+      ring->write_all(buffer.data(), amount);
+      written += amount;
+    }
+  }
+#endif
+
   if (options.stderr_bytes > 0) {
     write_bytes(std::cerr, WriteSpec{.count = options.stderr_bytes, .fill = 'b'});
   }
@@ -1,13 +1,18 @@
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <array>
 #include <atomic>
 #include <cerrno>
 #include <chrono>
 #include <cstdint>
 #include <cstdlib>
+#include <exception>
 #include <filesystem>
 #include <fstream>
+#include <sstream>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <string>
 #include <system_error>
@@ -18,7 +23,10 @@
 #include "procly/platform.hpp"
 #if PROCLY_PLATFORM_POSIX
 #include <fcntl.h>
+#include <poll.h>
+#include <sched.h>
 #include <signal.h>
+#include <sys/resource.h>
 #include <sys/stat.h>
 #include <sys/wait.h>
 #include <unistd.h>
@@ -30,11 +38,30 @@
 #include <process.h>
 #endif
 
+#include "procly/batch.hpp"
+#include "procly/cancellation.hpp"
+#include "procly/cgroup.hpp"
 #include "procly/child.hpp"
 #include "procly/command.hpp"
+#include "procly/fork_server.hpp"
+#include "procly/internal/fd.hpp"
 #include "procly/internal/lowering.hpp"
 #include "procly/internal/posix_spawn.hpp"
+#include "procly/numa.hpp"
+#include "procly/observer.hpp"
 #include "procly/pipeline.hpp"
+#include "procly/prepared_command.hpp"
+#include "procly/process_graph.hpp"
+#include "procly/reaper.hpp"
+#include "procly/reactor.hpp"
+#include "procly/replay.hpp"
+#include "procly/shared_file.hpp"
+#include "procly/shm_channel.hpp"
+#include "procly/shm_ring.hpp"
+#include "procly/unix.hpp"
+#include "procly/wait.hpp"
+#include "procly/worker_pool.hpp"
+#include "procly/zygote.hpp"
 #include "tests/helpers/runfiles_support.hpp"
 
 #if PROCLY_PLATFORM_POSIX && defined(PROCLY_FORCE_FORK)
@@ -398,6 +425,73 @@ TEST(CommandIntegrationTest, OutputCapturesStdoutAndStderr) {
   EXPECT_EQ(out->stderr_data.size(), 3u);
 }
 
+TEST(CommandIntegrationTest, PreparedCommandSubstitutesArgumentsAcrossSpawns) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  Command cmd(helper);
+  cmd.arg("--stdout-bytes").arg("1");
+  auto prepared = PreparedCommand::prepare(cmd);
+  ASSERT_TRUE(prepared.has_value())
+      << prepared.error().context << " " << prepared.error().code.message();
+
+  for (std::size_t bytes : {1U, 7U, 3U}) {
+    ASSERT_TRUE(prepared->set_arg(2, std::to_string(bytes)).has_value());
+    auto out = prepared->output();
+    ASSERT_TRUE(out.has_value()) << out.error().context << " " << out.error().code.message();
+    EXPECT_TRUE(out->status.success());
+    EXPECT_EQ(out->stdout_data.size(), bytes);
+  }
+
+  auto status = prepared->status();
+  ASSERT_TRUE(status.has_value()) << status.error().context << " " << status.error().code.message();
+  EXPECT_TRUE(status->success());
+}
+
+#if PROCLY_PLATFORM_LINUX
+TEST(CommandIntegrationTest, PinnedExecutableSurvivesRemovalOfItsPath) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+  auto copy = unique_temp_path("procly_pinned_helper");
+  std::filesystem::copy_file(helper, copy);
+
+  Command cmd(copy.string());
+  cmd.arg("--stdout-bytes").arg("4");
+  auto prepared = PreparedCommand::prepare(cmd);
+  ASSERT_TRUE(prepared.has_value())
+      << prepared.error().context << " " << prepared.error().code.message();
+  auto pinned = prepared->pin_executable();
+  ASSERT_TRUE(pinned.has_value()) << pinned.error().context << " " << pinned.error().code.message();
+  std::filesystem::remove(copy);
+
+  for (int i = 0; i < 2; ++i) {
+    auto out = prepared->output();
+    ASSERT_TRUE(out.has_value()) << out.error().context << " " << out.error().code.message();
+    EXPECT_TRUE(out->status.success());
+    EXPECT_EQ(out->stdout_data.size(), 4u);
+  }
+}
+#endif
+
+TEST(CommandIntegrationTest, CachedPathLookupSpawnsBareProgramName) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+  std::filesystem::path helper_file(helper);
+
+  clear_exec_path_cache();
+  Command cmd(helper_file.filename().string());
+  cmd.env("PATH", helper_file.parent_path().string());
+  cmd.arg("--exit-code").arg("3");
+  cmd.options(SpawnOptions{.path_lookup = PathLookup::cached});
+  for (int i = 0; i < 2; ++i) {
+    auto status = cmd.status();
+    ASSERT_TRUE(status.has_value())
+        << status.error().context << " " << status.error().code.message();
+    EXPECT_EQ(status->code(), std::optional<int>(3));
+  }
+  clear_exec_path_cache();
+}
+
 TEST(CommandIntegrationTest, MergeStderrIntoStdout) {
   std::string helper = helper_path();
   ASSERT_FALSE(helper.empty());
@@ -443,6 +537,35 @@ TEST(CommandIntegrationTest, CwdOverride) {
   EXPECT_TRUE(std::filesystem::equivalent(reported, cwd, ec)) << ec.message();
 }
 
+TEST(CommandIntegrationTest, VforkStrategyRunsChildInCwd) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  std::filesystem::path cwd = std::filesystem::temp_directory_path();
+
+  Command cmd(helper);
+  cmd.arg("--print-cwd");
+  cmd.current_dir(cwd);
+  cmd.options(SpawnOptions{.fork_strategy = ForkStrategy::vfork});
+  for (int i = 0; i < 3; ++i) {
+    auto output = cmd.output();
+    ASSERT_TRUE(output.has_value())
+        << output.error().context << " " << output.error().code.message();
+    std::error_code ec;
+    EXPECT_TRUE(std::filesystem::equivalent(std::filesystem::path(output->stdout_data), cwd, ec))
+        << ec.message();
+  }
+}
+
+TEST(CommandIntegrationTest, VforkStrategyReportsExecFailure) {
+  Command cmd("/definitely/missing/procly_binary");
+  cmd.current_dir(std::filesystem::temp_directory_path());
+  cmd.options(SpawnOptions{.fork_strategy = ForkStrategy::vfork});
+  auto child = cmd.spawn();
+  ASSERT_FALSE(child.has_value());
+  EXPECT_EQ(child.error().code, std::error_code(ENOENT, std::system_category()));
+}
+
 TEST(CommandIntegrationTest, EnvClearAndSet) {
   std::string helper = helper_path();
   ASSERT_FALSE(helper.empty());
@@ -551,6 +674,224 @@ TEST(CommandIntegrationTest, StdinFileRedirection) {
   std::filesystem::remove(in_path, remove_ec);
 }
 
+TEST(CommandIntegrationTest, StdinFromBytes) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  // Larger than a default pipe buffer, so a pipe would need a writer running alongside.
+  auto payload = std::make_shared<const std::string>(256 * 1024, 'x');
+  Command cmd(helper);
+  cmd.arg("--echo-stdin");
+  cmd.stdin(Stdio::bytes(payload));
+  auto output = cmd.output();
+  ASSERT_TRUE(output.has_value()) << output.error().context << " " << output.error().code.message();
+  EXPECT_TRUE(output->status.success());
+  EXPECT_EQ(output->stdout_data, *payload);
+
+  // A prepared command reuses one file; every spawn reads it from the start.
+  Command small(helper);
+  small.arg("--echo-stdin").stdin(Stdio::bytes("ping"));
+  auto prepared = PreparedCommand::prepare(small);
+  ASSERT_TRUE(prepared.has_value())
+      << prepared.error().context << " " << prepared.error().code.message();
+  for (int round = 0; round < 2; ++round) {
+    auto out = prepared->output();
+    ASSERT_TRUE(out.has_value()) << out.error().context << " " << out.error().code.message();
+    EXPECT_EQ(out->stdout_data, "ping");
+  }
+
+  // Children alive at the same time from one spec each read the whole payload.
+  Command shared(helper);
+  shared.arg("--echo-stdin").stdin(Stdio::bytes(payload)).stdout(Stdio::piped());
+  auto concurrent = PreparedCommand::prepare(shared);
+  ASSERT_TRUE(concurrent.has_value())
+      << concurrent.error().context << " " << concurrent.error().code.message();
+  std::vector<Child> children;
+  for (int index = 0; index < 3; ++index) {
+    auto child = concurrent->spawn();
+    ASSERT_TRUE(child.has_value()) << child.error().context;
+    children.push_back(std::move(child.value()));
+  }
+  for (auto& child : children) {
+    auto stdout_pipe = child.take_stdout();
+    ASSERT_TRUE(stdout_pipe.has_value());
+    auto data = stdout_pipe->read_all();
+    ASSERT_TRUE(data.has_value());
+    EXPECT_EQ(data->size(), payload->size());
+    auto status = child.wait();
+    ASSERT_TRUE(status.has_value());
+    EXPECT_TRUE(status->success());
+  }
+
+  Command bad(helper);
+  bad.stdout(Stdio::bytes("nope"));
+  auto rejected = bad.status();
+  ASSERT_FALSE(rejected.has_value());
+  EXPECT_EQ(rejected.error().code, make_error_code(errc::invalid_stdio));
+}
+
+TEST(CommandIntegrationTest, SharedFileAppendsAcrossSpawns) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  std::filesystem::path log_path = unique_temp_path("shared_log");
+  std::optional<Stdio> log_stdio;
+  {
+    auto log = SharedFile::open(log_path);
+    ASSERT_TRUE(log.has_value()) << log.error().context << " " << log.error().code.message();
+    EXPECT_GE(log->native_handle(), 0);
+    EXPECT_TRUE(::fcntl(log->native_handle(), F_GETFD) & FD_CLOEXEC);
+    log_stdio = log->stdio();
+  }
+
+  // The handle is gone; the Stdio keeps the descriptor open for every spawn.
+  for (int round = 0; round < 3; ++round) {
+    Command cmd(helper);
+    cmd.arg("--stdout-bytes").arg("4").stdout(*log_stdio);
+    auto status = cmd.status();
+    ASSERT_TRUE(status.has_value())
+        << status.error().context << " " << status.error().code.message();
+    EXPECT_TRUE(status->success());
+  }
+  Command first(helper);
+  first.arg("--stdout-bytes").arg("2");
+  Command second(helper);
+  second.arg("--echo-stdin");
+  Pipeline pipeline = first | second;
+  pipeline.stdout(*log_stdio);
+  auto pipeline_status = pipeline.status();
+  ASSERT_TRUE(pipeline_status.has_value())
+      << pipeline_status.error().context << " " << pipeline_status.error().code.message();
+
+  std::error_code ec;
+  EXPECT_EQ(std::filesystem::file_size(log_path, ec), 14U);
+  std::filesystem::remove(log_path, ec);
+}
+
+TEST(CommandIntegrationTest, SharedFileReadersShareOneOffset) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  // Larger than a pipe buffer, so both readers are still running while the other reads.
+  constexpr std::size_t kBytes = 256 * 1024;
+  std::filesystem::path input_path = unique_temp_path("shared_input");
+  {
+    std::ofstream input(input_path, std::ios::binary | std::ios::trunc);
+    input << std::string(kBytes, 'r');
+  }
+  auto input = SharedFile::open(input_path, OpenMode::read);
+  ASSERT_TRUE(input.has_value()) << input.error().context << " " << input.error().code.message();
+
+  std::vector<Child> readers;
+  for (int index = 0; index < 2; ++index) {
+    Command cmd(helper);
+    cmd.arg("--echo-stdin").stdin(input->stdio()).stdout(Stdio::piped());
+    auto child = cmd.spawn();
+    ASSERT_TRUE(child.has_value()) << child.error().context;
+    readers.push_back(std::move(child.value()));
+  }
+  // Each byte reaches exactly one reader.
+  std::size_t total = 0;
+  for (auto& reader : readers) {
+    auto stdout_pipe = reader.take_stdout();
+    ASSERT_TRUE(stdout_pipe.has_value());
+    auto data = stdout_pipe->read_all();
+    ASSERT_TRUE(data.has_value());
+    total += data->size();
+    auto status = reader.wait();
+    ASSERT_TRUE(status.has_value());
+    EXPECT_TRUE(status->success());
+  }
+  EXPECT_EQ(total, kBytes);
+
+  std::error_code ec;
+  std::filesystem::remove(input_path, ec);
+}
+
+#if PROCLY_PLATFORM_LINUX
+TEST(CommandIntegrationTest, ShmChannelStreamsFromChild) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  // Several times the ring size, so the child blocks on a full ring and wraps around.
+  constexpr std::size_t kBytes = 1000003;
+  auto channel = ShmChannel::create(64 * 1024);
+  ASSERT_TRUE(channel.has_value())
+      << channel.error().context << " " << channel.error().code.message();
+  Command cmd(helper);
+  cmd.arg("--ring-stdout-bytes").arg(std::to_string(kBytes)).stdout(channel->stdio());
+  auto child = cmd.spawn();
+  ASSERT_TRUE(child.has_value()) << child.error().context << " " << child.error().code.message();
+
+  auto data = channel->read_all();
+  ASSERT_TRUE(data.has_value()) << data.error().context << " " << data.error().code.message();
+  auto status = child->wait();
+  ASSERT_TRUE(status.has_value());
+  EXPECT_TRUE(status->success());
+  ASSERT_EQ(data->size(), kBytes);
+  bool pattern_ok = true;
+  for (std::size_t i = 0; i < kBytes; ++i) {
+    pattern_ok = pattern_ok && data.value()[i] == static_cast<char>('a' + i % 26);
+  }
+  EXPECT_TRUE(pattern_ok);
+
+  std::array<char, 16> buffer{};
+  auto idle = ShmChannel::create();
+  ASSERT_TRUE(idle.has_value());
+  auto timed_out = idle->read_some(buffer.data(), buffer.size(), std::chrono::milliseconds(20));
+  ASSERT_FALSE(timed_out.has_value());
+  EXPECT_EQ(timed_out.error().code, make_error_code(errc::timeout));
+  idle->close();
+  auto eof = idle->read_some(buffer.data(), buffer.size());
+  ASSERT_TRUE(eof.has_value());
+  EXPECT_EQ(eof.value(), 0U);
+}
+
+TEST(CommandIntegrationTest, ShmChannelRefusesResizeFromChild) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  auto channel = ShmChannel::create();
+  ASSERT_TRUE(channel.has_value())
+      << channel.error().context << " " << channel.error().code.message();
+  Command cmd(helper);
+  cmd.arg("--ring-shrink").arg("--ring-stdout-bytes").arg("26").stdout(channel->stdio());
+  auto child = cmd.spawn();
+  ASSERT_TRUE(child.has_value()) << child.error().context << " " << child.error().code.message();
+
+  // The child's failed shrink leaves the ring intact for the data that follows.
+  auto data = channel->read_all();
+  ASSERT_TRUE(data.has_value()) << data.error().context << " " << data.error().code.message();
+  auto status = child->wait();
+  ASSERT_TRUE(status.has_value());
+  EXPECT_TRUE(status->success());
+  EXPECT_EQ(data.value(), "abcdefghijklmnopqrstuvwxyz");
+  EXPECT_NE(::ftruncate(channel->native_handle(), 0), 0);
+}
+
+TEST(CommandIntegrationTest, ShmRingRejectsFillLevelPastCapacity) {
+  auto channel = ShmChannel::create();
+  ASSERT_TRUE(channel.has_value());
+  auto writer = shm::RingWriter::attach(channel->native_handle());
+  ASSERT_TRUE(writer.has_value());
+  auto mapping = shm::RingMapping::attach(channel->native_handle());
+  ASSERT_TRUE(mapping.has_value());
+  shm::RingHeader& header = mapping->header();
+
+  // A peer rewriting the header must not steer either side's memcpy past the mapping.
+  header.capacity = std::uint64_t{1} << 40;
+  header.head.store(mapping->capacity() + 1);
+  std::array<char, 16> buffer{};
+  auto read = channel->read_some(buffer.data(), buffer.size(), std::chrono::milliseconds(20));
+  ASSERT_FALSE(read.has_value());
+  EXPECT_EQ(read.error().code, make_error_code(errc::read_failed));
+
+  writer->write_all(buffer.data(), buffer.size());
+  EXPECT_TRUE(writer->corrupt());
+  EXPECT_EQ(writer->write_some(buffer.data(), buffer.size()), 0U);
+}
+#endif
+
 TEST(CommandIntegrationTest, NullRedirection) {
   std::string helper = helper_path();
   ASSERT_FALSE(helper.empty());
@@ -579,6 +920,314 @@ TEST(CommandIntegrationTest, WaitTimeout) {
   EXPECT_FALSE(wait_result->success());
 }
 
+TEST(CommandIntegrationTest, WaitTimeoutReturnsWhenChildExitsEarly) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  Command cmd(helper);
+  cmd.arg("--sleep-ms").arg("20");
+  auto child_result = cmd.spawn();
+  ASSERT_TRUE(child_result.has_value())
+      << child_result.error().context << " " << child_result.error().code.message();
+
+  WaitOptions opts;
+  opts.timeout = std::chrono::milliseconds(30000);
+  auto start = std::chrono::steady_clock::now();
+  auto wait_result = child_result->wait(opts);
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  ASSERT_TRUE(wait_result.has_value())
+      << wait_result.error().context << " " << wait_result.error().code.message();
+  EXPECT_FALSE(wait_result->timed_out);
+  EXPECT_TRUE(wait_result->success());
+  EXPECT_LT(elapsed, std::chrono::seconds(10));
+}
+
+#if PROCLY_PLATFORM_POSIX
+TEST(CommandIntegrationTest, WaitReportsResourceUsage) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  for (bool with_timeout : {false, true}) {
+    Command cmd(helper);
+    cmd.arg("--sleep-ms").arg("20");
+    auto child_result = cmd.spawn();
+    ASSERT_TRUE(child_result.has_value())
+        << child_result.error().context << " " << child_result.error().code.message();
+
+    WaitOptions opts;
+    if (with_timeout) {
+      opts.timeout = std::chrono::milliseconds(30000);
+    }
+    auto wait_result = child_result->wait(opts);
+    ASSERT_TRUE(wait_result.has_value())
+        << wait_result.error().context << " " << wait_result.error().code.message();
+    ASSERT_TRUE(wait_result->usage.has_value()) << "timeout=" << with_timeout;
+    EXPECT_GE(wait_result->usage->wall_time, std::chrono::milliseconds(20));
+    EXPECT_GT(wait_result->usage->max_rss_bytes, 0U);
+  }
+}
+#endif
+
+#if PROCLY_PLATFORM_POSIX
+TEST(CommandIntegrationTest, ResourceLimitAppliesInChild) {
+  for (auto strategy : {ForkStrategy::fork, ForkStrategy::vfork}) {
+    Command cmd("/bin/sh");
+    cmd.arg("-c").arg("ulimit -n");
+    SpawnOptions opts;
+    opts.fork_strategy = strategy;
+    cmd.options(opts);
+    cmd.limit(RLIMIT_NOFILE, 64, 64);
+    auto output = cmd.output();
+    ASSERT_TRUE(output.has_value())
+        << output.error().context << " " << output.error().code.message();
+    EXPECT_TRUE(output->status.success());
+    EXPECT_EQ(output->stdout_data, "64\n");
+  }
+}
+
+TEST(CommandIntegrationTest, InvalidResourceLimitFailsSpawn) {
+  // fork reports through the error pipe, vfork through memory shared with the parent.
+  for (auto strategy : {ForkStrategy::fork, ForkStrategy::vfork}) {
+    Command cmd("/bin/true");
+    cmd.options(SpawnOptions{.fork_strategy = strategy});
+    cmd.limit(RLIMIT_NOFILE, 64, 32);
+    auto status = cmd.status();
+    ASSERT_FALSE(status.has_value());
+    EXPECT_EQ(status.error().code, std::error_code(EINVAL, std::system_category()));
+    EXPECT_EQ(status.error().context, "spawn");
+  }
+}
+#endif
+
+#if PROCLY_PLATFORM_LINUX
+// Fields of /proc/self/stat after the parenthesised command name, starting at field 3 (state).
+std::vector<std::string> child_stat_fields(const SpawnOptions& opts) {
+  Command cmd("/bin/cat");
+  cmd.arg("/proc/self/stat");
+  cmd.options(opts);
+  auto output = cmd.output();
+  if (!output || !output->status.success()) {
+    return {};
+  }
+  std::vector<std::string> fields;
+  std::istringstream stream(output->stdout_data.substr(output->stdout_data.rfind(')') + 1));
+  for (std::string field; stream >> field;) {
+    fields.push_back(field);
+  }
+  return fields;
+}
+
+TEST(CommandIntegrationTest, SchedulingOptionsApplyInChild) {
+  constexpr std::size_t kNiceField = 19 - 3;
+  constexpr std::size_t kProcessorField = 39 - 3;
+  constexpr std::size_t kPolicyField = 41 - 3;
+
+  // Affinity takes the fork path whatever the policy; batch does too, vfork or not.
+  SpawnOptions normal;
+  normal.cpu_affinity = {0};
+  normal.scheduling_policy = SchedulingPolicy::normal;
+  auto normal_fields = child_stat_fields(normal);
+  ASSERT_GT(normal_fields.size(), kPolicyField);
+  EXPECT_EQ(normal_fields[kProcessorField], "0");
+  EXPECT_EQ(normal_fields[kPolicyField], std::to_string(SCHED_OTHER));
+
+  for (auto strategy : {ForkStrategy::fork, ForkStrategy::vfork}) {
+    SpawnOptions opts;
+    opts.fork_strategy = strategy;
+    opts.cpu_affinity = {0};
+    opts.scheduling_policy = SchedulingPolicy::batch;
+    opts.nice = 19;
+    auto fields = child_stat_fields(opts);
+    ASSERT_GT(fields.size(), kPolicyField);
+    EXPECT_EQ(fields[kProcessorField], "0");
+    EXPECT_EQ(fields[kPolicyField], std::to_string(SCHED_BATCH));
+    EXPECT_EQ(fields[kNiceField], "19");
+  }
+
+  SpawnOptions idle;
+  idle.scheduling_policy = SchedulingPolicy::idle;
+  idle.io_priority = IoPriority{.io_class = IoPriorityClass::idle, .level = 0};
+  auto fields = child_stat_fields(idle);
+  ASSERT_GT(fields.size(), kPolicyField);
+  EXPECT_EQ(fields[kPolicyField], std::to_string(SCHED_IDLE));
+}
+
+TEST(CommandIntegrationTest, AffinityDoesNotLeakIntoSpawningThread) {
+  cpu_set_t before;
+  ASSERT_EQ(::sched_getaffinity(0, sizeof(before), &before), 0);
+
+  Command cmd("/bin/true");
+  SpawnOptions opts;
+  opts.cpu_affinity = {0};
+  cmd.options(opts);
+  auto status = cmd.status();
+  ASSERT_TRUE(status.has_value()) << status.error().context << " "
+                                  << status.error().code.message();
+
+  cpu_set_t after;
+  ASSERT_EQ(::sched_getaffinity(0, sizeof(after), &after), 0);
+  EXPECT_TRUE(CPU_EQUAL(&before, &after));
+}
+
+TEST(CommandIntegrationTest, NumaNodesPinChildToNodeCpus) {
+  auto nodes = numa_nodes();
+  ASSERT_TRUE(nodes.has_value()) << nodes.error().context;
+  ASSERT_FALSE(nodes->empty());
+  const int node = nodes->front();
+  std::ifstream cpulist("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+  std::string expected;
+  if (!std::getline(cpulist, expected) || expected.empty()) {
+    GTEST_SKIP() << "node " << node << " has no CPUs";
+  }
+
+  Command cmd("/bin/cat");
+  cmd.arg("/proc/self/status");
+  cmd.numa_nodes({node});
+  auto output = cmd.output();
+  ASSERT_TRUE(output.has_value()) << output.error().context << " "
+                                  << output.error().code.message();
+  ASSERT_TRUE(output->status.success());
+  EXPECT_NE(output->stdout_data.find("Cpus_allowed_list:\t" + expected + "\n"),
+            std::string::npos)
+      << output->stdout_data;
+}
+
+TEST(CommandIntegrationTest, InvalidNumaNodeFailsSpawn) {
+  Command cmd("/bin/true");
+  cmd.numa_nodes({-1});
+  auto status = cmd.status();
+  ASSERT_FALSE(status.has_value());
+  EXPECT_EQ(status.error().code, std::make_error_code(std::errc::invalid_argument));
+  EXPECT_EQ(status.error().context, "numa_nodes");
+}
+
+TEST(CommandIntegrationTest, SpreadAcrossNumaNodesAssignsRoundRobin) {
+  auto nodes = numa_nodes();
+  ASSERT_TRUE(nodes.has_value());
+  std::vector<Command> commands(5, Command("/bin/true"));
+  ASSERT_TRUE(spread_across_numa_nodes(commands.data(), commands.size(),
+                                       NumaPolicy::interleave)
+                  .has_value());
+  for (std::size_t index = 0; index < commands.size(); ++index) {
+    auto spec = internal::lower_command(commands[index], internal::SpawnMode::spawn, nullptr);
+    ASSERT_TRUE(spec.has_value());
+    EXPECT_EQ(spec->opts.numa_nodes, std::vector<int>{nodes.value()[index % nodes->size()]});
+    EXPECT_EQ(spec->opts.numa_policy, NumaPolicy::interleave);
+  }
+  auto results = run_all(commands.data(), commands.size(), Concurrency{.limit = 2});
+  ASSERT_TRUE(results.has_value());
+  for (const auto& result : results.value()) {
+    ASSERT_TRUE(result.has_value()) << result.error().context;
+    EXPECT_TRUE(result->status.success());
+  }
+}
+
+TEST(CommandIntegrationTest, MissingCgroupFailsSpawn) {
+  Command cmd("/bin/true");
+  cmd.cgroup(unique_temp_path("missing_cgroup"));
+  auto status = cmd.status();
+  ASSERT_FALSE(status.has_value());
+  EXPECT_EQ(status.error().context, "open(cgroup)");
+}
+
+// Writable place for test cgroups: PROCLY_TEST_CGROUP, else this process's own cgroup v2 directory.
+std::optional<std::filesystem::path> cgroup_test_parent() {
+  if (const char* configured = std::getenv("PROCLY_TEST_CGROUP")) {
+    return std::filesystem::path(configured);
+  }
+  std::ifstream mounts("/proc/self/mounts");
+  std::string line;
+  std::optional<std::filesystem::path> mount_point;
+  while (std::getline(mounts, line)) {
+    std::istringstream fields(line);
+    std::string device;
+    std::string point;
+    std::string type;
+    fields >> device >> point >> type;
+    if (type == "cgroup2") {
+      mount_point = point;
+      break;
+    }
+  }
+  std::ifstream membership("/proc/self/cgroup");
+  while (mount_point && std::getline(membership, line)) {
+    if (line.rfind("0::", 0) == 0) {
+      return *mount_point / std::filesystem::path(line.substr(3)).relative_path();
+    }
+  }
+  return std::nullopt;
+}
+
+TEST(CgroupIntegrationTest, ChildKillTreeReachesOrphanedGrandchild) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+  auto parent = cgroup_test_parent();
+  if (!parent) {
+    GTEST_SKIP() << "no cgroup v2 hierarchy";
+  }
+  auto cgroup = Cgroup::create(*parent);
+  if (!cgroup) {
+    GTEST_SKIP() << "cannot create a cgroup: " << cgroup.error().code.message();
+  }
+
+  std::filesystem::path pid_path = unique_temp_path("cgroup_grandchild_pid");
+  Command cmd(helper);
+  cmd.arg("--spawn-grandchild").arg("--grandchild-sleep-ms").arg("10000");
+  cmd.arg("--grandchild-pid-file").arg(pid_path.string());
+  cmd.cgroup(cgroup->path());
+  auto child = cmd.spawn();
+  ASSERT_TRUE(child.has_value()) << child.error().context << " " << child.error().code.message();
+  auto status = child->wait();
+  ASSERT_TRUE(status.has_value());
+  EXPECT_TRUE(status->success());
+  ASSERT_GT(wait_for_pid_file(pid_path, kPidFileWaitTimeout), 0);
+
+  // The grandchild outlived its parent; only the cgroup still knows about it.
+  auto populated = cgroup->populated();
+  ASSERT_TRUE(populated.has_value()) << populated.error().context;
+  EXPECT_TRUE(populated.value());
+  auto killed = child->kill_tree(std::chrono::seconds(5));
+  ASSERT_TRUE(killed.has_value()) << killed.error().context << " "
+                                  << killed.error().code.message();
+  populated = cgroup->populated();
+  ASSERT_TRUE(populated.has_value());
+  EXPECT_FALSE(populated.value());
+  std::filesystem::remove(pid_path);
+}
+
+TEST(CgroupIntegrationTest, PipelineKillTreeEmptiesItsCgroup) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+  auto parent = cgroup_test_parent();
+  if (!parent) {
+    GTEST_SKIP() << "no cgroup v2 hierarchy";
+  }
+  auto cgroup = Cgroup::create(*parent);
+  if (!cgroup) {
+    GTEST_SKIP() << "cannot create a cgroup: " << cgroup.error().code.message();
+  }
+
+  Command first(helper);
+  first.arg("--spawn-grandchild").arg("--grandchild-sleep-ms").arg("10000").arg("--consume-stdin");
+  Command second(helper);
+  second.arg("--consume-stdin");
+  Pipeline pipeline = first | second;
+  pipeline.cgroup(cgroup->path()).stdin(Stdio::piped());
+  auto child = pipeline.spawn();
+  ASSERT_TRUE(child.has_value()) << child.error().context << " " << child.error().code.message();
+
+  auto killed = child->kill_tree(std::chrono::seconds(5));
+  ASSERT_TRUE(killed.has_value()) << killed.error().context << " "
+                                  << killed.error().code.message();
+  auto populated = cgroup->populated();
+  ASSERT_TRUE(populated.has_value());
+  EXPECT_FALSE(populated.value());
+  auto status = child->wait();
+  ASSERT_TRUE(status.has_value());
+  EXPECT_FALSE(status->aggregate.success());
+}
+#endif
+
 #if PROCLY_PLATFORM_POSIX && defined(PROCLY_FORCE_FORK)
 TEST(CommandIntegrationTest, ForkPathClosesFdsOpenedBetweenPreparationAndFork) {
   std::string helper = helper_path();
@@ -695,67 +1344,632 @@ TEST(CommandIntegrationTest, ForkPathAvoidsAllocationsAfterFork) {
 }
 #endif
 
-TEST(CommandIntegrationTest, TryWaitReturnsEmptyWhileRunning) {
+#if PROCLY_PLATFORM_POSIX
+TEST(CommandIntegrationTest, ExitHandlePollsReadableOnExit) {
   std::string helper = helper_path();
   ASSERT_FALSE(helper.empty());
 
   Command cmd(helper);
-  cmd.arg("--sleep-ms").arg("200");
+  cmd.arg("--sleep-ms").arg("100");
   auto child_result = cmd.spawn();
   ASSERT_TRUE(child_result.has_value())
       << child_result.error().context << " " << child_result.error().code.message();
 
-  auto try_result = child_result->try_wait();
-  ASSERT_TRUE(try_result.has_value())
-      << try_result.error().context << " " << try_result.error().code.message();
-  if (try_result->has_value()) {
-    EXPECT_TRUE(try_result->value().success());
-  } else {
-    auto wait_result = child_result->wait();
-    ASSERT_TRUE(wait_result.has_value())
-        << wait_result.error().context << " " << wait_result.error().code.message();
-    EXPECT_TRUE(wait_result->success());
-  }
+  auto handle = child_result->exit_handle();
+  ASSERT_TRUE(handle.has_value()) << handle.error().context << " " << handle.error().code.message();
+  auto again = child_result->exit_handle();
+  ASSERT_TRUE(again.has_value());
+  EXPECT_EQ(again.value(), handle.value());
+
+  pollfd pfd{.fd = handle.value(), .events = POLLIN, .revents = 0};
+  EXPECT_EQ(::poll(&pfd, 1, 0), 0);
+  ASSERT_EQ(::poll(&pfd, 1, 10000), 1);
+
+  auto status = child_result->try_wait();
+  ASSERT_TRUE(status.has_value()) << status.error().context << " " << status.error().code.message();
+  ASSERT_TRUE(status->has_value());
+  EXPECT_TRUE(status->value().success());
 }
 
-TEST(CommandIntegrationTest, StdinPipeRoundTrip) {
+TEST(PipelineIntegrationTest, ExitHandlesCoverEveryStage) {
   std::string helper = helper_path();
   ASSERT_FALSE(helper.empty());
 
-  Command cmd(helper);
-  cmd.arg("--echo-stdin");
-  cmd.stdin(Stdio::piped());
-  cmd.stdout(Stdio::piped());
-
-  auto child_result = cmd.spawn();
+  Command first(helper);
+  first.arg("--sleep-ms").arg("20");
+  Command second(helper);
+  second.arg("--consume-stdin");
+  auto child_result = (first | second).spawn();
   ASSERT_TRUE(child_result.has_value())
       << child_result.error().context << " " << child_result.error().code.message();
 
-  auto stdin_pipe = child_result->take_stdin();
-  auto stdout_pipe = child_result->take_stdout();
-  ASSERT_TRUE(stdin_pipe.has_value());
-  ASSERT_TRUE(stdout_pipe.has_value());
-
-  std::string payload = "stdin_payload";
-  auto write_result = stdin_pipe->write_all(payload);
-  ASSERT_TRUE(write_result.has_value());
-  stdin_pipe->close();
-
-  auto read_result = stdout_pipe->read_all();
-  ASSERT_TRUE(read_result.has_value());
-  EXPECT_EQ(read_result.value(), payload);
-
-  auto wait_result = child_result->wait();
-  ASSERT_TRUE(wait_result.has_value())
-      << wait_result.error().context << " " << wait_result.error().code.message();
-  EXPECT_TRUE(wait_result->success());
+  auto handles = child_result->exit_handles();
+  ASSERT_TRUE(handles.has_value())
+      << handles.error().context << " " << handles.error().code.message();
+  ASSERT_EQ(handles->size(), 2u);
+
+  std::optional<PipelineStatus> status;
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (!status && std::chrono::steady_clock::now() < deadline) {
+    std::vector<pollfd> pfds;
+    for (int fd : handles.value()) {
+      pfds.push_back(pollfd{.fd = fd, .events = POLLIN, .revents = 0});
+    }
+    ASSERT_GE(::poll(pfds.data(), pfds.size(), 1000), 0);
+    auto polled = child_result->try_wait();
+    ASSERT_TRUE(polled.has_value())
+        << polled.error().context << " " << polled.error().code.message();
+    status = std::move(polled.value());
+  }
+  ASSERT_TRUE(status.has_value());
+  EXPECT_EQ(status->stages.size(), 2u);
+  EXPECT_TRUE(status->aggregate.success());
 }
+#endif
 
-TEST(CommandIntegrationTest, BrokenPipeWriteReturnsError) {
+#if PROCLY_PLATFORM_LINUX && defined(F_GETPIPE_SZ)
+TEST(PipelineIntegrationTest, PipeCapacityAppliesToPipedEnds) {
   std::string helper = helper_path();
   ASSERT_FALSE(helper.empty());
 
-  std::filesystem::path ready_path = unique_temp_path("stdin_closed");
+  constexpr std::size_t kCapacity = 1024 * 1024;
+  Command first(helper);
+  first.arg("--stdout-bytes").arg("100000");
+  Command second(helper);
+  second.arg("--echo-stdin");
+  Pipeline pipeline = first | second;
+  pipeline.pipe_capacity(kCapacity).stdout(Stdio::piped());
+  auto child = pipeline.spawn();
+  ASSERT_TRUE(child.has_value()) << child.error().context << " " << child.error().code.message();
+
+  auto stdout_pipe = child->take_stdout();
+  ASSERT_TRUE(stdout_pipe.has_value());
+  int capacity = ::fcntl(stdout_pipe->native_handle(), F_GETPIPE_SZ);
+  EXPECT_GE(static_cast<std::size_t>(capacity),
+            std::min(kCapacity, internal::pipe_max_size()));
+  auto data = stdout_pipe->read_all();
+  ASSERT_TRUE(data.has_value());
+  EXPECT_EQ(data->size(), 100000U);
+  auto status = child->wait();
+  ASSERT_TRUE(status.has_value());
+  EXPECT_TRUE(status->aggregate.success());
+}
+#endif
+
+TEST(PipelineIntegrationTest, OutputWithInputFeedsFirstStage) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  std::string input(2 * 1024 * 1024, 'p');
+  Command first(helper);
+  first.arg("--echo-stdin");
+  Command second(helper);
+  second.arg("--echo-stdin");
+  Pipeline pipeline = first | second;
+  auto output = pipeline.output_with_input(input);
+  ASSERT_TRUE(output.has_value()) << output.error().context << " "
+                                  << output.error().code.message();
+  EXPECT_TRUE(output->status.success());
+  EXPECT_EQ(output->stdout_data.size(), input.size());
+  EXPECT_TRUE(output->stdout_data == input);
+}
+
+TEST(PipelineIntegrationTest, OutputStagesCapturesEveryStderr) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  // The first stage writes more stderr than a pipe holds, so it only finishes when its
+  // stderr is drained alongside the final stdout.
+  Command first(helper);
+  first.arg("--stderr-bytes").arg("262144").arg("--stdout-bytes").arg("5");
+  Command second(helper);
+  second.arg("--echo-stdin").arg("--stderr-bytes").arg("7");
+  second.stderr(Stdio::null());
+  Command third(helper);
+  third.arg("--echo-stdin").arg("--stderr-bytes").arg("3").arg("--exit-code").arg("4");
+  Pipeline pipeline = first | second | third;
+  auto result = pipeline.output_stages();
+  ASSERT_TRUE(result.has_value()) << result.error().context << " "
+                                  << result.error().code.message();
+  EXPECT_EQ(result->output.stdout_data, "aaaaa");
+  EXPECT_EQ(result->output.stderr_data, "bbb");
+  EXPECT_EQ(result->output.status.code(), std::optional<int>(4));
+  ASSERT_EQ(result->status.stages.size(), 3U);
+  ASSERT_EQ(result->status.stage_stderr.size(), 3U);
+  EXPECT_EQ(result->status.stage_stderr[0], std::string(262144, 'b'));
+  EXPECT_TRUE(result->status.stage_stderr[1].empty());
+  EXPECT_EQ(result->status.stage_stderr[2], "bbb");
+}
+
+namespace {
+
+Pipeline fail_fast_pipeline(const std::string& helper) {
+  Command first(helper);
+  first.arg("--sleep-ms").arg("10000");
+  Command second(helper);
+  second.arg("--exit-code").arg("3");
+  Command third(helper);
+  third.arg("--sleep-ms").arg("10000");
+  return first | second | third;
+}
+
+}  // namespace
+
+TEST(PipelineIntegrationTest, WaitFailFastTerminatesRemainingStages) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  for (bool group : {false, true}) {
+    Pipeline pipeline = fail_fast_pipeline(helper);
+    pipeline.pipefail().new_process_group(group);
+    auto child = pipeline.spawn();
+    ASSERT_TRUE(child.has_value()) << child.error().context << " "
+                                   << child.error().code.message();
+
+    auto start = std::chrono::steady_clock::now();
+    PipelineWaitOptions options;
+    options.fail_fast = true;
+    auto result = child->wait(options);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    ASSERT_TRUE(result.has_value()) << result.error().context << " "
+                                    << result.error().code.message();
+    EXPECT_LT(elapsed, std::chrono::seconds(5)) << "group=" << group;
+    ASSERT_TRUE(result->failed_stage.has_value());
+    EXPECT_EQ(*result->failed_stage, 1U);
+    EXPECT_TRUE(result->sent_terminate);
+    EXPECT_FALSE(result->timed_out);
+    ASSERT_EQ(result->status.stages.size(), 3U);
+    EXPECT_EQ(result->status.stages[1].code(), std::optional<int>(3));
+    EXPECT_FALSE(result->status.aggregate.success());
+  }
+}
+
+TEST(PipelineIntegrationTest, WaitTimeoutTerminatesPipeline) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  Command first(helper);
+  first.arg("--sleep-ms").arg("10000");
+  Command second(helper);
+  second.arg("--sleep-ms").arg("10000");
+  Pipeline pipeline = first | second;
+  auto child = pipeline.spawn();
+  ASSERT_TRUE(child.has_value()) << child.error().context << " "
+                                 << child.error().code.message();
+
+  PipelineWaitOptions options;
+  options.timeout = std::chrono::milliseconds(100);
+  auto result = child->wait(options);
+  ASSERT_TRUE(result.has_value()) << result.error().context << " "
+                                  << result.error().code.message();
+  EXPECT_TRUE(result->timed_out);
+  EXPECT_TRUE(result->sent_terminate);
+  EXPECT_FALSE(result->failed_stage.has_value());
+  ASSERT_EQ(result->status.stages.size(), 2U);
+  EXPECT_FALSE(result->status.aggregate.success());
+}
+
+TEST(PipelineIntegrationTest, OutputDeadlineTerminatesWhileDraining) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  for (bool group : {false, true}) {
+    Command first(helper);
+    first.arg("--sleep-ms").arg("10000");
+    Command second(helper);
+    second.arg("--echo-stdin");
+    Pipeline pipeline = first | second;
+    pipeline.new_process_group(group);
+
+    WaitOptions wait;
+    wait.timeout = std::chrono::milliseconds(200);
+    auto start = std::chrono::steady_clock::now();
+    auto result = pipeline.output(wait);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    ASSERT_TRUE(result.has_value()) << result.error().context << " "
+                                    << result.error().code.message();
+    EXPECT_LT(elapsed, std::chrono::seconds(5)) << "group=" << group;
+    EXPECT_TRUE(result->timed_out) << "group=" << group;
+    EXPECT_TRUE(result->sent_terminate) << "group=" << group;
+    ASSERT_EQ(result->status.stages.size(), 2U);
+    EXPECT_FALSE(result->status.stages[0].success());
+  }
+
+  Command quick(helper);
+  quick.arg("--stdout-bytes").arg("4");
+  Command echo(helper);
+  echo.arg("--echo-stdin");
+  WaitOptions wait;
+  wait.timeout = std::chrono::seconds(10);
+  auto result = (quick | echo).output(wait);
+  ASSERT_TRUE(result.has_value()) << result.error().context << " "
+                                  << result.error().code.message();
+  EXPECT_FALSE(result->timed_out);
+  EXPECT_FALSE(result->sent_terminate);
+  EXPECT_TRUE(result->output.status.success());
+  EXPECT_EQ(result->output.stdout_data, "aaaa");
+}
+
+TEST(PipelineIntegrationTest, OutputCancelledFromAnotherThread) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  for (bool group : {false, true}) {
+    Command first(helper);
+    first.arg("--sleep-ms").arg("10000");
+    Command second(helper);
+    second.arg("--echo-stdin");
+    Pipeline pipeline = first | second;
+    pipeline.new_process_group(group);
+
+    WaitOptions wait;
+    wait.cancel.emplace();
+    std::thread canceller([token = *wait.cancel]() mutable {
+      std::this_thread::sleep_for(std::chrono::milliseconds(50));
+      token.cancel();
+    });
+    auto start = std::chrono::steady_clock::now();
+    auto result = pipeline.output(wait);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    canceller.join();
+    ASSERT_TRUE(result.has_value()) << result.error().context << " "
+                                    << result.error().code.message();
+    EXPECT_LT(elapsed, std::chrono::seconds(5)) << "group=" << group;
+    EXPECT_TRUE(result->cancelled) << "group=" << group;
+    EXPECT_FALSE(result->timed_out) << "group=" << group;
+    EXPECT_TRUE(result->sent_terminate) << "group=" << group;
+    EXPECT_FALSE(result->status.stages[0].success());
+  }
+}
+
+#if PROCLY_PLATFORM_POSIX
+TEST(PipelineIntegrationTest, WaitReportsStageResourceUsage) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  Command first(helper);
+  first.arg("--stdout-bytes").arg("4096");
+  Command second(helper);
+  second.arg("--consume-stdin");
+  Pipeline pipeline = first | second;
+  auto child = pipeline.spawn();
+  ASSERT_TRUE(child.has_value()) << child.error().context << " "
+                                 << child.error().code.message();
+
+  auto result = child->wait(PipelineWaitOptions{});
+  ASSERT_TRUE(result.has_value()) << result.error().context << " "
+                                  << result.error().code.message();
+  ASSERT_EQ(result->status.stage_usage.size(), 2U);
+  for (const auto& usage : result->status.stage_usage) {
+    ASSERT_TRUE(usage.has_value());
+    EXPECT_GT(usage->max_rss_bytes, 0U);
+    EXPECT_GT(usage->wall_time.count(), 0);
+  }
+}
+#endif
+
+TEST(ReactorIntegrationTest, SupervisesManyChildrenOnOneThread) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  auto reactor = Reactor::create();
+  ASSERT_TRUE(reactor.has_value())
+      << reactor.error().context << " " << reactor.error().code.message();
+
+  constexpr int kChildren = 32;
+  std::vector<std::future<Result<ChildCompletion>>> futures;
+  for (int i = 0; i < kChildren; ++i) {
+    Command cmd(helper);
+    cmd.arg("--echo-stdin").arg("--stderr-bytes").arg(std::to_string(i));
+    cmd.stdin(Stdio::piped()).stdout(Stdio::piped()).stderr(Stdio::piped());
+    auto child = cmd.spawn();
+    ASSERT_TRUE(child.has_value()) << child.error().context << " " << child.error().code.message();
+    WatchOptions options;
+    options.stdin_data = std::string(static_cast<std::size_t>(i) * 4096, 'x');
+    futures.push_back(reactor->watch(std::move(child.value()), std::move(options)));
+  }
+
+  auto ran = reactor->run();
+  ASSERT_TRUE(ran.has_value()) << ran.error().context << " " << ran.error().code.message();
+  for (int i = 0; i < kChildren; ++i) {
+    auto completion = futures[static_cast<std::size_t>(i)].get();
+    ASSERT_TRUE(completion.has_value())
+        << completion.error().context << " " << completion.error().code.message();
+    EXPECT_TRUE(completion->wait.success());
+    EXPECT_EQ(completion->stdout_data.size(), static_cast<std::size_t>(i) * 4096);
+    EXPECT_EQ(completion->stderr_data.size(), static_cast<std::size_t>(i));
+  }
+}
+
+TEST(ReactorIntegrationTest, TimeoutTerminatesChild) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  auto reactor = Reactor::create();
+  ASSERT_TRUE(reactor.has_value());
+
+  Command cmd(helper);
+  cmd.arg("--sleep-ms").arg("5000");
+  auto child = cmd.spawn();
+  ASSERT_TRUE(child.has_value()) << child.error().context << " " << child.error().code.message();
+  WatchOptions options;
+  options.timeout = std::chrono::milliseconds(20);
+  auto future = reactor->watch(std::move(child.value()), options);
+
+  ASSERT_TRUE(reactor->run().has_value());
+  auto completion = future.get();
+  ASSERT_TRUE(completion.has_value())
+      << completion.error().context << " " << completion.error().code.message();
+  EXPECT_TRUE(completion->wait.timed_out);
+  EXPECT_TRUE(completion->wait.sent_terminate);
+  EXPECT_FALSE(completion->wait.success());
+}
+
+TEST(ReactorIntegrationTest, PipelineFeedsStdinAndCapturesLastStage) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  auto reactor = Reactor::create();
+  ASSERT_TRUE(reactor.has_value());
+
+  Command first(helper);
+  first.arg("--echo-stdin");
+  Command second(helper);
+  second.arg("--echo-stdin");
+  Pipeline pipeline = first | second;
+  pipeline.stdin(Stdio::piped()).stdout(Stdio::piped());
+  auto child = pipeline.spawn();
+  ASSERT_TRUE(child.has_value()) << child.error().context << " " << child.error().code.message();
+
+  std::optional<Result<PipelineCompletion>> completion;
+  WatchOptions options;
+  options.stdin_data = "through the pipeline";
+  auto watched = reactor->watch(std::move(child.value()), std::move(options),
+                                [&](Result<PipelineCompletion> result) { completion = result; });
+  ASSERT_TRUE(watched.has_value());
+
+  ASSERT_TRUE(reactor->run().has_value());
+  ASSERT_TRUE(completion.has_value());
+  ASSERT_TRUE(completion->has_value())
+      << completion->error().context << " " << completion->error().code.message();
+  EXPECT_EQ(completion->value().stdout_data, "through the pipeline");
+  EXPECT_EQ(completion->value().status.stages.size(), 2U);
+  EXPECT_TRUE(completion->value().status.aggregate.success());
+}
+
+#if PROCLY_PLATFORM_LINUX
+TEST(ReactorIntegrationTest, SampleAllCoversRunningChildrenAndStages) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  auto reactor = Reactor::create();
+  ASSERT_TRUE(reactor.has_value());
+
+  auto child = Command(helper).arg("--sleep-ms").arg("5000").spawn();
+  ASSERT_TRUE(child.has_value()) << child.error().context << " " << child.error().code.message();
+  const int child_pid = child->id();
+  WatchOptions options;
+  options.timeout = std::chrono::milliseconds(200);
+  auto child_done = reactor->watch(std::move(child.value()), options);
+
+  Command first(helper);
+  first.arg("--sleep-ms").arg("5000");
+  Command second(helper);
+  second.arg("--sleep-ms").arg("5000");
+  auto pipeline = (first | second).spawn();
+  ASSERT_TRUE(pipeline.has_value());
+  auto pipeline_done = reactor->watch(std::move(pipeline.value()), options);
+  // Let every process get through exec before sampling it.
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+  for (int round = 0; round < 2; ++round) {
+    auto samples = reactor->sample_all();
+    ASSERT_TRUE(samples.has_value()) << samples.error().context;
+    ASSERT_EQ(samples->size(), 3U);
+    EXPECT_EQ(samples->front().pid, child_pid);
+    for (const auto& process : samples.value()) {
+      EXPECT_GT(process.sample.rss_bytes, 0U);
+      EXPECT_GE(process.sample.threads, 1U);
+    }
+  }
+
+  ASSERT_TRUE(reactor->run().has_value());
+  EXPECT_TRUE(child_done.get().has_value());
+  EXPECT_TRUE(pipeline_done.get().has_value());
+  auto samples = reactor->sample_all();
+  ASSERT_TRUE(samples.has_value());
+  EXPECT_TRUE(samples->empty());
+}
+
+TEST(CommandIntegrationTest, SampleFailsOnceChildIsReaped) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  auto child = Command(helper).arg("--sleep-ms").arg("200").spawn();
+  ASSERT_TRUE(child.has_value());
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  auto sample = child->sample();
+  ASSERT_TRUE(sample.has_value()) << sample.error().context << " "
+                                  << sample.error().code.message();
+  EXPECT_GT(sample->rss_bytes, 0U);
+  EXPECT_EQ(sample->threads, 1U);
+  ASSERT_TRUE(child->wait().has_value());
+  sample = child->sample();
+  ASSERT_FALSE(sample.has_value());
+  EXPECT_EQ(sample.error().code, std::make_error_code(std::errc::no_such_process));
+}
+#endif
+
+TEST(AsyncIntegrationTest, OutputAsyncDeliversThroughThen) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  auto reactor = Reactor::create();
+  ASSERT_TRUE(reactor.has_value());
+
+  Command cmd(helper);
+  cmd.arg("--stdout-bytes").arg("4096");
+  std::optional<Result<Output>> output;
+  cmd.output_async(reactor.value()).then([&](Result<Output> result) { output = result; });
+  EXPECT_FALSE(output.has_value());
+
+  ASSERT_TRUE(reactor->run().has_value());
+  ASSERT_TRUE(output.has_value());
+  ASSERT_TRUE(output->has_value()) << output->error().context << " "
+                                   << output->error().code.message();
+  EXPECT_EQ(output->value().stdout_data.size(), 4096U);
+  EXPECT_TRUE(output->value().status.success());
+}
+
+TEST(AsyncIntegrationTest, SpawnFailureIsReadyImmediately) {
+  auto reactor = Reactor::create();
+  ASSERT_TRUE(reactor.has_value());
+
+  Command cmd("/nonexistent/procly-async");
+  auto future = cmd.status_async(reactor.value()).to_future();
+  ASSERT_EQ(future.wait_for(std::chrono::seconds(0)), std::future_status::ready);
+  EXPECT_FALSE(future.get().has_value());
+}
+
+TEST(AsyncIntegrationTest, WaitAsyncEscalatesOnTimeout) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  auto reactor = Reactor::create();
+  ASSERT_TRUE(reactor.has_value());
+
+  Command cmd(helper);
+  cmd.arg("--sleep-ms").arg("5000");
+  auto child = cmd.spawn();
+  ASSERT_TRUE(child.has_value()) << child.error().context << " " << child.error().code.message();
+
+  WaitOptions options;
+  options.timeout = std::chrono::milliseconds(20);
+  auto future = child->wait_async(reactor.value(), options).to_future();
+  ASSERT_TRUE(reactor->run().has_value());
+  auto result = future.get();
+  ASSERT_TRUE(result.has_value()) << result.error().context << " "
+                                  << result.error().code.message();
+  EXPECT_TRUE(result->timed_out);
+  EXPECT_TRUE(result->sent_terminate);
+  EXPECT_FALSE(result->success());
+}
+
+#if PROCLY_HAS_COROUTINES
+namespace {
+
+// Minimal eagerly-started coroutine for exercising co_await in tests.
+struct DetachedTask {
+  struct promise_type {
+    DetachedTask get_return_object() noexcept { return {}; }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() noexcept {}
+    void unhandled_exception() { std::terminate(); }
+  };
+};
+
+DetachedTask read_then_wait(Reactor& reactor, Child& child, std::string& data,
+                            std::optional<Result<WaitResult>>& waited) {
+  auto stdout_pipe = child.take_stdout();
+  std::array<std::byte, 64> buffer{};
+  for (;;) {
+    auto n = co_await stdout_pipe->read_some_async(reactor, buffer.data(), buffer.size());
+    if (!n || n.value() == 0) {
+      break;
+    }
+    data.append(reinterpret_cast<const char*>(buffer.data()), n.value());
+  }
+  waited = co_await child.wait_async(reactor);
+}
+
+}  // namespace
+
+TEST(AsyncIntegrationTest, CoAwaitReadsAndWaits) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  auto reactor = Reactor::create();
+  ASSERT_TRUE(reactor.has_value());
+
+  Command cmd(helper);
+  cmd.arg("--stdout-bytes").arg("1000").stdout(Stdio::piped());
+  auto child = cmd.spawn();
+  ASSERT_TRUE(child.has_value()) << child.error().context << " " << child.error().code.message();
+
+  std::string data;
+  std::optional<Result<WaitResult>> waited;
+  read_then_wait(reactor.value(), child.value(), data, waited);
+  ASSERT_TRUE(reactor->run().has_value());
+
+  EXPECT_EQ(data.size(), 1000U);
+  ASSERT_TRUE(waited.has_value());
+  ASSERT_TRUE(waited->has_value());
+  EXPECT_TRUE(waited->value().success());
+}
+#endif
+
+TEST(CommandIntegrationTest, TryWaitReturnsEmptyWhileRunning) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  Command cmd(helper);
+  cmd.arg("--sleep-ms").arg("200");
+  auto child_result = cmd.spawn();
+  ASSERT_TRUE(child_result.has_value())
+      << child_result.error().context << " " << child_result.error().code.message();
+
+  auto try_result = child_result->try_wait();
+  ASSERT_TRUE(try_result.has_value())
+      << try_result.error().context << " " << try_result.error().code.message();
+  if (try_result->has_value()) {
+    EXPECT_TRUE(try_result->value().success());
+  } else {
+    auto wait_result = child_result->wait();
+    ASSERT_TRUE(wait_result.has_value())
+        << wait_result.error().context << " " << wait_result.error().code.message();
+    EXPECT_TRUE(wait_result->success());
+  }
+}
+
+TEST(CommandIntegrationTest, StdinPipeRoundTrip) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  Command cmd(helper);
+  cmd.arg("--echo-stdin");
+  cmd.stdin(Stdio::piped());
+  cmd.stdout(Stdio::piped());
+
+  auto child_result = cmd.spawn();
+  ASSERT_TRUE(child_result.has_value())
+      << child_result.error().context << " " << child_result.error().code.message();
+
+  auto stdin_pipe = child_result->take_stdin();
+  auto stdout_pipe = child_result->take_stdout();
+  ASSERT_TRUE(stdin_pipe.has_value());
+  ASSERT_TRUE(stdout_pipe.has_value());
+
+  std::string payload = "stdin_payload";
+  auto write_result = stdin_pipe->write_all(payload);
+  ASSERT_TRUE(write_result.has_value());
+  stdin_pipe->close();
+
+  auto read_result = stdout_pipe->read_all();
+  ASSERT_TRUE(read_result.has_value());
+  EXPECT_EQ(read_result.value(), payload);
+
+  auto wait_result = child_result->wait();
+  ASSERT_TRUE(wait_result.has_value())
+      << wait_result.error().context << " " << wait_result.error().code.message();
+  EXPECT_TRUE(wait_result->success());
+}
+
+TEST(CommandIntegrationTest, BrokenPipeWriteReturnsError) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  std::filesystem::path ready_path = unique_temp_path("stdin_closed");
   std::error_code remove_ec;
   std::filesystem::remove(ready_path, remove_ec);
 
@@ -836,34 +2050,243 @@ TEST(PipelineIntegrationTest, OutputCapturesLastStage) {
   EXPECT_EQ(output->stdout_data.size(), 4u);
 }
 
-TEST(PipelineIntegrationTest, PipefailReportsFirstFailure) {
+TEST(PipelineIntegrationTest, FunctionStagesFilterBetweenProcesses) {
   std::string helper = helper_path();
   ASSERT_FALSE(helper.empty());
 
-  Command bad(helper);
-  bad.arg("--exit-code").arg("5");
+  Command first(helper);
+  first.arg("--echo-stdin");
+  Command second(helper);
+  second.arg("--echo-stdin");
 
-  Command good(helper);
+  auto grep = transform_lines([](std::string_view line, std::string& out) {
+    if (line.find('x') != std::string_view::npos) {
+      out.append(line).push_back('\n');
+    }
+    return true;
+  });
+  std::size_t seen = 0;
+  auto head = transform_lines([&seen](std::string_view line, std::string& out) {
+    out.append(line).push_back('\n');
+    return ++seen < 2;
+  });
+  Pipeline pipeline = first | std::move(grep) | second | std::move(head);
+  EXPECT_EQ(pipeline.size(), 4U);
+
+  std::string input;
+  for (int i = 0; i < 10000; ++i) {
+    input += (i % 3 == 0 ? "x" : "y") + std::to_string(i) + "\n";
+  }
+  auto output = pipeline.output_with_input(input);
+  ASSERT_TRUE(output.has_value()) << output.error().context << " " << output.error().code.message();
+  EXPECT_EQ(output->stdout_data, "x0\nx3\n");
+  EXPECT_TRUE(output->status.success());
+}
 
-  Pipeline pipeline = bad | good;
+TEST(PipelineIntegrationTest, FunctionStageErrorsAreReportedWithStageStatus) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  Command producer(helper);
+  producer.arg("--stdout-bytes").arg("1000");
+  Command consumer(helper);
+  consumer.arg("--echo-stdin");
+
+  Pipeline pipeline = producer | transform([](PipeReader& in, PipeWriter& out) -> Result<void> {
+                        auto data = in.read_all();
+                        if (!data) {
+                          return data.error();
+                        }
+                        auto written = out.write_all(data.value());
+                        if (!written) {
+                          return written;
+                        }
+                        return Error{.code = make_error_code(errc::invalid_argument),
+                                     .context = "stage"};
+                      }) |
+                      consumer;
   pipeline.pipefail(true);
-  auto status = pipeline.status();
+  pipeline.stdout(Stdio::null());
+  auto child = pipeline.spawn();
+  ASSERT_TRUE(child.has_value()) << child.error().context << " " << child.error().code.message();
+  auto handles = child->exit_handles();
+  ASSERT_TRUE(handles.has_value());
+  EXPECT_EQ(handles->size(), 3U);
+
+  auto status = child->wait();
   ASSERT_TRUE(status.has_value()) << status.error().context << " " << status.error().code.message();
-  ASSERT_TRUE(status->code().has_value());
-  EXPECT_EQ(status->code().value(), 5);
+  ASSERT_EQ(status->stages.size(), 2U);
+  EXPECT_TRUE(status->stages[0].success());
+  EXPECT_TRUE(status->stages[1].success());
+  ASSERT_EQ(status->function_stages.size(), 1U);
+  EXPECT_EQ(status->function_stages[0].position, 1U);
+  ASSERT_FALSE(status->function_stages[0].success());
+  EXPECT_EQ(status->function_stages[0].error->context, "stage");
+  EXPECT_EQ(status->aggregate.code(), std::optional<int>(1));
 }
 
-TEST(PipelineIntegrationTest, PipefailReportsLastFailure) {
+#if PROCLY_PLATFORM_POSIX
+TEST(ProcessGraphIntegrationTest, FanOutFeedsEveryConsumer) {
   std::string helper = helper_path();
   ASSERT_FALSE(helper.empty());
 
-  Command first(helper);
-  first.arg("--exit-code").arg("3");
-
-  Command second(helper);
-  second.arg("--exit-code").arg("7");
+  constexpr std::size_t kBytes = 300000;
+  ProcessGraph graph;
+  Command producer(helper);
+  producer.arg("--stdout-bytes").arg(std::to_string(kBytes));
+  auto source = graph.add(std::move(producer));
+  std::vector<std::filesystem::path> paths;
+  for (int i = 0; i < 3; ++i) {
+    paths.push_back(unique_temp_path("graph_fan_out"));
+    Command consumer(helper);
+    consumer.arg("--echo-stdin").stdout(Stdio::file(paths.back()));
+    graph.connect(source, graph.add(std::move(consumer)));
+  }
 
-  Command third(helper);
+  auto status = graph.status();
+  ASSERT_TRUE(status.has_value()) << status.error().context << " " << status.error().code.message();
+  EXPECT_TRUE(status->success());
+  EXPECT_EQ(status->nodes.size(), 4U);
+  for (const auto& path : paths) {
+    EXPECT_EQ(read_file(path), std::string(kBytes, 'a'));
+    std::filesystem::remove(path);
+  }
+}
+
+TEST(ProcessGraphIntegrationTest, FanInMergesProducers) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  ProcessGraph graph;
+  Command small(helper);
+  small.arg("--stdout-bytes").arg("1000");
+  Command large(helper);
+  large.arg("--stdout-bytes").arg("200000");
+  std::filesystem::path path = unique_temp_path("graph_fan_in");
+  Command consumer(helper);
+  consumer.arg("--echo-stdin").stdout(Stdio::file(path));
+  auto sink = graph.add(std::move(consumer));
+  graph.connect(graph.add(std::move(small)), sink);
+  graph.connect(graph.add(std::move(large)), sink);
+
+  auto status = graph.status();
+  ASSERT_TRUE(status.has_value()) << status.error().context << " " << status.error().code.message();
+  EXPECT_TRUE(status->success());
+  EXPECT_EQ(read_file(path).size(), 201000U);
+  std::filesystem::remove(path);
+}
+
+TEST(ProcessGraphIntegrationTest, RejectsCyclesAndBadEdges) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  ProcessGraph cycle;
+  auto a = cycle.add(Command(helper));
+  auto b = cycle.add(Command(helper));
+  cycle.connect(a, b).connect(b, a);
+  auto spawned = cycle.spawn();
+  ASSERT_FALSE(spawned.has_value());
+  EXPECT_EQ(spawned.error().context, "graph_cycle");
+
+  ProcessGraph dangling;
+  dangling.connect(dangling.add(Command(helper)), 5);
+  auto bad = dangling.spawn();
+  ASSERT_FALSE(bad.has_value());
+  EXPECT_EQ(bad.error().context, "graph_edge");
+}
+#endif
+
+TEST(CommandIntegrationTest, OutputCancelledFromAnotherThread) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  Command cmd(helper);
+  cmd.arg("--sleep-ms").arg("10000");
+  CancellationToken token;
+  std::thread canceller([token]() mutable {
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    token.cancel();
+  });
+  auto start = std::chrono::steady_clock::now();
+  auto output = cmd.output(CaptureOptions{}, token);
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  canceller.join();
+  ASSERT_FALSE(output.has_value());
+  EXPECT_EQ(output.error().code, make_error_code(errc::cancelled));
+  EXPECT_LT(elapsed, std::chrono::seconds(5));
+
+  // Inherited stdio leaves nothing to drain; the wait itself must wake.
+  Command quiet(helper);
+  quiet.arg("--sleep-ms").arg("10000").stdout(Stdio::null()).stderr(Stdio::null());
+  CancellationToken fired;
+  fired.cancel();
+  auto status = quiet.status(fired);
+  ASSERT_FALSE(status.has_value());
+  EXPECT_EQ(status.error().code, make_error_code(errc::cancelled));
+
+  CancellationToken unused;
+  Command quick(helper);
+  quick.arg("--stdout-bytes").arg("3");
+  auto finished = quick.output(CaptureOptions{}, unused);
+  ASSERT_TRUE(finished.has_value());
+  EXPECT_EQ(finished->stdout_data, "aaa");
+}
+
+TEST(CommandIntegrationTest, WaitCancelEscalates) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  Command cmd(helper);
+  cmd.arg("--sleep-ms").arg("10000");
+  auto child = cmd.spawn();
+  ASSERT_TRUE(child.has_value());
+  WaitOptions options;
+  options.cancel.emplace();
+  std::thread canceller([token = *options.cancel]() mutable {
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    token.cancel();
+  });
+  auto start = std::chrono::steady_clock::now();
+  auto result = child->wait(options);
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  canceller.join();
+  ASSERT_TRUE(result.has_value()) << result.error().context << " "
+                                  << result.error().code.message();
+  EXPECT_TRUE(result->cancelled);
+  EXPECT_FALSE(result->timed_out);
+  EXPECT_TRUE(result->sent_terminate);
+  EXPECT_FALSE(result->success());
+  EXPECT_LT(elapsed, std::chrono::seconds(5));
+}
+
+TEST(PipelineIntegrationTest, PipefailReportsFirstFailure) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  Command bad(helper);
+  bad.arg("--exit-code").arg("5");
+
+  Command good(helper);
+
+  Pipeline pipeline = bad | good;
+  pipeline.pipefail(true);
+  auto status = pipeline.status();
+  ASSERT_TRUE(status.has_value()) << status.error().context << " " << status.error().code.message();
+  ASSERT_TRUE(status->code().has_value());
+  EXPECT_EQ(status->code().value(), 5);
+}
+
+TEST(PipelineIntegrationTest, PipefailReportsLastFailure) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  Command first(helper);
+  first.arg("--exit-code").arg("3");
+
+  Command second(helper);
+  second.arg("--exit-code").arg("7");
+
+  Command third(helper);
   third.arg("--exit-code").arg("0");
 
   Pipeline pipeline = first | second | third;
@@ -948,6 +2371,384 @@ TEST(CommandIntegrationTest, OutputLargePayloads) {
   EXPECT_EQ(out->stderr_data.size(), kStderrBytes);
 }
 
+#if PROCLY_PLATFORM_POSIX
+TEST(CommandIntegrationTest, OutputMappedCapturesWithoutPipes) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  constexpr std::size_t kStdoutBytes = 16 * 1024 * 1024;
+
+  Command cmd(helper);
+  cmd.arg("--stdout-bytes").arg(std::to_string(kStdoutBytes)).arg("--stderr-bytes").arg("7");
+  auto out = cmd.output_mapped();
+  ASSERT_TRUE(out.has_value()) << out.error().context << " " << out.error().code.message();
+  EXPECT_TRUE(out->status.success());
+  ASSERT_EQ(out->stdout_data.size(), kStdoutBytes);
+  EXPECT_EQ(out->stdout_data.view().find_first_not_of('a'), std::string_view::npos);
+  EXPECT_EQ(out->stderr_data.size(), 7U);
+
+  MappedBuffer moved = std::move(out->stdout_data);
+  EXPECT_TRUE(out->stdout_data.empty());
+  EXPECT_EQ(moved.size(), kStdoutBytes);
+}
+
+TEST(CommandIntegrationTest, OutputMappedEmptyOutput) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  Command cmd(helper);
+  auto out = cmd.output_mapped();
+  ASSERT_TRUE(out.has_value()) << out.error().context << " " << out.error().code.message();
+  EXPECT_TRUE(out->stdout_data.empty());
+  EXPECT_TRUE(out->stderr_data.empty());
+}
+
+TEST(CommandIntegrationTest, OutputSpillMovesLargeStreamsToDisk) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  constexpr std::size_t kStdoutBytes = 4 * 1024 * 1024;
+
+  Command cmd(helper);
+  cmd.arg("--stdout-bytes").arg(std::to_string(kStdoutBytes)).arg("--stderr-bytes").arg("300");
+  auto out = cmd.output_spill(64 * 1024);
+  ASSERT_TRUE(out.has_value()) << out.error().context << " " << out.error().code.message();
+  EXPECT_TRUE(out->status.success());
+  EXPECT_TRUE(out->stdout_data.spilled());
+  ASSERT_EQ(out->stdout_data.size(), kStdoutBytes);
+  EXPECT_EQ(out->stdout_data.view().find_first_not_of('a'), std::string_view::npos);
+  std::array<char, 4> tail{};
+  EXPECT_EQ(out->stdout_data.read(kStdoutBytes - 2, tail.data(), tail.size()), 2U);
+  EXPECT_EQ(std::string_view(tail.data(), 2), "aa");
+
+  EXPECT_FALSE(out->stderr_data.spilled());
+  EXPECT_EQ(out->stderr_data.to_string(), std::string(300, 'b'));
+}
+#endif
+
+TEST(CommandIntegrationTest, OutputCompressedCapturesFrames) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  constexpr std::size_t kStdoutBytes = 4 * 1024 * 1024;
+
+  Command cmd(helper);
+  cmd.arg("--stdout-bytes").arg(std::to_string(kStdoutBytes)).arg("--stderr-bytes").arg("300");
+  for (Compression codec : {Compression::zstd, Compression::lz4}) {
+    auto out = cmd.output_compressed(codec);
+    if (!compression_supported(codec)) {
+      ASSERT_FALSE(out.has_value());
+      EXPECT_EQ(out.error().code, make_error_code(errc::invalid_argument));
+      continue;
+    }
+    ASSERT_TRUE(out.has_value()) << out.error().context << " " << out.error().code.message();
+    EXPECT_TRUE(out->status.success());
+    EXPECT_EQ(out->stdout_data.size(), kStdoutBytes);
+    EXPECT_LT(out->stdout_data.compressed_size(), kStdoutBytes / 100);
+    auto stdout_data = out->stdout_data.decompress();
+    ASSERT_TRUE(stdout_data.has_value()) << stdout_data.error().context;
+    EXPECT_EQ(stdout_data.value(), std::string(kStdoutBytes, 'a'));
+    auto stderr_data = out->stderr_data.decompress();
+    ASSERT_TRUE(stderr_data.has_value()) << stderr_data.error().context;
+    EXPECT_EQ(stderr_data.value(), std::string(300, 'b'));
+  }
+}
+
+TEST(CommandIntegrationTest, OutputCompressedUnsupportedCodecDoesNotSpawn) {
+  std::filesystem::path marker =
+      std::filesystem::temp_directory_path() / ("procly_codec_" + std::to_string(procly_test_pid()));
+  std::error_code ec;
+  std::filesystem::remove(marker, ec);
+  for (Compression codec : {Compression::zstd, Compression::lz4}) {
+    if (compression_supported(codec)) {
+      continue;
+    }
+    Command cmd("/bin/touch");
+    cmd.arg(marker.string());
+    auto out = cmd.output_compressed(codec);
+    ASSERT_FALSE(out.has_value());
+    EXPECT_EQ(out.error().code, make_error_code(errc::invalid_argument));
+    EXPECT_FALSE(std::filesystem::exists(marker));
+  }
+  std::filesystem::remove(marker, ec);
+}
+
+TEST(CommandIntegrationTest, OutputIntoReusesCallerBuffers) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  Command cmd(helper);
+  cmd.arg("--stdout-bytes").arg("100000").arg("--stderr-bytes").arg("300");
+
+  std::string out = "stale";
+  std::string err;
+  out.reserve(1024 * 1024);
+  err.reserve(4096);
+  const char* out_storage = out.data();
+  const char* err_storage = err.data();
+  for (int i = 0; i < 3; ++i) {
+    auto status = cmd.output_into(out, err);
+    ASSERT_TRUE(status.has_value()) << status.error().context << " "
+                                    << status.error().code.message();
+    EXPECT_TRUE(status->success());
+    EXPECT_EQ(out, std::string(100000, 'a'));
+    EXPECT_EQ(err.size(), 300U);
+    EXPECT_EQ(out.data(), out_storage);
+    EXPECT_EQ(err.data(), err_storage);
+  }
+}
+
+TEST(CommandIntegrationTest, OutputChunkedCapturesIntoFixedSizeChunks) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  constexpr std::size_t kBytes = 3 * ChunkedBuffer::kChunkBytes + 123;
+  Command cmd(helper);
+  cmd.arg("--stdout-bytes").arg(std::to_string(kBytes)).arg("--stderr-bytes").arg("300");
+  auto out = cmd.output_chunked();
+  ASSERT_TRUE(out.has_value()) << out.error().context << " " << out.error().code.message();
+  EXPECT_TRUE(out->status.success());
+  EXPECT_EQ(out->stdout_data.size(), kBytes);
+  EXPECT_EQ(out->stdout_data.chunk_count(), 4U);
+  for (std::string_view chunk : out->stdout_data) {
+    EXPECT_LE(chunk.size(), ChunkedBuffer::kChunkBytes);
+  }
+  EXPECT_EQ(out->stdout_data.flatten(), std::string(kBytes, 'a'));
+  EXPECT_EQ(out->stderr_data.size(), 300U);
+}
+
+TEST(CommandIntegrationTest, OutputTimelineRecordsInterleaving) {
+  Command cmd("/bin/sh");
+  cmd.arg("-c").arg("printf a; sleep 0.1; printf b >&2; sleep 0.1; printf c");
+  auto out = cmd.output_timeline();
+  ASSERT_TRUE(out.has_value()) << out.error().context << " " << out.error().code.message();
+  EXPECT_TRUE(out->status.success());
+  EXPECT_EQ(out->data, "abc");
+  ASSERT_EQ(out->records.size(), 3U);
+  EXPECT_EQ(out->records[0].stream, OutputStream::out);
+  EXPECT_EQ(out->records[1].stream, OutputStream::err);
+  EXPECT_EQ(out->records[2].stream, OutputStream::out);
+  EXPECT_EQ(out->bytes(out->records[1]), "b");
+  EXPECT_GT(out->records[1].at, out->records[0].at);
+  EXPECT_GT(out->records[2].at, out->records[1].at);
+  EXPECT_EQ(out->stream_data(OutputStream::out), "ac");
+  EXPECT_EQ(out->stream_data(OutputStream::err), "b");
+}
+
+TEST(CommandIntegrationTest, OutputWithInputFeedsLargeInputWithoutDeadlock) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  std::string input(4 * 1024 * 1024, 'x');
+  for (std::size_t i = 0; i < input.size(); i += 4096) {
+    input[i] = static_cast<char>('a' + (i / 4096) % 26);
+  }
+  Command cmd(helper);
+  cmd.arg("--echo-stdin").stdin(Stdio::null());
+  auto output = cmd.output_with_input(input);
+  ASSERT_TRUE(output.has_value()) << output.error().context << " "
+                                  << output.error().code.message();
+  EXPECT_TRUE(output->status.success());
+  EXPECT_EQ(output->stdout_data.size(), input.size());
+  EXPECT_TRUE(output->stdout_data == input);
+}
+
+TEST(CommandIntegrationTest, OutputWithInputToleratesEarlyStdinClose) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  Command cmd(helper);
+  cmd.arg("--close-stdin").arg("--stdout-bytes").arg("10");
+  auto output = cmd.output_with_input(std::string(1024 * 1024, 'x'));
+  ASSERT_TRUE(output.has_value()) << output.error().context << " "
+                                  << output.error().code.message();
+  EXPECT_TRUE(output->status.success());
+  EXPECT_EQ(output->stdout_data, std::string(10, 'a'));
+}
+
+TEST(CommandIntegrationTest, OutputWithBracedDefaultOptions) {
+  Command cmd("/bin/echo");
+  cmd.arg("hi");
+  auto output = cmd.output({});
+  ASSERT_TRUE(output.has_value()) << output.error().context;
+  EXPECT_EQ(output->stdout_data, "hi\n");
+}
+
+TEST(CommandIntegrationTest, OutputPullsChunksFromStdinSource) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  int row = 0;
+  std::string expected;
+  auto source = StdinSource::chunks([&]() -> std::optional<std::string> {
+    if (row == 5000) {
+      return std::nullopt;
+    }
+    // Every tenth chunk is empty and must be skipped rather than end the input.
+    std::string line = row % 10 == 0 ? "" : std::to_string(row) + ",name,value\n";
+    expected += line;
+    ++row;
+    return line;
+  });
+  Command cmd(helper);
+  cmd.arg("--echo-stdin");
+  auto output = cmd.output_from(std::move(source));
+  ASSERT_TRUE(output.has_value()) << output.error().context << " "
+                                  << output.error().code.message();
+  EXPECT_TRUE(output->status.success());
+  EXPECT_EQ(row, 5000);
+  EXPECT_TRUE(output->stdout_data == expected);
+}
+
+TEST(CommandIntegrationTest, OutputStdinSourceFollowsChildPace) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  // An endless producer: only the child closing its stdin ends the feed, and the producer is
+  // asked for no more than the pipe could take before that.
+  std::size_t produced = 0;
+  auto source = StdinSource::fill([&](char* data, std::size_t capacity) {
+    std::fill_n(data, capacity, 'x');
+    produced += capacity;
+    return capacity;
+  });
+  Command cmd(helper);
+  cmd.arg("--close-stdin").arg("--stdout-bytes").arg("10");
+  auto output = cmd.output_from(std::move(source));
+  ASSERT_TRUE(output.has_value()) << output.error().context << " "
+                                  << output.error().code.message();
+  EXPECT_TRUE(output->status.success());
+  EXPECT_EQ(output->stdout_data, std::string(10, 'a'));
+  EXPECT_LE(produced, 16 * StdinSource::kFillBytes);
+}
+
+TEST(CommandIntegrationTest, OutputCaptureLimitKillsChild) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  Command cmd(helper);
+  cmd.arg("--stdout-bytes").arg(std::to_string(64 * 1024 * 1024));
+  cmd.arg("--stderr-bytes").arg("4096");
+
+  CaptureOptions limits;
+  limits.stdout_limit = CaptureLimit{.max_bytes = 1024, .policy = OverflowPolicy::kill};
+  limits.stderr_limit = CaptureLimit{.max_bytes = 16, .policy = OverflowPolicy::keep_tail};
+  auto out = cmd.output(limits);
+  ASSERT_TRUE(out.has_value()) << out.error().context << " " << out.error().code.message();
+  EXPECT_FALSE(out->status.success());
+  EXPECT_EQ(out->stdout_data.size(), 1024U);
+  EXPECT_GT(out->stdout_dropped, 0U);
+  EXPECT_LE(out->stderr_data.size(), 16U);
+}
+
+TEST(CommandIntegrationTest, OutputDigestCoversDroppedAndCapturedBytes) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  Command cmd(helper);
+  cmd.arg("--stdout-bytes").arg("300000");
+  cmd.arg("--stderr-bytes").arg("5000");
+
+  CaptureOptions options;
+  options.stdout_limit = CaptureLimit{.max_bytes = 0, .policy = OverflowPolicy::keep_head};
+  options.stdout_digest = DigestAlgorithm::sha256;
+  options.stderr_digest = DigestAlgorithm::crc32c;
+  auto out = cmd.output(options);
+  ASSERT_TRUE(out.has_value()) << out.error().context << " " << out.error().code.message();
+  EXPECT_TRUE(out->status.success());
+  EXPECT_TRUE(out->stdout_data.empty());
+  EXPECT_EQ(out->stdout_dropped, 300000U);
+
+  Digest expected_stdout(DigestAlgorithm::sha256);
+  expected_stdout.update(std::string(300000, 'a'));
+  Digest expected_stderr(DigestAlgorithm::crc32c);
+  expected_stderr.update(out->stderr_data);
+  EXPECT_EQ(out->stdout_digest, expected_stdout.hex());
+  EXPECT_EQ(out->stderr_digest, expected_stderr.hex());
+}
+
+TEST(CommandIntegrationTest, OutputStreamsChunksWithoutBuffering) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  constexpr std::size_t kStdoutBytes = 8 * 1024 * 1024;
+
+  Command cmd(helper);
+  cmd.arg("--stdout-bytes").arg(std::to_string(kStdoutBytes));
+  cmd.arg("--stderr-bytes").arg("10");
+
+  std::size_t stdout_total = 0;
+  std::size_t largest_chunk = 0;
+  std::size_t stderr_total = 0;
+  auto status = cmd.output(
+      OutputSink::chunks(OutputSink::ChunkCallback([&](const std::byte*, std::size_t size) {
+        stdout_total += size;
+        largest_chunk = std::max(largest_chunk, size);
+      })),
+      OutputSink::chunks(OutputSink::ChunkCallback(
+          [&](const std::byte*, std::size_t size) { stderr_total += size; })));
+  ASSERT_TRUE(status.has_value()) << status.error().context << " "
+                                  << status.error().code.message();
+  EXPECT_TRUE(status->success());
+  EXPECT_EQ(stdout_total, kStdoutBytes);
+  EXPECT_EQ(stderr_total, 10U);
+  EXPECT_LE(largest_chunk, 64U * 1024U);
+}
+
+TEST(CommandIntegrationTest, OutputStreamsLines) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  std::filesystem::path input_path = unique_temp_path("lines");
+  {
+    std::ofstream input(input_path);
+    for (int i = 0; i < 1000; ++i) {
+      input << "line " << i << "\n";
+    }
+    input << "tail";
+  }
+
+  Command cmd(helper);
+  cmd.arg("--echo-stdin").stdin(Stdio::file(input_path));
+  std::vector<std::string> lines;
+  auto status = cmd.output(
+      OutputSink::lines([&](std::string_view line) { lines.emplace_back(line); }), OutputSink());
+  std::filesystem::remove(input_path);
+  ASSERT_TRUE(status.has_value()) << status.error().context << " "
+                                  << status.error().code.message();
+  ASSERT_EQ(lines.size(), 1001U);
+  EXPECT_EQ(lines.front(), "line 0");
+  EXPECT_EQ(lines[999], "line 999");
+  EXPECT_EQ(lines.back(), "tail");
+}
+
+#if PROCLY_PLATFORM_POSIX
+TEST(CommandIntegrationTest, OutputTeeCapturesAndLogsFromOneDrainLoop) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  std::filesystem::path log_path = unique_temp_path("tee");
+  auto log = OutputSink::file(log_path, false);
+  ASSERT_TRUE(log.has_value()) << log.error().context << " " << log.error().code.message();
+  std::string captured;
+  std::size_t chunk_bytes = 0;
+  Command cmd(helper);
+  cmd.arg("--stdout-bytes").arg("200000");
+  auto status = cmd.output(
+      OutputSink::tee({OutputSink::capture(captured), std::move(log.value()),
+                       OutputSink::chunks(OutputSink::ChunkCallback(
+                           [&](const std::byte*, std::size_t size) { chunk_bytes += size; }))}),
+      OutputSink());
+  ASSERT_TRUE(status.has_value()) << status.error().context << " "
+                                  << status.error().code.message();
+  EXPECT_TRUE(status->success());
+  EXPECT_EQ(captured, std::string(200000, 'a'));
+  EXPECT_EQ(chunk_bytes, 200000U);
+  EXPECT_EQ(read_file(log_path), captured);
+  std::filesystem::remove(log_path);
+}
+#endif
+
 TEST(CommandIntegrationTest, OutputParallelCalls) {
   std::string helper = helper_path();
   ASSERT_FALSE(helper.empty());
@@ -1171,6 +2972,908 @@ TEST(CommandIntegrationTest, NoFdLeakIntoGrandchild) {
 
   std::filesystem::remove(fd_path, remove_ec);
 }
+
+TEST(CommandIntegrationTest, NonCloexecFdIsNotInheritedByDefault) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  int leaked_fd = ::open("/dev/null", O_RDONLY);
+  ASSERT_GE(leaked_fd, 0);
+
+  std::filesystem::path fd_path = unique_temp_path("default_fds");
+  Command cmd(helper);
+  cmd.arg("--write-open-fds").arg(fd_path.string());
+  auto status = cmd.status();
+  ::close(leaked_fd);
+  ASSERT_TRUE(status.has_value()) << status.error().context << " " << status.error().code.message();
+
+  auto fds = read_fd_list(fd_path);
+  std::error_code remove_ec;
+  std::filesystem::remove(fd_path, remove_ec);
+  ASSERT_FALSE(fds.empty());
+  for (int fd : fds) {
+    EXPECT_NE(fd, leaked_fd);
+  }
+}
+
+TEST(CommandIntegrationTest, TrustCloexecInheritsNonCloexecFd) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  int inherited_fd = ::open("/dev/null", O_RDONLY);
+  ASSERT_GE(inherited_fd, 0);
+
+  std::filesystem::path fd_path = unique_temp_path("trusted_fds");
+  Command cmd(helper);
+  cmd.arg("--write-open-fds").arg(fd_path.string());
+  cmd.options(SpawnOptions{.trust_cloexec = true});
+  auto status = cmd.status();
+  ::close(inherited_fd);
+  ASSERT_TRUE(status.has_value()) << status.error().context << " " << status.error().code.message();
+
+  auto fds = read_fd_list(fd_path);
+  std::error_code remove_ec;
+  std::filesystem::remove(fd_path, remove_ec);
+  EXPECT_NE(std::find(fds.begin(), fds.end(), inherited_fd), fds.end());
+}
+
+TEST(CommandIntegrationTest, CwdFdOverride) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  std::filesystem::path cwd = std::filesystem::temp_directory_path();
+  int dir_fd = ::open(cwd.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  ASSERT_GE(dir_fd, 0);
+
+  Command cmd(helper);
+  cmd.arg("--print-cwd");
+  cmd.current_dir(dir_fd);
+  for (int i = 0; i < 2; ++i) {
+    auto output = cmd.output();
+    ASSERT_TRUE(output.has_value())
+        << output.error().context << " " << output.error().code.message();
+    std::error_code ec;
+    EXPECT_TRUE(std::filesystem::equivalent(std::filesystem::path(output->stdout_data), cwd, ec))
+        << ec.message();
+  }
+  ::close(dir_fd);
+}
+
+TEST(CommandIntegrationTest, CwdResolvesRelativePathEntriesForPathAndFd) {
+  std::filesystem::path dir_path = unique_temp_path("cwd_fd_path_dir");
+  std::error_code ec;
+  std::filesystem::create_directories(dir_path / "bin", ec);
+  ASSERT_FALSE(ec) << ec.message();
+
+  std::filesystem::path script_path = dir_path / "bin" / "procly_echo";
+  {
+    std::ofstream script(script_path);
+    ASSERT_TRUE(script.is_open());
+    script << "#!/bin/sh\n";
+    script << "printf \"cwd_exec_ok\"";
+  }
+  ASSERT_EQ(::chmod(script_path.c_str(), 0755), 0);
+  int dir_fd = ::open(dir_path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  ASSERT_GE(dir_fd, 0);
+
+  Command by_path("procly_echo");
+  by_path.current_dir(dir_path);
+  by_path.env_clear();
+  by_path.env("PATH", "bin");
+  Command by_fd = by_path;
+  by_fd.current_dir(dir_fd);
+
+  for (const Command* cmd : {&by_path, &by_fd}) {
+    auto out = cmd->output();
+    ASSERT_TRUE(out.has_value()) << out.error().context << " " << out.error().code.message();
+    EXPECT_EQ(out->stdout_data, "cwd_exec_ok");
+  }
+
+  ::close(dir_fd);
+  std::filesystem::remove_all(dir_path, ec);
+}
+#endif
+
+#if PROCLY_PLATFORM_POSIX
+class RecordingObserver final : public Observer {
+ public:
+  void on_lowered(const LoweringEvent& event) override {
+    std::lock_guard lock(mutex_);
+    lowered.push_back(std::string(event.program));
+  }
+  void on_spawn(const SpawnEvent& event) override {
+    std::lock_guard lock(mutex_);
+    spawns.push_back(event);
+    spawns.back().program = {};
+  }
+  void on_drain(const DrainEvent& event) override {
+    std::lock_guard lock(mutex_);
+    drains.push_back(event);
+  }
+  void on_wait(const WaitEvent& event) override {
+    std::lock_guard lock(mutex_);
+    waits.push_back(event);
+  }
+  void on_signal(const SignalEvent& event) override {
+    std::lock_guard lock(mutex_);
+    signals.push_back(event);
+  }
+
+  std::vector<std::string> lowered;
+  std::vector<SpawnEvent> spawns;
+  std::vector<DrainEvent> drains;
+  std::vector<WaitEvent> waits;
+  std::vector<SignalEvent> signals;
+
+ private:
+  std::mutex mutex_;
+};
+
+class ScopedObserver {
+ public:
+  explicit ScopedObserver(Observer& observer) { set_observer(&observer); }
+  ~ScopedObserver() { set_observer(nullptr); }
+  ScopedObserver(const ScopedObserver&) = delete;
+  ScopedObserver& operator=(const ScopedObserver&) = delete;
+};
+
+TEST(ObserverIntegrationTest, ReportsLoweringSpawnDrainAndWait) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  RecordingObserver recorder;
+  {
+    ScopedObserver scope(recorder);
+    Command cmd(helper);
+    cmd.arg("--stdout-bytes").arg("100").arg("--stderr-bytes").arg("7");
+    auto output = cmd.output();
+    ASSERT_TRUE(output.has_value())
+        << output.error().context << " " << output.error().code.message();
+  }
+
+  ASSERT_EQ(recorder.lowered.size(), 1U);
+  EXPECT_EQ(recorder.lowered[0], helper);
+  ASSERT_EQ(recorder.spawns.size(), 1U);
+  const auto& spawn = recorder.spawns[0];
+  EXPECT_GT(spawn.pid, 0);
+  EXPECT_FALSE(spawn.error);
+  EXPECT_LE(spawn.start, spawn.end);
+#if defined(PROCLY_FORCE_FORK) || defined(PROCLY_FORCE_VFORK)
+  EXPECT_EQ(spawn.fallback_reason, SpawnFallbackReason::forced);
+#else
+  EXPECT_EQ(spawn.strategy, SpawnStrategy::posix_spawn);
+  EXPECT_EQ(spawn.fallback_reason, SpawnFallbackReason::none);
+#endif
+  ASSERT_EQ(recorder.drains.size(), 1U);
+  EXPECT_EQ(recorder.drains[0].stdout_bytes, 100U);
+  EXPECT_EQ(recorder.drains[0].stderr_bytes, 7U);
+  ASSERT_EQ(recorder.waits.size(), 1U);
+  EXPECT_EQ(recorder.waits[0].pid, spawn.pid);
+  EXPECT_FALSE(recorder.waits[0].timed_out);
+}
+
+TEST(ObserverIntegrationTest, ReportsFallbackReasonAndEscalation) {
+  RecordingObserver recorder;
+  {
+    ScopedObserver scope(recorder);
+    Command cmd("/bin/sleep");
+    cmd.arg("5");
+    cmd.limit(RLIMIT_CORE, 0, 0);
+    auto child = cmd.spawn();
+    ASSERT_TRUE(child.has_value()) << child.error().context << " "
+                                   << child.error().code.message();
+    WaitOptions opts;
+    opts.timeout = std::chrono::milliseconds(10);
+    auto waited = child->wait(opts);
+    ASSERT_TRUE(waited.has_value()) << waited.error().context << " "
+                                    << waited.error().code.message();
+  }
+
+  ASSERT_EQ(recorder.spawns.size(), 1U);
+  EXPECT_NE(recorder.spawns[0].strategy, SpawnStrategy::posix_spawn);
+#if !defined(PROCLY_FORCE_FORK) && !defined(PROCLY_FORCE_VFORK)
+  EXPECT_EQ(recorder.spawns[0].fallback_reason, SpawnFallbackReason::resource_limits);
+#endif
+  ASSERT_FALSE(recorder.signals.empty());
+  EXPECT_EQ(recorder.signals[0].signo, SIGTERM);
+  ASSERT_EQ(recorder.waits.size(), 1U);
+  EXPECT_TRUE(recorder.waits[0].timed_out);
+  EXPECT_TRUE(recorder.waits[0].sent_terminate);
+}
+
+bool wait_until_untracked(const Reaper& reaper) {
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (reaper.tracked() != 0) {
+    if (std::chrono::steady_clock::now() > deadline) {
+      return false;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  return true;
+}
+
+TEST(ReaperIntegrationTest, WaitReceivesStatusFromReaper) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  auto reaper = Reaper::start();
+  ASSERT_TRUE(reaper.has_value()) << reaper.error().context << " "
+                                  << reaper.error().code.message();
+
+  Command cmd(helper);
+  cmd.arg("--exit-code").arg("3");
+  auto child = cmd.spawn();
+  ASSERT_TRUE(child.has_value()) << child.error().context << " " << child.error().code.message();
+  EXPECT_EQ(reaper->tracked(), 1U);
+
+  auto waited = child->wait(WaitOptions{});
+  ASSERT_TRUE(waited.has_value()) << waited.error().context << " "
+                                  << waited.error().code.message();
+  EXPECT_EQ(waited->status.code(), 3);
+  EXPECT_TRUE(waited->usage.has_value());
+  EXPECT_EQ(reaper->tracked(), 0U);
+
+  auto output = Command(helper).arg("--stdout-bytes").arg("64").output();
+  ASSERT_TRUE(output.has_value()) << output.error().context << " "
+                                  << output.error().code.message();
+  EXPECT_TRUE(output->status.success());
+  EXPECT_EQ(output->stdout_data.size(), 64U);
+  EXPECT_EQ(reaper->tracked(), 0U);
+}
+
+TEST(ReaperIntegrationTest, DroppedChildIsReapedInBackground) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  auto reaper = Reaper::start();
+  ASSERT_TRUE(reaper.has_value()) << reaper.error().context << " "
+                                  << reaper.error().code.message();
+
+  int pid = -1;
+  {
+    Command cmd(helper);
+    cmd.arg("--sleep-ms").arg("20");
+    auto child = cmd.spawn();
+    ASSERT_TRUE(child.has_value()) << child.error().context << " "
+                                   << child.error().code.message();
+    pid = child->id();
+  }
+  ASSERT_TRUE(wait_until_untracked(reaper.value()));
+  // Already reaped: the pid is no longer our child.
+  errno = 0;
+  EXPECT_EQ(::waitpid(pid, nullptr, WNOHANG), -1);
+  EXPECT_EQ(errno, ECHILD);
+}
+
+TEST(ReaperIntegrationTest, TimeoutEscalatesThroughReaper) {
+  auto reaper = Reaper::start();
+  ASSERT_TRUE(reaper.has_value()) << reaper.error().context << " "
+                                  << reaper.error().code.message();
+
+  Command cmd("/bin/sleep");
+  cmd.arg("5");
+  auto child = cmd.spawn();
+  ASSERT_TRUE(child.has_value()) << child.error().context << " " << child.error().code.message();
+  WaitOptions opts;
+  opts.timeout = std::chrono::milliseconds(20);
+  auto waited = child->wait(opts);
+  ASSERT_TRUE(waited.has_value()) << waited.error().context << " "
+                                  << waited.error().code.message();
+  EXPECT_TRUE(waited->timed_out);
+  EXPECT_TRUE(waited->sent_terminate);
+  EXPECT_FALSE(waited->status.success());
+  EXPECT_EQ(reaper->tracked(), 0U);
+}
+
+TEST(ReaperIntegrationTest, ManyWaitersShareOneReaper) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  auto reaper = Reaper::start();
+  ASSERT_TRUE(reaper.has_value()) << reaper.error().context << " "
+                                  << reaper.error().code.message();
+
+  constexpr int kChildren = 16;
+  std::vector<Child> children;
+  for (int i = 0; i < kChildren; ++i) {
+    Command cmd(helper);
+    cmd.arg("--sleep-ms").arg(std::to_string(i % 4 * 5)).arg("--exit-code").arg(std::to_string(i));
+    auto child = cmd.spawn();
+    ASSERT_TRUE(child.has_value()) << child.error().context << " "
+                                   << child.error().code.message();
+    children.push_back(std::move(child.value()));
+  }
+  std::vector<std::optional<int>> codes(kChildren);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kChildren; ++i) {
+    threads.emplace_back([&, i] {
+      auto status = children[i].wait();
+      if (status) {
+        codes[i] = status->code();
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (int i = 0; i < kChildren; ++i) {
+    EXPECT_EQ(codes[i], std::optional<int>(i));
+  }
+  EXPECT_EQ(reaper->tracked(), 0U);
+}
+
+TEST(ReaperIntegrationTest, OnlyOneReaperRuns) {
+  auto first = Reaper::start();
+  ASSERT_TRUE(first.has_value()) << first.error().context << " " << first.error().code.message();
+  auto second = Reaper::start();
+  ASSERT_FALSE(second.has_value());
+  EXPECT_EQ(second.error().code, std::make_error_code(std::errc::device_or_resource_busy));
+}
+
+TEST(ForkServerIntegrationTest, SpawnsAndCapturesThroughServer) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  auto server = ForkServer::start();
+  ASSERT_TRUE(server.has_value()) << server.error().context << " "
+                                  << server.error().code.message();
+  ForkServer::Scope scope(server.value());
+
+  Command cmd(helper);
+  cmd.arg("--stdout-bytes").arg("100000").arg("--stderr-bytes").arg("10");
+  cmd.arg("--exit-code").arg("3");
+  auto output = cmd.output();
+  ASSERT_TRUE(output.has_value()) << output.error().context << " "
+                                  << output.error().code.message();
+  EXPECT_EQ(output->status.code(), std::optional<int>(3));
+  EXPECT_EQ(output->stdout_data, std::string(100000, 'a'));
+  EXPECT_EQ(output->stderr_data.size(), 10U);
+
+  std::string input(1024 * 1024, 'z');
+  Command first(helper);
+  first.arg("--echo-stdin");
+  Command second(helper);
+  second.arg("--echo-stdin");
+  auto piped = (first | second).output_with_input(input);
+  ASSERT_TRUE(piped.has_value()) << piped.error().context << " "
+                                 << piped.error().code.message();
+  EXPECT_TRUE(piped->status.success());
+  EXPECT_TRUE(piped->stdout_data == input);
+}
+
+#if PROCLY_PLATFORM_LINUX
+TEST(ForkServerIntegrationTest, ChildrenAreParentedByServer) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  auto server = ForkServer::start();
+  ASSERT_TRUE(server.has_value());
+  ForkServer::Scope scope(server.value());
+
+  auto child = Command(helper).arg("--sleep-ms").arg("5000").spawn();
+  ASSERT_TRUE(child.has_value()) << child.error().context << " "
+                                 << child.error().code.message();
+  std::ifstream stat("/proc/" + std::to_string(child->id()) + "/stat");
+  std::string pid_field;
+  std::string comm;
+  std::string state;
+  int ppid = 0;
+  stat >> pid_field >> comm >> state >> ppid;
+  EXPECT_EQ(ppid, server->id());
+  EXPECT_NE(ppid, static_cast<int>(::getpid()));
+
+  WaitOptions options;
+  options.timeout = std::chrono::milliseconds(50);
+  auto waited = child->wait(options);
+  ASSERT_TRUE(waited.has_value()) << waited.error().context << " "
+                                  << waited.error().code.message();
+  EXPECT_TRUE(waited->timed_out);
+  EXPECT_TRUE(waited->sent_terminate);
+  EXPECT_FALSE(waited->success());
+}
+#endif
+
+TEST(ForkServerIntegrationTest, ExitHandleFiresOnExit) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  auto server = ForkServer::start();
+  ASSERT_TRUE(server.has_value());
+  ForkServer::Scope scope(server.value());
+
+  auto child = Command(helper).arg("--sleep-ms").arg("50").spawn();
+  ASSERT_TRUE(child.has_value()) << child.error().context << " "
+                                 << child.error().code.message();
+  auto handle = child->exit_handle();
+  ASSERT_TRUE(handle.has_value()) << handle.error().context << " "
+                                  << handle.error().code.message();
+  pollfd pfd{.fd = handle.value(), .events = POLLIN, .revents = 0};
+  ASSERT_EQ(::poll(&pfd, 1, 5000), 1);
+  auto status = child->try_wait();
+  ASSERT_TRUE(status.has_value());
+  ASSERT_TRUE(status->has_value());
+  EXPECT_TRUE(status->value().success());
+}
+
+TEST(ForkServerIntegrationTest, SpawnErrorsComeBackFromServer) {
+  auto server = ForkServer::start();
+  ASSERT_TRUE(server.has_value());
+  ForkServer::Scope scope(server.value());
+
+  auto status = Command("/nonexistent/procly-fork-server").status();
+  ASSERT_FALSE(status.has_value());
+  EXPECT_EQ(status.error().code, std::error_code(ENOENT, std::system_category()));
+}
+#endif
+
+#if PROCLY_PLATFORM_POSIX
+TEST(ZygoteIntegrationTest, ForksWarmCopiesWithFreshStreams) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  auto zygote = Zygote::start(Command(helper).arg("--sleep-ms").arg("200").arg("--zygote")
+                                  .arg("--echo-stdin"));
+  ASSERT_TRUE(zygote.has_value()) << zygote.error().context << " "
+                                  << zygote.error().code.message();
+
+  for (const std::string input : {"first", "second"}) {
+    auto start = std::chrono::steady_clock::now();
+    auto output = zygote->output(Stdio::bytes(input));
+    ASSERT_TRUE(output.has_value()) << output.error().context << " "
+                                    << output.error().code.message();
+    EXPECT_TRUE(output->status.success());
+    EXPECT_EQ(output->stdout_data, input);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(200));
+  }
+}
+
+TEST(ZygoteIntegrationTest, KillAndExitHandleRouteThroughTemplate) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  auto zygote = Zygote::start(Command(helper).arg("--zygote").arg("--echo-stdin"));
+  ASSERT_TRUE(zygote.has_value());
+
+  auto child = zygote->fork(Stdio::piped(), Stdio::null());
+  ASSERT_TRUE(child.has_value()) << child.error().context << " "
+                                 << child.error().code.message();
+  EXPECT_NE(child->id(), zygote->id());
+  auto handle = child->exit_handle();
+  ASSERT_TRUE(handle.has_value());
+  ASSERT_TRUE(child->kill().has_value());
+  pollfd pfd{.fd = handle.value(), .events = POLLIN, .revents = 0};
+  ASSERT_EQ(::poll(&pfd, 1, 5000), 1);
+  auto status = child->wait();
+  ASSERT_TRUE(status.has_value()) << status.error().context << " "
+                                  << status.error().code.message();
+  EXPECT_FALSE(status->success());
+  EXPECT_EQ(procly::unix::terminating_signal(status.value()), std::optional<int>(SIGKILL));
+}
+
+TEST(ZygoteIntegrationTest, StartFailsWhenTemplateExitsBeforeReady) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  auto zygote = Zygote::start(Command(helper).arg("--exit-code").arg("0"));
+  ASSERT_FALSE(zygote.has_value());
+  EXPECT_EQ(zygote.error().code, make_error_code(errc::spawn_failed));
+}
 #endif
 
+#if PROCLY_PLATFORM_POSIX
+TEST(ReplayIntegrationTest, ReplayServesRecordedOutputAndStatus) {
+  auto path = unique_temp_path("replay_output");
+  Command command("/bin/sh");
+  command.args({"-c", "printf out; printf err >&2; exit 3"});
+  {
+    Recorder recorder(path);
+    auto recorded = Command(command).backend(recorder.backend()).output();
+    ASSERT_TRUE(recorded.has_value()) << recorded.error().context;
+    EXPECT_EQ(recorded->stdout_data, "out");
+    EXPECT_EQ(recorded->stderr_data, "err");
+    EXPECT_EQ(recorder.recorded(), 1U);
+    ASSERT_TRUE(recorder.save().has_value());
+  }
+
+  auto replayer = Replayer::open(path, ReplayOptions{.time_scale = 0});
+  ASSERT_TRUE(replayer.has_value()) << replayer.error().context;
+  EXPECT_EQ(replayer->remaining(), 1U);
+  auto replayed = Command(command).backend(replayer->backend()).output();
+  ASSERT_TRUE(replayed.has_value()) << replayed.error().context;
+  EXPECT_EQ(replayed->stdout_data, "out");
+  EXPECT_EQ(replayed->stderr_data, "err");
+  EXPECT_EQ(replayed->status.code(), std::optional<int>(3));
+  EXPECT_EQ(replayer->remaining(), 0U);
+
+  auto exhausted = Command(command).backend(replayer->backend()).output();
+  ASSERT_FALSE(exhausted.has_value());
+  EXPECT_EQ(exhausted.error().code, make_error_code(errc::spawn_failed));
+  std::filesystem::remove(path);
+}
+
+TEST(ReplayIntegrationTest, ReplayKeepsRecordedTiming) {
+  auto path = unique_temp_path("replay_timing");
+  Command command("/bin/sh");
+  command.args({"-c", "printf a; sleep 0.2; printf b"});
+  {
+    Recorder recorder(path);
+    Recorder::Scope scope(recorder);
+    auto recorded = command.output();
+    ASSERT_TRUE(recorded.has_value());
+    EXPECT_EQ(recorded->stdout_data, "ab");
+  }
+
+  auto replayer = Replayer::open(path);
+  ASSERT_TRUE(replayer.has_value()) << replayer.error().context;
+  Replayer::Scope scope(replayer.value());
+  auto start = std::chrono::steady_clock::now();
+  auto replayed = command.output();
+  ASSERT_TRUE(replayed.has_value());
+  EXPECT_EQ(replayed->stdout_data, "ab");
+  EXPECT_TRUE(replayed->status.success());
+  EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(150));
+  std::filesystem::remove(path);
+}
+
+TEST(ReplayIntegrationTest, SignalEndsReplayedChild) {
+  auto path = unique_temp_path("replay_signal");
+  Command command("/bin/sh");
+  command.args({"-c", "sleep 0.3"});
+  {
+    Recorder recorder(path);
+    auto status = Command(command).backend(recorder.backend()).status();
+    ASSERT_TRUE(status.has_value());
+  }
+
+  auto replayer = Replayer::open(path);
+  ASSERT_TRUE(replayer.has_value());
+  auto child = Command(command).backend(replayer->backend()).spawn();
+  ASSERT_TRUE(child.has_value()) << child.error().context;
+  auto running = child->try_wait();
+  ASSERT_TRUE(running.has_value());
+  EXPECT_FALSE(running->has_value());
+  ASSERT_TRUE(child->terminate().has_value());
+  auto status = child->wait();
+  ASSERT_TRUE(status.has_value());
+  EXPECT_EQ(procly::unix::terminating_signal(status.value()), std::optional<int>(SIGTERM));
+  std::filesystem::remove(path);
+}
+#endif
+
+TEST(WorkerPoolIntegrationTest, NewlineWorkersAnswerRequests) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  WorkerPoolOptions options;
+  options.workers = 2;
+  auto pool = WorkerPool::start(Command(helper).arg("--echo-stdin"), options);
+  ASSERT_TRUE(pool.has_value()) << pool.error().context << " " << pool.error().code.message();
+  EXPECT_EQ(pool->size(), 2u);
+
+  for (std::string request : {"alpha", "", "gamma"}) {
+    auto response = pool->call(request);
+    ASSERT_TRUE(response.has_value())
+        << response.error().context << " " << response.error().code.message();
+    EXPECT_EQ(response.value(), request);
+  }
+  EXPECT_EQ(pool->restarts(), 0u);
+
+  auto rejected = pool->call("two\nlines");
+  ASSERT_FALSE(rejected.has_value());
+  EXPECT_EQ(rejected.error().code, make_error_code(errc::invalid_argument));
+}
+
+TEST(WorkerPoolIntegrationTest, LengthPrefixedWorkersExchangeLargePayloads) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  WorkerPoolOptions options;
+  options.framing = WorkerFraming::length_prefixed;
+  auto pool = WorkerPool::start(Command(helper).arg("--echo-stdin"), options);
+  ASSERT_TRUE(pool.has_value()) << pool.error().context << " " << pool.error().code.message();
+
+  // Larger than a pipe buffer in both directions, with embedded newlines and NULs.
+  std::string request(1U << 20U, 'x');
+  request[10] = '\n';
+  request[20] = '\0';
+  auto response = pool->call(request);
+  ASSERT_TRUE(response.has_value())
+      << response.error().context << " " << response.error().code.message();
+  EXPECT_EQ(response.value(), request);
+}
+
+TEST(WorkerPoolIntegrationTest, ConcurrentCallsShareWorkers) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  WorkerPoolOptions options;
+  options.workers = 2;
+  auto pool = WorkerPool::start(Command(helper).arg("--echo-stdin"), options);
+  ASSERT_TRUE(pool.has_value()) << pool.error().context << " " << pool.error().code.message();
+
+  constexpr int kThreads = 4;
+  constexpr int kCallsPerThread = 25;
+  std::atomic<int> matched{0};
+  std::vector<std::thread> threads;
+  threads.reserve(kThreads);
+  for (int thread = 0; thread < kThreads; ++thread) {
+    threads.emplace_back([&pool, &matched, thread] {
+      for (int call = 0; call < kCallsPerThread; ++call) {
+        std::string request = std::to_string(thread) + ":" + std::to_string(call);
+        auto response = pool->call(request);
+        if (response.has_value() && response.value() == request) {
+          matched.fetch_add(1);
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(matched.load(), kThreads * kCallsPerThread);
+  EXPECT_EQ(pool->restarts(), 0u);
+}
+
+TEST(WorkerPoolIntegrationTest, RequestTimeoutReplacesWorker) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  WorkerPoolOptions options;
+  options.request_timeout = std::chrono::milliseconds(100);
+  options.kill_grace = std::chrono::milliseconds(100);
+  auto pool = WorkerPool::start(Command(helper).arg("--consume-stdin"), options);
+  ASSERT_TRUE(pool.has_value()) << pool.error().context << " " << pool.error().code.message();
+
+  auto start = std::chrono::steady_clock::now();
+  auto response = pool->call("ping");
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  ASSERT_FALSE(response.has_value());
+  EXPECT_EQ(response.error().code, make_error_code(errc::timeout));
+  EXPECT_LT(elapsed, std::chrono::seconds(2));
+  EXPECT_EQ(pool->restarts(), 1u);
+}
+
+TEST(WorkerPoolIntegrationTest, ExitedWorkerIsReplaced) {
+  // head answers a single line and exits, so every request after the first needs a new worker.
+  auto pool = WorkerPool::start(Command("head").args({"-n", "1"}));
+  ASSERT_TRUE(pool.has_value()) << pool.error().context << " " << pool.error().code.message();
+
+  auto first = pool->call("one");
+  ASSERT_TRUE(first.has_value()) << first.error().context << " " << first.error().code.message();
+  EXPECT_EQ(first.value(), "one");
+
+  // The exit may not be visible yet, in which case that call fails and the next one succeeds.
+  std::optional<std::string> second;
+  for (int attempt = 0; attempt < 3 && !second; ++attempt) {
+    auto response = pool->call("two");
+    if (response.has_value()) {
+      second = response.value();
+    }
+  }
+  ASSERT_TRUE(second.has_value());
+  EXPECT_EQ(*second, "two");
+  EXPECT_GE(pool->restarts(), 1u);
+}
+
+TEST(RunAllIntegrationTest, CapturesEveryCommandInInputOrder) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  std::vector<Command> commands;
+  for (int index = 0; index < 20; ++index) {
+    commands.push_back(Command(helper).arg("--stdout-bytes").arg(std::to_string(index)));
+  }
+  commands.emplace_back("/nonexistent/procly-run-all");
+
+  std::vector<std::size_t> completed;
+  RunAllOptions options;
+  options.on_complete = [&completed](std::size_t index, const Result<Output>&) {
+    completed.push_back(index);
+  };
+  auto results = run_all(commands.data(), commands.size(), Concurrency{4}, options);
+  ASSERT_TRUE(results.has_value()) << results.error().context << " "
+                                   << results.error().code.message();
+  ASSERT_EQ(results->size(), commands.size());
+  for (std::size_t index = 0; index < 20; ++index) {
+    const auto& result = results.value()[index];
+    ASSERT_TRUE(result.has_value()) << result.error().context;
+    EXPECT_TRUE(result->status.success());
+    EXPECT_EQ(result->stdout_data, std::string(index, 'a'));
+  }
+  EXPECT_FALSE(results.value().back().has_value());
+  EXPECT_EQ(completed.size(), commands.size());
+}
+
+TEST(RunAllIntegrationTest, BoundsConcurrencyAndStreamsCompletions) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  std::vector<Command> commands;
+  commands.push_back(Command(helper).arg("--sleep-ms").arg("300"));
+  for (int index = 0; index < 4; ++index) {
+    commands.push_back(Command(helper).arg("--sleep-ms").arg("100"));
+  }
+
+  std::vector<std::size_t> completed;
+  RunAllOptions options;
+  options.on_complete = [&completed](std::size_t index, const Result<Output>&) {
+    completed.push_back(index);
+  };
+  auto start = std::chrono::steady_clock::now();
+  auto results = run_all(commands.data(), commands.size(), Concurrency{2}, options);
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  ASSERT_TRUE(results.has_value());
+
+  // With two slots the short commands take turns in one while the slow one holds the other.
+  EXPECT_GE(elapsed, std::chrono::milliseconds(400));
+  ASSERT_EQ(completed.size(), commands.size());
+  EXPECT_EQ(completed.front(), 1u);
+  for (const auto& result : results.value()) {
+    ASSERT_TRUE(result.has_value());
+    EXPECT_TRUE(result->status.success());
+  }
+}
+
+TEST(RunAllIntegrationTest, FailFastCancelsUnstartedCommands) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  std::vector<Command> commands;
+  commands.push_back(Command(helper).arg("--exit-code").arg("0"));
+  commands.push_back(Command(helper).arg("--exit-code").arg("3"));
+  commands.push_back(Command(helper).arg("--exit-code").arg("0"));
+  commands.push_back(Command(helper).arg("--exit-code").arg("0"));
+
+  RunAllOptions options;
+  options.fail_fast = true;
+  auto results = run_all(commands.data(), commands.size(), Concurrency{1}, options);
+  ASSERT_TRUE(results.has_value());
+  ASSERT_TRUE(results.value()[0].has_value());
+  EXPECT_TRUE(results.value()[0]->status.success());
+  ASSERT_TRUE(results.value()[1].has_value());
+  EXPECT_EQ(results.value()[1]->status.code(), std::optional<int>(3));
+  for (std::size_t index = 2; index < commands.size(); ++index) {
+    ASSERT_FALSE(results.value()[index].has_value());
+    EXPECT_EQ(results.value()[index].error().code, make_error_code(errc::cancelled));
+  }
+}
+
+TEST(RunAllIntegrationTest, TimeoutTerminatesCommand) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  std::vector<Command> commands;
+  commands.push_back(Command(helper).arg("--sleep-ms").arg("5000"));
+
+  RunAllOptions options;
+  options.timeout = std::chrono::milliseconds(100);
+  options.kill_grace = std::chrono::milliseconds(100);
+  auto start = std::chrono::steady_clock::now();
+  auto results = run_all(commands.data(), commands.size(), Concurrency{1}, options);
+  ASSERT_TRUE(results.has_value());
+  EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(2));
+  ASSERT_TRUE(results.value()[0].has_value());
+  EXPECT_FALSE(results.value()[0]->status.success());
+}
+
+TEST(WaitSetIntegrationTest, WaitAnyReportsFirstExitedChild) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  auto slow = Command(helper).arg("--sleep-ms").arg("5000").spawn();
+  ASSERT_TRUE(slow.has_value()) << slow.error().context << " " << slow.error().code.message();
+  auto fast = Command(helper).arg("--sleep-ms").arg("20").arg("--exit-code").arg("4").spawn();
+  ASSERT_TRUE(fast.has_value()) << fast.error().context << " " << fast.error().code.message();
+
+  std::array<Child*, 3> children{&slow.value(), nullptr, &fast.value()};
+  auto start = std::chrono::steady_clock::now();
+  auto done = wait_any(children.data(), children.size(), std::chrono::milliseconds(5000));
+  ASSERT_TRUE(done.has_value()) << done.error().context << " " << done.error().code.message();
+  EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(2));
+  ASSERT_TRUE(done->has_value());
+  EXPECT_EQ(done.value()->index, 2U);
+  EXPECT_EQ(done.value()->result.status.code(), 4);
+
+  auto timed_out = wait_any(children.data(), 1, std::chrono::milliseconds(50));
+  ASSERT_TRUE(timed_out.has_value());
+  EXPECT_FALSE(timed_out->has_value());
+  ASSERT_TRUE(slow->kill().has_value());
+  ASSERT_TRUE(slow->wait().has_value());
+}
+
+TEST(WaitSetIntegrationTest, WaitAnyRejectsEmptySet) {
+  std::array<Child*, 2> children{nullptr, nullptr};
+  auto done = wait_any(children.data(), children.size());
+  ASSERT_FALSE(done.has_value());
+  EXPECT_EQ(done.error().code, std::make_error_code(std::errc::invalid_argument));
+}
+
+TEST(WaitSetIntegrationTest, WaitAllReturnsStatusesInInputOrder) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  std::vector<Child> children;
+  for (int code : {3, 0, 7, 1}) {
+    auto child = Command(helper)
+                     .arg("--sleep-ms")
+                     .arg(std::to_string(40 - code * 5))
+                     .arg("--exit-code")
+                     .arg(std::to_string(code))
+                     .spawn();
+    ASSERT_TRUE(child.has_value()) << child.error().context << " "
+                                   << child.error().code.message();
+    children.push_back(std::move(child.value()));
+  }
+  std::vector<Child*> set;
+  for (auto& child : children) {
+    set.push_back(&child);
+  }
+  auto results = wait_all(set.data(), set.size());
+  ASSERT_TRUE(results.has_value()) << results.error().context << " "
+                                   << results.error().code.message();
+  ASSERT_EQ(results->size(), 4U);
+  EXPECT_EQ(results.value()[0].status.code(), 3);
+  EXPECT_EQ(results.value()[1].status.code(), 0);
+  EXPECT_EQ(results.value()[2].status.code(), 7);
+  EXPECT_EQ(results.value()[3].status.code(), 1);
+  EXPECT_FALSE(results.value()[0].timed_out);
+}
+
+TEST(WaitSetIntegrationTest, WaitAllTimeoutTerminatesOnlyLateChildren) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  auto quick = Command(helper).arg("--exit-code").arg("2").spawn();
+  ASSERT_TRUE(quick.has_value()) << quick.error().context << " " << quick.error().code.message();
+  auto late = Command(helper).arg("--sleep-ms").arg("10000").spawn();
+  ASSERT_TRUE(late.has_value()) << late.error().context << " " << late.error().code.message();
+
+  std::array<Child*, 2> children{&quick.value(), &late.value()};
+  WaitOptions options;
+  options.timeout = std::chrono::milliseconds(100);
+  options.kill_grace = std::chrono::milliseconds(100);
+  auto start = std::chrono::steady_clock::now();
+  auto results = wait_all(children.data(), children.size(), options);
+  ASSERT_TRUE(results.has_value()) << results.error().context << " "
+                                   << results.error().code.message();
+  EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(2));
+  EXPECT_EQ(results.value()[0].status.code(), 2);
+  EXPECT_FALSE(results.value()[0].timed_out);
+  EXPECT_TRUE(results.value()[1].timed_out);
+  EXPECT_TRUE(results.value()[1].sent_terminate);
+  EXPECT_FALSE(results.value()[1].status.success());
+}
+
+TEST(WaitSetIntegrationTest, WaitAnyOverPipelines) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  Pipeline slow_pipeline = Command(helper).arg("--sleep-ms").arg("5000") |
+                           Command(helper).arg("--consume-stdin");
+  Pipeline fast_pipeline = Command(helper).arg("--stdout-bytes").arg("16") |
+                           Command(helper).arg("--sleep-ms").arg("30").arg("--consume-stdin");
+  auto slow = slow_pipeline.spawn();
+  ASSERT_TRUE(slow.has_value()) << slow.error().context << " " << slow.error().code.message();
+  auto fast = fast_pipeline.spawn();
+  ASSERT_TRUE(fast.has_value()) << fast.error().context << " " << fast.error().code.message();
+
+  std::array<PipelineChild*, 2> pipelines{&slow.value(), &fast.value()};
+  auto done = wait_any(pipelines.data(), pipelines.size(), std::chrono::milliseconds(5000));
+  ASSERT_TRUE(done.has_value()) << done.error().context << " " << done.error().code.message();
+  ASSERT_TRUE(done->has_value());
+  EXPECT_EQ(done.value()->index, 1U);
+  EXPECT_EQ(done.value()->status.stages.size(), 2U);
+  EXPECT_TRUE(done.value()->status.aggregate.success());
+
+  WaitOptions options;
+  options.timeout = std::chrono::milliseconds(50);
+  options.kill_grace = std::chrono::milliseconds(100);
+  std::array<PipelineChild*, 1> rest{&slow.value()};
+  auto results = wait_all(rest.data(), rest.size(), options);
+  ASSERT_TRUE(results.has_value()) << results.error().context << " "
+                                   << results.error().code.message();
+  EXPECT_TRUE(results.value()[0].timed_out);
+  EXPECT_TRUE(results.value()[0].sent_terminate);
+}
+
 }  // namespace procly
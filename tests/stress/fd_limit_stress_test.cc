@@ -0,0 +1,151 @@
+#include <fcntl.h>
+#include <gtest/gtest.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "procly/command.hpp"
+#include "procly/internal/lowering.hpp"
+#include "procly/internal/posix_spawn.hpp"
+#include "procly/platform.hpp"
+#include "tests/helpers/runfiles_support.hpp"
+
+namespace procly {
+namespace {
+
+std::string helper_path() {
+  const auto& argv = ::testing::internal::GetArgvs();
+  if (argv.empty()) {
+    ADD_FAILURE() << "argv0 missing";
+    return "";
+  }
+  auto path = procly::support::helper_path(argv[0].c_str());
+  if (path.empty()) {
+    ADD_FAILURE() << "helper path not found";
+  }
+  return path;
+}
+
+// Raise the soft RLIMIT_NOFILE to the hard limit (capped at 1 << 20) for the test's lifetime.
+class ScopedHighFdLimit {
+ public:
+  ScopedHighFdLimit() {
+    if (::getrlimit(RLIMIT_NOFILE, &previous_) != 0) {
+      return;
+    }
+    constexpr rlim_t kTargetLimit = rlim_t{1} << 20;
+    rlimit raised = previous_;
+    raised.rlim_cur = (previous_.rlim_max == RLIM_INFINITY || previous_.rlim_max > kTargetLimit)
+                          ? kTargetLimit
+                          : previous_.rlim_max;
+    restore_ = ::setrlimit(RLIMIT_NOFILE, &raised) == 0;
+  }
+  ~ScopedHighFdLimit() {
+    if (restore_) {
+      ::setrlimit(RLIMIT_NOFILE, &previous_);
+    }
+  }
+  ScopedHighFdLimit(const ScopedHighFdLimit&) = delete;
+  ScopedHighFdLimit& operator=(const ScopedHighFdLimit&) = delete;
+
+  [[nodiscard]] static rlim_t current() {
+    rlimit limit{};
+    ::getrlimit(RLIMIT_NOFILE, &limit);
+    return limit.rlim_cur;
+  }
+
+ private:
+  rlimit previous_{};
+  bool restore_ = false;
+};
+
+std::vector<int> read_fd_list(const std::filesystem::path& path) {
+  std::ifstream file(path);
+  std::vector<int> fds;
+  int fd = -1;
+  while (file >> fd) {
+    fds.push_back(fd);
+  }
+  return fds;
+}
+
+}  // namespace
+
+// Spawns must not scale with RLIMIT_NOFILE; the old fork-path per-fd close loop made roughly one
+// syscall per possible descriptor in the child before exec. The _force_fork target covers fork.
+TEST(FdLimitStressTest, SpawnLatencyIndependentOfFdLimit) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  ScopedHighFdLimit high_limit;
+  std::cout << "RLIMIT_NOFILE soft limit: " << ScopedHighFdLimit::current() << "\n";
+
+  Command cmd(helper);
+  cmd.current_dir(std::filesystem::temp_directory_path());
+  cmd.stdout(Stdio::null());
+  cmd.stderr(Stdio::null());
+
+  auto spec = internal::lower_command(cmd, internal::SpawnMode::spawn, nullptr);
+  ASSERT_TRUE(spec.has_value());
+#if defined(PROCLY_FORCE_FORK)
+  EXPECT_EQ(internal::select_spawn_strategy(spec.value()), internal::SpawnStrategy::fork_exec);
+#endif
+
+  constexpr int kRuns = 100;
+#if PROCLY_HAS_ADDRESS_SANITIZER || PROCLY_HAS_THREAD_SANITIZER
+  constexpr auto kPerSpawnBudget = std::chrono::milliseconds(100);
+#else
+  constexpr auto kPerSpawnBudget = std::chrono::milliseconds(20);
+#endif
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kRuns; ++i) {
+    auto status = cmd.status();
+    ASSERT_TRUE(status.has_value())
+        << status.error().context << " " << status.error().code.message();
+    ASSERT_TRUE(status->success());
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  auto per_spawn = std::chrono::duration_cast<std::chrono::microseconds>(elapsed / kRuns);
+  std::cout << "spawn+wait: " << per_spawn.count() << " us/spawn\n";
+  EXPECT_LT(per_spawn, kPerSpawnBudget);
+}
+
+TEST(FdLimitStressTest, HighNumberedFdIsNotInherited) {
+  std::string helper = helper_path();
+  ASSERT_FALSE(helper.empty());
+
+  ScopedHighFdLimit high_limit;
+  int high_fd = static_cast<int>(ScopedHighFdLimit::current()) - 1;
+  int source = ::open("/dev/null", O_RDONLY);
+  ASSERT_GE(source, 0);
+  // dup2 leaves FD_CLOEXEC clear, so only the child-side sanitizing keeps it out.
+  ASSERT_EQ(::dup2(source, high_fd), high_fd);
+  ::close(source);
+
+  std::filesystem::path fd_path =
+      std::filesystem::temp_directory_path() /
+      ("procly_high_fd_" + std::to_string(::getpid()) + ".txt");
+  Command cmd(helper);
+  cmd.current_dir(std::filesystem::temp_directory_path());
+  cmd.arg("--write-open-fds").arg(fd_path.string());
+  auto status = cmd.status();
+  ::close(high_fd);
+  ASSERT_TRUE(status.has_value())
+      << status.error().context << " " << status.error().code.message();
+
+  auto fds = read_fd_list(fd_path);
+  std::error_code remove_ec;
+  std::filesystem::remove(fd_path, remove_ec);
+  ASSERT_FALSE(fds.empty());
+  for (int fd : fds) {
+    EXPECT_NE(fd, high_fd);
+  }
+}
+
+}  // namespace procly
@@ -4,15 +4,18 @@
 #include <chrono>
 #include <csignal>
 #include <optional>
+#include <string_view>
 #include <thread>
 #include <vector>
 
+#include "procly/backend.hpp"
 #include "procly/child.hpp"
 #include "procly/command.hpp"
 #include "procly/internal/access.hpp"
 #include "procly/internal/backend.hpp"
 #include "procly/pipeline.hpp"
 #include "procly/platform.hpp"
+#include "procly/prepared_command.hpp"
 
 #if PROCLY_PLATFORM_POSIX
 #include <fcntl.h>
@@ -453,6 +456,44 @@ TEST(BackendInjectionTest, TryWaitReturnsStatusOrEmpty) {
   EXPECT_EQ(status_result->value().code().value_or(-1), 9);
 }
 
+TEST(BackendInjectionTest, ExitHandleReportsUnsupportedBackend) {
+  FakeBackend backend;
+  internal::ScopedBackendOverride override_backend(backend);
+
+  internal::Spawned spawned;
+  spawned.pid = 5051;
+  Child child = internal::ChildAccess::from_spawned(spawned);
+
+  auto handle = child.exit_handle();
+  ASSERT_FALSE(handle.has_value());
+  EXPECT_EQ(handle.error().code, std::make_error_code(std::errc::not_supported));
+}
+
+TEST(BackendInjectionTest, PipelineTryWaitReportsOnceAllStagesExit) {
+  FakeBackend backend;
+  internal::ScopedBackendOverride override_backend(backend);
+
+  auto child_result = (Command("echo") | Command("cat")).pipefail(true).spawn();
+  ASSERT_TRUE(child_result.has_value());
+
+  backend.try_wait_result = std::nullopt;
+  auto running = child_result->try_wait();
+  ASSERT_TRUE(running.has_value());
+  EXPECT_FALSE(running->has_value());
+  EXPECT_EQ(backend.try_wait_pids, (std::vector<int>{101, 102}));
+
+  backend.try_wait_result = ExitStatus::exited(3);
+  auto exited = child_result->try_wait();
+  ASSERT_TRUE(exited.has_value());
+  ASSERT_TRUE(exited->has_value());
+  EXPECT_EQ(exited->value().stages.size(), 2u);
+  EXPECT_EQ(exited->value().aggregate.code().value_or(-1), 3);
+
+  auto waited = child_result->wait();
+  ASSERT_TRUE(waited.has_value());
+  EXPECT_TRUE(backend.wait_calls.empty());
+}
+
 TEST(BackendInjectionTest, PipelineNewProcessGroupPropagates) {
   FakeBackend backend;
   internal::ScopedBackendOverride override_backend(backend);
@@ -473,6 +514,28 @@ TEST(BackendInjectionTest, PipelineNewProcessGroupPropagates) {
   EXPECT_EQ(second_spec.process_group.value(), 101);
 }
 
+TEST(BackendInjectionTest, PipelineStagesShareInheritedEnvironment) {
+  FakeBackend backend;
+  internal::ScopedBackendOverride override_backend(backend);
+
+  Command middle("cat");
+  middle.env("PROCLY_STAGE_ONLY", "1");
+  Pipeline pipeline = Command("echo") | middle | Command("wc");
+
+  auto child_result = pipeline.spawn();
+  ASSERT_TRUE(child_result.has_value());
+  ASSERT_EQ(backend.spawn_specs.size(), 3u);
+
+  const auto& first_env = backend.spawn_specs[0].envp;
+  const auto& middle_env = backend.spawn_specs[1].envp;
+  const auto& last_env = backend.spawn_specs[2].envp;
+  EXPECT_EQ(first_env.data(), last_env.data());
+  EXPECT_NE(first_env.data(), middle_env.data());
+  EXPECT_EQ(middle_env.find("PROCLY_STAGE_ONLY"), std::optional<std::string_view>("1"));
+  EXPECT_FALSE(first_env.find("PROCLY_STAGE_ONLY").has_value());
+  EXPECT_EQ(middle_env.size(), first_env.size() + 1);
+}
+
 TEST(BackendInjectionTest, PipelineSpawnStopsOnError) {
   FakeBackend backend;
   backend.fail_on_spawn_call = 2;
@@ -577,6 +640,98 @@ TEST(BackendInjectionTest, CommandOutputUsesInjectedBackend) {
   EXPECT_EQ(backend.wait_calls.size(), 1u);
 }
 
+TEST(BackendInjectionTest, CommandBackendTakesPrecedenceOverThreadDefault) {
+  FakeBackend thread_backend;
+  FakeBackend command_backend;
+  command_backend.wait_result = ExitStatus::exited(4);
+  ScopedBackend scope(thread_backend);
+
+  Command cmd("echo");
+  cmd.backend(command_backend);
+  auto status = cmd.status();
+  ASSERT_TRUE(status.has_value());
+  EXPECT_EQ(status->code(), std::optional<int>(4));
+  EXPECT_EQ(command_backend.spawn_calls, 1);
+  EXPECT_EQ(command_backend.wait_calls.size(), 1u);
+  EXPECT_EQ(thread_backend.spawn_calls, 0);
+}
+
+TEST(BackendInjectionTest, PreparedCommandKeepsCommandBackend) {
+  FakeBackend thread_backend;
+  FakeBackend command_backend;
+  ScopedBackend scope(thread_backend);
+
+  Command cmd("echo");
+  cmd.backend(command_backend);
+  auto prepared = PreparedCommand::prepare(cmd);
+  ASSERT_TRUE(prepared.has_value());
+  ASSERT_TRUE(prepared->status().has_value());
+  ASSERT_TRUE(prepared->output().has_value());
+  EXPECT_EQ(command_backend.spawn_calls, 2);
+  EXPECT_EQ(thread_backend.spawn_calls, 0);
+}
+
+TEST(BackendInjectionTest, PipelineBackendAppliesToEveryStage) {
+  FakeBackend thread_backend;
+  FakeBackend stage_backend;
+  FakeBackend pipeline_backend;
+  ScopedBackend scope(thread_backend);
+
+  Command first("echo");
+  first.backend(stage_backend);
+  Pipeline pipeline = std::move(first) | Command("cat") | Command("wc");
+  pipeline.backend(pipeline_backend);
+  auto status = pipeline.status();
+  ASSERT_TRUE(status.has_value());
+  EXPECT_EQ(pipeline_backend.spawn_calls, 3);
+  EXPECT_EQ(pipeline_backend.wait_calls.size(), 3u);
+  EXPECT_EQ(stage_backend.spawn_calls, 0);
+  EXPECT_EQ(thread_backend.spawn_calls, 0);
+}
+
+TEST(BackendInjectionTest, PipelineStagesUseTheirOwnBackends) {
+  FakeBackend thread_backend;
+  FakeBackend stage_backend;
+  ScopedBackend scope(thread_backend);
+
+  Command last("cat");
+  last.backend(stage_backend);
+  Pipeline pipeline = Command("echo") | std::move(last);
+  auto child = pipeline.spawn();
+  ASSERT_TRUE(child.has_value());
+  ASSERT_TRUE(child->wait().has_value());
+  EXPECT_EQ(thread_backend.spawn_calls, 1);
+  EXPECT_EQ(thread_backend.wait_calls.size(), 1u);
+  EXPECT_EQ(stage_backend.spawn_calls, 1);
+  EXPECT_EQ(stage_backend.wait_calls.size(), 1u);
+}
+
+TEST(BackendInjectionTest, ConcurrentCommandsUseTheirOwnBackends) {
+  constexpr int kThreads = 8;
+  constexpr int kSpawnsPerThread = 50;
+  std::vector<FakeBackend> backends(kThreads);
+  std::vector<std::thread> threads;
+  threads.reserve(kThreads);
+  for (int index = 0; index < kThreads; ++index) {
+    backends[index].wait_result = ExitStatus::exited(index);
+    threads.emplace_back([&backends, index] {
+      Command cmd("echo");
+      cmd.backend(backends[index]);
+      for (int spawn = 0; spawn < kSpawnsPerThread; ++spawn) {
+        auto status = cmd.status();
+        ASSERT_TRUE(status.has_value());
+        EXPECT_EQ(status->code(), std::optional<int>(index));
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (const auto& backend : backends) {
+    EXPECT_EQ(backend.spawn_calls, kSpawnsPerThread);
+  }
+}
+
 #if PROCLY_PLATFORM_POSIX
 TEST(BackendInjectionTest, CommandStatusClosesPipedStdioBeforeWait) {
   PipeLifecycleBackend backend;
@@ -0,0 +1,51 @@
+#include "procly/cancellation.hpp"
+
+#include <gtest/gtest.h>
+#include <poll.h>
+
+#include <thread>
+
+namespace procly {
+namespace {
+
+bool readable(int fd, int timeout_ms) {
+  pollfd pfd{.fd = fd, .events = POLLIN, .revents = 0};
+  return ::poll(&pfd, 1, timeout_ms) == 1;
+}
+
+}  // namespace
+
+TEST(CancellationTest, CopiesShareState) {
+  CancellationToken token;
+  CancellationToken copy = token;
+  EXPECT_FALSE(token.cancelled());
+  copy.cancel();
+  EXPECT_TRUE(token.cancelled());
+  EXPECT_TRUE(copy.cancelled());
+}
+
+TEST(CancellationTest, WaitHandleWakesOnCancel) {
+  CancellationToken token;
+  auto handle = token.wait_handle();
+  ASSERT_TRUE(handle.has_value());
+  EXPECT_FALSE(readable(handle.value(), 0));
+
+  std::thread canceller([token]() mutable { token.cancel(); });
+  EXPECT_TRUE(readable(handle.value(), 5000));
+  canceller.join();
+  // The handle stays readable, and later calls get the same one.
+  EXPECT_TRUE(readable(handle.value(), 0));
+  auto again = token.wait_handle();
+  ASSERT_TRUE(again.has_value());
+  EXPECT_EQ(again.value(), handle.value());
+}
+
+TEST(CancellationTest, WaitHandleCreatedAfterCancelIsReadable) {
+  CancellationToken token;
+  token.cancel();
+  auto handle = token.wait_handle();
+  ASSERT_TRUE(handle.has_value());
+  EXPECT_TRUE(readable(handle.value(), 0));
+}
+
+}  // namespace procly
@@ -0,0 +1,69 @@
+#include "procly/chunked_buffer.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace procly {
+
+namespace {
+
+std::string pattern(std::size_t size) {
+  std::string bytes(size, '\0');
+  for (std::size_t i = 0; i < size; ++i) {
+    bytes[i] = static_cast<char>('a' + i % 26);
+  }
+  return bytes;
+}
+
+}  // namespace
+
+TEST(ChunkedBufferTest, EmptyBufferHasNoChunks) {
+  ChunkedBuffer buffer;
+  EXPECT_TRUE(buffer.empty());
+  EXPECT_EQ(buffer.chunk_count(), 0U);
+  EXPECT_EQ(buffer.begin(), buffer.end());
+  EXPECT_EQ(buffer.flatten(), "");
+}
+
+TEST(ChunkedBufferTest, AppendFillsFixedSizeChunks) {
+  constexpr std::size_t kChunk = ChunkedBuffer::kChunkBytes;
+  std::string input = pattern(2 * kChunk + 100);
+  ChunkedBuffer buffer;
+  // Uneven pieces so appends straddle chunk boundaries.
+  for (std::size_t offset = 0; offset < input.size(); offset += 1000) {
+    buffer.append(std::string_view(input).substr(offset, 1000));
+  }
+
+  EXPECT_EQ(buffer.size(), input.size());
+  ASSERT_EQ(buffer.chunk_count(), 3U);
+  EXPECT_EQ(buffer.chunk(0).size(), kChunk);
+  EXPECT_EQ(buffer.chunk(1).size(), kChunk);
+  EXPECT_EQ(buffer.chunk(2).size(), 100U);
+  std::vector<std::string_view> chunks(buffer.begin(), buffer.end());
+  ASSERT_EQ(chunks.size(), 3U);
+  EXPECT_EQ(chunks[1], std::string_view(input).substr(kChunk, kChunk));
+  EXPECT_EQ(buffer.flatten(), input);
+}
+
+TEST(ChunkedBufferTest, MoveTransfersChunksAndClearReleasesThem) {
+  ChunkedBuffer buffer;
+  buffer.append("hello");
+  const char* first = buffer.chunk(0).data();
+
+  ChunkedBuffer moved(std::move(buffer));
+  EXPECT_TRUE(buffer.empty());  // NOLINT(bugprone-use-after-move)
+  EXPECT_EQ(moved.chunk(0).data(), first);
+  EXPECT_EQ(moved.flatten(), "hello");
+
+  moved.clear();
+  EXPECT_TRUE(moved.empty());
+  moved.append("again");
+  EXPECT_EQ(moved.flatten(), "again");
+}
+
+}  // namespace procly
@@ -0,0 +1,101 @@
+#include "procly/internal/close_fds.hpp"
+
+#include <fcntl.h>
+#include <gtest/gtest.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <array>
+#include <cerrno>
+
+namespace procly::internal {
+
+namespace {
+
+constexpr int kChildOk = 0;
+constexpr int kChildSetupFailed = 10;
+constexpr int kChildFdSurvived = 11;
+constexpr int kChildKeepClosed = 12;
+
+bool fd_survives_exec(int fd) {
+  errno = 0;
+  int flags = ::fcntl(fd, F_GETFD);
+  if (flags == -1) {
+    return errno != EBADF;
+  }
+  return (flags & FD_CLOEXEC) == 0;
+}
+
+int high_fd_target() {
+  rlimit limit{};
+  if (::getrlimit(RLIMIT_NOFILE, &limit) != 0 || limit.rlim_cur == RLIM_INFINITY) {
+    return 1000;
+  }
+  return static_cast<int>(limit.rlim_cur) - 1;
+}
+
+// Runs close_inherited_fds in a forked child so the test process keeps its own descriptors.
+int run_in_child(int keep_count) {
+  pid_t pid = ::fork();
+  if (pid == 0) {
+    std::array<int, 3> targets = {10, 100, high_fd_target()};
+    for (int target : targets) {
+      int fd = ::open("/dev/null", O_RDONLY);
+      if (fd == -1 || ::dup2(fd, target) == -1) {
+        _exit(kChildSetupFailed);
+      }
+      ::close(fd);
+    }
+    std::array<int, 2> keep_fds = {-1, -1};
+    for (int index = 0; index < keep_count; ++index) {
+      keep_fds[index] = ::open("/dev/null", O_RDONLY);
+      if (keep_fds[index] == -1) {
+        _exit(kChildSetupFailed);
+      }
+    }
+
+    close_inherited_fds(STDERR_FILENO + 1, keep_fds[0], keep_fds[1]);
+
+    for (int target : targets) {
+      if (fd_survives_exec(target)) {
+        _exit(kChildFdSurvived);
+      }
+    }
+    for (int keep_fd : keep_fds) {
+      if (keep_fd != -1 && !fd_survives_exec(keep_fd)) {
+        _exit(kChildKeepClosed);
+      }
+    }
+    if (!fd_survives_exec(STDERR_FILENO)) {
+      _exit(kChildKeepClosed);
+    }
+    _exit(kChildOk);
+  }
+  if (pid < 0) {
+    return -1;
+  }
+  int status = 0;
+  while (::waitpid(pid, &status, 0) == -1) {
+    if (errno != EINTR) {
+      return -1;
+    }
+  }
+  return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+}  // namespace
+
+TEST(CloseFdsTest, ClosesOrMarksEveryDescriptorAboveFirst) {
+  EXPECT_EQ(run_in_child(/*keep_count=*/0), kChildOk);
+}
+
+TEST(CloseFdsTest, LeavesKeepFdUntouched) {
+  EXPECT_EQ(run_in_child(/*keep_count=*/1), kChildOk);
+}
+
+TEST(CloseFdsTest, LeavesBothKeepFdsUntouched) {
+  EXPECT_EQ(run_in_child(/*keep_count=*/2), kChildOk);
+}
+
+}  // namespace procly::internal
@@ -0,0 +1,103 @@
+#include "procly/internal/command_storage.hpp"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <utility>
+
+namespace procly {
+namespace {
+
+TEST(CommandStorageTest, ArgsKeepOrderPastInlineCapacity) {
+  internal::CommandStorage storage;
+  for (int index = 0; index < 20; ++index) {
+    storage.push_arg("arg-" + std::to_string(index));
+  }
+  ASSERT_EQ(storage.arg_count(), 20U);
+  auto argv = storage.argv();
+  for (int index = 0; index < 20; ++index) {
+    EXPECT_EQ(storage.arg(static_cast<std::size_t>(index)), "arg-" + std::to_string(index));
+    EXPECT_EQ(argv[static_cast<std::size_t>(index)], "arg-" + std::to_string(index));
+  }
+}
+
+TEST(CommandStorageTest, EnvEntriesStaySortedByKey) {
+  internal::CommandStorage storage;
+  storage.set_env("B", "2");
+  storage.set_env("C", "3");
+  storage.set_env("A", "1");
+  storage.set_env("B", std::nullopt);
+
+  ASSERT_EQ(storage.env_count(), 3U);
+  EXPECT_EQ(storage.env_entry(0).key, "A");
+  EXPECT_EQ(storage.env_entry(0).value, "1");
+  EXPECT_EQ(storage.env_entry(1).key, "B");
+  EXPECT_FALSE(storage.env_entry(1).value.has_value());
+  EXPECT_EQ(storage.env_entry(2).key, "C");
+  EXPECT_FALSE(storage.find_env("D").has_value());
+  ASSERT_TRUE(storage.find_env("C").has_value());
+  EXPECT_EQ(storage.find_env("C")->value, "3");
+}
+
+TEST(CommandStorageTest, OverwrittenValuesSurviveCompaction) {
+  internal::CommandStorage storage;
+  storage.push_arg("program");
+  storage.set_env("KEY", "short");
+  for (int round = 0; round < 200; ++round) {
+    storage.set_env("KEY", std::string(static_cast<std::size_t>(round % 40 + 1), 'x'));
+    storage.set_env("OTHER" + std::to_string(round % 3), std::to_string(round));
+  }
+  EXPECT_EQ(storage.arg(0), "program");
+  ASSERT_TRUE(storage.find_env("KEY").has_value());
+  EXPECT_EQ(storage.find_env("KEY")->value, std::string(199 % 40 + 1, 'x'));
+  EXPECT_EQ(storage.find_env("OTHER0")->value, "198");
+  EXPECT_EQ(storage.find_env("OTHER2")->value, "197");
+}
+
+TEST(CommandStorageTest, NewKeySurvivesCompactionWhileAppendingItsValue) {
+  internal::CommandStorage storage;
+  storage.push_arg("a");
+  storage.set_env("K", std::string(200, 'v'));
+  // Shrinking in place leaves most of the arena dead, so the next growth compacts.
+  storage.set_env("K", "x");
+  storage.set_env("NEWKEY", std::string(60, 'n'));
+
+  ASSERT_EQ(storage.env_count(), 2U);
+  EXPECT_EQ(storage.env_entry(0).key, "K");
+  EXPECT_EQ(storage.env_entry(0).value, "x");
+  EXPECT_EQ(storage.env_entry(1).key, "NEWKEY");
+  EXPECT_EQ(storage.env_entry(1).value, std::string(60, 'n'));
+  EXPECT_EQ(storage.arg(0), "a");
+}
+
+TEST(CommandStorageTest, MovedStorageKeepsContents) {
+  internal::CommandStorage storage;
+  storage.push_arg("/usr/bin/program-with-a-long-name");
+  storage.push_arg("--flag");
+  storage.set_env("NAME", "value");
+
+  internal::CommandStorage moved = std::move(storage);
+  internal::CommandStorage copied = moved;
+  for (const auto* current : {&moved, &copied}) {
+    ASSERT_EQ(current->arg_count(), 2U);
+    EXPECT_EQ(current->arg(0), "/usr/bin/program-with-a-long-name");
+    EXPECT_EQ(current->arg(1), "--flag");
+    ASSERT_TRUE(current->find_env("NAME").has_value());
+    EXPECT_EQ(current->find_env("NAME")->value, "value");
+  }
+}
+
+TEST(CommandStorageTest, ClearedArgsAndEnvAreEmpty) {
+  internal::CommandStorage storage;
+  storage.push_arg("program");
+  storage.set_env("KEY", "value");
+  storage.clear_args();
+  storage.clear_env();
+  EXPECT_EQ(storage.arg_count(), 0U);
+  EXPECT_EQ(storage.env_count(), 0U);
+  storage.push_arg("again");
+  EXPECT_EQ(storage.arg(0), "again");
+}
+
+}  // namespace
+}  // namespace procly
@@ -0,0 +1,122 @@
+#include "procly/compressed_buffer.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+#include "procly/output_sink.hpp"
+
+namespace procly {
+
+namespace {
+
+constexpr Compression kCodecs[] = {Compression::zstd, Compression::lz4};
+
+const char* codec_name(Compression codec) {
+  return codec == Compression::zstd ? "zstd" : "lz4";
+}
+
+// Feeds input to a compress sink in chunk_size pieces, as the drain loop would.
+CompressedBuffer compress_in_chunks(Compression codec, std::string_view input,
+                                    std::size_t chunk_size) {
+  CompressedBuffer out;
+  auto sink = OutputSink::compress(codec, out);
+  EXPECT_TRUE(sink.has_value());
+  if (!sink) {
+    return out;
+  }
+  for (std::size_t offset = 0; offset < input.size(); offset += chunk_size) {
+    auto chunk = input.substr(offset, chunk_size);
+    sink->write(chunk.data(), chunk.size());
+  }
+  EXPECT_TRUE(sink->finish().has_value());
+  return out;
+}
+
+}  // namespace
+
+TEST(CompressedBufferTest, UnsupportedCodecIsRejected) {
+  for (Compression codec : kCodecs) {
+    if (compression_supported(codec)) {
+      continue;
+    }
+    CompressedBuffer out;
+    auto sink = OutputSink::compress(codec, out);
+    ASSERT_FALSE(sink.has_value()) << codec_name(codec);
+    EXPECT_EQ(sink.error().code, make_error_code(errc::invalid_argument));
+    EXPECT_EQ(sink.error().context, codec_name(codec));
+  }
+}
+
+TEST(CompressedBufferTest, RepetitiveStreamRoundTrips) {
+  std::string input;
+  for (int line = 0; input.size() < 4 * 1024 * 1024; ++line) {
+    input += "INFO worker " + std::to_string(line % 16) + " processed batch\n";
+  }
+  for (Compression codec : kCodecs) {
+    if (!compression_supported(codec)) {
+      continue;
+    }
+    CompressedBuffer out = compress_in_chunks(codec, input, 65536);
+    EXPECT_EQ(out.codec(), codec);
+    EXPECT_EQ(out.size(), input.size());
+    EXPECT_LT(out.compressed_size(), input.size() / 20) << codec_name(codec);
+    auto restored = out.decompress();
+    ASSERT_TRUE(restored.has_value()) << restored.error().context;
+    EXPECT_EQ(restored.value(), input) << codec_name(codec);
+  }
+}
+
+TEST(CompressedBufferTest, OddChunkSizesRoundTrip) {
+  std::string input;
+  for (int i = 0; i < 200000; ++i) {
+    input.push_back(static_cast<char>((i * 7919) % 251));
+  }
+  for (Compression codec : kCodecs) {
+    if (!compression_supported(codec)) {
+      continue;
+    }
+    CompressedBuffer out = compress_in_chunks(codec, input, 1021);
+    auto restored = out.decompress();
+    ASSERT_TRUE(restored.has_value()) << restored.error().context;
+    EXPECT_EQ(restored.value(), input) << codec_name(codec);
+  }
+}
+
+TEST(CompressedBufferTest, EmptyStreamIsAValidFrame) {
+  for (Compression codec : kCodecs) {
+    if (!compression_supported(codec)) {
+      continue;
+    }
+    CompressedBuffer out = compress_in_chunks(codec, "", 1);
+    EXPECT_TRUE(out.empty());
+    EXPECT_FALSE(out.frame().empty()) << codec_name(codec);
+    auto restored = out.decompress();
+    ASSERT_TRUE(restored.has_value()) << restored.error().context;
+    EXPECT_TRUE(restored->empty());
+  }
+}
+
+TEST(CompressedBufferTest, TeeCompressesAlongsideCapture) {
+  std::string input(100000, 'x');
+  for (Compression codec : kCodecs) {
+    if (!compression_supported(codec)) {
+      continue;
+    }
+    std::string raw;
+    CompressedBuffer compressed;
+    auto compress = OutputSink::compress(codec, compressed);
+    ASSERT_TRUE(compress.has_value());
+    auto sink = OutputSink::tee({OutputSink::capture(raw), std::move(compress.value())});
+    sink.write(input.data(), input.size());
+    EXPECT_TRUE(sink.finish().has_value());
+    EXPECT_EQ(raw, input);
+    auto restored = compressed.decompress();
+    ASSERT_TRUE(restored.has_value()) << restored.error().context;
+    EXPECT_EQ(restored.value(), input);
+  }
+}
+
+}  // namespace procly
@@ -8,7 +8,9 @@
 #include <condition_variable>
 #include <cstdlib>
 #include <mutex>
+#include <system_error>
 #include <thread>
+#include <vector>
 
 #include "procly/command.hpp"
 #include "procly/internal/backend.hpp"
@@ -88,8 +90,98 @@ class BlockingBackend final : public internal::Backend {
   bool released_ = false;
 };
 
+// Holds every spawn() until kParties callers are inside at once, proving they overlap.
+class RendezvousBackend final : public internal::Backend {
+ public:
+  static constexpr int kParties = 4;
+
+  Result<internal::Spawned> spawn(const internal::SpawnSpec& spec) override {
+    std::unique_lock<std::mutex> lock(mutex_);
+    envp_sizes_.push_back(spec.envp.size());
+    ++arrived_;
+    arrived_cv_.notify_all();
+    if (!arrived_cv_.wait_for(lock, std::chrono::seconds(5),
+                              [&] { return arrived_ >= kParties; })) {
+      return Error{std::make_error_code(std::errc::timed_out), "rendezvous"};
+    }
+    internal::Spawned spawned;
+    spawned.pid = next_pid_++;
+    return spawned;
+  }
+
+  Result<WaitResult> wait(internal::Spawned& spawned,
+                          std::optional<std::chrono::milliseconds> timeout,
+                          std::chrono::milliseconds kill_grace) override {
+    (void)timeout;
+    (void)kill_grace;
+    internal::cache_terminal_result(spawned, WaitResult{.status = ExitStatus::exited(0)});
+    return *spawned.terminal_result;
+  }
+
+  Result<std::optional<ExitStatus>> try_wait(internal::Spawned& spawned) override {
+    (void)spawned;
+    return std::optional<ExitStatus>(ExitStatus::exited(0));
+  }
+
+  Result<void> terminate(internal::Spawned& spawned) override {
+    (void)spawned;
+    return {};
+  }
+
+  Result<void> kill(internal::Spawned& spawned) override {
+    (void)spawned;
+    return {};
+  }
+
+  Result<void> signal(internal::Spawned& spawned, int signo) override {
+    (void)spawned;
+    (void)signo;
+    return {};
+  }
+
+  std::vector<std::size_t> envp_sizes() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return envp_sizes_;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable arrived_cv_;
+  int arrived_ = 0;
+  int next_pid_ = 100;
+  std::vector<std::size_t> envp_sizes_;
+};
+
 }  // namespace
 
+TEST(ConcurrentUseContractTest, SharedConstCommandAllowsConcurrentLaunch) {
+  RendezvousBackend backend;
+  Command cmd("/bin/true");
+  cmd.backend(backend).env_clear().env("A", "1").env("B", "2");
+  const Command& shared = cmd;
+
+  std::vector<std::thread> threads;
+  std::array<bool, RendezvousBackend::kParties> ok{};
+  for (int i = 0; i < RendezvousBackend::kParties; ++i) {
+    threads.emplace_back([&, i] {
+      auto status = shared.status();
+      ok[i] = status.has_value() && status->success();
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  for (bool value : ok) {
+    EXPECT_TRUE(value);
+  }
+  auto sizes = backend.envp_sizes();
+  ASSERT_EQ(sizes.size(), static_cast<std::size_t>(RendezvousBackend::kParties));
+  for (auto size : sizes) {
+    EXPECT_EQ(size, 2U);
+  }
+}
+
 #ifndef NDEBUG
 TEST(ConcurrentUseContractTest, SharedCommandConcurrentUseDies) {
   EXPECT_DEATH(([] {
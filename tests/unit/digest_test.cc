@@ -0,0 +1,77 @@
+#include "procly/digest.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+#include "procly/output_sink.hpp"
+
+namespace procly {
+
+namespace {
+
+std::string pattern(std::size_t size) {
+  std::string bytes(size, '\0');
+  for (std::size_t i = 0; i < size; ++i) {
+    bytes[i] = static_cast<char>('a' + i % 26);
+  }
+  return bytes;
+}
+
+std::string digest_of(DigestAlgorithm algorithm, std::string_view data, std::size_t step) {
+  Digest digest(algorithm);
+  for (std::size_t offset = 0; offset < data.size(); offset += step) {
+    digest.update(data.substr(offset, step));
+  }
+  return digest.hex();
+}
+
+}  // namespace
+
+TEST(DigestTest, MatchesKnownVectors) {
+  EXPECT_EQ(digest_of(DigestAlgorithm::crc32c, "", 1), "00000000");
+  EXPECT_EQ(digest_of(DigestAlgorithm::crc32c, "123456789", 9), "e3069283");
+  EXPECT_EQ(digest_of(DigestAlgorithm::xxh64, "", 1), "ef46db3751d8e999");
+  EXPECT_EQ(digest_of(DigestAlgorithm::xxh64, "abc", 3), "44bc2cf5ad770999");
+  EXPECT_EQ(digest_of(DigestAlgorithm::xxh64, "The quick brown fox jumps over the lazy dog", 43),
+            "0b242d361fda71bc");
+  EXPECT_EQ(digest_of(DigestAlgorithm::sha256, "", 1),
+            "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+  EXPECT_EQ(digest_of(DigestAlgorithm::sha256, "abc", 3),
+            "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+}
+
+TEST(DigestTest, ChunkingDoesNotChangeTheDigest) {
+  std::string data = pattern(1000);
+  for (std::size_t step : {std::size_t{1}, std::size_t{7}, std::size_t{64}, std::size_t{1000}}) {
+    EXPECT_EQ(digest_of(DigestAlgorithm::crc32c, data, step), "68c9c0ef");
+    EXPECT_EQ(digest_of(DigestAlgorithm::xxh64, data, step), "94b86db9a16d86a9");
+    EXPECT_EQ(digest_of(DigestAlgorithm::sha256, data, step),
+              "915e53a44c18b19bb06ba5b3f5fcaf1dc4651e8404c63425cfc6174e74659d87");
+  }
+}
+
+TEST(DigestTest, HexLeavesTheDigestOpen) {
+  Digest digest(DigestAlgorithm::sha256);
+  digest.update("ab");
+  EXPECT_EQ(digest.hex(), digest.hex());
+  digest.update("c");
+  EXPECT_EQ(digest.hex(), "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+}
+
+TEST(DigestTest, DigestSinkHashesTeedStream) {
+  std::string captured;
+  std::string hex;
+  auto sink = OutputSink::tee(
+      {OutputSink::capture(captured), OutputSink::digest(DigestAlgorithm::crc32c, hex)});
+  sink.write("12345", 5);
+  sink.write("6789", 4);
+  EXPECT_TRUE(hex.empty());
+  sink.finish();
+  EXPECT_EQ(captured, "123456789");
+  EXPECT_EQ(hex, "e3069283");
+}
+
+}  // namespace procly
@@ -0,0 +1,142 @@
+#include "procly/exec_path_cache.hpp"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <string>
+
+#include "procly/internal/env_block.hpp"
+#include "procly/internal/exec_path.hpp"
+
+namespace procly {
+namespace {
+
+class ExecPathCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    dir_ = std::filesystem::temp_directory_path() /
+           (std::string("procly_exec_cache_") +
+            ::testing::UnitTest::GetInstance()->current_test_info()->name());
+    std::filesystem::create_directories(dir_);
+    configure_exec_path_cache({});
+    clear_exec_path_cache();
+  }
+
+  void TearDown() override {
+    configure_exec_path_cache({});
+    clear_exec_path_cache();
+    std::error_code ec;
+    std::filesystem::remove_all(dir_, ec);
+  }
+
+  std::filesystem::path make_tool(const std::filesystem::path& dir, const std::string& name) {
+    std::filesystem::create_directories(dir);
+    auto path = dir / name;
+    std::ofstream(path) << "#!/bin/sh\n";
+    std::filesystem::permissions(path, std::filesystem::perms::owner_all);
+    return path;
+  }
+
+  internal::EnvBlock env_with_path(const std::string& path_value) {
+    internal::EnvDeltaEntry delta{.key = "PATH", .value = path_value};
+    return internal::apply_env_delta({}, &delta, 1);
+  }
+
+  std::filesystem::path dir_;
+};
+
+}  // namespace
+
+TEST_F(ExecPathCacheTest, AutomaticLookupIsDisabledByDefault) {
+  auto tool = make_tool(dir_, "tool");
+  auto envp = env_with_path(dir_.string());
+  EXPECT_FALSE(exec_path_cache_options().enabled);
+  EXPECT_EQ(internal::cached_exec_path("tool", envp, std::nullopt, PathLookup::automatic),
+            std::nullopt);
+  EXPECT_EQ(internal::cached_exec_path("tool", envp, std::nullopt, PathLookup::cached),
+            std::optional<std::string>(tool.string()));
+}
+
+TEST_F(ExecPathCacheTest, CachedEntrySurvivesUntilInvalidated) {
+  configure_exec_path_cache({.enabled = true});
+  auto tool = make_tool(dir_, "tool");
+  auto envp = env_with_path(dir_.string());
+  ASSERT_EQ(internal::cached_exec_path("tool", envp, std::nullopt, PathLookup::automatic),
+            std::optional<std::string>(tool.string()));
+
+  std::filesystem::remove(tool);
+  EXPECT_EQ(internal::cached_exec_path("tool", envp, std::nullopt, PathLookup::automatic),
+            std::optional<std::string>(tool.string()));
+  EXPECT_EQ(internal::resolve_exec_path("tool", envp, std::nullopt), "tool");
+
+  invalidate_exec_path("tool");
+  EXPECT_EQ(internal::cached_exec_path("tool", envp, std::nullopt, PathLookup::automatic),
+            std::nullopt);
+}
+
+TEST_F(ExecPathCacheTest, UncachedLookupBypassesCache) {
+  configure_exec_path_cache({.enabled = true});
+  auto tool = make_tool(dir_, "tool");
+  auto envp = env_with_path(dir_.string());
+  EXPECT_EQ(internal::cached_exec_path("tool", envp, std::nullopt, PathLookup::uncached),
+            std::nullopt);
+}
+
+TEST_F(ExecPathCacheTest, KeyIncludesPathValue) {
+  configure_exec_path_cache({.enabled = true});
+  auto first = make_tool(dir_ / "a", "tool");
+  auto second = make_tool(dir_ / "b", "tool");
+  EXPECT_EQ(internal::cached_exec_path("tool", env_with_path((dir_ / "a").string()), std::nullopt,
+                                       PathLookup::automatic),
+            std::optional<std::string>(first.string()));
+  EXPECT_EQ(internal::cached_exec_path("tool", env_with_path((dir_ / "b").string()), std::nullopt,
+                                       PathLookup::automatic),
+            std::optional<std::string>(second.string()));
+}
+
+TEST_F(ExecPathCacheTest, RelativePathEntriesAreKeyedOnCwd) {
+  configure_exec_path_cache({.enabled = true});
+  auto first = make_tool(dir_ / "a" / "bin", "tool");
+  auto second = make_tool(dir_ / "b" / "bin", "tool");
+  auto envp = env_with_path("bin");
+  EXPECT_EQ(internal::cached_exec_path("tool", envp, dir_ / "a", PathLookup::automatic),
+            std::optional<std::string>(first.string()));
+  EXPECT_EQ(internal::cached_exec_path("tool", envp, dir_ / "b", PathLookup::automatic),
+            std::optional<std::string>(second.string()));
+}
+
+TEST_F(ExecPathCacheTest, RevalidationDropsChangedEntries) {
+  configure_exec_path_cache({.enabled = true, .revalidate_mtime = true});
+  auto first = make_tool(dir_ / "a", "tool");
+  auto second = make_tool(dir_ / "b", "tool");
+  auto envp = env_with_path((dir_ / "a").string() + ":" + (dir_ / "b").string());
+  ASSERT_EQ(internal::cached_exec_path("tool", envp, std::nullopt, PathLookup::automatic),
+            std::optional<std::string>(first.string()));
+
+  std::filesystem::remove(first);
+  EXPECT_EQ(internal::cached_exec_path("tool", envp, std::nullopt, PathLookup::automatic),
+            std::optional<std::string>(second.string()));
+
+  std::filesystem::last_write_time(
+      second, std::filesystem::last_write_time(second) - std::chrono::hours(1));
+  make_tool(dir_ / "a", "tool");
+  EXPECT_EQ(internal::cached_exec_path("tool", envp, std::nullopt, PathLookup::automatic),
+            std::optional<std::string>(first.string()));
+}
+
+TEST_F(ExecPathCacheTest, MissesAndPathsWithSlashAreNotCached) {
+  configure_exec_path_cache({.enabled = true});
+  auto envp = env_with_path(dir_.string());
+  EXPECT_EQ(internal::cached_exec_path("tool", envp, std::nullopt, PathLookup::automatic),
+            std::nullopt);
+  auto tool = make_tool(dir_, "tool");
+  EXPECT_EQ(internal::cached_exec_path("tool", envp, std::nullopt, PathLookup::automatic),
+            std::optional<std::string>(tool.string()));
+  EXPECT_EQ(internal::cached_exec_path(tool.string(), envp, std::nullopt, PathLookup::automatic),
+            std::nullopt);
+}
+
+}  // namespace procly
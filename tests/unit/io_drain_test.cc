@@ -3,6 +3,8 @@
 #include <gtest/gtest.h>
 
 #include <atomic>
+#include <chrono>
+#include <functional>
 #include <string>
 #include <thread>
 
@@ -106,4 +108,172 @@ TEST(IoDrainTest, HandlesLargePayloads) {
   EXPECT_TRUE(err_ok);
 }
 
+namespace {
+
+Result<internal::DrainResult> drain_payload(const std::string& payload, CaptureLimit limit,
+                                            const std::function<void()>& on_kill = {}) {
+  auto out_pipe = internal::create_pipe();
+  if (!out_pipe) {
+    return out_pipe.error();
+  }
+  PipeReader out_reader(out_pipe->first.release());
+  PipeWriter out_writer(out_pipe->second.release());
+  std::thread out_thread([&] {
+    // Odd-sized writes so the ring buffer wraps mid-chunk.
+    constexpr std::size_t kStep = 3001;
+    for (std::size_t offset = 0; offset < payload.size(); offset += kStep) {
+      std::string_view chunk = std::string_view(payload).substr(offset, kStep);
+      if (!out_writer.write_all(chunk)) {
+        break;
+      }
+    }
+    out_writer.close();
+  });
+  CaptureOptions limits;
+  limits.stdout_limit = limit;
+  auto drained = internal::drain_pipes(&out_reader, nullptr, limits, on_kill);
+  out_thread.join();
+  return drained;
+}
+
+std::string counting_payload(std::size_t size) {
+  std::string payload(size, '\0');
+  for (std::size_t i = 0; i < size; ++i) {
+    payload[i] = static_cast<char>('a' + (i * 7) % 26);
+  }
+  return payload;
+}
+
+}  // namespace
+
+TEST(IoDrainTest, CaptureLimitKeepsHead) {
+  std::string payload = counting_payload(100000);
+  auto drained = drain_payload(payload, CaptureLimit{.max_bytes = 1000});
+  ASSERT_TRUE(drained.has_value());
+  EXPECT_EQ(drained->stdout_data, payload.substr(0, 1000));
+  EXPECT_EQ(drained->stdout_dropped, payload.size() - 1000);
+}
+
+TEST(IoDrainTest, CaptureLimitKeepsTail) {
+  std::string payload = counting_payload(100000);
+  for (std::size_t max : {std::size_t{0}, std::size_t{1}, std::size_t{1000}, std::size_t{5000},
+                          payload.size(), payload.size() + 1}) {
+    auto drained =
+        drain_payload(payload, CaptureLimit{.max_bytes = max, .policy = OverflowPolicy::keep_tail});
+    ASSERT_TRUE(drained.has_value());
+    std::size_t kept = std::min(max, payload.size());
+    EXPECT_EQ(drained->stdout_data, payload.substr(payload.size() - kept)) << "max " << max;
+    EXPECT_EQ(drained->stdout_dropped, payload.size() - kept) << "max " << max;
+  }
+}
+
+TEST(IoDrainTest, CaptureLimitKillRunsOnce) {
+  std::string payload = counting_payload(100000);
+  int kills = 0;
+  auto drained = drain_payload(payload, CaptureLimit{.max_bytes = 10, .policy = OverflowPolicy::kill},
+                               [&] { ++kills; });
+  ASSERT_TRUE(drained.has_value());
+  EXPECT_EQ(kills, 1);
+  EXPECT_EQ(drained->stdout_data, payload.substr(0, 10));
+}
+
+TEST(IoDrainTest, CaptureWithinLimitDropsNothing) {
+  std::string payload = counting_payload(500);
+  auto drained =
+      drain_payload(payload, CaptureLimit{.max_bytes = 500, .policy = OverflowPolicy::kill},
+                    [] { FAIL() << "unexpected kill"; });
+  ASSERT_TRUE(drained.has_value());
+  EXPECT_EQ(drained->stdout_data, payload);
+  EXPECT_EQ(drained->stdout_dropped, 0U);
+}
+
+TEST(IoDrainTest, ReadIntoGrowsGeometrically) {
+  auto pipe = internal::create_pipe();
+  ASSERT_TRUE(pipe.has_value());
+  PipeReader reader(pipe->first.release());
+  PipeWriter writer(pipe->second.release());
+
+  std::string payload = counting_payload(3 * 1024 * 1024);
+  std::thread writer_thread([&] {
+    (void)writer.write_all(payload);
+    writer.close();
+  });
+
+  std::string out;
+  std::size_t reallocations = 0;
+  std::size_t capacity = out.capacity();
+  while (true) {
+    ssize_t count = internal::read_into(reader.native_handle(), out);
+    ASSERT_GE(count, 0);
+    if (count == 0) {
+      break;
+    }
+    if (out.capacity() != capacity) {
+      ++reallocations;
+      capacity = out.capacity();
+    }
+  }
+  writer_thread.join();
+  EXPECT_EQ(out, payload);
+  // 64 KiB doubling to 4 MiB.
+  EXPECT_LE(reallocations, 8U);
+}
+
+TEST(IoDrainTest, SizeHintIsReservedUpFront) {
+  auto out_pipe = internal::create_pipe();
+  ASSERT_TRUE(out_pipe.has_value());
+  PipeReader out_reader(out_pipe->first.release());
+  PipeWriter out_writer(out_pipe->second.release());
+
+  std::string payload = counting_payload(200000);
+  std::thread out_thread([&] {
+    (void)out_writer.write_all(payload);
+    out_writer.close();
+  });
+
+  CaptureOptions options;
+  options.stdout_size_hint = 256 * 1024;
+  auto drained = internal::drain_pipes(&out_reader, nullptr, options, {});
+  out_thread.join();
+  ASSERT_TRUE(drained.has_value());
+  EXPECT_EQ(drained->stdout_data, payload);
+  EXPECT_EQ(drained->stdout_data.capacity(), options.stdout_size_hint);
+}
+
+TEST(IoDrainTest, DeadlineEscalatesWhileDraining) {
+  auto out_pipe = internal::create_pipe();
+  ASSERT_TRUE(out_pipe.has_value());
+  PipeReader out_reader(out_pipe->first.release());
+  PipeWriter out_writer(out_pipe->second.release());
+
+  // Terminate is answered with more output; kill closes the stream.
+  internal::DrainDeadline deadline;
+  deadline.at = std::chrono::steady_clock::now() + std::chrono::milliseconds(10);
+  deadline.kill_grace = std::chrono::milliseconds(10);
+  deadline.terminate = [&] { (void)out_writer.write_all("term"); };
+  deadline.kill = [&] { out_writer.close(); };
+  auto drained = internal::drain_pipes(internal::StdinFeed{}, &out_reader, nullptr,
+                                       CaptureOptions{}, {}, {}, &deadline);
+  ASSERT_TRUE(drained.has_value());
+  EXPECT_EQ(drained->stdout_data, "term");
+  EXPECT_TRUE(deadline.sent_terminate);
+  EXPECT_TRUE(deadline.sent_kill);
+}
+
+TEST(IoDrainTest, DeadlineAbandonsStreamsHeldOpenPastKill) {
+  auto out_pipe = internal::create_pipe();
+  ASSERT_TRUE(out_pipe.has_value());
+  PipeReader out_reader(out_pipe->first.release());
+  PipeWriter out_writer(out_pipe->second.release());
+
+  internal::DrainDeadline deadline;
+  deadline.at = std::chrono::steady_clock::now();
+  deadline.kill_grace = std::chrono::milliseconds(5);
+  auto drained = internal::drain_pipes(internal::StdinFeed{}, &out_reader, nullptr,
+                                       CaptureOptions{}, {}, {}, &deadline);
+  ASSERT_TRUE(drained.has_value());
+  EXPECT_TRUE(drained->stdout_data.empty());
+  EXPECT_TRUE(deadline.sent_kill);
+}
+
 }  // namespace procly
@@ -9,7 +9,7 @@ namespace procly {
 
 namespace {
 
-bool env_contains(const std::vector<std::string>& envp, const std::string& key,
+bool env_contains(const internal::EnvBlock& envp, const std::string& key,
                   const std::string& value) {
   std::string match = key + "=" + value;
   for (const auto& entry : envp) {
@@ -24,8 +24,7 @@ bool env_contains(const std::vector<std::string>& envp, const std::string& key,
 
 TEST(LoweringTest, EmptyArgvIsError) {
   Command cmd("");
-  auto& argv = const_cast<std::vector<std::string>&>(internal::CommandAccess::argv(cmd));
-  argv.clear();
+  const_cast<internal::CommandStorage&>(internal::CommandAccess::storage(cmd)).clear_args();
   auto result = internal::lower_command(cmd, internal::SpawnMode::spawn, nullptr);
   ASSERT_FALSE(result.has_value());
   EXPECT_EQ(result.error().code, make_error_code(errc::empty_argv));
@@ -39,15 +38,25 @@ TEST(LoweringTest, OutputModeDefaultsToPiped) {
   EXPECT_EQ(result->stderr_spec.kind, internal::StdioSpec::Kind::piped);
 }
 
+TEST(LoweringTest, PipedCapacityIsCarried) {
+  Command cmd("echo");
+  cmd.stdout(Stdio::piped(1 << 20));
+  auto result = internal::lower_command(cmd, internal::SpawnMode::spawn, nullptr);
+  ASSERT_TRUE(result.has_value());
+  EXPECT_EQ(result->stdout_spec.kind, internal::StdioSpec::Kind::piped);
+  EXPECT_EQ(result->stdout_spec.pipe_capacity, 1U << 20);
+  EXPECT_EQ(result->stderr_spec.pipe_capacity, 0U);
+}
+
 TEST(LoweringTest, ArgsPointerSizeAppends) {
   Command cmd("echo");
   std::array<std::string, 2> extra{{"one", "two"}};
   cmd.args(extra.data(), extra.size());
 
-  const auto& argv = internal::CommandAccess::argv(cmd);
-  ASSERT_EQ(argv.size(), 3u);
-  EXPECT_EQ(argv[1], "one");
-  EXPECT_EQ(argv[2], "two");
+  const auto& storage = internal::CommandAccess::storage(cmd);
+  ASSERT_EQ(storage.arg_count(), 3u);
+  EXPECT_EQ(storage.arg(1), "one");
+  EXPECT_EQ(storage.arg(2), "two");
 }
 
 TEST(LoweringTest, MergeStderrDuplicatesStdout) {
@@ -135,6 +144,73 @@ TEST(LoweringTest, EnvironmentRemoveKey) {
   EXPECT_FALSE(env_contains(result->envp, "PROCLY_TEST_ENV_REMOVE", "one"));
 }
 
+TEST(LoweringTest, EnvironmentIsSortedAndDeltaMerged) {
+  Command cmd("echo");
+  cmd.env_clear();
+  cmd.env("B", "2");
+  cmd.env("A", "1");
+  cmd.env("C", "3");
+  cmd.env_remove("B");
+  auto result = internal::lower_command(cmd, internal::SpawnMode::spawn, nullptr);
+  ASSERT_TRUE(result.has_value());
+  ASSERT_EQ(result->envp.size(), 2U);
+  EXPECT_STREQ(result->envp.data()[0], "A=1");
+  EXPECT_STREQ(result->envp.data()[1], "C=3");
+  EXPECT_EQ(result->envp.data()[2], nullptr);
+}
+
+TEST(LoweringTest, EnvironmentSnapshotIsIndependentOfLiveEnviron) {
+  ::setenv("PROCLY_TEST_ENV_SNAPSHOT", "before", 1);
+  Environment snapshot = Environment::capture();
+  ::setenv("PROCLY_TEST_ENV_SNAPSHOT", "after", 1);
+  EXPECT_EQ(snapshot.get("PROCLY_TEST_ENV_SNAPSHOT"), std::optional<std::string_view>("before"));
+
+  Command cmd("echo");
+  cmd.environment(snapshot);
+  cmd.env("PROCLY_TEST_ENV_EXTRA", "x");
+  auto result = internal::lower_command(cmd, internal::SpawnMode::spawn, nullptr);
+  ASSERT_TRUE(result.has_value());
+  EXPECT_TRUE(env_contains(result->envp, "PROCLY_TEST_ENV_SNAPSHOT", "before"));
+  EXPECT_TRUE(env_contains(result->envp, "PROCLY_TEST_ENV_EXTRA", "x"));
+  ::unsetenv("PROCLY_TEST_ENV_SNAPSHOT");
+}
+
+TEST(LoweringTest, EnvironmentBlockIsCachedUntilModified) {
+  Command cmd("echo");
+  cmd.environment(Environment::capture());
+  cmd.env("PROCLY_TEST_ENV_CACHE", "one");
+  auto first = internal::lower_command(cmd, internal::SpawnMode::spawn, nullptr);
+  auto second = internal::lower_command(cmd, internal::SpawnMode::spawn, nullptr);
+  ASSERT_TRUE(first.has_value());
+  ASSERT_TRUE(second.has_value());
+  EXPECT_EQ(first->envp.data(), second->envp.data());
+
+  cmd.env("PROCLY_TEST_ENV_CACHE", "one");
+  auto unchanged = internal::lower_command(cmd, internal::SpawnMode::spawn, nullptr);
+  ASSERT_TRUE(unchanged.has_value());
+  EXPECT_EQ(first->envp.data(), unchanged->envp.data());
+
+  cmd.env("PROCLY_TEST_ENV_CACHE", "two");
+  auto changed = internal::lower_command(cmd, internal::SpawnMode::spawn, nullptr);
+  ASSERT_TRUE(changed.has_value());
+  EXPECT_NE(first->envp.data(), changed->envp.data());
+  EXPECT_TRUE(env_contains(changed->envp, "PROCLY_TEST_ENV_CACHE", "two"));
+  EXPECT_TRUE(env_contains(first->envp, "PROCLY_TEST_ENV_CACHE", "one"));
+}
+
+TEST(LoweringTest, InheritedLiveEnvironmentIsReadPerSpawn) {
+  Command cmd("echo");
+  ::setenv("PROCLY_TEST_ENV_LIVE", "one", 1);
+  auto first = internal::lower_command(cmd, internal::SpawnMode::spawn, nullptr);
+  ::setenv("PROCLY_TEST_ENV_LIVE", "two", 1);
+  auto second = internal::lower_command(cmd, internal::SpawnMode::spawn, nullptr);
+  ASSERT_TRUE(first.has_value());
+  ASSERT_TRUE(second.has_value());
+  EXPECT_TRUE(env_contains(first->envp, "PROCLY_TEST_ENV_LIVE", "one"));
+  EXPECT_TRUE(env_contains(second->envp, "PROCLY_TEST_ENV_LIVE", "two"));
+  ::unsetenv("PROCLY_TEST_ENV_LIVE");
+}
+
 TEST(LoweringTest, PipelineEmptyIsError) {
   Pipeline pipeline;
   auto result = internal::lower_pipeline(pipeline, internal::SpawnMode::spawn);
@@ -0,0 +1,161 @@
+#include "procly/output_sink.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if PROCLY_PLATFORM_POSIX
+#include <unistd.h>
+#endif
+
+namespace procly {
+
+namespace {
+
+std::vector<std::string> split_in_chunks(std::string_view input, std::size_t chunk_size,
+                                         std::string delimiter = "\n") {
+  std::vector<std::string> lines;
+  auto sink = OutputSink::lines([&](std::string_view line) { lines.emplace_back(line); },
+                                std::move(delimiter));
+  for (std::size_t offset = 0; offset < input.size(); offset += chunk_size) {
+    auto chunk = input.substr(offset, chunk_size);
+    sink.write(chunk.data(), chunk.size());
+  }
+  sink.finish();
+  return lines;
+}
+
+std::vector<std::string> split_reference(std::string_view input, std::string_view delimiter) {
+  std::vector<std::string> lines;
+  std::size_t start = 0;
+  for (std::size_t pos = input.find(delimiter); pos != std::string_view::npos;
+       pos = input.find(delimiter, start)) {
+    lines.emplace_back(input.substr(start, pos - start));
+    start = pos + delimiter.size();
+  }
+  if (start < input.size()) {
+    lines.emplace_back(input.substr(start));
+  }
+  return lines;
+}
+
+}  // namespace
+
+TEST(OutputSinkTest, DefaultSinkDiscards) {
+  OutputSink sink;
+  sink.write("ignored", 7);
+  sink.finish();
+}
+
+TEST(OutputSinkTest, ChunksSeeEveryByte) {
+  std::string seen;
+  auto sink = OutputSink::chunks(
+      OutputSink::ChunkCallback([&](const std::byte* data, std::size_t size) {
+        seen.append(reinterpret_cast<const char*>(data), size);
+      }));
+  sink.write("abc", 3);
+  sink.write("def", 3);
+  sink.finish();
+  EXPECT_EQ(seen, "abcdef");
+}
+
+TEST(OutputSinkTest, LinesSplitAcrossChunkBoundaries) {
+  std::string input = "first\nsecond\n\nlast";
+  std::vector<std::string> expected = {"first", "second", "", "last"};
+  for (std::size_t chunk_size = 1; chunk_size <= input.size(); ++chunk_size) {
+    EXPECT_EQ(split_in_chunks(input, chunk_size), expected) << "chunk size " << chunk_size;
+  }
+}
+
+TEST(OutputSinkTest, MultiByteDelimiterSpansChunks) {
+  std::string input = "a\r\nbb\r\n\r\nccc\r\n";
+  std::vector<std::string> expected = {"a", "bb", "", "ccc"};
+  for (std::size_t chunk_size = 1; chunk_size <= input.size(); ++chunk_size) {
+    EXPECT_EQ(split_in_chunks(input, chunk_size, "\r\n"), expected) << "chunk size " << chunk_size;
+  }
+}
+
+TEST(OutputSinkTest, CustomDelimiter) {
+  EXPECT_EQ(split_in_chunks(std::string("x\0y\0", 4), 3, std::string(1, '\0')),
+            (std::vector<std::string>{"x", "y"}));
+}
+
+TEST(OutputSinkTest, LongInputMatchesReferenceSplit) {
+  // Dense and sparse delimiters on both sides of the 16-byte block scan and its tail.
+  std::mt19937 random(7);
+  for (std::string delimiter : {std::string("\n"), std::string("\r\n"), std::string("aab")}) {
+    std::string input;
+    const std::string alphabet = "ab\r\n";
+    std::uniform_int_distribution<std::size_t> pick(0, alphabet.size() - 1);
+    for (int i = 0; i < 4096; ++i) {
+      input.push_back(alphabet[pick(random)]);
+    }
+    auto expected = split_reference(input, delimiter);
+    for (std::size_t chunk_size : {1U, 7U, 16U, 17U, 64U, 1000U, 4096U}) {
+      EXPECT_EQ(split_in_chunks(input, chunk_size, delimiter), expected)
+          << "delimiter size " << delimiter.size() << " chunk size " << chunk_size;
+    }
+  }
+}
+
+TEST(OutputSinkTest, TeeFeedsEverySinkAndFinishesThem) {
+  std::string captured;
+  std::vector<std::string> lines;
+  std::size_t counted = 0;
+  auto sink = OutputSink::tee({
+      OutputSink::capture(captured),
+      OutputSink::lines([&](std::string_view line) { lines.emplace_back(line); }),
+      OutputSink::chunks(OutputSink::ChunkCallback(
+          [&](const std::byte* /*data*/, std::size_t size) { counted += size; })),
+  });
+  sink.write("one\ntw", 6);
+  sink.write("o\nthree", 7);
+  EXPECT_EQ(lines, (std::vector<std::string>{"one", "two"}));
+  sink.finish();
+
+  EXPECT_EQ(captured, "one\ntwo\nthree");
+  EXPECT_EQ(lines, (std::vector<std::string>{"one", "two", "three"}));
+  EXPECT_EQ(counted, 13U);
+}
+
+#if PROCLY_PLATFORM_POSIX
+TEST(OutputSinkTest, FileSinkAppendsOrTruncates) {
+  auto path = std::filesystem::temp_directory_path() /
+              ("procly-output-sink-" + std::to_string(::getpid()) + ".log");
+  auto read_back = [&] {
+    std::ifstream in(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+  };
+  {
+    auto sink = OutputSink::file(path, false);
+    ASSERT_TRUE(sink.has_value()) << sink.error().code.message();
+    sink->write("first\n", 6);
+    sink->finish();
+  }
+  {
+    auto sink = OutputSink::file(path);
+    ASSERT_TRUE(sink.has_value()) << sink.error().code.message();
+    sink->write("second\n", 7);
+    sink->finish();
+  }
+  EXPECT_EQ(read_back(), "first\nsecond\n");
+  {
+    auto sink = OutputSink::file(path, false);
+    ASSERT_TRUE(sink.has_value());
+  }
+  EXPECT_EQ(read_back(), "");
+  std::filesystem::remove(path);
+
+  auto missing = OutputSink::file(path / "no-such-dir" / "x.log");
+  EXPECT_FALSE(missing.has_value());
+}
+#endif
+
+}  // namespace procly
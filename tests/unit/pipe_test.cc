@@ -3,7 +3,13 @@
 #include <fcntl.h>
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <array>
 #include <cerrno>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include "procly/internal/fd.hpp"
 
@@ -60,4 +66,228 @@ TEST(PipeTest, PipeFdsAreCloexec) {
 }
 #endif
 
+namespace {
+
+std::string transfer_payload() {
+  std::string payload(300 * 1024, '\0');
+  for (std::size_t i = 0; i < payload.size(); ++i) {
+    payload[i] = static_cast<char>('a' + i % 23);
+  }
+  return payload;
+}
+
+std::string read_file(int fd) {
+  std::string out;
+  ::lseek(fd, 0, SEEK_SET);
+  std::array<char, 4096> buffer{};
+  ssize_t n = 0;
+  while ((n = ::read(fd, buffer.data(), buffer.size())) > 0) {
+    out.append(buffer.data(), static_cast<std::size_t>(n));
+  }
+  return out;
+}
+
+void expect_transfer_to_file(int open_flags) {
+  auto source = internal::create_pipe();
+  ASSERT_TRUE(source.has_value());
+  PipeReader reader(source->first.release());
+  PipeWriter writer(source->second.release());
+
+  std::FILE* file = std::tmpfile();
+  ASSERT_NE(file, nullptr);
+  int file_fd = ::fileno(file);
+  ASSERT_NE(::fcntl(file_fd, F_SETFL, ::fcntl(file_fd, F_GETFL) | open_flags), -1);
+
+  std::string payload = transfer_payload();
+  std::thread producer([&] {
+    EXPECT_TRUE(writer.write_all(payload).has_value());
+    writer.close();
+  });
+  auto moved = reader.transfer_to(file_fd);
+  producer.join();
+  ASSERT_TRUE(moved.has_value()) << moved.error().context << " " << moved.error().code.message();
+  EXPECT_EQ(moved.value(), payload.size());
+  EXPECT_EQ(read_file(file_fd), payload);
+  std::fclose(file);
+}
+
+}  // namespace
+
+TEST(PipeTest, TransferToFile) { expect_transfer_to_file(0); }
+
+TEST(PipeTest, TransferToAppendFileFallsBack) { expect_transfer_to_file(O_APPEND); }
+
+TEST(PipeTest, TransferToPipeWithTee) {
+  auto source = internal::create_pipe();
+  ASSERT_TRUE(source.has_value());
+  auto sink = internal::create_pipe();
+  ASSERT_TRUE(sink.has_value());
+  auto observer = internal::create_pipe();
+  ASSERT_TRUE(observer.has_value());
+
+  PipeReader reader(source->first.release());
+  PipeWriter writer(source->second.release());
+  PipeReader sink_reader(sink->first.release());
+  PipeWriter sink_writer(sink->second.release());
+  PipeReader tee_reader(observer->first.release());
+  PipeWriter tee_writer(observer->second.release());
+
+  std::string payload = transfer_payload();
+  std::thread producer([&] {
+    EXPECT_TRUE(writer.write_all(payload).has_value());
+    writer.close();
+  });
+  std::string forwarded;
+  std::thread forward_reader([&] { forwarded = sink_reader.read_all().value(); });
+  std::string observed;
+  std::thread tee_thread([&] { observed = tee_reader.read_all().value(); });
+
+  auto moved = reader.transfer_to(sink_writer.native_handle(), tee_writer);
+  sink_writer.close();
+  tee_writer.close();
+  producer.join();
+  forward_reader.join();
+  tee_thread.join();
+  ASSERT_TRUE(moved.has_value()) << moved.error().context << " " << moved.error().code.message();
+  EXPECT_EQ(moved.value(), payload.size());
+  EXPECT_EQ(forwarded, payload);
+  EXPECT_EQ(observed, payload);
+}
+
+TEST(PipeTest, TransferFromFile) {
+  std::string payload = transfer_payload();
+  std::FILE* file = std::tmpfile();
+  ASSERT_NE(file, nullptr);
+  ASSERT_EQ(std::fwrite(payload.data(), 1, payload.size(), file), payload.size());
+  ASSERT_EQ(std::fflush(file), 0);
+  int file_fd = ::fileno(file);
+  ::lseek(file_fd, 0, SEEK_SET);
+
+  auto pipe_result = internal::create_pipe();
+  ASSERT_TRUE(pipe_result.has_value());
+  PipeReader reader(pipe_result->first.release());
+  PipeWriter writer(pipe_result->second.release());
+
+  std::string received;
+  std::thread consumer([&] { received = reader.read_all().value(); });
+  auto moved = writer.transfer_from(file_fd);
+  writer.close();
+  consumer.join();
+  std::fclose(file);
+  ASSERT_TRUE(moved.has_value()) << moved.error().context << " " << moved.error().code.message();
+  EXPECT_EQ(moved.value(), payload.size());
+  EXPECT_EQ(received, payload);
+}
+
+TEST(PipeTest, NonBlockingModeReportsWouldBlock) {
+  auto pipe_result = internal::create_pipe();
+  ASSERT_TRUE(pipe_result.has_value());
+  PipeReader reader(pipe_result->first.release());
+  PipeWriter writer(pipe_result->second.release());
+  ASSERT_TRUE(reader.set_nonblocking().has_value());
+  ASSERT_TRUE(writer.set_nonblocking().has_value());
+
+  std::array<char, 64> buffer{};
+  auto empty = reader.try_read_some(buffer.data(), buffer.size());
+  ASSERT_TRUE(empty.has_value()) << empty.error().context << " " << empty.error().code.message();
+  EXPECT_FALSE(empty->has_value());
+
+  // Fill the pipe until the writer reports it would block.
+  std::string chunk(4096, 'x');
+  std::size_t total = 0;
+  while (true) {
+    auto written = writer.try_write_some(chunk.data(), chunk.size());
+    ASSERT_TRUE(written.has_value())
+        << written.error().context << " " << written.error().code.message();
+    if (!written->has_value()) {
+      break;
+    }
+    total += *written.value();
+  }
+  EXPECT_GT(total, 0U);
+
+  auto read = reader.try_read_some(buffer.data(), buffer.size());
+  ASSERT_TRUE(read.has_value());
+  ASSERT_TRUE(read->has_value());
+  EXPECT_EQ(*read.value(), buffer.size());
+
+  writer.close();
+  std::vector<char> rest(total);
+  std::size_t drained = buffer.size();
+  while (true) {
+    auto more = reader.try_read_some(rest.data(), rest.size());
+    ASSERT_TRUE(more.has_value());
+    ASSERT_TRUE(more->has_value());
+    if (*more.value() == 0) {
+      break;
+    }
+    drained += *more.value();
+  }
+  EXPECT_EQ(drained, total);
+}
+
+#if PROCLY_HAS_STD_SPAN
+TEST(PipeTest, GatherWriteResumesAfterPartialWrites) {
+  auto pipe_result = internal::create_pipe();
+  ASSERT_TRUE(pipe_result.has_value());
+  PipeReader reader(pipe_result->first.release());
+  PipeWriter writer(pipe_result->second.release());
+
+  // More buffers than the inline iovec array, and larger than the pipe, so writev stops
+  // part-way through a buffer and has to resume inside it.
+  std::string payload = transfer_payload();
+  std::vector<std::span<const std::byte>> buffers;
+  std::string expected;
+  std::size_t offset = 0;
+  for (std::size_t size : {5U, 0U, 70000U, 1U, 0U, 120000U, 3U, 9U, 11U, 40000U}) {
+    buffers.emplace_back(reinterpret_cast<const std::byte*>(payload.data() + offset), size);
+    expected.append(payload, offset, size);
+    offset += size;
+  }
+
+  std::string received;
+  std::thread consumer([&] { received = reader.read_all().value(); });
+  auto written = writer.write_all(buffers);
+  writer.close();
+  consumer.join();
+  ASSERT_TRUE(written.has_value())
+      << written.error().context << " " << written.error().code.message();
+  EXPECT_EQ(received, expected);
+}
+
+TEST(PipeTest, ScatterReadFillsBuffersInOrder) {
+  auto pipe_result = internal::create_pipe();
+  ASSERT_TRUE(pipe_result.has_value());
+  PipeReader reader(pipe_result->first.release());
+  PipeWriter writer(pipe_result->second.release());
+  ASSERT_TRUE(writer.write_all("headbody!").has_value());
+
+  std::array<std::byte, 4> header{};
+  std::array<std::byte, 16> body{};
+  std::array<std::span<std::byte>, 2> buffers{std::span<std::byte>(header),
+                                              std::span<std::byte>(body)};
+  auto read = reader.read_some(buffers);
+  ASSERT_TRUE(read.has_value()) << read.error().context << " " << read.error().code.message();
+  EXPECT_EQ(read.value(), 9U);
+  EXPECT_EQ(std::string_view(reinterpret_cast<const char*>(header.data()), header.size()), "head");
+  EXPECT_EQ(std::string_view(reinterpret_cast<const char*>(body.data()), 5), "body!");
+}
+#endif
+
+#if PROCLY_PLATFORM_LINUX && defined(F_GETPIPE_SZ)
+TEST(PipeTest, CreatePipeAppliesCapacity) {
+  constexpr std::size_t kCapacity = 256 * 1024;
+  auto pipe_result = internal::create_pipe(kCapacity);
+  ASSERT_TRUE(pipe_result.has_value());
+  int capacity = ::fcntl(pipe_result->first.get(), F_GETPIPE_SZ);
+  EXPECT_GE(static_cast<std::size_t>(capacity), std::min(kCapacity, internal::pipe_max_size()));
+
+  // Requests above the system maximum are clamped rather than failing.
+  auto huge = internal::create_pipe(std::size_t{1} << 40);
+  ASSERT_TRUE(huge.has_value());
+  EXPECT_EQ(static_cast<std::size_t>(::fcntl(huge->first.get(), F_GETPIPE_SZ)),
+            internal::pipe_max_size());
+}
+#endif
+
 }  // namespace procly
@@ -2,6 +2,7 @@
 
 #include <gtest/gtest.h>
 #include <spawn.h>
+#include <sys/resource.h>
 
 #include <filesystem>
 
@@ -19,11 +20,14 @@ TEST(PosixSpawnTest, CwdRequiresSupport) {
   SpawnSpec spec;
   spec.argv = {"echo"};
   spec.cwd = std::filesystem::current_path();
-#if PROCLY_PLATFORM_MACOS
-  EXPECT_TRUE(can_use_posix_spawn(spec));
-#else
-  EXPECT_FALSE(can_use_posix_spawn(spec));
-#endif
+  EXPECT_EQ(can_use_posix_spawn(spec), PROCLY_HAS_SPAWN_CHDIR != 0);
+}
+
+TEST(PosixSpawnTest, CwdFdRequiresSupport) {
+  SpawnSpec spec;
+  spec.argv = {"echo"};
+  spec.cwd_fd = 3;
+  EXPECT_EQ(can_use_posix_spawn(spec), PROCLY_HAS_SPAWN_CHDIR != 0);
 }
 
 TEST(PosixSpawnTest, ProcessGroupRequiresSupport) {
@@ -37,4 +41,91 @@ TEST(PosixSpawnTest, ProcessGroupRequiresSupport) {
 #endif
 }
 
+TEST(PosixSpawnTest, ResourceLimitsRequireFork) {
+  SpawnSpec spec;
+  spec.argv = {"echo"};
+  spec.opts.limits.push_back(ResourceLimit{.resource = RLIMIT_NOFILE, .soft = 64, .hard = 64});
+  EXPECT_FALSE(can_use_posix_spawn(spec));
+}
+
+TEST(PosixSpawnTest, NiceRequiresFork) {
+  SpawnSpec spec;
+  spec.argv = {"echo"};
+  spec.opts.nice = 10;
+  EXPECT_FALSE(can_use_posix_spawn(spec));
+}
+
+#if PROCLY_PLATFORM_LINUX
+TEST(PosixSpawnTest, NormalPolicyKeepsPosixSpawn) {
+  SpawnSpec spec;
+  spec.argv = {"echo"};
+  spec.opts.scheduling_policy = SchedulingPolicy::normal;
+  EXPECT_TRUE(can_use_posix_spawn(spec));
+}
+
+TEST(PosixSpawnTest, AffinityRequiresFork) {
+  SpawnSpec spec;
+  spec.argv = {"echo"};
+  spec.opts.cpu_affinity = {0};
+  EXPECT_EQ(posix_spawn_blocker(spec), SpawnFallbackReason::cpu_affinity);
+}
+
+TEST(PosixSpawnTest, BatchAndIdlePoliciesRequireFork) {
+  SpawnSpec spec;
+  spec.argv = {"echo"};
+  spec.opts.scheduling_policy = SchedulingPolicy::batch;
+  EXPECT_FALSE(can_use_posix_spawn(spec));
+  spec.opts.scheduling_policy = SchedulingPolicy::idle;
+  EXPECT_FALSE(can_use_posix_spawn(spec));
+}
+
+TEST(PosixSpawnTest, IoPriorityRequiresFork) {
+  SpawnSpec spec;
+  spec.argv = {"echo"};
+  spec.opts.io_priority = IoPriority{.io_class = IoPriorityClass::idle, .level = 0};
+  EXPECT_FALSE(can_use_posix_spawn(spec));
+}
+
+TEST(PosixSpawnTest, CgroupRequiresFork) {
+  SpawnSpec spec;
+  spec.argv = {"echo"};
+  spec.opts.cgroup = "/sys/fs/cgroup/procly";
+  EXPECT_FALSE(can_use_posix_spawn(spec));
+}
+
+TEST(PosixSpawnTest, ExecutableFdRequiresFork) {
+  SpawnSpec spec;
+  spec.argv = {"echo"};
+  spec.exec_fd = 3;
+  EXPECT_EQ(posix_spawn_blocker(spec), SpawnFallbackReason::executable_fd);
+}
+#endif
+
+TEST(PosixSpawnTest, SelectReportsFallbackReason) {
+  SpawnSpec spec;
+  spec.argv = {"echo"};
+  spec.opts.nice = 5;
+  SpawnFallbackReason reason = SpawnFallbackReason::none;
+  EXPECT_NE(select_spawn_strategy(spec, &reason), SpawnStrategy::posix_spawn);
+#if defined(PROCLY_FORCE_FORK) || defined(PROCLY_FORCE_VFORK)
+  EXPECT_EQ(reason, SpawnFallbackReason::forced);
+#else
+  EXPECT_EQ(reason, SpawnFallbackReason::nice);
+#endif
+}
+
+TEST(PosixSpawnTest, VforkStrategyAppliesToForkFallback) {
+  SpawnSpec spec;
+  spec.argv = {"echo"};
+  spec.opts.fork_strategy = ForkStrategy::vfork;
+  EXPECT_EQ(fork_fallback_strategy(spec),
+            can_use_vfork() ? SpawnStrategy::vfork_exec : SpawnStrategy::fork_exec);
+}
+
+TEST(PosixSpawnTest, ForkStrategyDefaultsToFork) {
+  SpawnSpec spec;
+  spec.argv = {"echo"};
+  EXPECT_EQ(fork_fallback_strategy(spec), SpawnStrategy::fork_exec);
+}
+
 }  // namespace procly::internal
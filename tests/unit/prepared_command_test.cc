@@ -0,0 +1,144 @@
+#include "procly/prepared_command.hpp"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "procly/internal/backend.hpp"
+#include "procly/platform.hpp"
+
+namespace procly {
+namespace {
+
+class RecordingBackend : public internal::Backend {
+ public:
+  Result<internal::Spawned> spawn(const internal::SpawnSpec& spec) override {
+    spawn_specs.push_back(spec);
+    internal::Spawned spawned;
+    spawned.pid = 100 + static_cast<int>(spawn_specs.size());
+    return spawned;
+  }
+
+  Result<WaitResult> wait(internal::Spawned& spawned,
+                          std::optional<std::chrono::milliseconds> /*timeout*/,
+                          std::chrono::milliseconds /*kill_grace*/) override {
+    if (!spawned.terminal_result) {
+      internal::cache_terminal_result(spawned, WaitResult{.status = ExitStatus::exited(0)});
+    }
+    return *spawned.terminal_result;
+  }
+
+  Result<std::optional<ExitStatus>> try_wait(internal::Spawned& spawned) override {
+    if (spawned.terminal_result) {
+      return std::optional<ExitStatus>(spawned.terminal_result->status);
+    }
+    return std::optional<ExitStatus>();
+  }
+
+  Result<void> terminate(internal::Spawned& /*spawned*/) override { return {}; }
+  Result<void> kill(internal::Spawned& /*spawned*/) override { return {}; }
+  Result<void> signal(internal::Spawned& /*spawned*/, int /*signo*/) override { return {}; }
+
+  std::vector<internal::SpawnSpec> spawn_specs;
+};
+
+}  // namespace
+
+TEST(PreparedCommandTest, SetArgRewritesSlotForEverySpawnMode) {
+  RecordingBackend backend;
+  internal::ScopedBackendOverride override_backend(backend);
+
+  Command cmd("/bin/echo");
+  cmd.arg("--flag").arg("first");
+  auto prepared = PreparedCommand::prepare(cmd);
+  ASSERT_TRUE(prepared.has_value());
+  EXPECT_EQ(prepared->arg_count(), 3U);
+
+  ASSERT_TRUE(prepared->status().has_value());
+  ASSERT_TRUE(prepared->set_arg(2, "second").has_value());
+  ASSERT_TRUE(prepared->output().has_value());
+
+  ASSERT_EQ(backend.spawn_specs.size(), 2U);
+  EXPECT_EQ(backend.spawn_specs[0].argv,
+            (std::vector<std::string>{"/bin/echo", "--flag", "first"}));
+  EXPECT_EQ(backend.spawn_specs[1].argv,
+            (std::vector<std::string>{"/bin/echo", "--flag", "second"}));
+  EXPECT_EQ(backend.spawn_specs[0].stdout_spec.kind, internal::StdioSpec::Kind::inherit);
+  EXPECT_EQ(backend.spawn_specs[1].stdout_spec.kind, internal::StdioSpec::Kind::piped);
+}
+
+TEST(PreparedCommandTest, SetArgRejectsProgramAndOutOfRangeSlots) {
+  Command cmd("/bin/echo");
+  cmd.arg("one");
+  auto prepared = PreparedCommand::prepare(cmd);
+  ASSERT_TRUE(prepared.has_value());
+
+  auto program = prepared->set_arg(0, "/bin/true");
+  ASSERT_FALSE(program.has_value());
+  EXPECT_EQ(program.error().code, make_error_code(errc::invalid_argument));
+  EXPECT_FALSE(prepared->set_arg(2, "two").has_value());
+  EXPECT_EQ(prepared->argv().front(), "/bin/echo");
+}
+
+TEST(PreparedCommandTest, SpawnsShareOneEnvironmentBlock) {
+  RecordingBackend backend;
+  internal::ScopedBackendOverride override_backend(backend);
+
+  Command cmd("/bin/echo");
+  cmd.env("PROCLY_PREPARED_ENV", "value");
+  auto prepared = PreparedCommand::prepare(cmd);
+  ASSERT_TRUE(prepared.has_value());
+  ASSERT_TRUE(prepared->status().has_value());
+  ASSERT_TRUE(prepared->output().has_value());
+
+  ASSERT_EQ(backend.spawn_specs.size(), 2U);
+  EXPECT_EQ(backend.spawn_specs[0].envp.data(), backend.spawn_specs[1].envp.data());
+  EXPECT_EQ(backend.spawn_specs[0].envp.find("PROCLY_PREPARED_ENV"),
+            std::optional<std::string_view>("value"));
+}
+
+#if PROCLY_PLATFORM_POSIX
+TEST(PreparedCommandTest, ResolvesBareProgramAgainstPathOnce) {
+  RecordingBackend backend;
+  internal::ScopedBackendOverride override_backend(backend);
+
+  auto dir = std::filesystem::temp_directory_path() / "procly_prepared_path";
+  std::filesystem::create_directories(dir);
+  auto program = dir / "procly-prepared-tool";
+  {
+    std::ofstream file(program);
+    file << "#!/bin/sh\n";
+  }
+  std::filesystem::permissions(program, std::filesystem::perms::owner_all);
+
+  Command cmd("procly-prepared-tool");
+  cmd.env("PATH", dir.string());
+  auto prepared = PreparedCommand::prepare(cmd);
+  ASSERT_TRUE(prepared.has_value());
+  EXPECT_EQ(prepared->executable(), program.string());
+
+  std::filesystem::remove(program);
+  ASSERT_TRUE(prepared->status().has_value());
+  ASSERT_EQ(backend.spawn_specs.size(), 1U);
+  EXPECT_EQ(backend.spawn_specs[0].exec_path, std::optional<std::string>(program.string()));
+  EXPECT_EQ(backend.spawn_specs[0].argv.front(), "procly-prepared-tool");
+
+  std::error_code ec;
+  std::filesystem::remove_all(dir, ec);
+}
+
+TEST(PreparedCommandTest, UnresolvedProgramKeepsPerSpawnLookup) {
+  Command cmd("procly-prepared-missing-tool");
+  cmd.env("PATH", "/nonexistent-procly-dir");
+  auto prepared = PreparedCommand::prepare(cmd);
+  ASSERT_TRUE(prepared.has_value());
+  EXPECT_EQ(prepared->executable(), "procly-prepared-missing-tool");
+}
+#endif
+
+}  // namespace procly
@@ -0,0 +1,199 @@
+#include "procly/reactor.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "procly/internal/access.hpp"
+#include "procly/internal/backend.hpp"
+#include "procly/internal/fd.hpp"
+
+namespace procly {
+namespace {
+
+// Backend without exit handles: the reactor falls back to polling try_wait.
+class PollingBackend : public internal::Backend {
+ public:
+  Result<internal::Spawned> spawn(const internal::SpawnSpec& /*spec*/) override {
+    internal::Spawned spawned;
+    spawned.pid = 100 + ++spawn_calls;
+    return spawned;
+  }
+
+  Result<WaitResult> wait(internal::Spawned& spawned,
+                          std::optional<std::chrono::milliseconds> /*timeout*/,
+                          std::chrono::milliseconds /*kill_grace*/) override {
+    if (!spawned.terminal_result) {
+      internal::cache_terminal_result(spawned, WaitResult{.status = ExitStatus::other(9)});
+    }
+    return *spawned.terminal_result;
+  }
+
+  Result<std::optional<ExitStatus>> try_wait(internal::Spawned& spawned) override {
+    if (spawned.terminal_result) {
+      return std::optional<ExitStatus>(spawned.terminal_result->status);
+    }
+    ++try_wait_calls;
+    if (killed || (exit_after_calls > 0 && try_wait_calls >= exit_after_calls)) {
+      ExitStatus status = killed ? ExitStatus::other(9) : ExitStatus::exited(exit_code);
+      internal::cache_terminal_result(spawned, WaitResult{.status = status});
+      return std::optional<ExitStatus>(status);
+    }
+    return std::optional<ExitStatus>();
+  }
+
+  Result<void> terminate(internal::Spawned& /*spawned*/) override {
+    ++terminate_calls;
+    return {};
+  }
+
+  Result<void> kill(internal::Spawned& /*spawned*/) override {
+    ++kill_calls;
+    killed = true;
+    return {};
+  }
+
+  Result<void> signal(internal::Spawned& /*spawned*/, int /*signo*/) override { return {}; }
+
+  int spawn_calls = 0;
+  int try_wait_calls = 0;
+  int exit_after_calls = 1;
+  int exit_code = 0;
+  int terminate_calls = 0;
+  int kill_calls = 0;
+  bool killed = false;
+};
+
+}  // namespace
+
+TEST(ReactorTest, DeliversCompletionsWithoutExitHandles) {
+  PollingBackend backend;
+  backend.exit_after_calls = 3;
+  backend.exit_code = 4;
+  internal::ScopedBackendOverride override_backend(backend);
+
+  auto reactor = Reactor::create();
+  ASSERT_TRUE(reactor.has_value());
+
+  std::optional<Result<ChildCompletion>> completion;
+  auto child = Command("echo").spawn();
+  ASSERT_TRUE(child.has_value());
+  auto watched = reactor->watch(std::move(child.value()), {},
+                                [&](Result<ChildCompletion> result) { completion = result; });
+  ASSERT_TRUE(watched.has_value());
+  EXPECT_EQ(reactor->pending(), 1U);
+
+  auto ran = reactor->run();
+  ASSERT_TRUE(ran.has_value());
+  EXPECT_EQ(reactor->pending(), 0U);
+  ASSERT_TRUE(completion.has_value());
+  ASSERT_TRUE(completion->has_value());
+  EXPECT_EQ(completion->value().wait.status.code().value_or(-1), 4);
+  EXPECT_FALSE(completion->value().wait.timed_out);
+}
+
+TEST(ReactorTest, TimeoutEscalatesToKill) {
+  PollingBackend backend;
+  backend.exit_after_calls = 0;
+  internal::ScopedBackendOverride override_backend(backend);
+
+  auto reactor = Reactor::create();
+  ASSERT_TRUE(reactor.has_value());
+
+  auto child = Command("sleep").spawn();
+  ASSERT_TRUE(child.has_value());
+  WatchOptions options;
+  options.timeout = std::chrono::milliseconds(1);
+  options.kill_grace = std::chrono::milliseconds(1);
+  auto future = reactor->watch(std::move(child.value()), options);
+
+  ASSERT_TRUE(reactor->run().has_value());
+  auto completion = future.get();
+  ASSERT_TRUE(completion.has_value());
+  EXPECT_TRUE(completion->wait.timed_out);
+  EXPECT_TRUE(completion->wait.sent_terminate);
+  EXPECT_TRUE(completion->wait.sent_kill);
+  EXPECT_EQ(backend.terminate_calls, 1);
+  EXPECT_EQ(backend.kill_calls, 1);
+}
+
+TEST(ReactorTest, PipelineCompletesOnceEveryStageExits) {
+  PollingBackend backend;
+  backend.exit_after_calls = 1;
+  internal::ScopedBackendOverride override_backend(backend);
+
+  auto reactor = Reactor::create();
+  ASSERT_TRUE(reactor.has_value());
+
+  auto child = (Command("echo") | Command("cat")).spawn();
+  ASSERT_TRUE(child.has_value());
+  auto future = reactor->watch(std::move(child.value()));
+
+  ASSERT_TRUE(reactor->run().has_value());
+  auto completion = future.get();
+  ASSERT_TRUE(completion.has_value());
+  EXPECT_EQ(completion->status.stages.size(), 2U);
+  EXPECT_TRUE(completion->status.aggregate.success());
+}
+
+TEST(ReactorTest, CallbacksMayWatchMoreChildren) {
+  PollingBackend backend;
+  internal::ScopedBackendOverride override_backend(backend);
+
+  auto reactor = Reactor::create();
+  ASSERT_TRUE(reactor.has_value());
+
+  int completions = 0;
+  Reactor::ChildCallback on_complete = [&](Result<ChildCompletion> result) {
+    ASSERT_TRUE(result.has_value());
+    if (++completions < 3) {
+      auto next = Command("echo").spawn();
+      ASSERT_TRUE(next.has_value());
+      ASSERT_TRUE(reactor->watch(std::move(next.value()), {}, on_complete).has_value());
+    }
+  };
+  auto child = Command("echo").spawn();
+  ASSERT_TRUE(child.has_value());
+  ASSERT_TRUE(reactor->watch(std::move(child.value()), {}, on_complete).has_value());
+
+  ASSERT_TRUE(reactor->run().has_value());
+  EXPECT_EQ(completions, 3);
+  EXPECT_EQ(backend.spawn_calls, 3);
+}
+
+TEST(ReactorTest, ManyTimeoutsFireInDeadlineOrder) {
+  auto reactor = Reactor::create();
+  ASSERT_TRUE(reactor.has_value());
+
+  // Read ends that never become readable; the write ends stay open.
+  constexpr std::size_t kWaiters = 64;
+  std::vector<std::pair<internal::unique_fd, internal::unique_fd>> pipes;
+  std::vector<std::size_t> fired;
+  for (std::size_t i = 0; i < kWaiters; ++i) {
+    auto pipe = internal::create_pipe();
+    ASSERT_TRUE(pipe.has_value());
+    pipes.push_back(std::move(pipe.value()));
+  }
+  // Registered latest deadline first.
+  for (std::size_t i = kWaiters; i-- > 0;) {
+    auto timeout = std::chrono::milliseconds(static_cast<int>(i) / 4);
+    ASSERT_TRUE(reactor
+                    ->when_readable(pipes[i].first.get(), timeout,
+                                    [&fired, i](bool ready) {
+                                      EXPECT_FALSE(ready);
+                                      fired.push_back(i / 4);
+                                    })
+                    .has_value());
+  }
+
+  ASSERT_TRUE(reactor->run().has_value());
+  ASSERT_EQ(fired.size(), kWaiters);
+  EXPECT_TRUE(std::is_sorted(fired.begin(), fired.end()));
+}
+
+}  // namespace procly
@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+
+#include "procly/platform.hpp"
+
+#if PROCLY_PLATFORM_POSIX
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+
+#include "procly/internal/remote_backend.hpp"
+
+namespace procly {
+namespace {
+
+// Stands in for the reader thread: replies and exits are delivered by the test.
+class FakeRemote final : public internal::RemoteBackend<int> {
+ public:
+  FakeRemote() : RemoteBackend("fake disconnected") {}
+
+  Result<Spawned> spawn(const SpawnSpec& spec) override {
+    (void)spec;
+    return Error{.code = make_error_code(errc::spawn_failed), .context = "fake"};
+  }
+
+  Result<void> signal(Spawned& spawned, int signo) override {
+    (void)spawned;
+    (void)signo;
+    return {};
+  }
+
+  // A spawn reply handing out pid.
+  Spawned spawned(int pid) {
+    deliver_reply(next_id_++, pid, pid);
+    Spawned spawned;
+    spawned.pid = pid;
+    spawned.backend = this;
+    return spawned;
+  }
+
+  void exit(int pid, int code) { deliver_exit(pid, ExitStatus::exited(code)); }
+
+  using RemoteBackend::disconnect;
+
+ private:
+  std::uint64_t next_id_ = 1;
+};
+
+TEST(RemoteBackendTest, CollectsExitOnce) {
+  FakeRemote remote;
+  auto child = remote.spawned(40);
+  auto pending = remote.try_wait(child);
+  ASSERT_TRUE(pending.has_value());
+  EXPECT_FALSE(pending->has_value());
+
+  remote.exit(40, 3);
+  auto waited = remote.wait(child, std::nullopt, std::chrono::milliseconds(0));
+  ASSERT_TRUE(waited.has_value());
+  EXPECT_EQ(waited->status.code(), std::optional<int>(3));
+}
+
+TEST(RemoteBackendTest, AbandonedExitDoesNotReachReusedPid) {
+  FakeRemote remote;
+  auto first = remote.spawned(41);
+  remote.abandon(first);
+  remote.exit(41, 1);
+
+  auto second = remote.spawned(41);
+  auto status = remote.try_wait(second);
+  ASSERT_TRUE(status.has_value());
+  EXPECT_FALSE(status->has_value());
+  remote.exit(41, 0);
+  status = remote.try_wait(second);
+  ASSERT_TRUE(status.has_value() && status->has_value());
+  EXPECT_EQ(status->value().code(), std::optional<int>(0));
+}
+
+TEST(RemoteBackendTest, SpawnReplyClearsUncollectedExitOfReusedPid) {
+  FakeRemote remote;
+  auto first = remote.spawned(42);
+  remote.exit(42, 7);
+  // Dropped after the exit arrived: nothing is left behind either.
+  remote.abandon(first);
+
+  auto second = remote.spawned(42);
+  auto status = remote.try_wait(second);
+  ASSERT_TRUE(status.has_value());
+  EXPECT_FALSE(status->has_value());
+}
+
+TEST(RemoteBackendTest, DisconnectFailsPendingWaits) {
+  FakeRemote remote;
+  auto child = remote.spawned(43);
+  remote.disconnect();
+  auto status = remote.try_wait(child);
+  ASSERT_FALSE(status.has_value());
+  EXPECT_EQ(status.error().context, "fake disconnected");
+}
+
+}  // namespace
+}  // namespace procly
+
+#endif
@@ -0,0 +1,67 @@
+#include <gtest/gtest.h>
+
+#include "procly/platform.hpp"
+
+#if PROCLY_PLATFORM_POSIX
+
+#include <unistd.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <system_error>
+
+#include "procly/internal/wire.hpp"
+#include "procly/replay.hpp"
+
+namespace procly {
+namespace {
+
+// Replay file holding one run of `true` with a single chunk on the given stream byte.
+std::filesystem::path write_replay_file(const char* name, std::uint8_t stream) {
+  internal::Encoder out;
+  out.put_u64(1);
+  out.put_u32(1);
+  out.put_string("true");
+  out.put_u32(1);
+  out.put_u8(stream);
+  out.put_u64(0);
+  out.put_string("data");
+  out.put_bool(true);
+  out.put_i32(0);
+  out.put_u32(0);
+  out.put_u64(0);
+
+  auto path = std::filesystem::temp_directory_path() /
+              (std::string(name) + "." + std::to_string(::getpid()));
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  file << "procly-replay-1\n" << out.bytes();
+  return path;
+}
+
+TEST(ReplayTest, OpenAcceptsStdoutAndStderrChunks) {
+  for (std::uint8_t stream : {1, 2}) {
+    auto path = write_replay_file("replay_valid_stream", stream);
+    auto replayer = Replayer::open(path);
+    std::filesystem::remove(path);
+    ASSERT_TRUE(replayer.has_value()) << replayer.error().context;
+    EXPECT_EQ(replayer->remaining(), 1U);
+  }
+}
+
+TEST(ReplayTest, OpenRejectsCorruptedStreamByte) {
+  for (std::uint8_t stream : {0, 3, 255}) {
+    auto path = write_replay_file("replay_corrupt_stream", stream);
+    auto replayer = Replayer::open(path);
+    std::filesystem::remove(path);
+    ASSERT_FALSE(replayer.has_value()) << "stream " << static_cast<int>(stream);
+    EXPECT_EQ(replayer.error().code, std::make_error_code(std::errc::protocol_error));
+    EXPECT_EQ(replayer.error().context, "replay file");
+  }
+}
+
+}  // namespace
+}  // namespace procly
+
+#endif
@@ -0,0 +1,221 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "procly/backend.hpp"
+#include "procly/child.hpp"
+#include "procly/command.hpp"
+#include "procly/internal/backend.hpp"
+#include "procly/pipe.hpp"
+#include "procly/spawn_limiter.hpp"
+#include "procly/stdio.hpp"
+
+namespace procly {
+namespace {
+
+// Children exit as soon as they are waited on; spawns are recorded by argv[1].
+class RecordingBackend final : public Backend {
+ public:
+  Result<Spawned> spawn(const SpawnSpec& spec) override {
+    std::lock_guard lock(mutex_);
+    spawned_args_.push_back(spec.argv.size() > 1 ? spec.argv[1] : std::string());
+    Spawned spawned;
+    spawned.pid = next_pid_++;
+    return spawned;
+  }
+
+  Result<WaitResult> wait(Spawned& spawned, std::optional<std::chrono::milliseconds> timeout,
+                          std::chrono::milliseconds kill_grace) override {
+    (void)timeout;
+    (void)kill_grace;
+    if (!spawned.terminal_result) {
+      internal::cache_terminal_result(spawned, WaitResult{.status = ExitStatus::exited(0)});
+    }
+    return *spawned.terminal_result;
+  }
+
+  Result<std::optional<ExitStatus>> try_wait(Spawned& spawned) override {
+    if (spawned.terminal_result) {
+      return std::optional<ExitStatus>(spawned.terminal_result->status);
+    }
+    return std::optional<ExitStatus>{};
+  }
+
+  Result<void> terminate(Spawned& spawned) override {
+    (void)spawned;
+    return {};
+  }
+
+  Result<void> kill(Spawned& spawned) override {
+    (void)spawned;
+    return {};
+  }
+
+  Result<void> signal(Spawned& spawned, int signo) override {
+    (void)spawned;
+    (void)signo;
+    return {};
+  }
+
+  std::vector<std::string> spawned_args() {
+    std::lock_guard lock(mutex_);
+    return spawned_args_;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::vector<std::string> spawned_args_;
+  int next_pid_ = 100;
+};
+
+Result<Child> spawn_through(SpawnLimiter& limiter, SpawnPriority priority = SpawnPriority::normal,
+                            const std::string& tag = "") {
+  Command command("true");
+  command.arg(tag);
+  command.backend(limiter.backend(priority));
+  return command.spawn();
+}
+
+void wait_for_queued(const SpawnLimiter& limiter, std::size_t queued) {
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (limiter.stats().queued != queued && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  ASSERT_EQ(limiter.stats().queued, queued);
+}
+
+TEST(SpawnLimiterTest, FailFastRejectsBeyondMaxLiveUntilReaped) {
+  RecordingBackend inner;
+  SpawnLimiter limiter(SpawnLimiterOptions{.max_live = 2, .admission = Admission::fail_fast},
+                       &inner);
+
+  auto first = spawn_through(limiter);
+  auto second = spawn_through(limiter);
+  ASSERT_TRUE(first.has_value());
+  ASSERT_TRUE(second.has_value());
+  auto third = spawn_through(limiter);
+  ASSERT_FALSE(third.has_value());
+  EXPECT_EQ(third.error().code, std::make_error_code(std::errc::resource_unavailable_try_again));
+
+  ASSERT_TRUE(first->wait().has_value());
+  EXPECT_EQ(limiter.stats().live, 1U);
+  auto fourth = spawn_through(limiter);
+  EXPECT_TRUE(fourth.has_value());
+
+  SpawnLimiterStats stats = limiter.stats();
+  EXPECT_EQ(stats.live, 2U);
+  EXPECT_EQ(stats.admitted, 3U);
+  EXPECT_EQ(stats.rejected, 1U);
+}
+
+TEST(SpawnLimiterTest, BlockedSpawnProceedsWhenASlotFrees) {
+  RecordingBackend inner;
+  SpawnLimiter limiter(SpawnLimiterOptions{.max_live = 1}, &inner);
+
+  auto first = spawn_through(limiter);
+  ASSERT_TRUE(first.has_value());
+  std::optional<Result<Child>> second;
+  std::thread waiter([&] { second.emplace(spawn_through(limiter)); });
+  wait_for_queued(limiter, 1);
+  EXPECT_EQ(limiter.stats().peak_queued, 1U);
+
+  ASSERT_TRUE(first->wait().has_value());
+  waiter.join();
+  ASSERT_TRUE(second.has_value());
+  EXPECT_TRUE(second->has_value());
+  EXPECT_EQ(limiter.stats().queued, 0U);
+}
+
+TEST(SpawnLimiterTest, HigherPriorityIsAdmittedFirst) {
+  RecordingBackend inner;
+  SpawnLimiter limiter(SpawnLimiterOptions{.max_live = 1}, &inner);
+
+  auto holder = spawn_through(limiter, SpawnPriority::normal, "holder");
+  ASSERT_TRUE(holder.has_value());
+  std::optional<Result<Child>> low;
+  std::optional<Result<Child>> high;
+  std::thread low_waiter([&] { low.emplace(spawn_through(limiter, SpawnPriority::low, "low")); });
+  wait_for_queued(limiter, 1);
+  std::thread high_waiter(
+      [&] { high.emplace(spawn_through(limiter, SpawnPriority::high, "high")); });
+  wait_for_queued(limiter, 2);
+
+  ASSERT_TRUE(holder->wait().has_value());
+  high_waiter.join();
+  ASSERT_TRUE(high.has_value() && high->has_value());
+  EXPECT_EQ(limiter.stats().queued, 1U);
+  ASSERT_TRUE(high->value().wait().has_value());
+  low_waiter.join();
+  ASSERT_TRUE(low.has_value() && low->has_value());
+  EXPECT_EQ(inner.spawned_args(), (std::vector<std::string>{"holder", "high", "low"}));
+}
+
+TEST(SpawnLimiterTest, MaxWaitTimesOutBlockedSpawn) {
+  RecordingBackend inner;
+  SpawnLimiter limiter(
+      SpawnLimiterOptions{.max_live = 1, .max_wait = std::chrono::milliseconds(20)}, &inner);
+
+  auto first = spawn_through(limiter);
+  ASSERT_TRUE(first.has_value());
+  auto second = spawn_through(limiter);
+  ASSERT_FALSE(second.has_value());
+  EXPECT_EQ(second.error().code, make_error_code(errc::timeout));
+  EXPECT_EQ(limiter.stats().rejected, 1U);
+  EXPECT_EQ(limiter.stats().queued, 0U);
+}
+
+TEST(SpawnLimiterTest, RateLimitSpacesSpawnsAfterBurst) {
+  RecordingBackend inner;
+  SpawnLimiter limiter(SpawnLimiterOptions{.spawns_per_second = 50, .burst = 2}, &inner);
+
+  auto start = std::chrono::steady_clock::now();
+  for (int index = 0; index < 4; ++index) {
+    auto child = spawn_through(limiter);
+    ASSERT_TRUE(child.has_value());
+    ASSERT_TRUE(child->wait().has_value());
+  }
+  // Two spawns come from the burst; the other two wait 20ms each for a token.
+  EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(35));
+  EXPECT_EQ(limiter.stats().admitted, 4U);
+}
+
+TEST(SpawnLimiterTest, FailedSpawnReturnsItsSlot) {
+  SpawnLimiter limiter(SpawnLimiterOptions{.max_live = 1, .admission = Admission::fail_fast});
+
+  Command missing("/nonexistent/procly-spawn-limiter");
+  missing.backend(limiter.backend());
+  EXPECT_FALSE(missing.spawn().has_value());
+  EXPECT_EQ(limiter.stats().live, 0U);
+}
+
+TEST(SpawnLimiterTest, AbandonedChildKeepsItsSlotUntilItExits) {
+  SpawnLimiter limiter(SpawnLimiterOptions{.max_live = 1, .admission = Admission::fail_fast});
+
+  std::optional<PipeWriter> stdin_pipe;
+  {
+    Command cat("/bin/cat");
+    cat.stdin(Stdio::piped()).backend(limiter.backend());
+    auto child = cat.spawn();
+    ASSERT_TRUE(child.has_value()) << child.error().context;
+    stdin_pipe = child->take_stdin();
+    ASSERT_TRUE(stdin_pipe.has_value());
+  }
+  // The handle is gone but cat still runs, blocked on its stdin.
+  EXPECT_EQ(limiter.stats().live, 1U);
+  EXPECT_FALSE(spawn_through(limiter).has_value());
+
+  stdin_pipe->close();
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (limiter.stats().live != 0 && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_EQ(limiter.stats().live, 0U);
+}
+
+}  // namespace
+}  // namespace procly
@@ -1,10 +1,13 @@
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <cerrno>
+#include <cstddef>
 #include <chrono>
 #include <optional>
 #include <vector>
 
+#include "procly/internal/deadline_queue.hpp"
 #include "procly/internal/wait_policy.hpp"
 
 namespace procly {
@@ -152,6 +155,54 @@ TEST(TimeoutPolicyTest, TimeoutEscalatesToKill) {
   EXPECT_GE(clock.elapsed(), std::chrono::milliseconds(7));
 }
 
+TEST(TimeoutPolicyTest, WaitExitReplacesPollingSleeps) {
+  FakeClock clock;
+  TestOps ops_impl;
+  ops_impl.exit_after_terminate = true;
+  std::vector<std::chrono::milliseconds> budgets;
+
+  internal::WaitOps ops;
+  ops.try_wait = [&]() { return ops_impl.try_wait(); };
+  ops.wait_blocking = [&]() { return ops_impl.wait_blocking(); };
+  ops.terminate = [&]() { return ops_impl.terminate(); };
+  ops.kill = [&]() { return ops_impl.kill(); };
+  ops.wait_exit = [&](std::chrono::milliseconds budget) -> Result<void> {
+    budgets.push_back(budget);
+    clock.sleep_for(budget);
+    return {};
+  };
+
+  auto result = internal::wait_with_timeout(ops, clock, std::chrono::milliseconds(30000),
+                                            std::chrono::milliseconds(5));
+  ASSERT_TRUE(result.has_value());
+  EXPECT_TRUE(result->timed_out);
+  EXPECT_TRUE(result->sent_terminate);
+  EXPECT_FALSE(result->sent_kill);
+  ASSERT_EQ(budgets.size(), 1U);
+  EXPECT_EQ(budgets.front(), std::chrono::milliseconds(30000));
+  EXPECT_EQ(ops_impl.try_wait_calls, 3);
+}
+
+TEST(TimeoutPolicyTest, WaitExitErrorIsReturned) {
+  FakeClock clock;
+  TestOps ops_impl;
+
+  internal::WaitOps ops;
+  ops.try_wait = [&]() { return ops_impl.try_wait(); };
+  ops.wait_blocking = [&]() { return ops_impl.wait_blocking(); };
+  ops.terminate = [&]() { return ops_impl.terminate(); };
+  ops.kill = [&]() { return ops_impl.kill(); };
+  ops.wait_exit = [&](std::chrono::milliseconds) -> Result<void> {
+    return Error{.code = std::error_code(EBADF, std::system_category()), .context = "poll"};
+  };
+
+  auto result = internal::wait_with_timeout(ops, clock, std::chrono::milliseconds(5),
+                                            std::chrono::milliseconds(5));
+  ASSERT_FALSE(result.has_value());
+  EXPECT_EQ(result.error().context, "poll");
+  EXPECT_EQ(ops_impl.terminate_calls, 0);
+}
+
 TEST(TimeoutPolicyTest, TreatsEsrchDuringTerminateAsExitedProcess) {
   FakeClock clock;
   TestOps ops_impl;
@@ -176,4 +227,207 @@ TEST(TimeoutPolicyTest, TreatsEsrchDuringTerminateAsExitedProcess) {
   EXPECT_EQ(ops_impl.wait_calls, 1);
 }
 
+namespace {
+
+// Stages exit once the fake clock reaches their exit time, or once signalled when they obey it.
+struct FakeStages {
+  Result<std::optional<ExitStatus>> try_wait(std::size_t stage, FakeClock& clock) {
+    reap_order.push_back(stage);
+    if (terminated && exits_on_terminate[stage]) {
+      return std::optional<ExitStatus>(ExitStatus::other());
+    }
+    if (killed) {
+      return std::optional<ExitStatus>(ExitStatus::other());
+    }
+    if (clock.elapsed() >= exit_after[stage]) {
+      return std::optional<ExitStatus>(ExitStatus::exited(codes[stage]));
+    }
+    return std::optional<ExitStatus>();
+  }
+
+  internal::StageWaitOps ops(FakeClock& clock) {
+    internal::StageWaitOps ops;
+    ops.stage_count = exit_after.size();
+    ops.try_wait = [this, &clock](std::size_t stage) { return try_wait(stage, clock); };
+    ops.terminate = [this]() -> Result<void> {
+      ++terminate_calls;
+      terminated = true;
+      return {};
+    };
+    ops.kill = [this]() -> Result<void> {
+      ++kill_calls;
+      killed = true;
+      return {};
+    };
+    return ops;
+  }
+
+  std::vector<std::chrono::milliseconds> exit_after;
+  std::vector<int> codes;
+  std::vector<bool> exits_on_terminate;
+  std::vector<std::size_t> reap_order;
+  int terminate_calls = 0;
+  int kill_calls = 0;
+  bool terminated = false;
+  bool killed = false;
+};
+
+}  // namespace
+
+TEST(TimeoutPolicyTest, StagesAreReapedAsTheyExit) {
+  FakeClock clock;
+  FakeStages stages;
+  stages.exit_after = {std::chrono::milliseconds(10), std::chrono::milliseconds(2)};
+  stages.codes = {0, 0};
+  stages.exits_on_terminate = {true, true};
+  auto ops = stages.ops(clock);
+
+  auto result = internal::wait_stages(ops, clock, std::nullopt, std::chrono::milliseconds(5),
+                                      false);
+  ASSERT_TRUE(result.has_value());
+  ASSERT_EQ(result->stages.size(), 2U);
+  EXPECT_TRUE(result->stages[0].success());
+  EXPECT_TRUE(result->stages[1].success());
+  EXPECT_FALSE(result->sent_terminate);
+  EXPECT_EQ(stages.terminate_calls, 0);
+  // Stage 1 is reaped at 2ms and never polled again while stage 0 keeps running.
+  EXPECT_EQ(std::count(stages.reap_order.begin(), stages.reap_order.end(), 1U), 3);
+  EXPECT_GE(clock.elapsed(), std::chrono::milliseconds(10));
+}
+
+TEST(TimeoutPolicyTest, FailFastTerminatesRemainingStages) {
+  FakeClock clock;
+  FakeStages stages;
+  stages.exit_after = {std::chrono::milliseconds(1000), std::chrono::milliseconds(3),
+                       std::chrono::milliseconds(1000)};
+  stages.codes = {0, 2, 0};
+  stages.exits_on_terminate = {true, true, true};
+  auto ops = stages.ops(clock);
+
+  auto result = internal::wait_stages(ops, clock, std::nullopt, std::chrono::milliseconds(5),
+                                      true);
+  ASSERT_TRUE(result.has_value());
+  ASSERT_TRUE(result->failed_stage.has_value());
+  EXPECT_EQ(*result->failed_stage, 1U);
+  EXPECT_TRUE(result->sent_terminate);
+  EXPECT_FALSE(result->sent_kill);
+  EXPECT_FALSE(result->timed_out);
+  EXPECT_EQ(result->stages[1].code(), std::optional<int>(2));
+  EXPECT_EQ(stages.terminate_calls, 1);
+  EXPECT_LT(clock.elapsed(), std::chrono::milliseconds(10));
+}
+
+TEST(TimeoutPolicyTest, StageTimeoutEscalatesToKill) {
+  FakeClock clock;
+  FakeStages stages;
+  stages.exit_after = {std::chrono::milliseconds(1000), std::chrono::milliseconds(1000)};
+  stages.codes = {0, 0};
+  stages.exits_on_terminate = {true, false};
+  auto ops = stages.ops(clock);
+
+  auto result = internal::wait_stages(ops, clock, std::chrono::milliseconds(3),
+                                      std::chrono::milliseconds(4), false);
+  ASSERT_TRUE(result.has_value());
+  EXPECT_TRUE(result->timed_out);
+  EXPECT_TRUE(result->sent_terminate);
+  EXPECT_TRUE(result->sent_kill);
+  EXPECT_FALSE(result->failed_stage.has_value());
+  EXPECT_EQ(stages.terminate_calls, 1);
+  EXPECT_EQ(stages.kill_calls, 1);
+  EXPECT_GE(clock.elapsed(), std::chrono::milliseconds(7));
+}
+
+TEST(TimeoutPolicyTest, StageWaitUsesWaitAnyExitBudget) {
+  FakeClock clock;
+  FakeStages stages;
+  stages.exit_after = {std::chrono::milliseconds(20)};
+  stages.codes = {0};
+  stages.exits_on_terminate = {true};
+  auto ops = stages.ops(clock);
+  std::vector<std::optional<std::chrono::milliseconds>> budgets;
+  ops.wait_any_exit = [&](std::optional<std::chrono::milliseconds> budget) -> Result<void> {
+    budgets.push_back(budget);
+    clock.sleep_for(std::chrono::milliseconds(20));
+    return {};
+  };
+
+  auto result = internal::wait_stages(ops, clock, std::nullopt, std::chrono::milliseconds(5),
+                                      false);
+  ASSERT_TRUE(result.has_value());
+  ASSERT_EQ(budgets.size(), 1U);
+  EXPECT_FALSE(budgets.front().has_value());
+  EXPECT_EQ(clock.sleep_calls.size(), 1U);
+}
+
+TEST(TimeoutPolicyTest, CancellationEscalatesWithoutTimeout) {
+  FakeClock clock;
+  TestOps ops_impl;
+  ops_impl.exit_after_terminate = true;
+
+  internal::WaitOps ops;
+  ops.try_wait = [&]() { return ops_impl.try_wait(); };
+  ops.wait_blocking = [&]() { return ops_impl.wait_blocking(); };
+  ops.terminate = [&]() { return ops_impl.terminate(); };
+  ops.kill = [&]() { return ops_impl.kill(); };
+  ops.cancelled = [&]() { return clock.elapsed() >= std::chrono::milliseconds(2); };
+
+  auto result = internal::wait_with_timeout(ops, clock, std::nullopt, std::chrono::milliseconds(5));
+  ASSERT_TRUE(result.has_value());
+  EXPECT_TRUE(result->cancelled);
+  EXPECT_FALSE(result->timed_out);
+  EXPECT_TRUE(result->sent_terminate);
+  EXPECT_FALSE(result->sent_kill);
+  EXPECT_EQ(ops_impl.terminate_calls, 1);
+  EXPECT_EQ(ops_impl.wait_calls, 0);
+  EXPECT_EQ(clock.elapsed(), std::chrono::milliseconds(2));
+}
+
+TEST(TimeoutPolicyTest, StageCancellationEscalatesToKill) {
+  FakeClock clock;
+  FakeStages stages;
+  stages.exit_after = {std::chrono::milliseconds(1000), std::chrono::milliseconds(1000)};
+  stages.codes = {0, 0};
+  stages.exits_on_terminate = {true, false};
+  auto ops = stages.ops(clock);
+  ops.cancelled = [&]() { return clock.elapsed() >= std::chrono::milliseconds(3); };
+
+  auto result = internal::wait_stages(ops, clock, std::nullopt, std::chrono::milliseconds(4),
+                                      false);
+  ASSERT_TRUE(result.has_value());
+  EXPECT_TRUE(result->cancelled);
+  EXPECT_FALSE(result->timed_out);
+  EXPECT_TRUE(result->sent_terminate);
+  EXPECT_TRUE(result->sent_kill);
+  EXPECT_EQ(stages.terminate_calls, 1);
+  EXPECT_EQ(stages.kill_calls, 1);
+  EXPECT_GE(clock.elapsed(), std::chrono::milliseconds(7));
+}
+
+TEST(TimeoutPolicyTest, DeadlineQueuePopsDueTimersInDeadlineOrder) {
+  using Queue = internal::DeadlineQueue<int>;
+  Queue queue;
+  Queue::TimePoint epoch{};
+  auto at = [&](int ms) { return epoch + std::chrono::milliseconds(ms); };
+
+  EXPECT_FALSE(queue.next().has_value());
+  queue.schedule(at(30), 3);
+  auto cancelled = queue.schedule(at(5), -1);
+  queue.schedule(at(10), 1);
+  queue.schedule(at(10), 2);
+  queue.schedule(at(50), 5);
+  queue.cancel(cancelled);
+  ASSERT_TRUE(queue.next().has_value());
+  EXPECT_EQ(*queue.next(), at(10));
+
+  std::vector<int> popped;
+  while (auto value = queue.pop_due(at(30))) {
+    popped.push_back(*value);
+  }
+  EXPECT_EQ(popped, (std::vector<int>{1, 2, 3}));
+  EXPECT_EQ(queue.size(), 1U);
+  EXPECT_FALSE(queue.pop_due(at(49)).has_value());
+  EXPECT_EQ(queue.pop_due(at(50)), std::optional<int>(5));
+  EXPECT_TRUE(queue.empty());
+}
+
 }  // namespace procly